@@ -64,9 +64,9 @@ int Bitmap::next_unsetted_bit(int start) {
         ret = iter * 8 + index_in_byte;
         break;
       }
-
-      start_in_byte = 0;
     }
+    // 后面的字节都从第一位开始找，起始字节整个跳过时也一样
+    start_in_byte = 0;
   }
 
   if (ret >= size_) {
@@ -86,9 +86,9 @@ int Bitmap::next_setted_bit(int start) {
         ret = iter * 8 + index_in_byte;
         break;
       }
-
-      start_in_byte = 0;
     }
+    // 后面的字节都从第一位开始找，起始字节整个跳过时也一样
+    start_in_byte = 0;
   }
 
   if (ret >= size_) {
@@ -29,9 +29,9 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/lang/mutex.h"
 #include "common/log/log.h"
-#include "common/seda/seda_config.h"
 #include "event/session_event.h"
 #include "session/session.h"
+#include "common/seda/seda_config.h"    // 定义了COUNT宏，要在parse_defs.h之后包含
 #include "ini_setting.h"
 #include <common/metrics/metrics_registry.h>
 
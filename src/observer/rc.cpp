@@ -133,6 +133,7 @@ const char *strrc(RC rc) {
     RC_CASE_STRING(LOCKED_VIRT);
     RC_CASE_STRING(LOCKED_NEED_WAIT);
     RC_CASE_STRING(LOCKED_RESOURCE_DELETED);
+    RC_CASE_STRING(LOCKED_DEADLOCK);
 
     RC_CASE_STRING(BUSY_RECOVERY);
     RC_CASE_STRING(BUSY_SNAPSHOT);
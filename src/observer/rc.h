@@ -112,6 +112,7 @@ enum RCLock {
   LVIRT,
   NEED_WAIT,
   RESOURCE_DELETED,
+  DEADLOCK,
 };
 
 enum RCBusy {
@@ -295,6 +296,7 @@ enum RC {
   LOCKED_VIRT = (LOCKED | (RCLock::LVIRT << 8)),
   LOCKED_NEED_WAIT = (LOCKED | (RCLock::NEED_WAIT << 8)),
   LOCKED_RESOURCE_DELETED = (LOCKED | (RCLock::RESOURCE_DELETED << 8)),
+  LOCKED_DEADLOCK = (LOCKED | (RCLock::DEADLOCK << 8)),
 
   /* busy part */
   BUSY_RECOVERY = (BUSY | (RCBusy::BRECOVERY << 8)),
@@ -20,7 +20,8 @@ Session &Session::default_session() {
   return session;
 }
 
-Session::Session(const Session &other) : current_db_(other.current_db_){
+Session::Session(const Session &other)
+    : current_db_(other.current_db_), durability_(other.durability_), optimistic_(other.optimistic_) {
 }
 
 Session::~Session() {
@@ -43,9 +44,33 @@ bool Session::is_trx_multi_operation_mode() const {
   return trx_multi_operation_mode_;
 }
 
+void Session::set_durability(Durability durability) {
+  durability_ = durability;
+  if (trx_ != nullptr) {
+    trx_->set_durability(durability);
+  }
+}
+
+Durability Session::durability() const {
+  return durability_;
+}
+
+void Session::set_optimistic(bool optimistic) {
+  optimistic_ = optimistic;
+  if (trx_ != nullptr) {
+    trx_->set_optimistic(optimistic);
+  }
+}
+
+bool Session::optimistic() const {
+  return optimistic_;
+}
+
 Trx *Session::current_trx() {
   if (trx_ == nullptr) {
     trx_ = new Trx;
+    trx_->set_durability(durability_);
+    trx_->set_optimistic(optimistic_);
   }
   return trx_;
 }
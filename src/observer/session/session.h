@@ -17,6 +17,8 @@ See the Mulan PSL v2 for more details. */
 
 #include <string>
 
+#include "sql/parser/parse_defs.h"
+
 class Trx;
 
 class Session {
@@ -37,12 +39,26 @@ public:
   void set_trx_multi_operation_mode(bool multi_operation_mode);
   bool is_trx_multi_operation_mode() const;
 
+  /**
+   * SET DURABILITY = SYNC | ASYNC | DEFAULT，之后这个会话提交的事务都使用这个持久性级别
+   */
+  void set_durability(Durability durability);
+  Durability durability() const;
+
+  /**
+   * SET CONCURRENCY = OPTIMISTIC | PESSIMISTIC，之后开始的事务使用乐观或者悲观(加锁)的并发控制
+   */
+  void set_optimistic(bool optimistic);
+  bool optimistic() const;
+
   Trx * current_trx();
 
 private:
   std::string  current_db_;
   Trx         *trx_ = nullptr;
   bool         trx_multi_operation_mode_ = false; // 当前事务的模式，是否多语句模式. 单语句模式自动提交
+  Durability   durability_ = DURABILITY_DEFAULT;  // 默认按事务修改过的表的设置提交
+  bool         optimistic_ = false;
 };
 
 #endif // __OBSERVER_SESSION_SESSION_H__
\ No newline at end of file
@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 
 #include <string>
 #include <sstream>
+#include <strings.h>
 
 #include "execute_stage.h"
 
@@ -36,6 +37,7 @@ See the Mulan PSL v2 for more details. */
 using namespace common;
 
 RC create_selection_executor(Trx *trx, const Selects &selects, const char *db, const char *table_name, SelectExeNode &select_node);
+bool has_aggregation(const Selects &selects);
 
 //! Constructor
 ExecuteStage::ExecuteStage(const char *tag) : Stage(tag) {}
@@ -157,6 +159,12 @@ void ExecuteStage::handle_request(common::StageEvent *event) {
       exe_event->done_immediate();
     }
     break;
+    case SCF_BACKUP: {
+      RC rc = DefaultHandler::get_default().backup(sql->sstr.backup.dir);
+      session_event->set_response(strrc(rc));
+      exe_event->done_immediate();
+    }
+    break;
     case SCF_BEGIN: {
       session_event->get_client()->session->set_trx_multi_operation_mode(true);
       session_event->set_response(strrc(RC::SUCCESS));
@@ -179,6 +187,12 @@ void ExecuteStage::handle_request(common::StageEvent *event) {
       exe_event->done_immediate();
     }
     break;
+    case SCF_SET_VARIABLE: {
+      RC rc = do_set_variable(sql->sstr.set_variable, session_event->get_client()->session);
+      session_event->set_response(strrc(rc));
+      exe_event->done_immediate();
+    }
+    break;
     case SCF_HELP: {
       const char *response = "show tables;\n"
           "desc `table name`;\n"
@@ -187,7 +201,10 @@ void ExecuteStage::handle_request(common::StageEvent *event) {
           "insert into `table` values(`value1`,`value2`);\n"
           "update `table` set column=value [where `column`=`value`];\n"
           "delete from `table` [where `column`=`value`];\n"
-          "select [ * | `columns` ] from `table`;\n";
+          "select [ * | `columns` ] from `table`;\n"
+          "set durability = [ sync | async | default ];\n"
+          "set concurrency = [ optimistic | pessimistic ];\n"
+          "backup to 'dir';\n";
       session_event->set_response(response);
       exe_event->done_immediate();
     }
@@ -244,6 +261,106 @@ Record make_virtual_record(const char* data) {
     return record;
 }
 
+/**
+ * index nested-loop join的计划: 外表和内表在select_nodes中的下标，外表的连接字段，内表连接字段上的索引
+ */
+struct IndexJoinPlan {
+  int condition = -1;             // 用作连接条件的condition下标
+  int outer = -1;
+  int inner = -1;
+  const FieldMeta *outer_field = nullptr;
+  Index *inner_index = nullptr;
+};
+
+// 外表的行数不超过内表估计行数的1/INDEX_JOIN_OUTER_RATIO时才用index join，否则逐行查找不如直接扫描内表
+static const int INDEX_JOIN_OUTER_RATIO = 4;
+
+static int find_select_node(const std::vector<SelectExeNode *> &select_nodes, const char *table_name) {
+  for (size_t i = 0; i < select_nodes.size(); i++) {
+    if (table_name != nullptr && 0 == strcmp(select_nodes[i]->table()->name(), table_name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * 两表查询时，找一个两表字段之间的等值条件，并且其中一张表在这个字段上有可以逐行查找的索引。
+ * 两边都有索引时，估计行数多的表作为内表
+ */
+static bool plan_index_join(const Selects &selects, const std::vector<SelectExeNode *> &select_nodes,
+                            IndexJoinPlan &plan) {
+  if (select_nodes.size() != 2) {
+    return false;
+  }
+  int best_inner_record_num = -1;
+  for (size_t i = 0; i < selects.condition_num; i++) {
+    const Condition &condition = selects.conditions[i];
+    if (condition.left_is_attr != 1 || condition.right_is_attr != 1 || condition.comp != EQUAL_TO) {
+      continue;
+    }
+    int left = find_select_node(select_nodes, condition.left_attr.relation_name);
+    int right = find_select_node(select_nodes, condition.right_attr.relation_name);
+    if (left < 0 || right < 0 || left == right) {
+      continue;
+    }
+    const FieldMeta *left_field = select_nodes[left]->table()->table_meta().field(condition.left_attr.attribute_name);
+    const FieldMeta *right_field = select_nodes[right]->table()->table_meta().field(condition.right_attr.attribute_name);
+    if (left_field == nullptr || right_field == nullptr || left_field->type() != right_field->type()) {
+      continue;
+    }
+
+    const int sides[2][2] = {{left, right}, {right, left}};
+    const FieldMeta *fields[2] = {left_field, right_field};
+    for (int j = 0; j < 2; j++) {
+      const int outer = sides[j][0];
+      const int inner = sides[j][1];
+      Table *inner_table = select_nodes[inner]->table();
+      Index *index = inner_table->find_index_for_join(fields[1 - j]->name());
+      if (index == nullptr) {
+        continue;
+      }
+      const int inner_record_num = inner_table->estimate_record_num();
+      if (inner_record_num > best_inner_record_num) {
+        best_inner_record_num = inner_record_num;
+        plan.condition = i;
+        plan.outer = outer;
+        plan.inner = inner;
+        plan.outer_field = fields[j];
+        plan.inner_index = index;
+      }
+    }
+  }
+  return plan.inner_index != nullptr;
+}
+
+// 目前有DURABILITY: SYNC、ASYNC，DEFAULT表示按表的设置。NOLOG只能用在表上
+// CONCURRENCY: OPTIMISTIC、PESSIMISTIC
+RC ExecuteStage::do_set_variable(const SetVariable &set_variable, Session *session) {
+  if (strcasecmp(set_variable.name, "concurrency") == 0) {
+    if (strcasecmp(set_variable.value, "optimistic") == 0) {
+      session->set_optimistic(true);
+    } else if (strcasecmp(set_variable.value, "pessimistic") == 0) {
+      session->set_optimistic(false);
+    } else {
+      LOG_WARN("Invalid concurrency %s of session.", set_variable.value);
+      return RC::INVALID_ARGUMENT;
+    }
+    return RC::SUCCESS;
+  }
+  if (strcasecmp(set_variable.name, "durability") != 0) {
+    LOG_WARN("Unknown variable %s.", set_variable.name);
+    return RC::INVALID_ARGUMENT;
+  }
+  Durability durability;
+  if (parse_durability(set_variable.value, &durability) != 0 || durability == DURABILITY_NOLOG) {
+    LOG_WARN("Invalid durability %s of session.", set_variable.value);
+    return RC::INVALID_ARGUMENT;
+  }
+  session->set_durability(durability);
+  return RC::SUCCESS;
+}
+
 // 这里没有对输入的某些信息做合法性校验，比如查询的列名、where条件中的列名等，没有做必要的合法性校验
 // 需要补充上这一部分. 校验部分也可以放在resolve，不过跟execution放一起也没有关系
 // 单表多表查询逻辑合并
@@ -276,19 +393,59 @@ RC ExecuteStage::do_select(const char *db, Query *sql, SessionEvent *session_eve
     return RC::SQL_SYNTAX;
   }
 
-  std::vector<TupleSet> tuple_sets;
-  std::vector<std::vector<std::string>> tupleSets;
-  for (SelectExeNode *&node: select_nodes) {
+  const bool aggregation = has_aggregation(selects);
+  if (aggregation && select_nodes.size() == 1) {
+    // 单表的聚集查询先尝试只用索引回答，不执行下层的表扫描
+    AggregateExeNode aggregate_node;
     TupleSet tuple_set;
-    rc = node->execute(tuple_set);
+    rc = aggregate_node.init(trx, selects, select_nodes[0], nullptr);
+    if (rc == RC::SUCCESS) {
+      rc = aggregate_node.execute(tuple_set);
+    }
+    delete select_nodes[0];
+    if (rc != RC::SUCCESS) {
+      end_trx_if_need(session, trx, false);
+      return rc;
+    }
+    std::stringstream ss;
+    tuple_set.print(ss, false);
+    session_event->set_response(ss.str());
+    end_trx_if_need(session, trx, true);
+    return rc;
+  }
+
+  // 两表查询时，外表结果足够少就用index nested-loop join，不执行内表的全表扫描
+  IndexJoinPlan join_plan;
+  bool index_join = plan_index_join(selects, select_nodes, join_plan);
+  std::vector<TupleSet> tuple_sets(select_nodes.size());
+  std::vector<char> outer_keys;
+  if (index_join) {
+    rc = select_nodes[join_plan.outer]->execute(tuple_sets[join_plan.outer], join_plan.outer_field, outer_keys);
+    if (rc != RC::SUCCESS) {
+      for (SelectExeNode *& tmp_node: select_nodes) {
+        delete tmp_node;
+      }
+      end_trx_if_need(session, trx, false);
+      return rc;
+    }
+    const int inner_record_num = select_nodes[join_plan.inner]->table()->estimate_record_num();
+    index_join = tuple_sets[join_plan.outer].size() <= inner_record_num / INDEX_JOIN_OUTER_RATIO;
+    LOG_DEBUG("Index join plan. outer=%s(%d rows), inner=%s(about %d rows), use index join=%d",
+              select_nodes[join_plan.outer]->table()->name(), tuple_sets[join_plan.outer].size(),
+              select_nodes[join_plan.inner]->table()->name(), inner_record_num, index_join);
+  }
+  for (size_t i = 0; i < select_nodes.size(); i++) {
+    if (join_plan.outer == (int)i || (index_join && join_plan.inner == (int)i)) {
+      // 外表已经执行过了，用index join时内表不需要执行
+      continue;
+    }
+    rc = select_nodes[i]->execute(tuple_sets[i]);
     if (rc != RC::SUCCESS) {
       for (SelectExeNode *& tmp_node: select_nodes) {
         delete tmp_node;
       }
       end_trx_if_need(session, trx, false);
       return rc;
-    } else {
-      tuple_sets.push_back(std::move(tuple_set));
     }
   }
 
@@ -298,25 +455,45 @@ RC ExecuteStage::do_select(const char *db, Query *sql, SessionEvent *session_eve
       // TODO 多张表合并后表如果都为空
       // TODO float过滤有问题
 
-    // 本次查询了多张表，需要做join操作
-    // 制作新属性表表头
-    TupleSchema tuple_schema;
-    for (int i = tuple_sets.size()-1; i >= 0; i--) {
-        tuple_schema.merge(tuple_sets[i].get_schema());
-    }
-    tuple_set.set_schema(tuple_schema);
+    if (index_join) {
+      // 结果中的字段顺序与笛卡尔积相同: 后面的表在前
+      IndexJoinExeNode join_node;
+      join_node.init(trx, &tuple_sets[join_plan.outer], &outer_keys, join_plan.outer_field,
+                     select_nodes[join_plan.inner], join_plan.inner_index, join_plan.outer > join_plan.inner);
+      rc = join_node.execute(tuple_set);
+      if (rc != RC::SUCCESS) {
+        for (SelectExeNode *& tmp_node: select_nodes) {
+          delete tmp_node;
+        }
+        end_trx_if_need(session, trx, false);
+        return rc;
+      }
+    } else {
+      // 本次查询了多张表，需要做join操作
+      // 制作新属性表表头
+      TupleSchema tuple_schema;
+      for (int i = tuple_sets.size()-1; i >= 0; i--) {
+          tuple_schema.merge(tuple_sets[i].get_schema());
+      }
+      tuple_set.set_schema(tuple_schema);
 
-//    tuple_set.get_schema().print(ss);
+  //    tuple_set.get_schema().print(ss);
 
-    // 进行笛卡尔积，填充值
-    std::vector<const Tuple*> path;
-    do_join_dfs(tuple_sets, tuple_sets.size()-1, path, tuple_set);
+      // 进行笛卡尔积，填充值
+      std::vector<const Tuple*> path;
+      do_join_dfs(tuple_sets, tuple_sets.size()-1, path, tuple_set);
+    }
 
     // 单表中两个属性间的比较 过滤-where
     // 找出仅与此表相关的过滤条件, 或者都是值的过滤条件
     DefaultConditionFilter* condition_filters[selects.condition_num];
     int condition_filters_count = 0, connection_table_size = 0;
-    for (size_t i = 0; i < selects.condition_num; i++) {
+    // 连接结果为空时没有需要过滤的记录
+    for (size_t i = 0; i < selects.condition_num && !tuple_set.is_empty(); i++) {
+        if (index_join && join_plan.condition == (int)i) {
+            // index join查找出来的记录已经满足连接条件
+            continue;
+        }
         const Condition &condition = selects.conditions[i];
         if ((condition.left_is_attr == 1 && condition.right_is_attr == 1)) {
             if (::match_table(selects, condition.left_attr.relation_name, selects.relations) &&
@@ -401,6 +578,22 @@ RC ExecuteStage::do_select(const char *db, Query *sql, SessionEvent *session_eve
   // group by
 
   // aggregation
+  if (aggregation) {
+    AggregateExeNode aggregate_node;
+    TupleSet aggregated;
+    rc = aggregate_node.init(trx, selects, nullptr, &tuple_set);
+    if (rc == RC::SUCCESS) {
+      rc = aggregate_node.execute(aggregated);
+    }
+    if (rc != RC::SUCCESS) {
+      for (SelectExeNode *& tmp_node: select_nodes) {
+        delete tmp_node;
+      }
+      end_trx_if_need(session, trx, false);
+      return rc;
+    }
+    tuple_set = std::move(aggregated);
+  }
 
   // order by
 
@@ -418,7 +611,7 @@ RC ExecuteStage::do_select(const char *db, Query *sql, SessionEvent *session_eve
 	}
 
   // print/子查询
-  if (tuple_sets.size() > 1) {
+  if (tuple_sets.size() > 1 && !aggregation) {
     tuple_set.print(ss, true);
   } else {
     tuple_set.print(ss, false);
@@ -432,6 +625,15 @@ RC ExecuteStage::do_select(const char *db, Query *sql, SessionEvent *session_eve
   return rc;
 }
 
+bool has_aggregation(const Selects &selects) {
+  for (size_t i = 0; i < selects.attr_num; i++) {
+    if (selects.aggregations[i] != UNVALID) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool match_table(const Selects &selects, const char *table_name_in_condition,  const char* const *table_name_to_match){
     if (table_name_in_condition != nullptr) {
       while (*table_name_to_match != nullptr) {
@@ -466,26 +668,36 @@ RC create_selection_executor(Trx *trx, const Selects &selects, const char *db, c
     return RC::SCHEMA_TABLE_NOT_EXIST;
   }
 
-//  for (int i = selects.attr_num - 1; i >= 0; i--) {
-//    const RelAttr &attr = selects.attributes[];
-//    if (nullptr == attr.relation_name || 0 == strcmp(table_name, attr.relation_name)) {
-//      if (0 == strcmp("*", attr.attribute_name)) {
+  // 单表查询并且没有聚合时，只读取select中的字段，这样才有机会走覆盖索引。
+  // 多表查询在join时还要用到其它字段，仍然列出所有字段
+  if (selects.relation_num == 1 && !has_aggregation(selects)) {
+    // 属性是倒序保存的
+    for (int i = selects.attr_num - 1; i >= 0; i--) {
+      const RelAttr &attr = selects.attributes[i];
+      if (0 == strcmp("*", attr.attribute_name)) {
         // 列出这张表所有字段
+        schema.clear();
         TupleSchema::from_table(table, schema);
-//        break; // 没有校验，给出* 之后，再写字段的错误
-//      } else {
-//        // 列出这张表相关字段
-//        RC rc = schema_add_field(table, attr.attribute_name, schema);
-//        if (rc != RC::SUCCESS) {
-//          return rc;
-//        }
-//      }
-//    }
-//  }
+        break;
+      }
+      if (attr.relation_name != nullptr && 0 != strcmp(table_name, attr.relation_name)) {
+        LOG_WARN("No such table [%s] in select", attr.relation_name);
+        return RC::SCHEMA_TABLE_NOT_EXIST;
+      }
+      // 列出这张表相关字段
+      RC rc = schema_add_field(table, attr.attribute_name, schema);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+    }
+  } else {
+    // 列出这张表所有字段
+    TupleSchema::from_table(table, schema);
+  }
 
   // 找出仅与此表相关的过滤条件, 或者都是值的过滤条件
   std::vector<DefaultConditionFilter *> condition_filters;
-  const char* table_names[] = {table_name};
+  const char* table_names[] = {table_name, nullptr};   // match_table按nullptr结束
   for (size_t i = 0; i < selects.condition_num; i++) {
     const Condition &condition = selects.conditions[i];
     if ((condition.left_is_attr == 0 && condition.right_is_attr == 0) || // 两边都是值
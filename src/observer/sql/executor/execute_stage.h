@@ -20,6 +20,7 @@ See the Mulan PSL v2 for more details. */
 #include "rc.h"
 
 class SessionEvent;
+class Session;
 
 class ExecuteStage : public common::Stage {
 public:
@@ -39,6 +40,7 @@ protected:
 
   void handle_request(common::StageEvent *event);
   RC do_select(const char *db, Query *sql, SessionEvent *session_event);
+  RC do_set_variable(const SetVariable &set_variable, Session *session);
 protected:
 private:
   Stage *default_storage_stage_ = nullptr;
@@ -12,8 +12,14 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2021/5/14.
 //
 
+#include <string.h>
+#include <algorithm>
+#include <string>
+
 #include "sql/executor/execution_node.h"
 #include "storage/common/table.h"
+#include "storage/common/index.h"
+#include "storage/common/key_comparator.h"
 #include "common/log/log.h"
 
 SelectExeNode::SelectExeNode() : table_(nullptr) {
@@ -40,11 +46,406 @@ void record_reader(const char *data, void *context) {
   converter->add_record(data);
 }
 RC SelectExeNode::execute(TupleSet &tuple_set) {
+  tuple_set.clear();
+  tuple_set.set_schema(tuple_schema_);
+  TupleRecordConverter converter(table_, tuple_set);
+  return scan((void *)&converter, record_reader);
+}
+
+/**
+ * 转换成Tuple的同时，收集连接字段的原始值
+ */
+class JoinKeyCollector {
+public:
+  JoinKeyCollector(Table *table, TupleSet &tuple_set, const FieldMeta *key_field, std::vector<char> &keys)
+      : converter_(table, tuple_set), key_field_(key_field), keys_(keys) {
+  }
+
+  void add_record(const char *data) {
+    converter_.add_record(data);
+    const char *key = data + key_field_->offset();
+    keys_.insert(keys_.end(), key, key + key_field_->len());
+  }
+private:
+  TupleRecordConverter converter_;
+  const FieldMeta *key_field_;
+  std::vector<char> &keys_;
+};
+
+static void join_key_record_reader(const char *data, void *context) {
+  JoinKeyCollector *collector = (JoinKeyCollector *)context;
+  collector->add_record(data);
+}
+
+RC SelectExeNode::execute(TupleSet &tuple_set, const FieldMeta *key_field, std::vector<char> &keys) {
+  if (tuple_schema_.index_of_field(table_->name(), key_field->name()) < 0) {
+    // 覆盖索引扫描时记录中只有输出的字段
+    LOG_ERROR("Join field is not in the schema. table=%s, field=%s", table_->name(), key_field->name());
+    return RC::SCHEMA_FIELD_MISSING;
+  }
+  tuple_set.clear();
+  tuple_set.set_schema(tuple_schema_);
+  keys.clear();
+  JoinKeyCollector collector(table_, tuple_set, key_field, keys);
+  return scan((void *)&collector, join_key_record_reader);
+}
+
+RC SelectExeNode::scan(void *context, void (*reader)(const char *data, void *context)) {
   CompositeConditionFilter condition_filter;
   condition_filter.init((const ConditionFilter **)condition_filters_.data(), condition_filters_.size());
 
+  // 只读取输出的字段，有覆盖索引时可以不用回表
+  std::vector<const FieldMeta *> fields;
+  for (const TupleField &field : tuple_schema_.fields()) {
+    const FieldMeta *field_meta = table_->table_meta().field(field.field_name());
+    if (field_meta == nullptr) {
+      return table_->scan_record(trx_, &condition_filter, -1, context, reader);
+    }
+    fields.push_back(field_meta);
+  }
+  return table_->scan_record(trx_, &condition_filter, fields, -1, context, reader);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC IndexJoinExeNode::init(Trx *trx, const TupleSet *outer, const std::vector<char> *outer_keys,
+                          const FieldMeta *outer_field, const SelectExeNode *inner, Index *inner_index,
+                          bool outer_first) {
+  trx_ = trx;
+  outer_ = outer;
+  outer_keys_ = outer_keys;
+  outer_field_ = outer_field;
+  inner_ = inner;
+  inner_index_ = inner_index;
+  outer_first_ = outer_first;
+  return RC::SUCCESS;
+}
+
+/**
+ * 内表查找到的记录，probe是外表连接字段去重后的下标
+ */
+class ProbeResultCollector {
+public:
+  ProbeResultCollector(Table *table, TupleSet &tuple_set) : converter_(table, tuple_set) {
+  }
+
+  void add_record(int probe, const char *data) {
+    converter_.add_record(data);
+    probes_.push_back(probe);
+  }
+
+  const std::vector<int> &probes() const {
+    return probes_;
+  }
+private:
+  TupleRecordConverter converter_;
+  std::vector<int> probes_;
+};
+
+static void probe_record_reader(int probe, const char *data, void *context) {
+  ProbeResultCollector *collector = (ProbeResultCollector *)context;
+  collector->add_record(probe, data);
+}
+
+RC IndexJoinExeNode::execute(TupleSet &tuple_set) {
+  Table *inner_table = inner_->table();
+  const FieldMeta &inner_field = inner_index_->field_metas()[0];
+  const int outer_length = outer_field_->len();
+  const int inner_length = inner_field.len();
+  const int row_num = outer_->size();
+
+  // 外表的连接字段编码后可以直接memcmp比较，按编码后的值排序去重
+  std::vector<std::string> normalized(row_num, std::string(outer_length, '\0'));
+  std::vector<int> order(row_num);
+  for (int i = 0; i < row_num; i++) {
+    normalize_attr(outer_field_->type(), outer_length, outer_keys_->data() + i * outer_length, &normalized[i][0]);
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&normalized](int a, int b) {
+    return normalized[a] < normalized[b];
+  });
+
+  // 查找用的值要换成内表字段的长度。字符串比内表字段还长时不可能相等，不用查找
+  std::vector<char> probe_keys;
+  probe_keys.reserve(row_num * inner_length);
+  std::vector<int> probe_of_row(row_num, -1);
+  int probe_num = 0;
+  for (int i = 0; i < row_num; i++) {
+    const int row = order[i];
+    if (i > 0 && normalized[row] == normalized[order[i - 1]]) {
+      probe_of_row[row] = probe_of_row[order[i - 1]];
+      continue;
+    }
+    const char *key = outer_keys_->data() + row * outer_length;
+    if (outer_field_->type() == CHARS) {
+      int len = strnlen(key, outer_length);
+      if (len > inner_length) {
+        continue;
+      }
+      probe_keys.insert(probe_keys.end(), key, key + len);
+      probe_keys.insert(probe_keys.end(), inner_length - len, '\0');
+    } else {
+      probe_keys.insert(probe_keys.end(), key, key + inner_length);
+    }
+    probe_of_row[row] = probe_num++;
+  }
+  std::vector<const char *> values;
+  for (int i = 0; i < probe_num; i++) {
+    values.push_back(probe_keys.data() + i * inner_length);
+  }
+
+  CompositeConditionFilter condition_filter;
+  condition_filter.init((const ConditionFilter **)inner_->condition_filters().data(),
+                        inner_->condition_filters().size());
+  TupleSet inner_set;
+  inner_set.set_schema(inner_->tuple_schema());
+  ProbeResultCollector collector(inner_table, inner_set);
+  RC rc = inner_table->probe_record(trx_, inner_index_, values, &condition_filter, &collector, probe_record_reader);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  std::vector<std::vector<int>> matches(probe_num);
+  for (int i = 0; i < (int)collector.probes().size(); i++) {
+    matches[collector.probes()[i]].push_back(i);
+  }
+
+  TupleSchema schema;
+  schema.append(outer_first_ ? outer_->schema() : inner_set.schema());
+  schema.append(outer_first_ ? inner_set.schema() : outer_->schema());
   tuple_set.clear();
-  tuple_set.set_schema(tuple_schema_);
-  TupleRecordConverter converter(table_, tuple_set);
-  return table_->scan_record(trx_, &condition_filter, -1, (void *)&converter, record_reader);
-}
\ No newline at end of file
+  tuple_set.set_schema(schema);
+  for (int row = 0; row < row_num; row++) {
+    if (probe_of_row[row] < 0) {
+      continue;
+    }
+    const Tuple &outer_tuple = outer_->get(row);
+    for (int match : matches[probe_of_row[row]]) {
+      const Tuple &inner_tuple = inner_set.get(match);
+      Tuple tuple;
+      tuple.merge(outer_first_ ? outer_tuple : inner_tuple);
+      tuple.merge(outer_first_ ? inner_tuple : outer_tuple);
+      tuple_set.add(std::move(tuple));
+    }
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static const char *aggregation_name(AggreType type) {
+  switch (type) {
+    case MAX:
+      return "max";
+    case MIN:
+      return "min";
+    case COUNT:
+      return "count";
+    case AVG:
+      return "avg";
+    default:
+      return "";
+  }
+}
+
+/**
+ * 聚集的字段在输入中的下标，没有时返回-1
+ */
+static int find_column(const TupleSchema &schema, const RelAttr &attr) {
+  const std::vector<TupleField> &fields = schema.fields();
+  for (int i = 0; i < (int)fields.size(); i++) {
+    if (0 == strcmp(fields[i].field_name(), attr.attribute_name) &&
+        (attr.relation_name == nullptr || 0 == strcmp(fields[i].table_name(), attr.relation_name))) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void add_field_value(Tuple &tuple, const FieldMeta *field_meta, const char *value) {
+  switch (field_meta->type()) {
+    case INTS:
+      tuple.add(*(const int *)value);
+      break;
+    case FLOATS:
+      tuple.add(*(const float *)value);
+      break;
+    case CHARS:
+      tuple.add(value, strnlen(value, field_meta->len()));
+      break;
+    case DATES:
+      tuple.add_date(*(const int *)value);
+      break;
+    default:
+      LOG_PANIC("Unsupported field type. type=%d", field_meta->type());
+  }
+}
+
+RC AggregateExeNode::init(Trx *trx, const Selects &selects, SelectExeNode *select_node, const TupleSet *input) {
+  trx_ = trx;
+  selects_ = &selects;
+  select_node_ = select_node;
+  input_ = input;
+
+  for (size_t i = 0; i < selects.attr_num; i++) {
+    const RelAttr &attr = selects.attributes[i];
+    if (selects.aggregations[i] == UNVALID) {
+      LOG_WARN("Aggregation and plain attribute cannot be selected together. attr=%s", attr.attribute_name);
+      return RC::SQL_SYNTAX;
+    }
+    if (0 == strcmp("*", attr.attribute_name)) {
+      if (selects.aggregations[i] != COUNT) {
+        LOG_WARN("Only count can be applied to *. aggregation=%s", aggregation_name(selects.aggregations[i]));
+        return RC::SQL_SYNTAX;
+      }
+      continue;
+    }
+    if (find_column(input_schema(), attr) < 0) {
+      LOG_WARN("No such field in aggregation. %s", attr.attribute_name);
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+const TupleSchema &AggregateExeNode::input_schema() const {
+  return select_node_ != nullptr ? select_node_->tuple_schema() : input_->schema();
+}
+
+RC AggregateExeNode::execute(TupleSet &tuple_set) {
+  // 属性是倒序保存的
+  TupleSchema schema;
+  for (int i = selects_->attr_num - 1; i >= 0; i--) {
+    const RelAttr &attr = selects_->attributes[i];
+    const AggreType type = selects_->aggregations[i];
+    std::string name = std::string(aggregation_name(type)) + "(";
+    if (attr.relation_name != nullptr) {
+      name = name + attr.relation_name + ".";
+    }
+    name = name + attr.attribute_name + ")";
+
+    AttrType attr_type = INTS;
+    if (type == AVG) {
+      attr_type = FLOATS;
+    } else if (type != COUNT) {
+      attr_type = input_schema().field(find_column(input_schema(), attr)).type();
+    }
+    schema.add(attr_type, "", name.c_str());
+  }
+  tuple_set.clear();
+  tuple_set.set_schema(schema);
+
+  RC rc = RC::SUCCESS;
+  Tuple tuple;
+  bool done = false;
+  if (select_node_ != nullptr) {
+    rc = execute_by_index(tuple, &done);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    LOG_DEBUG("Aggregation on table %s answered by index: %d", select_node_->table()->name(), done);
+  }
+  if (!done) {
+    tuple = Tuple();
+    if (select_node_ != nullptr) {
+      TupleSet input;
+      rc = select_node_->execute(input);
+      if (rc == RC::SUCCESS) {
+        rc = aggregate(input, tuple);
+      }
+    } else {
+      rc = aggregate(*input_, tuple);
+    }
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+  tuple_set.add(std::move(tuple));
+  return RC::SUCCESS;
+}
+
+/**
+ * 所有的聚集都能用索引回答时才不扫描表。MIN/MAX只在没有过滤条件时从索引的一端读取
+ */
+RC AggregateExeNode::execute_by_index(Tuple &tuple, bool *done) {
+  *done = false;
+  Table *table = select_node_->table();
+  const std::vector<DefaultConditionFilter *> &filters = select_node_->condition_filters();
+  CompositeConditionFilter condition_filter;
+  condition_filter.init((const ConditionFilter **)filters.data(), filters.size());
+  ConditionFilter *filter = filters.empty() ? nullptr : &condition_filter;
+
+  RC rc;
+  int count = -1;
+  std::vector<char> value;
+  for (int i = selects_->attr_num - 1; i >= 0; i--) {
+    const RelAttr &attr = selects_->attributes[i];
+    const AggreType type = selects_->aggregations[i];
+    if (type == COUNT) {
+      // 没有空值，count(字段)和count(*)相同
+      if (count < 0) {
+        rc = table->count_by_index(trx_, filter, &count, done);
+        if (rc != RC::SUCCESS || !*done) {
+          return rc;
+        }
+      }
+      tuple.add(count);
+    } else if ((type == MIN || type == MAX) && filter == nullptr) {
+      const FieldMeta *field_meta = table->table_meta().field(attr.attribute_name);
+      bool found = false;
+      value.resize(field_meta->len());
+      rc = table->min_max_by_index(trx_, field_meta, type == MAX, value.data(), &found, done);
+      if (rc != RC::SUCCESS || !*done) {
+        return rc;
+      }
+      if (found) {
+        add_field_value(tuple, field_meta, value.data());
+      } else {
+        tuple.add(new StringValue("NULL"));
+      }
+    } else {
+      *done = false;
+      return RC::SUCCESS;
+    }
+  }
+  *done = true;
+  return RC::SUCCESS;
+}
+
+RC AggregateExeNode::aggregate(const TupleSet &input, Tuple &tuple) {
+  for (int i = selects_->attr_num - 1; i >= 0; i--) {
+    const RelAttr &attr = selects_->attributes[i];
+    const AggreType type = selects_->aggregations[i];
+    if (type == COUNT) {
+      tuple.add(input.size());
+      continue;
+    }
+    if (input.is_empty()) {
+      tuple.add(new StringValue("NULL"));
+      continue;
+    }
+
+    const int column = find_column(input.schema(), attr);
+    if (type == AVG) {
+      const AttrType attr_type = input.schema().field(column).type();
+      if (attr_type != INTS && attr_type != FLOATS) {
+        LOG_WARN("Cannot compute avg of field %s. type=%d", attr.attribute_name, attr_type);
+        return RC::SCHEMA_FIELD_TYPE_MISMATCH;
+      }
+      double sum = 0;
+      for (const Tuple &row : input.tuples()) {
+        sum += atof(row.get(column).to_string().c_str());
+      }
+      tuple.add((float)(sum / input.size()));
+      continue;
+    }
+
+    const std::shared_ptr<TupleValue> *best = &input.get(0).get_pointer(column);
+    for (const Tuple &row : input.tuples()) {
+      const int result = row.get(column).compare(**best);
+      if ((type == MIN && result < 0) || (type == MAX && result > 0)) {
+        best = &row.get_pointer(column);
+      }
+    }
+    tuple.add(*best);
+  }
+  return RC::SUCCESS;
+}
@@ -17,10 +17,13 @@ See the Mulan PSL v2 for more details. */
 
 #include <vector>
 #include "storage/common/condition_filter.h"
+#include "sql/parser/parse_defs.h"
 #include "sql/executor/tuple.h"
 
 class Table;
 class Trx;
+class Index;
+class FieldMeta;
 
 class ExecutionNode {
 public:
@@ -38,6 +41,24 @@ public:
   RC init(Trx *trx, Table *table, TupleSchema && tuple_schema, std::vector<DefaultConditionFilter *> &&condition_filters);
 
   RC execute(TupleSet &tuple_set) override;
+
+  /**
+   * 同execute，同时把每条记录中key_field的原始值依次追加到keys中，作为index nested-loop join的外表
+   */
+  RC execute(TupleSet &tuple_set, const FieldMeta *key_field, std::vector<char> &keys);
+
+  Table *table() const {
+    return table_;
+  }
+  const TupleSchema &tuple_schema() const {
+    return tuple_schema_;
+  }
+  const std::vector<DefaultConditionFilter *> &condition_filters() const {
+    return condition_filters_;
+  }
+private:
+  RC scan(void *context, void (*reader)(const char *data, void *context));
+
 private:
   Trx *trx_ = nullptr;
   Table  * table_;
@@ -45,4 +66,63 @@ private:
   std::vector<DefaultConditionFilter *> condition_filters_;
 };
 
+/**
+ * Index nested-loop join。外表已经执行完，对外表的每一行，用连接字段的值到内表的索引上查找，不扫描整个内表。
+ * 查找前把外表的连接字段排序去重，B+树上相邻的查找可以共用同一个叶子节点
+ */
+class IndexJoinExeNode : public ExecutionNode {
+public:
+  IndexJoinExeNode() = default;
+  virtual ~IndexJoinExeNode() = default;
+
+  /**
+   * @param outer 外表的结果
+   * @param outer_keys 外表每一行连接字段的原始值，与outer中的行一一对应
+   * @param outer_field 外表的连接字段
+   * @param inner 内表的查询，只使用它的表、字段和过滤条件，不会执行
+   * @param inner_index 内表连接字段上的索引
+   * @param outer_first 结果中外表的字段是否在前面
+   */
+  RC init(Trx *trx, const TupleSet *outer, const std::vector<char> *outer_keys, const FieldMeta *outer_field,
+          const SelectExeNode *inner, Index *inner_index, bool outer_first);
+
+  RC execute(TupleSet &tuple_set) override;
+private:
+  Trx *trx_ = nullptr;
+  const TupleSet *outer_ = nullptr;
+  const std::vector<char> *outer_keys_ = nullptr;
+  const FieldMeta *outer_field_ = nullptr;
+  const SelectExeNode *inner_ = nullptr;
+  Index *inner_index_ = nullptr;
+  bool outer_first_ = true;
+};
+
+/**
+ * 不带group by的聚集查询(MIN/MAX/COUNT/AVG)，结果只有一行。
+ * 单表查询时先尝试只用索引回答: MIN/MAX从索引的一端开始找第一条可见的记录，COUNT只数索引项，
+ * 都不需要扫描表。索引回答不了时再执行下层的查询，在查询结果上计算
+ */
+class AggregateExeNode : public ExecutionNode {
+public:
+  AggregateExeNode() = default;
+  virtual ~AggregateExeNode() = default;
+
+  /**
+   * @param select_node 单表查询时的下层查询，还没有执行
+   * @param input 多表查询时连接之后的结果，这时select_node为空
+   */
+  RC init(Trx *trx, const Selects &selects, SelectExeNode *select_node, const TupleSet *input);
+
+  RC execute(TupleSet &tuple_set) override;
+private:
+  RC execute_by_index(Tuple &tuple, bool *done);
+  RC aggregate(const TupleSet &input, Tuple &tuple);
+  const TupleSchema &input_schema() const;
+private:
+  Trx *trx_ = nullptr;
+  const Selects *selects_ = nullptr;
+  SelectExeNode *select_node_ = nullptr;
+  const TupleSet *input_ = nullptr;
+};
+
 #endif //__OBSERVER_SQL_EXECUTOR_EXECUTION_NODE_H_
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <mutex>
+#include <strings.h>
 #include "sql/parser/parse.h"
 #include "rc.h"
 #include "common/log/log.h"
@@ -294,11 +295,15 @@ void create_table_append_attribute(CreateTable *create_table, AttrInfo *attr_inf
 void create_table_init_name(CreateTable *create_table, const char *relation_name) {
   create_table->relation_name = strdup(relation_name);
 }
+void create_table_set_durability(CreateTable *create_table, Durability durability) {
+  create_table->durability = durability;
+}
 void create_table_destroy(CreateTable *create_table) {
   for (size_t i = 0; i < create_table->attribute_count; i++) {
     attr_info_destroy(&create_table->attributes[i]);
   }
   create_table->attribute_count = 0;
+  create_table->durability = DURABILITY_DEFAULT;
   free(create_table->relation_name);
   create_table->relation_name = nullptr;
 }
@@ -311,20 +316,48 @@ void drop_table_destroy(DropTable *drop_table) {
   drop_table->relation_name = nullptr;
 }
 
-void create_index_init(CreateIndex *create_index, const char *index_name, 
-                       const char *relation_name, const char *attr_name) {
+void create_index_init(CreateIndex *create_index, const char *index_name, const char *relation_name) {
   create_index->index_name = strdup(index_name);
   create_index->relation_name = strdup(relation_name);
-  create_index->attribute_name = strdup(attr_name);
+}
+int create_index_append_attribute(CreateIndex *create_index, const char *attr_name) {
+  if (create_index->attribute_num >= MAX_NUM) {
+    return -1;
+  }
+  create_index->attribute_names[create_index->attribute_num++] = strdup(attr_name);
+  return 0;
+}
+int create_index_append_include(CreateIndex *create_index, const char *attr_name) {
+  if (create_index->include_num >= MAX_NUM) {
+    return -1;
+  }
+  create_index->include_names[create_index->include_num++] = strdup(attr_name);
+  return 0;
+}
+void create_index_set_type(CreateIndex *create_index, IndexType index_type) {
+  create_index->index_type = index_type;
+}
+void create_index_add_option(CreateIndex *create_index, IndexOption option) {
+  create_index->options |= option;
 }
 void create_index_destroy(CreateIndex *create_index) {
   free(create_index->index_name);
   free(create_index->relation_name);
-  free(create_index->attribute_name);
+  for (size_t i = 0; i < create_index->attribute_num; i++) {
+    free(create_index->attribute_names[i]);
+    create_index->attribute_names[i] = nullptr;
+  }
+  for (size_t i = 0; i < create_index->include_num; i++) {
+    free(create_index->include_names[i]);
+    create_index->include_names[i] = nullptr;
+  }
 
   create_index->index_name = nullptr;
   create_index->relation_name = nullptr;
-  create_index->attribute_name = nullptr;
+  create_index->attribute_num = 0;
+  create_index->include_num = 0;
+  create_index->index_type = INDEX_BPLUS_TREE;
+  create_index->options = 0;
 }
 
 void drop_index_init(DropIndex *drop_index, const char *index_name) {
@@ -365,6 +398,55 @@ void load_data_destroy(LoadData *load_data) {
   load_data->file_name = nullptr;
 }
 
+void set_variable_init(SetVariable *set_variable, const char *name, const char *value) {
+  set_variable->name = strdup(name);
+  set_variable->value = strdup(value);
+}
+
+void set_variable_destroy(SetVariable *set_variable) {
+  free(set_variable->name);
+  free(set_variable->value);
+  set_variable->name = nullptr;
+  set_variable->value = nullptr;
+}
+
+void backup_init(Backup *backup, const char *dir) {
+  if (dir[0] == '\'' || dir[0] == '\"') {
+    dir++;
+  }
+  backup->dir = strdup(dir);
+  int len = strlen(backup->dir);
+  if (len > 0 && (backup->dir[len - 1] == '\'' || backup->dir[len - 1] == '\"')) {
+    backup->dir[len - 1] = 0;
+  }
+}
+
+void backup_destroy(Backup *backup) {
+  free(backup->dir);
+  backup->dir = nullptr;
+}
+
+int parse_durability(const char *name, Durability *durability) {
+  static const Durability durabilities[] = {DURABILITY_DEFAULT, DURABILITY_SYNC, DURABILITY_ASYNC, DURABILITY_NOLOG};
+  for (Durability d : durabilities) {
+    if (strcasecmp(name, durability_name(d)) == 0) {
+      *durability = d;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+const char *durability_name(Durability durability) {
+  switch (durability) {
+    case DURABILITY_DEFAULT: return "default";
+    case DURABILITY_SYNC: return "sync";
+    case DURABILITY_ASYNC: return "async";
+    case DURABILITY_NOLOG: return "nolog";
+  }
+  return "unknown";
+}
+
 void query_init(Query *query) {
   query->flag = SCF_ERROR;
   memset(&query->sstr, 0, sizeof(query->sstr));
@@ -431,6 +513,14 @@ void query_reset(Query *query) {
       load_data_destroy(&query->sstr.load_data);
     }
     break;
+    case SCF_SET_VARIABLE: {
+      set_variable_destroy(&query->sstr.set_variable);
+    }
+    break;
+    case SCF_BACKUP: {
+      backup_destroy(&query->sstr.backup);
+    }
+    break;
     case SCF_BEGIN:
     case SCF_COMMIT:
     case SCF_ROLLBACK:
@@ -43,7 +43,8 @@ typedef enum {
 typedef enum { UNVALID, MAX, MIN, COUNT, AVG } AggreType;
 
 //属性值类型
-typedef enum { UNDEFINED, CHARS, INTS, FLOATS, DATES } AttrType;
+// BYTES 只在索引内部使用，表示可以直接用memcmp比较的定长字节串(组合索引的key)
+typedef enum { UNDEFINED, CHARS, INTS, FLOATS, DATES, BYTES } AttrType;
 
 //属性值
 typedef struct _Value {
@@ -106,11 +107,22 @@ typedef struct {
   size_t length;  // Length of attribute
 } AttrInfo;
 
+/**
+ * 事务提交的持久性级别，表上设置的是默认值，会话上设置后覆盖表的设置
+ */
+typedef enum {
+  DURABILITY_DEFAULT,   // 会话: 按事务修改过的表中最强的级别提交; 表: 同DURABILITY_SYNC
+  DURABILITY_SYNC,      // COMMIT日志落盘之后才返回
+  DURABILITY_ASYNC,     // COMMIT日志追加到日志缓冲区就返回，后台在CLogAsyncCommitDelay毫秒内落盘
+  DURABILITY_NOLOG      // 只用于表: 表上的修改不记日志，崩溃之后表被清空，正常关闭时数据保留
+} Durability;
+
 // struct of craete_table
 typedef struct {
   char *relation_name;           // Relation name
   size_t attribute_count;        // Length of attribute
   AttrInfo attributes[MAX_NUM];  // attributes
+  Durability durability;         // DURABILITY = SYNC | ASYNC | NOLOG
 } CreateTable;
 
 // struct of drop_table
@@ -118,11 +130,27 @@ typedef struct {
   char *relation_name;  // Relation name
 } DropTable;
 
+typedef enum {
+  INDEX_BPLUS_TREE,   // 默认的B+树索引
+  INDEX_HASH,         // 哈希索引，只支持等值查找
+  INDEX_LSM           // LSM树索引，写入只修改内存，适合写多读少的表
+} IndexType;
+
+typedef enum {
+  INDEX_OPTION_BLOOM_FILTER = 1,    // WITH BLOOM，在B+树索引上建Bloom过滤器
+  INDEX_OPTION_ADAPTIVE_HASH = 2    // WITH ADAPTIVE_HASH，热点值的查找直接定位到叶子节点
+} IndexOption;
+
 // struct of create_index
 typedef struct {
-  char *index_name;      // Index name
-  char *relation_name;   // Relation name
-  char *attribute_name;  // Attribute name
+  char *index_name;                 // Index name
+  char *relation_name;              // Relation name
+  size_t attribute_num;             // Length of attribute names
+  char *attribute_names[MAX_NUM];   // Attribute names, 组合索引按列的顺序排列
+  size_t include_num;               // Length of include attribute names
+  char *include_names[MAX_NUM];     // INCLUDE的字段，只保存在索引叶子中，不参与排序
+  IndexType index_type;             // USING HASH / USING BTREE
+  int options;                      // IndexOption的组合
 } CreateIndex;
 
 // struct of  drop_index
@@ -139,6 +167,17 @@ typedef struct {
   const char *file_name;
 } LoadData;
 
+// SET name = value，设置当前会话的变量
+typedef struct {
+  char *name;
+  char *value;
+} SetVariable;
+
+// BACKUP TO 'dir'，在线备份
+typedef struct {
+  char *dir;
+} Backup;
+
 union Queries {
   Selects selection;
   Inserts insertion;
@@ -150,6 +189,8 @@ union Queries {
   DropIndex drop_index;
   DescTable desc_table;
   LoadData load_data;
+  SetVariable set_variable;
+  Backup backup;
   char *errors;
 };
 
@@ -172,7 +213,9 @@ enum SqlCommandFlag {
   SCF_ROLLBACK,
   SCF_LOAD_DATA,
   SCF_HELP,
-  SCF_EXIT
+  SCF_EXIT,
+  SCF_SET_VARIABLE,
+  SCF_BACKUP
 };
 // struct of flag and sql_struct
 typedef struct Query {
@@ -221,13 +264,20 @@ void updates_destroy(Updates *updates);
 
 void create_table_append_attribute(CreateTable *create_table, AttrInfo *attr_info);
 void create_table_init_name(CreateTable *create_table, const char *relation_name);
+void create_table_set_durability(CreateTable *create_table, Durability durability);
 void create_table_destroy(CreateTable *create_table);
 
 void drop_table_init(DropTable *drop_table, const char *relation_name);
 void drop_table_destroy(DropTable *drop_table);
 
-void create_index_init(
-    CreateIndex *create_index, const char *index_name, const char *relation_name, const char *attr_name);
+void create_index_init(CreateIndex *create_index, const char *index_name, const char *relation_name);
+/**
+ * 字段超过MAX_NUM时返回-1，整条语句按语法错误处理，不会建一个少了字段的索引
+ */
+int create_index_append_attribute(CreateIndex *create_index, const char *attr_name);
+int create_index_append_include(CreateIndex *create_index, const char *attr_name);
+void create_index_set_type(CreateIndex *create_index, IndexType index_type);
+void create_index_add_option(CreateIndex *create_index, IndexOption option);
 void create_index_destroy(CreateIndex *create_index);
 
 void drop_index_init(DropIndex *drop_index, const char *index_name);
@@ -239,6 +289,18 @@ void desc_table_destroy(DescTable *desc_table);
 void load_data_init(LoadData *load_data, const char *relation_name, const char *file_name);
 void load_data_destroy(LoadData *load_data);
 
+void set_variable_init(SetVariable *set_variable, const char *name, const char *value);
+void set_variable_destroy(SetVariable *set_variable);
+
+void backup_init(Backup *backup, const char *dir);
+void backup_destroy(Backup *backup);
+
+/**
+ * 不区分大小写地解析sync、async、nolog、default，成功返回0
+ */
+int parse_durability(const char *name, Durability *durability);
+const char *durability_name(Durability durability);
+
 void query_init(Query *query);
 Query *query_create();  // create and init
 void query_reset(Query *query);
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -34,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -41,14 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
-
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.5.1"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -124,7 +125,7 @@ ParserContext *get_context(yyscan_t scanner)
 #define CONTEXT get_context(scanner)
 
 
-#line 128 "yacc_sql.tab.c"
+#line 129 "yacc_sql.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -147,171 +148,115 @@ ParserContext *get_context(yyscan_t scanner)
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* Use api.header.include to #include this header
-   instead of duplicating it here.  */
-#ifndef YY_YY_Y_TAB_H_INCLUDED
-# define YY_YY_Y_TAB_H_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 0
-#endif
-#if YYDEBUG
-extern int yydebug;
-#endif
-
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    SEMICOLON = 258,
-    CREATE = 259,
-    DROP = 260,
-    TABLE = 261,
-    TABLES = 262,
-    INDEX = 263,
-    SELECT = 264,
-    DESC = 265,
-    SHOW = 266,
-    SYNC = 267,
-    INSERT = 268,
-    DELETE = 269,
-    UPDATE = 270,
-    LBRACE = 271,
-    RBRACE = 272,
-    COMMA = 273,
-    TRX_BEGIN = 274,
-    TRX_COMMIT = 275,
-    TRX_ROLLBACK = 276,
-    INT_T = 277,
-    STRING_T = 278,
-    FLOAT_T = 279,
-    DATE_T = 280,
-    HELP = 281,
-    EXIT = 282,
-    DOT = 283,
-    INTO = 284,
-    VALUES = 285,
-    FROM = 286,
-    WHERE = 287,
-    AND = 288,
-    SET = 289,
-    ON = 290,
-    LOAD = 291,
-    DATA = 292,
-    INFILE = 293,
-    _MAX = 294,
-    _MIN = 295,
-    _COUNT = 296,
-    _AVG = 297,
-    EQ = 298,
-    LT = 299,
-    GT = 300,
-    LE = 301,
-    GE = 302,
-    NE = 303,
-    NUMBER = 304,
-    FLOAT = 305,
-    ID = 306,
-    PATH = 307,
-    SSS = 308,
-    STAR = 309,
-    STRING_V = 310,
-    DATE = 311
-  };
-#endif
-/* Tokens.  */
-#define SEMICOLON 258
-#define CREATE 259
-#define DROP 260
-#define TABLE 261
-#define TABLES 262
-#define INDEX 263
-#define SELECT 264
-#define DESC 265
-#define SHOW 266
-#define SYNC 267
-#define INSERT 268
-#define DELETE 269
-#define UPDATE 270
-#define LBRACE 271
-#define RBRACE 272
-#define COMMA 273
-#define TRX_BEGIN 274
-#define TRX_COMMIT 275
-#define TRX_ROLLBACK 276
-#define INT_T 277
-#define STRING_T 278
-#define FLOAT_T 279
-#define DATE_T 280
-#define HELP 281
-#define EXIT 282
-#define DOT 283
-#define INTO 284
-#define VALUES 285
-#define FROM 286
-#define WHERE 287
-#define AND 288
-#define SET 289
-#define ON 290
-#define LOAD 291
-#define DATA 292
-#define INFILE 293
-#define _MAX 294
-#define _MIN 295
-#define _COUNT 296
-#define _AVG 297
-#define EQ 298
-#define LT 299
-#define GT 300
-#define LE 301
-#define GE 302
-#define NE 303
-#define NUMBER 304
-#define FLOAT 305
-#define ID 306
-#define PATH 307
-#define SSS 308
-#define STAR 309
-#define STRING_V 310
-#define DATE 311
-
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-union YYSTYPE
+#include "yacc_sql.tab.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
 {
-#line 112 "yacc_sql.y"
-
-  struct _Attr *attr;
-  struct _Condition *condition1;
-  struct _Value *value1;
-  char *string;
-  int number;
-  float floats;
-  char *position;
-  char*  date;
-
-#line 303 "yacc_sql.tab.c"
-
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_SEMICOLON = 3,                  /* SEMICOLON  */
+  YYSYMBOL_CREATE = 4,                     /* CREATE  */
+  YYSYMBOL_DROP = 5,                       /* DROP  */
+  YYSYMBOL_TABLE = 6,                      /* TABLE  */
+  YYSYMBOL_TABLES = 7,                     /* TABLES  */
+  YYSYMBOL_INDEX = 8,                      /* INDEX  */
+  YYSYMBOL_SELECT = 9,                     /* SELECT  */
+  YYSYMBOL_DESC = 10,                      /* DESC  */
+  YYSYMBOL_SHOW = 11,                      /* SHOW  */
+  YYSYMBOL_SYNC = 12,                      /* SYNC  */
+  YYSYMBOL_INSERT = 13,                    /* INSERT  */
+  YYSYMBOL_DELETE = 14,                    /* DELETE  */
+  YYSYMBOL_UPDATE = 15,                    /* UPDATE  */
+  YYSYMBOL_LBRACE = 16,                    /* LBRACE  */
+  YYSYMBOL_RBRACE = 17,                    /* RBRACE  */
+  YYSYMBOL_COMMA = 18,                     /* COMMA  */
+  YYSYMBOL_TRX_BEGIN = 19,                 /* TRX_BEGIN  */
+  YYSYMBOL_TRX_COMMIT = 20,                /* TRX_COMMIT  */
+  YYSYMBOL_TRX_ROLLBACK = 21,              /* TRX_ROLLBACK  */
+  YYSYMBOL_INT_T = 22,                     /* INT_T  */
+  YYSYMBOL_STRING_T = 23,                  /* STRING_T  */
+  YYSYMBOL_FLOAT_T = 24,                   /* FLOAT_T  */
+  YYSYMBOL_DATE_T = 25,                    /* DATE_T  */
+  YYSYMBOL_HELP = 26,                      /* HELP  */
+  YYSYMBOL_EXIT = 27,                      /* EXIT  */
+  YYSYMBOL_DOT = 28,                       /* DOT  */
+  YYSYMBOL_INTO = 29,                      /* INTO  */
+  YYSYMBOL_VALUES = 30,                    /* VALUES  */
+  YYSYMBOL_FROM = 31,                      /* FROM  */
+  YYSYMBOL_WHERE = 32,                     /* WHERE  */
+  YYSYMBOL_AND = 33,                       /* AND  */
+  YYSYMBOL_SET = 34,                       /* SET  */
+  YYSYMBOL_ON = 35,                        /* ON  */
+  YYSYMBOL_LOAD = 36,                      /* LOAD  */
+  YYSYMBOL_DATA = 37,                      /* DATA  */
+  YYSYMBOL_INFILE = 38,                    /* INFILE  */
+  YYSYMBOL__MAX = 39,                      /* _MAX  */
+  YYSYMBOL__MIN = 40,                      /* _MIN  */
+  YYSYMBOL__COUNT = 41,                    /* _COUNT  */
+  YYSYMBOL__AVG = 42,                      /* _AVG  */
+  YYSYMBOL_EQ = 43,                        /* EQ  */
+  YYSYMBOL_LT = 44,                        /* LT  */
+  YYSYMBOL_GT = 45,                        /* GT  */
+  YYSYMBOL_LE = 46,                        /* LE  */
+  YYSYMBOL_GE = 47,                        /* GE  */
+  YYSYMBOL_NE = 48,                        /* NE  */
+  YYSYMBOL_NUMBER = 49,                    /* NUMBER  */
+  YYSYMBOL_FLOAT = 50,                     /* FLOAT  */
+  YYSYMBOL_ID = 51,                        /* ID  */
+  YYSYMBOL_PATH = 52,                      /* PATH  */
+  YYSYMBOL_SSS = 53,                       /* SSS  */
+  YYSYMBOL_STAR = 54,                      /* STAR  */
+  YYSYMBOL_STRING_V = 55,                  /* STRING_V  */
+  YYSYMBOL_DATE = 56,                      /* DATE  */
+  YYSYMBOL_YYACCEPT = 57,                  /* $accept  */
+  YYSYMBOL_commands = 58,                  /* commands  */
+  YYSYMBOL_command = 59,                   /* command  */
+  YYSYMBOL_exit = 60,                      /* exit  */
+  YYSYMBOL_help = 61,                      /* help  */
+  YYSYMBOL_sync = 62,                      /* sync  */
+  YYSYMBOL_begin = 63,                     /* begin  */
+  YYSYMBOL_commit = 64,                    /* commit  */
+  YYSYMBOL_rollback = 65,                  /* rollback  */
+  YYSYMBOL_set_variable = 66,              /* set_variable  */
+  YYSYMBOL_backup = 67,                    /* backup  */
+  YYSYMBOL_option_value = 68,              /* option_value  */
+  YYSYMBOL_drop_table = 69,                /* drop_table  */
+  YYSYMBOL_show_tables = 70,               /* show_tables  */
+  YYSYMBOL_desc_table = 71,                /* desc_table  */
+  YYSYMBOL_create_index = 72,              /* create_index  */
+  YYSYMBOL_index_attr = 73,                /* index_attr  */
+  YYSYMBOL_index_attr_list = 74,           /* index_attr_list  */
+  YYSYMBOL_index_options = 75,             /* index_options  */
+  YYSYMBOL_index_option = 76,              /* index_option  */
+  YYSYMBOL_include_attr = 77,              /* include_attr  */
+  YYSYMBOL_include_attr_list = 78,         /* include_attr_list  */
+  YYSYMBOL_drop_index = 79,                /* drop_index  */
+  YYSYMBOL_create_table = 80,              /* create_table  */
+  YYSYMBOL_table_options = 81,             /* table_options  */
+  YYSYMBOL_attr_def_list = 82,             /* attr_def_list  */
+  YYSYMBOL_attr_def = 83,                  /* attr_def  */
+  YYSYMBOL_number = 84,                    /* number  */
+  YYSYMBOL_type = 85,                      /* type  */
+  YYSYMBOL_ID_get = 86,                    /* ID_get  */
+  YYSYMBOL_insert = 87,                    /* insert  */
+  YYSYMBOL_value_list = 88,                /* value_list  */
+  YYSYMBOL_value = 89,                     /* value  */
+  YYSYMBOL_delete = 90,                    /* delete  */
+  YYSYMBOL_update = 91,                    /* update  */
+  YYSYMBOL_select = 92,                    /* select  */
+  YYSYMBOL_select_attr = 93,               /* select_attr  */
+  YYSYMBOL_attr_list = 94,                 /* attr_list  */
+  YYSYMBOL_rel_list = 95,                  /* rel_list  */
+  YYSYMBOL_where = 96,                     /* where  */
+  YYSYMBOL_condition_list = 97,            /* condition_list  */
+  YYSYMBOL_condition = 98,                 /* condition  */
+  YYSYMBOL_comOp = 99,                     /* comOp  */
+  YYSYMBOL_load_data = 100                 /* load_data  */
 };
-typedef union YYSTYPE YYSTYPE;
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
-#endif
-
-
-
-int yyparse (void *scanner);
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-#endif /* !YY_YY_Y_TAB_H_INCLUDED  */
 
 
 
@@ -352,6 +297,18 @@ typedef int_least16_t yytype_int16;
 typedef short yytype_int16;
 #endif
 
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
 #if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
 typedef __UINT_LEAST8_TYPE__ yytype_uint8;
 #elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
@@ -411,6 +368,7 @@ typedef int yytype_uint16;
 
 #define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
 
+
 /* Stored state numbers (used for stacks). */
 typedef yytype_int16 yy_state_t;
 
@@ -429,6 +387,7 @@ typedef int yy_state_fast_t;
 # endif
 #endif
 
+
 #ifndef YY_ATTRIBUTE_PURE
 # if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
 #  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
@@ -447,17 +406,23 @@ typedef int yy_state_fast_t;
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && ! defined __ICC && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                            \
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
     _Pragma ("GCC diagnostic push")                                     \
     _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
 # define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
@@ -486,7 +451,7 @@ typedef int yy_state_fast_t;
 
 #define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -551,8 +516,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -617,25 +581,27 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  2
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   263
+#define YYLAST   294
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  57
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  34
+#define YYNNTS  44
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  104
+#define YYNRULES  122
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  264
+#define YYNSTATES  299
 
-#define YYUNDEFTOK  2
+/* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   311
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex, with out-of-bounds checking.  */
-#define YYTRANSLATE(YYX)                                                \
-  (0 <= (YYX) && (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex.  */
@@ -676,60 +642,63 @@ static const yytype_int8 yytranslate[] =
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,   140,   140,   142,   146,   147,   148,   149,   150,   151,
-     152,   153,   154,   155,   156,   157,   158,   159,   160,   161,
-     162,   166,   171,   176,   182,   188,   194,   200,   206,   212,
-     219,   227,   234,   243,   245,   249,   260,   273,   276,   277,
-     278,   279,   282,   291,   307,   309,   314,   317,   320,   324,
-     330,   340,   350,   369,   374,   379,   384,   390,   396,   402,
-     408,   414,   420,   426,   432,   438,   444,   450,   456,   463,
-     465,   470,   475,   481,   487,   493,   499,   505,   511,   517,
-     523,   529,   535,   541,   547,   555,   557,   561,   563,   567,
-     569,   574,   595,   615,   635,   657,   678,   699,   721,   722,
-     723,   724,   725,   726,   730
+       0,   141,   141,   143,   147,   148,   149,   150,   151,   152,
+     153,   154,   155,   156,   157,   158,   159,   160,   161,   162,
+     163,   164,   165,   169,   174,   179,   185,   191,   197,   203,
+     210,   222,   223,   227,   233,   239,   246,   253,   260,   262,
+     265,   267,   271,   278,   305,   312,   314,   319,   326,   335,
+     337,   348,   350,   354,   365,   378,   381,   382,   383,   384,
+     387,   396,   412,   414,   419,   422,   425,   429,   435,   445,
+     455,   474,   479,   484,   489,   495,   501,   507,   513,   519,
+     525,   531,   537,   543,   549,   555,   561,   568,   570,   575,
+     580,   586,   592,   598,   604,   610,   616,   622,   628,   634,
+     640,   646,   652,   660,   662,   666,   668,   672,   674,   679,
+     700,   720,   740,   762,   783,   804,   826,   827,   828,   829,
+     830,   831,   835
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "SEMICOLON", "CREATE", "DROP", "TABLE",
-  "TABLES", "INDEX", "SELECT", "DESC", "SHOW", "SYNC", "INSERT", "DELETE",
-  "UPDATE", "LBRACE", "RBRACE", "COMMA", "TRX_BEGIN", "TRX_COMMIT",
-  "TRX_ROLLBACK", "INT_T", "STRING_T", "FLOAT_T", "DATE_T", "HELP", "EXIT",
-  "DOT", "INTO", "VALUES", "FROM", "WHERE", "AND", "SET", "ON", "LOAD",
-  "DATA", "INFILE", "_MAX", "_MIN", "_COUNT", "_AVG", "EQ", "LT", "GT",
-  "LE", "GE", "NE", "NUMBER", "FLOAT", "ID", "PATH", "SSS", "STAR",
-  "STRING_V", "DATE", "$accept", "commands", "command", "exit", "help",
-  "sync", "begin", "commit", "rollback", "drop_table", "show_tables",
-  "desc_table", "create_index", "drop_index", "create_table",
-  "attr_def_list", "attr_def", "number", "type", "ID_get", "insert",
-  "value_list", "value", "delete", "update", "select", "select_attr",
-  "attr_list", "rel_list", "where", "condition_list", "condition", "comOp",
-  "load_data", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "SEMICOLON", "CREATE",
+  "DROP", "TABLE", "TABLES", "INDEX", "SELECT", "DESC", "SHOW", "SYNC",
+  "INSERT", "DELETE", "UPDATE", "LBRACE", "RBRACE", "COMMA", "TRX_BEGIN",
+  "TRX_COMMIT", "TRX_ROLLBACK", "INT_T", "STRING_T", "FLOAT_T", "DATE_T",
+  "HELP", "EXIT", "DOT", "INTO", "VALUES", "FROM", "WHERE", "AND", "SET",
+  "ON", "LOAD", "DATA", "INFILE", "_MAX", "_MIN", "_COUNT", "_AVG", "EQ",
+  "LT", "GT", "LE", "GE", "NE", "NUMBER", "FLOAT", "ID", "PATH", "SSS",
+  "STAR", "STRING_V", "DATE", "$accept", "commands", "command", "exit",
+  "help", "sync", "begin", "commit", "rollback", "set_variable", "backup",
+  "option_value", "drop_table", "show_tables", "desc_table",
+  "create_index", "index_attr", "index_attr_list", "index_options",
+  "index_option", "include_attr", "include_attr_list", "drop_index",
+  "create_table", "table_options", "attr_def_list", "attr_def", "number",
+  "type", "ID_get", "insert", "value_list", "value", "delete", "update",
+  "select", "select_attr", "attr_list", "rel_list", "where",
+  "condition_list", "condition", "comOp", "load_data", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_int16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,   297,   298,   299,   300,   301,   302,   303,   304,
-     305,   306,   307,   308,   309,   310,   311
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF (-131)
+#define YYPACT_NINF (-143)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -739,230 +708,252 @@ static const yytype_int16 yytoknum[] =
 #define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-    -131,    23,  -131,    45,   147,    29,   -44,    24,    36,    17,
-      -5,     1,    70,    76,    82,    83,   122,    96,  -131,  -131,
-    -131,  -131,  -131,  -131,  -131,  -131,  -131,  -131,  -131,  -131,
-    -131,  -131,  -131,  -131,  -131,  -131,    88,    95,   103,   115,
-     151,   152,   153,   154,    30,  -131,   140,   169,   170,  -131,
-     123,   124,   142,  -131,  -131,  -131,  -131,  -131,   139,   162,
-     144,   177,   178,     6,    50,    56,    64,   -31,    72,  -131,
-     131,  -131,  -131,   155,   156,   132,   133,   136,   138,  -131,
-    -131,   -11,   167,    -3,   173,    12,   174,    13,   175,   179,
-     180,   181,   182,    54,   176,   176,   183,   184,    63,   190,
-     159,   185,  -131,   186,   127,   187,   176,   148,   176,   176,
-     157,   176,   176,   158,   176,   176,   160,   176,    80,    93,
-     109,   110,   111,  -131,  -131,  -131,   161,   156,    92,  -131,
-    -131,    19,  -131,  -131,    47,   172,  -131,    92,   200,   136,
-     193,  -131,  -131,  -131,  -131,   191,   164,  -131,   196,  -131,
-    -131,   199,  -131,  -131,   201,  -131,  -131,   202,  -131,    28,
-     203,    59,   204,    60,   205,    61,   206,   176,   176,   183,
-     214,   207,   188,  -131,  -131,  -131,  -131,  -131,  -131,    71,
-      79,    63,  -131,   156,   189,   186,   221,   192,   209,   176,
-     176,   176,   176,   176,   194,   176,   176,   195,   176,   176,
-     197,   176,   176,   198,   176,  -131,  -131,  -131,  -131,    92,
-     210,    47,  -131,  -131,   208,  -131,   172,   225,   226,  -131,
-    -131,  -131,   213,   228,  -131,  -131,  -131,  -131,  -131,   215,
-    -131,  -131,   216,  -131,  -131,   217,  -131,  -131,   218,  -131,
-     207,   234,    87,   211,  -131,  -131,  -131,  -131,  -131,   176,
-     176,   176,   176,  -131,  -131,   219,  -131,  -131,  -131,  -131,
-    -131,  -131,   212,  -131
+    -143,    27,  -143,    51,   167,    31,   -42,     8,    13,     0,
+      -1,   -17,    49,    55,    95,   113,   128,   -16,    14,    59,
+    -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,
+    -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,
+      72,    88,   121,   125,   131,   142,   161,   162,    32,  -143,
+     148,   177,   178,  -143,   132,   133,   151,  -143,  -143,  -143,
+    -143,  -143,   139,   149,   135,   170,   154,   187,   188,   -40,
+      78,    86,    94,    48,   105,  -143,   141,  -143,  -143,   163,
+     164,   143,    -6,   144,   192,   147,   150,  -143,  -143,   -10,
+     182,    -7,   183,    -4,   185,    16,   186,   189,   190,   191,
+     193,    73,   194,   194,   195,   198,    69,   201,   165,  -143,
+    -143,   207,   196,  -143,  -143,   197,    52,   200,   194,   160,
+     194,   194,   166,   194,   194,   168,   194,   194,   169,   194,
+     106,   110,   111,   112,   120,  -143,  -143,  -143,   171,   164,
+      44,  -143,  -143,    21,  -143,  -143,   107,   199,  -143,    44,
+    -143,   212,   147,   204,  -143,  -143,  -143,  -143,   208,   172,
+    -143,   209,  -143,  -143,   210,  -143,  -143,   211,  -143,  -143,
+     213,  -143,    64,   214,    67,   216,    79,   217,    96,   218,
+     194,   194,   195,   226,   219,   202,  -143,  -143,  -143,  -143,
+    -143,  -143,    77,    85,    69,  -143,   164,   203,   197,   205,
+     206,  -143,   220,   194,   194,   194,   194,   194,   215,   194,
+     194,   221,   194,   194,   222,   194,   194,   223,   194,  -143,
+    -143,  -143,  -143,    44,   224,   107,  -143,  -143,   229,  -143,
+     199,   233,   236,  -143,   225,   237,  -143,   227,   172,   228,
+    -143,  -143,  -143,  -143,  -143,   230,  -143,  -143,   231,  -143,
+    -143,   232,  -143,  -143,   234,  -143,   219,   239,    93,   235,
+    -143,  -143,  -143,    -6,  -143,  -143,   220,   238,   194,   194,
+     194,   194,  -143,  -143,   241,  -143,  -143,  -143,  -143,    -8,
+     240,   238,  -143,  -143,  -143,  -143,   242,   243,  -143,  -143,
+    -143,  -143,  -143,   244,   243,   246,   244,  -143,  -143
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
        2,     0,     1,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,     0,     0,     0,     0,     3,    20,
-      19,    14,    15,    16,    17,     9,    10,    11,    12,    13,
-       8,     5,     7,     6,     4,    18,     0,     0,     0,     0,
-       0,     0,     0,     0,    69,    53,     0,     0,     0,    23,
-       0,     0,     0,    24,    25,    26,    22,    21,     0,     0,
-       0,     0,     0,     0,     0,     0,     0,     0,     0,    54,
-       0,    29,    28,     0,    87,     0,     0,     0,     0,    27,
-      31,     0,     0,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,    69,    69,    69,    85,     0,     0,     0,
-       0,     0,    42,    33,     0,     0,    69,     0,    69,    69,
-       0,    69,    69,     0,    69,    69,     0,    69,     0,     0,
-       0,     0,     0,    70,    56,    55,     0,    87,     0,    46,
-      47,     0,    48,    49,     0,    89,    50,     0,     0,     0,
-       0,    38,    39,    40,    41,    36,     0,    58,     0,    57,
-      64,     0,    63,    61,     0,    60,    67,     0,    66,     0,
-       0,     0,     0,     0,     0,     0,     0,    69,    69,    85,
-       0,    44,     0,    98,    99,   100,   101,   102,   103,     0,
-       0,     0,    88,    87,     0,    33,     0,     0,     0,    69,
-      69,    69,    69,    69,     0,    69,    69,     0,    69,    69,
-       0,    69,    69,     0,    69,    72,    71,    86,    52,     0,
-       0,     0,    93,    91,    94,    92,    89,     0,     0,    34,
-      32,    37,     0,     0,    59,    65,    62,    68,    74,     0,
-      73,    80,     0,    79,    77,     0,    76,    83,     0,    82,
-      44,     0,     0,     0,    90,    51,   104,    35,    30,    69,
-      69,    69,    69,    45,    43,     0,    95,    96,    75,    81,
-      78,    84,     0,    97
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       3,    20,    19,    14,    15,    16,    17,    21,    22,     9,
+      10,    11,    12,    13,     8,     5,     7,     6,     4,    18,
+       0,     0,     0,     0,     0,     0,     0,     0,    87,    71,
+       0,     0,     0,    25,     0,     0,     0,    26,    27,    28,
+      24,    23,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,    72,     0,    35,    34,     0,
+     105,     0,     0,     0,     0,     0,     0,    33,    47,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,    87,    87,    87,   103,     0,     0,     0,     0,    32,
+      31,     0,     0,    30,    60,    51,     0,     0,    87,     0,
+      87,    87,     0,    87,    87,     0,    87,    87,     0,    87,
+       0,     0,     0,     0,     0,    88,    74,    73,     0,   105,
+       0,    64,    65,     0,    66,    67,     0,   107,    68,     0,
+      29,     0,     0,     0,    56,    57,    58,    59,    54,     0,
+      76,     0,    75,    82,     0,    81,    79,     0,    78,    85,
+       0,    84,     0,     0,     0,     0,     0,     0,     0,     0,
+      87,    87,   103,     0,    62,     0,   116,   117,   118,   119,
+     120,   121,     0,     0,     0,   106,   105,     0,    51,    49,
+       0,    37,    38,    87,    87,    87,    87,    87,     0,    87,
+      87,     0,    87,    87,     0,    87,    87,     0,    87,    90,
+      89,   104,    70,     0,     0,     0,   111,   109,   112,   110,
+     107,     0,     0,    52,     0,     0,    55,     0,     0,     0,
+      77,    83,    80,    86,    92,     0,    91,    98,     0,    97,
+      95,     0,    94,   101,     0,   100,    62,     0,     0,     0,
+     108,    69,   122,     0,    48,    53,    38,    40,    87,    87,
+      87,    87,    63,    61,     0,   113,   114,    50,    39,     0,
+       0,    40,    93,    99,    96,   102,     0,     0,    43,    36,
+      41,   115,    44,    45,     0,     0,    45,    42,    46
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
-    -131,  -131,  -131,  -131,  -131,  -131,  -131,  -131,  -131,  -131,
-    -131,  -131,  -131,  -131,  -131,    53,   104,  -131,  -131,  -131,
-    -131,     2,  -125,  -131,  -131,  -131,  -131,   -93,    75,  -122,
-      34,    73,  -130,  -131
+    -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,  -143,
+    -143,   -13,  -143,  -143,  -143,  -143,    20,   -20,   -29,  -143,
+     -35,   -36,  -143,  -143,  -143,    63,   115,  -143,  -143,  -143,
+    -143,     9,  -137,  -143,  -143,  -143,  -143,  -101,    82,  -134,
+      40,    81,  -142,  -143
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int16 yydefgoto[] =
 {
-      -1,     1,    18,    19,    20,    21,    22,    23,    24,    25,
-      26,    27,    28,    29,    30,   140,   103,   222,   145,   104,
-      31,   210,   134,    32,    33,    34,    46,    69,   127,    99,
-     182,   135,   179,    35
+       0,     1,    20,    21,    22,    23,    24,    25,    26,    27,
+      28,   111,    29,    30,    31,    32,   202,   239,   280,   281,
+     293,   295,    33,    34,   235,   153,   115,   237,   158,   116,
+      35,   224,   146,    36,    37,    38,    50,    75,   139,   107,
+     195,   147,   192,    39
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int16 yytable[] =
 {
-     123,   124,   125,   171,   180,   170,   106,    47,    89,    90,
-      91,    92,   183,   147,   109,   149,   150,   107,   152,   153,
-      93,   155,   156,     2,   158,   110,    51,     3,     4,   112,
-     115,    48,     5,     6,     7,     8,     9,    10,    11,    49,
-     113,   116,    12,    13,    14,   193,    50,   172,    67,    15,
-      16,    36,    52,    37,   213,   215,   194,    81,    68,    17,
-      82,   217,   173,   174,   175,   176,   177,   178,    40,    41,
-      42,    43,    67,    53,   205,   206,   196,   199,   202,    54,
-      44,   242,   122,    45,   240,    55,    56,   197,   200,   203,
-     173,   174,   175,   176,   177,   178,   224,   225,   226,   227,
-     228,    83,   230,   231,    84,   233,   234,    85,   236,   237,
-      86,   239,   129,   130,   131,    87,   132,   256,    88,   133,
-     129,   130,   212,    94,   132,    57,    95,   133,   129,   130,
-     214,   159,   132,    58,   160,   133,   129,   130,   255,    59,
-     132,   129,   130,   133,   161,   132,    60,   162,   133,   141,
-     142,   143,   144,    38,    61,    39,   258,   259,   260,   261,
-     163,   165,   167,   164,   166,   168,    62,    63,    64,    65,
-      66,    70,    71,    72,    73,    74,    75,    76,    77,    78,
-      79,    80,    96,   100,   108,    97,   101,   102,    98,   105,
-     111,   114,   117,   136,    67,   118,   119,   120,   121,   148,
-     128,   126,   137,   146,   139,   181,   184,   187,   151,   154,
-     186,   157,   169,   189,   138,   188,   190,   208,   191,   192,
-     195,   198,   201,   204,   220,   209,   223,   241,   245,   246,
-     247,   248,   249,   250,   251,   252,   243,   254,   219,   211,
-     218,   221,   253,   185,   207,   229,   232,   262,   235,   238,
-     244,     0,     0,     0,   216,     0,     0,     0,     0,     0,
-       0,     0,   257,   263
+     135,   136,   137,   184,   193,   183,   109,   118,   287,    51,
+     121,    89,   196,   124,    90,    52,    53,   160,   119,   162,
+     163,   122,   165,   166,   125,   168,   169,     2,   171,    54,
+      55,     3,     4,   127,    56,    62,     5,     6,     7,     8,
+       9,    10,    11,   288,   128,   110,    12,    13,    14,   185,
+      73,    63,    57,    15,    16,   227,   229,    40,    58,    41,
+      74,    17,   231,    18,   186,   187,   188,   189,   190,   191,
+      44,    45,    46,    47,   154,   155,   156,   157,    19,   219,
+     220,   207,    48,   258,   210,    49,   256,    97,    98,    99,
+     100,    73,   208,   141,   142,   211,   213,   144,    59,   101,
+     145,   134,   240,   241,   242,   243,   244,   214,   246,   247,
+      64,   249,   250,   216,   252,   253,    60,   255,   141,   142,
+     143,   275,   144,    65,   217,   145,   141,   142,   226,    91,
+     144,    61,    92,   145,   141,   142,   228,    93,   144,    66,
+      94,   145,   141,   142,   274,    95,   144,    69,    96,   145,
+     186,   187,   188,   189,   190,   191,   102,   172,    70,   103,
+     173,   174,   176,   178,   175,   177,   179,   282,   283,   284,
+     285,   180,    67,    42,   181,    43,    68,    71,    72,    76,
+      77,    78,    82,    79,    80,    81,    85,    83,    84,    86,
+      87,    88,   104,   105,   108,   113,   106,   112,   114,   120,
+     123,   117,   126,   129,   148,   130,   131,   132,   149,   133,
+     150,   161,    73,   138,   140,   152,   159,   164,   197,   167,
+     170,   199,   182,   201,   200,   151,   203,   204,   205,   222,
+     206,   209,   194,   212,   215,   218,   261,   223,   238,   262,
+     264,   257,   273,   289,   265,   267,   278,   268,   269,   270,
+     277,   271,   290,   225,   232,   236,   234,   259,   266,   296,
+     298,   233,   294,   297,   221,   272,   245,   198,   263,   286,
+     260,     0,   248,   251,   254,   230,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,   276,     0,     0,   279,
+       0,     0,     0,   291,   292
 };
 
 static const yytype_int16 yycheck[] =
 {
-      93,    94,    95,   128,   134,   127,    17,    51,    39,    40,
-      41,    42,   137,   106,    17,   108,   109,    28,   111,   112,
-      51,   114,   115,     0,   117,    28,    31,     4,     5,    17,
-      17,     7,     9,    10,    11,    12,    13,    14,    15,     3,
-      28,    28,    19,    20,    21,    17,    29,    28,    18,    26,
-      27,     6,    51,     8,   179,   180,    28,    51,    28,    36,
-      54,   183,    43,    44,    45,    46,    47,    48,    39,    40,
-      41,    42,    18,     3,   167,   168,    17,    17,    17,     3,
-      51,   211,    28,    54,   209,     3,     3,    28,    28,    28,
-      43,    44,    45,    46,    47,    48,   189,   190,   191,   192,
-     193,    51,   195,   196,    54,   198,   199,    51,   201,   202,
-      54,   204,    49,    50,    51,    51,    53,   242,    54,    56,
-      49,    50,    51,    51,    53,     3,    54,    56,    49,    50,
-      51,    51,    53,    37,    54,    56,    49,    50,    51,    51,
-      53,    49,    50,    56,    51,    53,    51,    54,    56,    22,
-      23,    24,    25,     6,    51,     8,   249,   250,   251,   252,
-      51,    51,    51,    54,    54,    54,    51,    16,    16,    16,
-      16,    31,     3,     3,    51,    51,    34,    38,    16,    35,
-       3,     3,    51,    51,    17,    30,    53,    51,    32,    51,
-      17,    17,    17,     3,    18,    16,    16,    16,    16,    51,
-      16,    18,    43,    16,    18,    33,     6,    16,    51,    51,
-      17,    51,    51,    17,    29,    51,    17,     3,    17,    17,
-      17,    17,    17,    17,     3,    18,    17,    17,     3,     3,
-      17,     3,    17,    17,    17,    17,    28,     3,   185,    51,
-      51,    49,   240,   139,   169,    51,    51,    28,    51,    51,
-     216,    -1,    -1,    -1,   181,    -1,    -1,    -1,    -1,    -1,
-      -1,    -1,    51,    51
+     101,   102,   103,   140,   146,   139,    12,    17,    16,    51,
+      17,    51,   149,    17,    54,     7,     3,   118,    28,   120,
+     121,    28,   123,   124,    28,   126,   127,     0,   129,    29,
+      31,     4,     5,    17,    51,    51,     9,    10,    11,    12,
+      13,    14,    15,    51,    28,    51,    19,    20,    21,    28,
+      18,    37,     3,    26,    27,   192,   193,     6,     3,     8,
+      28,    34,   196,    36,    43,    44,    45,    46,    47,    48,
+      39,    40,    41,    42,    22,    23,    24,    25,    51,   180,
+     181,    17,    51,   225,    17,    54,   223,    39,    40,    41,
+      42,    18,    28,    49,    50,    28,    17,    53,     3,    51,
+      56,    28,   203,   204,   205,   206,   207,    28,   209,   210,
+      51,   212,   213,    17,   215,   216,     3,   218,    49,    50,
+      51,   258,    53,    51,    28,    56,    49,    50,    51,    51,
+      53,     3,    54,    56,    49,    50,    51,    51,    53,    51,
+      54,    56,    49,    50,    51,    51,    53,    16,    54,    56,
+      43,    44,    45,    46,    47,    48,    51,    51,    16,    54,
+      54,    51,    51,    51,    54,    54,    54,   268,   269,   270,
+     271,    51,    51,     6,    54,     8,    51,    16,    16,    31,
+       3,     3,    43,    51,    51,    34,    16,    38,    53,    35,
+       3,     3,    51,    30,    51,     3,    32,    53,    51,    17,
+      17,    51,    17,    17,     3,    16,    16,    16,    43,    16,
+       3,    51,    18,    18,    16,    18,    16,    51,     6,    51,
+      51,    17,    51,    51,    16,    29,    17,    17,    17,     3,
+      17,    17,    33,    17,    17,    17,     3,    18,    18,     3,
+       3,    17,     3,     3,    17,    17,   266,    17,    17,    17,
+     263,    17,   281,    51,    51,    49,    51,    28,   238,   294,
+     296,   198,    18,    17,   182,   256,    51,   152,    43,    28,
+     230,    -1,    51,    51,    51,   194,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    51,    -1,    -1,    51,
+      -1,    -1,    -1,    51,    51
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
        0,    58,     0,     4,     5,     9,    10,    11,    12,    13,
-      14,    15,    19,    20,    21,    26,    27,    36,    59,    60,
-      61,    62,    63,    64,    65,    66,    67,    68,    69,    70,
-      71,    77,    80,    81,    82,    90,     6,     8,     6,     8,
-      39,    40,    41,    42,    51,    54,    83,    51,     7,     3,
-      29,    31,    51,     3,     3,     3,     3,     3,    37,    51,
-      51,    51,    51,    16,    16,    16,    16,    18,    28,    84,
-      31,     3,     3,    51,    51,    34,    38,    16,    35,     3,
-       3,    51,    54,    51,    54,    51,    54,    51,    54,    39,
-      40,    41,    42,    51,    51,    54,    51,    30,    32,    86,
-      51,    53,    51,    73,    76,    51,    17,    28,    17,    17,
-      28,    17,    17,    28,    17,    17,    28,    17,    16,    16,
-      16,    16,    28,    84,    84,    84,    18,    85,    16,    49,
-      50,    51,    53,    56,    79,    88,     3,    43,    29,    18,
-      72,    22,    23,    24,    25,    75,    16,    84,    51,    84,
-      84,    51,    84,    84,    51,    84,    84,    51,    84,    51,
-      54,    51,    54,    51,    54,    51,    54,    51,    54,    51,
-      86,    79,    28,    43,    44,    45,    46,    47,    48,    89,
-      89,    33,    87,    79,     6,    73,    17,    16,    51,    17,
-      17,    17,    17,    17,    28,    17,    17,    28,    17,    17,
-      28,    17,    17,    28,    17,    84,    84,    85,     3,    18,
-      78,    51,    51,    79,    51,    79,    88,    86,    51,    72,
-       3,    49,    74,    17,    84,    84,    84,    84,    84,    51,
-      84,    84,    51,    84,    84,    51,    84,    84,    51,    84,
-      79,    17,    89,    28,    87,     3,     3,    17,     3,    17,
-      17,    17,    17,    78,     3,    51,    79,    51,    84,    84,
-      84,    84,    28,    51
+      14,    15,    19,    20,    21,    26,    27,    34,    36,    51,
+      59,    60,    61,    62,    63,    64,    65,    66,    67,    69,
+      70,    71,    72,    79,    80,    87,    90,    91,    92,   100,
+       6,     8,     6,     8,    39,    40,    41,    42,    51,    54,
+      93,    51,     7,     3,    29,    31,    51,     3,     3,     3,
+       3,     3,    51,    37,    51,    51,    51,    51,    51,    16,
+      16,    16,    16,    18,    28,    94,    31,     3,     3,    51,
+      51,    34,    43,    38,    53,    16,    35,     3,     3,    51,
+      54,    51,    54,    51,    54,    51,    54,    39,    40,    41,
+      42,    51,    51,    54,    51,    30,    32,    96,    51,    12,
+      51,    68,    53,     3,    51,    83,    86,    51,    17,    28,
+      17,    17,    28,    17,    17,    28,    17,    17,    28,    17,
+      16,    16,    16,    16,    28,    94,    94,    94,    18,    95,
+      16,    49,    50,    51,    53,    56,    89,    98,     3,    43,
+       3,    29,    18,    82,    22,    23,    24,    25,    85,    16,
+      94,    51,    94,    94,    51,    94,    94,    51,    94,    94,
+      51,    94,    51,    54,    51,    54,    51,    54,    51,    54,
+      51,    54,    51,    96,    89,    28,    43,    44,    45,    46,
+      47,    48,    99,    99,    33,    97,    89,     6,    83,    17,
+      16,    51,    73,    17,    17,    17,    17,    17,    28,    17,
+      17,    28,    17,    17,    28,    17,    17,    28,    17,    94,
+      94,    95,     3,    18,    88,    51,    51,    89,    51,    89,
+      98,    96,    51,    82,    51,    81,    49,    84,    18,    74,
+      94,    94,    94,    94,    94,    51,    94,    94,    51,    94,
+      94,    51,    94,    94,    51,    94,    89,    17,    99,    28,
+      97,     3,     3,    43,     3,    17,    73,    17,    17,    17,
+      17,    17,    88,     3,    51,    89,    51,    68,    74,    51,
+      75,    76,    94,    94,    94,    94,    28,    16,    51,     3,
+      75,    51,    51,    77,    18,    78,    77,    17,    78
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
        0,    57,    58,    58,    59,    59,    59,    59,    59,    59,
       59,    59,    59,    59,    59,    59,    59,    59,    59,    59,
-      59,    60,    61,    62,    63,    64,    65,    66,    67,    68,
-      69,    70,    71,    72,    72,    73,    73,    74,    75,    75,
-      75,    75,    76,    77,    78,    78,    79,    79,    79,    79,
-      80,    81,    82,    83,    83,    83,    83,    83,    83,    83,
-      83,    83,    83,    83,    83,    83,    83,    83,    83,    84,
-      84,    84,    84,    84,    84,    84,    84,    84,    84,    84,
-      84,    84,    84,    84,    84,    85,    85,    86,    86,    87,
-      87,    88,    88,    88,    88,    88,    88,    88,    89,    89,
-      89,    89,    89,    89,    90
+      59,    59,    59,    60,    61,    62,    63,    64,    65,    66,
+      67,    68,    68,    69,    70,    71,    72,    73,    74,    74,
+      75,    75,    76,    76,    77,    78,    78,    79,    80,    81,
+      81,    82,    82,    83,    83,    84,    85,    85,    85,    85,
+      86,    87,    88,    88,    89,    89,    89,    89,    90,    91,
+      92,    93,    93,    93,    93,    93,    93,    93,    93,    93,
+      93,    93,    93,    93,    93,    93,    93,    94,    94,    94,
+      94,    94,    94,    94,    94,    94,    94,    94,    94,    94,
+      94,    94,    94,    95,    95,    96,    96,    97,    97,    98,
+      98,    98,    98,    98,    98,    98,    99,    99,    99,    99,
+      99,    99,   100
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     0,     2,     1,     1,     1,     1,     1,     1,
        1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
-       1,     2,     2,     2,     2,     2,     2,     4,     3,     3,
-       9,     4,     8,     0,     3,     5,     2,     1,     1,     1,
-       1,     1,     1,     9,     0,     3,     1,     1,     1,     1,
-       5,     8,     7,     1,     2,     4,     4,     5,     5,     7,
-       5,     5,     7,     5,     5,     7,     5,     5,     7,     0,
-       3,     5,     5,     6,     6,     8,     6,     6,     8,     6,
-       6,     8,     6,     6,     8,     0,     3,     0,     3,     0,
-       3,     3,     3,     3,     3,     5,     5,     7,     1,     1,
-       1,     1,     1,     1,     8
+       1,     1,     1,     2,     2,     2,     2,     2,     2,     5,
+       4,     1,     1,     4,     3,     3,    11,     1,     0,     3,
+       0,     2,     5,     2,     1,     0,     3,     4,     9,     0,
+       3,     0,     3,     5,     2,     1,     1,     1,     1,     1,
+       1,     9,     0,     3,     1,     1,     1,     1,     5,     8,
+       7,     1,     2,     4,     4,     5,     5,     7,     5,     5,
+       7,     5,     5,     7,     5,     5,     7,     0,     3,     5,
+       5,     6,     6,     8,     6,     6,     8,     6,     6,     8,
+       6,     6,     8,     0,     3,     0,     3,     0,     3,     3,
+       3,     3,     3,     5,     5,     7,     1,     1,     1,     1,
+       1,     1,     8
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
@@ -984,10 +975,9 @@ static const yytype_int8 yyr2[] =
       }                                                           \
   while (0)
 
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -1004,19 +994,16 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, scanner); \
+                  Kind, Value, scanner); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -1027,19 +1014,16 @@ do {                                                                      \
 `-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, void *scanner)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, void *scanner)
 {
   FILE *yyoutput = yyo;
-  YYUSE (yyoutput);
-  YYUSE (scanner);
+  YY_USE (yyoutput);
+  YY_USE (scanner);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyo, yytoknum[yytype], *yyvaluep);
-# endif
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
@@ -1049,12 +1033,13 @@ yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, vo
 `---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, void *scanner)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, void *scanner)
 {
   YYFPRINTF (yyo, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yytype, yyvaluep, scanner);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner);
   YYFPRINTF (yyo, ")");
 }
 
@@ -1087,7 +1072,8 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule, void *scanner)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, void *scanner)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -1099,9 +1085,8 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule, void *scanner)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[+yyssp[yyi + 1 - yynrhs]],
-                       &yyvsp[(yyi + 1) - (yynrhs)]
-                                              , scanner);
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -1116,8 +1101,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -1140,259 +1125,34 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
 
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
-#  else
-/* Return the length of YYSTR.  */
-static YYPTRDIFF_T
-yystrlen (const char *yystr)
-{
-  YYPTRDIFF_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
 
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
 
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
-
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYPTRDIFF_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYPTRDIFF_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            else
-              goto append;
-
-          append:
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
-
-  if (yyres)
-    return yystpcpy (yyres, yystr) - yyres;
-  else
-    return yystrlen (yystr);
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
-                yy_state_t *yyssp, int yytoken)
-{
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat: reported tokens (one for the "unexpected",
-     one per "expected"). */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Actual size of YYARG. */
-  int yycount = 0;
-  /* Cumulated lengths of YYARG.  */
-  YYPTRDIFF_T yysize = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[+*yyssp];
-      YYPTRDIFF_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-      yysize = yysize0;
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYPTRDIFF_T yysize1
-                    = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-                    yysize = yysize1;
-                  else
-                    return 2;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-    default: /* Avoid compiler warnings. */
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
-
-  {
-    /* Don't count the "%s"s in the final size, but reserve room for
-       the terminator.  */
-    YYPTRDIFF_T yysize1 = yysize + (yystrlen (yyformat) - 2 * yycount) + 1;
-    if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-      yysize = yysize1;
-    else
-      return 2;
-  }
-
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
-
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          ++yyp;
-          ++yyformat;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, void *scanner)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, void *scanner)
 {
-  YYUSE (yyvaluep);
-  YYUSE (scanner);
+  YY_USE (yyvaluep);
+  YY_USE (scanner);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1400,7 +1160,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, void *scanner)
 int
 yyparse (void *scanner)
 {
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 
@@ -1411,45 +1171,38 @@ YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
 YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
 
     /* Number of syntax errors so far.  */
-    int yynerrs;
+    int yynerrs = 0;
 
-    yy_state_fast_t yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+    int yyerrstatus = 0;
 
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
-
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
     yy_state_t yyssa[YYINITDEPTH];
-    yy_state_t *yyss;
-    yy_state_t *yyssp;
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    /* The semantic value stack.  */
+    /* The semantic value stack: array, bottom, top.  */
     YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
-
-    YYPTRDIFF_T yystacksize;
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1457,16 +1210,10 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
 
@@ -1488,10 +1235,11 @@ yysetstate:
   YY_IGNORE_USELESS_CAST_BEGIN
   *yyssp = YY_CAST (yy_state_t, yystate);
   YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
 #if !defined yyoverflow && !defined YYSTACK_RELOCATE
-    goto yyexhaustedlab;
+    YYNOMEM;
 #else
     {
       /* Get the current used size of the three stacks, in elements.  */
@@ -1519,7 +1267,7 @@ yysetstate:
 # else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
@@ -1530,10 +1278,10 @@ yysetstate:
           YY_CAST (union yyalloc *,
                    YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
-# undef YYSTACK_RELOCATE
+#  undef YYSTACK_RELOCATE
         if (yyss1 != yyssa)
           YYSTACK_FREE (yyss1);
       }
@@ -1552,6 +1300,7 @@ yysetstate:
     }
 #endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
+
   if (yystate == YYFINAL)
     YYACCEPT;
 
@@ -1572,18 +1321,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex (&yylval, scanner);
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1652,118 +1412,253 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-  case 21:
-#line 166 "yacc_sql.y"
+  case 23: /* exit: EXIT SEMICOLON  */
+#line 169 "yacc_sql.y"
                    {
         CONTEXT->ssql->flag=SCF_EXIT;//"exit";
     }
-#line 1661 "yacc_sql.tab.c"
+#line 1421 "yacc_sql.tab.c"
     break;
 
-  case 22:
-#line 171 "yacc_sql.y"
+  case 24: /* help: HELP SEMICOLON  */
+#line 174 "yacc_sql.y"
                    {
         CONTEXT->ssql->flag=SCF_HELP;//"help";
     }
-#line 1669 "yacc_sql.tab.c"
+#line 1429 "yacc_sql.tab.c"
     break;
 
-  case 23:
-#line 176 "yacc_sql.y"
+  case 25: /* sync: SYNC SEMICOLON  */
+#line 179 "yacc_sql.y"
                    {
       CONTEXT->ssql->flag = SCF_SYNC;
     }
-#line 1677 "yacc_sql.tab.c"
+#line 1437 "yacc_sql.tab.c"
     break;
 
-  case 24:
-#line 182 "yacc_sql.y"
+  case 26: /* begin: TRX_BEGIN SEMICOLON  */
+#line 185 "yacc_sql.y"
                         {
       CONTEXT->ssql->flag = SCF_BEGIN;
     }
-#line 1685 "yacc_sql.tab.c"
+#line 1445 "yacc_sql.tab.c"
     break;
 
-  case 25:
-#line 188 "yacc_sql.y"
+  case 27: /* commit: TRX_COMMIT SEMICOLON  */
+#line 191 "yacc_sql.y"
                          {
       CONTEXT->ssql->flag = SCF_COMMIT;
     }
-#line 1693 "yacc_sql.tab.c"
+#line 1453 "yacc_sql.tab.c"
     break;
 
-  case 26:
-#line 194 "yacc_sql.y"
+  case 28: /* rollback: TRX_ROLLBACK SEMICOLON  */
+#line 197 "yacc_sql.y"
                            {
       CONTEXT->ssql->flag = SCF_ROLLBACK;
     }
-#line 1701 "yacc_sql.tab.c"
+#line 1461 "yacc_sql.tab.c"
+    break;
+
+  case 29: /* set_variable: SET ID EQ option_value SEMICOLON  */
+#line 203 "yacc_sql.y"
+                                     {
+      CONTEXT->ssql->flag = SCF_SET_VARIABLE;
+      set_variable_init(&CONTEXT->ssql->sstr.set_variable, (yyvsp[-3].string), (yyvsp[-1].string));
+    }
+#line 1470 "yacc_sql.tab.c"
+    break;
+
+  case 30: /* backup: ID ID SSS SEMICOLON  */
+#line 210 "yacc_sql.y"
+                        {
+      // BACKUP TO 'dir'，词法里没有BACKUP和TO关键字，按标识符解析
+      if (strcasecmp((yyvsp[-3].string), "backup") != 0 || strcasecmp((yyvsp[-2].string), "to") != 0) {
+        yyerror(scanner, "syntax error");
+        YYABORT;
+      }
+      CONTEXT->ssql->flag = SCF_BACKUP;
+      backup_init(&CONTEXT->ssql->sstr.backup, (yyvsp[-1].string));
+    }
+#line 1484 "yacc_sql.tab.c"
     break;
 
-  case 27:
-#line 200 "yacc_sql.y"
+  case 31: /* option_value: ID  */
+#line 222 "yacc_sql.y"
+       { (yyval.string) = (yyvsp[0].string); }
+#line 1490 "yacc_sql.tab.c"
+    break;
+
+  case 32: /* option_value: SYNC  */
+#line 223 "yacc_sql.y"
+           { (yyval.string) = "sync"; }
+#line 1496 "yacc_sql.tab.c"
+    break;
+
+  case 33: /* drop_table: DROP TABLE ID SEMICOLON  */
+#line 227 "yacc_sql.y"
                             {
         CONTEXT->ssql->flag = SCF_DROP_TABLE;//"drop_table";
         drop_table_init(&CONTEXT->ssql->sstr.drop_table, (yyvsp[-1].string));
     }
-#line 1710 "yacc_sql.tab.c"
+#line 1505 "yacc_sql.tab.c"
     break;
 
-  case 28:
-#line 206 "yacc_sql.y"
+  case 34: /* show_tables: SHOW TABLES SEMICOLON  */
+#line 233 "yacc_sql.y"
                           {
       CONTEXT->ssql->flag = SCF_SHOW_TABLES;
     }
-#line 1718 "yacc_sql.tab.c"
+#line 1513 "yacc_sql.tab.c"
     break;
 
-  case 29:
-#line 212 "yacc_sql.y"
+  case 35: /* desc_table: DESC ID SEMICOLON  */
+#line 239 "yacc_sql.y"
                       {
       CONTEXT->ssql->flag = SCF_DESC_TABLE;
       desc_table_init(&CONTEXT->ssql->sstr.desc_table, (yyvsp[-1].string));
     }
-#line 1727 "yacc_sql.tab.c"
+#line 1522 "yacc_sql.tab.c"
     break;
 
-  case 30:
-#line 220 "yacc_sql.y"
+  case 36: /* create_index: CREATE INDEX ID ON ID LBRACE index_attr index_attr_list RBRACE index_options SEMICOLON  */
+#line 247 "yacc_sql.y"
                 {
 			CONTEXT->ssql->flag = SCF_CREATE_INDEX;//"create_index";
-			create_index_init(&CONTEXT->ssql->sstr.create_index, (yyvsp[-6].string), (yyvsp[-4].string), (yyvsp[-2].string));
+			create_index_init(&CONTEXT->ssql->sstr.create_index, (yyvsp[-8].string), (yyvsp[-6].string));
+		}
+#line 1531 "yacc_sql.tab.c"
+    break;
+
+  case 37: /* index_attr: ID  */
+#line 253 "yacc_sql.y"
+       {
+			if (create_index_append_attribute(&CONTEXT->ssql->sstr.create_index, (yyvsp[0].string)) != 0) {
+				yyerror(scanner, "too many index columns");
+				YYABORT;
+			}
+		}
+#line 1542 "yacc_sql.tab.c"
+    break;
+
+  case 39: /* index_attr_list: COMMA index_attr index_attr_list  */
+#line 262 "yacc_sql.y"
+                                       {
+		}
+#line 1549 "yacc_sql.tab.c"
+    break;
+
+  case 41: /* index_options: index_option index_options  */
+#line 267 "yacc_sql.y"
+                                 {
+		}
+#line 1556 "yacc_sql.tab.c"
+    break;
+
+  case 42: /* index_option: ID LBRACE include_attr include_attr_list RBRACE  */
+#line 271 "yacc_sql.y"
+                                                    {
+			// 词法里没有INCLUDE关键字，按标识符解析
+			if (strcasecmp((yyvsp[-4].string), "include") != 0) {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			}
+		}
+#line 1568 "yacc_sql.tab.c"
+    break;
+
+  case 43: /* index_option: ID ID  */
+#line 278 "yacc_sql.y"
+            {
+			// USING HASH / USING BTREE / USING LSM / WITH BLOOM / WITH ADAPTIVE_HASH
+			if (strcasecmp((yyvsp[-1].string), "with") == 0) {
+				if (strcasecmp((yyvsp[0].string), "bloom") == 0) {
+					create_index_add_option(&CONTEXT->ssql->sstr.create_index, INDEX_OPTION_BLOOM_FILTER);
+				} else if (strcasecmp((yyvsp[0].string), "adaptive_hash") == 0) {
+					create_index_add_option(&CONTEXT->ssql->sstr.create_index, INDEX_OPTION_ADAPTIVE_HASH);
+				} else {
+					yyerror(scanner, "syntax error");
+					YYABORT;
+				}
+			} else if (strcasecmp((yyvsp[-1].string), "using") != 0) {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			} else if (strcasecmp((yyvsp[0].string), "hash") == 0) {
+				create_index_set_type(&CONTEXT->ssql->sstr.create_index, INDEX_HASH);
+			} else if (strcasecmp((yyvsp[0].string), "btree") == 0) {
+				create_index_set_type(&CONTEXT->ssql->sstr.create_index, INDEX_BPLUS_TREE);
+			} else if (strcasecmp((yyvsp[0].string), "lsm") == 0) {
+				create_index_set_type(&CONTEXT->ssql->sstr.create_index, INDEX_LSM);
+			} else {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			}
+		}
+#line 1598 "yacc_sql.tab.c"
+    break;
+
+  case 44: /* include_attr: ID  */
+#line 305 "yacc_sql.y"
+       {
+			if (create_index_append_include(&CONTEXT->ssql->sstr.create_index, (yyvsp[0].string)) != 0) {
+				yyerror(scanner, "too many index columns");
+				YYABORT;
+			}
+		}
+#line 1609 "yacc_sql.tab.c"
+    break;
+
+  case 46: /* include_attr_list: COMMA include_attr include_attr_list  */
+#line 314 "yacc_sql.y"
+                                           {
 		}
-#line 1736 "yacc_sql.tab.c"
+#line 1616 "yacc_sql.tab.c"
     break;
 
-  case 31:
-#line 228 "yacc_sql.y"
+  case 47: /* drop_index: DROP INDEX ID SEMICOLON  */
+#line 320 "yacc_sql.y"
                 {
 			CONTEXT->ssql->flag=SCF_DROP_INDEX;//"drop_index";
 			drop_index_init(&CONTEXT->ssql->sstr.drop_index, (yyvsp[-1].string));
 		}
-#line 1745 "yacc_sql.tab.c"
+#line 1625 "yacc_sql.tab.c"
     break;
 
-  case 32:
-#line 235 "yacc_sql.y"
+  case 48: /* create_table: CREATE TABLE ID LBRACE attr_def attr_def_list RBRACE table_options SEMICOLON  */
+#line 327 "yacc_sql.y"
                 {
 			CONTEXT->ssql->flag=SCF_CREATE_TABLE;//"create_table";
 			// CONTEXT->ssql->sstr.create_table.attribute_count = CONTEXT->value_length;
-			create_table_init_name(&CONTEXT->ssql->sstr.create_table, (yyvsp[-5].string));
+			create_table_init_name(&CONTEXT->ssql->sstr.create_table, (yyvsp[-6].string));
 			//临时变量清零	
 			CONTEXT->value_length = 0;
 		}
-#line 1757 "yacc_sql.tab.c"
+#line 1637 "yacc_sql.tab.c"
     break;
 
-  case 34:
-#line 245 "yacc_sql.y"
+  case 50: /* table_options: ID EQ option_value  */
+#line 337 "yacc_sql.y"
+                         {
+			// DURABILITY = SYNC | ASYNC | NOLOG，词法里没有DURABILITY关键字，按标识符解析
+			Durability durability;
+			if (strcasecmp((yyvsp[-2].string), "durability") != 0 || parse_durability((yyvsp[0].string), &durability) != 0
+			    || durability == DURABILITY_DEFAULT) {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			}
+			create_table_set_durability(&CONTEXT->ssql->sstr.create_table, durability);
+		}
+#line 1652 "yacc_sql.tab.c"
+    break;
+
+  case 52: /* attr_def_list: COMMA attr_def attr_def_list  */
+#line 350 "yacc_sql.y"
                                    {    }
-#line 1763 "yacc_sql.tab.c"
+#line 1658 "yacc_sql.tab.c"
     break;
 
-  case 35:
-#line 250 "yacc_sql.y"
+  case 53: /* attr_def: ID_get type LBRACE number RBRACE  */
+#line 355 "yacc_sql.y"
                 {
 			AttrInfo attribute;
 			attr_info_init(&attribute, CONTEXT->id, (yyvsp[-3].number), (yyvsp[-1].number));
@@ -1774,11 +1669,11 @@ yyreduce:
 			// CONTEXT->ssql->sstr.create_table.attributes[CONTEXT->value_length].length = $4;
 			CONTEXT->value_length++;
 		}
-#line 1778 "yacc_sql.tab.c"
+#line 1673 "yacc_sql.tab.c"
     break;
 
-  case 36:
-#line 261 "yacc_sql.y"
+  case 54: /* attr_def: ID_get type  */
+#line 366 "yacc_sql.y"
                 {
 			AttrInfo attribute;
 			attr_info_init(&attribute, CONTEXT->id, (yyvsp[0].number), 4);
@@ -1789,50 +1684,50 @@ yyreduce:
 			// CONTEXT->ssql->sstr.create_table.attributes[CONTEXT->value_length].length=4; // default attribute length 属性类型空间大小
 			CONTEXT->value_length++;
 		}
-#line 1793 "yacc_sql.tab.c"
+#line 1688 "yacc_sql.tab.c"
     break;
 
-  case 37:
-#line 273 "yacc_sql.y"
+  case 55: /* number: NUMBER  */
+#line 378 "yacc_sql.y"
                        {(yyval.number) = (yyvsp[0].number);}
-#line 1799 "yacc_sql.tab.c"
+#line 1694 "yacc_sql.tab.c"
     break;
 
-  case 38:
-#line 276 "yacc_sql.y"
+  case 56: /* type: INT_T  */
+#line 381 "yacc_sql.y"
               { (yyval.number)=INTS; }
-#line 1805 "yacc_sql.tab.c"
+#line 1700 "yacc_sql.tab.c"
     break;
 
-  case 39:
-#line 277 "yacc_sql.y"
+  case 57: /* type: STRING_T  */
+#line 382 "yacc_sql.y"
                   { (yyval.number)=CHARS; }
-#line 1811 "yacc_sql.tab.c"
+#line 1706 "yacc_sql.tab.c"
     break;
 
-  case 40:
-#line 278 "yacc_sql.y"
+  case 58: /* type: FLOAT_T  */
+#line 383 "yacc_sql.y"
                  { (yyval.number)=FLOATS; }
-#line 1817 "yacc_sql.tab.c"
+#line 1712 "yacc_sql.tab.c"
     break;
 
-  case 41:
-#line 279 "yacc_sql.y"
+  case 59: /* type: DATE_T  */
+#line 384 "yacc_sql.y"
                 { (yyval.number)=DATES; }
-#line 1823 "yacc_sql.tab.c"
+#line 1718 "yacc_sql.tab.c"
     break;
 
-  case 42:
-#line 283 "yacc_sql.y"
+  case 60: /* ID_get: ID  */
+#line 388 "yacc_sql.y"
         {
 		char *temp=(yyvsp[0].string); 
 		snprintf(CONTEXT->id, sizeof(CONTEXT->id), "%s", temp);
 	}
-#line 1832 "yacc_sql.tab.c"
+#line 1727 "yacc_sql.tab.c"
     break;
 
-  case 43:
-#line 292 "yacc_sql.y"
+  case 61: /* insert: INSERT INTO ID VALUES LBRACE value value_list RBRACE SEMICOLON  */
+#line 397 "yacc_sql.y"
                 {
 			// CONTEXT->values[CONTEXT->value_length++] = *$6;
 
@@ -1847,52 +1742,52 @@ yyreduce:
       //临时变量清零
       CONTEXT->value_length=0;
     }
-#line 1851 "yacc_sql.tab.c"
+#line 1746 "yacc_sql.tab.c"
     break;
 
-  case 45:
-#line 309 "yacc_sql.y"
+  case 63: /* value_list: COMMA value value_list  */
+#line 414 "yacc_sql.y"
                               { 
   		// CONTEXT->values[CONTEXT->value_length++] = *$2;
 	  }
-#line 1859 "yacc_sql.tab.c"
+#line 1754 "yacc_sql.tab.c"
     break;
 
-  case 46:
-#line 314 "yacc_sql.y"
+  case 64: /* value: NUMBER  */
+#line 419 "yacc_sql.y"
           {	
   		value_init_integer(&CONTEXT->values[CONTEXT->value_length++], (yyvsp[0].number));
 		}
-#line 1867 "yacc_sql.tab.c"
+#line 1762 "yacc_sql.tab.c"
     break;
 
-  case 47:
-#line 317 "yacc_sql.y"
+  case 65: /* value: FLOAT  */
+#line 422 "yacc_sql.y"
           {
   		value_init_float(&CONTEXT->values[CONTEXT->value_length++], (yyvsp[0].floats));
 		}
-#line 1875 "yacc_sql.tab.c"
+#line 1770 "yacc_sql.tab.c"
     break;
 
-  case 48:
-#line 320 "yacc_sql.y"
+  case 66: /* value: SSS  */
+#line 425 "yacc_sql.y"
          {
 		(yyvsp[0].string) = substr((yyvsp[0].string),1,strlen((yyvsp[0].string))-2);
   		value_init_string(&CONTEXT->values[CONTEXT->value_length++], (yyvsp[0].string));
 		}
-#line 1884 "yacc_sql.tab.c"
+#line 1779 "yacc_sql.tab.c"
     break;
 
-  case 49:
-#line 324 "yacc_sql.y"
+  case 67: /* value: DATE  */
+#line 429 "yacc_sql.y"
           {
     		value_init_date(&CONTEXT->values[CONTEXT->value_length++], (yyvsp[0].date));
     		}
-#line 1892 "yacc_sql.tab.c"
+#line 1787 "yacc_sql.tab.c"
     break;
 
-  case 50:
-#line 331 "yacc_sql.y"
+  case 68: /* delete: DELETE FROM ID where SEMICOLON  */
+#line 436 "yacc_sql.y"
                 {
 			CONTEXT->ssql->flag = SCF_DELETE;//"delete";
 			deletes_init_relation(&CONTEXT->ssql->sstr.deletion, (yyvsp[-2].string));
@@ -1900,11 +1795,11 @@ yyreduce:
 					CONTEXT->conditions, CONTEXT->condition_length);
 			CONTEXT->condition_length = 0;	
     }
-#line 1904 "yacc_sql.tab.c"
+#line 1799 "yacc_sql.tab.c"
     break;
 
-  case 51:
-#line 341 "yacc_sql.y"
+  case 69: /* update: UPDATE ID SET ID EQ value where SEMICOLON  */
+#line 446 "yacc_sql.y"
                 {
 			CONTEXT->ssql->flag = SCF_UPDATE;//"update";
 			Value *value = &CONTEXT->values[0];
@@ -1912,11 +1807,11 @@ yyreduce:
 					CONTEXT->conditions, CONTEXT->condition_length);
 			CONTEXT->condition_length = 0;
 		}
-#line 1916 "yacc_sql.tab.c"
+#line 1811 "yacc_sql.tab.c"
     break;
 
-  case 52:
-#line 351 "yacc_sql.y"
+  case 70: /* select: SELECT select_attr FROM ID rel_list where SEMICOLON  */
+#line 456 "yacc_sql.y"
                 {
 			// CONTEXT->ssql->sstr.selection.relations[CONTEXT->from_length++]=$4;
 			selects_append_relation(&CONTEXT->ssql->sstr.selection, (yyvsp[-3].string));
@@ -1932,369 +1827,369 @@ yyreduce:
 			CONTEXT->select_length=0;
 			CONTEXT->value_length = 0;
 	}
-#line 1936 "yacc_sql.tab.c"
+#line 1831 "yacc_sql.tab.c"
     break;
 
-  case 53:
-#line 369 "yacc_sql.y"
+  case 71: /* select_attr: STAR  */
+#line 474 "yacc_sql.y"
          {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
     }
-#line 1946 "yacc_sql.tab.c"
+#line 1841 "yacc_sql.tab.c"
     break;
 
-  case 54:
-#line 374 "yacc_sql.y"
+  case 72: /* select_attr: ID attr_list  */
+#line 479 "yacc_sql.y"
                    {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-1].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
 		}
-#line 1956 "yacc_sql.tab.c"
+#line 1851 "yacc_sql.tab.c"
     break;
 
-  case 55:
-#line 379 "yacc_sql.y"
+  case 73: /* select_attr: ID DOT STAR attr_list  */
+#line 484 "yacc_sql.y"
                            {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-3].string), "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
           	}
-#line 1966 "yacc_sql.tab.c"
+#line 1861 "yacc_sql.tab.c"
     break;
 
-  case 56:
-#line 384 "yacc_sql.y"
+  case 74: /* select_attr: ID DOT ID attr_list  */
+#line 489 "yacc_sql.y"
                           {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-3].string), (yyvsp[-1].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
 		}
-#line 1976 "yacc_sql.tab.c"
+#line 1871 "yacc_sql.tab.c"
     break;
 
-  case 57:
-#line 390 "yacc_sql.y"
+  case 75: /* select_attr: _MAX LBRACE STAR RBRACE attr_list  */
+#line 495 "yacc_sql.y"
                                             {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 1987 "yacc_sql.tab.c"
+#line 1882 "yacc_sql.tab.c"
     break;
 
-  case 58:
-#line 396 "yacc_sql.y"
+  case 76: /* select_attr: _MAX LBRACE ID RBRACE attr_list  */
+#line 501 "yacc_sql.y"
                                           {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 1998 "yacc_sql.tab.c"
+#line 1893 "yacc_sql.tab.c"
     break;
 
-  case 59:
-#line 402 "yacc_sql.y"
+  case 77: /* select_attr: _MAX LBRACE ID DOT ID RBRACE attr_list  */
+#line 507 "yacc_sql.y"
                                                  {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2009 "yacc_sql.tab.c"
+#line 1904 "yacc_sql.tab.c"
     break;
 
-  case 60:
-#line 408 "yacc_sql.y"
+  case 78: /* select_attr: _COUNT LBRACE STAR RBRACE attr_list  */
+#line 513 "yacc_sql.y"
                                               {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2020 "yacc_sql.tab.c"
+#line 1915 "yacc_sql.tab.c"
     break;
 
-  case 61:
-#line 414 "yacc_sql.y"
+  case 79: /* select_attr: _COUNT LBRACE ID RBRACE attr_list  */
+#line 519 "yacc_sql.y"
                                             {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2031 "yacc_sql.tab.c"
+#line 1926 "yacc_sql.tab.c"
     break;
 
-  case 62:
-#line 420 "yacc_sql.y"
+  case 80: /* select_attr: _COUNT LBRACE ID DOT ID RBRACE attr_list  */
+#line 525 "yacc_sql.y"
                                                    {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2042 "yacc_sql.tab.c"
+#line 1937 "yacc_sql.tab.c"
     break;
 
-  case 63:
-#line 426 "yacc_sql.y"
+  case 81: /* select_attr: _MIN LBRACE STAR RBRACE attr_list  */
+#line 531 "yacc_sql.y"
                                             {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2053 "yacc_sql.tab.c"
+#line 1948 "yacc_sql.tab.c"
     break;
 
-  case 64:
-#line 432 "yacc_sql.y"
+  case 82: /* select_attr: _MIN LBRACE ID RBRACE attr_list  */
+#line 537 "yacc_sql.y"
                                           {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2064 "yacc_sql.tab.c"
+#line 1959 "yacc_sql.tab.c"
     break;
 
-  case 65:
-#line 438 "yacc_sql.y"
+  case 83: /* select_attr: _MIN LBRACE ID DOT ID RBRACE attr_list  */
+#line 543 "yacc_sql.y"
                                                  {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2075 "yacc_sql.tab.c"
+#line 1970 "yacc_sql.tab.c"
     break;
 
-  case 66:
-#line 444 "yacc_sql.y"
+  case 84: /* select_attr: _AVG LBRACE STAR RBRACE attr_list  */
+#line 549 "yacc_sql.y"
                                             {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2086 "yacc_sql.tab.c"
+#line 1981 "yacc_sql.tab.c"
     break;
 
-  case 67:
-#line 450 "yacc_sql.y"
+  case 85: /* select_attr: _AVG LBRACE ID RBRACE attr_list  */
+#line 555 "yacc_sql.y"
                                           {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2097 "yacc_sql.tab.c"
+#line 1992 "yacc_sql.tab.c"
     break;
 
-  case 68:
-#line 456 "yacc_sql.y"
+  case 86: /* select_attr: _AVG LBRACE ID DOT ID RBRACE attr_list  */
+#line 561 "yacc_sql.y"
                                                  {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2108 "yacc_sql.tab.c"
+#line 2003 "yacc_sql.tab.c"
     break;
 
-  case 70:
-#line 465 "yacc_sql.y"
+  case 88: /* attr_list: COMMA ID attr_list  */
+#line 570 "yacc_sql.y"
                          {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-1].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
       }
-#line 2118 "yacc_sql.tab.c"
+#line 2013 "yacc_sql.tab.c"
     break;
 
-  case 71:
-#line 470 "yacc_sql.y"
+  case 89: /* attr_list: COMMA ID DOT STAR attr_list  */
+#line 575 "yacc_sql.y"
                                   {
   			RelAttr attr;
   			relation_attr_init(&attr, (yyvsp[-3].string), "*");
   			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
     }
-#line 2128 "yacc_sql.tab.c"
+#line 2023 "yacc_sql.tab.c"
     break;
 
-  case 72:
-#line 475 "yacc_sql.y"
+  case 90: /* attr_list: COMMA ID DOT ID attr_list  */
+#line 580 "yacc_sql.y"
                                 {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-3].string), (yyvsp[-1].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
   	  }
-#line 2138 "yacc_sql.tab.c"
+#line 2033 "yacc_sql.tab.c"
     break;
 
-  case 73:
-#line 481 "yacc_sql.y"
+  case 91: /* attr_list: COMMA _MAX LBRACE STAR RBRACE attr_list  */
+#line 586 "yacc_sql.y"
                                                   {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
-#line 2149 "yacc_sql.tab.c"
+#line 2044 "yacc_sql.tab.c"
     break;
 
-  case 74:
-#line 487 "yacc_sql.y"
+  case 92: /* attr_list: COMMA _MAX LBRACE ID RBRACE attr_list  */
+#line 592 "yacc_sql.y"
                                                 {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2160 "yacc_sql.tab.c"
+#line 2055 "yacc_sql.tab.c"
     break;
 
-  case 75:
-#line 493 "yacc_sql.y"
+  case 93: /* attr_list: COMMA _MAX LBRACE ID DOT ID RBRACE attr_list  */
+#line 598 "yacc_sql.y"
                                                        {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2171 "yacc_sql.tab.c"
+#line 2066 "yacc_sql.tab.c"
     break;
 
-  case 76:
-#line 499 "yacc_sql.y"
+  case 94: /* attr_list: COMMA _COUNT LBRACE STAR RBRACE attr_list  */
+#line 604 "yacc_sql.y"
                                                     {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2182 "yacc_sql.tab.c"
+#line 2077 "yacc_sql.tab.c"
     break;
 
-  case 77:
-#line 505 "yacc_sql.y"
+  case 95: /* attr_list: COMMA _COUNT LBRACE ID RBRACE attr_list  */
+#line 610 "yacc_sql.y"
                                                   {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2193 "yacc_sql.tab.c"
+#line 2088 "yacc_sql.tab.c"
     break;
 
-  case 78:
-#line 511 "yacc_sql.y"
+  case 96: /* attr_list: COMMA _COUNT LBRACE ID DOT ID RBRACE attr_list  */
+#line 616 "yacc_sql.y"
                                                          {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2204 "yacc_sql.tab.c"
+#line 2099 "yacc_sql.tab.c"
     break;
 
-  case 79:
-#line 517 "yacc_sql.y"
+  case 97: /* attr_list: COMMA _MIN LBRACE STAR RBRACE attr_list  */
+#line 622 "yacc_sql.y"
                                                   {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2215 "yacc_sql.tab.c"
+#line 2110 "yacc_sql.tab.c"
     break;
 
-  case 80:
-#line 523 "yacc_sql.y"
+  case 98: /* attr_list: COMMA _MIN LBRACE ID RBRACE attr_list  */
+#line 628 "yacc_sql.y"
                                                 {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2226 "yacc_sql.tab.c"
+#line 2121 "yacc_sql.tab.c"
     break;
 
-  case 81:
-#line 529 "yacc_sql.y"
+  case 99: /* attr_list: COMMA _MIN LBRACE ID DOT ID RBRACE attr_list  */
+#line 634 "yacc_sql.y"
                                                        {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2237 "yacc_sql.tab.c"
+#line 2132 "yacc_sql.tab.c"
     break;
 
-  case 82:
-#line 535 "yacc_sql.y"
+  case 100: /* attr_list: COMMA _AVG LBRACE STAR RBRACE attr_list  */
+#line 640 "yacc_sql.y"
                                                   {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2248 "yacc_sql.tab.c"
+#line 2143 "yacc_sql.tab.c"
     break;
 
-  case 83:
-#line 541 "yacc_sql.y"
+  case 101: /* attr_list: COMMA _AVG LBRACE ID RBRACE attr_list  */
+#line 646 "yacc_sql.y"
                                                 {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2259 "yacc_sql.tab.c"
+#line 2154 "yacc_sql.tab.c"
     break;
 
-  case 84:
-#line 547 "yacc_sql.y"
+  case 102: /* attr_list: COMMA _AVG LBRACE ID DOT ID RBRACE attr_list  */
+#line 652 "yacc_sql.y"
                                                        {
 			RelAttr attr;
 			relation_attr_init(&attr, (yyvsp[-4].string), (yyvsp[-2].string));
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
-#line 2270 "yacc_sql.tab.c"
+#line 2165 "yacc_sql.tab.c"
     break;
 
-  case 86:
-#line 557 "yacc_sql.y"
+  case 104: /* rel_list: COMMA ID rel_list  */
+#line 662 "yacc_sql.y"
                         {	
 				selects_append_relation(&CONTEXT->ssql->sstr.selection, (yyvsp[-1].string));
 		  }
-#line 2278 "yacc_sql.tab.c"
+#line 2173 "yacc_sql.tab.c"
     break;
 
-  case 88:
-#line 563 "yacc_sql.y"
+  case 106: /* where: WHERE condition condition_list  */
+#line 668 "yacc_sql.y"
                                      {	
 				// CONTEXT->conditions[CONTEXT->condition_length++]=*$2;
 			}
-#line 2286 "yacc_sql.tab.c"
+#line 2181 "yacc_sql.tab.c"
     break;
 
-  case 90:
-#line 569 "yacc_sql.y"
+  case 108: /* condition_list: AND condition condition_list  */
+#line 674 "yacc_sql.y"
                                    {
 				// CONTEXT->conditions[CONTEXT->condition_length++]=*$2;
 			}
-#line 2294 "yacc_sql.tab.c"
+#line 2189 "yacc_sql.tab.c"
     break;
 
-  case 91:
-#line 575 "yacc_sql.y"
+  case 109: /* condition: ID comOp value  */
+#line 680 "yacc_sql.y"
                 {
 			RelAttr left_attr;
 			relation_attr_init(&left_attr, NULL, (yyvsp[-2].string));
@@ -2315,11 +2210,11 @@ yyreduce:
 			// $$->right_value = *$3;
 
 		}
-#line 2319 "yacc_sql.tab.c"
+#line 2214 "yacc_sql.tab.c"
     break;
 
-  case 92:
-#line 596 "yacc_sql.y"
+  case 110: /* condition: value comOp value  */
+#line 701 "yacc_sql.y"
                 {
 			Value *left_value = &CONTEXT->values[CONTEXT->value_length - 2];
 			Value *right_value = &CONTEXT->values[CONTEXT->value_length - 1];
@@ -2339,11 +2234,11 @@ yyreduce:
 			// $$->right_value = *$3;
 
 		}
-#line 2343 "yacc_sql.tab.c"
+#line 2238 "yacc_sql.tab.c"
     break;
 
-  case 93:
-#line 616 "yacc_sql.y"
+  case 111: /* condition: ID comOp ID  */
+#line 721 "yacc_sql.y"
                 {
 			RelAttr left_attr;
 			relation_attr_init(&left_attr, NULL, (yyvsp[-2].string));
@@ -2363,11 +2258,11 @@ yyreduce:
 			// $$->right_attr.attribute_name=$3;
 
 		}
-#line 2367 "yacc_sql.tab.c"
+#line 2262 "yacc_sql.tab.c"
     break;
 
-  case 94:
-#line 636 "yacc_sql.y"
+  case 112: /* condition: value comOp ID  */
+#line 741 "yacc_sql.y"
                 {
 			Value *left_value = &CONTEXT->values[CONTEXT->value_length - 1];
 			RelAttr right_attr;
@@ -2389,11 +2284,11 @@ yyreduce:
 			// $$->right_attr.attribute_name=$3;
 		
 		}
-#line 2393 "yacc_sql.tab.c"
+#line 2288 "yacc_sql.tab.c"
     break;
 
-  case 95:
-#line 658 "yacc_sql.y"
+  case 113: /* condition: ID DOT ID comOp value  */
+#line 763 "yacc_sql.y"
                 {
 			RelAttr left_attr;
 			relation_attr_init(&left_attr, (yyvsp[-4].string), (yyvsp[-2].string));
@@ -2414,11 +2309,11 @@ yyreduce:
 			// $$->right_value =*$5;			
 							
     }
-#line 2418 "yacc_sql.tab.c"
+#line 2313 "yacc_sql.tab.c"
     break;
 
-  case 96:
-#line 679 "yacc_sql.y"
+  case 114: /* condition: value comOp ID DOT ID  */
+#line 784 "yacc_sql.y"
                 {
 			Value *left_value = &CONTEXT->values[CONTEXT->value_length - 1];
 
@@ -2439,11 +2334,11 @@ yyreduce:
 			// $$->right_attr.attribute_name = $5;
 									
     }
-#line 2443 "yacc_sql.tab.c"
+#line 2338 "yacc_sql.tab.c"
     break;
 
-  case 97:
-#line 700 "yacc_sql.y"
+  case 115: /* condition: ID DOT ID comOp ID DOT ID  */
+#line 805 "yacc_sql.y"
                 {
 			RelAttr left_attr;
 			relation_attr_init(&left_attr, (yyvsp[-6].string), (yyvsp[-4].string));
@@ -2462,56 +2357,56 @@ yyreduce:
 			// $$->right_attr.relation_name=$5;
 			// $$->right_attr.attribute_name=$7;
     }
-#line 2466 "yacc_sql.tab.c"
+#line 2361 "yacc_sql.tab.c"
     break;
 
-  case 98:
-#line 721 "yacc_sql.y"
+  case 116: /* comOp: EQ  */
+#line 826 "yacc_sql.y"
              { CONTEXT->comp = EQUAL_TO; }
-#line 2472 "yacc_sql.tab.c"
+#line 2367 "yacc_sql.tab.c"
     break;
 
-  case 99:
-#line 722 "yacc_sql.y"
+  case 117: /* comOp: LT  */
+#line 827 "yacc_sql.y"
          { CONTEXT->comp = LESS_THAN; }
-#line 2478 "yacc_sql.tab.c"
+#line 2373 "yacc_sql.tab.c"
     break;
 
-  case 100:
-#line 723 "yacc_sql.y"
+  case 118: /* comOp: GT  */
+#line 828 "yacc_sql.y"
          { CONTEXT->comp = GREAT_THAN; }
-#line 2484 "yacc_sql.tab.c"
+#line 2379 "yacc_sql.tab.c"
     break;
 
-  case 101:
-#line 724 "yacc_sql.y"
+  case 119: /* comOp: LE  */
+#line 829 "yacc_sql.y"
          { CONTEXT->comp = LESS_EQUAL; }
-#line 2490 "yacc_sql.tab.c"
+#line 2385 "yacc_sql.tab.c"
     break;
 
-  case 102:
-#line 725 "yacc_sql.y"
+  case 120: /* comOp: GE  */
+#line 830 "yacc_sql.y"
          { CONTEXT->comp = GREAT_EQUAL; }
-#line 2496 "yacc_sql.tab.c"
+#line 2391 "yacc_sql.tab.c"
     break;
 
-  case 103:
-#line 726 "yacc_sql.y"
+  case 121: /* comOp: NE  */
+#line 831 "yacc_sql.y"
          { CONTEXT->comp = NOT_EQUAL; }
-#line 2502 "yacc_sql.tab.c"
+#line 2397 "yacc_sql.tab.c"
     break;
 
-  case 104:
-#line 731 "yacc_sql.y"
+  case 122: /* load_data: LOAD DATA INFILE SSS INTO TABLE ID SEMICOLON  */
+#line 836 "yacc_sql.y"
                 {
 		  CONTEXT->ssql->flag = SCF_LOAD_DATA;
 			load_data_init(&CONTEXT->ssql->sstr.load_data, (yyvsp[-1].string), (yyvsp[-4].string));
 		}
-#line 2511 "yacc_sql.tab.c"
+#line 2406 "yacc_sql.tab.c"
     break;
 
 
-#line 2515 "yacc_sql.tab.c"
+#line 2410 "yacc_sql.tab.c"
 
       default: break;
     }
@@ -2526,11 +2421,10 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
@@ -2554,50 +2448,14 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (scanner, YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = YY_CAST (char *, YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (scanner, yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -2630,6 +2488,7 @@ yyerrorlab:
      label yyerrorlab therefore never appears in user code.  */
   if (0)
     YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -2646,13 +2505,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -2666,7 +2526,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, scanner);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -2678,7 +2538,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -2689,7 +2549,7 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
 /*-----------------------------------.
@@ -2697,24 +2557,22 @@ yyacceptlab:
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (scanner, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
 
-/*-----------------------------------------------------.
-| yyreturn -- parsing is finished, return the result.  |
-`-----------------------------------------------------*/
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -2730,20 +2588,18 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[+*yyssp], yyvsp, scanner);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
-#line 736 "yacc_sql.y"
+
+#line 841 "yacc_sql.y"
 
 //_____________________________________________________________________
 extern void scan_string(const char *str, yyscan_t scanner);
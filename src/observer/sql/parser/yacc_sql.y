@@ -133,6 +133,7 @@ ParserContext *get_context(yyscan_t scanner)
 %type <number> type;
 %type <condition1> condition;
 %type <value1> value;
+%type <string> option_value;
 %type <number> number;
 
 %%
@@ -160,6 +161,8 @@ command:
 	| load_data
 	| help
 	| exit
+	| set_variable
+	| backup
     ;
 
 exit:			
@@ -196,6 +199,30 @@ rollback:
     }
     ;
 
+set_variable:
+    SET ID EQ option_value SEMICOLON {
+      CONTEXT->ssql->flag = SCF_SET_VARIABLE;
+      set_variable_init(&CONTEXT->ssql->sstr.set_variable, $2, $4);
+    }
+    ;
+
+backup:
+    ID ID SSS SEMICOLON {
+      // BACKUP TO 'dir'，词法里没有BACKUP和TO关键字，按标识符解析
+      if (strcasecmp($1, "backup") != 0 || strcasecmp($2, "to") != 0) {
+        yyerror(scanner, "syntax error");
+        YYABORT;
+      }
+      CONTEXT->ssql->flag = SCF_BACKUP;
+      backup_init(&CONTEXT->ssql->sstr.backup, $3);
+    }
+    ;
+
+option_value:
+    ID { $$ = $1; }
+    | SYNC { $$ = "sync"; }  /* SYNC是关键字 */
+    ;
+
 drop_table:		/*drop table 语句的语法解析树*/
     DROP TABLE ID SEMICOLON {
         CONTEXT->ssql->flag = SCF_DROP_TABLE;//"drop_table";
@@ -216,10 +243,75 @@ desc_table:
     ;
 
 create_index:		/*create index 语句的语法解析树*/
-    CREATE INDEX ID ON ID LBRACE ID RBRACE SEMICOLON 
+    CREATE INDEX ID ON ID LBRACE index_attr index_attr_list RBRACE index_options SEMICOLON 
 		{
 			CONTEXT->ssql->flag = SCF_CREATE_INDEX;//"create_index";
-			create_index_init(&CONTEXT->ssql->sstr.create_index, $3, $5, $7);
+			create_index_init(&CONTEXT->ssql->sstr.create_index, $3, $5);
+		}
+    ;
+index_attr:
+    ID {
+			if (create_index_append_attribute(&CONTEXT->ssql->sstr.create_index, $1) != 0) {
+				yyerror(scanner, "too many index columns");
+				YYABORT;
+			}
+		}
+    ;
+index_attr_list:
+    /* empty */
+    | COMMA index_attr index_attr_list {
+		}
+    ;
+index_options:
+    /* empty */
+    | index_option index_options {
+		}
+    ;
+index_option:
+    ID LBRACE include_attr include_attr_list RBRACE {
+			// 词法里没有INCLUDE关键字，按标识符解析
+			if (strcasecmp($1, "include") != 0) {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			}
+		}
+    | ID ID {
+			// USING HASH / USING BTREE / USING LSM / WITH BLOOM / WITH ADAPTIVE_HASH
+			if (strcasecmp($1, "with") == 0) {
+				if (strcasecmp($2, "bloom") == 0) {
+					create_index_add_option(&CONTEXT->ssql->sstr.create_index, INDEX_OPTION_BLOOM_FILTER);
+				} else if (strcasecmp($2, "adaptive_hash") == 0) {
+					create_index_add_option(&CONTEXT->ssql->sstr.create_index, INDEX_OPTION_ADAPTIVE_HASH);
+				} else {
+					yyerror(scanner, "syntax error");
+					YYABORT;
+				}
+			} else if (strcasecmp($1, "using") != 0) {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			} else if (strcasecmp($2, "hash") == 0) {
+				create_index_set_type(&CONTEXT->ssql->sstr.create_index, INDEX_HASH);
+			} else if (strcasecmp($2, "btree") == 0) {
+				create_index_set_type(&CONTEXT->ssql->sstr.create_index, INDEX_BPLUS_TREE);
+			} else if (strcasecmp($2, "lsm") == 0) {
+				create_index_set_type(&CONTEXT->ssql->sstr.create_index, INDEX_LSM);
+			} else {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			}
+		}
+    ;
+include_attr:
+    ID {
+			if (create_index_append_include(&CONTEXT->ssql->sstr.create_index, $1) != 0) {
+				yyerror(scanner, "too many index columns");
+				YYABORT;
+			}
+		}
+    ;
+include_attr_list:
+    /* empty */
+    | COMMA include_attr include_attr_list {
 		}
     ;
 
@@ -231,7 +323,7 @@ drop_index:			/*drop index 语句的语法解析树*/
 		}
     ;
 create_table:		/*create table 语句的语法解析树*/
-    CREATE TABLE ID LBRACE attr_def attr_def_list RBRACE SEMICOLON 
+    CREATE TABLE ID LBRACE attr_def attr_def_list RBRACE table_options SEMICOLON 
 		{
 			CONTEXT->ssql->flag=SCF_CREATE_TABLE;//"create_table";
 			// CONTEXT->ssql->sstr.create_table.attribute_count = CONTEXT->value_length;
@@ -240,6 +332,19 @@ create_table:		/*create table 语句的语法解析树*/
 			CONTEXT->value_length = 0;
 		}
     ;
+table_options:
+    /* empty */
+    | ID EQ option_value {
+			// DURABILITY = SYNC | ASYNC | NOLOG，词法里没有DURABILITY关键字，按标识符解析
+			Durability durability;
+			if (strcasecmp($1, "durability") != 0 || parse_durability($3, &durability) != 0
+			    || durability == DURABILITY_DEFAULT) {
+				yyerror(scanner, "syntax error");
+				YYABORT;
+			}
+			create_table_set_durability(&CONTEXT->ssql->sstr.create_table, durability);
+		}
+    ;
 attr_def_list:
     /* empty */
     | COMMA attr_def attr_def_list {    }
@@ -391,73 +496,73 @@ select_attr:
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _MAX LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $3);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _MAX LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $3, $5);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _COUNT LBRACE STAR RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _COUNT LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $3);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _COUNT LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $3, $5);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _MIN LBRACE STAR RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _MIN LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $3);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _MIN LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $3, $5);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _AVG LBRACE STAR RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _AVG LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $3);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| _AVG LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $3, $5);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	;
 attr_list:
@@ -482,73 +587,73 @@ attr_list:
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);
 		}
 	| COMMA _MAX LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $4);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _MAX LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $4, $6);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 1, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _COUNT LBRACE STAR RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _COUNT LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $4);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _COUNT LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $4, $6);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 3, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _MIN LBRACE STAR RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _MIN LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $4);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _MIN LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $4, $6);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 2, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _AVG LBRACE STAR RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, "*");
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _AVG LBRACE ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, NULL, $4);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	| COMMA _AVG LBRACE ID DOT ID RBRACE attr_list {
 			RelAttr attr;
 			relation_attr_init(&attr, $4, $6);
 			selects_append_attribute(&CONTEXT->ssql->sstr.selection, &attr);
-			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->select_length);	
+			selects_aggregation_add(&CONTEXT->ssql->sstr.selection, 4, CONTEXT->ssql->sstr.selection.attr_num - 1);	
 		}
 	;
 
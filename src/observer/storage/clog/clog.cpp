@@ -0,0 +1,1362 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include "storage/clog/clog.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+
+#include "common/log/log.h"
+#include "common/os/path.h"
+#include "storage/common/record_manager.h"
+
+static uint32_t crc32_table[256];
+
+static bool init_crc32_table() {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) {
+      c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+    }
+    crc32_table[i] = c;
+  }
+  return true;
+}
+
+static uint32_t crc32(uint32_t crc, const char *data, size_t size) {
+  static bool initialized = init_crc32_table();
+  (void)initialized;
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc = crc32_table[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+static uint32_t record_checksum(const CLogRecordHeader &header, const char *data) {
+  CLogRecordHeader tmp = header;
+  tmp.checksum = 0;
+  uint32_t crc = crc32(0, (const char *)&tmp, sizeof(tmp));
+  return crc32(crc, data, header.data_len);
+}
+
+static const uint32_t CLOG_CONTROL_MAGIC = 0x474F4C43;  // "CLOG"
+static const int32_t  CLOG_CONTROL_VERSION = 2;
+static const int32_t  TRX_ID_RESERVE_STEP = 1000;
+static const size_t   REDO_BATCH_SIZE = 256;
+static const size_t   REDO_MAX_BATCHES = 16;
+
+/**
+ * 控制文件的内容，后面跟着commit_count个事务号和整个文件的CRC32
+ */
+struct CLogControl {
+  uint32_t magic;
+  int32_t  version;
+  LSN      checkpoint_lsn;  // 恢复从这里开始，之前的修改都已经写回了数据文件
+  int32_t  max_trx_id;      // 已经分配出去的事务号不会超过它
+  int32_t  commit_count;    // 检查点时已经提交但还没有TRX_END的事务
+  int32_t  clean_shutdown;  // 正常关闭时是1，版本2增加
+};
+
+// 版本1的控制文件没有clean_shutdown
+static const size_t CLOG_CONTROL_V1_SIZE = offsetof(CLogControl, clean_shutdown);
+
+CLogOptions &CLogOptions::instance() {
+  static CLogOptions options;
+  return options;
+}
+
+const char *clog_type_name(CLogType type) {
+  switch (type) {
+    case CLogType::FILE_CREATE: return "FILE_CREATE";
+    case CLogType::FILE_NAME: return "FILE_NAME";
+    case CLogType::PAGE_ALLOCATE: return "PAGE_ALLOCATE";
+    case CLogType::PAGE_DISPOSE: return "PAGE_DISPOSE";
+    case CLogType::PAGE_WRITE: return "PAGE_WRITE";
+    case CLogType::RECORD_PAGE_INIT: return "RECORD_PAGE_INIT";
+    case CLogType::RECORD_INSERT: return "RECORD_INSERT";
+    case CLogType::RECORD_UPDATE: return "RECORD_UPDATE";
+    case CLogType::RECORD_DELETE: return "RECORD_DELETE";
+    case CLogType::COMMIT: return "COMMIT";
+    case CLogType::TRX_END: return "TRX_END";
+  }
+  return "UNKNOWN";
+}
+
+
+CLogManager *theGlobalCLogManager() {
+  static CLogManager *instance = new CLogManager();
+  return instance;
+}
+
+static std::string dir_of(const std::string &file_name) {
+  size_t pos = file_name.rfind('/');
+  if (pos == std::string::npos) {
+    return ".";
+  }
+  return pos == 0 ? "/" : file_name.substr(0, pos);
+}
+
+/**
+ * 新建或者重命名文件之后，目录项也要落盘
+ */
+static RC sync_dir(const std::string &file_name) {
+  const std::string dir = dir_of(file_name);
+  int fd = ::open(dir.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open directory %s, due to %s.", dir.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  RC rc = RC::SUCCESS;
+  if (fsync(fd) != 0) {
+    LOG_ERROR("Failed to sync directory %s, due to %s.", dir.c_str(), strerror(errno));
+    rc = RC::IOERR_DIR_FSYNC;
+  }
+  ::close(fd);
+  return rc;
+}
+
+CLogManager::~CLogManager() {
+  close();
+}
+
+RC CLogManager::open(const char *file_name, const CLogOptions &options) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (opened_) {
+    LOG_WARN("Redo log has been opened. file=%s", file_name_.c_str());
+    return RC::RECORD_OPENNED;
+  }
+  file_name_ = file_name;
+  options_ = options;
+  io_error_ = RC::SUCCESS;
+  buffer_.clear();
+  buffer_.reserve(options_.buffer_size);
+  fd_ = -1;
+  segment_lsn_ = 0;
+  current_lsn_ = 0;
+  durable_lsn_ = 0;
+  file_nos_.clear();
+  committing_trx_.clear();
+  stats_ = CLogStats();
+  async_lsn_ = 0;
+  crashed_ = false;
+  stopping_ = false;
+  recovered_trx_id_ = 0;
+  recovered_commits_.clear();
+  trx_recovery_finished_.store(false);
+
+  std::lock_guard<std::mutex> control_guard(control_lock_);
+  RC rc = read_control();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  checkpoint_lsn_ = control_checkpoint_lsn_;
+  opened_ = true;
+  LOG_INFO("Open redo log %s. checkpoint lsn=%lld", file_name, (long long)checkpoint_lsn_);
+  return RC::SUCCESS;
+}
+
+RC CLogManager::close() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    stopping_ = true;
+    checkpoint_cond_.notify_all();
+    async_cond_.notify_all();
+  }
+  if (checkpoint_thread_.joinable()) {
+    checkpoint_thread_.join();
+  }
+  if (flush_thread_.joinable()) {
+    flush_thread_.join();
+  }
+
+  RC rc = RC::SUCCESS;
+  if (enabled()) {
+    rc = checkpoint();
+    if (rc == RC::SUCCESS) {
+      // 所有的修改都已经写回数据文件，下次启动时不记日志的表可以保留
+      std::lock_guard<std::mutex> control_guard(control_lock_);
+      control_clean_shutdown_ = true;
+      rc = write_control(control_checkpoint_lsn_, reserved_trx_id_.load(), control_commits_);
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  while (flushing_) {
+    flushed_cond_.wait(lock);
+  }
+  enabled_.store(false, std::memory_order_release);
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+    LOG_INFO("Close redo log %s.", file_name_.c_str());
+  }
+  opened_ = false;
+  buffer_pool_ = nullptr;
+  return rc;
+}
+
+RC CLogManager::append(CLogType type, int32_t trx_id, const char *file_name, PageNum page_num, int32_t offset,
+                       const char *data, int32_t data_len, LSN *lsn) {
+  *lsn = 0;
+  if (!enabled()) {
+    return RC::SUCCESS;
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (io_error_ != RC::SUCCESS) {
+    return io_error_;
+  }
+
+  // 缓冲区满了，等正在写的leader结束，或者自己把缓冲区写出去
+  while (buffer_.size() >= options_.buffer_size) {
+    if (flushing_) {
+      flushed_cond_.wait(lock);
+      continue;
+    }
+    RC rc = flush_buffer(lock);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  int32_t file_no = 0;
+  if (file_name != nullptr) {
+    auto iter = file_nos_.find(file_name);
+    if (iter == file_nos_.end()) {
+      file_no = (int32_t)file_nos_.size() + 1;
+      file_nos_.emplace(file_name, file_no);
+      append_record(CLogType::FILE_NAME, 0, file_no, BP_INVALID_PAGE_NUM, 0, file_name, strlen(file_name) + 1);
+    } else {
+      file_no = iter->second;
+    }
+  }
+  *lsn = append_record(type, trx_id, file_no, page_num, offset, data, data_len);
+  return RC::SUCCESS;
+}
+
+LSN CLogManager::append_record(CLogType type, int32_t trx_id, int32_t file_no, PageNum page_num, int32_t offset,
+                               const char *data, int32_t data_len) {
+  CLogRecordHeader header;
+  header.length = sizeof(header) + data_len;
+  header.checksum = 0;
+  header.type = (int32_t)type;
+  header.trx_id = trx_id;
+  header.file_no = file_no;
+  header.page_num = page_num;
+  header.offset = offset;
+  header.data_len = data_len;
+  header.checksum = record_checksum(header, data);
+
+  buffer_.insert(buffer_.end(), (const char *)&header, (const char *)&header + sizeof(header));
+  buffer_.insert(buffer_.end(), data, data + data_len);
+  current_lsn_ += header.length;
+
+  stats_.appends++;
+  stats_.bytes += header.length;
+  if (type == CLogType::COMMIT) {
+    stats_.commits++;
+    if (trx_id != 0) {
+      committing_trx_.insert(trx_id);
+    }
+  } else if (type == CLogType::TRX_END) {
+    committing_trx_.erase(trx_id);
+  }
+  if (options_.checkpoint_size > 0 && current_lsn_ - checkpoint_lsn_ >= (LSN)options_.checkpoint_size) {
+    checkpoint_cond_.notify_one();
+  }
+  return current_lsn_;
+}
+
+RC CLogManager::sync(LSN lsn) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!enabled()) {
+    return RC::SUCCESS;
+  }
+  // 日志尾部损坏被丢弃时，页面上可能留下比已经追加的位置更大的LSN
+  if (lsn > current_lsn_) {
+    lsn = current_lsn_;
+  }
+  while (durable_lsn_ < lsn) {
+    if (io_error_ != RC::SUCCESS) {
+      return io_error_;
+    }
+    if (flushing_) {
+      flushed_cond_.wait(lock);
+      continue;
+    }
+    RC rc = flush_buffer(lock);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC CLogManager::commit_async(LSN lsn) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!enabled()) {
+    return RC::SUCCESS;
+  }
+  if (io_error_ != RC::SUCCESS) {
+    return io_error_;
+  }
+  if (lsn > async_lsn_) {
+    // 后台线程空闲时才需要唤醒，否则它写完当前这一批后会再检查
+    const bool idle = async_lsn_ <= durable_lsn_;
+    async_lsn_ = lsn;
+    if (idle) {
+      async_cond_.notify_one();
+    }
+  }
+  return RC::SUCCESS;
+}
+
+/**
+ * 当前线程作为leader把缓冲区中所有的日志写出并落盘。
+ * 写文件时不持有锁，其它线程可以继续往新的缓冲区中追加日志，等待落盘的线程在leader结束后一起返回。
+ * 检查点只在没有leader并且缓冲区为空时切换日志段，写出的日志总是在同一个日志段中
+ */
+RC CLogManager::flush_buffer(std::unique_lock<std::mutex> &lock) {
+  flushing_ = true;
+  if (options_.commit_delay > 0) {
+    lock.unlock();
+    usleep(options_.commit_delay);
+    lock.lock();
+  }
+
+  flush_buffer_.swap(buffer_);
+  const int fd = fd_;
+  const off_t offset = durable_lsn_ - segment_lsn_;
+  const LSN end_lsn = current_lsn_;
+  lock.unlock();
+
+  RC rc = write_file(fd, flush_buffer_.data(), flush_buffer_.size(), offset);
+  if (rc == RC::SUCCESS && fdatasync(fd) != 0) {
+    LOG_ERROR("Failed to sync redo log %s, due to %s.", file_name_.c_str(), strerror(errno));
+    rc = RC::IOERR_FSYNC;
+  }
+  flush_buffer_.clear();
+
+  lock.lock();
+  flushing_ = false;
+  if (rc == RC::SUCCESS) {
+    durable_lsn_ = end_lsn;
+    stats_.syncs++;
+  } else {
+    io_error_ = rc;
+  }
+  flushed_cond_.notify_all();
+  return rc;
+}
+
+RC CLogManager::write_file(int fd, const char *data, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR("Failed to write redo log %s at %lld, due to %s.", file_name_.c_str(), (long long)offset,
+                strerror(errno));
+      return RC::IOERR_WRITE;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return RC::SUCCESS;
+}
+
+LSN CLogManager::current_lsn() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return current_lsn_;
+}
+
+LSN CLogManager::durable_lsn() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return durable_lsn_;
+}
+
+LSN CLogManager::checkpoint_lsn() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return checkpoint_lsn_;
+}
+
+CLogStats CLogManager::stats() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return stats_;
+}
+
+std::string CLogManager::segment_file(LSN start_lsn) const {
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%020lld", (long long)start_lsn);
+  return file_name_ + suffix;
+}
+
+RC CLogManager::list_segments(std::vector<LSN> &segments) const {
+  std::vector<std::string> files;
+  if (common::list_file(dir_of(file_name_).c_str(), "\\.[0-9]\\{20\\}$", files) < 0) {
+    LOG_ERROR("Failed to list redo log segments of %s.", file_name_.c_str());
+    return RC::IOERR_ACCESS;
+  }
+
+  segments.clear();
+  const std::string base_name = common::getFileName(file_name_) + ".";
+  for (const std::string &file : files) {
+    const std::string name = common::getFileName(file);
+    if (name.size() == base_name.size() + 20 && name.compare(0, base_name.size(), base_name) == 0) {
+      segments.push_back(strtoll(name.c_str() + base_name.size(), nullptr, 10));
+    }
+  }
+  std::sort(segments.begin(), segments.end());
+  return RC::SUCCESS;
+}
+
+RC CLogManager::open_segment(LSN start_lsn) {
+  const std::string file_name = segment_file(start_lsn);
+  int fd = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IREAD | S_IWRITE);
+  if (fd < 0) {
+    LOG_ERROR("Failed to create redo log segment %s, due to %s.", file_name.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  RC rc = sync_dir(file_name);
+  if (rc != RC::SUCCESS) {
+    ::close(fd);
+    return rc;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  fd_ = fd;
+  segment_lsn_ = start_lsn;
+  return RC::SUCCESS;
+}
+
+void CLogManager::remove_segments_before(LSN lsn) {
+  std::vector<LSN> segments;
+  if (list_segments(segments) != RC::SUCCESS) {
+    return;
+  }
+  for (LSN segment_lsn : segments) {
+    if (segment_lsn >= lsn) {
+      break;
+    }
+    const std::string file_name = segment_file(segment_lsn);
+    if (unlink(file_name.c_str()) != 0) {
+      LOG_WARN("Failed to remove redo log segment %s, due to %s.", file_name.c_str(), strerror(errno));
+    }
+  }
+}
+
+RC CLogManager::read_control() {
+  control_checkpoint_lsn_ = 0;
+  control_commits_.clear();
+  control_clean_shutdown_ = true;   // 还没有控制文件时是新建的日志，没有要恢复的内容
+  reserved_trx_id_.store(0);
+
+  const std::string file_name = file_name_ + ".ctl";
+  FILE *fp = fopen(file_name.c_str(), "rb");
+  if (fp == nullptr) {
+    if (errno == ENOENT) {
+      return RC::SUCCESS;
+    }
+    LOG_ERROR("Failed to open redo log control file %s, due to %s.", file_name.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  std::vector<char> content;
+  char buf[4096];
+  size_t size;
+  while ((size = fread(buf, 1, sizeof(buf), fp)) > 0) {
+    content.insert(content.end(), buf, buf + size);
+  }
+  fclose(fp);
+
+  CLogControl control;
+  memset(&control, 0, sizeof(control));
+  uint32_t checksum;
+  if (content.size() < CLOG_CONTROL_V1_SIZE + sizeof(checksum)) {
+    LOG_ERROR("Invalid redo log control file %s. size=%d", file_name.c_str(), (int)content.size());
+    return RC::IOERR_SHORT_READ;
+  }
+  memcpy(&control, content.data(), CLOG_CONTROL_V1_SIZE);
+  const size_t header_size = control.version == 1 ? CLOG_CONTROL_V1_SIZE : sizeof(control);
+  if (content.size() < header_size + sizeof(checksum)) {
+    LOG_ERROR("Invalid redo log control file %s. size=%d", file_name.c_str(), (int)content.size());
+    return RC::IOERR_SHORT_READ;
+  }
+  memcpy(&control, content.data(), header_size);
+  const size_t data_size = content.size() - sizeof(checksum);
+  memcpy(&checksum, content.data() + data_size, sizeof(checksum));
+  if (control.magic != CLOG_CONTROL_MAGIC || control.version < 1 || control.version > CLOG_CONTROL_VERSION ||
+      control.commit_count < 0 || data_size != header_size + control.commit_count * sizeof(int32_t) ||
+      checksum != crc32(0, content.data(), data_size)) {
+    LOG_ERROR("Corrupted redo log control file %s.", file_name.c_str());
+    return RC::IOERR_DATA;
+  }
+
+  const int32_t *commits = (const int32_t *)(content.data() + header_size);
+  control_commits_.insert(commits, commits + control.commit_count);
+  control_checkpoint_lsn_ = control.checkpoint_lsn;
+  control_clean_shutdown_ = control.clean_shutdown != 0;
+  reserved_trx_id_.store(control.max_trx_id);
+  return RC::SUCCESS;
+}
+
+/**
+ * 先写临时文件，落盘之后再替换原来的控制文件，崩溃时总有一个完整的控制文件。调用者持有control_lock_
+ */
+RC CLogManager::write_control(LSN checkpoint_lsn, int32_t max_trx_id, const std::unordered_set<int32_t> &commits) {
+  RC rc = write_control_file(file_name_ + ".ctl", checkpoint_lsn, max_trx_id, commits, control_clean_shutdown_);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  control_checkpoint_lsn_ = checkpoint_lsn;
+  control_commits_ = commits;
+  return RC::SUCCESS;
+}
+
+RC CLogManager::write_control_file(const std::string &file_name, LSN checkpoint_lsn, int32_t max_trx_id,
+                                   const std::unordered_set<int32_t> &commits, bool clean_shutdown) {
+  CLogControl control;
+  memset(&control, 0, sizeof(control));
+  control.magic = CLOG_CONTROL_MAGIC;
+  control.version = CLOG_CONTROL_VERSION;
+  control.checkpoint_lsn = checkpoint_lsn;
+  control.max_trx_id = max_trx_id;
+  control.commit_count = (int32_t)commits.size();
+  control.clean_shutdown = clean_shutdown ? 1 : 0;
+  std::vector<char> content((const char *)&control, (const char *)&control + sizeof(control));
+  for (int32_t trx_id : commits) {
+    content.insert(content.end(), (const char *)&trx_id, (const char *)&trx_id + sizeof(trx_id));
+  }
+  const uint32_t checksum = crc32(0, content.data(), content.size());
+  content.insert(content.end(), (const char *)&checksum, (const char *)&checksum + sizeof(checksum));
+
+  const std::string tmp_file_name = file_name + ".tmp";
+  int fd = ::open(tmp_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IREAD | S_IWRITE);
+  if (fd < 0) {
+    LOG_ERROR("Failed to create %s, due to %s.", tmp_file_name.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  RC rc = write_file(fd, content.data(), content.size(), 0);
+  if (rc == RC::SUCCESS && fsync(fd) != 0) {
+    LOG_ERROR("Failed to sync %s, due to %s.", tmp_file_name.c_str(), strerror(errno));
+    rc = RC::IOERR_FSYNC;
+  }
+  ::close(fd);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  if (rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+    LOG_ERROR("Failed to rename %s to %s, due to %s.", tmp_file_name.c_str(), file_name.c_str(), strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+  return sync_dir(file_name);
+}
+
+RC CLogManager::reserve_trx_id(int32_t trx_id) {
+  if (trx_id <= reserved_trx_id_.load(std::memory_order_acquire) || !enabled()) {
+    return RC::SUCCESS;
+  }
+  std::lock_guard<std::mutex> control_guard(control_lock_);
+  if (trx_id <= reserved_trx_id_.load(std::memory_order_acquire)) {
+    return RC::SUCCESS;
+  }
+  const int32_t reserved_trx_id = trx_id + TRX_ID_RESERVE_STEP;
+  RC rc = write_control(control_checkpoint_lsn_, reserved_trx_id, control_commits_);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to reserve trx id %d. rc=%d:%s", trx_id, rc, strrc(rc));
+    return rc;
+  }
+  reserved_trx_id_.store(reserved_trx_id, std::memory_order_release);
+  return RC::SUCCESS;
+}
+
+RC CLogManager::begin_backup(CLogBackup &backup) {
+  if (!enabled()) {
+    LOG_WARN("Online backup needs redo log.");
+    return RC::GENERIC_ERROR;
+  }
+  // 和检查点写控制文件、决定删除哪些日志段在同一个锁里，拿到的检查点之后的日志段不会被删除
+  std::lock_guard<std::mutex> control_guard(control_lock_);
+  backup.start_lsn = control_checkpoint_lsn_;
+  backup.end_lsn = 0;
+  backup.commits = control_commits_;
+  backup_lsns_.insert(backup.start_lsn);
+  LOG_INFO("Begin backup of redo log %s at checkpoint lsn %lld.", file_name_.c_str(), (long long)backup.start_lsn);
+  return RC::SUCCESS;
+}
+
+RC CLogManager::copy_backup_log(CLogBackup &backup, const std::string &file_name) {
+  const LSN end_lsn = current_lsn();
+  RC rc = sync(end_lsn);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  std::vector<LSN> segments;
+  rc = list_segments(segments);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  // 一个日志段的内容正好到下一个日志段开始的位置，最后一段只复制已经落盘的部分
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (segments[i] < backup.start_lsn) {
+      continue;
+    }
+    if (segments[i] >= end_lsn && segments[i] != backup.start_lsn) {
+      break;
+    }
+    const LSN segment_end = i + 1 < segments.size() && segments[i + 1] <= end_lsn ? segments[i + 1] : end_lsn;
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%020lld", (long long)segments[i]);
+    rc = copy_segment(segments[i], segment_end - segments[i], file_name + suffix);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  // 事务号在备份之后继续分配，记下到现在为止预留的最大事务号
+  rc = write_control_file(file_name + ".ctl", backup.start_lsn, reserved_trx_id_.load(std::memory_order_acquire),
+                          backup.commits, false);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to write redo log control file of backup %s. rc=%d:%s", file_name.c_str(), rc, strrc(rc));
+    return rc;
+  }
+  backup.end_lsn = end_lsn;
+  LOG_INFO("Copy redo log %s to backup %s. lsn=[%lld, %lld)", file_name_.c_str(), file_name.c_str(),
+           (long long)backup.start_lsn, (long long)end_lsn);
+  return RC::SUCCESS;
+}
+
+RC CLogManager::copy_segment(LSN start_lsn, off_t size, const std::string &target_file) {
+  const std::string source_file = segment_file(start_lsn);
+  int source = ::open(source_file.c_str(), O_RDONLY);
+  if (source < 0) {
+    LOG_ERROR("Failed to open redo log segment %s, due to %s.", source_file.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  int target = ::open(target_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IREAD | S_IWRITE);
+  if (target < 0) {
+    LOG_ERROR("Failed to create %s, due to %s.", target_file.c_str(), strerror(errno));
+    ::close(source);
+    return RC::IOERR_ACCESS;
+  }
+
+  RC rc = RC::SUCCESS;
+  std::vector<char> buffer(1024 * 1024);
+  for (off_t offset = 0; rc == RC::SUCCESS && offset < size;) {
+    ssize_t ret = pread(source, buffer.data(), std::min((off_t)buffer.size(), size - offset), offset);
+    if (ret <= 0) {
+      LOG_ERROR("Failed to read redo log segment %s at %lld. ret=%d, error=%s",
+                source_file.c_str(), (long long)offset, (int)ret, strerror(errno));
+      rc = RC::IOERR_READ;
+      break;
+    }
+    rc = write_file(target, buffer.data(), ret, offset);
+    offset += ret;
+  }
+  if (rc == RC::SUCCESS && fsync(target) != 0) {
+    LOG_ERROR("Failed to sync %s, due to %s.", target_file.c_str(), strerror(errno));
+    rc = RC::IOERR_FSYNC;
+  }
+  ::close(source);
+  ::close(target);
+  return rc;
+}
+
+void CLogManager::end_backup(const CLogBackup &backup) {
+  std::lock_guard<std::mutex> control_guard(control_lock_);
+  auto iter = backup_lsns_.find(backup.start_lsn);
+  if (iter != backup_lsns_.end()) {
+    backup_lsns_.erase(iter);
+  }
+}
+
+bool CLogManager::is_recovered_commit(int32_t trx_id) const {
+  return !trx_recovery_finished_.load(std::memory_order_acquire) && recovered_commits_.count(trx_id) > 0;
+}
+
+void CLogManager::finish_trx_recovery() {
+  trx_recovery_finished_.store(true, std::memory_order_release);
+}
+
+RC CLogManager::checkpoint(bool throttled) {
+  std::lock_guard<std::mutex> checkpoint_guard(checkpoint_lock_);
+  LSN checkpoint_lsn;
+  std::unordered_set<int32_t> commits;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!enabled()) {
+      return RC::SUCCESS;
+    }
+    // 当前日志段中的日志都落盘之后才能切换到新的日志段
+    while (flushing_ || !buffer_.empty()) {
+      if (io_error_ != RC::SUCCESS) {
+        return io_error_;
+      }
+      if (flushing_) {
+        flushed_cond_.wait(lock);
+        continue;
+      }
+      RC rc = flush_buffer(lock);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+    }
+    if (current_lsn_ == checkpoint_lsn_) {
+      return RC::SUCCESS;
+    }
+    RC rc = open_segment(current_lsn_);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    // 新的日志段中重新给文件分配编号，恢复时只从检查点之后的日志段读起
+    file_nos_.clear();
+    checkpoint_lsn = current_lsn_;
+    commits = committing_trx_;
+    if (!trx_recovery_finished_.load(std::memory_order_acquire)) {
+      commits.insert(recovered_commits_.begin(), recovered_commits_.end());
+    }
+  }
+
+  // 检查点之前的修改都写回数据文件之后，之前的日志才不再需要
+  RC rc = flush_dirty_pages(checkpoint_lsn, throttled);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to flush dirty pages for checkpoint. rc=%d:%s", rc, strrc(rc));
+    return rc;
+  }
+  LSN remove_lsn = checkpoint_lsn;
+  {
+    std::lock_guard<std::mutex> control_guard(control_lock_);
+    rc = write_control(checkpoint_lsn, reserved_trx_id_.load(std::memory_order_acquire), commits);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to write redo log control file for checkpoint. rc=%d:%s", rc, strrc(rc));
+      return rc;
+    }
+    // 在线备份还要复制的日志段先保留
+    if (!backup_lsns_.empty()) {
+      remove_lsn = std::min(remove_lsn, *backup_lsns_.begin());
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    checkpoint_lsn_ = checkpoint_lsn;
+    stats_.checkpoints++;
+  }
+  remove_segments_before(remove_lsn);
+  LOG_INFO("Checkpoint of redo log %s at lsn %lld.", file_name_.c_str(), (long long)checkpoint_lsn);
+  return RC::SUCCESS;
+}
+
+/**
+ * 在检查点之前变脏的页面按(文件, 页面)的顺序分批写回，然后把数据文件落盘。
+ * 限速时每批至少是10毫秒的配额。页面上的日志还没有落盘时在缓冲池的锁外等待，
+ * 同一个页面等过一次之后还在被修改时直接写回，由缓冲池在锁里等日志落盘
+ */
+RC CLogManager::flush_dirty_pages(LSN checkpoint_lsn, bool throttled) {
+  std::vector<DirtyPage> pages;
+  buffer_pool_->dirty_page_table(checkpoint_lsn, pages);
+
+  const auto begin = std::chrono::steady_clock::now();
+  const int rate = options_.checkpoint_flush_rate;
+  const long batch_pages = std::max(1, rate / 100);
+  DirtyPageBatch batch;
+  batch.lsn = checkpoint_lsn;
+  batch.max_pause = options_.checkpoint_max_pause;
+  size_t synced_page = pages.size();
+  long written = 0;
+  while (batch.next < pages.size()) {
+    long max_pages = (long)(pages.size() - batch.next);
+    if (throttled && rate > 0) {
+      std::unique_lock<std::mutex> lock(lock_);
+      while (!stopping_) {
+        // 按限速到现在为止还可以写回的页面数
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        const long allowed = (long)(elapsed.count() * rate) + 1 - written;
+        if (allowed >= std::min(batch_pages, max_pages)) {
+          max_pages = std::min(max_pages, allowed);
+          break;
+        }
+        const long target = written + std::min(batch_pages, max_pages) - 1;
+        checkpoint_cond_.wait_until(lock, begin + std::chrono::microseconds(target * 1000000 / rate));
+      }
+    }
+
+    batch.max_pages = (int)max_pages;
+    batch.durable_lsn = batch.next == synced_page ? std::numeric_limits<LSN>::max() : durable_lsn();
+    RC rc = buffer_pool_->flush_dirty_pages(pages, batch);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    written += batch.flushed;
+    if (batch.sync_lsn != 0) {
+      // 之后的页面上的修改也一起落盘
+      synced_page = batch.next;
+      rc = sync(std::max(batch.sync_lsn, current_lsn()));
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    stats_.checkpoint_pages += written;
+  }
+  return buffer_pool_->sync_files();
+}
+
+void CLogManager::request_checkpoint() {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!enabled()) {
+    return;
+  }
+  checkpoint_requested_ = true;
+  checkpoint_cond_.notify_all();
+}
+
+void CLogManager::checkpoint_thread() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!stopping_) {
+    if (!checkpoint_requested_ &&
+        (options_.checkpoint_size == 0 || current_lsn_ - checkpoint_lsn_ < (LSN)options_.checkpoint_size)) {
+      checkpoint_cond_.wait(lock);
+      continue;
+    }
+    checkpoint_requested_ = false;
+    lock.unlock();
+    RC rc = checkpoint(true);
+    lock.lock();
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to do checkpoint of redo log %s. rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+      checkpoint_cond_.wait_for(lock, std::chrono::seconds(1));
+    }
+  }
+}
+
+/**
+ * 有异步提交的日志没有落盘时，最多等待async_commit_delay毫秒，期间异步提交的事务一起落盘。
+ * 同步提交或者检查点已经把日志写出时不用再写
+ */
+void CLogManager::flush_thread() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!stopping_) {
+    if (durable_lsn_ >= async_lsn_ || io_error_ != RC::SUCCESS) {
+      async_cond_.wait(lock);
+      continue;
+    }
+    if (options_.async_commit_delay > 0) {
+      async_cond_.wait_for(lock, std::chrono::milliseconds(options_.async_commit_delay), [this]() {
+        return stopping_;
+      });
+    }
+    while (durable_lsn_ < async_lsn_ && io_error_ == RC::SUCCESS) {
+      if (flushing_) {
+        flushed_cond_.wait(lock);
+        continue;
+      }
+      RC rc = flush_buffer(lock);
+      if (rc != RC::SUCCESS) {
+        LOG_ERROR("Failed to flush redo log %s for async commit. rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+        break;
+      }
+      stats_.async_flushes++;
+    }
+  }
+}
+
+namespace {
+
+/**
+ * 交给重放线程的一条页面修改
+ */
+struct RedoTask {
+  CLogType          type;
+  int               file_id;
+  PageNum           page_num;
+  int32_t           offset;
+  LSN               lsn;
+  std::vector<char> data;
+};
+
+RC redo_page(DiskBufferPool &buffer_pool, const RedoTask &task) {
+  RC rc = RC::SUCCESS;
+  switch (task.type) {
+    case CLogType::PAGE_WRITE: {
+      rc = buffer_pool.redo_write_page(task.file_id, task.page_num, task.offset, task.data.data(),
+                                       (int)task.data.size(), task.lsn);
+    } break;
+    case CLogType::RECORD_PAGE_INIT:
+    case CLogType::RECORD_INSERT:
+    case CLogType::RECORD_UPDATE:
+    case CLogType::RECORD_DELETE: {
+      RecordPageHandler page_handler;
+      rc = page_handler.init(buffer_pool, task.file_id, task.page_num);
+      if (rc == RC::SUCCESS) {
+        rc = page_handler.redo(task.type, task.offset, task.data.data(), (int)task.data.size(), task.lsn);
+      }
+    } break;
+    default: {
+      LOG_ERROR("Unknown page redo log type %d.", (int)task.type);
+      return RC::GENERIC_ERROR;
+    }
+  }
+  // 页面在后面的日志中被释放了，写回的文件头中已经没有这个页面
+  if (rc == RC::BUFFERPOOL_INVALID_PAGE_NUM) {
+    return RC::SUCCESS;
+  }
+  return rc;
+}
+
+/**
+ * 并行重放页面修改。同一个页面的日志总是交给同一个线程，按日志中的顺序重放。
+ * 读日志的线程按批提交，每个线程排队的批数有上限
+ */
+class RedoWorkers {
+public:
+  RedoWorkers(DiskBufferPool &buffer_pool, int thread_num) : buffer_pool_(buffer_pool) {
+    for (int i = 0; thread_num > 1 && i < thread_num; i++) {
+      workers_.emplace_back(new Worker());
+    }
+    for (std::unique_ptr<Worker> &worker : workers_) {
+      worker->thread = std::thread(&RedoWorkers::run, this, worker.get());
+    }
+  }
+
+  ~RedoWorkers() {
+    for (std::unique_ptr<Worker> &worker : workers_) {
+      std::unique_lock<std::mutex> lock(worker->lock);
+      worker->stopping = true;
+      worker->cond.notify_all();
+    }
+    for (std::unique_ptr<Worker> &worker : workers_) {
+      worker->thread.join();
+    }
+  }
+
+  RC add(RedoTask &&task) {
+    if (workers_.empty()) {
+      return redo_page(buffer_pool_, task);
+    }
+    RC rc = error();
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    Worker *worker = workers_[((size_t)task.file_id * 31 + task.page_num) % workers_.size()].get();
+    worker->pending.emplace_back(std::move(task));
+    if (worker->pending.size() >= REDO_BATCH_SIZE) {
+      submit(worker);
+    }
+    return RC::SUCCESS;
+  }
+
+  /**
+   * 等待已经读出的日志全部重放完
+   */
+  RC drain() {
+    for (std::unique_ptr<Worker> &worker : workers_) {
+      if (!worker->pending.empty()) {
+        submit(worker.get());
+      }
+    }
+    for (std::unique_ptr<Worker> &worker : workers_) {
+      std::unique_lock<std::mutex> lock(worker->lock);
+      while (!worker->batches.empty() || worker->busy) {
+        worker->cond.wait(lock);
+      }
+    }
+    return error();
+  }
+
+private:
+  struct Worker {
+    std::mutex                         lock;
+    std::condition_variable            cond;
+    std::deque<std::vector<RedoTask>>  batches;
+    bool                               busy = false;
+    bool                               stopping = false;
+    std::vector<RedoTask>              pending;   // 只有读日志的线程访问
+    std::thread                        thread;
+  };
+
+  void submit(Worker *worker) {
+    std::unique_lock<std::mutex> lock(worker->lock);
+    while (worker->batches.size() >= REDO_MAX_BATCHES) {
+      worker->cond.wait(lock);
+    }
+    worker->batches.emplace_back(std::move(worker->pending));
+    worker->pending.clear();
+    worker->cond.notify_all();
+  }
+
+  void run(Worker *worker) {
+    std::unique_lock<std::mutex> lock(worker->lock);
+    while (true) {
+      while (worker->batches.empty() && !worker->stopping) {
+        worker->cond.wait(lock);
+      }
+      if (worker->batches.empty()) {
+        return;
+      }
+      std::vector<RedoTask> batch = std::move(worker->batches.front());
+      worker->batches.pop_front();
+      worker->busy = true;
+      worker->cond.notify_all();
+      lock.unlock();
+
+      for (const RedoTask &task : batch) {
+        if (error() != RC::SUCCESS) {
+          break;
+        }
+        RC rc = redo_page(buffer_pool_, task);
+        if (rc != RC::SUCCESS) {
+          LOG_ERROR("Failed to redo %s log at %lld. page=%d, rc=%d:%s",
+                    clog_type_name(task.type), (long long)task.lsn, task.page_num, rc, strrc(rc));
+          set_error(rc);
+        }
+      }
+
+      lock.lock();
+      worker->busy = false;
+      worker->cond.notify_all();
+    }
+  }
+
+  RC error() {
+    std::lock_guard<std::mutex> guard(error_lock_);
+    return error_;
+  }
+
+  void set_error(RC rc) {
+    std::lock_guard<std::mutex> guard(error_lock_);
+    if (error_ == RC::SUCCESS) {
+      error_ = rc;
+    }
+  }
+
+private:
+  DiskBufferPool &buffer_pool_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::mutex error_lock_;
+  RC error_ = RC::SUCCESS;
+};
+
+/**
+ * 重放过程中的状态，只有读日志的线程访问
+ */
+struct RedoContext {
+  RedoContext(DiskBufferPool &buffer_pool, int thread_num) : buffer_pool(buffer_pool), workers(buffer_pool, thread_num) {
+  }
+
+  DiskBufferPool                       &buffer_pool;
+  RedoWorkers                           workers;
+  std::unordered_map<std::string, int>  file_ids;    // 文件名 -> 缓冲池中的file_id，-1表示文件已经不存在
+  std::vector<std::string>              file_names;  // 下标是当前日志段中的文件编号
+  std::unordered_set<int32_t>           commits;     // COMMIT之后还没有TRX_END的事务
+  int32_t                               max_trx_id = 0;
+  long                                  records = 0;
+};
+
+/**
+ * 文件的创建、打开和页面的分配、释放由读日志的线程直接执行，页面内的修改交给重放线程
+ */
+RC redo(RedoContext &context, const CLogRecordHeader &header, const char *data, LSN lsn) {
+  DiskBufferPool &buffer_pool = context.buffer_pool;
+  const CLogType type = (CLogType)header.type;
+  switch (type) {
+    case CLogType::FILE_CREATE: {
+      std::string file_name(data, strnlen(data, header.data_len));
+      // 同名的文件在前面的日志中已经打开过，等前面的修改重放完，关闭，清空之后重新打开
+      RC rc = context.workers.drain();
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+      auto iter = context.file_ids.find(file_name);
+      const bool opened = iter != context.file_ids.end() && iter->second >= 0;
+      if (opened) {
+        rc = buffer_pool.close_file(iter->second);
+        if (rc != RC::SUCCESS) {
+          return rc;
+        }
+      }
+      rc = buffer_pool.redo_create_file(file_name.c_str());
+      if (rc != RC::SUCCESS || !opened) {
+        return rc;
+      }
+      return buffer_pool.open_file(file_name.c_str(), &iter->second);
+    }
+    case CLogType::FILE_NAME: {
+      std::string file_name(data, strnlen(data, header.data_len));
+      if (header.file_no <= 0) {
+        LOG_ERROR("Invalid file no %d of %s in redo log.", header.file_no, file_name.c_str());
+        return RC::GENERIC_ERROR;
+      }
+      if ((int)context.file_names.size() <= header.file_no) {
+        context.file_names.resize(header.file_no + 1);
+      }
+      context.file_names[header.file_no] = file_name;
+      if (context.file_ids.count(file_name) != 0) {
+        return RC::SUCCESS;
+      }
+      if (access(file_name.c_str(), F_OK) != 0) {
+        LOG_WARN("File %s does not exist any more, skip its redo log.", file_name.c_str());
+        context.file_ids[file_name] = -1;
+        return RC::SUCCESS;
+      }
+      int file_id = -1;
+      RC rc = buffer_pool.open_file(file_name.c_str(), &file_id);
+      if (rc == RC::SUCCESS) {
+        context.file_ids[file_name] = file_id;
+      }
+      return rc;
+    }
+    case CLogType::COMMIT: {
+      if (header.trx_id != 0) {
+        context.commits.insert(header.trx_id);
+      }
+      return RC::SUCCESS;
+    }
+    case CLogType::TRX_END: {
+      context.commits.erase(header.trx_id);
+      return RC::SUCCESS;
+    }
+    default: {
+    } break;
+  }
+
+  if (header.file_no <= 0 || header.file_no >= (int)context.file_names.size() ||
+      context.file_names[header.file_no].empty()) {
+    LOG_ERROR("Unknown file no %d in redo log.", header.file_no);
+    return RC::GENERIC_ERROR;
+  }
+  const int file_id = context.file_ids[context.file_names[header.file_no]];
+  if (file_id < 0) {
+    return RC::SUCCESS;
+  }
+
+  switch (type) {
+    case CLogType::PAGE_ALLOCATE: {
+      return buffer_pool.redo_allocate_page(file_id, header.page_num, lsn);
+    }
+    case CLogType::PAGE_DISPOSE: {
+      // 释放页面时页面不能被重放线程占用
+      RC rc = context.workers.drain();
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+      return buffer_pool.redo_dispose_page(file_id, header.page_num, lsn);
+    }
+    case CLogType::PAGE_WRITE:
+    case CLogType::RECORD_PAGE_INIT:
+    case CLogType::RECORD_INSERT:
+    case CLogType::RECORD_UPDATE:
+    case CLogType::RECORD_DELETE: {
+      RedoTask task;
+      task.type = type;
+      task.file_id = file_id;
+      task.page_num = header.page_num;
+      task.offset = header.offset;
+      task.lsn = lsn;
+      task.data.assign(data, data + header.data_len);
+      return context.workers.add(std::move(task));
+    }
+    default: {
+      LOG_ERROR("Unknown redo log type %d.", header.type);
+      return RC::GENERIC_ERROR;
+    }
+  }
+}
+
+/**
+ * 按顺序重放一个日志段。lsn是这一段的起始位置，返回时是最后一条完整日志的结束位置。
+ * 遇到不完整或者校验失败的日志时认为日志到此结束，end返回true
+ */
+RC redo_segment(RedoContext &context, const std::string &file_name, LSN &lsn, bool &end) {
+  FILE *fp = fopen(file_name.c_str(), "rb");
+  if (fp == nullptr) {
+    LOG_ERROR("Failed to open redo log %s to recover, due to %s.", file_name.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  // 每个日志段重新分配文件编号
+  context.file_names.clear();
+  RC rc = RC::SUCCESS;
+  CLogRecordHeader header;
+  std::vector<char> data;
+  end = true;
+  while (true) {
+    size_t size = fread(&header, 1, sizeof(header), fp);
+    if (size == 0 && feof(fp)) {
+      end = false;
+      break;
+    }
+    if (size != sizeof(header) || header.data_len < 0 || header.data_len > (int32_t)BP_PAGE_SIZE ||
+        header.length != (int32_t)sizeof(header) + header.data_len) {
+      LOG_WARN("Invalid redo log record at %lld, ignore the rest. length=%d, data_len=%d",
+               (long long)lsn, header.length, header.data_len);
+      break;
+    }
+    data.resize(header.data_len);
+    if (header.data_len > 0 && fread(data.data(), header.data_len, 1, fp) != 1) {
+      LOG_WARN("Incomplete redo log record at %lld, ignore it.", (long long)lsn);
+      break;
+    }
+    if (record_checksum(header, data.data()) != header.checksum) {
+      LOG_WARN("Checksum mismatch of redo log record at %lld, ignore the rest.", (long long)lsn);
+      break;
+    }
+
+    const LSN record_lsn = lsn + header.length;
+    rc = redo(context, header, data.data(), record_lsn);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to redo %s log at %lld. page=%d, rc=%d:%s",
+                clog_type_name((CLogType)header.type), (long long)record_lsn, header.page_num, rc, strrc(rc));
+      break;
+    }
+    lsn = record_lsn;
+    context.max_trx_id = std::max(context.max_trx_id, header.trx_id);
+    context.records++;
+  }
+  fclose(fp);
+  return rc;
+}
+
+}  // namespace
+
+RC CLogManager::recover(DiskBufferPool &buffer_pool) {
+  if (!opened_ || enabled()) {
+    LOG_ERROR("Redo log is not opened or has been recovered.");
+    return RC::GENERIC_ERROR;
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  std::vector<LSN> segments;
+  RC rc = list_segments(segments);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  LSN lsn = checkpoint_lsn_;
+  long redo_records = 0;
+  int32_t max_trx_id = 0;
+  std::unordered_set<int32_t> commits;
+  {
+    RedoContext context(buffer_pool, options_.recovery_threads);
+    context.commits = control_commits_;
+    context.max_trx_id = reserved_trx_id_.load();
+    for (LSN segment_lsn : segments) {
+      if (segment_lsn < checkpoint_lsn_) {
+        continue;  // 上次检查点之后没来得及删除
+      }
+      if (segment_lsn != lsn) {
+        LOG_WARN("Redo log segment %s does not start at the end of log %lld, ignore the rest.",
+                 segment_file(segment_lsn).c_str(), (long long)lsn);
+        break;
+      }
+      bool end = false;
+      rc = redo_segment(context, segment_file(segment_lsn), lsn, end);
+      if (rc != RC::SUCCESS || end) {
+        break;
+      }
+    }
+    RC rc2 = context.workers.drain();
+    if (rc == RC::SUCCESS) {
+      rc = rc2;
+    }
+
+    // 所有的页面写回并落盘之后，日志中的内容就不再需要了
+    for (const auto &iter : context.file_ids) {
+      if (iter.second < 0) {
+        continue;
+      }
+      rc2 = buffer_pool.close_file(iter.second);
+      if (rc2 == RC::SUCCESS) {
+        int fd = ::open(iter.first.c_str(), O_RDONLY);
+        if (fd < 0 || fsync(fd) != 0) {
+          LOG_ERROR("Failed to sync %s after recover, due to %s.", iter.first.c_str(), strerror(errno));
+          rc2 = RC::IOERR_FSYNC;
+        }
+        if (fd >= 0) {
+          ::close(fd);
+        }
+      }
+      if (rc == RC::SUCCESS) {
+        rc = rc2;
+      }
+    }
+    redo_records = context.records;
+    max_trx_id = context.max_trx_id;
+    commits.swap(context.commits);
+  }
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  // 重放的结果已经落盘，在日志的结束位置开始新的日志段并作为检查点
+  std::unique_lock<std::mutex> lock(lock_);
+  {
+    std::lock_guard<std::mutex> control_guard(control_lock_);
+    // 从现在开始到正常关闭之前崩溃的话，下次启动时要清空不记日志的表
+    crashed_ = !control_clean_shutdown_;
+    control_clean_shutdown_ = false;
+    rc = open_segment(lsn);
+    if (rc == RC::SUCCESS) {
+      rc = write_control(lsn, max_trx_id, commits);
+    }
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to start redo log at %lld. rc=%d:%s", (long long)lsn, rc, strrc(rc));
+      return rc;
+    }
+    reserved_trx_id_.store(max_trx_id);
+  }
+  for (LSN segment_lsn : segments) {
+    if (segment_lsn != lsn && unlink(segment_file(segment_lsn).c_str()) != 0) {
+      LOG_WARN("Failed to remove redo log segment %s, due to %s.", segment_file(segment_lsn).c_str(), strerror(errno));
+    }
+  }
+
+  current_lsn_ = lsn;
+  durable_lsn_ = lsn;
+  checkpoint_lsn_ = lsn;
+  async_lsn_ = lsn;
+  file_nos_.clear();
+  committing_trx_.clear();
+  buffer_pool_ = &buffer_pool;
+  recovered_trx_id_ = max_trx_id;
+  recovered_commits_.swap(commits);
+  trx_recovery_finished_.store(false);
+  stats_.redo_records = redo_records;
+  stopping_ = false;
+  checkpoint_requested_ = false;
+  enabled_.store(true, std::memory_order_release);
+  checkpoint_thread_ = std::thread(&CLogManager::checkpoint_thread, this);
+  flush_thread_ = std::thread(&CLogManager::flush_thread, this);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  LOG_INFO("Recover from redo log %s. lsn=%lld, records=%ld, threads=%d, max trx id=%d, committing trx=%d, "
+           "crashed=%d, time=%.3fs",
+           file_name_.c_str(), (long long)lsn, redo_records, std::max(1, options_.recovery_threads), max_trx_id,
+           (int)recovered_commits_.size(), crashed_, elapsed.count());
+  return RC::SUCCESS;
+}
@@ -0,0 +1,295 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_CLOG_CLOG_H_
+#define __OBSERVER_STORAGE_CLOG_CLOG_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "rc.h"
+#include "storage/default/disk_buffer_pool.h"
+
+/**
+ * redo日志的参数，由DefaultStorageStage根据配置文件设置
+ */
+struct CLogOptions {
+  size_t buffer_size = 4 * 1024 * 1024;  // 内存中日志缓冲区的大小，写满后追加日志的线程负责写出
+  int    commit_delay = 0;               // 组提交的leader写文件之前等待其它事务加入的时间(微秒)
+  size_t checkpoint_size = 64 * 1024 * 1024;  // 上一个检查点之后的日志超过这个大小时在后台做检查点，0表示只在关闭时做
+  int    recovery_threads = 4;           // 恢复时并行重放页面修改的线程数
+  int    async_commit_delay = 10;        // 异步提交的COMMIT日志最迟多少毫秒之后落盘
+  int    checkpoint_flush_rate = 1000;   // 后台检查点每秒最多写回的脏页数，0表示不限速
+  int    checkpoint_max_pause = 1000;    // 检查点每次持有缓冲池的锁写回脏页的最长时间(微秒)，0表示不限制
+
+  static CLogOptions &instance();
+};
+
+/**
+ * 日志类型。页面上的修改都是物理到页、页内逻辑的(physiological)，
+ * 重做时只依赖日志本身和页面上被修改的部分，按顺序重放多次的结果不变
+ */
+enum class CLogType : int {
+  FILE_CREATE = 1,    // 创建文件，数据是文件名。同名的文件删除后重建时，重放到这里要把文件清空
+  FILE_NAME,          // 给文件分配日志中使用的编号，数据是文件名。同一个文件只在第一次修改前记一次
+  PAGE_ALLOCATE,      // 分配页面，文件头的页面位图中置位
+  PAGE_DISPOSE,       // 释放页面
+  PAGE_WRITE,         // 把数据写到页面数据区offset开始的位置，B+树节点和文件头使用
+  RECORD_PAGE_INIT,   // 初始化记录页面，offset是记录的长度
+  RECORD_INSERT,      // 在offset号槽插入记录，数据是记录内容
+  RECORD_UPDATE,      // 更新offset号槽上的记录
+  RECORD_DELETE,      // 删除offset号槽上的记录
+  COMMIT,             // 事务提交，落盘之后事务才算提交
+  TRX_END,            // 已提交事务在记录上的事务号都已经改成提交时间戳，恢复时不用再处理这个事务
+};
+
+const char *clog_type_name(CLogType type);
+
+/**
+ * 日志文件中每条日志的头部，后面紧跟data_len字节的数据
+ */
+struct CLogRecordHeader {
+  int32_t  length;     // 整条日志的长度，包括头部
+  uint32_t checksum;   // 头部(checksum按0计算)和数据的CRC32，用来发现崩溃时没有写完整的日志
+  int32_t  type;
+  int32_t  trx_id;
+  int32_t  file_no;    // FILE_NAME日志分配的文件编号，0表示与文件无关
+  PageNum  page_num;
+  int32_t  offset;     // 含义见CLogType
+  int32_t  data_len;
+};
+
+struct CLogStats {
+  long appends = 0;        // 追加的日志条数
+  long bytes = 0;          // 追加的日志字节数
+  long commits = 0;        // COMMIT日志条数
+  long syncs = 0;          // fdatasync的次数，与commits的比值就是组提交的平均大小
+  long checkpoints = 0;     // 检查点的次数
+  long checkpoint_pages = 0;  // 检查点写回的脏页数
+  long async_flushes = 0;   // 后台线程为异步提交落盘的次数
+  long redo_records = 0;   // 上次恢复时重放的日志条数
+};
+
+/**
+ * 在线备份的日志部分，参考CLogManager::begin_backup
+ */
+struct CLogBackup {
+  LSN start_lsn = 0;                    // 备份开始时最近的检查点，恢复从这里开始重放
+  LSN end_lsn = 0;                      // 复制到备份中的日志的结束位置，备份恢复之后是这时的状态
+  std::unordered_set<int32_t> commits;  // 检查点记录的正在提交的事务
+};
+
+/**
+ * redo日志(WAL)。所有对数据文件和索引文件页面的修改先追加到内存中的日志缓冲区，
+ * 得到一个LSN(日志结束的位置，单调递增，重启后继续增长)，页面头部记住最后修改它的LSN，
+ * 缓冲池把脏页写回之前先保证对应的日志已经落盘。
+ * 事务提交时追加COMMIT日志并调用sync等待日志落盘。多个事务同时sync时，
+ * 第一个线程成为leader，把缓冲区中所有的日志一次写出并fdatasync，其它线程等待leader完成后一起返回(组提交)。
+ * 异步提交的事务调用commit_async后直接返回，后台线程在async_commit_delay毫秒内把日志写出，
+ * 崩溃时可能丢掉最近提交的事务，但恢复的结果仍然是一致的。
+ *
+ * 日志分段存放，每段的文件名是 <file_name>.<这一段起始的LSN>。检查点切换到新的一段，
+ * 从缓冲池的脏页表中取出在这之前变脏(rec_lsn小于新日志段起始位置)的页面，按(文件, 页面)的顺序分批写回并落盘，
+ * 然后在控制文件 <file_name>.ctl 中记下检查点的LSN，删除之前的日志段。之后才变脏的页面留给下一个检查点。
+ * 后台的检查点按checkpoint_flush_rate限速，每批持有缓冲池的锁不超过checkpoint_max_pause，前台的请求不会被长时间阻塞。
+ * 控制文件中还记录了已经分配出去的最大事务号和崩溃时正在提交的事务，恢复之后用来区分已提交和未提交的事务。
+ *
+ * 启动时调用recover从检查点开始重放日志：一个线程按顺序读日志，按(文件, 页面)把页面修改分给多个线程重放，
+ * 页面上的LSN不小于日志的LSN时跳过。重放之后做一次检查点再开始记录新的日志。
+ * 记录上留下的未提交事务由Db在后台回滚，参考Table::recover_trx。
+ * 正常关闭时在控制文件中做标记，启动时没有这个标记说明上次崩溃了，不记日志的表要清空。
+ * 在线备份时从最近的检查点开始保留日志段，数据文件复制完之后把这段日志和对应的控制文件也复制到备份中，
+ * 备份启动时就像崩溃后一样从检查点开始重放，得到日志结束时的状态。
+ * 没有打开日志时所有的接口都不做任何事情
+ */
+class CLogManager {
+public:
+  CLogManager() = default;
+  ~CLogManager();
+
+  /**
+   * 打开日志，读取控制文件。file_name是日志段和控制文件名字的前缀。
+   * 打开后还要调用recover才会开始记录日志
+   */
+  RC open(const char *file_name, const CLogOptions &options = CLogOptions::instance());
+
+  /**
+   * 做一次检查点，然后关闭日志
+   */
+  RC close();
+
+  /**
+   * 从上一个检查点开始重放日志中的修改，然后做检查点并开始记录日志。
+   * 要在数据文件被打开之前调用，重放时打开的文件在结束时会关闭
+   */
+  RC recover(DiskBufferPool &buffer_pool);
+
+  /**
+   * 切换到新的日志段，把在这之前变脏的页面写回并落盘，然后记录检查点、删除旧的日志段。
+   * throttled为true时按checkpoint_flush_rate限速写回，关闭日志时不再限速
+   */
+  RC checkpoint(bool throttled = false);
+
+  /**
+   * 让后台线程尽快做一次限速的检查点，不等待完成
+   */
+  void request_checkpoint();
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * 追加一条日志
+   * @param file_name 被修改的文件，nullptr表示与文件无关
+   * @param lsn 返回这条日志的LSN，没有记录日志时返回0
+   */
+  RC append(CLogType type, int32_t trx_id, const char *file_name, PageNum page_num, int32_t offset,
+            const char *data, int32_t data_len, LSN *lsn);
+
+  /**
+   * 等待LSN之前的日志落盘
+   */
+  RC sync(LSN lsn);
+
+  /**
+   * 异步提交: 不等待落盘，后台线程在async_commit_delay毫秒内把LSN之前的日志写出。
+   * 之前写日志失败时返回错误
+   */
+  RC commit_async(LSN lsn);
+
+  /**
+   * 在线备份开始时调用。记下最近的检查点，在end_backup之前不删除它之后的日志段。
+   * 这个检查点之前的修改都已经在数据文件中，之后的修改都能从日志中重放
+   */
+  RC begin_backup(CLogBackup &backup);
+
+  /**
+   * 数据文件都复制完之后调用。让日志落盘，把检查点开始到落盘位置的日志段复制成file_name.<LSN>，
+   * 再写一个从检查点恢复的控制文件file_name.ctl，恢复时当作崩溃处理
+   */
+  RC copy_backup_log(CLogBackup &backup, const std::string &file_name);
+
+  /**
+   * 不管备份是否成功都要调用，之后的检查点可以删除保留的日志段
+   */
+  void end_backup(const CLogBackup &backup);
+
+  /**
+   * 上次是不是没有正常关闭，recover之后才有意义
+   */
+  bool crashed() const {
+    return crashed_;
+  }
+
+  /**
+   * 分配事务号之后调用，保证控制文件中记录的最大事务号不小于trx_id。每次多预留一批，减少写控制文件的次数
+   */
+  RC reserve_trx_id(int32_t trx_id);
+
+  /**
+   * 重启之前可能用过的最大事务号。重启后的事务号都比它大，记录上不大于它的事务号都是重启前留下的
+   */
+  int32_t recovered_trx_id() const {
+    return recovered_trx_id_;
+  }
+
+  /**
+   * 重启之前COMMIT日志已经落盘，但是还没有清除完记录上事务号的事务，这些事务要继续完成提交
+   */
+  bool is_recovered_commit(int32_t trx_id) const;
+
+  /**
+   * 重启前的事务都已经处理完，之后的检查点不用再记录它们
+   */
+  void finish_trx_recovery();
+
+  LSN current_lsn();
+  LSN durable_lsn();
+  LSN checkpoint_lsn();
+  CLogStats stats();
+
+private:
+  LSN append_record(CLogType type, int32_t trx_id, int32_t file_no, PageNum page_num, int32_t offset,
+                    const char *data, int32_t data_len);
+  RC flush_buffer(std::unique_lock<std::mutex> &lock);
+  RC write_file(int fd, const char *data, size_t size, off_t offset);
+  std::string segment_file(LSN start_lsn) const;
+  RC list_segments(std::vector<LSN> &segments) const;
+  RC open_segment(LSN start_lsn);
+  RC read_control();
+  RC write_control(LSN checkpoint_lsn, int32_t max_trx_id, const std::unordered_set<int32_t> &commits);
+  RC write_control_file(const std::string &file_name, LSN checkpoint_lsn, int32_t max_trx_id,
+                        const std::unordered_set<int32_t> &commits, bool clean_shutdown);
+  RC copy_segment(LSN start_lsn, off_t size, const std::string &target_file);
+  void remove_segments_before(LSN lsn);
+  RC flush_dirty_pages(LSN checkpoint_lsn, bool throttled);
+  void checkpoint_thread();
+  void flush_thread();
+
+private:
+  std::mutex              lock_;
+  std::condition_variable flushed_cond_;
+  std::condition_variable checkpoint_cond_;
+  std::condition_variable async_cond_;
+  std::atomic<bool>       enabled_{false};
+  bool                    opened_ = false;
+  CLogOptions             options_;
+  std::string             file_name_;
+  int                     fd_ = -1;           // 当前日志段
+  LSN                     segment_lsn_ = 0;   // 当前日志段的起始LSN
+  RC                      io_error_ = RC::SUCCESS;  // 写日志失败后不能再保证持久性，之后的提交都返回错误
+
+  std::vector<char>       buffer_;            // 还没有写出的日志
+  std::vector<char>       flush_buffer_;      // leader正在写出的日志
+  bool                    flushing_ = false;
+  LSN                     current_lsn_ = 0;   // 已经追加的日志的结束位置
+  LSN                     durable_lsn_ = 0;   // 已经落盘的日志的结束位置
+  LSN                     checkpoint_lsn_ = 0;
+  LSN                     async_lsn_ = 0;     // 异步提交的事务要求落盘的位置
+  std::unordered_map<std::string, int> file_nos_;  // 当前日志段中的文件编号
+  std::unordered_set<int32_t> committing_trx_;     // COMMIT之后还没有TRX_END的事务
+  CLogStats               stats_;
+
+  DiskBufferPool         *buffer_pool_ = nullptr;
+  std::thread             checkpoint_thread_;
+  std::thread             flush_thread_;      // 异步提交的日志由它落盘
+  bool                    stopping_ = false;
+  bool                    checkpoint_requested_ = false;
+  std::mutex              checkpoint_lock_;   // 同一时间只做一个检查点
+
+  std::mutex              control_lock_;      // 写控制文件
+  LSN                     control_checkpoint_lsn_ = 0;  // 控制文件中记录的检查点
+  std::atomic<int32_t>    reserved_trx_id_{0};
+  std::unordered_set<int32_t> control_commits_;   // 控制文件中记录的正在提交的事务
+  bool                    control_clean_shutdown_ = false;  // 控制文件中的正常关闭标记，只在close时写成true
+  bool                    crashed_ = false;
+  std::multiset<LSN>      backup_lsns_;       // 正在进行的在线备份开始的检查点，之后的日志段不能删除
+
+  int32_t                 recovered_trx_id_ = 0;
+  std::unordered_set<int32_t> recovered_commits_;
+  std::atomic<bool>       trx_recovery_finished_{false};
+};
+
+CLogManager *theGlobalCLogManager();
+
+#endif //__OBSERVER_STORAGE_CLOG_CLOG_H_
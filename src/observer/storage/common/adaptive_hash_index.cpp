@@ -0,0 +1,141 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include "storage/common/adaptive_hash_index.h"
+
+AdaptiveHashOptions &AdaptiveHashOptions::instance() {
+  static AdaptiveHashOptions options;
+  return options;
+}
+
+AdaptiveHashIndex::AdaptiveHashIndex(size_t memory_limit, int hot_threshold)
+    : shard_memory_limit_(memory_limit / SHARD_NUM), hot_threshold_(hot_threshold < 1 ? 1 : hot_threshold) {
+  for (int i = 0; i < SKETCH_SIZE; i++) {
+    sketch_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * 哈希表节点、LRU链表节点和key本身
+ */
+size_t AdaptiveHashIndex::entry_memory(const std::string &key) {
+  return key.size() + sizeof(std::string) + sizeof(Entry) + 6 * sizeof(void *);
+}
+
+bool AdaptiveHashIndex::lookup(const char *key, int length, Position &position) {
+  std::string key_str(key, length);
+  Shard &s = shard(std::hash<std::string>()(key_str));
+  std::lock_guard<std::mutex> guard(s.mutex);
+  auto iter = s.entries.find(key_str);
+  if (iter == s.entries.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  s.lru.splice(s.lru.begin(), s.lru, iter->second.lru_iter);
+  position = iter->second.position;
+  return true;
+}
+
+/**
+ * 累加这个值的查找次数，达到阈值时返回true并清零
+ */
+bool AdaptiveHashIndex::count_probe(size_t hash) {
+  std::atomic<uint8_t> &counter = sketch_[(hash / SHARD_NUM) % SKETCH_SIZE];
+  uint8_t count = counter.load(std::memory_order_relaxed) + 1;
+  if (count >= hot_threshold_) {
+    counter.store(0, std::memory_order_relaxed);
+    return true;
+  }
+  counter.store(count, std::memory_order_relaxed);
+
+  if (sketch_probes_.fetch_add(1, std::memory_order_relaxed) % (SKETCH_SIZE * 8) == SKETCH_SIZE * 8 - 1) {
+    for (int i = 0; i < SKETCH_SIZE; i++) {
+      sketch_[i].store(sketch_[i].load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+    }
+  }
+  return false;
+}
+
+void AdaptiveHashIndex::record(const char *key, int length, const Position &position) {
+  std::string key_str(key, length);
+  const size_t hash = std::hash<std::string>()(key_str);
+  Shard &s = shard(hash);
+  std::lock_guard<std::mutex> guard(s.mutex);
+  auto iter = s.entries.find(key_str);
+  if (iter != s.entries.end()) {
+    // 记录已经失效后被其它线程重新加入了
+    iter->second.position = position;
+    s.lru.splice(s.lru.begin(), s.lru, iter->second.lru_iter);
+    return;
+  }
+  if (!count_probe(hash)) {
+    return;
+  }
+
+  const size_t memory = entry_memory(key_str);
+  if (memory > shard_memory_limit_) {
+    return;
+  }
+  while (s.memory + memory > shard_memory_limit_ && !s.lru.empty()) {
+    const std::string *victim = s.lru.back();
+    s.memory -= entry_memory(*victim);
+    s.lru.pop_back();
+    s.entries.erase(*victim);
+  }
+
+  auto result = s.entries.emplace(std::move(key_str), Entry());
+  Entry &entry = result.first->second;
+  entry.position = position;
+  s.lru.push_front(&result.first->first);
+  entry.lru_iter = s.lru.begin();
+  s.memory += memory;
+}
+
+void AdaptiveHashIndex::invalidate(const char *key, int length) {
+  std::string key_str(key, length);
+  Shard &s = shard(std::hash<std::string>()(key_str));
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  invalidations_.fetch_add(1, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> guard(s.mutex);
+  auto iter = s.entries.find(key_str);
+  if (iter == s.entries.end()) {
+    return;
+  }
+  s.memory -= entry_memory(iter->first);
+  s.lru.erase(iter->second.lru_iter);
+  s.entries.erase(iter);
+}
+
+void AdaptiveHashIndex::clear() {
+  for (Shard &s : shards_) {
+    std::lock_guard<std::mutex> guard(s.mutex);
+    s.entries.clear();
+    s.lru.clear();
+    s.memory = 0;
+  }
+}
+
+AdaptiveHashStats AdaptiveHashIndex::stats() const {
+  AdaptiveHashStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+  for (const Shard &s : shards_) {
+    std::lock_guard<std::mutex> guard(s.mutex);
+    stats.entries += s.entries.size();
+    stats.memory += s.memory;
+  }
+  return stats;
+}
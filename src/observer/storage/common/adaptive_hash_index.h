@@ -0,0 +1,122 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_ADAPTIVE_HASH_INDEX_H_
+#define __OBSERVER_STORAGE_COMMON_ADAPTIVE_HASH_INDEX_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "storage/default/disk_buffer_pool.h"
+
+/**
+ * 自适应哈希索引的参数，由DefaultStorageStage根据配置文件设置
+ */
+struct AdaptiveHashOptions {
+  size_t memory_limit = 4 * 1024 * 1024;   // 每个索引上的内存上限，0表示不使用自适应哈希索引
+  int    hot_threshold = 4;                // 同一个值从根节点查找多少次之后记录它的位置
+
+  static AdaptiveHashOptions &instance();
+};
+
+struct AdaptiveHashStats {
+  long   hits = 0;            // 直接定位到叶子节点的查找
+  long   misses = 0;          // 没有记录或者记录已经失效，需要从根节点查找
+  long   invalidations = 0;   // 失效的记录
+  long   entries = 0;
+  size_t memory = 0;
+};
+
+/**
+ * B+树上的自适应哈希索引。统计等值查找的值被查找的次数，
+ * 热点值直接映射到它所在的叶子页面和位置，查找时不用从根节点逐层向下。
+ * 记录的位置只是提示，使用者读取叶子节点后需要校验key确实落在这个叶子中；
+ * 叶子分裂、合并或者删除数据后，使用者通过页面的epoch让旧的记录失效。
+ * 内存超过上限时淘汰最久没有使用的记录
+ */
+class AdaptiveHashIndex {
+public:
+  struct Position {
+    PageNum  page_num = -1;
+    int      slot = -1;       // key在叶子节点中的位置
+    uint32_t epoch = 0;       // 记录时叶子页面的epoch
+  };
+
+public:
+  AdaptiveHashIndex(size_t memory_limit, int hot_threshold);
+
+  bool lookup(const char *key, int length, Position &position);
+
+  /**
+   * 从根节点完整地查找一次之后调用。这个值被查找的次数达到阈值后记录它的位置
+   */
+  void record(const char *key, int length, const Position &position);
+
+  /**
+   * lookup返回的位置校验失败，删除这条记录
+   */
+  void invalidate(const char *key, int length);
+
+  void hit() {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void clear();
+
+  AdaptiveHashStats stats() const;
+
+private:
+  struct Entry {
+    Position position;
+    std::list<const std::string *>::iterator lru_iter;
+  };
+
+  /**
+   * 按哈希值分成多个分片，每个分片一把锁，各自维护LRU链表和内存
+   */
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<const std::string *> lru;   // 最近使用的在前面
+    size_t memory = 0;
+  };
+
+  static const int SHARD_NUM = 16;
+  static const int SKETCH_SIZE = 4096;
+
+  Shard &shard(size_t hash) {
+    return shards_[hash % SHARD_NUM];
+  }
+  bool count_probe(size_t hash);
+  static size_t entry_memory(const std::string &key);
+
+private:
+  const size_t shard_memory_limit_;
+  const int hot_threshold_;
+  Shard shards_[SHARD_NUM];
+
+  // 还没有记录的值被查找的次数，按哈希值计数，不同的值可能共用一个计数器。定期减半，冷掉的值不会累积到阈值
+  std::atomic<uint8_t> sketch_[SKETCH_SIZE];
+  std::atomic<long> sketch_probes_{0};
+
+  std::atomic<long> hits_{0};
+  std::atomic<long> misses_{0};
+  std::atomic<long> invalidations_{0};
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_ADAPTIVE_HASH_INDEX_H_
@@ -0,0 +1,200 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+
+#include "storage/common/bloom_filter.h"
+#include "common/log/log.h"
+#include "common/metrics/metrics_registry.h"
+#include "common/metrics/snapshot.h"
+
+// 每个key在块中置7位，7 * 9 = 63，正好用完一个64位的哈希值
+static const int BLOOM_PROBE_NUM = 7;
+static const int BLOOM_PROBE_BITS = 9;
+
+static const char BLOOM_FILE_MAGIC[8] = {'M', 'I', 'N', 'I', 'B', 'L', 'M', '1'};
+
+struct BloomFileHeader {
+  char    magic[8];
+  int64_t tag;
+  int64_t capacity;
+  int64_t block_num;
+  int64_t count;
+  int64_t deleted;
+};
+
+void BloomFilter::init(int64_t capacity) {
+  if (capacity < MIN_CAPACITY) {
+    capacity = MIN_CAPACITY;
+  }
+  const int64_t block_bits = BLOCK_WORDS * 64;
+  capacity_ = capacity;
+  block_num_ = (capacity * BITS_PER_KEY + block_bits - 1) / block_bits;
+  words_.assign(block_num_ * BLOCK_WORDS, 0);
+  count_.store(0, std::memory_order_relaxed);
+  deleted_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t BloomFilter::hash(const char *data, int length) {
+  // FNV-1a，最后再打散一次，高位和低位都要足够随机
+  uint64_t h = 14695981039346656037ULL;
+  for (int i = 0; i < length; i++) {
+    h ^= (uint8_t)data[i];
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+void BloomFilter::add(uint64_t hash) {
+  uint64_t *block = words_.data() + ((hash >> 32) * block_num_ >> 32) * BLOCK_WORDS;
+  uint64_t bits = hash * 0x9e3779b97f4a7c15ULL;
+  for (int i = 0; i < BLOOM_PROBE_NUM; i++, bits >>= BLOOM_PROBE_BITS) {
+    const int bit = bits & (BLOCK_WORDS * 64 - 1);
+    __atomic_fetch_or(&block[bit / 64], (uint64_t)1 << (bit % 64), __ATOMIC_RELAXED);
+  }
+  count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BloomFilter::may_contain(uint64_t hash) const {
+  const uint64_t *block = words_.data() + ((hash >> 32) * block_num_ >> 32) * BLOCK_WORDS;
+  uint64_t bits = hash * 0x9e3779b97f4a7c15ULL;
+  for (int i = 0; i < BLOOM_PROBE_NUM; i++, bits >>= BLOOM_PROBE_BITS) {
+    const int bit = bits & (BLOCK_WORDS * 64 - 1);
+    if ((__atomic_load_n(&block[bit / 64], __ATOMIC_RELAXED) & ((uint64_t)1 << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BloomFilter::serialize(std::ostream &os, int64_t tag) const {
+  BloomFileHeader header;
+  memcpy(header.magic, BLOOM_FILE_MAGIC, sizeof(header.magic));
+  header.tag = tag;
+  header.capacity = capacity_;
+  header.block_num = block_num_;
+  header.count = count();
+  header.deleted = deleted();
+  os.write((const char *)&header, sizeof(header));
+  os.write((const char *)words_.data(), words_.size() * sizeof(uint64_t));
+}
+
+RC BloomFilter::deserialize(std::istream &is, int64_t tag) {
+  BloomFileHeader header;
+  is.read((char *)&header, sizeof(header));
+  if (is.fail() || memcmp(header.magic, BLOOM_FILE_MAGIC, sizeof(header.magic)) != 0 || header.tag != tag ||
+      header.block_num <= 0 || header.block_num * BLOCK_WORDS * 64 < header.capacity * BITS_PER_KEY) {
+    return RC::IOERR_READ;
+  }
+
+  std::vector<uint64_t> words(header.block_num * BLOCK_WORDS);
+  is.read((char *)words.data(), words.size() * sizeof(uint64_t));
+  if (is.gcount() != (std::streamsize)(words.size() * sizeof(uint64_t))) {
+    return RC::IOERR_READ;
+  }
+
+  capacity_ = header.capacity;
+  block_num_ = header.block_num;
+  words_.swap(words);
+  count_.store(header.count, std::memory_order_relaxed);
+  deleted_.store(header.deleted, std::memory_order_relaxed);
+  return RC::SUCCESS;
+}
+
+RC BloomFilter::save(const char *file_name, int64_t tag) const {
+  std::string tmp_file = std::string(file_name) + ".tmp";
+  std::fstream fs;
+  fs.open(tmp_file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!fs.is_open()) {
+    LOG_ERROR("Failed to open file for write. file name=%s, errmsg=%s", tmp_file.c_str(), strerror(errno));
+    return RC::IOERR;
+  }
+  serialize(fs, tag);
+  fs.close();
+  if (fs.fail()) {
+    LOG_ERROR("Failed to write bloom filter to file: %s. sys err=%d:%s", tmp_file.c_str(), errno, strerror(errno));
+    remove(tmp_file.c_str());
+    return RC::IOERR;
+  }
+
+  if (rename(tmp_file.c_str(), file_name) != 0) {
+    LOG_ERROR("Failed to rename tmp bloom filter file (%s) to %s. system error=%d:%s",
+              tmp_file.c_str(), file_name, errno, strerror(errno));
+    remove(tmp_file.c_str());
+    return RC::IOERR;
+  }
+  return RC::SUCCESS;
+}
+
+RC BloomFilter::load(const char *file_name, int64_t tag) {
+  std::fstream fs;
+  fs.open(file_name, std::ios_base::in | std::ios_base::binary);
+  if (!fs.is_open()) {
+    return RC::IOERR_ACCESS;
+  }
+
+  RC rc = deserialize(fs, tag);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("Invalid bloom filter file: %s", file_name);
+  }
+  return rc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static const std::string BLOOM_FILTER_METRIC_TAG = "BplusTree.bloom_filter";
+
+BloomFilterMetric::BloomFilterMetric() {
+  snapshot_value_ = nullptr;
+}
+
+BloomFilterMetric::~BloomFilterMetric() {
+  delete snapshot_value_;
+  snapshot_value_ = nullptr;
+}
+
+void BloomFilterMetric::snapshot() {
+  BloomFilterStats stats;
+  stats.probes = probes.load(std::memory_order_relaxed);
+  stats.negatives = negatives.load(std::memory_order_relaxed);
+  stats.false_positives = false_positives.load(std::memory_order_relaxed);
+
+  std::stringstream ss;
+  ss << "probes=" << stats.probes << ", negatives=" << stats.negatives
+     << ", false_positives=" << stats.false_positives
+     << ", false_positive_rate=" << stats.false_positive_rate();
+  std::string value = ss.str();
+
+  if (snapshot_value_ == nullptr) {
+    snapshot_value_ = new common::SnapshotBasic<std::string>();
+  }
+  ((common::SnapshotBasic<std::string> *)snapshot_value_)->setValue(value);
+}
+
+BloomFilterMetric &bloom_filter_metric() {
+  static BloomFilterMetric *metric = []() {
+    BloomFilterMetric *metric = new BloomFilterMetric();
+    common::get_metrics_registry().register_metric(BLOOM_FILTER_METRIC_TAG, metric);
+    return metric;
+  }();
+  return *metric;
+}
@@ -0,0 +1,125 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_BLOOM_FILTER_H_
+#define __OBSERVER_STORAGE_COMMON_BLOOM_FILTER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "rc.h"
+#include "common/metrics/metric.h"
+
+/**
+ * Bloom过滤器的命中统计
+ */
+struct BloomFilterStats {
+  long probes = 0;            // 查询过滤器的次数
+  long negatives = 0;         // 过滤器判断一定不存在，不用访问B+树
+  long false_positives = 0;   // 过滤器判断可能存在，实际上不存在
+
+  /**
+   * 不存在的值中没有被过滤器挡住的比例
+   */
+  double false_positive_rate() const {
+    long misses = negatives + false_positives;
+    return misses == 0 ? 0 : (double)false_positives / misses;
+  }
+};
+
+/**
+ * 分块的Bloom过滤器。每个key的所有位都落在同一个512位的块中，
+ * 一次查询只访问一个cache line。
+ * 只能添加不能删除，删除的key只记录个数，删除得多了由使用者重建。
+ * add和may_contain可以并发调用
+ */
+class BloomFilter {
+public:
+  static const int BITS_PER_KEY = 10;
+  static const int64_t MIN_CAPACITY = 1024;
+
+public:
+  BloomFilter() = default;
+
+  /**
+   * @param capacity 预计的key个数，按每个key BITS_PER_KEY位分配空间
+   */
+  void init(int64_t capacity);
+
+  static uint64_t hash(const char *data, int length);
+
+  void add(uint64_t hash);
+  bool may_contain(uint64_t hash) const;
+
+  void mark_deleted() {
+    deleted_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  int64_t capacity() const {
+    return capacity_;
+  }
+  int64_t count() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+  int64_t deleted() const {
+    return deleted_.load(std::memory_order_relaxed);
+  }
+  int64_t memory_size() const {
+    return words_.size() * sizeof(uint64_t);
+  }
+
+  /**
+   * 写到file_name中。先写临时文件再改名，不会留下写了一半的文件
+   * @param tag 使用者的格式信息，load时必须一致
+   */
+  RC save(const char *file_name, int64_t tag) const;
+  RC load(const char *file_name, int64_t tag);
+
+  /**
+   * 写到流的当前位置，用于把过滤器嵌在其它文件中
+   */
+  void serialize(std::ostream &os, int64_t tag) const;
+  RC deserialize(std::istream &is, int64_t tag);
+
+private:
+  static const int BLOCK_WORDS = 8;  // 512位，一个cache line
+
+  int64_t               capacity_ = 0;
+  int64_t               block_num_ = 0;
+  std::atomic<int64_t>  count_{0};
+  std::atomic<int64_t>  deleted_{0};
+  std::vector<uint64_t> words_;
+};
+
+/**
+ * 所有B+树索引上Bloom过滤器的累计统计，注册在metrics中，名字是BplusTree.bloom_filter
+ */
+class BloomFilterMetric : public common::Metric {
+public:
+  BloomFilterMetric();
+  ~BloomFilterMetric();
+
+  void snapshot() override;
+
+  std::atomic<long> probes{0};
+  std::atomic<long> negatives{0};
+  std::atomic<long> false_positives{0};
+};
+
+BloomFilterMetric &bloom_filter_metric();
+
+#endif //__OBSERVER_STORAGE_COMMON_BLOOM_FILTER_H_
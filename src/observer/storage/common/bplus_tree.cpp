@@ -11,11 +11,17 @@ See the Mulan PSL v2 for more details. */
 //
 // Created by Longda on 2021/4/13.
 //
+#include <thread>
+#include <algorithm>
+
 #include "storage/common/bplus_tree.h"
 #include "storage/default/disk_buffer_pool.h"
+#include "storage/clog/clog.h"
 #include "rc.h"
 #include "common/log/log.h"
 #include "sql/parser/parse_defs.h"
+#include "storage/common/key_sorter.h"
+#include "storage/common/key_comparator.h"
 
 int float_compare(float f1, float f2) {
   float result = f1 - f2;
@@ -32,11 +38,66 @@ IndexNode * BplusTreeHandler::get_index_node(char *page_data) const {
   return node;
 }
 
-RC BplusTreeHandler::sync() {
-  return disk_buffer_pool_->flush_all_pages(file_id_);
+/**
+ * 前缀压缩格式的节点紧跟在IndexNode之后，布局是:
+ * PrefixNodeHeader | 公共前缀 | key_num个槽 | 内部节点的key_num+1个孩子页号
+ * 每个槽是属性值去掉公共前缀之后的部分加上RID，属性值按slot_len定长存放，末尾的0不存，解码时补回。
+ * 叶子节点中key的RID就是索引项的值，不再单独存放
+ */
+struct PrefixNodeHeader {
+  uint16_t prefix_len;
+  uint16_t slot_len;
+  PageNum  next_page;   // 叶子节点的下一个叶子
+};
+
+static const int PREFIX_NODE_AREA_SIZE =
+    (int)(BP_PAGE_DATA_SIZE - sizeof(IndexFileHeader) - sizeof(IndexNode) - sizeof(PrefixNodeHeader));
+
+static PrefixNodeHeader *prefix_node_header(IndexNode *node) {
+  return (PrefixNodeHeader *)((char *)node + sizeof(IndexNode));
+}
+
+BplusTreeOptions &BplusTreeOptions::instance() {
+  static BplusTreeOptions options;
+  return options;
+}
+
+RC BplusTreeHandler::sync(bool flush_pages) {
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  dispose_deferred_nodes();
+  if (flush_pages) {
+    RC rc = disk_buffer_pool_->flush_all_pages(file_id_);
+    if (rc != SUCCESS) {
+      return rc;
+    }
+  }
+  // 过滤器要在索引页面写回或者日志落盘之后再写出，文件存在时一定包含了崩溃恢复之后索引中的所有key
+  return save_bloom_filter();
+}
+
+RC BplusTreeHandler::flush_file_header() {
+  BPPageHandle page_handle;
+  char *pdata;
+  RC rc = disk_buffer_pool_->get_this_page(file_id_, 1, &page_handle);
+  if(rc!=SUCCESS){
+    LOG_ERROR("Failed to get index file header page. rc=%d:%s", rc, strrc(rc));
+    return rc;
+  }
+  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  memcpy(pdata, &file_header_, sizeof(file_header_));
+  rc = log_page_write(page_handle, pdata, sizeof(file_header_));
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  return disk_buffer_pool_->unpin_page(&page_handle);
 }
 
-RC BplusTreeHandler::create(const char *file_name, AttrType attr_type, int attr_length)
+RC BplusTreeHandler::create(const char *file_name, AttrType attr_type, int attr_length, bool prefix_compression)
 {
   BPPageHandle page_handle;
   IndexNode *root;
@@ -75,10 +136,16 @@ RC BplusTreeHandler::create(const char *file_name, AttrType attr_type, int attr_
   file_header->attr_length = attr_length;
   file_header->key_length = attr_length + sizeof(RID);
   file_header->attr_type = attr_type;
-  file_header->node_num = 1;
+  file_header->node_format = NODE_FORMAT_FIXED;
   file_header->order=((int)BP_PAGE_DATA_SIZE-sizeof(IndexFileHeader)-sizeof(IndexNode))/(attr_length+2*sizeof(RID));
   file_header->root_page = page_num;
+  // 只有按字节比较的类型可以压缩。一个节点至少要放得下4个完整的key，否则分裂时可能找不到分裂点
+  if(prefix_compression && (attr_type == CHARS || attr_type == BYTES) &&
+     4 * (attr_length + (int)sizeof(RID)) + 5 * (int)sizeof(PageNum) <= PREFIX_NODE_AREA_SIZE){
+    file_header->node_format = NODE_FORMAT_PREFIX;
+  }
 
+  memset(pdata + sizeof(IndexFileHeader), 0, BP_PAGE_DATA_SIZE - sizeof(IndexFileHeader));
   root = get_index_node(pdata);
   root->is_leaf = 1;
   root->key_num = 0;
@@ -86,7 +153,7 @@ RC BplusTreeHandler::create(const char *file_name, AttrType attr_type, int attr_
   root->keys = nullptr;
   root->rids = nullptr;
 
-  rc = disk_buffer_pool->mark_dirty(&page_handle);
+  rc = disk_buffer_pool->append_log(file_id, &page_handle, CLogType::PAGE_WRITE, 0, pdata, BP_PAGE_DATA_SIZE);
   if(rc!=SUCCESS){
     return rc;
   }
@@ -98,11 +165,15 @@ RC BplusTreeHandler::create(const char *file_name, AttrType attr_type, int attr_
 
   disk_buffer_pool_ = disk_buffer_pool;
   file_id_ = file_id;
+  file_name_ = file_name;
 
   memcpy(&file_header_, pdata, sizeof(file_header_));
-  header_dirty_ = false;
 
-  return SUCCESS;
+  // 同名的旧索引留下的过滤器不能再用
+  remove(bloom_filter_file(file_name).c_str());
+
+  upper_level_pages_ = BplusTreeOptions::instance().upper_level_pages;
+  return refresh_upper_levels();
 }
 
 RC BplusTreeHandler::open(const char *file_name) {
@@ -128,22 +199,38 @@ RC BplusTreeHandler::open(const char *file_name) {
     return rc;
   }
   memcpy(&file_header_,pdata,sizeof(IndexFileHeader));
-  header_dirty_ = false;
   disk_buffer_pool_ = disk_buffer_pool;
   file_id_ = file_id;
+  file_name_ = file_name;
 
   rc = disk_buffer_pool->unpin_page(&page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
-  return SUCCESS;
+  upper_level_pages_ = BplusTreeOptions::instance().upper_level_pages;
+  return refresh_upper_levels();
+}
+
+BplusTreeHandler::~BplusTreeHandler() {
+  stop_rebalance();
 }
 
 RC BplusTreeHandler::close() {
+  stop_rebalance();
+  RC rc = rebalance();
+  if(rc!=SUCCESS){
+    LOG_WARN("Failed to rebalance index %s before close. rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+  }
   sync();
   disk_buffer_pool_->close_file(file_id_);
   file_id_ = -1;
   disk_buffer_pool_ = nullptr;
+  std::atomic_store(&bloom_filter_, std::shared_ptr<BloomFilter>());
+  bloom_key_length_ = 0;
+  adaptive_hash_.reset();
+  std::atomic_store(&upper_levels_, std::shared_ptr<const UpperLevels>());
+  changed_pages_.clear();
+  deferred_disposes_.clear();
   return RC::SUCCESS;
 }
 
@@ -159,35 +246,17 @@ static int CmpRid(const RID *rid1, const RID *rid2) {
   return 0;
 }
 int CompareKey(const char *pdata, const char *pkey,AttrType attr_type,int attr_length) { // 简化
-  int i1,i2;
-  float f1,f2;
-  const char *s1,*s2;
   switch(attr_type){
     case INTS:
+      return AttrComparator<INTS>::compare(pdata, pkey, attr_length);
     case DATES:
-    {
-      i1 = *(int *) pdata;
-      i2 = *(int *) pkey;
-      if (i1 > i2)
-        return 1;
-      if (i1 < i2)
-        return -1;
-      if (i1 == i2)
-        return 0;
-    }
-      break;
-    case FLOATS: {
-      f1 = *(float *) pdata;
-      f2 = *(float *) pkey;
-      return float_compare(f1, f2);
-    }
-      break;
-    case CHARS: {
-      s1 = pdata;
-      s2 = pkey;
-      return strncmp(s1, s2, attr_length);
-    }
-      break;
+      return AttrComparator<DATES>::compare(pdata, pkey, attr_length);
+    case FLOATS:
+      return AttrComparator<FLOATS>::compare(pdata, pkey, attr_length);
+    case CHARS:
+      return AttrComparator<CHARS>::compare(pdata, pkey, attr_length);
+    case BYTES:
+      return AttrComparator<BYTES>::compare(pdata, pkey, attr_length);
     default:{
       LOG_PANIC("Unknown attr type: %d", attr_type);
     }
@@ -205,13 +274,684 @@ int CmpKey(AttrType attr_type, int attr_length, const char *pdata, const char *p
   return CmpRid(rid1, rid2);
 }
 
+int BplusTreeHandler::upper_bound(const char *keys, int key_num, const char *pkey) const {
+  const int key_length = file_header_.key_length;
+  return dispatch_key_comparator(file_header_.attr_type, file_header_.attr_length,
+                                 [&](const auto &cmp) {
+                                   return binary_search_keys<true>(keys, key_num, key_length, pkey, cmp);
+                                 });
+}
+
+int BplusTreeHandler::lower_bound(const char *keys, int key_num, const char *pkey) const {
+  const int key_length = file_header_.key_length;
+  return dispatch_key_comparator(file_header_.attr_type, file_header_.attr_length,
+                                 [&](const auto &cmp) {
+                                   return binary_search_keys<false>(keys, key_num, key_length, pkey, cmp);
+                                 });
+}
+
+/**
+ * 读者不加锁读取页面时节点头可能是写了一半的，用到的字段都先读到局部变量里，检查合法之后再用
+ */
+static bool prefix_layout_valid(const IndexFileHeader &file_header, bool is_leaf, int key_num, int prefix_len,
+                                int slot_len) {
+  if (key_num < 0 || prefix_len + slot_len > file_header.attr_length) {
+    return false;
+  }
+  long size = prefix_len + (long)key_num * (slot_len + sizeof(RID));
+  if (!is_leaf) {
+    size += (key_num + 1) * sizeof(PageNum);
+  }
+  return size <= PREFIX_NODE_AREA_SIZE;
+}
+
+/**
+ * 属性值去掉末尾的0之后的长度。字符串按strncmp比较，'\0'之后的内容不参与比较，都当作0，
+ * 这样CHARS和BYTES的key都可以按字节比较
+ */
+static int significant_length(AttrType attr_type, const char *attr, int attr_length) {
+  if (attr_type == CHARS) {
+    return strnlen(attr, attr_length);
+  }
+  int length = attr_length;
+  while (length > 0 && attr[length - 1] == 0) {
+    length--;
+  }
+  return length;
+}
+
+/**
+ * 两个属性值的公共前缀长度，a_length/b_length之后的字节当作0。完全相同时返回attr_length
+ */
+static int common_prefix_length(const char *a, int a_length, const char *b, int b_length, int attr_length) {
+  const int length = std::max(a_length, b_length);
+  for (int i = 0; i < length; i++) {
+    char ca = i < a_length ? a[i] : 0;
+    char cb = i < b_length ? b[i] : 0;
+    if (ca != cb) {
+      return i;
+    }
+  }
+  return attr_length;
+}
+
+/**
+ * 依次加入有序的key，计算前缀压缩之后节点的大小
+ */
+class PrefixNodeSizer {
+public:
+  PrefixNodeSizer(AttrType attr_type, int attr_length) : attr_type_(attr_type), attr_length_(attr_length) {
+  }
+
+  void add(const char *key) {
+    const int length = significant_length(attr_type_, key, attr_length_);
+    if (key_num_ == 0) {
+      first_.assign(key, length);
+      common_ = attr_length_;
+    } else if (common_ > 0) {
+      common_ = std::min(common_, common_prefix_length(first_.data(), first_.size(), key, length, attr_length_));
+    }
+    max_length_ = std::max(max_length_, length);
+    key_num_++;
+  }
+
+  int key_num() const {
+    return key_num_;
+  }
+  int prefix_len() const {
+    return std::min(common_, max_length_);
+  }
+  int slot_len() const {
+    return max_length_ - prefix_len();
+  }
+  int size(bool is_leaf) const {
+    int size = prefix_len() + key_num_ * (slot_len() + (int)sizeof(RID));
+    if (!is_leaf) {
+      size += (key_num_ + 1) * sizeof(PageNum);
+    }
+    return size;
+  }
+
+private:
+  AttrType    attr_type_;
+  int         attr_length_;
+  int         key_num_ = 0;
+  int         common_ = 0;
+  int         max_length_ = 0;
+  std::string first_;
+};
+
+/**
+ * 比较槽中的属性值与pkey去掉前缀之后的部分，pkey只有前length个字节有效，后面当作0
+ */
+static int compare_slot(const char *slot, int slot_len, const char *pkey, int length) {
+  const int n = std::max(0, std::min(length, slot_len));
+  int result = memcmp(slot, pkey, n);
+  if (result != 0) {
+    return result;
+  }
+  for (int i = n; i < slot_len; i++) {
+    if (slot[i] != 0) {
+      return 1;
+    }
+  }
+  return length > slot_len ? -1 : 0;
+}
+
+/**
+ * 在前缀压缩的节点上二分查找，不用解码出完整的key。
+ * 先和公共前缀比较一次，前缀不同时pkey比节点中所有的key都大或者都小
+ */
+static int prefix_node_search(const IndexFileHeader &file_header, IndexNode *node, const char *pkey, bool upper) {
+  const PrefixNodeHeader *header = prefix_node_header(node);
+  const int prefix_len = header->prefix_len;
+  const int slot_len = header->slot_len;
+  const char *prefix = (const char *)(header + 1);
+  const int key_num = node->key_num;
+  if (!prefix_layout_valid(file_header, node->is_leaf, key_num, prefix_len, slot_len)) {
+    return 0;
+  }
+  const int length = significant_length(file_header.attr_type, pkey, file_header.attr_length);
+
+  for (int i = 0; i < prefix_len; i++) {
+    unsigned char c = i < length ? pkey[i] : 0;
+    if (c != (unsigned char)prefix[i]) {
+      return c < (unsigned char)prefix[i] ? 0 : key_num;
+    }
+  }
+
+  RID rid;
+  memcpy(&rid, pkey + file_header.attr_length, sizeof(RID));
+  const char *slots = prefix + prefix_len;
+  const int entry_length = slot_len + sizeof(RID);
+  int low = 0;
+  int high = key_num;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    const char *entry = slots + middle * entry_length;
+    int result = compare_slot(entry, slot_len, pkey + prefix_len, length - prefix_len);
+    if (result == 0) {
+      RID entry_rid;
+      memcpy(&entry_rid, entry + slot_len, sizeof(RID));
+      result = CmpRid(&entry_rid, &rid);
+    }
+    if (upper ? result > 0 : result >= 0) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+/**
+ * 把前缀压缩的节点中的key_num个key解码成完整的key。内部节点的孩子不在这里解码
+ */
+static void decode_prefix_keys(const IndexFileHeader &file_header, IndexNode *node, int key_num, int prefix_len,
+                               int slot_len, char *keys, RID *rids) {
+  const int attr_length = file_header.attr_length;
+  const char *prefix = (const char *)(prefix_node_header(node) + 1);
+  const char *entry = prefix + prefix_len;
+  for (int i = 0; i < key_num; i++, entry += slot_len + sizeof(RID)) {
+    char *key = keys + i * file_header.key_length;
+    memcpy(key, prefix, prefix_len);
+    memcpy(key + prefix_len, entry, slot_len);
+    memset(key + prefix_len + slot_len, 0, attr_length - prefix_len - slot_len);
+    memcpy(key + attr_length, entry + slot_len, sizeof(RID));
+    if (rids != nullptr) {
+      memcpy(rids + i, entry + slot_len, sizeof(RID));
+    }
+  }
+}
+
+/**
+ * 把src中[key_begin, key_end)的key复制到dst中，内部节点同时复制这些key两边的孩子
+ */
+static void slice_node(const NodeImage &src, int key_begin, int key_end, int key_length, NodeImage &dst) {
+  dst.is_leaf = src.is_leaf;
+  dst.parent = src.parent;
+  dst.next_page = 0;
+  dst.key_num = key_end - key_begin;
+  dst.keys.assign(src.keys.begin() + key_begin * key_length, src.keys.begin() + key_end * key_length);
+  if (src.is_leaf) {
+    dst.rids.assign(src.rids.begin() + key_begin, src.rids.begin() + key_end);
+  } else {
+    dst.rids.assign(src.rids.begin() + key_begin, src.rids.begin() + key_end + 1);
+  }
+}
+
+/**
+ * 从middle开始向两边找第一个两边都放得下的分裂点
+ */
+template <typename Fits>
+static int find_split(int low, int high, int middle, Fits fits) {
+  for (int d = 0; middle - d >= low || middle + d <= high; d++) {
+    if (middle - d >= low && middle - d <= high && fits(middle - d)) {
+      return middle - d;
+    }
+    if (d > 0 && middle + d >= low && middle + d <= high && fits(middle + d)) {
+      return middle + d;
+    }
+  }
+  return -1;
+}
+
+int BplusTreeHandler::node_upper_bound(IndexNode *node, const char *pkey) const {
+  if (prefix_compressed()) {
+    return prefix_node_search(file_header_, node, pkey, true);
+  }
+  return upper_bound(node->keys, node->key_num, pkey);
+}
+
+int BplusTreeHandler::node_lower_bound(IndexNode *node, const char *pkey) const {
+  if (prefix_compressed()) {
+    return prefix_node_search(file_header_, node, pkey, false);
+  }
+  return lower_bound(node->keys, node->key_num, pkey);
+}
+
+PageNum BplusTreeHandler::node_child(IndexNode *node, int index) const {
+  if (prefix_compressed()) {
+    const PrefixNodeHeader *header = prefix_node_header(node);
+    const int key_num = node->key_num;
+    const int prefix_len = header->prefix_len;
+    const int slot_len = header->slot_len;
+    if (!prefix_layout_valid(file_header_, false, key_num, prefix_len, slot_len) || index < 0 || index > key_num) {
+      return BP_INVALID_PAGE_NUM;
+    }
+    PageNum page_num;
+    const char *children = (const char *)(header + 1) + prefix_len + key_num * (slot_len + sizeof(RID));
+    memcpy(&page_num, children + index * sizeof(PageNum), sizeof(PageNum));
+    return page_num;
+  }
+  return node->rids[index].page_num;
+}
+
+bool BplusTreeHandler::node_key(IndexNode *node, int index, char *key) const {
+  const int key_length = file_header_.key_length;
+  const int key_num = node->key_num;
+  if (prefix_compressed()) {
+    const PrefixNodeHeader *header = prefix_node_header(node);
+    const int prefix_len = header->prefix_len;
+    const int slot_len = header->slot_len;
+    if (!prefix_layout_valid(file_header_, node->is_leaf, key_num, prefix_len, slot_len) || index < 0 ||
+        index >= key_num) {
+      return false;
+    }
+    const char *prefix = (const char *)(header + 1);
+    const char *entry = prefix + prefix_len + index * (slot_len + sizeof(RID));
+    memcpy(key, prefix, prefix_len);
+    memcpy(key + prefix_len, entry, slot_len);
+    memset(key + prefix_len + slot_len, 0, file_header_.attr_length - prefix_len - slot_len);
+    memcpy(key + file_header_.attr_length, entry + slot_len, sizeof(RID));
+    return true;
+  }
+  if (key_num < 0 || key_num > file_header_.order - 1 || index < 0 || index >= key_num) {
+    return false;
+  }
+  memcpy(key, node->keys + index * key_length, key_length);
+  return true;
+}
+
+PageNum BplusTreeHandler::leaf_next_page(IndexNode *node) const {
+  if (prefix_compressed()) {
+    return prefix_node_header(node)->next_page;
+  }
+  return node->rids[file_header_.order - 1].page_num;
+}
+
+bool BplusTreeHandler::node_consistent(IndexNode *node) const {
+  const int key_num = node->key_num;
+  if (!prefix_compressed()) {
+    return key_num >= 0 && key_num <= file_header_.order - 1;
+  }
+  const PrefixNodeHeader *header = prefix_node_header(node);
+  return prefix_layout_valid(file_header_, node->is_leaf, key_num, header->prefix_len, header->slot_len);
+}
+
+bool BplusTreeHandler::copy_leaf(IndexNode *node, LeafSnapshot &snapshot) const {
+  const int key_num = node->key_num;
+  if (prefix_compressed()) {
+    const PrefixNodeHeader *header = prefix_node_header(node);
+    const int prefix_len = header->prefix_len;
+    const int slot_len = header->slot_len;
+    if (!prefix_layout_valid(file_header_, true, key_num, prefix_len, slot_len)) {
+      return false;
+    }
+    snapshot.keys.resize((size_t)key_num * file_header_.key_length);
+    snapshot.rids.resize(key_num);
+    decode_prefix_keys(file_header_, node, key_num, prefix_len, slot_len, snapshot.keys.data(), snapshot.rids.data());
+  } else {
+    if (key_num < 0 || key_num > file_header_.order - 1) {
+      return false;
+    }
+    snapshot.keys.resize((size_t)key_num * file_header_.key_length);
+    snapshot.rids.resize(key_num);
+    memcpy(snapshot.keys.data(), node->keys, (size_t)key_num * file_header_.key_length);
+    memcpy(snapshot.rids.data(), node->rids, key_num * sizeof(RID));
+  }
+  snapshot.next_page = leaf_next_page(node);
+  snapshot.key_num = key_num;
+  return true;
+}
+
+void BplusTreeHandler::load_node(IndexNode *node, NodeImage &image) const {
+  const int key_num = node->key_num;
+  image.is_leaf = node->is_leaf != 0;
+  image.parent = node->parent;
+  image.key_num = key_num;
+  image.keys.resize((size_t)key_num * file_header_.key_length);
+  image.rids.resize(image.is_leaf ? key_num : key_num + 1);
+  image.next_page = image.is_leaf ? leaf_next_page(node) : 0;
+  if (!prefix_compressed()) {
+    memcpy(image.keys.data(), node->keys, image.keys.size());
+    memcpy(image.rids.data(), node->rids, image.rids.size() * sizeof(RID));
+    return;
+  }
+
+  const PrefixNodeHeader *header = prefix_node_header(node);
+  decode_prefix_keys(file_header_, node, key_num, header->prefix_len, header->slot_len, image.keys.data(),
+                     image.is_leaf ? image.rids.data() : nullptr);
+  if (!image.is_leaf) {
+    for (int i = 0; i <= key_num; i++) {
+      image.rids[i].page_num = node_child(node, i);
+      image.rids[i].slot_num = BP_INVALID_PAGE_NUM;
+    }
+  }
+}
+
+bool BplusTreeHandler::node_fits(const NodeImage &image) const {
+  if (!prefix_compressed()) {
+    return image.key_num <= file_header_.order - 1;
+  }
+  PrefixNodeSizer sizer(file_header_.attr_type, file_header_.attr_length);
+  for (int i = 0; i < image.key_num; i++) {
+    sizer.add(image.keys.data() + i * file_header_.key_length);
+  }
+  return sizer.size(image.is_leaf) <= PREFIX_NODE_AREA_SIZE;
+}
+
+bool BplusTreeHandler::store_node(const NodeImage &image, IndexNode *node) const {
+  const int key_length = file_header_.key_length;
+  const int attr_length = file_header_.attr_length;
+  if (!prefix_compressed()) {
+    if (!node_fits(image)) {
+      return false;
+    }
+    node->is_leaf = image.is_leaf;
+    node->key_num = image.key_num;
+    node->parent = image.parent;
+    memcpy(node->keys, image.keys.data(), image.keys.size());
+    memcpy(node->rids, image.rids.data(), image.rids.size() * sizeof(RID));
+    if (image.is_leaf) {
+      node->rids[file_header_.order - 1].page_num = image.next_page;
+      node->rids[file_header_.order - 1].slot_num = BP_INVALID_PAGE_NUM;
+    }
+    return true;
+  }
+
+  PrefixNodeSizer sizer(file_header_.attr_type, attr_length);
+  for (int i = 0; i < image.key_num; i++) {
+    sizer.add(image.keys.data() + i * key_length);
+  }
+  if (sizer.size(image.is_leaf) > PREFIX_NODE_AREA_SIZE) {
+    return false;
+  }
+
+  const int prefix_len = sizer.prefix_len();
+  const int slot_len = sizer.slot_len();
+  node->is_leaf = image.is_leaf;
+  node->key_num = image.key_num;
+  node->parent = image.parent;
+  PrefixNodeHeader *header = prefix_node_header(node);
+  header->prefix_len = prefix_len;
+  header->slot_len = slot_len;
+  header->next_page = image.is_leaf ? image.next_page : 0;
+  char *prefix = (char *)(header + 1);
+  if (image.key_num > 0) {
+    memcpy(prefix, image.keys.data(), prefix_len);
+  }
+  char *entry = prefix + prefix_len;
+  for (int i = 0; i < image.key_num; i++, entry += slot_len + sizeof(RID)) {
+    const char *key = image.keys.data() + i * key_length;
+    const int length = significant_length(file_header_.attr_type, key, attr_length);
+    const int copy_length = std::max(0, length - prefix_len);
+    memcpy(entry, key + prefix_len, copy_length);
+    memset(entry + copy_length, 0, slot_len - copy_length);
+    memcpy(entry + slot_len, key + attr_length, sizeof(RID));
+  }
+  if (!image.is_leaf) {
+    for (int i = 0; i <= image.key_num; i++, entry += sizeof(PageNum)) {
+      memcpy(entry, &image.rids[i].page_num, sizeof(PageNum));
+    }
+  }
+  return true;
+}
+
+/**
+ * 定长格式按key的个数判断；前缀压缩格式按占用的空间判断，低于一半算作不满
+ */
+bool BplusTreeHandler::node_underfull(IndexNode *node) const {
+  if (!prefix_compressed()) {
+    const int min_key = node->is_leaf ? file_header_.order / 2 : (file_header_.order + 1) / 2 - 1;
+    return node->key_num < min_key;
+  }
+  const PrefixNodeHeader *header = prefix_node_header(node);
+  int size = header->prefix_len + node->key_num * (header->slot_len + sizeof(RID));
+  if (!node->is_leaf) {
+    size += (node->key_num + 1) * sizeof(PageNum);
+  }
+  return size * 2 < PREFIX_NODE_AREA_SIZE;
+}
+
+bool BplusTreeHandler::node_underfull(const NodeImage &image) const {
+  if (!prefix_compressed()) {
+    const int min_key = image.is_leaf ? file_header_.order / 2 : (file_header_.order + 1) / 2 - 1;
+    return image.key_num < min_key;
+  }
+  PrefixNodeSizer sizer(file_header_.attr_type, file_header_.attr_length);
+  for (int i = 0; i < image.key_num; i++) {
+    sizer.add(image.keys.data() + i * file_header_.key_length);
+  }
+  return sizer.size(image.is_leaf) * 2 < PREFIX_NODE_AREA_SIZE;
+}
+
+/**
+ * 插入pkey之后叶子是否还放得下。前缀压缩格式按插入后前缀只会变短、槽只会变长估算，
+ * 估算的结果不小于实际编码后的大小
+ */
+bool BplusTreeHandler::leaf_has_room(IndexNode *node, const char *pkey) const {
+  if (!prefix_compressed()) {
+    return node->key_num < file_header_.order - 1;
+  }
+  if (node->key_num == 0) {
+    return true;
+  }
+  const PrefixNodeHeader *header = prefix_node_header(node);
+  const int prefix_len = header->prefix_len;
+  const int length = significant_length(file_header_.attr_type, pkey, file_header_.attr_length);
+  const int common = std::min(prefix_len, common_prefix_length((const char *)(header + 1), prefix_len,
+                                                               pkey, length, file_header_.attr_length));
+  const int slot_len = std::max(header->slot_len + prefix_len - common, length - common);
+  return common + (node->key_num + 1) * (slot_len + (int)sizeof(RID)) <= PREFIX_NODE_AREA_SIZE;
+}
+
+/**
+ * 左右两个节点之间的分隔key，需要大于left_last并且不大于right_first。
+ * 前缀压缩格式只保留right_first中与left_last不同的第一个字节为止的前缀，内部节点的key越短扇出越大。
+ * 属性值相同时只能用right_first本身
+ */
+void BplusTreeHandler::make_separator(const char *left_last, const char *right_first, char *separator) const {
+  const int attr_length = file_header_.attr_length;
+  memcpy(separator, right_first, file_header_.key_length);
+  if (!prefix_compressed()) {
+    return;
+  }
+  const int common = common_prefix_length(left_last, significant_length(file_header_.attr_type, left_last, attr_length),
+                                          right_first, significant_length(file_header_.attr_type, right_first, attr_length),
+                                          attr_length);
+  if (common + 1 < attr_length) {
+    memset(separator + common + 1, 0, attr_length - common - 1);
+  }
+}
+
+RC BplusTreeHandler::load_node(PageNum page_num, NodeImage &image) {
+  BPPageHandle page_handle;
+  char *pdata;
+  RC rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
+  if(rc!=SUCCESS){
+    return rc;
+  }
+  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  load_node(get_index_node(pdata), image);
+  return disk_buffer_pool_->unpin_page(&page_handle);
+}
+
+RC BplusTreeHandler::store_node(PageNum page_num, const NodeImage &image) {
+  BPPageHandle page_handle;
+  char *pdata;
+  RC rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
+  if(rc!=SUCCESS){
+    return rc;
+  }
+  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  if(!image.is_leaf){
+    changed_pages_.insert(page_num);
+  }
+  IndexNode *node = get_index_node(pdata);
+  if(!store_node(image, node)){
+    LOG_ERROR("Node is too large for page %d. key_num=%d", page_num, image.key_num);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return RC::RECORD_NOMEM;
+  }
+  rc = log_node(page_handle, node, 0);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  return disk_buffer_pool_->unpin_page(&page_handle);
+}
+
+/**
+ * 分配一个新的节点页面，回收的页面上可能还有旧数据，先清空
+ */
+RC BplusTreeHandler::allocate_node(PageNum *page_num) {
+  BPPageHandle page_handle;
+  char *pdata;
+  RC rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle);
+  if(rc!=SUCCESS){
+    return rc;
+  }
+  disk_buffer_pool_->get_page_num(&page_handle, page_num);
+  changed_pages_.insert(*page_num);
+  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  // 新节点在store_node之前不会被引用，store_node会记下所有用到的部分，清空不需要记日志
+  memset(pdata + sizeof(IndexFileHeader), 0, BP_PAGE_DATA_SIZE - sizeof(IndexFileHeader));
+  rc = disk_buffer_pool_->mark_dirty(&page_handle);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  return disk_buffer_pool_->unpin_page(&page_handle);
+}
+
+PageNum BplusTreeHandler::descend_upper_levels(const char *pkey, std::vector<char> *low) const {
+  std::shared_ptr<const UpperLevels> upper_levels = std::atomic_load(&upper_levels_);
+  if(upper_levels == nullptr){
+    return file_header_.root_page;
+  }
+  PageNum page_num = upper_levels->root_page;
+  auto iter = upper_levels->nodes.find(page_num);
+  while(iter != upper_levels->nodes.end()){
+    const UpperLevelNode &node = *iter->second;
+    int i;
+    if(low != nullptr){
+      i = pkey == nullptr ? node.key_num : lower_bound(node.keys.data(), node.key_num, pkey);
+      if(i > 0){
+        const char *separator = node.keys.data() + (i - 1) * file_header_.key_length;
+        low->assign(separator, separator + file_header_.key_length);
+      }
+    } else {
+      i = pkey == nullptr ? 0 : upper_bound(node.keys.data(), node.key_num, pkey);
+    }
+    page_num = node.children[i];
+    iter = upper_levels->nodes.find(page_num);
+  }
+  return page_num;
+}
+
+RC BplusTreeHandler::refresh_upper_levels() {
+  std::shared_ptr<const UpperLevels> old_levels = std::atomic_load(&upper_levels_);
+  if(upper_level_pages_ <= 0){
+    std::atomic_store(&upper_levels_, std::shared_ptr<const UpperLevels>());
+    changed_pages_.clear();
+    return SUCCESS;
+  }
+  if(old_levels != nullptr && changed_pages_.empty() && old_levels->root_page == file_header_.root_page){
+    return SUCCESS;
+  }
+
+  std::shared_ptr<UpperLevels> upper_levels = std::make_shared<UpperLevels>();
+  upper_levels->root_page = file_header_.root_page;
+  std::vector<PageNum> level_pages(1, file_header_.root_page);
+  std::vector<std::shared_ptr<const UpperLevelNode>> level_nodes;
+  std::vector<PageNum> next_pages;
+  RC rc = SUCCESS;
+  // 按层加入，整层放得下才缓存这一层
+  while(upper_levels->nodes.size() + level_pages.size() <= (size_t)upper_level_pages_){
+    level_nodes.clear();
+    next_pages.clear();
+    bool is_leaf = false;
+    for(PageNum page_num : level_pages){
+      std::shared_ptr<const UpperLevelNode> cached;
+      if(old_levels != nullptr && changed_pages_.count(page_num) == 0){
+        auto iter = old_levels->nodes.find(page_num);
+        if(iter != old_levels->nodes.end()){
+          cached = iter->second;
+        }
+      }
+      if(cached == nullptr){
+        NodeImage image;
+        rc = load_node(page_num, image);
+        if(rc!=SUCCESS){
+          break;
+        }
+        if(image.is_leaf){
+          is_leaf = true;
+          break;
+        }
+        std::shared_ptr<UpperLevelNode> node = std::make_shared<UpperLevelNode>();
+        node->key_num = image.key_num;
+        node->keys.swap(image.keys);
+        for(const RID &child : image.rids){
+          node->children.push_back(child.page_num);
+        }
+        cached = node;
+      }
+      next_pages.insert(next_pages.end(), cached->children.begin(), cached->children.end());
+      level_nodes.push_back(cached);
+    }
+    if(rc!=SUCCESS || is_leaf){
+      break;
+    }
+    for(size_t i = 0; i < level_pages.size(); i++){
+      upper_levels->nodes.emplace(level_pages[i], level_nodes[i]);
+    }
+    upper_levels->levels++;
+    level_pages.swap(next_pages);
+  }
+
+  changed_pages_.clear();
+  if(rc!=SUCCESS){
+    LOG_WARN("Failed to cache upper levels of index %s. rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+    std::atomic_store(&upper_levels_, std::shared_ptr<const UpperLevels>());
+    return rc;
+  }
+  std::atomic_store(&upper_levels_, std::shared_ptr<const UpperLevels>(upper_levels));
+  return SUCCESS;
+}
+
+RC BplusTreeHandler::set_upper_level_pages(int max_pages) {
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  if(nullptr == disk_buffer_pool_){
+    return RC::RECORD_CLOSED;
+  }
+  upper_level_pages_ = max_pages;
+  std::atomic_store(&upper_levels_, std::shared_ptr<const UpperLevels>());
+  return refresh_upper_levels();
+}
+
+int BplusTreeHandler::upper_level_pages() const {
+  std::shared_ptr<const UpperLevels> upper_levels = std::atomic_load(&upper_levels_);
+  return upper_levels == nullptr ? 0 : (int)upper_levels->nodes.size();
+}
+
+int BplusTreeHandler::upper_level_depth() const {
+  std::shared_ptr<const UpperLevels> upper_levels = std::atomic_load(&upper_levels_);
+  return upper_levels == nullptr ? 0 : upper_levels->levels;
+}
+
 RC BplusTreeHandler::find_leaf(const char *pkey,PageNum *leaf_page) {
   RC rc;
   BPPageHandle page_handle;
   IndexNode *node;
   char *pdata;
-  int i,tmp;
-  rc = disk_buffer_pool_->get_this_page(file_id_, file_header_.root_page, &page_handle);
+  int i;
+  // 结构修改过程中缓存已经过期，从根节点开始找
+  const PageNum start_page = changed_pages_.empty() ? descend_upper_levels(pkey) : file_header_.root_page;
+  rc = disk_buffer_pool_->get_this_page(file_id_, start_page, &page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
@@ -222,16 +962,14 @@ RC BplusTreeHandler::find_leaf(const char *pkey,PageNum *leaf_page) {
   }
   node = get_index_node(pdata);
   while(0 == node->is_leaf){
-    for(i = 0; i < node->key_num; i++){
-      tmp = CmpKey(file_header_.attr_type, file_header_.attr_length,pkey,node->keys + i * file_header_.key_length);
-      if(tmp < 0)
-        break;
-    }
+    i = node_upper_bound(node, pkey);
+    // unpin之后页面可能被其它线程换出，先取出孩子节点的页号
+    PageNum child_page = node_child(node, i);
     rc = disk_buffer_pool_->unpin_page(&page_handle);
     if(rc!=SUCCESS){
       return rc;
     }
-    rc = disk_buffer_pool_->get_this_page(file_id_, node->rids[i].page_num, &page_handle);
+    rc = disk_buffer_pool_->get_this_page(file_id_, child_page, &page_handle);
     if(rc!=SUCCESS){
       return rc;
     }
@@ -254,7 +992,7 @@ RC BplusTreeHandler::find_leaf(const char *pkey,PageNum *leaf_page) {
 
 RC BplusTreeHandler::insert_into_leaf(PageNum leaf_page, const char *pkey, const RID *rid)
 {
-  int i,insert_pos,tmp;
+  int i,insert_pos;
   BPPageHandle  page_handle;
   char *pdata;
   char *from,*to;
@@ -271,13 +1009,25 @@ RC BplusTreeHandler::insert_into_leaf(PageNum leaf_page, const char *pkey, const
   }
   node = get_index_node(pdata);
 
-  for(insert_pos = 0; insert_pos < node->key_num; insert_pos++){
-    tmp = CmpKey(file_header_.attr_type, file_header_.attr_length, pkey, node->keys + insert_pos * file_header_.key_length);
-    if (tmp == 0) {
-      return RC::RECORD_DUPLICATE_KEY;
+  if (prefix_compressed()) {
+    rc = insert_into_prefix_leaf(node, pkey);
+    if (rc != SUCCESS) {
+      disk_buffer_pool_->unpin_page(&page_handle);
+      return rc;
     }
-    if(tmp < 0)
-      break;
+    rc = log_node(page_handle, node, 0);
+    if(rc != SUCCESS){
+      disk_buffer_pool_->unpin_page(&page_handle);
+      return rc;
+    }
+    return disk_buffer_pool_->unpin_page(&page_handle);
+  }
+
+  insert_pos = lower_bound(node->keys, node->key_num, pkey);
+  if (insert_pos < node->key_num &&
+      CmpKey(file_header_.attr_type, file_header_.attr_length, pkey, node->keys + insert_pos * file_header_.key_length) == 0) {
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return RC::RECORD_DUPLICATE_KEY;
   }
   for(i = node->key_num; i > insert_pos; i--){
     from = node->keys+(i-1)*file_header_.key_length;
@@ -288,8 +1038,9 @@ RC BplusTreeHandler::insert_into_leaf(PageNum leaf_page, const char *pkey, const
   memcpy(node->keys + insert_pos * file_header_.key_length, pkey, file_header_.key_length);
   memcpy(node->rids + insert_pos, rid, sizeof(RID));
   node->key_num++; //叶子结点增加一条记录
-  rc = disk_buffer_pool_->mark_dirty(&page_handle);
+  rc = log_node(page_handle, node, insert_pos);
   if(rc != SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
     return rc;
   }
   rc = disk_buffer_pool_->unpin_page(&page_handle);
@@ -299,6 +1050,54 @@ RC BplusTreeHandler::insert_into_leaf(PageNum leaf_page, const char *pkey, const
   return SUCCESS;
 }
 
+/**
+ * 在前缀压缩的叶子中插入pkey。pkey带有节点的公共前缀并且放得进现有的槽时直接移动后面的槽插入，
+ * 否则解码整个节点重新编码。调用者已经用leaf_has_room检查过空间
+ */
+RC BplusTreeHandler::insert_into_prefix_leaf(IndexNode *node, const char *pkey) {
+  const int insert_pos = node_lower_bound(node, pkey);
+  if (node_upper_bound(node, pkey) > insert_pos) {
+    return RC::RECORD_DUPLICATE_KEY;
+  }
+
+  PrefixNodeHeader *header = prefix_node_header(node);
+  const int prefix_len = header->prefix_len;
+  const int slot_len = header->slot_len;
+  const int entry_length = slot_len + sizeof(RID);
+  const char *prefix = (const char *)(header + 1);
+  const int length = significant_length(file_header_.attr_type, pkey, file_header_.attr_length);
+  bool in_place = node->key_num > 0 && length <= prefix_len + slot_len &&
+                  prefix_len + (node->key_num + 1) * entry_length <= PREFIX_NODE_AREA_SIZE;
+  for (int i = 0; in_place && i < prefix_len; i++) {
+    in_place = (i < length ? pkey[i] : 0) == prefix[i];
+  }
+
+  if (in_place) {
+    char *entry = (char *)prefix + prefix_len + insert_pos * entry_length;
+    memmove(entry + entry_length, entry, (node->key_num - insert_pos) * entry_length);
+    const int copy_length = std::max(0, length - prefix_len);
+    memcpy(entry, pkey + prefix_len, copy_length);
+    memset(entry + copy_length, 0, slot_len - copy_length);
+    memcpy(entry + slot_len, pkey + file_header_.attr_length, sizeof(RID));
+    node->key_num++;
+    return SUCCESS;
+  }
+
+  const int key_length = file_header_.key_length;
+  NodeImage image;
+  load_node(node, image);
+  image.keys.insert(image.keys.begin() + insert_pos * key_length, pkey, pkey + key_length);
+  RID rid;
+  memcpy(&rid, pkey + file_header_.attr_length, sizeof(RID));
+  image.rids.insert(image.rids.begin() + insert_pos, rid);
+  image.key_num++;
+  if (!store_node(image, node)) {
+    LOG_ERROR("Leaf has no room for new key. key_num=%d", node->key_num);
+    return RC::RECORD_NOMEM;
+  }
+  return SUCCESS;
+}
+
 RC BplusTreeHandler::print() {
   IndexNode *node;
   RC rc;
@@ -322,9 +1121,11 @@ RC BplusTreeHandler::print() {
       return rc;
     }
     node = get_index_node(pdata);
+    NodeImage image;
+    load_node(node, image);
     printf("page_num :%d %d\n",i,node->is_leaf);
-    for(j=0;j<node->key_num&&j<6;j++){
-      printf("keynum :%d rids:page_num :%d,slotnum :%d\n", node->key_num, node->rids[j].page_num, node->rids[j].slot_num);
+    for(j=0;j<image.key_num&&j<6;j++){
+      printf("keynum :%d rids:page_num :%d,slotnum :%d\n", image.key_num, image.rids[j].page_num, image.rids[j].slot_num);
     }
     printf("\n");
     rc = disk_buffer_pool_->unpin_page(&page_handle);
@@ -335,1334 +1136,1643 @@ RC BplusTreeHandler::print() {
   return rc;
 }
 
-RC BplusTreeHandler::insert_into_leaf_after_split(PageNum leaf_page, const char *pkey, const RID *rid) {
-  RC rc;
-  BPPageHandle  page_handle1,page_handle2;
-  IndexNode *leaf,*new_node;
-  PageNum new_page,parent_page;
-  RID *temp_pointers,tmprid;
-  char *temp_keys,*new_key;
-  char *pdata;
-  int insert_pos,split,i,j,tmp;
-
-  rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle1);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_data(&page_handle1, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+bool BplusTreeHandler::validate_tree(int *key_count, int *leaf_count) {
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  std::vector<PageNum> leaves;
+  int leaf_depth = -1;
+  int count = 0;
+  if(!validate_node(file_header_.root_page, -1, nullptr, nullptr, 0, &leaf_depth, leaves, &count)){
+    return false;
+  }
+
+  // 叶子链表需要和中序遍历得到的叶子顺序一致
+  PageNum page_num = leaves.empty() ? 0 : leaves[0];
+  for(size_t i = 0; i < leaves.size(); i++){
+    if(page_num != leaves[i]){
+      LOG_ERROR("Leaf list is broken. expect page %d but got %d", leaves[i], page_num);
+      return false;
+    }
+    BPPageHandle page_handle;
+    char *pdata;
+    if(disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle) != SUCCESS){
+      return false;
+    }
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    page_num = leaf_next_page(get_index_node(pdata));
+    disk_buffer_pool_->unpin_page(&page_handle);
   }
-  leaf = get_index_node(pdata);
-
-  //add a new node
-  rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle2);
-  if(rc!=SUCCESS){
-    return rc;
+  if(page_num != 0){
+    LOG_ERROR("Last leaf has next page %d", page_num);
+    return false;
   }
-
-  rc = disk_buffer_pool_->get_data(&page_handle2, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+  if(key_count != nullptr){
+    *key_count = count;
   }
-  rc = disk_buffer_pool_->get_page_num(&page_handle2, &new_page);
-  if(rc!=SUCCESS){
-    return rc;
+  if(leaf_count != nullptr){
+    *leaf_count = leaves.size();
   }
-  new_node = get_index_node(pdata);
-  new_node->key_num = 0;
-  new_node->is_leaf = 1;
-  new_node->parent = leaf->parent;
-
-  parent_page = leaf->parent;
-
-  // print();
+  return true;
+}
 
-  temp_keys = (char *)malloc(file_header_.key_length*file_header_.order);
-  if(temp_keys == nullptr){
-    LOG_ERROR("Failed to alloc memory for temp key. size=%d", file_header_.key_length*file_header_.order);
-    return RC::NOMEM;
+bool BplusTreeHandler::validate_node(PageNum page_num, PageNum parent, const char *lower, const char *upper,
+                                     int depth, int *leaf_depth, std::vector<PageNum> &leaves, int *key_count) {
+  BPPageHandle page_handle;
+  char *pdata;
+  if(disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle) != SUCCESS){
+    LOG_ERROR("Failed to get page %d", page_num);
+    return false;
+  }
+  disk_buffer_pool_->get_data(&page_handle, &pdata);
+  IndexNode *node = get_index_node(pdata);
+
+  const int key_length = file_header_.key_length;
+  bool valid = node->parent == parent && node_consistent(node);
+  if(!valid){
+    LOG_ERROR("Invalid node %d. parent=%d, expect parent=%d, key_num=%d", page_num, node->parent, parent, node->key_num);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return false;
+  }
+  NodeImage image;
+  load_node(node, image);
+  disk_buffer_pool_->unpin_page(&page_handle);
+
+  const int key_num = image.key_num;
+  const bool is_leaf = image.is_leaf;
+  const std::vector<char> &keys = image.keys;
+  if(!node_fits(image)){
+    LOG_ERROR("Node %d is too large. key_num=%d", page_num, key_num);
+    return false;
+  }
+
+  for(int i = 0; i < key_num; i++){
+    const char *key = keys.data() + i * key_length;
+    if(i > 0 && CmpKey(file_header_.attr_type, file_header_.attr_length, key - key_length, key) >= 0){
+      LOG_ERROR("Keys are not in order in node %d", page_num);
+      return false;
+    }
+    if((lower != nullptr && CmpKey(file_header_.attr_type, file_header_.attr_length, key, lower) < 0) ||
+       (upper != nullptr && CmpKey(file_header_.attr_type, file_header_.attr_length, key, upper) >= 0)){
+      LOG_ERROR("Key out of range in node %d", page_num);
+      return false;
+    }
   }
 
-  temp_pointers = (RID *)malloc((file_header_.order+1)*sizeof(RID));
-  if(temp_pointers == nullptr){
-    LOG_ERROR("Failed to alloc memory for temp pointers. size=%ld", (file_header_.order + 1)* sizeof(RID));
-    free(temp_keys);
-    return RC::NOMEM;
+  if(is_leaf){
+    if(*leaf_depth == -1){
+      *leaf_depth = depth;
+    } else if(*leaf_depth != depth){
+      LOG_ERROR("Leaves are not in the same level. leaf %d, depth %d, expect %d", page_num, depth, *leaf_depth);
+      return false;
+    }
+    leaves.push_back(page_num);
+    *key_count += key_num;
+    return true;
   }
 
-  for(insert_pos=0;insert_pos<leaf->key_num;insert_pos++){
-    tmp=CmpKey(file_header_.attr_type, file_header_.attr_length, pkey, leaf->keys+insert_pos*file_header_.key_length);
-    if(tmp<0)
-      break;
+  if(parent != -1 && key_num == 0){
+    LOG_ERROR("Intern node %d has no key", page_num);
+    return false;
   }
-  for(i=0,j=0;i<leaf->key_num;i++,j++){
-    if(j==insert_pos)
-      j++;
-    memcpy(temp_keys+j*file_header_.key_length,leaf->keys+i*file_header_.key_length,file_header_.key_length);
-    memcpy(temp_pointers+j,leaf->rids+i,sizeof(RID));
+  for(int i = 0; i <= key_num; i++){
+    const char *child_lower = i == 0 ? lower : keys.data() + (i - 1) * key_length;
+    const char *child_upper = i == key_num ? upper : keys.data() + i * key_length;
+    if(!validate_node(image.rids[i].page_num, page_num, child_lower, child_upper, depth + 1, leaf_depth, leaves, key_count)){
+      return false;
+    }
   }
-  memcpy(temp_keys+insert_pos*file_header_.key_length,pkey,file_header_.key_length);
-  memcpy(temp_pointers+insert_pos,rid,sizeof(RID));
-
-  split=file_header_.order/2;
+  return true;
+}
 
-  for(i=0;i<split;i++){
-    memcpy(leaf->keys+i*file_header_.key_length,temp_keys+i*file_header_.key_length,file_header_.key_length);
-    memcpy(leaf->rids+i,temp_pointers+i,sizeof(RID));
-  }
-  leaf->key_num=split;
+RC BplusTreeHandler::insert_into_leaf_after_split(PageNum leaf_page, const char *pkey, const RID *rid) {
+  RC rc;
+  NodeImage leaf,left,right;
+  PageNum new_page;
+  const int key_length = file_header_.key_length;
 
-  for(i=split,j=0;i<file_header_.order;i++,j++){
-    memcpy(new_node->keys+j*file_header_.key_length,temp_keys+i*file_header_.key_length,file_header_.key_length);
-    memcpy(new_node->rids+j,temp_pointers+i,sizeof(RID));
-    new_node->key_num++;
+  bump_page_epoch(leaf_page);
+  rc = load_node(leaf_page, leaf);
+  if(rc!=SUCCESS){
+    return rc;
   }
 
-  free(temp_pointers);
-  free(temp_keys);
+  const int insert_pos = upper_bound(leaf.keys.data(), leaf.key_num, pkey);
+  leaf.keys.insert(leaf.keys.begin() + insert_pos * key_length, pkey, pkey + key_length);
+  leaf.rids.insert(leaf.rids.begin() + insert_pos, *rid);
+  leaf.key_num++;
 
-  memcpy(new_node->rids+file_header_.order-1,leaf->rids+file_header_.order-1,sizeof(RID));
-  tmprid.page_num = new_page;
-  tmprid.slot_num = -1;
-  memcpy(leaf->rids+file_header_.order-1,&tmprid,sizeof(RID));
-
-  new_key=(char *)malloc(file_header_.key_length);
-  if(new_key == nullptr){
-    LOG_ERROR("Failed to alloc memory for new key. size=%d", file_header_.key_length);
-    return RC::NOMEM;
+  // 定长格式左边留order/2个key，前缀压缩格式从中间开始找两边都放得下的位置
+  int split = file_header_.order / 2;
+  if(prefix_compressed()){
+    split = find_split(1, leaf.key_num - 1, leaf.key_num / 2, [&](int s) {
+      slice_node(leaf, 0, s, key_length, left);
+      slice_node(leaf, s, leaf.key_num, key_length, right);
+      return node_fits(left) && node_fits(right);
+    });
+    if(split < 0){
+      LOG_ERROR("Failed to find split point for leaf %d. key_num=%d", leaf_page, leaf.key_num);
+      return RC::RECORD_NOMEM;
+    }
   }
-  memcpy(new_key,new_node->keys,file_header_.key_length);
+  slice_node(leaf, 0, split, key_length, left);
+  slice_node(leaf, split, leaf.key_num, key_length, right);
 
-  rc = disk_buffer_pool_->mark_dirty(&page_handle1);
+  rc = allocate_node(&new_page);
   if(rc!=SUCCESS){
-    free(new_key);
     return rc;
   }
+  right.next_page = leaf.next_page;
+  left.next_page = new_page;
 
-  rc = disk_buffer_pool_->unpin_page(&page_handle1);
-  if(rc!=SUCCESS){
-    free(new_key);
-    return rc;
-  }
+  std::vector<char> new_key(key_length);
+  make_separator(left.keys.data() + (left.key_num - 1) * key_length, right.keys.data(), new_key.data());
 
-  rc = disk_buffer_pool_->mark_dirty(&page_handle2);
-  if(rc!=SUCCESS){
-    free(new_key);
-    return rc;
-  }
-  rc = disk_buffer_pool_->unpin_page(&page_handle2);
+  rc = store_node(new_page, right);
   if(rc!=SUCCESS){
-    free(new_key);
     return rc;
   }
-
-  rc=insert_into_parent(parent_page,leaf_page,new_key,new_page); // 插入失败，应该回滚之前的叶子节点
+  rc = store_node(leaf_page, left);
   if(rc!=SUCCESS){
-    free(new_key);
     return rc;
   }
-  free(new_key);
-  return SUCCESS;
+  return insert_into_parent(leaf.parent, leaf_page, new_key.data(), new_page); // 插入失败，应该回滚之前的叶子节点
 }
 
-RC BplusTreeHandler::insert_intern_node(PageNum parent_page,PageNum left_page,PageNum right_page,const char *pkey) {
-  int i,insert_pos;
-  BPPageHandle page_handle;
-  char *pdata;
-  IndexNode *node;
-  RID rid;
+/**
+ * intern_node中已经插入了新的key，放不下，分成两个节点，中间的key插入到父节点
+ */
+RC BplusTreeHandler::insert_intern_node_after_split(PageNum inter_page, NodeImage &intern_node) {
   RC rc;
+  NodeImage left,right;
+  PageNum new_page;
+  const int key_length = file_header_.key_length;
+
+  // 下标为middle的key移到父节点，定长格式左边留(order+1)/2-1个key
+  int middle = (file_header_.order + 1) / 2 - 1;
+  if(prefix_compressed()){
+    middle = find_split(1, intern_node.key_num - 2, intern_node.key_num / 2, [&](int m) {
+      slice_node(intern_node, 0, m, key_length, left);
+      slice_node(intern_node, m + 1, intern_node.key_num, key_length, right);
+      return node_fits(left) && node_fits(right);
+    });
+    if(middle < 0){
+      LOG_ERROR("Failed to find split point for intern node %d. key_num=%d", inter_page, intern_node.key_num);
+      return RC::RECORD_NOMEM;
+    }
+  }
+  slice_node(intern_node, 0, middle, key_length, left);
+  slice_node(intern_node, middle + 1, intern_node.key_num, key_length, right);
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, parent_page, &page_handle);
+  rc = allocate_node(&new_page);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  rc = store_node(new_page, right);
   if(rc!=SUCCESS){
     return rc;
   }
-
-  node = get_index_node(pdata);
-
-  insert_pos=0;
-  while((insert_pos<=node->key_num)&&(node->rids[insert_pos].page_num != left_page))
-    insert_pos++;
-  for(i=node->key_num;i>insert_pos;i--){
-    memcpy(node->rids+i+1,node->rids+i,sizeof(RID));
-    memcpy(node->keys+i*file_header_.key_length,node->keys+(i-1)*file_header_.key_length,file_header_.key_length);
-  }
-  rid.page_num = right_page;
-  rid.slot_num = BP_INVALID_PAGE_NUM; // change to invalid page num
-  memcpy(node->rids+insert_pos+1,&rid,sizeof(RID));
-  memcpy(node->keys+insert_pos*file_header_.key_length,pkey,file_header_.key_length);
-  node->key_num++;
-  rc = disk_buffer_pool_->mark_dirty(&page_handle);
+  rc = store_node(inter_page, left);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  for(int i=0;i<=right.key_num;i++){
+    rc = set_parent(right.rids[i].page_num, new_page);
+    if(rc!=SUCCESS){
+      return rc;
+    }
   }
-  return SUCCESS;
+
+  return insert_into_parent(intern_node.parent, inter_page, intern_node.keys.data() + middle * key_length, new_page);
 }
 
-RC BplusTreeHandler::insert_intern_node_after_split(PageNum inter_page,PageNum left_page,PageNum right_page,const char *pkey) {
+RC BplusTreeHandler::insert_into_parent(PageNum parent_page, PageNum left_page, const char *pkey,PageNum right_page) {
   RC rc;
-  BPPageHandle page_handle1,page_handle2,child_page_handle;
-  IndexNode *inter_node,*new_node,*child_node;
-  PageNum new_page,child_page,parent_page;
-  RID *temp_pointers,tmprid;
-  char *temp_keys,*new_key;
-  char *pdata;
-  int insert_pos,i,j,split;
-  rc = disk_buffer_pool_->get_this_page(file_id_, inter_page, &page_handle1);
-  if(rc!=SUCCESS){
-    return rc;
+  NodeImage parent;
+  if(parent_page==-1){
+    return insert_into_new_root(left_page,pkey,right_page);
   }
-  rc = disk_buffer_pool_->get_data(&page_handle1, &pdata);
+
+  rc = load_node(parent_page, parent);
   if(rc!=SUCCESS){
     return rc;
   }
+  int insert_pos=0;
+  while((insert_pos<=parent.key_num)&&(parent.rids[insert_pos].page_num != left_page))
+    insert_pos++;
+  RID rid;
+  rid.page_num = right_page;
+  rid.slot_num = BP_INVALID_PAGE_NUM; // change to invalid page num
+  parent.keys.insert(parent.keys.begin() + insert_pos * file_header_.key_length, pkey, pkey + file_header_.key_length);
+  parent.rids.insert(parent.rids.begin() + insert_pos + 1, rid);
+  parent.key_num++;
+
+  if(node_fits(parent)){
+    return store_node(parent_page, parent);
+  }
+  return insert_intern_node_after_split(parent_page, parent);
+}
 
-  inter_node = get_index_node(pdata);
+RC BplusTreeHandler::insert_into_new_root(PageNum left_page, const char *pkey, PageNum right_page) {
+  RC rc;
+  NodeImage root;
+  PageNum root_page;
+  RID rid;
 
-  //add a new node
-  rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle2);
+  rc = allocate_node(&root_page);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle2, &pdata);
+  root.is_leaf=false;
+  root.key_num=1;
+  root.parent=-1;
+  root.keys.assign(pkey, pkey + file_header_.key_length);
+  rid.page_num = left_page;
+  rid.slot_num = -1;
+  root.rids.push_back(rid);
+  rid.page_num = right_page;
+  root.rids.push_back(rid);
+  rc = store_node(root_page, root);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->get_page_num(&page_handle2, &new_page);
+
+  rc = set_parent(left_page, root_page);
   if(rc!=SUCCESS){
     return rc;
   }
-
-  new_node = get_index_node(pdata);
-  new_node->key_num=0;
-  new_node->is_leaf=false;
-  new_node->parent=inter_node->parent;
-
-  parent_page=inter_node->parent;
-
-  // print();
-
-  temp_keys=(char *)malloc(file_header_.key_length*file_header_.order);
-  if(temp_keys == nullptr){
-    LOG_ERROR("Failed to alloc memory for temp keys. size=%d", 
-              file_header_.key_length * file_header_.order);
-    return RC::NOMEM;
+  rc = set_parent(right_page, root_page);
+  if(rc!=SUCCESS){
+    return rc;
   }
+  file_header_.root_page=root_page;
+  return flush_file_header();
+}
 
-  temp_pointers = (RID *)malloc((file_header_.order + 1) * sizeof(RID));
-  if(temp_pointers == nullptr){
-    LOG_ERROR("Failed to alloc memory for temp pointers. size=%ld", 
-              (file_header_.order + 1) * sizeof(RID));
-    free(temp_keys);
-    return RC::NOMEM;
+RC BplusTreeHandler::insert_entry(const char *pkey, const RID *rid) {
+  RC rc;
+  PageNum leaf_page;
+  BPPageHandle page_handle;
+  char *pdata,*key;
+  IndexNode *leaf;
+  if(nullptr == disk_buffer_pool_){
+    return RC::RECORD_CLOSED;
   }
-
-  new_key=(char *)malloc(file_header_.key_length);
-  if(new_key==nullptr){
-    LOG_ERROR("Failed to alloc memory for new key. size=%d", file_header_.key_length);
-    free(temp_keys);
-    free(temp_pointers);
+  key=(char *)malloc(file_header_.key_length);
+  if(key == nullptr){
+    LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
     return RC::NOMEM;
   }
+  memcpy(key,pkey,file_header_.attr_length);
+  memcpy(key + file_header_.attr_length, rid, sizeof(*rid));
 
-  insert_pos=0;
-  while((insert_pos<=inter_node->key_num)&&(inter_node->rids[insert_pos].page_num != left_page))
-    insert_pos++;
-  for(i=0,j=0;i<inter_node->key_num+1;i++,j++){
-    if(j==insert_pos+1)
-      j++;
-    memcpy(temp_pointers+j,inter_node->rids+i,sizeof(RID));
-  }
-  for(i=0,j=0;i<inter_node->key_num;i++,j++){
-    if(j==insert_pos)
-      j++;
-    memcpy(temp_keys+j*file_header_.key_length,inter_node->keys+i*file_header_.key_length,file_header_.key_length);
-  }
-  tmprid.page_num = right_page;
-  tmprid.slot_num = -1;
-  memcpy(temp_keys+insert_pos*file_header_.key_length,pkey,file_header_.key_length);
-  memcpy(temp_pointers+insert_pos+1,&tmprid,sizeof(RID));
-
-  split=(file_header_.order+1)/2;
-
-  for(i=0;i<split-1;i++){
-    memcpy(inter_node->keys+i*file_header_.key_length,temp_keys+i*file_header_.key_length,file_header_.key_length);
-    memcpy(inter_node->rids+i,temp_pointers+i,sizeof(RID));
+  bool done = false;
+  rc = insert_entry_optimistic(key, rid, &done);
+  if(rc!=SUCCESS || done){
+    free(key);
+    if(rc==SUCCESS){
+      rebuild_bloom_filter_if_full();
+    }
+    return rc;
   }
-  inter_node->key_num=split-1;
-  memcpy(inter_node->rids+i,temp_pointers+i,sizeof(RID));
-  memcpy(new_key,temp_keys+i*file_header_.key_length,file_header_.key_length);
 
-  for(++i,j=0;i<file_header_.order;i++,j++){
-    memcpy(new_node->keys+j*file_header_.key_length,temp_keys+i*file_header_.key_length,file_header_.key_length);
-    memcpy(new_node->rids+j,temp_pointers+i,sizeof(RID));
-    new_node->key_num++;
+  // 叶子节点需要分裂，独占整棵树
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  add_to_bloom_filter(key);
+  tree_latch_.write_lock();
+  rc= find_leaf(key, &leaf_page);
+  if(rc==SUCCESS){
+    rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle);
   }
-  memcpy(new_node->rids+j,temp_pointers+i,sizeof(RID));
+  if(rc==SUCCESS){
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    leaf = get_index_node(pdata);
+    bool full = !leaf_has_room(leaf, key);
+    disk_buffer_pool_->unpin_page(&page_handle);
 
-  free(temp_keys);
-  free(temp_pointers);
+    // print();
 
-  for(i=0;i<=new_node->key_num;i++){
-    child_page=new_node->rids[i].page_num;
-    rc = disk_buffer_pool_->get_this_page(file_id_, child_page, &child_page_handle);
-    if(rc!=SUCCESS){
-      free(new_key);
-      return rc;
-    }
-    rc = disk_buffer_pool_->get_data(&child_page_handle, &pdata);
-    if(rc!=SUCCESS){
-      free(new_key);
-      return rc;
+    if(full){
+      rc=insert_into_leaf_after_split(leaf_page,key,rid);
     }
-    child_node=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-    child_node->parent=new_page;
-    rc = disk_buffer_pool_->mark_dirty(&child_page_handle);
-    if(rc!=SUCCESS){
-      free(new_key);
-      return rc;
-    }
-    rc = disk_buffer_pool_->unpin_page(&child_page_handle);
-    if(rc!=SUCCESS){
-      free(new_key);
-      return rc;
+    else{
+      rc=insert_into_leaf(leaf_page,key,rid);
     }
   }
+  refresh_upper_levels();
+  tree_latch_.write_unlock();
+  smo_guard.unlock();
+  free(key);
+  if(rc==SUCCESS){
+    rebuild_bloom_filter_if_full();
+  }
+  return rc;
+}
+
+/**
+ * 不需要分裂时，只锁住叶子节点插入
+ */
+RC BplusTreeHandler::insert_entry_optimistic(const char *pkey, const RID *rid, bool *done) {
+  RC rc;
+  PageNum leaf_page;
+  BPPageHandle page_handle;
+  char *pdata;
+  IndexNode *leaf;
 
-  rc = disk_buffer_pool_->mark_dirty(&page_handle1);
+  *done = false;
+  std::shared_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  // 先加入过滤器再插入，读者在树中看到这个key时过滤器中一定也有
+  add_to_bloom_filter(pkey);
+  rc = find_leaf(pkey, &leaf_page);
   if(rc!=SUCCESS){
-    free(new_key);
     return rc;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle1);
+
+  VersionLatch &latch = page_latch(leaf_page);
+  latch.write_lock();
+  rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle);
   if(rc!=SUCCESS){
-    free(new_key);
+    latch.write_unlock();
     return rc;
   }
-  rc = disk_buffer_pool_->mark_dirty(&page_handle2);
-  if(rc!=SUCCESS){
-    free(new_key);
-    return rc;
+  disk_buffer_pool_->get_data(&page_handle, &pdata);
+  leaf = get_index_node(pdata);
+  bool full = !leaf_has_room(leaf, pkey);
+  disk_buffer_pool_->unpin_page(&page_handle);
+  if(!full){
+    rc = insert_into_leaf(leaf_page, pkey, rid);
+    *done = true;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle2);
-  if(rc!=SUCCESS){
-    free(new_key);
-    return rc;
+  latch.write_unlock();
+  return rc;
+}
+
+RC BplusTreeHandler::get_entry(const char *pkey,RID *rid) {
+  RC rc;
+  int i;
+  char *key;
+  LeafSnapshot leaf;
+
+  key=(char *)malloc(file_header_.key_length);
+  if(key == nullptr){
+    LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
+    return RC::NOMEM;
   }
-  // print();
+  memcpy(key,pkey,file_header_.attr_length);
+  memcpy(key+file_header_.attr_length,rid,sizeof(RID));
 
-  rc=insert_into_parent(parent_page,inter_page,new_key,new_page);
+  const bool bloom_checked = bloom_key_length_ == file_header_.attr_length;
+  if(!may_contain(key, file_header_.attr_length)){
+    free(key);
+    return RC::RECORD_INVALID_KEY;
+  }
 
-  // print();
+  rc=lookup_leaf(key,file_header_.key_length,leaf,&i);
   if(rc!=SUCCESS){
-    free(new_key);
+    free(key);
     return rc;
   }
-  free(new_key);
-  return SUCCESS;
+
+  rc = RC::RECORD_INVALID_KEY;
+  if(i<leaf.key_num &&
+     CmpKey(file_header_.attr_type, file_header_.attr_length,key,leaf.keys.data()+(i*file_header_.key_length))==0){
+    memcpy(rid,&leaf.rids[i],sizeof(RID));
+    rc = SUCCESS;
+  } else if(bloom_checked){
+    // 相同的属性值按RID排在一起，前后都不是这个值就说明值不存在
+    const char *keys = leaf.keys.data();
+    bool value_found =
+        (i < leaf.key_num && CompareKey(keys + i * file_header_.key_length, key,
+                                        file_header_.attr_type, file_header_.attr_length) == 0) ||
+        (i > 0 && CompareKey(keys + (i - 1) * file_header_.key_length, key,
+                             file_header_.attr_type, file_header_.attr_length) == 0);
+    if(!value_found){
+      record_false_positive();
+    }
+  }
+  free(key);
+  return rc;
 }
 
-RC BplusTreeHandler::insert_into_parent(PageNum parent_page, PageNum left_page, const char *pkey,PageNum right_page) {
-  RC rc;
+/**
+ * 从叶子节点中删除pkey，不做合并
+ */
+RC BplusTreeHandler::delete_entry_from_node(PageNum node_page,const char *pkey) {
   BPPageHandle page_handle;
   IndexNode *node;
   char *pdata;
-  if(parent_page==-1){
-    return insert_into_new_root(left_page,pkey,right_page);
-  }
+  int delete_index,i;
+  RC rc;
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, parent_page, &page_handle);
+  rc = disk_buffer_pool_->get_this_page(file_id_, node_page, &page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
+
   rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
   if(rc!=SUCCESS){
     return rc;
   }
-  node=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-  if(node->key_num<file_header_.order-1){
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      return rc;
+
+  node = get_index_node(pdata);
+
+  if(prefix_compressed()){
+    // 删除之后剩下的key仍然带有原来的前缀，也放得进原来的槽，直接移动后面的槽
+    delete_index = node_lower_bound(node, pkey);
+    if(node_upper_bound(node, pkey) == delete_index){
+      disk_buffer_pool_->unpin_page(&page_handle);
+      return RC::RECORD_INVALID_KEY;
     }
-    return  insert_intern_node(parent_page,left_page,right_page,pkey);
-  }
-  else{
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      return rc;
+    PrefixNodeHeader *header = prefix_node_header(node);
+    const int entry_length = header->slot_len + sizeof(RID);
+    char *entry = (char *)(header + 1) + header->prefix_len + delete_index * entry_length;
+    memmove(entry, entry + entry_length, (node->key_num - delete_index - 1) * entry_length);
+    node->key_num--;
+  } else {
+    delete_index = lower_bound(node->keys, node->key_num, pkey);
+    if(delete_index>=node->key_num ||
+       CmpKey(file_header_.attr_type, file_header_.attr_length, pkey, node->keys+delete_index*file_header_.key_length)!=0){
+      disk_buffer_pool_->unpin_page(&page_handle);
+      return RC::RECORD_INVALID_KEY;
     }
-    return insert_intern_node_after_split(parent_page,left_page,right_page,pkey);
+    i=delete_index;
+    while(i<(node->key_num-1)){
+      memcpy(node->keys+i*file_header_.key_length,node->keys+(i+1)*file_header_.key_length,file_header_.key_length);
+      i++;
+    }
+    for(i=delete_index;i<(node->key_num-1);i++)
+      memcpy(node->rids+i,node->rids+i+1,sizeof(RID));
+    node->key_num--;
   }
-}
 
-RC BplusTreeHandler::insert_into_new_root(PageNum left_page, const char *pkey, PageNum right_page) {
-  RC rc;
-  BPPageHandle page_handle;
-  IndexNode *root,*left,*right;
-  PageNum root_page;
-  RID rid;
-  char *pdata;
-  rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle);
+  rc = log_node(page_handle, node, delete_index);
   if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_page_num(&page_handle, &root_page);
+  rc = disk_buffer_pool_->unpin_page(&page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
 
-  root = get_index_node(pdata);
-  root->is_leaf=false;
-  root->key_num=1;
-  root->parent=-1;
-  memcpy(root->keys,pkey,file_header_.key_length);
-  rid.page_num = left_page;
-  rid.slot_num = -1;
-  memcpy(root->rids,&rid,sizeof(RID));
-  rid.page_num = right_page;
-  rid.slot_num = -1;
-  memcpy(root->rids+1,&rid,sizeof(RID));
+  return SUCCESS;
+}
 
-  rc = disk_buffer_pool_->mark_dirty(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+/**
+ * 把right合并到left中，从parent中删除两者之间的第index个key，然后检查parent是否需要合并。
+ * 前缀压缩的节点合并后可能放不下，这时保持原样
+ */
+RC BplusTreeHandler::coalesce_node(PageNum left_page, NodeImage &left, PageNum right_page, NodeImage &right,
+                                   PageNum parent_page, NodeImage &parent, int index)
+{
+  RC rc;
+  const int key_length = file_header_.key_length;
+  NodeImage merged = left;
+  if(!merged.is_leaf){
+    merged.keys.insert(merged.keys.end(), parent.keys.begin() + index * key_length,
+                       parent.keys.begin() + (index + 1) * key_length);
+    merged.key_num++;
+  }
+  merged.keys.insert(merged.keys.end(), right.keys.begin(), right.keys.end());
+  merged.rids.insert(merged.rids.end(), right.rids.begin(), right.rids.end());
+  merged.key_num += right.key_num;
+  if(merged.is_leaf){
+    merged.next_page = right.next_page;
+  }
+  if(!node_fits(merged)){
+    return SUCCESS;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
+
+  bump_page_epoch(left_page);
+  bump_page_epoch(right_page);
+  rc = store_node(left_page, merged);
   if(rc!=SUCCESS){
     return rc;
   }
+  if(!merged.is_leaf){
+    for(const RID &child : right.rids){
+      rc = set_parent(child.page_num, left_page);
+      if(rc!=SUCCESS){
+        return rc;
+      }
+    }
+  }
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, left_page, &page_handle);
+  // 先让父节点不再指向right，再释放它。否则释放失败时right中的key在left中也有一份
+  parent.keys.erase(parent.keys.begin() + index * key_length, parent.keys.begin() + (index + 1) * key_length);
+  parent.rids.erase(parent.rids.begin() + index + 1);
+  parent.key_num--;
+  rc = store_node(parent_page, parent);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  rc = dispose_node(right_page);
   if(rc!=SUCCESS){
     return rc;
   }
-  left=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-  left->parent=root_page;
+  return rebalance_node(parent_page);
+}
 
-  rc = disk_buffer_pool_->mark_dirty(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+/**
+ * 从兄弟节点借一个key，from_right表示从right借给left，否则从left借给right。
+ * 前缀压缩格式中父节点的分隔key会变，变长之后放不下时不做调整
+ */
+RC BplusTreeHandler::redistribute_nodes(PageNum left_page, NodeImage &left, PageNum right_page, NodeImage &right,
+                                        PageNum parent_page, NodeImage &parent, int index, bool from_right)
+{
+  RC rc;
+  const int key_length = file_header_.key_length;
+  NodeImage new_left = left;
+  NodeImage new_right = right;
+  NodeImage new_parent = parent;
+  char *separator = new_parent.keys.data() + index * key_length;
+  PageNum moved_child = -1;
+
+  if(from_right){
+    if(new_left.is_leaf){
+      new_left.keys.insert(new_left.keys.end(), right.keys.begin(), right.keys.begin() + key_length);
+      new_left.rids.push_back(right.rids[0]);
+    } else {
+      new_left.keys.insert(new_left.keys.end(), separator, separator + key_length);
+      new_left.rids.push_back(right.rids[0]);
+      memcpy(separator, right.keys.data(), key_length);
+      moved_child = right.rids[0].page_num;
+    }
+    new_left.key_num++;
+    new_right.keys.erase(new_right.keys.begin(), new_right.keys.begin() + key_length);
+    new_right.rids.erase(new_right.rids.begin());
+    new_right.key_num--;
+  } else {
+    const char *last_key = left.keys.data() + (left.key_num - 1) * key_length;
+    if(new_right.is_leaf){
+      new_right.keys.insert(new_right.keys.begin(), last_key, last_key + key_length);
+      new_right.rids.insert(new_right.rids.begin(), left.rids.back());
+    } else {
+      new_right.keys.insert(new_right.keys.begin(), separator, separator + key_length);
+      new_right.rids.insert(new_right.rids.begin(), left.rids.back());
+      memcpy(separator, last_key, key_length);
+      moved_child = left.rids.back().page_num;
+    }
+    new_right.key_num++;
+    new_left.keys.resize((left.key_num - 1) * key_length);
+    new_left.rids.pop_back();
+    new_left.key_num--;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  if(new_left.is_leaf){
+    make_separator(new_left.keys.data() + (new_left.key_num - 1) * key_length, new_right.keys.data(), separator);
+  }
+  if(!node_fits(new_left) || !node_fits(new_right) || !node_fits(new_parent)){
+    return SUCCESS;
   }
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, right_page, &page_handle);
+  bump_page_epoch(left_page);
+  bump_page_epoch(right_page);
+  rc = store_node(left_page, new_left);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  rc = store_node(right_page, new_right);
   if(rc!=SUCCESS){
     return rc;
   }
-  right=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-  right->parent=root_page;
-
-  rc = disk_buffer_pool_->mark_dirty(&page_handle);
+  rc = store_node(parent_page, new_parent);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  if(moved_child != -1){
+    rc = set_parent(moved_child, from_right ? left_page : right_page);
   }
-  file_header_.root_page=root_page;
-  header_dirty_ = true;
-  return SUCCESS;
+  return rc;
 }
 
-RC BplusTreeHandler::insert_entry(const char *pkey, const RID *rid) {
+/**
+ * 节点低于半满时与兄弟节点合并或者从兄弟节点借一个key，根节点没有key时降低树的高度。
+ * 需要持有smo_lock_的排他锁
+ */
+RC BplusTreeHandler::rebalance_node(PageNum page_num) {
+  NodeImage node,parent,sibling;
   RC rc;
-  PageNum leaf_page;
-  BPPageHandle page_handle;
-  char *pdata,*key;
-  IndexNode *leaf;
-  if(nullptr == disk_buffer_pool_){
-    return RC::RECORD_CLOSED;
-  }
-  key=(char *)malloc(file_header_.key_length);
-  if(key == nullptr){
-    LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
-    return RC::NOMEM;
-  }
-  memcpy(key,pkey,file_header_.attr_length);
-  memcpy(key + file_header_.attr_length, rid, sizeof(*rid));
-  rc= find_leaf(key, &leaf_page);
+
+  rc = load_node(page_num, node);
   if(rc!=SUCCESS){
-    free(key);
     return rc;
   }
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle);
+  if(node.parent==-1){
+    if(node.key_num==0&&node.is_leaf==false){
+      PageNum child_page = node.rids[0].page_num;
+      rc = set_parent(child_page, -1);
+      if(rc!=SUCCESS){
+        return rc;
+      }
+      file_header_.root_page=child_page;
+      rc = flush_file_header();
+      if(rc!=SUCCESS){
+        return rc;
+      }
+      return dispose_node(page_num);
+    }
+    return SUCCESS;
+  }
+
+  if(!node_underfull(node)){
+    return SUCCESS;
+  }
+
+  const PageNum parent_page = node.parent;
+  rc = load_node(parent_page, parent);
   if(rc!=SUCCESS){
-    free(key);
     return rc;
   }
 
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  int delete_index=0;
+  while(delete_index<=parent.key_num){
+    if((parent.rids[delete_index].page_num) == page_num)
+      break;
+    delete_index++;
+  }
+
+  // 最左边的节点和右兄弟调整，其它节点和左兄弟调整
+  const bool from_right = delete_index == 0;
+  const PageNum sibling_page = from_right ? parent.rids[1].page_num : parent.rids[delete_index-1].page_num;
+  rc = load_node(sibling_page, sibling);
   if(rc!=SUCCESS){
-    free(key);
     return rc;
   }
-  leaf=(IndexNode *)(pdata+sizeof(IndexFileHeader));
 
-  if(leaf->key_num<file_header_.order-1){
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      free(key);
-      return rc;
-    }
-    rc=insert_into_leaf(leaf_page,key,rid);
-    if(rc!=SUCCESS){
-      free(key);
-      return rc;
+  // 兄弟节点借出一个key之后不会低于半满，才从兄弟节点借
+  bool can_lend = false;
+  if(sibling.key_num > 0){
+    NodeImage lent = sibling;
+    const int key_length = file_header_.key_length;
+    if(from_right){
+      lent.keys.erase(lent.keys.begin(), lent.keys.begin() + key_length);
+      lent.rids.erase(lent.rids.begin());
+    } else {
+      lent.keys.resize((lent.key_num - 1) * key_length);
+      lent.rids.pop_back();
     }
-    free(key);
-    return SUCCESS;
+    lent.key_num--;
+    can_lend = !node_underfull(lent);
   }
-  else{
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      free(key);
-      return rc;
-    }
 
-    // print();
-
-    rc=insert_into_leaf_after_split(leaf_page,key,rid);
-    free(key);
-    return SUCCESS;
+  if(from_right){
+    if(can_lend){
+      return redistribute_nodes(page_num, node, sibling_page, sibling, parent_page, parent, 0, true);
+    }
+    return coalesce_node(page_num, node, sibling_page, sibling, parent_page, parent, 0);
+  }
+  if(can_lend){
+    return redistribute_nodes(sibling_page, sibling, page_num, node, parent_page, parent, delete_index-1, false);
   }
+  return coalesce_node(sibling_page, sibling, page_num, node, parent_page, parent, delete_index-1);
 }
 
-RC BplusTreeHandler::get_entry(const char *pkey,RID *rid) {
+RC BplusTreeHandler::delete_entry(const char *data, const RID *rid) {
   RC rc;
   PageNum leaf_page;
   BPPageHandle page_handle;
-  int i;
-  char *pdata,*key;
+  char *pdata,*pkey;
   IndexNode *leaf;
-
-  key=(char *)malloc(file_header_.key_length);
-  if(key == nullptr){
+  pkey=(char *)malloc(file_header_.key_length);
+  if(nullptr == pkey){
     LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
     return RC::NOMEM;
   }
-  memcpy(key,pkey,file_header_.attr_length);
-  memcpy(key+file_header_.attr_length,rid,sizeof(RID));
+  memcpy(pkey,data,file_header_.attr_length);
+  memcpy(pkey + file_header_.attr_length, rid ,sizeof(*rid));
 
-  rc=find_leaf(key,&leaf_page);
-  if(rc!=SUCCESS){
-    free(key);
-    return rc;
+  std::shared_ptr<BloomFilter> bloom_filter = std::atomic_load(&bloom_filter_);
+  if(bloom_filter){
+    bloom_filter->mark_deleted();
   }
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle);
+  // 只锁住叶子节点删除，低于半满的叶子留给后台线程合并，删除不会引起结构修改
+  std::shared_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  rc = find_leaf(pkey, &leaf_page);
   if(rc!=SUCCESS){
-    free(key);
+    free(pkey);
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-  if(rc!=SUCCESS){
-    free(key);
-    return rc;
+
+  VersionLatch &latch = page_latch(leaf_page);
+  latch.write_lock();
+  bump_page_epoch(leaf_page);
+  rc = delete_entry_from_node(leaf_page, pkey);
+  bool underfull = false;
+  if(rc==SUCCESS && disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle)==SUCCESS){
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    leaf = get_index_node(pdata);
+    underfull = leaf->parent != -1 && node_underfull(leaf);
+    disk_buffer_pool_->unpin_page(&page_handle);
   }
+  latch.write_unlock();
+  smo_guard.unlock();
 
-  leaf = get_index_node(pdata);
-  for(i=0;i<leaf->key_num;i++){
-    if(CmpKey(file_header_.attr_type, file_header_.attr_length,key,leaf->keys+(i*file_header_.key_length))==0){
-      memcpy(rid,leaf->rids+i,sizeof(RID));
-      free(key);
-      return SUCCESS;
-    }
+  if(underfull){
+    add_rebalance(leaf_page, pkey);
   }
-  free(key);
-  return RC::RECORD_INVALID_KEY;
+  free(pkey);
+  return rc;
 }
 
-RC BplusTreeHandler::delete_entry_from_node(PageNum node_page,const char *pkey) {
-  BPPageHandle page_handle;
-  IndexNode *node;
-  char *pdata;
-  int delete_index,i,tmp;
-  RC rc;
-
-  rc = disk_buffer_pool_->get_this_page(file_id_, node_page, &page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+void BplusTreeHandler::add_rebalance(PageNum leaf_page, const char *pkey) {
+  std::lock_guard<std::mutex> guard(rebalance_mutex_);
+  if(!rebalance_pending_.emplace(leaf_page, std::string(pkey, file_header_.key_length)).second){
+    return;
   }
-
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+  if(!rebalance_thread_.joinable() && !rebalance_stop_){
+    rebalance_thread_ = std::thread(&BplusTreeHandler::rebalance_work, this);
+  }
+  if(rebalance_pending_.size() == 1){
+    rebalance_cond_.notify_one();
   }
+}
 
-  node = get_index_node(pdata);
+size_t BplusTreeHandler::rebalance_pending() const {
+  std::lock_guard<std::mutex> guard(rebalance_mutex_);
+  return rebalance_pending_.size();
+}
 
-  for(delete_index=0;delete_index<node->key_num;delete_index++){
-    tmp=CmpKey(file_header_.attr_type, file_header_.attr_length, pkey, node->keys+delete_index*file_header_.key_length);
-    if(tmp==0)
-      break;
+/**
+ * 后台线程攒一小段时间的删除再一起合并，每个叶子单独持有一次排他锁，不会长时间阻塞前台的读写
+ */
+void BplusTreeHandler::rebalance_work() {
+  std::unique_lock<std::mutex> lock(rebalance_mutex_);
+  while(!rebalance_stop_){
+    if(rebalance_pending_.empty()){
+      rebalance_cond_.wait(lock);
+      continue;
+    }
+    rebalance_cond_.wait_for(lock, std::chrono::milliseconds(REBALANCE_DELAY_MS), [this]() {
+      return rebalance_stop_;
+    });
+    while(!rebalance_stop_ && !rebalance_pending_.empty()){
+      std::string pkey = std::move(rebalance_pending_.begin()->second);
+      rebalance_pending_.erase(rebalance_pending_.begin());
+      lock.unlock();
+      RC rc = rebalance_leaf(pkey);
+      if(rc!=SUCCESS){
+        LOG_ERROR("Failed to rebalance index %s. rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+      }
+      lock.lock();
+    }
   }
-  if(delete_index>=node->key_num){
-    return RC::RECORD_INVALID_KEY;
+}
+
+void BplusTreeHandler::stop_rebalance() {
+  {
+    std::lock_guard<std::mutex> guard(rebalance_mutex_);
+    rebalance_stop_ = true;
+    rebalance_cond_.notify_all();
   }
-  i=delete_index;
-  while(i<(node->key_num-1)){
-    memcpy(node->keys+i*file_header_.key_length,node->keys+(i+1)*file_header_.key_length,file_header_.key_length);
-    i++;
+  if(rebalance_thread_.joinable()){
+    rebalance_thread_.join();
   }
+  std::lock_guard<std::mutex> guard(rebalance_mutex_);
+  rebalance_stop_ = false;
+}
 
-  if(node->is_leaf)
-    for(i=delete_index;i<(node->key_num-1);i++)
-      memcpy(node->rids+i,node->rids+i+1,sizeof(RID));
-  else
-    for(i=delete_index+1;i<node->key_num;i++)
-      memcpy(node->rids+i,node->rids+i+1,sizeof(RID));
-  node->key_num--;
-
-  rc = disk_buffer_pool_->mark_dirty(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+RC BplusTreeHandler::rebalance() {
+  std::map<PageNum, std::string> pending;
+  {
+    std::lock_guard<std::mutex> guard(rebalance_mutex_);
+    pending.swap(rebalance_pending_);
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  for(const auto &item : pending){
+    RC rc = rebalance_leaf(item.second);
+    if(rc!=SUCCESS){
+      return rc;
+    }
   }
-
   return SUCCESS;
 }
 
-RC BplusTreeHandler::coalesce_node(PageNum leaf_page,PageNum right_page)
-{
-  BPPageHandle left_handle,right_handle,parent_handle,tmphandle;
-  IndexNode *left,*right,*parent,*node;
-  char *pdata,*tmp_key;
-  PageNum parent_page;
-  RC rc;
-  int i,j,k,start;
-
-  rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &left_handle);
-  if(rc!=SUCCESS){
-    return rc;
+/**
+ * 找到pkey当前所在的叶子节点，低于半满就反复合并或者重新分配，直到不再低于半满。
+ * 重新分配每次只从兄弟节点借一个key
+ */
+RC BplusTreeHandler::rebalance_leaf(const std::string &pkey) {
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  if(nullptr == disk_buffer_pool_){
+    return RC::RECORD_CLOSED;
   }
-  rc = disk_buffer_pool_->get_data(&left_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+  tree_latch_.write_lock();
+  RC rc;
+  PageNum last_page = -1;
+  int last_key_num = -1;
+  while(true){
+    PageNum leaf_page;
+    BPPageHandle page_handle;
+    char *pdata;
+    rc = find_leaf(pkey.data(), &leaf_page);
+    if(rc!=SUCCESS){
+      break;
+    }
+    rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &page_handle);
+    if(rc!=SUCCESS){
+      break;
+    }
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    IndexNode *leaf = get_index_node(pdata);
+    bool underfull = leaf->parent != -1 && node_underfull(leaf);
+    const int key_num = leaf->key_num;
+    disk_buffer_pool_->unpin_page(&page_handle);
+    // 前缀压缩的节点可能既不能合并也借不到key，叶子没有变化时不再重试
+    if(!underfull || (leaf_page == last_page && key_num == last_key_num)){
+      break;
+    }
+    last_page = leaf_page;
+    last_key_num = key_num;
+    bump_page_epoch(leaf_page);
+    rc = rebalance_node(leaf_page);
+    if(rc!=SUCCESS){
+      break;
+    }
   }
+  refresh_upper_levels();
+  tree_latch_.write_unlock();
+  return rc;
+}
 
-  left = get_index_node(pdata);
-
-  rc = disk_buffer_pool_->get_this_page(file_id_, right_page, &right_handle);
-  if(rc!=SUCCESS){
-    return rc;
+/**
+ * 释放一个已经从树中摘掉的节点。读者可能正固定着这个页面，这时留到之后再释放
+ */
+RC BplusTreeHandler::dispose_node(PageNum page_num) {
+  bump_page_epoch(page_num);
+  changed_pages_.insert(page_num);
+  dispose_deferred_nodes();
+  RC rc = disk_buffer_pool_->dispose_page(file_id_, page_num);
+  if(rc == RC::BUFFERPOOL_PAGE_PINNED){
+    LOG_TRACE("Index page %d is pinned, dispose it later. index=%s", page_num, file_name_.c_str());
+    deferred_disposes_.push_back(page_num);
+    return SUCCESS;
   }
+  return rc;
+}
 
-  rc = disk_buffer_pool_->get_data(&right_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+/**
+ * 重新释放之前被固定的页面，需要持有smo_lock_的排他锁
+ */
+void BplusTreeHandler::dispose_deferred_nodes() {
+  std::vector<PageNum> still_pinned;
+  for(PageNum page_num : deferred_disposes_){
+    RC rc = disk_buffer_pool_->dispose_page(file_id_, page_num);
+    if(rc == RC::BUFFERPOOL_PAGE_PINNED){
+      still_pinned.push_back(page_num);
+    } else if(rc != SUCCESS){
+      LOG_WARN("Failed to dispose index page %d. index=%s, rc=%d:%s", page_num, file_name_.c_str(), rc, strrc(rc));
+    }
   }
+  deferred_disposes_.swap(still_pinned);
+}
 
-  right = get_index_node(pdata);
-
-  parent_page=left->parent;
-  rc = disk_buffer_pool_->get_this_page(file_id_, parent_page, &parent_handle);
-  if(rc!=SUCCESS){
-    return rc;
+uint64_t VersionLatch::read_begin() const {
+  uint64_t version = version_.load(std::memory_order_acquire);
+  while(version & 1){
+    std::this_thread::yield();
+    version = version_.load(std::memory_order_acquire);
   }
+  return version;
+}
 
-  rc = disk_buffer_pool_->get_data(&parent_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+void VersionLatch::write_lock() {
+  uint64_t version = version_.load(std::memory_order_relaxed);
+  while(true){
+    if((version & 1) == 0 &&
+       version_.compare_exchange_weak(version, version + 1, std::memory_order_acquire)){
+      return;
+    }
+    std::this_thread::yield();
+    version = version_.load(std::memory_order_relaxed);
   }
+}
 
-  parent = get_index_node(pdata);
-
-  for(k=0;k<parent->key_num;k++)
-    if((parent->rids[k].page_num) == leaf_page)
-      break;
-
-  start=left->key_num;
-  if(left->is_leaf==false){
-    memcpy(left->keys+start*file_header_.key_length,parent->keys+k*file_header_.key_length,file_header_.key_length);
-    start++;
-    left->key_num++;
-  }
-  for(i=start,j=0;j<right->key_num;i++,j++){
-    memcpy(left->keys+i*file_header_.key_length,right->keys+j*file_header_.key_length,file_header_.key_length);
-    memcpy(left->rids+i,right->rids+j,sizeof(RID));
-    left->key_num++;
+RC BplusTreeHandler::read_leaf(const char *pkey, LeafSnapshot &snapshot) {
+  RC rc;
+  while(true){
+    uint64_t tree_version = tree_latch_.read_begin();
+    rc = read_leaf_optimistic(pkey, descend_upper_levels(pkey), tree_version, snapshot);
+    if(rc == SUCCESS){
+      return rc;
+    }
+    if(rc != RC::LOCKED_NEED_WAIT && tree_latch_.read_validate(tree_version)){
+      return rc;
+    }
+    // 读取过程中有写者修改了节点，重试
   }
+}
 
-  if(left->is_leaf)
-    memcpy(left->rids+file_header_.order-1,right->rids+file_header_.order-1,sizeof(RID));
-  else{
-    memcpy(left->rids+i,right->rids+j,sizeof(RID));
-
-    for(i=start;i<=left->key_num;i++){
-      rc = disk_buffer_pool_->get_this_page(file_id_, left->rids[i].page_num, &tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->get_data(&tmphandle, &pdata);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      node=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-      node->parent=leaf_page;
-
-      rc = disk_buffer_pool_->mark_dirty(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
+RC BplusTreeHandler::read_prev_leaf(const char *pkey, LeafSnapshot &snapshot, std::vector<char> &low) {
+  RC rc;
+  while(true){
+    uint64_t tree_version = tree_latch_.read_begin();
+    low.clear();
+    PageNum page_num = descend_upper_levels(pkey, &low);
+    rc = read_leaf_optimistic(pkey, page_num, tree_version, snapshot, &low);
+    if(rc == SUCCESS){
+      return rc;
+    }
+    if(rc != RC::LOCKED_NEED_WAIT && tree_latch_.read_validate(tree_version)){
+      return rc;
     }
   }
+}
 
-  tmp_key=(char *)malloc(file_header_.key_length);
-  if(tmp_key== nullptr){
-    LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
-    return RC::NOMEM;
+RC BplusTreeHandler::read_next_leaf(const LeafSnapshot &current, LeafSnapshot &next) {
+  RC rc;
+  while(true){
+    if(!tree_latch_.read_validate(current.tree_version)){
+      return RC::RECORD_NO_MORE_IDX_IN_MEM;
+    }
+    rc = read_leaf_optimistic(nullptr, current.next_page, current.tree_version, next);
+    if(rc == SUCCESS){
+      return rc;
+    }
+    if(!tree_latch_.read_validate(current.tree_version)){
+      return RC::RECORD_NO_MORE_IDX_IN_MEM;
+    }
+    if(rc != RC::LOCKED_NEED_WAIT){
+      return rc;
+    }
   }
-  memcpy(tmp_key,parent->keys+k*file_header_.key_length,file_header_.key_length);
+}
 
-  rc = disk_buffer_pool_->mark_dirty(&left_handle);
-  if(rc!=SUCCESS){
-    free(tmp_key);
-    return rc;
-  }
-  rc = disk_buffer_pool_->unpin_page(&left_handle);
-  if(rc!=SUCCESS){
-    free(tmp_key);
-    return rc;
-  }
-  rc = disk_buffer_pool_->unpin_page(&right_handle);
-  if(rc!=SUCCESS){
-    free(tmp_key);
-    return rc;
-  }
-  rc = disk_buffer_pool_->dispose_page(file_id_, right_page);
-  if(rc!=SUCCESS){
-    free(tmp_key);
+/**
+ * 自适应哈希索引中记录的位置只是提示：页面的epoch没有变化，并且叶子中pkey前后都有key，
+ * 才能确定pkey的位置就在这个叶子中。否则从根节点查找
+ */
+RC BplusTreeHandler::lookup_leaf(const char *pkey, int hash_key_length, LeafSnapshot &snapshot, int *index) {
+  RC rc;
+  if(adaptive_hash_ == nullptr){
+    rc = read_leaf(pkey, snapshot);
+    if(rc == SUCCESS){
+      *index = lower_bound(snapshot.keys.data(), snapshot.key_num, pkey);
+    }
     return rc;
   }
 
-  rc = disk_buffer_pool_->unpin_page(&parent_handle);
-  if(rc!=SUCCESS){
-    free(tmp_key);
-    return rc;
+  // 字符串比较到'\0'为止，后面的字节不参与比较，也不应该出现在哈希索引的key中
+  std::string hash_key;
+  if(file_header_.attr_type == CHARS){
+    const int value_length = std::min(hash_key_length, file_header_.attr_length);
+    hash_key.assign(pkey, strnlen(pkey, value_length));
+    if(hash_key_length > file_header_.attr_length){
+      hash_key.append(pkey + file_header_.attr_length, hash_key_length - file_header_.attr_length);
+    }
+  } else {
+    hash_key.assign(pkey, hash_key_length);
+  }
+
+  const int key_length = file_header_.key_length;
+  AdaptiveHashIndex::Position position;
+  if(adaptive_hash_->lookup(hash_key.data(), hash_key.size(), position)){
+    uint64_t tree_version = tree_latch_.read_begin();
+    if(page_epoch(position.page_num) == position.epoch &&
+       read_leaf_optimistic(pkey, position.page_num, tree_version, snapshot) == SUCCESS){
+      const char *keys = snapshot.keys.data();
+      int i = position.slot;
+      if(i <= 0 || i >= snapshot.key_num ||
+         CmpKey(file_header_.attr_type, file_header_.attr_length, keys + (i - 1) * key_length, pkey) >= 0 ||
+         CmpKey(file_header_.attr_type, file_header_.attr_length, keys + i * key_length, pkey) < 0){
+        i = lower_bound(keys, snapshot.key_num, pkey);
+      }
+      if(i > 0 && i < snapshot.key_num){
+        adaptive_hash_->hit();
+        *index = i;
+        return SUCCESS;
+      }
+    }
+    adaptive_hash_->invalidate(hash_key.data(), hash_key.size());
   }
 
-  rc= delete_entry_internal(parent_page,tmp_key);
-  if(rc!=SUCCESS){
-    free(tmp_key);
+  rc = read_leaf(pkey, snapshot);
+  if(rc != SUCCESS){
     return rc;
   }
-  free(tmp_key);
+  *index = lower_bound(snapshot.keys.data(), snapshot.key_num, pkey);
+  if(*index > 0 && *index < snapshot.key_num){
+    position.page_num = snapshot.page_num;
+    position.slot = *index;
+    position.epoch = page_epoch(snapshot.page_num);
+    // 读取叶子之后树结构变化了，epoch可能已经是变化之后的，不能记录
+    if(tree_latch_.read_validate(snapshot.tree_version)){
+      adaptive_hash_->record(hash_key.data(), hash_key.size(), position);
+    }
+  }
   return SUCCESS;
 }
 
-RC BplusTreeHandler::redistribute_nodes(PageNum leaf_page,PageNum right_page)
-{
-  BPPageHandle left_handle,right_handle,parent_handle,tmphandle;
-  IndexNode *left,*right,*parent,*node;
-  char *pdata;
-  PageNum parent_page;
+/**
+ * 从page_num开始向下找到pkey所在的叶子节点并拷贝出来，pkey为空时一直向左走。
+ * low不为空时是倒序读取，见read_prev_leaf。
+ * 读取期间如果版本号发生变化，返回LOCKED_NEED_WAIT
+ */
+RC BplusTreeHandler::read_leaf_optimistic(const char *pkey, PageNum page_num, uint64_t tree_version,
+                                          LeafSnapshot &snapshot, std::vector<char> *low) {
   RC rc;
-  int min_key,i,k;
-
-  rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &left_handle);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_data(&left_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-
-  left = get_index_node(pdata);
-
-  rc = disk_buffer_pool_->get_this_page(file_id_, right_page, &right_handle);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_data(&right_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
-  }
+  BPPageHandle page_handle;
+  IndexNode *node;
+  char *pdata;
+  for(int depth = 0; depth < 64; depth++){
+    rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
+    if(rc!=SUCCESS){
+      return rc;
+    }
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    node = get_index_node(pdata);
 
-  right = get_index_node(pdata);
+    if(node->is_leaf){
+      VersionLatch &latch = page_latch(page_num);
+      uint64_t page_version = latch.read_begin();
+      if(!copy_leaf(node, snapshot)){
+        disk_buffer_pool_->unpin_page(&page_handle);
+        return RC::LOCKED_NEED_WAIT;
+      }
+      snapshot.page_num = page_num;
+      snapshot.tree_version = tree_version;
+      disk_buffer_pool_->unpin_page(&page_handle);
+      if(!latch.read_validate(page_version) || !tree_latch_.read_validate(tree_version)){
+        return RC::LOCKED_NEED_WAIT;
+      }
+      return SUCCESS;
+    }
 
-  parent_page=left->parent;
-  rc = disk_buffer_pool_->get_this_page(file_id_, parent_page, &parent_handle);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_data(&parent_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+    int i = 0;
+    if(!node_consistent(node)){
+      disk_buffer_pool_->unpin_page(&page_handle);
+      return RC::LOCKED_NEED_WAIT;
+    }
+    if(low != nullptr){
+      // 走到key都小于pkey的最后一个孩子，它的下界是左边的分隔key
+      i = pkey == nullptr ? (int)node->key_num : node_lower_bound(node, pkey);
+      if(i > 0){
+        low->resize(file_header_.key_length);
+        if(!node_key(node, i - 1, low->data())){
+          disk_buffer_pool_->unpin_page(&page_handle);
+          return RC::LOCKED_NEED_WAIT;
+        }
+      }
+    } else if(pkey != nullptr){
+      i = node_upper_bound(node, pkey);
+    }
+    page_num = node_child(node, i);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    if(!tree_latch_.read_validate(tree_version)){
+      return RC::LOCKED_NEED_WAIT;
+    }
   }
+  return RC::LOCKED_NEED_WAIT;
+}
 
-  parent = get_index_node(pdata);
-
-  for(k=0;k<parent->key_num;k++)
-    if(parent->rids[k].page_num == leaf_page)
+RC BplusTreeHandler::print_tree() {
+  LeafSnapshot leaf;
+  RC rc = read_leaf(nullptr, leaf);
+  while(rc == SUCCESS){
+    for(int i=0;i<leaf.key_num;i++){
+      const char *pkey=leaf.keys.data()+i*file_header_.key_length;
+      printf("key : %d,rids (page_num:%d slotnum %d)\n",*(int *)pkey,leaf.rids[i].page_num,leaf.rids[i].slot_num);
+    }
+    printf("next node:%d\n",leaf.next_page);
+    if(leaf.next_page<=0){
       break;
-  if(left->is_leaf){
-    min_key=file_header_.order/2;
-    if(left->key_num<min_key){
-      memcpy(left->keys+left->key_num*file_header_.key_length,right->keys,file_header_.key_length);
-      memcpy(left->rids+left->key_num,right->rids,sizeof(RID));
-      left->key_num++;
-
-      for(i=0;i<right->key_num-1;i++){
-        memcpy(right->keys+i*file_header_.key_length,right->keys+(i+1)*file_header_.key_length,file_header_.key_length);
-        memcpy(right->rids+i,right->rids+i+1,sizeof(RID));
-      }
-      right->key_num--;
-      memcpy(parent->keys+k*file_header_.key_length,right->keys,file_header_.key_length);
     }
-    else{
-      for(i=right->key_num;i>0;i--){
-        memcpy(right->keys+i*file_header_.key_length,right->keys+(i-1)*file_header_.key_length,file_header_.key_length);
-        memcpy(right->rids+i,right->rids+i-1,sizeof(RID));
-      }
-      memcpy(right->keys,left->keys+(left->key_num-1)*file_header_.key_length,file_header_.key_length);
+    LeafSnapshot next;
+    rc = read_next_leaf(leaf, next);
+    std::swap(leaf, next);
+  }
+  return rc;
+}
 
-      left->key_num--;
-      right->key_num++;
-      memcpy(parent->keys+k*file_header_.key_length,right->keys,file_header_.key_length);
+int BplusTreeHandler::height() {
+  std::shared_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  BPPageHandle page_handle;
+  char *pdata;
+  PageNum page_num = file_header_.root_page;
+  for(int height = 1; ; height++){
+    if(disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle) != SUCCESS){
+      return -1;
+    }
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    IndexNode *node = get_index_node(pdata);
+    const bool is_leaf = node->is_leaf;
+    page_num = is_leaf ? 0 : node_child(node, 0);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    if(is_leaf){
+      return height;
     }
   }
-  else{
-    min_key=(file_header_.order+1)/2-1;
-    if(left->key_num<min_key){
-      memcpy(left->keys+left->key_num*file_header_.key_length,parent->keys+k*file_header_.key_length,file_header_.key_length);
-      memcpy(left->rids+left->key_num+1,right->rids,sizeof(RID));
-      left->key_num++;
-
-      memcpy(parent->keys+k*file_header_.key_length,right->keys,file_header_.key_length);
-      for(i=0;i<right->key_num-1;i++){
-        memcpy(right->keys+i*file_header_.key_length,right->keys+(i+1)*file_header_.key_length,file_header_.key_length);
-        memcpy(right->rids+i,right->rids+i+1,sizeof(RID));
-      }
-      right->key_num--;
+}
 
-      rc = disk_buffer_pool_->get_this_page(file_id_, left->rids[left->key_num].page_num,&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->get_data(&tmphandle, &pdata);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      node=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-      node->parent=leaf_page;
-      rc = disk_buffer_pool_->mark_dirty(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-    }
-    else{
-      for(i=right->key_num;i>0;i--){
-        memcpy(right->keys+i*file_header_.key_length,right->keys+(i-1)*file_header_.key_length,file_header_.key_length);
-        memcpy(right->rids+i,right->rids+i-1,sizeof(RID));
-      }
-      memcpy(right->keys,parent->keys+k*file_header_.key_length,file_header_.key_length);
-      memcpy(right->rids,left->rids+left->key_num,sizeof(RID));
+/**
+ * 将count个节点平均分配到node_num个节点上时，第index个节点分到的个数
+ */
+static int bulk_load_node_size(int count, int node_num, int index) {
+  return count / node_num + (index < count % node_num ? 1 : 0);
+}
 
-      right->key_num++;
-      memcpy(parent->keys+k*file_header_.key_length,left->keys+(left->key_num-1)*file_header_.key_length,file_header_.key_length);
-      left->key_num--;
+RC BplusTreeHandler::bulk_load(KeySorter &sorter, float fill_factor) {
+  RC rc;
+  BPPageHandle page_handle;
+  char *pdata;
+  IndexNode *root;
 
-      rc = disk_buffer_pool_->get_this_page(file_id_, right->rids[0].page_num, &tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->get_data(&tmphandle, &pdata);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      node = get_index_node(pdata);
-      node->parent=right_page;
-      rc = disk_buffer_pool_->mark_dirty(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-    }
+  if(nullptr == disk_buffer_pool_){
+    return RC::RECORD_CLOSED;
   }
-  rc = disk_buffer_pool_->mark_dirty(&left_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  if(sorter.key_length() != file_header_.key_length){
+    LOG_ERROR("Key length mismatch. sorter=%d, index=%d", sorter.key_length(), file_header_.key_length);
+    return RC::INVALID_ARGUMENT;
   }
-  rc = disk_buffer_pool_->unpin_page(&left_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  if(fill_factor <= 0 || fill_factor > 1){
+    fill_factor = 1;
   }
 
-  rc = disk_buffer_pool_->mark_dirty(&right_handle);
+  rc = disk_buffer_pool_->get_this_page(file_id_, file_header_.root_page, &page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
-
-  rc = disk_buffer_pool_->unpin_page(&right_handle);
+  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
   if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
     return rc;
   }
-
-  rc = disk_buffer_pool_->mark_dirty(&parent_handle);
+  root = get_index_node(pdata);
+  bool empty = root->is_leaf && root->key_num == 0;
+  rc = disk_buffer_pool_->unpin_page(&page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
-  rc = disk_buffer_pool_->unpin_page(&parent_handle);
-  if(rc!=SUCCESS){
-    return rc;
+  if(!empty){
+    LOG_ERROR("Cannot bulk load into a non-empty index");
+    return RC::MISUSE;
   }
-  return SUCCESS;
-}
-
-RC BplusTreeHandler::delete_entry_internal(PageNum page_num,const char *pkey) {
-  BPPageHandle parent_handle,page_handle,left_handle,right_handle,tmphandle;
-  IndexNode *node,*parent,*left,*right,*tmpnode;
-  PageNum leaf_page,right_page;
-  char *pdata;
-  RC rc;
-  int delete_index,min_key;
-
-  rc=delete_entry_from_node(page_num,pkey);
-  if(rc!=SUCCESS){
-    return rc;
+  if(sorter.size() == 0){
+    return SUCCESS;
   }
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
+  std::vector<PageNum> pages;
+  std::vector<char> separators;
+  rc = bulk_load_leaves(sorter, fill_factor, pages, separators);
   if(rc!=SUCCESS){
+    LOG_ERROR("Failed to build leaf level. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  node = get_index_node(pdata);
-
-  if(node->parent==-1){
-    if(node->key_num==0&&node->is_leaf==false){
-      rc = disk_buffer_pool_->get_this_page(file_id_, node->rids[0].page_num, &tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->get_data(&tmphandle, &pdata);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      tmpnode=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-      tmpnode->parent=-1;
-      rc = disk_buffer_pool_->mark_dirty(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&tmphandle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-
-      file_header_.root_page=node->rids[0].page_num;
-      header_dirty_ = true;
-
-      rc = disk_buffer_pool_->unpin_page(&page_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->dispose_page(file_id_, page_num);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      return SUCCESS;
-    }
-
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      return rc;
-    }
-    return SUCCESS;
-  }
-
-  if(node->is_leaf)
-    min_key=file_header_.order/2;
-  else
-    min_key=(file_header_.order+1)/2-1;
 
-  if(node->key_num>=min_key){
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
+  int level = 1;
+  while(pages.size() > 1){
+    rc = bulk_load_intern_level(fill_factor, pages, separators);
     if(rc!=SUCCESS){
+      LOG_ERROR("Failed to build intern level %d. rc=%d:%s", level, rc, strrc(rc));
       return rc;
     }
-    return SUCCESS;
+    level++;
   }
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, node->parent, &parent_handle);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_data(&parent_handle, &pdata);
+  file_header_.root_page = pages[0];
+  rc = flush_file_header();
   if(rc!=SUCCESS){
     return rc;
   }
+  LOG_INFO("Bulk loaded %lu keys, tree height=%d, root page=%d",
+           sorter.size(), level, file_header_.root_page);
 
-  parent = get_index_node(pdata);
+  if(adaptive_hash_ != nullptr){
+    adaptive_hash_->clear();
+  }
 
-  delete_index=0;
-  while(delete_index<=parent->key_num){
-    if((parent->rids[delete_index].page_num) == page_num)
-      break;
-    delete_index++;
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  std::atomic_store(&upper_levels_, std::shared_ptr<const UpperLevels>());
+  refresh_upper_levels();
+  if(bloom_filter_enabled()){
+    rc = rebuild_bloom_filter();
   }
+  return rc;
+}
 
-  if(delete_index==0){
-    leaf_page=page_num;
-    right_page=parent->rids[delete_index+1].page_num;
-    rc = disk_buffer_pool_->get_this_page(file_id_, right_page, &right_handle);
-    if(rc!=SUCCESS){
-      return rc;
-    }
-    rc = disk_buffer_pool_->get_data(&right_handle, &pdata);
-    if(rc!=SUCCESS){
-      return rc;
-    }
-    right=(IndexNode *)(pdata+sizeof(IndexFileHeader));
+/**
+ * 构建叶子层。第一个叶子复用当前的根节点页面。
+ * 定长格式把key平均分到各个叶子上；前缀压缩格式依次填充，压缩后的大小超过fill_factor时换下一个叶子。
+ * pages返回每个叶子的页面号，separators返回每个叶子与前一个叶子之间的分隔key，用于构建上一层，
+ * 第一个叶子对应的是它最小的key
+ */
+RC BplusTreeHandler::bulk_load_leaves(KeySorter &sorter, float fill_factor,
+                                      std::vector<PageNum> &pages, std::vector<char> &separators) {
+  RC rc;
+  PageNum page_num, next_page_num;
+  NodeImage leaf;
+  RID rid;
+  const char *key;
 
-    if(right->key_num>min_key){
-      rc = disk_buffer_pool_->unpin_page(&page_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&parent_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&right_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      return redistribute_nodes(page_num,right_page);
-    }
-    else{
-      rc = disk_buffer_pool_->unpin_page(&page_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&parent_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&right_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      return coalesce_node(page_num,right_page);
-    }
+  const int key_length = file_header_.key_length;
+  const int total = (int)sorter.size();
+  int leaf_capacity = (int)((file_header_.order - 1) * fill_factor);
+  if(leaf_capacity < 1){
+    leaf_capacity = 1;
   }
-  else{
-    leaf_page=parent->rids[delete_index-1].page_num;
-    rc = disk_buffer_pool_->get_this_page(file_id_, leaf_page, &left_handle);
+  const int leaf_num = (total + leaf_capacity - 1) / leaf_capacity;
+  const int size_limit = (int)(PREFIX_NODE_AREA_SIZE * fill_factor);
+  PrefixNodeSizer sizer(file_header_.attr_type, file_header_.attr_length);
+
+  page_num = file_header_.root_page;
+  for(int i = 0; i < total; i++){
+    rc = sorter.next(&key);
     if(rc!=SUCCESS){
+      LOG_ERROR("Failed to get next key from sorter. rc=%d:%s", rc, strrc(rc));
       return rc;
     }
-    rc = disk_buffer_pool_->get_data(&left_handle, &pdata);
-    if(rc!=SUCCESS){
-      return rc;
+    if(i == 0){
+      separators.insert(separators.end(), key, key + key_length);
     }
-    left=(IndexNode *)(pdata+sizeof(IndexFileHeader));
 
-    if(left->key_num>min_key){
-      rc = disk_buffer_pool_->unpin_page(&page_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&parent_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&left_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      return redistribute_nodes(leaf_page,page_num);
+    bool full;
+    if(prefix_compressed()){
+      PrefixNodeSizer next_sizer = sizer;
+      next_sizer.add(key);
+      full = leaf.key_num > 0 && next_sizer.size(true) > size_limit;
+      sizer = next_sizer;
+    } else {
+      full = leaf.key_num == bulk_load_node_size(total, leaf_num, pages.size());
     }
-    else{
-      rc = disk_buffer_pool_->unpin_page(&page_handle);
-      if(rc!=SUCCESS){
-        return rc;
-      }
-      rc = disk_buffer_pool_->unpin_page(&parent_handle);
+
+    if(full){
+      rc = allocate_node(&next_page_num);
       if(rc!=SUCCESS){
         return rc;
       }
-      rc = disk_buffer_pool_->unpin_page(&left_handle);
+      leaf.next_page = next_page_num;
+      rc = store_node(page_num, leaf);
       if(rc!=SUCCESS){
         return rc;
       }
-      return coalesce_node(leaf_page,page_num);
+      pages.push_back(page_num);
+      separators.resize(separators.size() + key_length);
+      make_separator(leaf.keys.data() + (leaf.key_num - 1) * key_length, key,
+                     separators.data() + separators.size() - key_length);
+
+      page_num = next_page_num;
+      leaf = NodeImage();
+      sizer = PrefixNodeSizer(file_header_.attr_type, file_header_.attr_length);
+      sizer.add(key);
     }
-  }
-}
 
-RC BplusTreeHandler::delete_entry(const char *data, const RID *rid) {
-  RC rc;
-  PageNum leaf_page;
-  char *pkey;
-  pkey=(char *)malloc(file_header_.key_length);
-  if(nullptr == pkey){
-    LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
-    return RC::NOMEM;
+    leaf.keys.insert(leaf.keys.end(), key, key + key_length);
+    memcpy(&rid, key + file_header_.attr_length, sizeof(RID));
+    leaf.rids.push_back(rid);
+    leaf.key_num++;
   }
-  memcpy(pkey,data,file_header_.attr_length);
-  memcpy(pkey + file_header_.attr_length, rid ,sizeof(*rid));
 
-  rc=find_leaf(pkey,&leaf_page);
+  leaf.next_page = 0;
+  rc = store_node(page_num, leaf);
   if(rc!=SUCCESS){
-    free(pkey);
     return rc;
   }
-  rc=delete_entry_internal(leaf_page,pkey);
-  if(rc!=SUCCESS){
-    free(pkey);
-    return rc;
-  }
-  free(pkey);
+  pages.push_back(page_num);
   return SUCCESS;
 }
 
-
-RC BplusTreeHandler::print_tree() {
-  BPPageHandle page_handle;
-  IndexNode *node;
-  PageNum page_num;
-  char *pdata,*pkey;
-  int i;
+/**
+ * 根据下一层的节点构建一层内部节点，结束后pages/separators替换为新一层的节点
+ */
+RC BplusTreeHandler::bulk_load_intern_level(float fill_factor,
+                                            std::vector<PageNum> &pages, std::vector<char> &separators) {
   RC rc;
+  PageNum page_num;
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, file_header_.root_page, &page_handle);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
-  }
-
-  node = get_index_node(pdata);
-
-  while(!node->is_leaf){
-    page_num=node->rids[0].page_num;
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      return rc;
+  const int key_length = file_header_.key_length;
+  const int child_total = (int)pages.size();
+  int node_num;
+  if(prefix_compressed()){
+    // 按填充率依次填充，估算需要的节点个数
+    const int size_limit = (int)(PREFIX_NODE_AREA_SIZE * fill_factor);
+    PrefixNodeSizer sizer(file_header_.attr_type, file_header_.attr_length);
+    node_num = 1;
+    for(int i = 1; i < child_total; i++){
+      PrefixNodeSizer next_sizer = sizer;
+      next_sizer.add(separators.data() + (size_t)i * key_length);
+      if(sizer.key_num() > 0 && next_sizer.size(false) > size_limit){
+        node_num++;
+        sizer = PrefixNodeSizer(file_header_.attr_type, file_header_.attr_length);
+      } else {
+        sizer = next_sizer;
+      }
     }
-    rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
-    if(rc!=SUCCESS){
-      return rc;
+  } else {
+    int child_capacity = (int)(file_header_.order * fill_factor);
+    if(child_capacity < 2){
+      child_capacity = 2;
     }
-    rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-    if(rc!=SUCCESS){
-      return rc;
+    node_num = (child_total + child_capacity - 1) / child_capacity;
+  }
+  if(child_total / node_num < 2){
+    // 每个内部节点至少要有两个孩子
+    node_num = child_total / 2;
+  }
+
+  // 孩子平均分到各个节点上，前缀压缩格式中有节点放不下时增加节点个数
+  std::vector<NodeImage> nodes;
+  bool fits = false;
+  while(!fits){
+    nodes.assign(node_num, NodeImage());
+    fits = true;
+    for(int i = 0, child = 0; i < node_num; i++){
+      const int child_num = bulk_load_node_size(child_total, node_num, i);
+      NodeImage &node = nodes[i];
+      node.is_leaf = false;
+      node.parent = -1;
+      node.key_num = child_num - 1;
+      node.keys.assign(separators.begin() + (size_t)(child + 1) * key_length,
+                       separators.begin() + (size_t)(child + child_num) * key_length);
+      for(int j = 0; j < child_num; j++){
+        RID rid;
+        rid.page_num = pages[child + j];
+        rid.slot_num = BP_INVALID_PAGE_NUM;
+        node.rids.push_back(rid);
+      }
+      fits = fits && node_fits(node);
+      child += child_num;
     }
-    node=(IndexNode *)(pdata+sizeof(IndexFileHeader));
-    node->keys=(char *)node+sizeof(IndexNode);
-    node->rids=(RID *)(node->keys+file_header_.order*file_header_.key_length);
-  }
-  page_num=1;
-  while(page_num!=0){
-    for(i=0;i<node->key_num;i++){
-      pkey=node->keys+i*file_header_.key_length;
-      printf("key : %d,rids (page_num:%d slotnum %d)\n",*(int *)pkey,node->rids[i].page_num,node->rids[i].slot_num);
+    if(!fits){
+      if(child_total / (node_num + 1) < 2){
+        LOG_ERROR("Failed to build intern level, keys are too large. children=%d", child_total);
+        return RC::RECORD_NOMEM;
+      }
+      node_num++;
     }
-    printf("next node:%d\n",page_num);
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
+  }
+
+  std::vector<PageNum> parent_pages;
+  std::vector<char> parent_separators;
+  parent_pages.reserve(node_num);
+  parent_separators.reserve((size_t)node_num * key_length);
+
+  for(int i = 0, child = 0; i < node_num; i++){
+    const NodeImage &node = nodes[i];
+    rc = allocate_node(&page_num);
     if(rc!=SUCCESS){
       return rc;
     }
-    page_num=node->rids[file_header_.order-1].page_num;
-    if(page_num==0)
-      break;
-    rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
+    rc = store_node(page_num, node);
     if(rc!=SUCCESS){
       return rc;
     }
-    rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-    if(rc!=SUCCESS){
-      return rc;
+    for(const RID &rid : node.rids){
+      rc = set_parent(rid.page_num, page_num);
+      if(rc!=SUCCESS){
+        return rc;
+      }
     }
 
-    node = get_index_node(pdata);
+    parent_pages.push_back(page_num);
+    parent_separators.insert(parent_separators.end(),
+                             separators.data() + (size_t)child * key_length,
+                             separators.data() + (size_t)(child + 1) * key_length);
+    child += node.key_num + 1;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
+
+  pages.swap(parent_pages);
+  separators.swap(parent_separators);
+  return SUCCESS;
+}
+
+RC BplusTreeHandler::set_parent(PageNum page_num, PageNum parent) {
+  BPPageHandle page_handle;
+  char *pdata;
+  RC rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
   if(rc!=SUCCESS){
     return rc;
   }
-  return SUCCESS;
+  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  IndexNode *node = get_index_node(pdata);
+  node->parent = parent;
+  rc = log_page_write(page_handle, (const char *)&node->parent, sizeof(node->parent));
+  if(rc!=SUCCESS){
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return rc;
+  }
+  return disk_buffer_pool_->unpin_page(&page_handle);
 }
 
-RC BplusTreeHandler::find_first_index_satisfied(CompOp compop, const char *key, PageNum *page_num, int *rididx) {
-  BPPageHandle page_handle;
-  IndexNode *node;
-  PageNum leaf_page,next;
-  char *pdata,*pkey;
-  RC rc;
-  int i,tmp;
-  RID rid;
-  if(compop == LESS_THAN || compop == LESS_EQUAL || compop == NOT_EQUAL){
-    rc = get_first_leaf_page(page_num);
-    if(rc != SUCCESS){
-      return rc;
+RC BplusTreeHandler::log_node(BPPageHandle &page_handle, IndexNode *node, int from) {
+  if(prefix_compressed()){
+    const PrefixNodeHeader *header = prefix_node_header(node);
+    int size = sizeof(IndexNode) + sizeof(PrefixNodeHeader) + header->prefix_len +
+               node->key_num * (header->slot_len + sizeof(RID));
+    if(!node->is_leaf){
+      size += (node->key_num + 1) * sizeof(PageNum);
     }
-    *rididx=0;
-    return SUCCESS;
-  }
-  rid.page_num = -1;
-  rid.slot_num = -1;
-  pkey=(char *)malloc(file_header_.key_length);
-  if(pkey == nullptr){
-    LOG_ERROR("Failed to alloc memory for key. size=%d", file_header_.key_length);
-    return RC::NOMEM;
+    return log_page_write(page_handle, (const char *)node, size);
   }
-  memcpy(pkey, key, file_header_.attr_length);
-  memcpy(pkey + file_header_.attr_length, &rid, sizeof(RID));
 
-  rc = find_leaf(pkey, &leaf_page);
-  if(rc != SUCCESS){
-    free(pkey);
-    return rc;
+  const int key_length = file_header_.key_length;
+  const int key_num = node->key_num;
+  const int rid_num = node->is_leaf ? key_num : key_num + 1;
+  RC rc = log_page_write(page_handle, (const char *)node, sizeof(IndexNode));
+  if(rc == SUCCESS && from < key_num){
+    rc = log_page_write(page_handle, node->keys + from * key_length, (key_num - from) * key_length);
   }
-  free(pkey);
+  if(rc == SUCCESS && from < rid_num){
+    rc = log_page_write(page_handle, (const char *)(node->rids + from), (rid_num - from) * sizeof(RID));
+  }
+  if(rc == SUCCESS && node->is_leaf && from == 0){
+    // 下一个叶子的页号
+    rc = log_page_write(page_handle, (const char *)(node->rids + file_header_.order - 1), sizeof(RID));
+  }
+  return rc;
+}
 
-  next=leaf_page;
+RC BplusTreeHandler::log_page_write(BPPageHandle &page_handle, const char *data, int length) {
+  return disk_buffer_pool_->append_log(file_id_, &page_handle, CLogType::PAGE_WRITE,
+                                       data - page_handle.frame->page.data, data, length);
+}
 
-  while(next > 0){
-    rc = disk_buffer_pool_->get_this_page(file_id_, next, &page_handle);
-    if(rc!=SUCCESS){
-      return rc;
-    }
-    rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-    if(rc!=SUCCESS){
-      return rc;
-    }
+std::string BplusTreeHandler::bloom_filter_file(const char *index_file) {
+  return std::string(index_file) + ".bloom";
+}
 
-    node = get_index_node(pdata);
-    for(i = 0; i < node->key_num; i++){
-      tmp=CompareKey(node->keys+i*file_header_.key_length,key,file_header_.attr_type,file_header_.attr_length);
-      if(compop == EQUAL_TO ||compop == GREAT_EQUAL){
-        if(tmp>=0){
-          rc = disk_buffer_pool_->get_page_num(&page_handle, page_num);
-          if(rc != SUCCESS){
-            return rc;
-          }
-          *rididx=i;
-          rc = disk_buffer_pool_->unpin_page(&page_handle);
-          if(rc != SUCCESS){
-            return rc;
-          }
-          return SUCCESS;
-        }
-      }
-      if(compop == GREAT_THAN){
-        if(tmp > 0){
-          rc = disk_buffer_pool_->get_page_num(&page_handle, page_num);
-          if(rc!=SUCCESS){
-            return rc;
-          }
-          *rididx=i;
-          rc = disk_buffer_pool_->unpin_page(&page_handle);
-          if(rc!=SUCCESS){
-            return rc;
-          }
-          return SUCCESS;
-        }
-      }
+/**
+ * 过滤器只取key的前bloom_key_length个字节。单列的字符串索引按strncmp比较，结束符之后的内容不参与
+ */
+static uint64_t bloom_hash(AttrType attr_type, const char *pkey, int bloom_key_length) {
+  if(attr_type == CHARS){
+    return BloomFilter::hash(pkey, strnlen(pkey, bloom_key_length));
+  }
+  return BloomFilter::hash(pkey, bloom_key_length);
+}
 
-    }
-    next=node->rids[file_header_.order-1].page_num;
+int64_t BplusTreeHandler::bloom_filter_tag() const {
+  return ((int64_t)file_header_.attr_type << 48) | ((int64_t)file_header_.attr_length << 24) | bloom_key_length_;
+}
+
+RC BplusTreeHandler::enable_bloom_filter(int key_length) {
+  if(nullptr == disk_buffer_pool_){
+    return RC::RECORD_CLOSED;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
+  if(key_length <= 0 || key_length > file_header_.attr_length){
+    LOG_ERROR("Invalid bloom filter key length %d, attr length=%d", key_length, file_header_.attr_length);
+    return RC::INVALID_ARGUMENT;
+  }
+  if(file_header_.attr_type == FLOATS){
+    // 浮点数按误差范围比较相等，不能按字节过滤
+    LOG_WARN("Bloom filter is not supported on float index. file=%s", file_name_.c_str());
+    return SUCCESS;
+  }
+
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  bloom_key_length_ = key_length;
+  std::string bloom_file = bloom_filter_file(file_name_.c_str());
+  std::shared_ptr<BloomFilter> bloom_filter = std::make_shared<BloomFilter>();
+  RC rc = bloom_filter->load(bloom_file.c_str(), bloom_filter_tag());
+  if(rc == SUCCESS && bloom_filter->deleted() <= bloom_filter->count() / 2){
+    std::atomic_store(&bloom_filter_, bloom_filter);
+    bloom_persisted_ = true;
+    LOG_INFO("Load bloom filter from %s, keys=%ld, capacity=%ld",
+             bloom_file.c_str(), bloom_filter->count(), bloom_filter->capacity());
+    return SUCCESS;
+  }
+
+  // 文件不存在、已经过期或者删除的key太多，从B+树中重建
+  rc = rebuild_bloom_filter();
   if(rc != SUCCESS){
+    bloom_key_length_ = 0;
     return rc;
   }
-  return RC::RECORD_EOF;
+  return SUCCESS;
 }
 
-RC BplusTreeHandler::get_first_leaf_page(PageNum *leaf_page) {
-  RC rc;
-  BPPageHandle page_handle;
-  PageNum page_num;
-  IndexNode *node;
-  char *pdata;
+RC BplusTreeHandler::enable_adaptive_hash(size_t memory_limit, int hot_threshold) {
+  if(nullptr == disk_buffer_pool_){
+    return RC::RECORD_CLOSED;
+  }
+  if(memory_limit == 0){
+    return SUCCESS;
+  }
+  adaptive_hash_.reset(new AdaptiveHashIndex(memory_limit, hot_threshold));
+  return SUCCESS;
+}
 
-  rc = disk_buffer_pool_->get_this_page(file_id_, file_header_.root_page, &page_handle);
-  if(rc!=SUCCESS){
-    return rc;
+AdaptiveHashStats BplusTreeHandler::adaptive_hash_stats() const {
+  if(adaptive_hash_ == nullptr){
+    return AdaptiveHashStats();
   }
-  rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-  if(rc!=SUCCESS){
-    return rc;
+  return adaptive_hash_->stats();
+}
+
+bool BplusTreeHandler::may_contain(const char *pkey, int length) {
+  if(length != bloom_key_length_){
+    return true;
+  }
+  std::shared_ptr<BloomFilter> bloom_filter = std::atomic_load(&bloom_filter_);
+  if(!bloom_filter){
+    return true;
   }
 
-  node = get_index_node(pdata);
+  BloomFilterMetric &metric = bloom_filter_metric();
+  bloom_probes_.fetch_add(1, std::memory_order_relaxed);
+  metric.probes.fetch_add(1, std::memory_order_relaxed);
+  if(bloom_filter->may_contain(bloom_hash(file_header_.attr_type, pkey, bloom_key_length_))){
+    return true;
+  }
+  bloom_negatives_.fetch_add(1, std::memory_order_relaxed);
+  metric.negatives.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
 
-  while(node->is_leaf==false){
-    page_num=node->rids[0].page_num;
-    rc = disk_buffer_pool_->unpin_page(&page_handle);
-    if(rc!=SUCCESS){
-      return rc;
-    }
+void BplusTreeHandler::record_false_positive() {
+  bloom_false_positives_.fetch_add(1, std::memory_order_relaxed);
+  bloom_filter_metric().false_positives.fetch_add(1, std::memory_order_relaxed);
+}
 
-    rc = disk_buffer_pool_->get_this_page(file_id_, page_num, &page_handle);
-    if(rc!=SUCCESS){
-      return rc;
+BloomFilterStats BplusTreeHandler::bloom_filter_stats() const {
+  BloomFilterStats stats;
+  stats.probes = bloom_probes_.load(std::memory_order_relaxed);
+  stats.negatives = bloom_negatives_.load(std::memory_order_relaxed);
+  stats.false_positives = bloom_false_positives_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+/**
+ * 插入时调用，调用者持有smo_lock_
+ */
+void BplusTreeHandler::add_to_bloom_filter(const char *pkey) {
+  std::shared_ptr<BloomFilter> bloom_filter = std::atomic_load(&bloom_filter_);
+  if(!bloom_filter){
+    return;
+  }
+  if(bloom_persisted_.exchange(false)){
+    // 文件中的过滤器不再包含所有的key，如果在下次sync之前崩溃，重新打开时要重建
+    remove(bloom_filter_file(file_name_.c_str()).c_str());
+  }
+  bloom_filter->add(bloom_hash(file_header_.attr_type, pkey, bloom_key_length_));
+  if(bloom_filter->count() > bloom_filter->capacity()){
+    bloom_need_rebuild_ = true;
+  }
+}
+
+/**
+ * 遍历所有的叶子节点重新构建过滤器，容量是现有key个数的两倍。调用者持有smo_lock_的排他锁
+ */
+RC BplusTreeHandler::rebuild_bloom_filter() {
+  std::vector<uint64_t> hashes;
+  LeafSnapshot leaf;
+  RC rc = read_leaf(nullptr, leaf);
+  while(rc == SUCCESS){
+    for(int i = 0; i < leaf.key_num; i++){
+      hashes.push_back(bloom_hash(file_header_.attr_type,
+                                  leaf.keys.data() + i * file_header_.key_length, bloom_key_length_));
     }
-    rc = disk_buffer_pool_->get_data(&page_handle, &pdata);
-    if(rc!=SUCCESS){
-      return rc;
+    if(leaf.next_page <= 0){
+      break;
     }
-
-    node = get_index_node(pdata);
+    LeafSnapshot next;
+    rc = read_next_leaf(leaf, next);
+    std::swap(leaf, next);
   }
-  rc = disk_buffer_pool_->get_page_num(&page_handle, leaf_page);
-  if(rc!=SUCCESS){
+  if(rc != SUCCESS){
+    LOG_ERROR("Failed to read leaves to build bloom filter. file=%s, rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
     return rc;
   }
-  rc = disk_buffer_pool_->unpin_page(&page_handle);
-  if(rc!=SUCCESS){
+
+  std::shared_ptr<BloomFilter> bloom_filter = std::make_shared<BloomFilter>();
+  bloom_filter->init(hashes.size() * 2);
+  for(uint64_t hash : hashes){
+    bloom_filter->add(hash);
+  }
+  std::atomic_store(&bloom_filter_, bloom_filter);
+  bloom_persisted_ = false;
+  bloom_need_rebuild_ = false;
+  LOG_INFO("Build bloom filter. file=%s, keys=%lu, memory=%ld bytes",
+           file_name_.c_str(), hashes.size(), bloom_filter->memory_size());
+  return SUCCESS;
+}
+
+void BplusTreeHandler::rebuild_bloom_filter_if_full() {
+  if(!bloom_need_rebuild_.exchange(false)){
+    return;
+  }
+  // key的个数超过了过滤器的容量，假阳性率会越来越高，按现在的key个数重建
+  std::unique_lock<std::shared_timed_mutex> smo_guard(smo_lock_);
+  RC rc = rebuild_bloom_filter();
+  if(rc != SUCCESS){
+    LOG_WARN("Failed to rebuild bloom filter. file=%s, rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+  }
+}
+
+/**
+ * sync时调用，调用者持有smo_lock_的排他锁
+ */
+RC BplusTreeHandler::save_bloom_filter() {
+  std::shared_ptr<BloomFilter> bloom_filter = std::atomic_load(&bloom_filter_);
+  if(!bloom_filter || bloom_persisted_){
+    return SUCCESS;
+  }
+  RC rc = bloom_filter->save(bloom_filter_file(file_name_.c_str()).c_str(), bloom_filter_tag());
+  if(rc != SUCCESS){
     return rc;
   }
+  bloom_persisted_ = true;
   return SUCCESS;
 }
 
@@ -1670,7 +2780,6 @@ BplusTreeScanner::BplusTreeScanner(BplusTreeHandler &index_handler) : index_hand
 }
 
 RC BplusTreeScanner::open(CompOp comp_op,const char *value) {
-  RC rc;
   if(opened_){
     return RC::RECORD_OPENNED;
   }
@@ -1684,19 +2793,77 @@ RC BplusTreeScanner::open(CompOp comp_op,const char *value) {
   }
   memcpy(value_copy, value, index_handler_.file_header_.attr_length);
   value_ = value_copy; // free value_
-  rc = index_handler_.find_first_index_satisfied(comp_op, value, &next_page_num_, &index_in_node_);
-  if(rc != SUCCESS){
-    if(rc == RC::RECORD_EOF){
-      next_page_num_ = -1;
-      index_in_node_ = -1;
-    }
-    else
-      return rc;
+  prefix_scan_ = false;
+  located_ = false;
+  last_key_.clear();
+  opened_ = true;
+  check_bloom_filter(comp_op_ == EQUAL_TO ? value_ : nullptr, index_handler_.file_header_.attr_length);
+  return SUCCESS;
+}
+
+RC BplusTreeScanner::open(const char *low, int low_length, bool low_inclusive,
+                          const char *high, int high_length, bool high_inclusive) {
+  if(opened_){
+    return RC::RECORD_OPENNED;
+  }
+  const IndexFileHeader &header = index_handler_.file_header_;
+  if(header.attr_type != BYTES || low_length > header.attr_length || high_length > header.attr_length){
+    LOG_ERROR("Invalid prefix scan on index. attr type=%d, attr length=%d, low length=%d, high length=%d",
+              header.attr_type, header.attr_length, low_length, high_length);
+    return RC::INVALID_ARGUMENT;
   }
-  num_fixed_pages_ = 1;
-  next_index_of_page_handle_=0;
-  pinned_page_count_ = 0;
+
+  comp_op_ = NO_OP;
+  value_ = nullptr;
+  prefix_scan_ = true;
+  low_.assign(low == nullptr ? "" : low, low == nullptr ? 0 : low_length);
+  low_inclusive_ = low_inclusive;
+  high_.assign(high == nullptr ? "" : high, high == nullptr ? 0 : high_length);
+  high_inclusive_ = high_inclusive;
+  located_ = false;
+  last_key_.clear();
   opened_ = true;
+  bool equal = low_inclusive_ && high_inclusive_ && low != nullptr && low_ == high_;
+  check_bloom_filter(equal ? low_.data() : nullptr, low_.size());
+  return SUCCESS;
+}
+
+RC BplusTreeScanner::seek(const char *value) {
+  if(!opened_){
+    return RC::RECORD_CLOSED;
+  }
+  if(!prefix_scan_ && comp_op_ != EQUAL_TO){
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const IndexFileHeader &header = index_handler_.file_header_;
+  std::vector<char> key(header.key_length, 0);
+  RID rid;
+  rid.page_num = -1;
+  rid.slot_num = -1;
+  if(prefix_scan_){
+    low_.assign(value, low_.size());
+    high_ = low_;
+    low_inclusive_ = true;
+    high_inclusive_ = true;
+    memcpy(key.data(), low_.data(), low_.size());
+  } else {
+    memcpy((char *)value_, value, header.attr_length);
+    memcpy(key.data(), value, header.attr_length);
+  }
+  memcpy(key.data() + header.attr_length, &rid, sizeof(RID));
+  last_key_.clear();
+  check_bloom_filter(key.data(), prefix_scan_ ? low_.size() : header.attr_length);
+
+  // 叶子中有比新值小的key，也有不小于新值的key时，新值的位置一定在这个叶子里
+  if(located_){
+    int index = index_handler_.lower_bound(leaf_.keys.data(), leaf_.key_num, key.data());
+    if(index > 0 && index < leaf_.key_num){
+      index_in_node_ = index;
+      return SUCCESS;
+    }
+  }
+  located_ = false;
   return SUCCESS;
 }
 
@@ -1710,102 +2877,187 @@ RC BplusTreeScanner::close() {
   return RC::SUCCESS;
 }
 
-RC BplusTreeScanner::next_entry(RID *rid) {
+/**
+ * 找到扫描的起始位置。如果已经返回过数据，就从上一次返回的key之后开始
+ */
+RC BplusTreeScanner::locate() {
   RC rc;
-  if(!opened_){
-    return RC::RECORD_CLOSED;
-  }
-  rc = get_next_idx_in_memory(rid);//和RM中一样，有可能有错误，一次只查当前页和当前页的下一页，有待确定
-  if(rc == RC::RECORD_NO_MORE_IDX_IN_MEM){
-    rc = find_idx_pages();
+  const IndexFileHeader &header = index_handler_.file_header_;
+  if(!last_key_.empty()){
+    rc = index_handler_.read_leaf(last_key_.data(), leaf_);
     if(rc != SUCCESS){
       return rc;
     }
-    return get_next_idx_in_memory(rid);
+    index_in_node_ = index_handler_.upper_bound(leaf_.keys.data(), leaf_.key_num, last_key_.data());
+    located_ = true;
+    return SUCCESS;
   }
-  else{
+
+  if(prefix_scan_ && !low_.empty()){
+    // 下界后面补0，定位到以下界开头的第一个key
+    std::vector<char> key(header.key_length, 0);
+    RID rid;
+    rid.page_num = -1;
+    rid.slot_num = -1;
+    memcpy(key.data(), low_.data(), low_.size());
+    memcpy(key.data() + header.attr_length, &rid, sizeof(RID));
+    if(low_inclusive_ && high_inclusive_ && low_ == high_){
+      // 组合索引前缀上的等值查找
+      rc = index_handler_.lookup_leaf(key.data(), low_.size(), leaf_, &index_in_node_);
+    } else {
+      rc = index_handler_.read_leaf(key.data(), leaf_);
+      if(rc == SUCCESS){
+        index_in_node_ = index_handler_.lower_bound(leaf_.keys.data(), leaf_.key_num, key.data());
+      }
+    }
     if(rc != SUCCESS){
       return rc;
     }
-  }
-  return SUCCESS;
-}
-
-RC BplusTreeScanner::find_idx_pages() {
-  RC rc;
-  if(!opened_){
-    return RC::RECORD_CLOSED;
-  }
-  if(pinned_page_count_ > 0){
-    for(int i = 0; i < pinned_page_count_; i++){
-      rc = index_handler_.disk_buffer_pool_->unpin_page(page_handles_ + i);
-      if(rc != SUCCESS){
-        return rc;
+  } else if(comp_op_ == EQUAL_TO || comp_op_ == GREAT_EQUAL || comp_op_ == GREAT_THAN){
+    std::vector<char> key(header.key_length);
+    RID rid;
+    rid.page_num = -1;
+    rid.slot_num = -1;
+    memcpy(key.data(), value_, header.attr_length);
+    memcpy(key.data() + header.attr_length, &rid, sizeof(RID));
+    if(comp_op_ == EQUAL_TO){
+      rc = index_handler_.lookup_leaf(key.data(), header.attr_length, leaf_, &index_in_node_);
+    } else {
+      rc = index_handler_.read_leaf(key.data(), leaf_);
+      if(rc == SUCCESS){
+        index_in_node_ = index_handler_.lower_bound(leaf_.keys.data(), leaf_.key_num, key.data());
       }
     }
-  }
-  next_index_of_page_handle_ = 0;
-  pinned_page_count_ = 0;
-
-  for(int i = 0; i < num_fixed_pages_; i++){
-    if(next_page_num_ <= 0)
-      break;
-    rc = index_handler_.disk_buffer_pool_->get_this_page(index_handler_.file_id_, next_page_num_, page_handles_ + i);
     if(rc != SUCCESS){
       return rc;
     }
-    char *pdata;
-    rc = index_handler_.disk_buffer_pool_->get_data(page_handles_ + i, &pdata);
+  } else {
+    rc = index_handler_.read_leaf(nullptr, leaf_);
     if(rc != SUCCESS){
       return rc;
     }
-
-    IndexNode *node = index_handler_.get_index_node(pdata);
-    pinned_page_count_++;
-    next_page_num_ = node->rids[index_handler_.file_header_.order-1].page_num;
+    index_in_node_ = 0;
   }
-  if(pinned_page_count_ > 0)
-    return SUCCESS;
-  return RC::RECORD_EOF;
+  located_ = true;
+  return SUCCESS;
 }
 
-RC BplusTreeScanner::get_next_idx_in_memory(RID *rid) {
-  char *pdata;
-  IndexNode *node;
-  RC rc;
-  if(next_index_of_page_handle_ >= pinned_page_count_) {
-    return RC::RECORD_NO_MORE_IDX_IN_MEM;
-  }
+RC BplusTreeScanner::next_entry(RID *rid) {
+  return next_entry(rid, nullptr);
+}
 
-  if(next_page_num_ == -1 && index_in_node_ == -1) {
+/**
+ * 等值查找时先查Bloom过滤器，key为空表示不是等值查找
+ */
+void BplusTreeScanner::check_bloom_filter(const char *key, int length) {
+  bloom_miss_ = false;
+  bloom_pending_ = false;
+  if(key == nullptr || !index_handler_.bloom_filter_enabled() || length != index_handler_.bloom_key_length_){
+    return;
+  }
+  bloom_miss_ = !index_handler_.may_contain(key, length);
+  bloom_pending_ = !bloom_miss_;
+}
+
+RC BplusTreeScanner::next_entry(RID *rid, char *key_out) {
+  if(!opened_){
+    return RC::RECORD_CLOSED;
+  }
+  if(bloom_miss_){
     return RC::RECORD_EOF;
   }
 
-  for( ; next_index_of_page_handle_ < pinned_page_count_; next_index_of_page_handle_++){
-    rc = index_handler_.disk_buffer_pool_->get_data(page_handles_ + next_index_of_page_handle_, &pdata);
-    if(rc != SUCCESS){
-      LOG_ERROR("Failed to get data from disk buffer pool. rc=%s", strrc);
-      return rc;
+  RC rc = fetch_next(rid, key_out);
+  if(bloom_pending_ && rc != RC::LOCKED_NEED_WAIT){
+    bloom_pending_ = false;
+    if(rc == RC::RECORD_EOF){
+      index_handler_.record_false_positive();
+    }
+  }
+  return rc;
+}
+
+RC BplusTreeScanner::fetch_next(RID *rid, char *key_out) {
+  RC rc;
+
+  const int key_length = index_handler_.file_header_.key_length;
+  while(true){
+    if(!located_){
+      rc = locate();
+      if(rc != SUCCESS){
+        return rc;
+      }
     }
 
-    node = index_handler_.get_index_node(pdata);
-    for( ; index_in_node_ < node->key_num; index_in_node_++){
-      if(satisfy_condition(node->keys + index_in_node_ * index_handler_.file_header_.key_length)){
-        memcpy(rid,node->rids+index_in_node_,sizeof(RID));
+    for( ; index_in_node_ < leaf_.key_num; index_in_node_++){
+      const char *key = leaf_.keys.data() + index_in_node_ * key_length;
+      if(reach_end(key)){
+        return RC::RECORD_EOF;
+      }
+      if(satisfy_condition(key)){
+        memcpy(rid, &leaf_.rids[index_in_node_], sizeof(RID));
+        if(key_out != nullptr){
+          memcpy(key_out, key, index_handler_.file_header_.attr_length);
+        }
+        last_key_.assign(key, key + key_length);
         index_in_node_++;
         return SUCCESS;
       }
     }
 
+    if(leaf_.next_page <= 0){
+      return RC::RECORD_EOF;
+    }
+    LeafSnapshot next;
+    rc = index_handler_.read_next_leaf(leaf_, next);
+    if(rc == RC::RECORD_NO_MORE_IDX_IN_MEM){
+      // 树结构变化了，重新定位
+      located_ = false;
+      continue;
+    }
+    if(rc != SUCCESS){
+      return rc;
+    }
+    std::swap(leaf_, next);
     index_in_node_ = 0;
   }
-  return RC::RECORD_NO_MORE_IDX_IN_MEM;
 }
+
+/**
+ * key是有序的，超过扫描范围的上界之后就不用再往后找了
+ */
+bool BplusTreeScanner::reach_end(const char *key) {
+  if(prefix_scan_){
+    if(high_.empty()){
+      return false;
+    }
+    int result = memcmp(key, high_.data(), high_.size());
+    return result > 0 || (result == 0 && !high_inclusive_);
+  }
+  if(comp_op_ != EQUAL_TO && comp_op_ != LESS_THAN && comp_op_ != LESS_EQUAL){
+    return false;
+  }
+  const IndexFileHeader &header = index_handler_.file_header_;
+  int result = CompareKey(key, value_, header.attr_type, header.attr_length);
+  if(comp_op_ == LESS_THAN){
+    return result >= 0;
+  }
+  return result > 0;
+}
+
 bool BplusTreeScanner::satisfy_condition(const char *pkey) {
   int i1=0,i2=0;
   float f1=0,f2=0;
   const char *s1=nullptr,*s2=nullptr;
 
+  if(prefix_scan_){
+    if(low_.empty()){
+      return true;
+    }
+    int result = memcmp(pkey, low_.data(), low_.size());
+    return result > 0 || (result == 0 && low_inclusive_);
+  }
+
   if(comp_op_ == NO_OP){
     return true;
   }
@@ -1934,3 +3186,43 @@ bool BplusTreeScanner::satisfy_condition(const char *pkey) {
   }
   return flag;
 }
+
+BplusTreeReverseScanner::BplusTreeReverseScanner(BplusTreeHandler &index_handler) : index_handler_(index_handler){
+}
+
+RC BplusTreeReverseScanner::next_entry(RID *rid, char *key) {
+  RC rc;
+  const int key_length = index_handler_.file_header_.key_length;
+  while(true){
+    if(index_in_node_ >= 0){
+      const char *entry = leaf_.keys.data() + index_in_node_ * key_length;
+      memcpy(rid, &leaf_.rids[index_in_node_], sizeof(RID));
+      if(key != nullptr){
+        memcpy(key, entry, index_handler_.file_header_.attr_length);
+      }
+      index_in_node_--;
+      return SUCCESS;
+    }
+    if(finished_){
+      return RC::RECORD_EOF;
+    }
+
+    std::vector<char> low;
+    rc = index_handler_.read_prev_leaf(started_ ? bound_.data() : nullptr, leaf_, low);
+    if(rc != SUCCESS){
+      return rc;
+    }
+    // 叶子中不小于bound_的key已经在后面的叶子中返回过了
+    if(started_){
+      index_in_node_ = index_handler_.lower_bound(leaf_.keys.data(), leaf_.key_num, bound_.data()) - 1;
+    } else {
+      index_in_node_ = leaf_.key_num - 1;
+    }
+    started_ = true;
+    if(low.empty()){
+      finished_ = true;
+    } else {
+      bound_.swap(low);
+    }
+  }
+}
@@ -14,16 +14,40 @@ See the Mulan PSL v2 for more details. */
 #ifndef __OBSERVER_STORAGE_COMMON_INDEX_MANAGER_H_
 #define __OBSERVER_STORAGE_COMMON_INDEX_MANAGER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "record_manager.h"
+#include "storage/common/adaptive_hash_index.h"
+#include "storage/common/bloom_filter.h"
 #include "storage/default/disk_buffer_pool.h"
 #include "sql/parser/parse_defs.h"
 
+/**
+ * 节点格式。定长格式中每个key都占key_length字节，最多order-1个key；
+ * 前缀压缩格式只用于按字节比较的CHARS/BYTES索引，节点内的key去掉公共前缀和末尾的0后存放，
+ * 能放多少个key取决于key的实际长度
+ */
+enum IndexNodeFormat {
+  NODE_FORMAT_FIXED = 1,
+  NODE_FORMAT_PREFIX = 2,
+};
+
 struct IndexFileHeader {
   int attr_length;
   int key_length;
   AttrType attr_type;
   PageNum root_page; // 初始时，root_page一定是1
-  int node_num;
+  int node_format;   // IndexNodeFormat，旧版本的索引文件中这里一直是1
   int order;
 };
 
@@ -35,6 +59,44 @@ struct IndexNode {
   RID *rids;
 };
 
+/**
+ * 解码出来的节点。分裂、合并、重新分配这些结构修改先把节点解码出来，
+ * 修改完再整体编码写回页面，两种节点格式共用一套逻辑
+ */
+struct NodeImage {
+  bool              is_leaf = true;
+  PageNum           parent = -1;
+  PageNum           next_page = 0;   // 叶子节点的下一个叶子，0表示没有
+  int               key_num = 0;
+  std::vector<char> keys;            // key_num个key(属性值 + RID)
+  std::vector<RID>  rids;            // 叶子节点是每个key的RID，内部节点是key_num+1个孩子
+};
+
+/**
+ * B+树的参数，由DefaultStorageStage根据配置文件设置
+ */
+struct BplusTreeOptions {
+  int upper_level_pages = 256;   // 每个索引常驻内存的上层内部节点个数上限，0表示不缓存
+
+  static BplusTreeOptions &instance();
+};
+
+/**
+ * 上层内部节点解码后的只读副本。从根节点开始按层缓存，一层放不进预算就不再缓存这一层及以下。
+ * 查找时在这里走完缓存的几层，剩下的才经过缓冲池
+ */
+struct UpperLevelNode {
+  int                  key_num = 0;
+  std::vector<char>    keys;       // 解码后的完整key
+  std::vector<PageNum> children;   // key_num+1个孩子
+};
+
+struct UpperLevels {
+  PageNum root_page = -1;
+  int     levels = 0;              // 缓存的层数，根节点是叶子时为0
+  std::unordered_map<PageNum, std::shared_ptr<const UpperLevelNode>> nodes;
+};
+
 struct TreeNode {
   int key_num;
   char **keys;
@@ -50,13 +112,56 @@ struct Tree {
   TreeNode *root;
 };
 
+class KeySorter;
+
+/**
+ * 基于版本号的乐观锁。版本号为奇数表示有写者持有。
+ * 读者记录版本号后不加锁读取数据，读完后校验版本号没有变化，变化了就重试
+ */
+class VersionLatch {
+public:
+  uint64_t read_begin() const;
+  bool read_validate(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  void write_lock();
+  void write_unlock() {
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+private:
+  std::atomic<uint64_t> version_{0};
+};
+
+/**
+ * 读者拷贝出来的一个叶子节点
+ */
+struct LeafSnapshot {
+  PageNum           page_num = -1;
+  PageNum           next_page = 0;     // 下一个叶子，0表示没有
+  uint64_t          tree_version = 0;  // 读取时树结构的版本号
+  int               key_num = 0;
+  std::vector<char> keys;
+  std::vector<RID>  rids;
+};
+
+/**
+ * 比较两个B+树的key(属性值 + RID)
+ */
+int CmpKey(AttrType attr_type, int attr_length, const char *pdata, const char *pkey);
+
 class BplusTreeHandler {
 public:
+  ~BplusTreeHandler();
+
   /**
    * 此函数创建一个名为fileName的索引。
    * attrType描述被索引属性的类型，attrLength描述被索引属性的长度
+   * @param prefix_compression 节点使用前缀压缩格式，只对CHARS/BYTES类型生效
    */
-  RC create(const char *file_name, AttrType attr_type, int attr_length);
+  RC create(const char *file_name, AttrType attr_type, int attr_length, bool prefix_compression = false);
 
   /**
    * 打开名为fileName的索引文件。
@@ -78,37 +183,239 @@ public:
   RC insert_entry(const char *pkey, const RID *rid);
 
   /**
-   * 从IndexHandle句柄对应的索引中删除一个值为（*pData，rid）的索引项
+   * 从IndexHandle句柄对应的索引中删除一个值为（*pData，rid）的索引项。
+   * 只从叶子节点中删除，不合并节点。叶子低于半满时记下来，由后台线程合并或者重新分配
    * @return RECORD_INVALID_KEY 指定值不存在
    */
   RC delete_entry(const char *pkey, const RID *rid);
 
+  /**
+   * 立即合并所有等待处理的低于半满的叶子节点，close时也会调用
+   */
+  RC rebalance();
+
+  /**
+   * 等待后台合并的叶子节点个数
+   */
+  size_t rebalance_pending() const;
+
   /**
    * 获取指定值的record
    * @param rid  返回值，记录记录所在的页面号和slot
    */
   RC get_entry(const char *pkey, RID *rid);
 
-  RC sync();
+  /**
+   * 从有序的key流自底向上构建B+树，只能在空树上调用。
+   * 叶子节点按照fill_factor填充，然后逐层向上一次性构建内部节点
+   * @param sorter 已经调用过finish的KeySorter
+   * @param fill_factor 节点填充率 (0, 1]
+   */
+  RC bulk_load(KeySorter &sorter, float fill_factor);
+
+  /**
+   * flush_pages为false时只写出Bloom过滤器，调用者要先让redo日志落盘
+   */
+  RC sync(bool flush_pages = true);
+
+  /**
+   * 无锁地读取pkey所在的叶子节点，pkey为空时读取第一个叶子节点
+   */
+  RC read_leaf(const char *pkey, LeafSnapshot &snapshot);
+
+  /**
+   * 读取current的下一个叶子节点。
+   * 如果读取current之后树结构发生了变化，返回RECORD_NO_MORE_IDX_IN_MEM，调用者需要重新定位
+   */
+  RC read_next_leaf(const LeafSnapshot &current, LeafSnapshot &next);
+
+  /**
+   * 倒序读取叶子节点: 无锁地读取key都小于pkey的最后一个叶子节点，pkey为空时读取最后一个叶子节点。
+   * 叶子中也可能有不小于pkey的key，由调用者跳过。
+   * low返回这个叶子在上层节点中的下界，作为读取前一个叶子时的pkey；最左边的叶子没有下界，low为空
+   */
+  RC read_prev_leaf(const char *pkey, LeafSnapshot &snapshot, std::vector<char> &low);
+
+  /**
+   * 在索引上启用Bloom过滤器，等值查找的值一定不存在时不用访问B+树。
+   * 过滤器保存在索引文件旁边的bloom_filter_file中，sync时写出，
+   * 打开时文件不存在或者已经过期(上次sync之后又有插入)就从B+树重建。需要在create或open之后调用
+   * @param key_length 参与过滤的key前缀长度。组合索引是各索引字段编码后的长度之和，不含INCLUDE字段
+   */
+  RC enable_bloom_filter(int key_length);
+  bool bloom_filter_enabled() const {
+    return bloom_key_length_ > 0;
+  }
+
+  /**
+   * Bloom过滤器判断key的前length个字节是否可能存在。
+   * 没有启用过滤器或者length与过滤的前缀长度不同时返回true
+   */
+  bool may_contain(const char *pkey, int length);
+
+  /**
+   * 过滤器判断可能存在，实际查找后不存在
+   */
+  void record_false_positive();
+
+  BloomFilterStats bloom_filter_stats() const;
+
+  static std::string bloom_filter_file(const char *index_file);
+
+  /**
+   * 在索引上启用自适应哈希索引，经常查找的值直接定位到叶子节点。需要在create或open之后调用
+   * @param memory_limit 自适应哈希索引使用的内存上限
+   * @param hot_threshold 一个值从根节点查找多少次之后记录它的位置
+   */
+  RC enable_adaptive_hash(size_t memory_limit, int hot_threshold);
+  bool adaptive_hash_enabled() const {
+    return adaptive_hash_ != nullptr;
+  }
+  AdaptiveHashStats adaptive_hash_stats() const;
+
+  /**
+   * 等值查找时定位pkey所在的叶子节点，index返回叶子中第一个不小于pkey的位置。
+   * 启用了自适应哈希索引时，热点值直接读取记录的叶子节点，不从根节点查找
+   * @param hash_key_length 自适应哈希索引中使用的pkey前缀长度。按值查找时是属性值的长度，
+   *        组合索引上的前缀查找时小于attr_length，查找完整的key时是key_length
+   */
+  RC lookup_leaf(const char *pkey, int hash_key_length, LeafSnapshot &snapshot, int *index);
 public:
   RC print();
   RC print_tree();
+
+  /**
+   * 检查整棵树是否满足B+树的约束: 节点内key有序、key落在父节点给出的范围内、
+   * 父指针正确、叶子在同一层且叶子链表有序。供测试使用
+   * @param key_count 返回叶子节点中key的总数
+   * @param leaf_count 返回叶子节点的个数
+   */
+  bool validate_tree(int *key_count = nullptr, int *leaf_count = nullptr);
+
+  bool prefix_compressed() const {
+    return file_header_.node_format == NODE_FORMAT_PREFIX;
+  }
+
+  /**
+   * 树的高度，只有一个叶子节点时是1
+   */
+  int height();
+
+  /**
+   * 设置常驻内存的上层内部节点个数上限，立即按新的上限重新缓存。create/open时取BplusTreeOptions中的值
+   */
+  RC set_upper_level_pages(int max_pages);
+
+  /**
+   * 当前缓存的内部节点个数和层数
+   */
+  int upper_level_pages() const;
+  int upper_level_depth() const;
 protected:
+  /**
+   * 在节点的有序key数组上二分查找，比较器按attr_type在编译期特化
+   * @return upper_bound返回第一个大于pkey的下标，lower_bound返回第一个大于等于pkey的下标
+   */
+  int upper_bound(const char *keys, int key_num, const char *pkey) const;
+  int lower_bound(const char *keys, int key_num, const char *pkey) const;
+
+  /**
+   * 在页面上的节点中二分查找，两种节点格式都不需要解码整个节点
+   */
+  int node_upper_bound(IndexNode *node, const char *pkey) const;
+  int node_lower_bound(IndexNode *node, const char *pkey) const;
+  PageNum node_child(IndexNode *node, int index) const;
+  /**
+   * 读者拷贝节点中的第index个key，节点头不合法时返回false
+   */
+  bool node_key(IndexNode *node, int index, char *key) const;
+  PageNum leaf_next_page(IndexNode *node) const;
+
+  /**
+   * 读者不加锁读取页面，可能读到写了一半的节点，解码前先检查节点头是否合法
+   */
+  bool node_consistent(IndexNode *node) const;
+  bool copy_leaf(IndexNode *node, LeafSnapshot &snapshot) const;
+
+  void load_node(IndexNode *node, NodeImage &image) const;
+  /**
+   * 把image编码写回页面，放不下时返回false，页面不变
+   */
+  bool store_node(const NodeImage &image, IndexNode *node) const;
+  bool node_fits(const NodeImage &image) const;
+  bool node_underfull(IndexNode *node) const;
+  bool node_underfull(const NodeImage &image) const;
+  RC load_node(PageNum page_num, NodeImage &image);
+  RC store_node(PageNum page_num, const NodeImage &image);
+  RC allocate_node(PageNum *page_num);
+  void make_separator(const char *left_last, const char *right_first, char *separator) const;
+  bool leaf_has_room(IndexNode *node, const char *pkey) const;
+
   RC find_leaf(const char *pkey, PageNum *leaf_page);
+  /**
+   * 在缓存的上层节点中查找pkey，返回第一个没有缓存的节点，pkey为空时一直向左走。
+   * low不为空时是倒序读取，走向key都小于pkey的最后一个孩子(pkey为空时一直向右走)，并在low中记下孩子的下界
+   */
+  PageNum descend_upper_levels(const char *pkey, std::vector<char> *low = nullptr) const;
+  /**
+   * 结构修改结束时调用，调用者持有smo_lock_的排他锁。没有变化的节点直接沿用，变化了的从页面重新解码
+   */
+  RC refresh_upper_levels();
   RC insert_into_leaf(PageNum leaf_page, const char *pkey, const RID *rid);
+  RC insert_into_prefix_leaf(IndexNode *node, const char *pkey);
   RC insert_into_leaf_after_split(PageNum leaf_page, const char *pkey, const RID *rid);
   RC insert_into_parent(PageNum parent_page, PageNum leaf_page, const char *pkey, PageNum right_page);
   RC insert_into_new_root(PageNum leaf_page, const char *pkey, PageNum right_page);
-  RC insert_intern_node(PageNum parent_page, PageNum leaf_page, PageNum right_page, const char *pkey);
-  RC insert_intern_node_after_split(PageNum intern_page, PageNum leaf_page, PageNum right_page, const char *pkey);
+  RC insert_intern_node_after_split(PageNum intern_page, NodeImage &intern_node);
 
   RC delete_entry_from_node(PageNum node_page, const char *pkey);
-  RC delete_entry_internal(PageNum page_num, const char *pkey);
-  RC coalesce_node(PageNum leaf_page, PageNum right_page);
-  RC redistribute_nodes(PageNum left_page, PageNum right_page);
+  RC rebalance_node(PageNum page_num);
+  RC rebalance_leaf(const std::string &pkey);
+  void add_rebalance(PageNum leaf_page, const char *pkey);
+  void rebalance_work();
+  void stop_rebalance();
+  RC coalesce_node(PageNum left_page, NodeImage &left, PageNum right_page, NodeImage &right,
+                   PageNum parent_page, NodeImage &parent, int index);
+  RC redistribute_nodes(PageNum left_page, NodeImage &left, PageNum right_page, NodeImage &right,
+                        PageNum parent_page, NodeImage &parent, int index, bool from_right);
+
+  RC bulk_load_leaves(KeySorter &sorter, float fill_factor, std::vector<PageNum> &pages, std::vector<char> &separators);
+  RC bulk_load_intern_level(float fill_factor, std::vector<PageNum> &pages, std::vector<char> &separators);
+  RC set_parent(PageNum page_num, PageNum parent);
+  RC flush_file_header();
+
+  /**
+   * 为节点上的修改记redo日志并标记脏页。定长格式只记节点头和从第from个key开始的部分，
+   * 前缀压缩格式的槽长度可能整体变化，记整个节点已使用的部分
+   */
+  RC log_node(BPPageHandle &page_handle, IndexNode *node, int from);
+  RC log_page_write(BPPageHandle &page_handle, const char *data, int length);
+
+  RC insert_entry_optimistic(const char *pkey, const RID *rid, bool *done);
+  RC read_leaf_optimistic(const char *pkey, PageNum page_num, uint64_t tree_version, LeafSnapshot &snapshot,
+                          std::vector<char> *low = nullptr);
+  RC dispose_node(PageNum page_num);
+  void dispose_deferred_nodes();
+  void add_to_bloom_filter(const char *pkey);
+  RC rebuild_bloom_filter();
+  void rebuild_bloom_filter_if_full();
+  RC save_bloom_filter();
+  int64_t bloom_filter_tag() const;
+  bool validate_node(PageNum page_num, PageNum parent, const char *lower, const char *upper,
+                     int depth, int *leaf_depth, std::vector<PageNum> &leaves, int *key_count);
+  VersionLatch &page_latch(PageNum page_num) {
+    return page_latches_[page_num % PAGE_LATCH_NUM];
+  }
 
-  RC find_first_index_satisfied(CompOp comp_op, const char *pkey, PageNum *page_num, int *rididx);
-  RC get_first_leaf_page(PageNum *leaf_page);
+  /**
+   * 页面被分裂、合并、回收或者删除数据后增加epoch，自适应哈希索引中指向这个页面的记录随之失效
+   */
+  void bump_page_epoch(PageNum page_num) {
+    page_epochs_[page_num % PAGE_LATCH_NUM].fetch_add(1, std::memory_order_release);
+  }
+  uint32_t page_epoch(PageNum page_num) const {
+    return page_epochs_[page_num % PAGE_LATCH_NUM].load(std::memory_order_acquire);
+  }
 
 private:
   IndexNode *get_index_node(char *page_data) const;
@@ -116,11 +423,59 @@ private:
 private:
   DiskBufferPool  * disk_buffer_pool_ = nullptr;
   int               file_id_ = -1;
-  bool              header_dirty_ = false;
   IndexFileHeader   file_header_;
+  std::string       file_name_;
+
+  /**
+   * Bloom过滤器，只记录key前bloom_key_length_个字节。重建时整体替换，读者通过atomic_load取得。
+   * 过滤器只在持有smo_lock_时添加key，重建时持有smo_lock_的排他锁，不会漏掉并发插入的key
+   */
+  std::shared_ptr<BloomFilter> bloom_filter_;
+  int               bloom_key_length_ = 0;
+  std::atomic<bool> bloom_persisted_{false};    // bloom_filter_file中的内容与当前的过滤器一致
+  std::atomic<bool> bloom_need_rebuild_{false}; // key的个数超过了过滤器的容量
+  std::atomic<long> bloom_probes_{0};
+  std::atomic<long> bloom_negatives_{0};
+  std::atomic<long> bloom_false_positives_{0};
+
+  /**
+   * 并发控制:
+   * - 只修改一个叶子节点的插入/删除持有smo_lock_的共享锁和叶子的page latch；
+   * - 分裂/合并等结构修改持有smo_lock_的排他锁，并修改tree_latch_的版本号；
+   * - 读者不加锁，读完叶子后校验tree_latch_和page latch的版本号，变化了就重试
+   */
+  static const int PAGE_LATCH_NUM = 1024;
+  std::shared_timed_mutex smo_lock_;
+  VersionLatch      tree_latch_;
+  VersionLatch      page_latches_[PAGE_LATCH_NUM];
+  std::atomic<uint32_t> page_epochs_[PAGE_LATCH_NUM] = {};
+
+  std::unique_ptr<AdaptiveHashIndex> adaptive_hash_;
+
+  /**
+   * 内部节点只在持有smo_lock_排他锁的结构修改中变化。修改过程中记下写过的内部节点，
+   * 修改结束、tree_latch_解锁之前重新生成缓存，读者通过atomic_load取得，读完叶子后照常校验版本号。
+   * changed_pages_不为空时缓存已经过期，find_leaf不再使用
+   */
+  std::shared_ptr<const UpperLevels> upper_levels_;
+  int               upper_level_pages_ = 0;
+  std::unordered_set<PageNum> changed_pages_;
+  std::vector<PageNum> deferred_disposes_;     // 摘掉时还被读者固定的节点，之后的结构修改或者sync时再释放
+
+  /**
+   * 删除后低于半满的叶子节点，记录的是叶子中删除的一个key。
+   * 页面可能在合并前被回收又被重新分配，合并时按key重新查找叶子节点
+   */
+  static const int REBALANCE_DELAY_MS = 20;   // 后台线程合并前等待的时间，连续的删除一起处理
+  mutable std::mutex rebalance_mutex_;
+  std::condition_variable rebalance_cond_;
+  std::map<PageNum, std::string> rebalance_pending_;
+  std::thread       rebalance_thread_;
+  bool              rebalance_stop_ = false;
 
 private:
   friend class BplusTreeScanner;
+  friend class BplusTreeReverseScanner;
 };
 
 class BplusTreeScanner {
@@ -134,12 +489,31 @@ public:
    */
   RC open(CompOp comp_op, const char *value);
 
+  /**
+   * 按key的前缀做范围扫描，只适用于可以直接memcmp比较的key(BYTES类型，组合索引)。
+   * 比较时只比较边界自身的长度，边界为空表示这一侧没有限制
+   */
+  RC open(const char *low, int low_length, bool low_inclusive,
+          const char *high, int high_length, bool high_inclusive);
+
   /**
    * 用于继续索引扫描，获得下一个满足条件的索引项，
    * 并返回该索引项对应的记录的ID
    */
   RC next_entry(RID *rid);
 
+  /**
+   * 同next_entry(rid)，同时把索引项的属性值(不含RID)拷贝到key中
+   */
+  RC next_entry(RID *rid, char *key);
+
+  /**
+   * 把等值扫描(或等值前缀扫描)换成新的值，用于按顺序连续做多次查找。
+   * 新的值落在当前叶子节点的范围内时直接在这个叶子中定位，不用再从根节点开始查找
+   * @param value 与open时的值长度相同，前缀扫描时是编码后的前缀
+   */
+  RC seek(const char *value);
+
   /**
    * 关闭一个索引扫描，释放相应的资源
    */
@@ -152,21 +526,51 @@ public:
   // RC getIndexTree(char *fileName, Tree *index);
 
 private:
-  RC get_next_idx_in_memory(RID *rid);
-  RC find_idx_pages();
+  RC locate();
+  RC fetch_next(RID *rid, char *key);
+  void check_bloom_filter(const char *key, int length);
   bool satisfy_condition(const char *key);
+  bool reach_end(const char *key);
 
 private:
   BplusTreeHandler   & index_handler_;
   bool opened_ = false;
   CompOp comp_op_ = NO_OP;                      // 用于比较的操作符
   const char *value_ = nullptr;		              // 与属性行比较的值
-  int num_fixed_pages_ = -1;                    // 固定在缓冲区中的页，与指定的页面固定策略有关
-  int pinned_page_count_ = 0;                   // 实际固定在缓冲区的页面数
-  BPPageHandle page_handles_[BP_BUFFER_SIZE];   // 固定在缓冲区页面所对应的页面操作列表
-  int next_index_of_page_handle_ = -1;          // 当前被扫描页面的操作索引
+  LeafSnapshot leaf_;                           // 当前正在扫描的叶子节点的拷贝
+  bool located_ = false;                        // leaf_是否有效
   int index_in_node_ = -1;                      // 当前B+ Tree页面上的key index
-  PageNum next_page_num_ = -1;                  // 下一个将要被读入的页面号
+  std::vector<char> last_key_;                  // 上一次返回的key，树结构变化后从这里重新定位
+  bool bloom_miss_ = false;                     // Bloom过滤器判断等值查找的值不存在
+  bool bloom_pending_ = false;                  // Bloom过滤器判断可能存在，还没有找到数据
+
+  bool prefix_scan_ = false;                    // 是否是按前缀的范围扫描
+  std::string low_;                             // 范围扫描的下界
+  bool low_inclusive_ = true;
+  std::string high_;                            // 范围扫描的上界
+  bool high_inclusive_ = true;
+};
+
+/**
+ * 从最后一个索引项开始倒序扫描整棵树。叶子节点没有指向前一个叶子的指针，
+ * 每读完一个叶子就用它的下界从根节点(经过缓存的上层节点)重新定位前一个叶子
+ */
+class BplusTreeReverseScanner {
+public:
+  BplusTreeReverseScanner(BplusTreeHandler &index_handler);
+
+  /**
+   * 返回前一个索引项的RID，key不为空时同时拷贝索引项的属性值(不含RID)
+   */
+  RC next_entry(RID *rid, char *key);
+
+private:
+  BplusTreeHandler   & index_handler_;
+  LeafSnapshot leaf_;                           // 当前正在扫描的叶子节点的拷贝
+  int index_in_node_ = -1;                      // 下一个返回的key在leaf_中的下标
+  std::vector<char> bound_;                     // 前面的叶子中的key都小于bound_
+  bool started_ = false;
+  bool finished_ = false;                       // leaf_是最左边的叶子
 };
 
 #endif //__OBSERVER_STORAGE_COMMON_INDEX_MANAGER_H_
\ No newline at end of file
@@ -13,34 +13,43 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/common/bplus_tree_index.h"
+#include "storage/common/key_comparator.h"
+#include "storage/common/key_sorter.h"
 #include "common/log/log.h"
 
 BplusTreeIndex::~BplusTreeIndex() noexcept {
   close();
 }
 
-RC BplusTreeIndex::create(const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) {
+RC BplusTreeIndex::create(const char *file_name, const IndexMeta &index_meta,
+                          const std::vector<FieldMeta> &field_metas, const std::vector<FieldMeta> &include_metas) {
   if (inited_) {
     return RC::RECORD_OPENNED;
   }
 
-  RC rc = Index::init(index_meta, field_meta);
+  RC rc = Index::init(index_meta, field_metas, include_metas);
   if (rc != RC::SUCCESS) {
     return rc;
   }
 
-  rc = index_handler_.create(file_name, field_meta.type(), field_meta.len());
+  rc = index_handler_.create(file_name, key_type_, key_length_, IndexBuildOptions::instance().prefix_compression);
   if (RC::SUCCESS == rc) {
     inited_ = true;
+    rc = enable_bloom_filter();
+  }
+  if (RC::SUCCESS == rc && index_meta_.adaptive_hash()) {
+    const AdaptiveHashOptions &options = AdaptiveHashOptions::instance();
+    rc = index_handler_.enable_adaptive_hash(options.memory_limit, options.hot_threshold);
   }
   return rc;
 }
 
-RC BplusTreeIndex::open(const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) {
+RC BplusTreeIndex::open(const char *file_name, const IndexMeta &index_meta,
+                        const std::vector<FieldMeta> &field_metas, const std::vector<FieldMeta> &include_metas) {
   if (inited_) {
     return RC::RECORD_OPENNED;
   }
-  RC rc = Index::init(index_meta, field_meta);
+  RC rc = Index::init(index_meta, field_metas, include_metas);
   if (rc != RC::SUCCESS) {
     return rc;
   }
@@ -48,6 +57,29 @@ RC BplusTreeIndex::open(const char *file_name, const IndexMeta &index_meta, cons
   rc = index_handler_.open(file_name);
   if (RC::SUCCESS == rc) {
     inited_ = true;
+    rc = enable_bloom_filter();
+  }
+  if (RC::SUCCESS == rc && index_meta_.adaptive_hash()) {
+    const AdaptiveHashOptions &options = AdaptiveHashOptions::instance();
+    rc = index_handler_.enable_adaptive_hash(options.memory_limit, options.hot_threshold);
+  }
+  return rc;
+}
+
+/**
+ * 过滤器只记录索引字段，不包含INCLUDE字段，只有所有索引字段都是等值条件时才能使用
+ */
+RC BplusTreeIndex::enable_bloom_filter() {
+  if (!index_meta_.bloom_filter()) {
+    return RC::SUCCESS;
+  }
+  int bloom_key_length = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    bloom_key_length += field_meta.len();
+  }
+  RC rc = index_handler_.enable_bloom_filter(bloom_key_length);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to enable bloom filter. index=%s, rc=%d:%s", index_meta_.name(), rc, strrc(rc));
   }
   return rc;
 }
@@ -61,11 +93,17 @@ RC BplusTreeIndex::close() {
 }
 
 RC BplusTreeIndex::insert_entry(const char *record, const RID *rid) {
-  return index_handler_.insert_entry(record + field_meta_.offset(), rid);
+  std::vector<char> buffer(key_type_ == BYTES ? key_length_ : 0);
+  return index_handler_.insert_entry(make_key(record, buffer.data()), rid);
 }
 
 RC BplusTreeIndex::delete_entry(const char *record, const RID *rid) {
-  return index_handler_.delete_entry(record + field_meta_.offset(), rid);
+  std::vector<char> buffer(key_type_ == BYTES ? key_length_ : 0);
+  return index_handler_.delete_entry(make_key(record, buffer.data()), rid);
+}
+
+RC BplusTreeIndex::bulk_load(KeySorter &sorter, float fill_factor) {
+  return index_handler_.bulk_load(sorter, fill_factor);
 }
 
 IndexScanner *BplusTreeIndex::create_scanner(CompOp comp_op, const char *value) {
@@ -81,8 +119,138 @@ IndexScanner *BplusTreeIndex::create_scanner(CompOp comp_op, const char *value)
   return index_scanner;
 }
 
-RC BplusTreeIndex::sync() {
-  return index_handler_.sync();
+IndexScanner *BplusTreeIndex::create_scanner(int eq_num, const char * const values[],
+                                             CompOp range_op, const char *range_value) {
+  const int field_num = field_metas_.size();
+  if (eq_num < 0 || eq_num > field_num || (eq_num == field_num && range_op != NO_OP)) {
+    LOG_ERROR("Invalid index scan. index=%s, field num=%d, eq num=%d", index_meta_.name(), field_num, eq_num);
+    return nullptr;
+  }
+
+  if (key_type_ != BYTES) {
+    if (eq_num == 1) {
+      return create_scanner(EQUAL_TO, values[0]);
+    }
+    return create_scanner(range_op, range_value);
+  }
+
+  // 组合索引(或带INCLUDE字段的索引)的key是各字段编码后拼接起来的，等值条件构成key的前缀
+  std::string prefix;
+  for (int i = 0; i < eq_num; i++) {
+    const FieldMeta &field_meta = field_metas_[i];
+    std::string value(field_meta.len(), '\0');
+    normalize_attr(field_meta.type(), field_meta.len(), values[i], &value[0]);
+    prefix += value;
+  }
+  std::string bound = prefix;
+  if (range_op != NO_OP) {
+    const FieldMeta &field_meta = field_metas_[eq_num];
+    std::string value(field_meta.len(), '\0');
+    normalize_attr(field_meta.type(), field_meta.len(), range_value, &value[0]);
+    bound += value;
+  }
+
+  const std::string *low = &prefix;
+  const std::string *high = &prefix;
+  bool low_inclusive = true;
+  bool high_inclusive = true;
+  switch (range_op) {
+    case GREAT_EQUAL:
+      low = &bound;
+      break;
+    case GREAT_THAN:
+      low = &bound;
+      low_inclusive = false;
+      break;
+    case LESS_EQUAL:
+      high = &bound;
+      break;
+    case LESS_THAN:
+      high = &bound;
+      high_inclusive = false;
+      break;
+    case EQUAL_TO:
+      low = &bound;
+      high = &bound;
+      break;
+    default:
+      break;
+  }
+
+  BplusTreeScanner *bplus_tree_scanner = new BplusTreeScanner(index_handler_);
+  RC rc = bplus_tree_scanner->open(low->data(), low->size(), low_inclusive, high->data(), high->size(), high_inclusive);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open index scanner. rc=%d:%s", rc, strrc(rc));
+    delete bplus_tree_scanner;
+    return nullptr;
+  }
+  return new BplusTreeIndexScanner(bplus_tree_scanner);
+}
+
+RC BplusTreeIndex::probe(const std::vector<const char *> &values, void *context,
+                         RC (*callback)(int probe, const RID &rid, void *context)) {
+  if (values.empty()) {
+    return RC::SUCCESS;
+  }
+
+  // 组合索引上查找的是第一个字段编码后的前缀
+  const FieldMeta &field_meta = field_metas_[0];
+  std::string key(field_meta.len(), '\0');
+  auto make_probe_key = [&](const char *value) {
+    if (key_type_ != BYTES) {
+      return value;
+    }
+    normalize_attr(field_meta.type(), field_meta.len(), value, &key[0]);
+    return (const char *)key.data();
+  };
+
+  BplusTreeScanner scanner(index_handler_);
+  RC rc;
+  if (key_type_ != BYTES) {
+    rc = scanner.open(EQUAL_TO, values[0]);
+  } else {
+    make_probe_key(values[0]);
+    rc = scanner.open(key.data(), key.size(), true, key.data(), key.size(), true);
+  }
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open index scanner. rc=%d:%s", rc, strrc(rc));
+    return rc;
+  }
+
+  for (int i = 0; i < (int)values.size(); i++) {
+    if (i > 0) {
+      rc = scanner.seek(make_probe_key(values[i]));
+      if (rc != RC::SUCCESS) {
+        break;
+      }
+    }
+    RID rid;
+    while ((rc = scanner.next_entry(&rid)) == RC::SUCCESS) {
+      rc = callback(i, rid, context);
+      if (rc != RC::SUCCESS) {
+        break;
+      }
+    }
+    if (rc != RC::RECORD_EOF) {
+      break;
+    }
+    rc = RC::SUCCESS;
+  }
+  scanner.close();
+  return rc;
+}
+
+IndexScanner *BplusTreeIndex::create_ordered_scanner(bool reverse) {
+  if (reverse) {
+    return new BplusTreeIndexReverseScanner(index_handler_);
+  }
+  // 没有条件的扫描从第一个叶子节点开始，value不参与比较
+  std::vector<char> value(key_length_, 0);
+  return create_scanner(NO_OP, value.data());
+}
+
+RC BplusTreeIndex::sync(bool flush_pages) {
+  return index_handler_.sync(flush_pages);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -99,7 +267,27 @@ RC BplusTreeIndexScanner::next_entry(RID *rid) {
   return tree_scanner_->next_entry(rid);
 }
 
+RC BplusTreeIndexScanner::next_entry(RID *rid, char *key) {
+  return tree_scanner_->next_entry(rid, key);
+}
+
 RC BplusTreeIndexScanner::destroy() {
   delete this;
   return RC::SUCCESS;
-}
\ No newline at end of file
+}
+BplusTreeIndexReverseScanner::BplusTreeIndexReverseScanner(BplusTreeHandler &index_handler) :
+    tree_scanner_(index_handler) {
+}
+
+RC BplusTreeIndexReverseScanner::next_entry(RID *rid) {
+  return tree_scanner_.next_entry(rid, nullptr);
+}
+
+RC BplusTreeIndexReverseScanner::next_entry(RID *rid, char *key) {
+  return tree_scanner_.next_entry(rid, key);
+}
+
+RC BplusTreeIndexReverseScanner::destroy() {
+  delete this;
+  return RC::SUCCESS;
+}
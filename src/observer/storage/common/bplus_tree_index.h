@@ -23,16 +23,43 @@ public:
   BplusTreeIndex() = default;
   virtual ~BplusTreeIndex() noexcept;
 
-  RC create(const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta);
-  RC open(const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta);
+  RC create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+            const std::vector<FieldMeta> &include_metas);
+  RC open(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+          const std::vector<FieldMeta> &include_metas);
   RC close();
 
   RC insert_entry(const char *record, const RID *rid) override;
   RC delete_entry(const char *record, const RID *rid) override;
 
   IndexScanner *create_scanner(CompOp comp_op, const char *value) override;
+  IndexScanner *create_scanner(int eq_num, const char * const values[],
+                               CompOp range_op, const char *range_value) override;
 
-  RC sync() override;
+  /**
+   * 用同一个扫描器依次查找，相邻的值在同一个叶子节点中时不用再从根节点开始查找
+   */
+  RC probe(const std::vector<const char *> &values, void *context,
+           RC (*callback)(int probe, const RID &rid, void *context)) override;
+
+  IndexScanner *create_ordered_scanner(bool reverse) override;
+
+  RC sync(bool flush_pages) override;
+
+  /**
+   * 用排好序的key批量构建一个新创建的空索引
+   */
+  RC bulk_load(KeySorter &sorter, float fill_factor);
+
+  BloomFilterStats bloom_filter_stats() const {
+    return index_handler_.bloom_filter_stats();
+  }
+  AdaptiveHashStats adaptive_hash_stats() const {
+    return index_handler_.adaptive_hash_stats();
+  }
+
+private:
+  RC enable_bloom_filter();
 
 private:
   bool inited_ = false;
@@ -45,9 +72,22 @@ public:
   ~BplusTreeIndexScanner() noexcept override;
 
   RC next_entry(RID *rid) override;
+  RC next_entry(RID *rid, char *key) override;
   RC destroy() override;
 private:
   BplusTreeScanner * tree_scanner_;
 };
 
+class BplusTreeIndexReverseScanner : public IndexScanner {
+public:
+  BplusTreeIndexReverseScanner(BplusTreeHandler &index_handler);
+  ~BplusTreeIndexReverseScanner() noexcept override = default;
+
+  RC next_entry(RID *rid) override;
+  RC next_entry(RID *rid, char *key) override;
+  RC destroy() override;
+private:
+  BplusTreeReverseScanner tree_scanner_;
+};
+
 #endif //__OBSERVER_STORAGE_COMMON_BPLUS_TREE_INDEX_H_
@@ -24,9 +24,12 @@ See the Mulan PSL v2 for more details. */
 #include "storage/common/table_meta.h"
 #include "storage/common/table.h"
 #include "storage/common/meta_util.h"
+#include "storage/clog/clog.h"
+#include "storage/trx/mvcc_manager.h"
 
 
 Db::~Db() {
+  wait_recover_trx();
   for (auto &iter : opened_tables_) {
     delete iter.second;
   }
@@ -48,10 +51,47 @@ RC Db::init(const char *name, const char *dbpath) {
   name_ = name;
   path_ = dbpath;
 
-  return open_all_tables();
+  RC rc = open_all_tables();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  // 重启前没有完成的事务在后台处理，不阻塞启动
+  if (theGlobalCLogManager()->enabled() && !opened_tables_.empty()) {
+    std::vector<Table *> tables;
+    for (const auto &iter : opened_tables_) {
+      tables.push_back(iter.second);
+    }
+    recover_trx_thread_ = std::thread(&Db::recover_trx, this, std::move(tables));
+  }
+  return rc;
+}
+
+void Db::recover_trx(std::vector<Table *> tables) {
+  CLogManager *clog_manager = theGlobalCLogManager();
+  const int32_t max_trx_id = clog_manager->recovered_trx_id();
+  RC rc = RC::SUCCESS;
+  for (Table *table : tables) {
+    RC rc2 = table->recover_trx(max_trx_id);
+    if (rc2 != RC::SUCCESS) {
+      LOG_ERROR("Failed to recover trx of table %s.%s. rc=%d:%s", name_.c_str(), table->name(), rc2, strrc(rc2));
+      rc = rc2;
+    }
+  }
+  // 只有一个库，处理完之后检查点不用再记录重启前正在提交的事务
+  if (rc == RC::SUCCESS) {
+    clog_manager->finish_trx_recovery();
+  }
+  LOG_INFO("Recover trx of db %s over. rc=%d:%s", name_.c_str(), rc, strrc(rc));
+}
+
+void Db::wait_recover_trx() {
+  if (recover_trx_thread_.joinable()) {
+    recover_trx_thread_.join();
+  }
 }
 
-RC Db::create_table(const char *table_name, int attribute_count, const AttrInfo *attributes) {
+RC Db::create_table(const char *table_name, int attribute_count, const AttrInfo *attributes, Durability durability) {
   RC rc = RC::SUCCESS;
   // check table_name
   if (opened_tables_.count(table_name) != 0) {
@@ -60,7 +100,7 @@ RC Db::create_table(const char *table_name, int attribute_count, const AttrInfo
 
   std::string table_file_path = table_meta_file(path_.c_str(), table_name); // 文件路径可以移到Table模块
   Table *table = new Table();
-  rc = table->create(table_file_path.c_str(), table_name, path_.c_str(), attribute_count, attributes);
+  rc = table->create(table_file_path.c_str(), table_name, path_.c_str(), attribute_count, attributes, durability);
   if (rc != RC::SUCCESS) {
     delete table;
     return rc;
@@ -87,6 +127,9 @@ RC Db::drop_table(const char* table_name) {
     if (nullptr == table) {
         return RC::SCHEMA_TABLE_NOT_EXIST;
     }
+    wait_recover_trx();
+    // 后台不再清理这个表上的旧版本
+    theGlobalMvccManager()->remove_table(table);
 
     std::string table_file_path = table_meta_file(path_.c_str(), table_name);
     // 删除与表相关的一切(table meta-data, table index, table data)
@@ -145,11 +188,11 @@ void Db::all_tables(std::vector<std::string> &table_names) const {
   }
 }
 
-RC Db::sync() {
+RC Db::sync(bool flush_pages) {
   RC rc = RC::SUCCESS;
   for (const auto &table_pair: opened_tables_) {
     Table *table = table_pair.second;
-    rc = table->sync();
+    rc = table->sync(flush_pages);
     if (rc != RC::SUCCESS) {
       LOG_ERROR("Failed to flush table. table=%s.%s, rc=%d:%s", name_.c_str(), table->name(), rc, strrc(rc));
       return rc;
@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 
 #include <vector>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "rc.h"
@@ -31,7 +32,8 @@ public:
 
   RC init(const char *name, const char *dbpath);
 
-  RC create_table(const char *table_name, int attribute_count, const AttrInfo *attributes);
+  RC create_table(const char *table_name, int attribute_count, const AttrInfo *attributes,
+                  Durability durability = DURABILITY_DEFAULT);
 
   RC drop_table(const char* table_name);
 
@@ -41,14 +43,21 @@ public:
 
   void all_tables(std::vector<std::string> &table_names) const;
 
-  RC sync();
+  RC sync(bool flush_pages);
 private:
   RC open_all_tables();
 
+  /**
+   * 在后台处理重启前的事务留在各个表上的事务号，参考Table::recover_trx
+   */
+  void recover_trx(std::vector<Table *> tables);
+  void wait_recover_trx();
+
 private:
   std::string   name_;
   std::string   path_;
   std::unordered_map<std::string, Table *>  opened_tables_;
+  std::thread   recover_trx_thread_;
 };
 
 #endif // __OBSERVER_STORAGE_COMMON_DB_H__
\ No newline at end of file
@@ -0,0 +1,607 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "storage/common/extendible_hash.h"
+#include "storage/common/key_comparator.h"
+#include "common/log/log.h"
+
+static const int DIRECTORY_ENTRIES_PER_PAGE = BP_PAGE_DATA_SIZE / sizeof(PageNum);
+static const int MAX_DIRECTORY_PAGES = (BP_PAGE_DATA_SIZE - sizeof(HashFileHeader)) / sizeof(PageNum);
+
+static PageNum *get_directory_pages(char *pdata) {
+  return (PageNum *)(pdata + sizeof(HashFileHeader));
+}
+
+static char *bucket_entries(HashBucket *bucket) {
+  return (char *)bucket + sizeof(HashBucket);
+}
+
+/**
+ * 文件头之后能记录的目录页面个数限制了目录的最大深度
+ */
+static int max_directory_depth() {
+  int depth = 0;
+  while ((2L << depth) <= (long)MAX_DIRECTORY_PAGES * DIRECTORY_ENTRIES_PER_PAGE) {
+    depth++;
+  }
+  return depth;
+}
+
+int AttrDataOperator::compare(const void *data1, const void *data2) const {
+  const char *v1 = (const char *)data1;
+  const char *v2 = (const char *)data2;
+  switch (attr_type_) {
+    case INTS:
+      return AttrComparator<INTS>::compare(v1, v2, attr_length_);
+    case DATES:
+      return AttrComparator<DATES>::compare(v1, v2, attr_length_);
+    case FLOATS:
+      return AttrComparator<FLOATS>::compare(v1, v2, attr_length_);
+    case CHARS:
+      return AttrComparator<CHARS>::compare(v1, v2, attr_length_);
+    case BYTES:
+    default:
+      return AttrComparator<BYTES>::compare(v1, v2, attr_length_);
+  }
+}
+
+size_t AttrDataOperator::hash(const void *data) const {
+  const char *value = (const char *)data;
+  int length = attr_length_;
+  switch (attr_type_) {
+    case CHARS: {
+      length = strnlen(value, attr_length_);
+    } break;
+    default:
+      break;
+  }
+
+  // FNV-1a。目录使用的是哈希值的低位，最后再混合一次
+  uint64_t h = 14695981039346656037ULL;
+  for (int i = 0; i < length; i++) {
+    h ^= (uint8_t)value[i];
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (size_t)h;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ExtendibleHashHandler::~ExtendibleHashHandler() {
+  if (disk_buffer_pool_ != nullptr) {
+    close();
+  }
+}
+
+RC ExtendibleHashHandler::create(const char *file_name, AttrType attr_type, int attr_length) {
+  if (disk_buffer_pool_ != nullptr) {
+    return RC::RECORD_OPENNED;
+  }
+
+  if (attr_type == FLOATS) {
+    // 浮点数比较时差值小于1e-6就相等，相等的值哈希到的桶可能不同
+    LOG_WARN("Hash index does not support float key. file name=%s", file_name);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  DiskBufferPool *disk_buffer_pool = theGlobalDiskBufferPool();
+  RC rc = disk_buffer_pool->create_file(file_name);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  int file_id;
+  rc = disk_buffer_pool->open_file(file_name, &file_id);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open file. file name=%s, rc=%d:%s", file_name, rc, strrc(rc));
+    return rc;
+  }
+
+  // 第一个页面是文件头
+  BPPageHandle page_handle;
+  rc = disk_buffer_pool->allocate_page(file_id, &page_handle);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to allocate page. file name=%s, rc=%d:%s", file_name, rc, strrc(rc));
+    disk_buffer_pool->close_file(file_id);
+    return rc;
+  }
+  disk_buffer_pool->unpin_page(&page_handle);
+
+  memset(&file_header_, 0, sizeof(file_header_));
+  file_header_.attr_length = attr_length;
+  file_header_.entry_length = attr_length + sizeof(RID);
+  file_header_.attr_type = attr_type;
+  file_header_.bucket_capacity = (BP_PAGE_DATA_SIZE - sizeof(HashBucket)) / file_header_.entry_length;
+  file_header_.global_depth = 0;
+  file_header_.directory_page_num = 0;
+
+  disk_buffer_pool_ = disk_buffer_pool;
+  file_id_ = file_id;
+  data_operator_ = new AttrDataOperator(attr_type, attr_length);
+  max_global_depth_ = max_directory_depth();
+
+  // 初始只有一个桶
+  PageNum bucket_page;
+  rc = allocate_bucket(0, &bucket_page);
+  if (rc != RC::SUCCESS) {
+    close();
+    return rc;
+  }
+  directory_.clear();
+  directory_.push_back(bucket_page);
+  directory_dirty_.clear();
+  directory_pages_.clear();
+  header_dirty_ = true;
+  rc = flush_directory();
+  if (rc != RC::SUCCESS) {
+    close();
+  }
+  return rc;
+}
+
+RC ExtendibleHashHandler::open(const char *file_name) {
+  if (disk_buffer_pool_ != nullptr) {
+    return RC::RECORD_OPENNED;
+  }
+
+  DiskBufferPool *disk_buffer_pool = theGlobalDiskBufferPool();
+  int file_id;
+  RC rc = disk_buffer_pool->open_file(file_name, &file_id);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  BPPageHandle page_handle;
+  char *pdata;
+  rc = disk_buffer_pool->get_this_page(file_id, 1, &page_handle);
+  if (rc != RC::SUCCESS) {
+    disk_buffer_pool->close_file(file_id);
+    return rc;
+  }
+  disk_buffer_pool->get_data(&page_handle, &pdata);
+  memcpy(&file_header_, pdata, sizeof(file_header_));
+  directory_pages_.assign(get_directory_pages(pdata), get_directory_pages(pdata) + file_header_.directory_page_num);
+  disk_buffer_pool->unpin_page(&page_handle);
+
+  // 把目录加载到内存中
+  const int directory_size = 1 << file_header_.global_depth;
+  directory_.resize(directory_size);
+  for (int i = 0; i < (int)directory_pages_.size(); i++) {
+    rc = disk_buffer_pool->get_this_page(file_id, directory_pages_[i], &page_handle);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to load directory page. file name=%s, page=%d, rc=%d:%s",
+                file_name, directory_pages_[i], rc, strrc(rc));
+      disk_buffer_pool->close_file(file_id);
+      return rc;
+    }
+    disk_buffer_pool->get_data(&page_handle, &pdata);
+    int begin = i * DIRECTORY_ENTRIES_PER_PAGE;
+    int end = std::min(directory_size, begin + DIRECTORY_ENTRIES_PER_PAGE);
+    memcpy(directory_.data() + begin, pdata, (end - begin) * sizeof(PageNum));
+    disk_buffer_pool->unpin_page(&page_handle);
+  }
+  directory_dirty_.assign(directory_pages_.size(), false);
+  header_dirty_ = false;
+
+  disk_buffer_pool_ = disk_buffer_pool;
+  file_id_ = file_id;
+  data_operator_ = new AttrDataOperator(file_header_.attr_type, file_header_.attr_length);
+  max_global_depth_ = max_directory_depth();
+  return RC::SUCCESS;
+}
+
+RC ExtendibleHashHandler::close() {
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::SUCCESS;
+  }
+  sync();
+  disk_buffer_pool_->close_file(file_id_);
+  disk_buffer_pool_ = nullptr;
+  file_id_ = -1;
+  delete data_operator_;
+  data_operator_ = nullptr;
+  return RC::SUCCESS;
+}
+
+RC ExtendibleHashHandler::sync() {
+  std::unique_lock<std::shared_timed_mutex> guard(lock_);
+  RC rc = flush_directory();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  return disk_buffer_pool_->flush_all_pages(file_id_);
+}
+
+size_t ExtendibleHashHandler::hash(const char *pkey) const {
+  return data_operator_->hash(pkey);
+}
+
+PageNum ExtendibleHashHandler::bucket_of(size_t hash_value) const {
+  return directory_[hash_value & (directory_.size() - 1)];
+}
+
+RC ExtendibleHashHandler::get_bucket(PageNum page_num, BPPageHandle *page_handle, HashBucket **bucket) {
+  RC rc = disk_buffer_pool_->get_this_page(file_id_, page_num, page_handle);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to get bucket page. page=%d, rc=%d:%s", page_num, rc, strrc(rc));
+    return rc;
+  }
+  char *pdata;
+  disk_buffer_pool_->get_data(page_handle, &pdata);
+  *bucket = (HashBucket *)pdata;
+  return RC::SUCCESS;
+}
+
+RC ExtendibleHashHandler::allocate_bucket(int local_depth, PageNum *page_num) {
+  BPPageHandle page_handle;
+  RC rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to allocate bucket page. rc=%d:%s", rc, strrc(rc));
+    return rc;
+  }
+  char *pdata;
+  disk_buffer_pool_->get_data(&page_handle, &pdata);
+  disk_buffer_pool_->get_page_num(&page_handle, page_num);
+  HashBucket *bucket = (HashBucket *)pdata;
+  bucket->local_depth = local_depth;
+  bucket->entry_num = 0;
+  bucket->overflow_page = 0;
+  disk_buffer_pool_->mark_dirty(&page_handle);
+  disk_buffer_pool_->unpin_page(&page_handle);
+  return RC::SUCCESS;
+}
+
+void ExtendibleHashHandler::set_directory(int index, PageNum page_num) {
+  directory_[index] = page_num;
+  directory_dirty_[index / DIRECTORY_ENTRIES_PER_PAGE] = true;
+}
+
+/**
+ * 把修改过的目录页面和文件头写回buffer pool，目录变大时分配新的目录页面
+ */
+RC ExtendibleHashHandler::flush_directory() {
+  RC rc = RC::SUCCESS;
+  const int directory_size = directory_.size();
+  const int page_num = (directory_size + DIRECTORY_ENTRIES_PER_PAGE - 1) / DIRECTORY_ENTRIES_PER_PAGE;
+  BPPageHandle page_handle;
+  char *pdata;
+  while ((int)directory_pages_.size() < page_num) {
+    rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to allocate directory page. rc=%d:%s", rc, strrc(rc));
+      return rc;
+    }
+    PageNum directory_page;
+    disk_buffer_pool_->get_page_num(&page_handle, &directory_page);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    directory_pages_.push_back(directory_page);
+    directory_dirty_.push_back(true);
+    header_dirty_ = true;
+  }
+
+  for (int i = 0; i < page_num; i++) {
+    if (!directory_dirty_[i]) {
+      continue;
+    }
+    rc = disk_buffer_pool_->get_this_page(file_id_, directory_pages_[i], &page_handle);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to get directory page. page=%d, rc=%d:%s", directory_pages_[i], rc, strrc(rc));
+      return rc;
+    }
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    int begin = i * DIRECTORY_ENTRIES_PER_PAGE;
+    int end = std::min(directory_size, begin + DIRECTORY_ENTRIES_PER_PAGE);
+    memcpy(pdata, directory_.data() + begin, (end - begin) * sizeof(PageNum));
+    disk_buffer_pool_->mark_dirty(&page_handle);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    directory_dirty_[i] = false;
+  }
+
+  if (header_dirty_) {
+    rc = disk_buffer_pool_->get_this_page(file_id_, 1, &page_handle);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to get hash index file header page. rc=%d:%s", rc, strrc(rc));
+      return rc;
+    }
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    file_header_.directory_page_num = directory_pages_.size();
+    memcpy(pdata, &file_header_, sizeof(file_header_));
+    memcpy(get_directory_pages(pdata), directory_pages_.data(), directory_pages_.size() * sizeof(PageNum));
+    disk_buffer_pool_->mark_dirty(&page_handle);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    header_dirty_ = false;
+  }
+  return rc;
+}
+
+/**
+ * 在桶和它的溢出页中查找属性值和RID都相同的项
+ */
+RC ExtendibleHashHandler::find_entry(PageNum page_num, const char *entry, bool *found) {
+  const int entry_length = file_header_.entry_length;
+  const int attr_length = file_header_.attr_length;
+  *found = false;
+  while (page_num != 0 && !*found) {
+    BPPageHandle page_handle;
+    HashBucket *bucket;
+    RC rc = get_bucket(page_num, &page_handle, &bucket);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    const char *entries = bucket_entries(bucket);
+    for (int i = 0; i < bucket->entry_num; i++) {
+      const char *current = entries + i * entry_length;
+      if (0 == memcmp(current + attr_length, entry + attr_length, sizeof(RID)) &&
+          0 == data_operator_->compare(current, entry)) {
+        *found = true;
+        break;
+      }
+    }
+    page_num = bucket->overflow_page;
+    disk_buffer_pool_->unpin_page(&page_handle);
+  }
+  return RC::SUCCESS;
+}
+
+/**
+ * 把索引项放到桶中，桶满了就放到溢出页中
+ */
+RC ExtendibleHashHandler::append_entry(PageNum page_num, const char *entry) {
+  const int entry_length = file_header_.entry_length;
+  while (true) {
+    BPPageHandle page_handle;
+    HashBucket *bucket;
+    RC rc = get_bucket(page_num, &page_handle, &bucket);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    if (bucket->entry_num < file_header_.bucket_capacity) {
+      memcpy(bucket_entries(bucket) + bucket->entry_num * entry_length, entry, entry_length);
+      bucket->entry_num++;
+      disk_buffer_pool_->mark_dirty(&page_handle);
+      disk_buffer_pool_->unpin_page(&page_handle);
+      return RC::SUCCESS;
+    }
+
+    if (bucket->overflow_page == 0) {
+      PageNum overflow_page;
+      rc = allocate_bucket(bucket->local_depth, &overflow_page);
+      if (rc != RC::SUCCESS) {
+        disk_buffer_pool_->unpin_page(&page_handle);
+        return rc;
+      }
+      bucket->overflow_page = overflow_page;
+      disk_buffer_pool_->mark_dirty(&page_handle);
+    }
+    page_num = bucket->overflow_page;
+    disk_buffer_pool_->unpin_page(&page_handle);
+  }
+}
+
+/**
+ * 按哈希值的第local_depth位把桶分成两个。
+ * 桶中所有项和要插入的项哈希值都相同时分裂没有用，splitted返回false，由调用者放到溢出页中
+ */
+RC ExtendibleHashHandler::split_bucket(PageNum page_num, size_t hash_value, bool *splitted) {
+  const int entry_length = file_header_.entry_length;
+  *splitted = false;
+
+  BPPageHandle page_handle;
+  HashBucket *bucket;
+  RC rc = get_bucket(page_num, &page_handle, &bucket);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  const int local_depth = bucket->local_depth;
+  bool same_hash = true;
+  for (int i = 0; i < bucket->entry_num && same_hash; i++) {
+    same_hash = hash(bucket_entries(bucket) + i * entry_length) == hash_value;
+  }
+  if (same_hash || local_depth >= max_global_depth_) {
+    disk_buffer_pool_->unpin_page(&page_handle);
+    return RC::SUCCESS;
+  }
+
+  // 取出桶和溢出页中的所有项，释放溢出页
+  std::vector<char> entries(bucket_entries(bucket), bucket_entries(bucket) + bucket->entry_num * entry_length);
+  PageNum overflow_page = bucket->overflow_page;
+  bucket->local_depth = local_depth + 1;
+  bucket->entry_num = 0;
+  bucket->overflow_page = 0;
+  disk_buffer_pool_->mark_dirty(&page_handle);
+  disk_buffer_pool_->unpin_page(&page_handle);
+  while (overflow_page != 0) {
+    rc = get_bucket(overflow_page, &page_handle, &bucket);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    entries.insert(entries.end(), bucket_entries(bucket), bucket_entries(bucket) + bucket->entry_num * entry_length);
+    PageNum next_page = bucket->overflow_page;
+    disk_buffer_pool_->unpin_page(&page_handle);
+    disk_buffer_pool_->dispose_page(file_id_, overflow_page);
+    overflow_page = next_page;
+  }
+
+  if (local_depth == file_header_.global_depth) {
+    // 目录扩大一倍，新的一半与原来的一半指向相同的桶
+    const int directory_size = directory_.size();
+    directory_.resize(directory_size * 2);
+    directory_dirty_.resize((directory_size * 2 + DIRECTORY_ENTRIES_PER_PAGE - 1) / DIRECTORY_ENTRIES_PER_PAGE, true);
+    for (int i = 0; i < directory_size; i++) {
+      set_directory(i + directory_size, directory_[i]);
+    }
+    file_header_.global_depth++;
+    header_dirty_ = true;
+  }
+
+  PageNum new_page;
+  rc = allocate_bucket(local_depth + 1, &new_page);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  const size_t split_bit = (size_t)1 << local_depth;
+  for (int i = 0; i < (int)directory_.size(); i++) {
+    if (directory_[i] == page_num && (i & split_bit) != 0) {
+      set_directory(i, new_page);
+    }
+  }
+
+  for (size_t offset = 0; offset < entries.size(); offset += entry_length) {
+    const char *entry = entries.data() + offset;
+    rc = append_entry((hash(entry) & split_bit) != 0 ? new_page : page_num, entry);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  rc = flush_directory();
+  if (rc == RC::SUCCESS) {
+    *splitted = true;
+  }
+  return rc;
+}
+
+RC ExtendibleHashHandler::insert_entry(const char *pkey, const RID *rid) {
+  std::unique_lock<std::shared_timed_mutex> guard(lock_);
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::RECORD_CLOSED;
+  }
+
+  std::vector<char> entry(file_header_.entry_length);
+  memcpy(entry.data(), pkey, file_header_.attr_length);
+  memcpy(entry.data() + file_header_.attr_length, rid, sizeof(RID));
+
+  const size_t hash_value = hash(pkey);
+  bool found = false;
+  RC rc = find_entry(bucket_of(hash_value), entry.data(), &found);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  if (found) {
+    return RC::RECORD_DUPLICATE_KEY;
+  }
+
+  while (true) {
+    PageNum page_num = bucket_of(hash_value);
+    BPPageHandle page_handle;
+    HashBucket *bucket;
+    rc = get_bucket(page_num, &page_handle, &bucket);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    bool full = bucket->entry_num >= file_header_.bucket_capacity;
+    disk_buffer_pool_->unpin_page(&page_handle);
+    if (!full) {
+      return append_entry(page_num, entry.data());
+    }
+
+    bool splitted = false;
+    rc = split_bucket(page_num, hash_value, &splitted);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to split bucket. page=%d, rc=%d:%s", page_num, rc, strrc(rc));
+      return rc;
+    }
+    if (!splitted) {
+      return append_entry(page_num, entry.data());
+    }
+  }
+}
+
+RC ExtendibleHashHandler::delete_entry(const char *pkey, const RID *rid) {
+  std::unique_lock<std::shared_timed_mutex> guard(lock_);
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::RECORD_CLOSED;
+  }
+
+  const int entry_length = file_header_.entry_length;
+  const int attr_length = file_header_.attr_length;
+  PageNum prev_page = 0;
+  PageNum page_num = bucket_of(hash(pkey));
+  while (page_num != 0) {
+    BPPageHandle page_handle;
+    HashBucket *bucket;
+    RC rc = get_bucket(page_num, &page_handle, &bucket);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    char *entries = bucket_entries(bucket);
+    for (int i = 0; i < bucket->entry_num; i++) {
+      char *current = entries + i * entry_length;
+      if (0 != memcmp(current + attr_length, rid, sizeof(RID)) || 0 != data_operator_->compare(current, pkey)) {
+        continue;
+      }
+
+      // 用最后一项填补空位
+      bucket->entry_num--;
+      memmove(current, entries + bucket->entry_num * entry_length, entry_length);
+      PageNum next_page = bucket->overflow_page;
+      bool empty_overflow = prev_page != 0 && bucket->entry_num == 0;
+      disk_buffer_pool_->mark_dirty(&page_handle);
+      disk_buffer_pool_->unpin_page(&page_handle);
+
+      // 空的溢出页从链表中摘掉
+      if (empty_overflow) {
+        rc = get_bucket(prev_page, &page_handle, &bucket);
+        if (rc != RC::SUCCESS) {
+          return rc;
+        }
+        bucket->overflow_page = next_page;
+        disk_buffer_pool_->mark_dirty(&page_handle);
+        disk_buffer_pool_->unpin_page(&page_handle);
+        disk_buffer_pool_->dispose_page(file_id_, page_num);
+      }
+      return RC::SUCCESS;
+    }
+    prev_page = page_num;
+    page_num = bucket->overflow_page;
+    disk_buffer_pool_->unpin_page(&page_handle);
+  }
+  return RC::RECORD_INVALID_KEY;
+}
+
+RC ExtendibleHashHandler::get_entries(const char *pkey, std::vector<RID> &rids) {
+  std::shared_lock<std::shared_timed_mutex> guard(lock_);
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::RECORD_CLOSED;
+  }
+
+  const int entry_length = file_header_.entry_length;
+  const int attr_length = file_header_.attr_length;
+  PageNum page_num = bucket_of(hash(pkey));
+  while (page_num != 0) {
+    BPPageHandle page_handle;
+    HashBucket *bucket;
+    RC rc = get_bucket(page_num, &page_handle, &bucket);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    const char *entries = bucket_entries(bucket);
+    for (int i = 0; i < bucket->entry_num; i++) {
+      const char *current = entries + i * entry_length;
+      if (0 == data_operator_->compare(current, pkey)) {
+        rids.push_back(*(const RID *)(current + attr_length));
+      }
+    }
+    page_num = bucket->overflow_page;
+    disk_buffer_pool_->unpin_page(&page_handle);
+  }
+  return RC::SUCCESS;
+}
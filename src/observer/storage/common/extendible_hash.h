@@ -0,0 +1,124 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_EXTENDIBLE_HASH_H_
+#define __OBSERVER_STORAGE_COMMON_EXTENDIBLE_HASH_H_
+
+#include <shared_mutex>
+#include <vector>
+
+#include "storage/common/index.h"
+#include "storage/common/record_manager.h"
+#include "storage/default/disk_buffer_pool.h"
+#include "sql/parser/parse_defs.h"
+
+/**
+ * 按属性类型比较和计算哈希值。
+ * 与B+树的比较规则保持一致: 字符串只看结束符之前的部分。
+ * 浮点数按误差比较，无法得到一致的哈希值，哈希索引不支持浮点数
+ */
+class AttrDataOperator : public IndexDataOperator {
+public:
+  AttrDataOperator(AttrType attr_type, int attr_length) : attr_type_(attr_type), attr_length_(attr_length) {
+  }
+
+  int compare(const void *data1, const void *data2) const override;
+  size_t hash(const void *data) const override;
+
+private:
+  AttrType attr_type_;
+  int      attr_length_;
+};
+
+/**
+ * 哈希索引文件的第一个页面
+ */
+struct HashFileHeader {
+  int      attr_length;
+  int      entry_length;          // 索引项长度: 属性值 + RID
+  AttrType attr_type;
+  int      bucket_capacity;       // 一个桶页面最多保存的索引项个数
+  int      global_depth;          // 目录大小为 2^global_depth
+  int      directory_page_num;    // 目录占用的页面个数，页面号紧跟在文件头之后
+};
+
+/**
+ * 桶页面。桶装不下并且无法分裂时(所有项的哈希值都相同)，通过overflow_page串起溢出页
+ */
+struct HashBucket {
+  int     local_depth;
+  int     entry_num;
+  PageNum overflow_page;          // 0表示没有溢出页，索引项紧跟在后面
+};
+
+/**
+ * 可扩展哈希(extendible hashing)。
+ * 目录常驻内存，修改后写回目录页面，所以一次等值查找一般只需要读取一个桶页面。
+ * 桶满时按哈希值的下一位分裂，桶的深度等于全局深度时先把目录扩大一倍。
+ * 删除不合并桶
+ */
+class ExtendibleHashHandler {
+public:
+  ExtendibleHashHandler() = default;
+  ~ExtendibleHashHandler();
+
+  RC create(const char *file_name, AttrType attr_type, int attr_length);
+  RC open(const char *file_name);
+  RC close();
+  RC sync();
+
+  /**
+   * 插入一个索引项，属性值和RID都相同的项已经存在时返回RECORD_DUPLICATE_KEY
+   */
+  RC insert_entry(const char *pkey, const RID *rid);
+  RC delete_entry(const char *pkey, const RID *rid);
+
+  /**
+   * 找出属性值等于pkey的所有索引项的RID
+   */
+  RC get_entries(const char *pkey, std::vector<RID> &rids);
+
+  const HashFileHeader &file_header() const {
+    return file_header_;
+  }
+  int global_depth() const {
+    return file_header_.global_depth;
+  }
+
+private:
+  size_t hash(const char *pkey) const;
+  PageNum bucket_of(size_t hash_value) const;
+
+  RC get_bucket(PageNum page_num, BPPageHandle *page_handle, HashBucket **bucket);
+  RC allocate_bucket(int local_depth, PageNum *page_num);
+  RC find_entry(PageNum page_num, const char *entry, bool *found);
+  RC append_entry(PageNum page_num, const char *entry);
+  RC split_bucket(PageNum page_num, size_t hash_value, bool *splitted);
+  void set_directory(int index, PageNum page_num);
+  RC flush_directory();
+
+private:
+  DiskBufferPool *       disk_buffer_pool_ = nullptr;
+  int                    file_id_ = -1;
+  HashFileHeader         file_header_;
+  AttrDataOperator *     data_operator_ = nullptr;
+  std::vector<PageNum>   directory_;           // 内存中的目录
+  std::vector<PageNum>   directory_pages_;     // 保存目录的页面
+  std::vector<bool>      directory_dirty_;     // 每个目录页面是否需要写回
+  bool                   header_dirty_ = false;
+  int                    max_global_depth_ = 0;
+  std::shared_timed_mutex lock_;               // 查找持有共享锁，修改持有排他锁
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_EXTENDIBLE_HASH_H_
@@ -0,0 +1,144 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include "storage/common/hash_index.h"
+#include "storage/common/key_comparator.h"
+#include "common/log/log.h"
+
+HashIndex::~HashIndex() noexcept {
+  close();
+}
+
+RC HashIndex::create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas) {
+  if (inited_) {
+    return RC::RECORD_OPENNED;
+  }
+
+  RC rc = Index::init(index_meta, field_metas, std::vector<FieldMeta>());
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  rc = index_handler_.create(file_name, key_type_, key_length_);
+  if (RC::SUCCESS == rc) {
+    inited_ = true;
+  }
+  return rc;
+}
+
+RC HashIndex::open(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas) {
+  if (inited_) {
+    return RC::RECORD_OPENNED;
+  }
+  RC rc = Index::init(index_meta, field_metas, std::vector<FieldMeta>());
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  rc = index_handler_.open(file_name);
+  if (RC::SUCCESS == rc) {
+    inited_ = true;
+  }
+  return rc;
+}
+
+RC HashIndex::close() {
+  if (inited_) {
+    index_handler_.close();
+    inited_ = false;
+  }
+  return RC::SUCCESS;
+}
+
+RC HashIndex::insert_entry(const char *record, const RID *rid) {
+  std::vector<char> buffer(key_type_ == BYTES ? key_length_ : 0);
+  return index_handler_.insert_entry(make_key(record, buffer.data()), rid);
+}
+
+RC HashIndex::delete_entry(const char *record, const RID *rid) {
+  std::vector<char> buffer(key_type_ == BYTES ? key_length_ : 0);
+  return index_handler_.delete_entry(make_key(record, buffer.data()), rid);
+}
+
+IndexScanner *HashIndex::create_scanner(CompOp comp_op, const char *value) {
+  if (comp_op != EQUAL_TO || key_type_ == BYTES) {
+    LOG_ERROR("Hash index only supports equality lookups on all fields. index=%s", index_meta_.name());
+    return nullptr;
+  }
+  const char *values[] = {value};
+  return create_scanner(1, values, NO_OP, nullptr);
+}
+
+IndexScanner *HashIndex::create_scanner(int eq_num, const char * const values[],
+                                        CompOp range_op, const char *range_value) {
+  if (eq_num != (int)field_metas_.size() || range_op != NO_OP) {
+    LOG_ERROR("Hash index only supports equality lookups on all fields. index=%s, eq num=%d",
+              index_meta_.name(), eq_num);
+    return nullptr;
+  }
+
+  std::string key;
+  if (key_type_ != BYTES) {
+    key.assign(values[0], key_length_);
+  } else {
+    key.resize(key_length_);
+    char *pos = &key[0];
+    for (int i = 0; i < eq_num; i++) {
+      const FieldMeta &field_meta = field_metas_[i];
+      pos += normalize_attr(field_meta.type(), field_meta.len(), values[i], pos);
+    }
+  }
+
+  HashIndexScanner *scanner = new HashIndexScanner(key.data(), key_length_);
+  RC rc = index_handler_.get_entries(key.data(), scanner->rids());
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to lookup hash index. index=%s, rc=%d:%s", index_meta_.name(), rc, strrc(rc));
+    delete scanner;
+    return nullptr;
+  }
+  return scanner;
+}
+
+RC HashIndex::sync(bool flush_pages) {
+  if (!flush_pages) {
+    // 哈希索引的状态都在页面上，崩溃之后从表中重建
+    return RC::SUCCESS;
+  }
+  return index_handler_.sync();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+HashIndexScanner::HashIndexScanner(const char *key, int key_length) : key_(key, key_length) {
+}
+
+RC HashIndexScanner::next_entry(RID *rid) {
+  if (index_ >= rids_.size()) {
+    return RC::RECORD_EOF;
+  }
+  *rid = rids_[index_++];
+  return RC::SUCCESS;
+}
+
+RC HashIndexScanner::next_entry(RID *rid, char *key) {
+  RC rc = next_entry(rid);
+  if (rc == RC::SUCCESS) {
+    memcpy(key, key_.data(), key_.size());
+  }
+  return rc;
+}
+
+RC HashIndexScanner::destroy() {
+  delete this;
+  return RC::SUCCESS;
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_HASH_INDEX_H_
+#define __OBSERVER_STORAGE_COMMON_HASH_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "storage/common/index.h"
+#include "storage/common/extendible_hash.h"
+
+/**
+ * 基于可扩展哈希的索引，只支持所有字段上的等值查找
+ */
+class HashIndex : public Index {
+public:
+  HashIndex() = default;
+  virtual ~HashIndex() noexcept;
+
+  RC create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas);
+  RC open(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas);
+  RC close();
+
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
+
+  IndexScanner *create_scanner(CompOp comp_op, const char *value) override;
+  IndexScanner *create_scanner(int eq_num, const char * const values[],
+                               CompOp range_op, const char *range_value) override;
+
+  RC sync(bool flush_pages) override;
+
+private:
+  bool inited_ = false;
+  ExtendibleHashHandler index_handler_;
+};
+
+/**
+ * 打开时就取出所有匹配的RID
+ */
+class HashIndexScanner : public IndexScanner {
+public:
+  HashIndexScanner(const char *key, int key_length);
+  ~HashIndexScanner() noexcept override = default;
+
+  RC next_entry(RID *rid) override;
+  RC next_entry(RID *rid, char *key) override;
+  RC destroy() override;
+
+  std::vector<RID> &rids() {
+    return rids_;
+  }
+
+private:
+  std::string      key_;
+  std::vector<RID> rids_;
+  size_t           index_ = 0;
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_HASH_INDEX_H_
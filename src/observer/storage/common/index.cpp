@@ -13,9 +13,102 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/common/index.h"
+#include "storage/common/key_comparator.h"
 
-RC Index::init(const IndexMeta &index_meta, const FieldMeta &field_meta) {
+RC Index::init(const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+               const std::vector<FieldMeta> &include_metas) {
+  if (field_metas.empty()) {
+    return RC::INVALID_ARGUMENT;
+  }
   index_meta_ = index_meta;
-  field_meta_ = field_meta;
+  field_metas_ = field_metas;
+  include_metas_ = include_metas;
+  if (field_metas_.size() == 1 && include_metas_.empty()) {
+    key_type_ = field_metas_[0].type();
+    key_length_ = field_metas_[0].len();
+  } else {
+    key_type_ = BYTES;
+    key_length_ = 0;
+    for (const FieldMeta &field_meta : field_metas_) {
+      key_length_ += field_meta.len();
+    }
+    for (const FieldMeta &field_meta : include_metas_) {
+      key_length_ += field_meta.len();
+    }
+  }
   return RC::SUCCESS;
-}
\ No newline at end of file
+}
+
+const char *Index::make_key(const char *record, char *buffer) const {
+  if (key_type_ != BYTES) {
+    return record + field_metas_[0].offset();
+  }
+
+  char *pos = buffer;
+  for (const FieldMeta &field_meta : field_metas_) {
+    pos += normalize_attr(field_meta.type(), field_meta.len(), record + field_meta.offset(), pos);
+  }
+  // INCLUDE的字段不参与查找，按原样保存
+  for (const FieldMeta &field_meta : include_metas_) {
+    memcpy(pos, record + field_meta.offset(), field_meta.len());
+    pos += field_meta.len();
+  }
+  return buffer;
+}
+
+bool Index::covers(const char *field_name) const {
+  for (const FieldMeta &field_meta : field_metas_) {
+    if (0 == strcmp(field_meta.name(), field_name)) {
+      return true;
+    }
+  }
+  for (const FieldMeta &field_meta : include_metas_) {
+    if (0 == strcmp(field_meta.name(), field_name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Index::restore_record(const char *key, char *record) const {
+  if (key_type_ != BYTES) {
+    memcpy(record + field_metas_[0].offset(), key, key_length_);
+    return;
+  }
+
+  const char *pos = key;
+  for (const FieldMeta &field_meta : field_metas_) {
+    pos += denormalize_attr(field_meta.type(), field_meta.len(), pos, record + field_meta.offset());
+  }
+  for (const FieldMeta &field_meta : include_metas_) {
+    memcpy(record + field_meta.offset(), pos, field_meta.len());
+    pos += field_meta.len();
+  }
+}
+IndexScanner *Index::create_ordered_scanner(bool reverse) {
+  return nullptr;
+}
+
+RC Index::probe(const std::vector<const char *> &values, void *context,
+                RC (*callback)(int probe, const RID &rid, void *context)) {
+  for (int i = 0; i < (int)values.size(); i++) {
+    const char *value = values[i];
+    IndexScanner *scanner = create_scanner(1, &value, NO_OP, nullptr);
+    if (nullptr == scanner) {
+      return RC::INVALID_ARGUMENT;
+    }
+    RC rc;
+    RID rid;
+    while ((rc = scanner->next_entry(&rid)) == RC::SUCCESS) {
+      rc = callback(i, rid, context);
+      if (rc != RC::SUCCESS) {
+        break;
+      }
+    }
+    scanner->destroy();
+    if (rc != RC::RECORD_EOF) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
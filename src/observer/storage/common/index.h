@@ -47,14 +47,77 @@ public:
 
   virtual IndexScanner *create_scanner(CompOp comp_op, const char *value) = 0;
 
-  virtual RC sync() = 0;
+  /**
+   * 组合索引上的扫描: 前eq_num个字段分别等于values[i]，
+   * 第eq_num个字段上还可以带一个范围条件，range_op为NO_OP表示没有范围条件
+   */
+  virtual IndexScanner *create_scanner(int eq_num, const char * const values[],
+                                       CompOp range_op, const char *range_value) = 0;
+
+  /**
+   * 在第一个字段上依次做多次等值查找，用于index nested-loop join。
+   * values需要按字段的顺序从小到大排好，每找到一个索引项调用一次callback，probe是values中的下标
+   */
+  virtual RC probe(const std::vector<const char *> &values, void *context,
+                   RC (*callback)(int probe, const RID &rid, void *context));
+
+  /**
+   * 按key的顺序扫描整个索引，reverse为true时从最大的key开始。
+   * 索引中的key无序时返回nullptr，MIN/MAX等聚集查询只能扫描表
+   */
+  virtual IndexScanner *create_ordered_scanner(bool reverse);
+
+  /**
+   * 把索引的修改写到磁盘上。flush_pages为false时页面上的修改已经由redo日志保证不会丢失，
+   * 只写出不在页面上的状态，比如LSM的memtable和B+树的Bloom过滤器
+   */
+  virtual RC sync(bool flush_pages) = 0;
+
+  const std::vector<FieldMeta> &field_metas() const {
+    return field_metas_;
+  }
+  const std::vector<FieldMeta> &include_metas() const {
+    return include_metas_;
+  }
+
+  /**
+   * 索引中是否保存了这个字段的值(索引字段或INCLUDE字段)
+   */
+  bool covers(const char *field_name) const;
+
+  /**
+   * 把key中保存的各字段的值写回到记录中对应的位置，记录中的其它字段不变。
+   * 覆盖索引扫描时用来构造出只包含这些字段的记录
+   */
+  void restore_record(const char *key, char *record) const;
+
+  /**
+   * 索引key(不含RID)的类型和长度。没有INCLUDE字段的单列索引就是字段本身，
+   * 其它情况是各字段编码后拼接成的BYTES，INCLUDE字段按原样跟在最后
+   */
+  AttrType key_type() const {
+    return key_type_;
+  }
+  int key_length() const {
+    return key_length_;
+  }
+
+  /**
+   * 从记录中取出索引key。单列索引直接返回字段在记录中的位置，
+   * 其它情况把各字段编码后写入buffer(至少key_length字节)并返回buffer
+   */
+  const char *make_key(const char *record, char *buffer) const;
 
 protected:
-  RC init(const IndexMeta &index_meta, const FieldMeta &field_meta);
+  RC init(const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+          const std::vector<FieldMeta> &include_metas);
 
 protected:
   IndexMeta   index_meta_;
-  FieldMeta   field_meta_;    /// 当前实现仅考虑一个字段的索引
+  std::vector<FieldMeta> field_metas_;
+  std::vector<FieldMeta> include_metas_;
+  AttrType    key_type_ = UNDEFINED;
+  int         key_length_ = 0;
 };
 
 class IndexScanner {
@@ -63,6 +126,11 @@ public:
   virtual ~IndexScanner() = default;
 
   virtual RC next_entry(RID *rid) = 0;
+
+  /**
+   * 同时返回索引项的key(不含RID)，key至少要有Index::key_length字节
+   */
+  virtual RC next_entry(RID *rid, char *key) = 0;
   virtual RC destroy() = 0;
 };
 
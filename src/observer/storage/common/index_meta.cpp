@@ -22,43 +22,174 @@ See the Mulan PSL v2 for more details. */
 
 const static Json::StaticString FIELD_NAME("name");
 const static Json::StaticString FIELD_FIELD_NAME("field_name");
+const static Json::StaticString FIELD_FIELD_NAMES("field_names");
+const static Json::StaticString FIELD_INCLUDE_FIELD_NAMES("include_field_names");
+const static Json::StaticString FIELD_TYPE("type");
+const static Json::StaticString FIELD_BLOOM_FILTER("bloom_filter");
+const static Json::StaticString FIELD_ADAPTIVE_HASH("adaptive_hash");
+
+static const char *INDEX_TYPE_NAMES[] = {
+  "btree",
+  "hash",
+  "lsm"
+};
+
+static const char *index_type_to_string(IndexType type) {
+  if (type >= INDEX_BPLUS_TREE && type <= INDEX_LSM) {
+    return INDEX_TYPE_NAMES[type];
+  }
+  return "unknown";
+}
+
+static bool index_type_from_string(const char *s, IndexType &type) {
+  for (unsigned int i = 0; i < sizeof(INDEX_TYPE_NAMES) / sizeof(INDEX_TYPE_NAMES[0]); i++) {
+    if (0 == strcmp(INDEX_TYPE_NAMES[i], s)) {
+      type = (IndexType)i;
+      return true;
+    }
+  }
+  return false;
+}
 
 RC IndexMeta::init(const char *name, const FieldMeta &field) {
-  if (nullptr == name || common::is_blank(name)) {
+  std::vector<const FieldMeta *> fields;
+  fields.push_back(&field);
+  return init(name, fields);
+}
+
+RC IndexMeta::init(const char *name, const std::vector<const FieldMeta *> &fields) {
+  return init(name, fields, std::vector<const FieldMeta *>());
+}
+
+RC IndexMeta::init(const char *name, const std::vector<const FieldMeta *> &fields,
+                   const std::vector<const FieldMeta *> &include_fields, IndexType type, int options) {
+  if (nullptr == name || common::is_blank(name) || fields.empty()) {
     return RC::INVALID_ARGUMENT;
   }
 
   name_ = name;
-  field_ = field.name();
+  fields_.clear();
+  for (const FieldMeta *field : fields) {
+    fields_.push_back(field->name());
+  }
+  include_fields_.clear();
+  for (const FieldMeta *field : include_fields) {
+    include_fields_.push_back(field->name());
+  }
+  type_ = type;
+  options_ = options;
   return RC::SUCCESS;
 }
 
 void IndexMeta::to_json(Json::Value &json_value) const {
   json_value[FIELD_NAME] = name_;
-  json_value[FIELD_FIELD_NAME] = field_;
+  // 保留field_name，单列索引的元数据与原来的格式一致
+  json_value[FIELD_FIELD_NAME] = fields_[0];
+  if (fields_.size() > 1) {
+    Json::Value fields_value;
+    for (const std::string &field : fields_) {
+      fields_value.append(field);
+    }
+    json_value[FIELD_FIELD_NAMES] = std::move(fields_value);
+  }
+  if (!include_fields_.empty()) {
+    Json::Value include_fields_value;
+    for (const std::string &field : include_fields_) {
+      include_fields_value.append(field);
+    }
+    json_value[FIELD_INCLUDE_FIELD_NAMES] = std::move(include_fields_value);
+  }
+  // B+树索引不写type，与原来的格式一致
+  if (type_ != INDEX_BPLUS_TREE) {
+    json_value[FIELD_TYPE] = index_type_to_string(type_);
+  }
+  if (bloom_filter()) {
+    json_value[FIELD_BLOOM_FILTER] = true;
+  }
+  if (adaptive_hash()) {
+    json_value[FIELD_ADAPTIVE_HASH] = true;
+  }
 }
 
 RC IndexMeta::from_json(const TableMeta &table, const Json::Value &json_value, IndexMeta &index) {
   const Json::Value &name_value = json_value[FIELD_NAME];
   const Json::Value &field_value = json_value[FIELD_FIELD_NAME];
+  const Json::Value &fields_value = json_value[FIELD_FIELD_NAMES];
+  const Json::Value &include_fields_value = json_value[FIELD_INCLUDE_FIELD_NAMES];
+  const Json::Value &type_value = json_value[FIELD_TYPE];
+  const Json::Value &bloom_filter_value = json_value[FIELD_BLOOM_FILTER];
+  const Json::Value &adaptive_hash_value = json_value[FIELD_ADAPTIVE_HASH];
   if (!name_value.isString()) {
     LOG_ERROR("Index name is not a string. json value=%s", name_value.toStyledString().c_str());
     return RC::GENERIC_ERROR;
   }
 
-  if (!field_value.isString()) {
+  IndexType type = INDEX_BPLUS_TREE;
+  if (!type_value.isNull()) {
+    if (!type_value.isString() || !index_type_from_string(type_value.asCString(), type)) {
+      LOG_ERROR("Invalid type of index [%s]. json value=%s",
+                name_value.asCString(), type_value.toStyledString().c_str());
+      return RC::GENERIC_ERROR;
+    }
+  }
+
+  std::vector<std::string> field_names;
+  if (fields_value.isArray()) {
+    for (int i = 0; i < (int)fields_value.size(); i++) {
+      if (!fields_value[i].isString()) {
+        LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
+                  name_value.asCString(), fields_value[i].toStyledString().c_str());
+        return RC::GENERIC_ERROR;
+      }
+      field_names.push_back(fields_value[i].asString());
+    }
+  } else if (field_value.isString()) {
+    field_names.push_back(field_value.asString());
+  } else {
     LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
               name_value.asCString(), field_value.toStyledString().c_str());
     return RC::GENERIC_ERROR;
   }
 
-  const FieldMeta *field = table.field(field_value.asCString());
-  if (nullptr == field) {
-    LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_value.asCString());
-    return RC::SCHEMA_FIELD_MISSING;
+  std::vector<const FieldMeta *> fields;
+  for (const std::string &field_name : field_names) {
+    const FieldMeta *field = table.field(field_name.c_str());
+    if (nullptr == field) {
+      LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_name.c_str());
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+    fields.push_back(field);
+  }
+
+  std::vector<const FieldMeta *> include_fields;
+  if (include_fields_value.isArray()) {
+    for (int i = 0; i < (int)include_fields_value.size(); i++) {
+      const Json::Value &include_field_value = include_fields_value[i];
+      const FieldMeta *field = include_field_value.isString() ? table.field(include_field_value.asCString()) : nullptr;
+      if (nullptr == field) {
+        LOG_ERROR("Deserialize index [%s]: invalid include field: %s",
+                  name_value.asCString(), include_field_value.toStyledString().c_str());
+        return RC::SCHEMA_FIELD_MISSING;
+      }
+      include_fields.push_back(field);
+    }
+  }
+
+  if ((!bloom_filter_value.isNull() && !bloom_filter_value.isBool()) ||
+      (!adaptive_hash_value.isNull() && !adaptive_hash_value.isBool())) {
+    LOG_ERROR("Options of index [%s] are not bool. json value=%s",
+              name_value.asCString(), json_value.toStyledString().c_str());
+    return RC::GENERIC_ERROR;
+  }
+  int options = 0;
+  if (bloom_filter_value.asBool()) {
+    options |= INDEX_OPTION_BLOOM_FILTER;
+  }
+  if (adaptive_hash_value.asBool()) {
+    options |= INDEX_OPTION_ADAPTIVE_HASH;
   }
 
-  return index.init(name_value.asCString(), *field);
+  return index.init(name_value.asCString(), fields, include_fields, type, options);
 }
 
 const char *IndexMeta::name() const {
@@ -66,10 +197,60 @@ const char *IndexMeta::name() const {
 }
 
 const char *IndexMeta::field() const {
-  return field_.c_str();
+  return fields_[0].c_str();
+}
+
+const char *IndexMeta::field(int i) const {
+  return fields_[i].c_str();
+}
+
+int IndexMeta::field_num() const {
+  return fields_.size();
+}
+
+const char *IndexMeta::include_field(int i) const {
+  return include_fields_[i].c_str();
+}
+
+int IndexMeta::include_field_num() const {
+  return include_fields_.size();
+}
+
+IndexType IndexMeta::type() const {
+  return type_;
+}
+
+int IndexMeta::options() const {
+  return options_;
+}
+
+bool IndexMeta::bloom_filter() const {
+  return (options_ & INDEX_OPTION_BLOOM_FILTER) != 0;
+}
+
+bool IndexMeta::adaptive_hash() const {
+  return (options_ & INDEX_OPTION_ADAPTIVE_HASH) != 0;
 }
 
 void IndexMeta::desc(std::ostream &os) const {
   os << "index name=" << name_
-      << ", field=" << field_;
+      << ", field=" << fields_[0];
+  for (size_t i = 1; i < fields_.size(); i++) {
+    os << "," << fields_[i];
+  }
+  if (!include_fields_.empty()) {
+    os << ", include=" << include_fields_[0];
+    for (size_t i = 1; i < include_fields_.size(); i++) {
+      os << "," << include_fields_[i];
+    }
+  }
+  if (type_ != INDEX_BPLUS_TREE) {
+    os << ", type=" << index_type_to_string(type_);
+  }
+  if (bloom_filter()) {
+    os << ", bloom_filter";
+  }
+  if (adaptive_hash()) {
+    os << ", adaptive_hash";
+  }
 }
\ No newline at end of file
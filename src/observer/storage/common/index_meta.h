@@ -16,7 +16,9 @@ See the Mulan PSL v2 for more details. */
 #define __OBSERVER_STORAGE_COMMON_INDEX_META_H__
 
 #include <string>
+#include <vector>
 #include "rc.h"
+#include "sql/parser/parse_defs.h"
 
 class TableMeta;
 class FieldMeta;
@@ -30,10 +32,22 @@ public:
   IndexMeta() = default;
 
   RC init(const char *name, const FieldMeta &field);
+  RC init(const char *name, const std::vector<const FieldMeta *> &fields);
+  RC init(const char *name, const std::vector<const FieldMeta *> &fields,
+          const std::vector<const FieldMeta *> &include_fields, IndexType type = INDEX_BPLUS_TREE,
+          int options = 0);
 
 public:
   const char *name() const;
-  const char *field() const;
+  const char *field() const;                 // 第一个字段
+  const char *field(int i) const;
+  int field_num() const;
+  const char *include_field(int i) const;    // INCLUDE的字段
+  int include_field_num() const;
+  IndexType type() const;
+  int options() const;                       // IndexOption的组合
+  bool bloom_filter() const;                 // 是否在索引上建了Bloom过滤器
+  bool adaptive_hash() const;                // 是否为热点查找建自适应哈希索引
 
   void desc(std::ostream &os) const;
 public:
@@ -42,6 +56,9 @@ public:
 
 private:
   std::string       name_;
-  std::string       field_;
+  std::vector<std::string> fields_;          // 组合索引按顺序包含多个字段
+  std::vector<std::string> include_fields_;  // 覆盖索引额外保存在叶子中的字段
+  IndexType         type_ = INDEX_BPLUS_TREE;
+  int               options_ = 0;
 };
 #endif // __OBSERVER_STORAGE_COMMON_INDEX_META_H__
\ No newline at end of file
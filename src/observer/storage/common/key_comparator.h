@@ -0,0 +1,204 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_KEY_COMPARATOR_H_
+#define __OBSERVER_STORAGE_COMMON_KEY_COMPARATOR_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sql/parser/parse_defs.h"
+#include "storage/common/record_manager.h"
+
+/**
+ * 按属性类型在编译期特化的属性值比较器。
+ * B+树中的比较都通过这里的模板完成，只在一次查找开始时根据attr_type分派一次，
+ * 而不是每次比较都做一次switch
+ */
+template <AttrType TYPE>
+struct AttrComparator;
+
+template <>
+struct AttrComparator<INTS> {
+  static int compare(const char *v1, const char *v2, int attr_length) {
+    int i1 = *(const int *)v1;
+    int i2 = *(const int *)v2;
+    return (i1 > i2) - (i1 < i2);
+  }
+};
+
+template <>
+struct AttrComparator<DATES> : public AttrComparator<INTS> {
+};
+
+template <>
+struct AttrComparator<FLOATS> {
+  static int compare(const char *v1, const char *v2, int attr_length) {
+    float result = *(const float *)v1 - *(const float *)v2;
+    if (result < 1e-6 && result > -1e-6) {
+      return 0;
+    }
+    return result > 0 ? 1 : -1;
+  }
+};
+
+template <>
+struct AttrComparator<CHARS> {
+  static int compare(const char *v1, const char *v2, int attr_length) {
+    return strncmp(v1, v2, attr_length);
+  }
+};
+
+template <>
+struct AttrComparator<BYTES> {
+  static int compare(const char *v1, const char *v2, int attr_length) {
+    return memcmp(v1, v2, attr_length);
+  }
+};
+
+/**
+ * 把一个属性值编码成可以直接memcmp比较的定长字节串，写入out，返回编码后的长度(与字段长度相同)。
+ * 组合索引把各列的编码依次拼接起来作为key，整体按字节比较即可得到按列依次比较的顺序
+ */
+inline int normalize_attr(AttrType attr_type, int attr_length, const char *value, char *out) {
+  switch (attr_type) {
+    case INTS:
+    case DATES: {
+      // 大端序，翻转符号位后负数排在正数前面
+      uint32_t v = *(const uint32_t *)value ^ 0x80000000u;
+      for (int i = 0; i < 4; i++) {
+        out[i] = (char)(v >> (24 - i * 8));
+      }
+    } break;
+    case FLOATS: {
+      // 正数翻转符号位，负数翻转所有位
+      uint32_t v = *(const uint32_t *)value;
+      v = (v & 0x80000000u) ? ~v : (v | 0x80000000u);
+      for (int i = 0; i < 4; i++) {
+        out[i] = (char)(v >> (24 - i * 8));
+      }
+    } break;
+    case CHARS:
+    default: {
+      // 字符串结束符之后补0，与strncmp的结果一致
+      int len = strnlen(value, attr_length);
+      memcpy(out, value, len);
+      memset(out + len, 0, attr_length - len);
+    } break;
+  }
+  return attr_length;
+}
+
+/**
+ * normalize_attr的逆过程，把编码后的属性值还原到out中
+ */
+inline int denormalize_attr(AttrType attr_type, int attr_length, const char *value, char *out) {
+  switch (attr_type) {
+    case INTS:
+    case DATES:
+    case FLOATS: {
+      uint32_t v = 0;
+      for (int i = 0; i < 4; i++) {
+        v = (v << 8) | (uint8_t)value[i];
+      }
+      if (attr_type == FLOATS) {
+        v = (v & 0x80000000u) ? (v & 0x7FFFFFFFu) : ~v;
+      } else {
+        v ^= 0x80000000u;
+      }
+      memcpy(out, &v, sizeof(v));
+    } break;
+    case CHARS:
+    default: {
+      memcpy(out, value, attr_length);
+    } break;
+  }
+  return attr_length;
+}
+
+/**
+ * B+树的key(属性值 + RID)比较器，属性值相同时再比较RID
+ */
+template <AttrType TYPE>
+class KeyComparator {
+public:
+  explicit KeyComparator(int attr_length) : attr_length_(attr_length) {
+  }
+
+  int compare_attr(const char *v1, const char *v2) const {
+    return AttrComparator<TYPE>::compare(v1, v2, attr_length_);
+  }
+
+  int operator()(const char *key1, const char *key2) const {
+    int result = AttrComparator<TYPE>::compare(key1, key2, attr_length_);
+    if (result != 0) {
+      return result;
+    }
+    const RID *rid1 = (const RID *)(key1 + attr_length_);
+    const RID *rid2 = (const RID *)(key2 + attr_length_);
+    if (rid1->page_num != rid2->page_num) {
+      return rid1->page_num > rid2->page_num ? 1 : -1;
+    }
+    return (rid1->slot_num > rid2->slot_num) - (rid1->slot_num < rid2->slot_num);
+  }
+
+private:
+  int attr_length_;
+};
+
+/**
+ * 在有序的定长key数组上做二分查找。
+ * 循环中只根据比较结果移动base指针，不会产生难以预测的分支
+ * @return UPPER为true时返回第一个大于pkey的下标，否则返回第一个大于等于pkey的下标
+ */
+template <bool UPPER, typename Comparator>
+int binary_search_keys(const char *keys, int key_num, int key_length, const char *pkey, const Comparator &cmp) {
+  if (key_num <= 0) {
+    return 0;
+  }
+  const char *base = keys;
+  int n = key_num;
+  while (n > 1) {
+    int half = n / 2;
+    const char *middle = base + half * key_length;
+    int result = cmp(middle, pkey);
+    base = (UPPER ? result <= 0 : result < 0) ? middle : base;
+    n -= half;
+  }
+  int result = cmp(base, pkey);
+  return (int)((base - keys) / key_length) + ((UPPER ? result <= 0 : result < 0) ? 1 : 0);
+}
+
+/**
+ * 根据属性类型分派到特化后的比较器上，调用func(comparator)
+ */
+template <typename Func>
+auto dispatch_key_comparator(AttrType attr_type, int attr_length, Func &&func)
+    -> decltype(func(KeyComparator<INTS>(attr_length))) {
+  switch (attr_type) {
+    case FLOATS:
+      return func(KeyComparator<FLOATS>(attr_length));
+    case CHARS:
+      return func(KeyComparator<CHARS>(attr_length));
+    case DATES:
+      return func(KeyComparator<DATES>(attr_length));
+    case BYTES:
+      return func(KeyComparator<BYTES>(attr_length));
+    case INTS:
+    default:
+      return func(KeyComparator<INTS>(attr_length));
+  }
+}
+
+#endif //__OBSERVER_STORAGE_COMMON_KEY_COMPARATOR_H_
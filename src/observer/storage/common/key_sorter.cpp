@@ -0,0 +1,279 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <thread>
+
+#include "storage/common/key_sorter.h"
+#include "storage/common/bplus_tree.h"
+#include "common/log/log.h"
+#include "common/os/os.h"
+
+// 每个run在归并时使用的读缓冲大小
+static const size_t RUN_READ_BUFFER_SIZE = 256 * 1024;
+
+IndexBuildOptions &IndexBuildOptions::instance() {
+  static IndexBuildOptions options;
+  return options;
+}
+
+KeySorter::KeySorter(AttrType attr_type, int attr_length, const char *tmp_file_prefix,
+                     const IndexBuildOptions &options)
+    : attr_type_(attr_type), attr_length_(attr_length), key_length_(attr_length + sizeof(RID)),
+      tmp_file_prefix_(tmp_file_prefix) {
+  thread_num_ = options.sort_threads > 0 ? options.sort_threads : (int)common::getCpuNum();
+  if (thread_num_ <= 0) {
+    thread_num_ = 1;
+  }
+  max_buffer_keys_ = options.sort_memory / key_length_;
+  if (max_buffer_keys_ < 1024) {
+    max_buffer_keys_ = 1024;
+  }
+}
+
+KeySorter::~KeySorter() {
+  for (Run &run : runs_) {
+    if (run.file != nullptr) {
+      fclose(run.file);
+      run.file = nullptr;
+    }
+    unlink(run.file_name.c_str());
+  }
+}
+
+bool KeySorter::less(const char *key1, const char *key2) const {
+  return CmpKey(attr_type_, attr_length_, key1, key2) < 0;
+}
+
+RC KeySorter::add(const char *attr, const RID &rid) {
+  if (finished_) {
+    return RC::MISUSE;
+  }
+
+  size_t offset = buffer_.size();
+  buffer_.resize(offset + key_length_);
+  memcpy(buffer_.data() + offset, attr, attr_length_);
+  memcpy(buffer_.data() + offset + attr_length_, &rid, sizeof(rid));
+  key_count_++;
+
+  if (buffer_.size() / key_length_ >= max_buffer_keys_) {
+    return spill();
+  }
+  return RC::SUCCESS;
+}
+
+/**
+ * 将buffer_按线程数切成几段，每个线程排序一段，再两两并行归并，结果放在sorted_中
+ */
+void KeySorter::sort_buffer() {
+  const size_t key_num = buffer_.size() / key_length_;
+  sorted_.resize(key_num);
+  for (size_t i = 0; i < key_num; i++) {
+    sorted_[i] = buffer_.data() + i * key_length_;
+  }
+  sorted_pos_ = 0;
+
+  auto cmp = [this](const char *key1, const char *key2) {
+    return less(key1, key2);
+  };
+
+  size_t part_num = std::min((size_t)thread_num_, std::max((size_t)1, key_num / 4096));
+  if (part_num <= 1) {
+    std::sort(sorted_.begin(), sorted_.end(), cmp);
+    return;
+  }
+
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= part_num; i++) {
+    bounds.push_back(key_num * i / part_num);
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < part_num; i++) {
+    threads.emplace_back([this, &bounds, &cmp, i]() {
+      std::sort(sorted_.begin() + bounds[i], sorted_.begin() + bounds[i + 1], cmp);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  while (bounds.size() > 2) {
+    std::vector<size_t> next_bounds;
+    threads.clear();
+    size_t i = 0;
+    for (; i + 2 < bounds.size(); i += 2) {
+      size_t first = bounds[i], middle = bounds[i + 1], last = bounds[i + 2];
+      threads.emplace_back([this, &cmp, first, middle, last]() {
+        std::inplace_merge(sorted_.begin() + first, sorted_.begin() + middle, sorted_.begin() + last, cmp);
+      });
+      next_bounds.push_back(first);
+    }
+    if (i + 1 < bounds.size()) {
+      // 落单的一段直接保留到下一轮
+      next_bounds.push_back(bounds[i]);
+    }
+    next_bounds.push_back(bounds.back());
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    bounds.swap(next_bounds);
+  }
+}
+
+RC KeySorter::spill() {
+  if (buffer_.empty()) {
+    return RC::SUCCESS;
+  }
+
+  sort_buffer();
+
+  Run run;
+  run.file_name = tmp_file_prefix_ + ".sort." + std::to_string(runs_.size());
+  FILE *file = fopen(run.file_name.c_str(), "w+");
+  if (file == nullptr) {
+    LOG_ERROR("Failed to create sort file. file name=%s, errmsg=%s", run.file_name.c_str(), strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+  run.file = file;
+  runs_.push_back(std::move(run));
+
+  for (const char *key : sorted_) {
+    if (fwrite(key, key_length_, 1, file) != 1) {
+      LOG_ERROR("Failed to write sort file. file name=%s, errmsg=%s",
+                runs_.back().file_name.c_str(), strerror(errno));
+      return RC::IOERR_WRITE;
+    }
+  }
+  if (fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0) {
+    LOG_ERROR("Failed to flush sort file. file name=%s, errmsg=%s",
+              runs_.back().file_name.c_str(), strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_DEBUG("Spill %lu keys to sort file %s", sorted_.size(), runs_.back().file_name.c_str());
+  sorted_.clear();
+  buffer_.clear();
+  return RC::SUCCESS;
+}
+
+RC KeySorter::fill_run(Run &run) {
+  size_t max_keys = std::max((size_t)1, RUN_READ_BUFFER_SIZE / key_length_);
+  run.buffer.resize(max_keys * key_length_);
+  run.buffer_keys = fread(run.buffer.data(), key_length_, max_keys, run.file);
+  run.pos = 0;
+  if (run.buffer_keys == 0) {
+    if (ferror(run.file)) {
+      LOG_ERROR("Failed to read sort file. file name=%s, errmsg=%s", run.file_name.c_str(), strerror(errno));
+      return RC::IOERR_READ;
+    }
+    return RC::RECORD_EOF;
+  }
+  return RC::SUCCESS;
+}
+
+void KeySorter::heap_down(int pos) {
+  const int size = heap_.size();
+  while (true) {
+    int smallest = pos;
+    int left = pos * 2 + 1;
+    int right = left + 1;
+    if (left < size && less(run_key(heap_[left]), run_key(heap_[smallest]))) {
+      smallest = left;
+    }
+    if (right < size && less(run_key(heap_[right]), run_key(heap_[smallest]))) {
+      smallest = right;
+    }
+    if (smallest == pos) {
+      return;
+    }
+    std::swap(heap_[pos], heap_[smallest]);
+    pos = smallest;
+  }
+}
+
+RC KeySorter::finish() {
+  if (finished_) {
+    return RC::SUCCESS;
+  }
+  finished_ = true;
+
+  if (runs_.empty()) {
+    // 数据全部在内存中，不需要外部归并
+    sort_buffer();
+    return RC::SUCCESS;
+  }
+
+  RC rc = spill();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  buffer_.shrink_to_fit();
+
+  for (size_t i = 0; i < runs_.size(); i++) {
+    rc = fill_run(runs_[i]);
+    if (rc == RC::SUCCESS) {
+      heap_.push_back(i);
+    } else if (rc != RC::RECORD_EOF) {
+      return rc;
+    }
+  }
+  for (int i = (int)heap_.size() / 2 - 1; i >= 0; i--) {
+    heap_down(i);
+  }
+  LOG_INFO("Merge %lu sorted runs, total %lu keys", runs_.size(), key_count_);
+  return RC::SUCCESS;
+}
+
+RC KeySorter::next(const char **key) {
+  if (!finished_) {
+    return RC::MISUSE;
+  }
+
+  if (runs_.empty()) {
+    if (sorted_pos_ >= sorted_.size()) {
+      return RC::RECORD_EOF;
+    }
+    *key = sorted_[sorted_pos_++];
+    return RC::SUCCESS;
+  }
+
+  // 上一次返回的key所在的run向前移动一位
+  if (merging_ && !heap_.empty()) {
+    Run &run = runs_[heap_[0]];
+    run.pos++;
+    if (run.pos >= run.buffer_keys) {
+      RC rc = fill_run(run);
+      if (rc == RC::RECORD_EOF) {
+        heap_[0] = heap_.back();
+        heap_.pop_back();
+      } else if (rc != RC::SUCCESS) {
+        return rc;
+      }
+    }
+    if (!heap_.empty()) {
+      heap_down(0);
+    }
+  }
+
+  if (heap_.empty()) {
+    return RC::RECORD_EOF;
+  }
+  merging_ = true;
+  *key = run_key(heap_[0]);
+  return RC::SUCCESS;
+}
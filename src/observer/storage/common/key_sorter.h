@@ -0,0 +1,109 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_KEY_SORTER_H_
+#define __OBSERVER_STORAGE_COMMON_KEY_SORTER_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "rc.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/common/record_manager.h"
+
+/**
+ * 创建索引时的参数，由DefaultStorageStage根据配置文件设置
+ */
+struct IndexBuildOptions {
+  float  fill_factor = 0.9f;                 // 批量建索引时B+树节点的填充率 (0, 1]
+  int    sort_threads = 0;                   // 排序线程数，0表示使用cpu核数
+  size_t sort_memory = 64 * 1024 * 1024;     // 排序使用的内存上限，超过后生成有序段写入临时文件
+  bool   prefix_compression = true;          // 字符串类型的索引是否使用前缀压缩的节点格式
+
+  static IndexBuildOptions &instance();
+};
+
+/**
+ * 对B+树的key(属性值 + RID)做外部排序。
+ * 内存中的数据达到上限后，多线程排序并写到一个临时文件(run)中，
+ * 最后对所有run做多路归并，按顺序吐出所有key。
+ * 使用方式: add ... add -> finish -> next ... next
+ */
+class KeySorter {
+public:
+  KeySorter(AttrType attr_type, int attr_length, const char *tmp_file_prefix,
+            const IndexBuildOptions &options = IndexBuildOptions::instance());
+  ~KeySorter();
+
+  RC add(const char *attr, const RID &rid);
+
+  /**
+   * 添加结束，准备开始输出有序数据
+   */
+  RC finish();
+
+  /**
+   * 获取下一个key，返回的指针在下一次调用next前有效
+   * @return RECORD_EOF 没有更多数据
+   */
+  RC next(const char **key);
+
+  int key_length() const {
+    return key_length_;
+  }
+  size_t size() const {
+    return key_count_;
+  }
+
+private:
+  struct Run {
+    std::string file_name;
+    FILE       *file = nullptr;
+    std::vector<char> buffer;
+    size_t      buffer_keys = 0;   // buffer中有效key的个数
+    size_t      pos = 0;           // 当前key在buffer中的下标
+  };
+
+  void sort_buffer();
+  RC   spill();
+  RC   fill_run(Run &run);
+  bool less(const char *key1, const char *key2) const;
+  void heap_down(int pos);
+  const char *run_key(int run_index) const {
+    const Run &run = runs_[run_index];
+    return run.buffer.data() + run.pos * key_length_;
+  }
+
+private:
+  AttrType    attr_type_;
+  int         attr_length_;
+  int         key_length_;
+  std::string tmp_file_prefix_;
+  int         thread_num_;
+  size_t      max_buffer_keys_;
+
+  size_t      key_count_ = 0;
+  bool        finished_ = false;
+
+  std::vector<char>         buffer_;       // 尚未写出的key
+  std::vector<const char *> sorted_;       // buffer_ 排序后的结果
+  size_t                    sorted_pos_ = 0;
+
+  std::vector<Run>  runs_;
+  std::vector<int>  heap_;                 // 多路归并使用的小顶堆，保存run的下标
+  bool              merging_ = false;      // 是否已经从堆顶返回过key
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_KEY_SORTER_H_
@@ -0,0 +1,254 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include "storage/common/lsm_index.h"
+#include "storage/common/key_comparator.h"
+#include "common/log/log.h"
+
+LsmIndex::~LsmIndex() noexcept {
+  close();
+}
+
+RC LsmIndex::create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+                    const std::vector<FieldMeta> &include_metas) {
+  if (inited_) {
+    return RC::RECORD_OPENNED;
+  }
+
+  RC rc = Index::init(index_meta, field_metas, include_metas);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  // Bloom过滤器只记录索引字段，不包含INCLUDE字段
+  int bloom_key_length = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    bloom_key_length += field_meta.len();
+  }
+  rc = lsm_tree_.create(file_name, key_length_, bloom_key_length);
+  if (RC::SUCCESS == rc) {
+    inited_ = true;
+  }
+  return rc;
+}
+
+RC LsmIndex::open(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+                  const std::vector<FieldMeta> &include_metas) {
+  if (inited_) {
+    return RC::RECORD_OPENNED;
+  }
+  RC rc = Index::init(index_meta, field_metas, include_metas);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  rc = lsm_tree_.open(file_name);
+  if (RC::SUCCESS == rc) {
+    inited_ = true;
+  }
+  return rc;
+}
+
+RC LsmIndex::close() {
+  if (inited_) {
+    lsm_tree_.close();
+    inited_ = false;
+  }
+  return RC::SUCCESS;
+}
+
+RC LsmIndex::destroy() {
+  if (inited_) {
+    lsm_tree_.destroy();
+    inited_ = false;
+  }
+  return RC::SUCCESS;
+}
+
+/**
+ * 单列索引的key编码成按字节比较的形式，组合索引的key本来就是编码过的
+ */
+const char *LsmIndex::make_lsm_key(const char *record, char *buffer) const {
+  if (key_type_ != BYTES) {
+    normalize_attr(key_type_, key_length_, record + field_metas_[0].offset(), buffer);
+    return buffer;
+  }
+  return make_key(record, buffer);
+}
+
+RC LsmIndex::insert_entry(const char *record, const RID *rid) {
+  std::vector<char> buffer(key_length_);
+  return lsm_tree_.insert_entry(make_lsm_key(record, buffer.data()), rid);
+}
+
+RC LsmIndex::delete_entry(const char *record, const RID *rid) {
+  std::vector<char> buffer(key_length_);
+  return lsm_tree_.delete_entry(make_lsm_key(record, buffer.data()), rid);
+}
+
+IndexScanner *LsmIndex::create_scanner(CompOp comp_op, const char *value) {
+  std::string key(key_length_, '\0');
+  if (value != nullptr) {
+    if (key_type_ != BYTES) {
+      normalize_attr(key_type_, key_length_, value, &key[0]);
+    } else {
+      key.assign(value, key_length_);
+    }
+  }
+
+  switch (comp_op) {
+    case EQUAL_TO:
+      return create_scanner(&key, true, &key, true, nullptr);
+    case GREAT_EQUAL:
+      return create_scanner(&key, true, nullptr, true, nullptr);
+    case GREAT_THAN:
+      return create_scanner(&key, false, nullptr, true, nullptr);
+    case LESS_EQUAL:
+      return create_scanner(nullptr, true, &key, true, nullptr);
+    case LESS_THAN:
+      return create_scanner(nullptr, true, &key, false, nullptr);
+    case NOT_EQUAL:
+      return create_scanner(nullptr, true, nullptr, true, &key);
+    default:
+      return create_scanner(nullptr, true, nullptr, true, nullptr);
+  }
+}
+
+IndexScanner *LsmIndex::create_scanner(int eq_num, const char * const values[],
+                                       CompOp range_op, const char *range_value) {
+  const int field_num = field_metas_.size();
+  if (eq_num < 0 || eq_num > field_num || (eq_num == field_num && range_op != NO_OP)) {
+    LOG_ERROR("Invalid index scan. index=%s, field num=%d, eq num=%d", index_meta_.name(), field_num, eq_num);
+    return nullptr;
+  }
+
+  if (key_type_ != BYTES) {
+    if (eq_num == 1) {
+      return create_scanner(EQUAL_TO, values[0]);
+    }
+    return create_scanner(range_op, range_value);
+  }
+
+  // 与B+树索引相同，等值条件构成key的前缀
+  std::string prefix;
+  for (int i = 0; i < eq_num; i++) {
+    const FieldMeta &field_meta = field_metas_[i];
+    std::string value(field_meta.len(), '\0');
+    normalize_attr(field_meta.type(), field_meta.len(), values[i], &value[0]);
+    prefix += value;
+  }
+  std::string bound = prefix;
+  if (range_op != NO_OP) {
+    const FieldMeta &field_meta = field_metas_[eq_num];
+    std::string value(field_meta.len(), '\0');
+    normalize_attr(field_meta.type(), field_meta.len(), range_value, &value[0]);
+    bound += value;
+  }
+
+  const std::string *low = &prefix;
+  const std::string *high = &prefix;
+  bool low_inclusive = true;
+  bool high_inclusive = true;
+  switch (range_op) {
+    case GREAT_EQUAL:
+      low = &bound;
+      break;
+    case GREAT_THAN:
+      low = &bound;
+      low_inclusive = false;
+      break;
+    case LESS_EQUAL:
+      high = &bound;
+      break;
+    case LESS_THAN:
+      high = &bound;
+      high_inclusive = false;
+      break;
+    case EQUAL_TO:
+      low = &bound;
+      high = &bound;
+      break;
+    default:
+      break;
+  }
+  if (low->empty()) {
+    low = nullptr;
+  }
+  if (high->empty()) {
+    high = nullptr;
+  }
+  return create_scanner(low, low_inclusive, high, high_inclusive, nullptr);
+}
+
+IndexScanner *LsmIndex::create_scanner(const std::string *low, bool low_inclusive, const std::string *high,
+                                       bool high_inclusive, const std::string *excluded) {
+  LsmIndexScanner *scanner = new LsmIndexScanner(*this);
+  RC rc = scanner->open(low, low_inclusive, high, high_inclusive, excluded);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open index scanner. index=%s, rc=%d:%s", index_meta_.name(), rc, strrc(rc));
+    delete scanner;
+    return nullptr;
+  }
+  return scanner;
+}
+
+RC LsmIndex::sync(bool flush_pages) {
+  // memtable不在缓冲池的页面上，总是要写出
+  return lsm_tree_.sync();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LsmIndexScanner::LsmIndexScanner(LsmIndex &index) : index_(index), scanner_(index.lsm_tree_) {
+}
+
+LsmIndexScanner::~LsmIndexScanner() noexcept {
+  scanner_.close();
+}
+
+RC LsmIndexScanner::open(const std::string *low, bool low_inclusive, const std::string *high, bool high_inclusive,
+                         const std::string *excluded) {
+  if (excluded != nullptr) {
+    excluded_ = *excluded;
+  }
+  key_.resize(index_.key_length());
+  return scanner_.open(low == nullptr ? nullptr : low->data(), low == nullptr ? 0 : low->size(), low_inclusive,
+                       high == nullptr ? nullptr : high->data(), high == nullptr ? 0 : high->size(), high_inclusive);
+}
+
+RC LsmIndexScanner::next_entry(RID *rid) {
+  return next_entry(rid, nullptr);
+}
+
+RC LsmIndexScanner::next_entry(RID *rid, char *key) {
+  RC rc;
+  while ((rc = scanner_.next_entry(rid, &key_[0])) == RC::SUCCESS) {
+    if (!excluded_.empty() && excluded_ == key_) {
+      continue;
+    }
+    if (key != nullptr) {
+      if (index_.key_type() != BYTES) {
+        denormalize_attr(index_.key_type(), index_.key_length(), key_.data(), key);
+      } else {
+        memcpy(key, key_.data(), key_.size());
+      }
+    }
+    return RC::SUCCESS;
+  }
+  return rc;
+}
+
+RC LsmIndexScanner::destroy() {
+  delete this;
+  return RC::SUCCESS;
+}
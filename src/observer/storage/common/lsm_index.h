@@ -0,0 +1,89 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_LSM_INDEX_H_
+#define __OBSERVER_STORAGE_COMMON_LSM_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "storage/common/index.h"
+#include "storage/common/lsm_tree.h"
+
+/**
+ * 基于LSM树的索引，适合写多读少的表。插入和删除只写内存，
+ * 支持与B+树索引相同的等值、范围和组合索引前缀查找。
+ * 单列索引的key也编码成可以按字节比较的形式，浮点数按编码后的值精确比较
+ */
+class LsmIndex : public Index {
+public:
+  LsmIndex() = default;
+  virtual ~LsmIndex() noexcept;
+
+  RC create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+            const std::vector<FieldMeta> &include_metas);
+  RC open(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+          const std::vector<FieldMeta> &include_metas);
+  RC close();
+
+  /**
+   * 删除表时调用，关闭索引并删除所有有序文件
+   */
+  RC destroy();
+
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
+
+  IndexScanner *create_scanner(CompOp comp_op, const char *value) override;
+  IndexScanner *create_scanner(int eq_num, const char * const values[],
+                               CompOp range_op, const char *range_value) override;
+
+  RC sync(bool flush_pages) override;
+
+  LsmStats stats() const {
+    return lsm_tree_.stats();
+  }
+
+private:
+  const char *make_lsm_key(const char *record, char *buffer) const;
+  IndexScanner *create_scanner(const std::string *low, bool low_inclusive, const std::string *high,
+                               bool high_inclusive, const std::string *excluded);
+
+private:
+  friend class LsmIndexScanner;
+
+  bool inited_ = false;
+  LsmTree lsm_tree_;
+};
+
+class LsmIndexScanner : public IndexScanner {
+public:
+  LsmIndexScanner(LsmIndex &index);
+  ~LsmIndexScanner() noexcept override;
+
+  RC open(const std::string *low, bool low_inclusive, const std::string *high, bool high_inclusive,
+          const std::string *excluded);
+
+  RC next_entry(RID *rid) override;
+  RC next_entry(RID *rid, char *key) override;
+  RC destroy() override;
+
+private:
+  LsmIndex &  index_;
+  LsmScanner  scanner_;
+  std::string excluded_;       // 不等于条件排除的值
+  std::string key_;
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_LSM_INDEX_H_
@@ -0,0 +1,972 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "storage/common/lsm_tree.h"
+#include "common/log/log.h"
+
+static const char LSM_RUN_MAGIC[8] = {'M', 'I', 'N', 'I', 'L', 'S', 'M', 'R'};
+static const char LSM_MANIFEST_MAGIC[8] = {'M', 'I', 'N', 'I', 'L', 'S', 'M', 'M'};
+
+// memtable中每个索引项除了key本身之外大约占用的内存: 红黑树节点和std::string
+static const size_t MEMTABLE_ENTRY_OVERHEAD = 80;
+
+/**
+ * 有序文件的第一个块。数据块从第二个块开始，之后是栅栏和Bloom过滤器
+ */
+struct LsmRunHeader {
+  char    magic[8];
+  int32_t entry_length;
+  int32_t bloom_key_length;
+  int64_t entry_count;
+  int64_t block_count;
+  int64_t fence_offset;
+  int64_t bloom_offset;
+  int64_t file_size;
+};
+
+/**
+ * 文件列表。后面依次是每一层的文件个数和文件的seq
+ */
+struct LsmManifestHeader {
+  char    magic[8];
+  int32_t key_length;
+  int32_t bloom_key_length;
+  int64_t next_seq;
+  int32_t level_num;
+  int32_t reserved;
+};
+
+LsmOptions &LsmOptions::instance() {
+  static LsmOptions options;
+  return options;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LsmRun::~LsmRun() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  if (obsolete_) {
+    if (unlink(file_name_.c_str()) != 0) {
+      LOG_WARN("Failed to remove obsolete lsm run %s. errmsg=%s", file_name_.c_str(), strerror(errno));
+    }
+  }
+}
+
+RC LsmRun::open(const std::string &file_name, int64_t seq, int entry_length, std::shared_ptr<LsmRun> &run) {
+  std::fstream fs;
+  fs.open(file_name, std::ios_base::in | std::ios_base::binary);
+  if (!fs.is_open()) {
+    LOG_ERROR("Failed to open lsm run %s. errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  LsmRunHeader header;
+  fs.read((char *)&header, sizeof(header));
+  if (fs.fail() || memcmp(header.magic, LSM_RUN_MAGIC, sizeof(header.magic)) != 0 ||
+      header.entry_length != entry_length || header.block_count <= 0) {
+    LOG_ERROR("Invalid lsm run file: %s", file_name.c_str());
+    return RC::IOERR_READ;
+  }
+
+  std::shared_ptr<LsmRun> new_run(new LsmRun());
+  new_run->file_name_ = file_name;
+  new_run->seq_ = seq;
+  new_run->entry_length_ = entry_length;
+  new_run->records_per_block_ = BLOCK_SIZE / (entry_length + 1);
+  new_run->bloom_key_length_ = header.bloom_key_length;
+  new_run->entry_count_ = header.entry_count;
+  new_run->file_size_ = header.file_size;
+  new_run->fences_.resize(header.block_count * entry_length);
+  new_run->last_entry_.resize(entry_length);
+  fs.seekg(header.fence_offset);
+  fs.read(new_run->fences_.data(), new_run->fences_.size());
+  fs.read(&new_run->last_entry_[0], entry_length);
+  if (fs.fail()) {
+    LOG_ERROR("Lsm run file is truncated: %s", file_name.c_str());
+    return RC::IOERR_READ;
+  }
+  fs.seekg(header.bloom_offset);
+  RC rc = new_run->bloom_filter_.deserialize(fs, header.bloom_key_length);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Invalid bloom filter in lsm run %s", file_name.c_str());
+    return rc;
+  }
+  fs.close();
+
+  new_run->fd_ = ::open(file_name.c_str(), O_RDONLY);
+  if (new_run->fd_ < 0) {
+    LOG_ERROR("Failed to open lsm run %s. errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  run = new_run;
+  return RC::SUCCESS;
+}
+
+int64_t LsmRun::find_block(const char *entry) const {
+  int64_t low = 0;
+  int64_t high = block_count() - 1;
+  while (low < high) {
+    int64_t mid = (low + high + 1) / 2;
+    if (memcmp(fences_.data() + mid * entry_length_, entry, entry_length_) <= 0) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+RC LsmRun::read_block(int64_t block, std::vector<char> &buffer) const {
+  buffer.resize(BLOCK_SIZE);
+  ssize_t size = pread(fd_, buffer.data(), BLOCK_SIZE, (off_t)(block + 1) * BLOCK_SIZE);
+  if (size != BLOCK_SIZE) {
+    LOG_ERROR("Failed to read block %ld of lsm run %s. errmsg=%s", block, file_name_.c_str(), strerror(errno));
+    return RC::IOERR_READ;
+  }
+  return RC::SUCCESS;
+}
+
+bool LsmRun::may_contain(const char *key, int length) const {
+  if (length != bloom_key_length_) {
+    return true;
+  }
+  return bloom_filter_.may_contain(BloomFilter::hash(key, length));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+class MemtableSource : public LsmMergeIterator::Source {
+public:
+  MemtableSource(std::shared_ptr<const LsmMemtable> memtable, const std::string &seek)
+      : memtable_(std::move(memtable)), iter_(memtable_->entries.lower_bound(seek)) {
+  }
+
+  bool valid() const override {
+    return iter_ != memtable_->entries.end();
+  }
+  const char *entry() const override {
+    return iter_->first.data();
+  }
+  bool tombstone() const override {
+    return iter_->second;
+  }
+  RC next() override {
+    ++iter_;
+    return RC::SUCCESS;
+  }
+
+private:
+  std::shared_ptr<const LsmMemtable> memtable_;
+  std::map<std::string, bool>::const_iterator iter_;
+};
+
+class RunSource : public LsmMergeIterator::Source {
+public:
+  RunSource(std::shared_ptr<LsmRun> run, int entry_length)
+      : run_(std::move(run)), entry_length_(entry_length), record_length_(entry_length + 1) {
+  }
+
+  /**
+   * 定位到第一个不小于seek的索引项
+   */
+  RC seek(const std::string &seek) {
+    block_ = run_->find_block(seek.data());
+    RC rc = load_block();
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    while (valid() && memcmp(entry(), seek.data(), entry_length_) < 0) {
+      rc = next();
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+    }
+    return RC::SUCCESS;
+  }
+
+  bool valid() const override {
+    return index_ < record_num_;
+  }
+  const char *entry() const override {
+    return buffer_.data() + index_ * record_length_;
+  }
+  bool tombstone() const override {
+    return buffer_[index_ * record_length_ + entry_length_] != 0;
+  }
+  RC next() override {
+    if (++index_ < record_num_) {
+      return RC::SUCCESS;
+    }
+    if (block_ + 1 >= run_->block_count()) {
+      return RC::SUCCESS;
+    }
+    block_++;
+    return load_block();
+  }
+
+private:
+  RC load_block() {
+    index_ = 0;
+    record_num_ = 0;
+    RC rc = run_->read_block(block_, buffer_);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    record_num_ = std::min<int64_t>(run_->records_per_block(),
+                                    run_->entry_count() - block_ * run_->records_per_block());
+    return RC::SUCCESS;
+  }
+
+private:
+  std::shared_ptr<LsmRun> run_;
+  const int entry_length_;
+  const int record_length_;
+  int64_t block_ = 0;
+  int record_num_ = 0;
+  int index_ = 0;
+  std::vector<char> buffer_;
+};
+
+}  // namespace
+
+RC LsmMergeIterator::next(const char **entry, bool *tombstone) {
+  // 上一次返回的索引项在各个数据源中的副本都跳过
+  if (current_source_ >= 0) {
+    for (std::unique_ptr<Source> &source : sources_) {
+      if (source->valid() && memcmp(source->entry(), current_.data(), entry_length_) == 0) {
+        RC rc = source->next();
+        if (rc != RC::SUCCESS) {
+          return rc;
+        }
+      }
+    }
+  }
+
+  int best = -1;
+  for (int i = 0; i < (int)sources_.size(); i++) {
+    if (!sources_[i]->valid()) {
+      continue;
+    }
+    if (best < 0 || memcmp(sources_[i]->entry(), sources_[best]->entry(), entry_length_) < 0) {
+      best = i;
+    }
+  }
+  if (best < 0) {
+    return RC::RECORD_EOF;
+  }
+  current_.assign(sources_[best]->entry(), entry_length_);
+  current_source_ = best;
+  *entry = current_.data();
+  *tombstone = sources_[best]->tombstone();
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LsmTree::~LsmTree() {
+  close();
+}
+
+std::string LsmTree::run_file(int64_t seq) const {
+  return file_name_ + "." + std::to_string(seq) + ".run";
+}
+
+/**
+ * RID编码成大端序并翻转符号位，按字节比较的顺序与按数值比较一致
+ */
+void LsmTree::encode_rid(const RID *rid, char *out) {
+  const uint32_t values[2] = {(uint32_t)rid->page_num ^ 0x80000000u, (uint32_t)rid->slot_num ^ 0x80000000u};
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 4; j++) {
+      out[i * 4 + j] = (char)(values[i] >> (24 - j * 8));
+    }
+  }
+}
+
+void LsmTree::decode_rid(const char *data, RID *rid) {
+  uint32_t values[2] = {0, 0};
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 4; j++) {
+      values[i] = (values[i] << 8) | (uint8_t)data[i * 4 + j];
+    }
+  }
+  rid->page_num = (PageNum)(values[0] ^ 0x80000000u);
+  rid->slot_num = (SlotNum)(values[1] ^ 0x80000000u);
+}
+
+RC LsmTree::create(const char *file_name, int key_length, int bloom_key_length) {
+  if (opened_) {
+    return RC::RECORD_OPENNED;
+  }
+  if (key_length <= 0 || bloom_key_length <= 0 || bloom_key_length > key_length) {
+    LOG_ERROR("Invalid lsm key length. key length=%d, bloom key length=%d", key_length, bloom_key_length);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (key_length + RID_LENGTH + 1 > LsmRun::BLOCK_SIZE) {
+    LOG_ERROR("Lsm key is too long. key length=%d", key_length);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (access(file_name, F_OK) == 0) {
+    LOG_ERROR("Lsm index file %s already exists", file_name);
+    return RC::SCHEMA_INDEX_EXIST;
+  }
+
+  file_name_ = file_name;
+  key_length_ = key_length;
+  bloom_key_length_ = bloom_key_length;
+  next_seq_ = 1;
+  version_ = std::make_shared<LsmVersion>();
+  RC rc = save_manifest();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  start_background();
+  LOG_INFO("Successfully create lsm index %s", file_name);
+  return RC::SUCCESS;
+}
+
+RC LsmTree::open(const char *file_name) {
+  if (opened_) {
+    return RC::RECORD_OPENNED;
+  }
+  std::fstream fs;
+  fs.open(file_name, std::ios_base::in | std::ios_base::binary);
+  if (!fs.is_open()) {
+    LOG_ERROR("Failed to open lsm index %s. errmsg=%s", file_name, strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  LsmManifestHeader header;
+  fs.read((char *)&header, sizeof(header));
+  if (fs.fail() || memcmp(header.magic, LSM_MANIFEST_MAGIC, sizeof(header.magic)) != 0) {
+    LOG_ERROR("Invalid lsm index file: %s", file_name);
+    return RC::IOERR_READ;
+  }
+
+  file_name_ = file_name;
+  key_length_ = header.key_length;
+  bloom_key_length_ = header.bloom_key_length;
+  next_seq_ = header.next_seq;
+  std::shared_ptr<LsmVersion> version = std::make_shared<LsmVersion>();
+  version->levels.resize(header.level_num);
+  for (int level = 0; level < header.level_num; level++) {
+    int32_t run_num = 0;
+    fs.read((char *)&run_num, sizeof(run_num));
+    for (int i = 0; i < run_num && !fs.fail(); i++) {
+      int64_t seq = 0;
+      fs.read((char *)&seq, sizeof(seq));
+      std::shared_ptr<LsmRun> run;
+      RC rc = LsmRun::open(run_file(seq), seq, entry_length(), run);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+      version->levels[level].push_back(run);
+    }
+  }
+  if (fs.fail()) {
+    LOG_ERROR("Lsm index file is truncated: %s", file_name);
+    return RC::IOERR_READ;
+  }
+  version_ = version;
+  start_background();
+  LOG_INFO("Successfully open lsm index %s", file_name);
+  return RC::SUCCESS;
+}
+
+void LsmTree::start_background() {
+  const LsmOptions &options = LsmOptions::instance();
+  memtable_size_ = options.memtable_size;
+  runs_per_level_ = std::max(options.runs_per_level, 2);
+  memtable_ = std::make_shared<LsmMemtable>();
+  immutables_.clear();
+  stop_ = false;
+  background_rc_ = RC::SUCCESS;
+  opened_ = true;
+  background_ = std::thread(&LsmTree::background_work, this);
+}
+
+void LsmTree::stop_background() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  work_cond_.notify_all();
+  flush_cond_.notify_all();
+  if (background_.joinable()) {
+    background_.join();
+  }
+}
+
+RC LsmTree::close() {
+  if (!opened_) {
+    return RC::SUCCESS;
+  }
+  stop_background();
+  RC rc = sync();
+  opened_ = false;
+  memtable_.reset();
+  version_.reset();
+  return rc;
+}
+
+RC LsmTree::destroy() {
+  if (!opened_) {
+    return RC::SUCCESS;
+  }
+  stop_background();
+  std::lock_guard<std::mutex> flush_guard(flush_mutex_);
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (const std::vector<std::shared_ptr<LsmRun>> &runs : version_->levels) {
+    for (const std::shared_ptr<LsmRun> &run : runs) {
+      run->set_obsolete();
+    }
+  }
+  opened_ = false;
+  memtable_.reset();
+  immutables_.clear();
+  version_.reset();
+  return RC::SUCCESS;
+}
+
+RC LsmTree::insert_entry(const char *key, const RID *rid) {
+  return write_entry(key, rid, false);
+}
+
+RC LsmTree::delete_entry(const char *key, const RID *rid) {
+  return write_entry(key, rid, true);
+}
+
+RC LsmTree::write_entry(const char *key, const RID *rid, bool tombstone) {
+  std::string entry(entry_length(), '\0');
+  memcpy(&entry[0], key, key_length_);
+  encode_rid(rid, &entry[key_length_]);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!opened_) {
+    return RC::RECORD_CLOSED;
+  }
+  // 后台线程来不及写出时限制写入的速度，memtable占用的内存不会无限增长
+  while ((int)immutables_.size() >= MAX_IMMUTABLE_NUM && !stop_) {
+    flush_cond_.wait(lock);
+  }
+
+  auto result = memtable_->entries.emplace(std::move(entry), tombstone);
+  if (result.second) {
+    memtable_->memory += entry_length() + MEMTABLE_ENTRY_OVERHEAD;
+  } else {
+    result.first->second = tombstone;
+  }
+  bytes_inserted_ += entry_length();
+  if (memtable_->memory >= memtable_size_) {
+    seal_memtable();
+    work_cond_.notify_one();
+  }
+  return RC::SUCCESS;
+}
+
+/**
+ * 当前的memtable变成只读的，等待写出。需要持有mutex_
+ */
+void LsmTree::seal_memtable() {
+  if (memtable_->entries.empty()) {
+    return;
+  }
+  immutables_.push_back(memtable_);
+  memtable_ = std::make_shared<LsmMemtable>();
+}
+
+void LsmTree::background_work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    bool has_work = !immutables_.empty() || level_to_compact() >= 0;
+    if (!has_work || background_rc_ != RC::SUCCESS) {
+      // 出错之后过一段时间再重试
+      work_cond_.wait_for(lock, std::chrono::seconds(1));
+      background_rc_ = RC::SUCCESS;
+      continue;
+    }
+    lock.unlock();
+
+    RC rc = RC::SUCCESS;
+    {
+      std::lock_guard<std::mutex> flush_guard(flush_mutex_);
+      while (rc == RC::SUCCESS && has_immutable()) {
+        rc = flush_immutable();
+      }
+      int level;
+      while (rc == RC::SUCCESS && (level = pick_compaction()) >= 0) {
+        rc = compact_level(level);
+      }
+    }
+
+    lock.lock();
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Lsm background work failed. file=%s, rc=%d:%s", file_name_.c_str(), rc, strrc(rc));
+      background_rc_ = rc;
+    }
+  }
+}
+
+RC LsmTree::sync() {
+  if (!opened_) {
+    return RC::RECORD_CLOSED;
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    seal_memtable();
+  }
+  std::lock_guard<std::mutex> flush_guard(flush_mutex_);
+  RC rc = RC::SUCCESS;
+  while (rc == RC::SUCCESS && has_immutable()) {
+    rc = flush_immutable();
+  }
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  return save_manifest();
+}
+
+RC LsmTree::compact() {
+  RC rc = sync();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  std::lock_guard<std::mutex> flush_guard(flush_mutex_);
+  int level;
+  while ((level = pick_compaction()) >= 0) {
+    rc = compact_level(level);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+bool LsmTree::has_immutable() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return !immutables_.empty();
+}
+
+/**
+ * 需要持有mutex_
+ */
+int LsmTree::level_to_compact() const {
+  for (int level = 0; level < (int)version_->levels.size(); level++) {
+    if ((int)version_->levels[level].size() >= runs_per_level_) {
+      return level;
+    }
+  }
+  return -1;
+}
+
+int LsmTree::pick_compaction() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return stop_ ? -1 : level_to_compact();
+}
+
+/**
+ * 写出最早的一个memtable，放到第0层
+ */
+RC LsmTree::flush_immutable() {
+  std::shared_ptr<const LsmMemtable> memtable;
+  bool no_runs = true;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (immutables_.empty()) {
+      return RC::SUCCESS;
+    }
+    memtable = immutables_.front();
+    for (const std::vector<std::shared_ptr<LsmRun>> &runs : version_->levels) {
+      no_runs = no_runs && runs.empty();
+    }
+  }
+
+  // 没有更早的数据时删除标记可以直接去掉
+  LsmMergeIterator iterator(entry_length());
+  iterator.add_source(std::unique_ptr<LsmMergeIterator::Source>(new MemtableSource(memtable, std::string())));
+  std::shared_ptr<LsmRun> run;
+  RC rc = write_run(iterator, no_runs, memtable->entries.size(), run);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::shared_ptr<LsmVersion> version = std::make_shared<LsmVersion>(*version_);
+    if (run != nullptr) {
+      if (version->levels.empty()) {
+        version->levels.resize(1);
+      }
+      version->levels[0].push_back(run);
+    }
+    version_ = version;
+    immutables_.erase(immutables_.begin());
+    flushes_++;
+  }
+  flush_cond_.notify_all();
+  work_cond_.notify_one();
+  return save_manifest();
+}
+
+/**
+ * 把一层的所有文件合并成一个，放到下一层
+ */
+RC LsmTree::compact_level(int level) {
+  std::vector<std::shared_ptr<LsmRun>> runs;
+  bool bottom = true;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    runs = version_->levels[level];
+    for (int i = level + 1; i < (int)version_->levels.size(); i++) {
+      bottom = bottom && version_->levels[i].empty();
+    }
+  }
+
+  // 越新的文件越靠前
+  LsmMergeIterator iterator(entry_length());
+  int64_t expect_count = 0;
+  for (auto iter = runs.rbegin(); iter != runs.rend(); ++iter) {
+    RunSource *source = new RunSource(*iter, entry_length());
+    iterator.add_source(std::unique_ptr<LsmMergeIterator::Source>(source));
+    RC rc = source->seek(std::string(entry_length(), '\0'));
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    expect_count += (*iter)->entry_count();
+  }
+  std::shared_ptr<LsmRun> run;
+  RC rc = write_run(iterator, bottom, expect_count, run);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::shared_ptr<LsmVersion> version = std::make_shared<LsmVersion>(*version_);
+    std::vector<std::shared_ptr<LsmRun>> &level_runs = version->levels[level];
+    // 合并期间第0层可能又写出了新的文件，只去掉参与合并的
+    level_runs.erase(level_runs.begin(), level_runs.begin() + runs.size());
+    if ((int)version->levels.size() <= level + 1) {
+      version->levels.resize(level + 2);
+    }
+    if (run != nullptr) {
+      version->levels[level + 1].push_back(run);
+    }
+    version_ = version;
+    compactions_++;
+  }
+  rc = save_manifest();
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  // 文件列表中已经没有这些文件了，最后一个扫描结束后删除
+  for (const std::shared_ptr<LsmRun> &old_run : runs) {
+    old_run->set_obsolete();
+  }
+  LOG_INFO("Compact %d runs of level %d into level %d. file=%s, entries=%ld",
+           (int)runs.size(), level, level + 1, file_name_.c_str(), run == nullptr ? 0 : run->entry_count());
+  return RC::SUCCESS;
+}
+
+/**
+ * 把iterator中的索引项写成一个新的有序文件。所有索引项都被去掉时run返回空
+ */
+RC LsmTree::write_run(LsmMergeIterator &iterator, bool drop_tombstones, int64_t expect_count,
+                      std::shared_ptr<LsmRun> &run) {
+  int64_t seq;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    seq = next_seq_++;
+  }
+  const std::string file_name = run_file(seq);
+  std::fstream fs;
+  fs.open(file_name, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!fs.is_open()) {
+    LOG_ERROR("Failed to open file for write. file name=%s, errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR;
+  }
+
+  const int entry_len = entry_length();
+  const int record_length = entry_len + 1;
+  const int records_per_block = LsmRun::BLOCK_SIZE / record_length;
+  std::vector<char> block(LsmRun::BLOCK_SIZE, 0);
+  fs.write(block.data(), block.size());   // 文件头最后再写
+
+  BloomFilter bloom_filter;
+  bloom_filter.init(expect_count);
+  std::vector<char> fences;
+  std::string last_entry;
+  int64_t count = 0;
+  int records = 0;
+  RC rc;
+  const char *entry;
+  bool tombstone;
+  while ((rc = iterator.next(&entry, &tombstone)) == RC::SUCCESS) {
+    if (tombstone && drop_tombstones) {
+      continue;
+    }
+    if (records == records_per_block) {
+      fs.write(block.data(), block.size());
+      memset(block.data(), 0, block.size());
+      records = 0;
+    }
+    if (records == 0) {
+      fences.insert(fences.end(), entry, entry + entry_len);
+    }
+    memcpy(block.data() + records * record_length, entry, entry_len);
+    block[records * record_length + entry_len] = tombstone ? 1 : 0;
+    records++;
+    // 同一个key的多个索引项只加一次
+    if (count == 0 || memcmp(last_entry.data(), entry, bloom_key_length_) != 0) {
+      bloom_filter.add(BloomFilter::hash(entry, bloom_key_length_));
+    }
+    last_entry.assign(entry, entry_len);
+    count++;
+  }
+  if (rc != RC::RECORD_EOF) {
+    LOG_ERROR("Failed to read entries while writing lsm run %s. rc=%d:%s", file_name.c_str(), rc, strrc(rc));
+    fs.close();
+    remove(file_name.c_str());
+    return rc;
+  }
+  if (count == 0) {
+    fs.close();
+    remove(file_name.c_str());
+    run = nullptr;
+    return RC::SUCCESS;
+  }
+  fs.write(block.data(), block.size());
+
+  LsmRunHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LSM_RUN_MAGIC, sizeof(header.magic));
+  header.entry_length = entry_len;
+  header.bloom_key_length = bloom_key_length_;
+  header.entry_count = count;
+  header.block_count = fences.size() / entry_len;
+  header.fence_offset = fs.tellp();
+  fs.write(fences.data(), fences.size());
+  fs.write(last_entry.data(), last_entry.size());
+  header.bloom_offset = fs.tellp();
+  bloom_filter.serialize(fs, bloom_key_length_);
+  header.file_size = fs.tellp();
+  fs.seekp(0);
+  fs.write((const char *)&header, sizeof(header));
+  fs.close();
+  if (fs.fail()) {
+    LOG_ERROR("Failed to write lsm run %s. sys err=%d:%s", file_name.c_str(), errno, strerror(errno));
+    remove(file_name.c_str());
+    return RC::IOERR_WRITE;
+  }
+
+  // 文件列表引用这个文件之前先落盘
+  int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd < 0 || fsync(fd) != 0) {
+    LOG_ERROR("Failed to fsync lsm run %s. sys err=%d:%s", file_name.c_str(), errno, strerror(errno));
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    remove(file_name.c_str());
+    return RC::IOERR_FSYNC;
+  }
+  ::close(fd);
+
+  rc = LsmRun::open(file_name, seq, entry_len, run);
+  if (rc != RC::SUCCESS) {
+    remove(file_name.c_str());
+    return rc;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  bytes_written_ += header.file_size;
+  return RC::SUCCESS;
+}
+
+/**
+ * 先写临时文件再改名，不会留下写了一半的文件列表
+ */
+RC LsmTree::save_manifest() {
+  std::shared_ptr<const LsmVersion> version;
+  LsmManifestHeader header;
+  memset(&header, 0, sizeof(header));
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    version = version_;
+    header.next_seq = next_seq_;
+  }
+  memcpy(header.magic, LSM_MANIFEST_MAGIC, sizeof(header.magic));
+  header.key_length = key_length_;
+  header.bloom_key_length = bloom_key_length_;
+  header.level_num = version->levels.size();
+
+  std::string tmp_file = file_name_ + ".tmp";
+  std::fstream fs;
+  fs.open(tmp_file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!fs.is_open()) {
+    LOG_ERROR("Failed to open file for write. file name=%s, errmsg=%s", tmp_file.c_str(), strerror(errno));
+    return RC::IOERR;
+  }
+  fs.write((const char *)&header, sizeof(header));
+  for (const std::vector<std::shared_ptr<LsmRun>> &runs : version->levels) {
+    int32_t run_num = runs.size();
+    fs.write((const char *)&run_num, sizeof(run_num));
+    for (const std::shared_ptr<LsmRun> &run : runs) {
+      int64_t seq = run->seq();
+      fs.write((const char *)&seq, sizeof(seq));
+    }
+  }
+  fs.close();
+  if (fs.fail()) {
+    LOG_ERROR("Failed to write lsm index file %s. sys err=%d:%s", tmp_file.c_str(), errno, strerror(errno));
+    remove(tmp_file.c_str());
+    return RC::IOERR_WRITE;
+  }
+  if (rename(tmp_file.c_str(), file_name_.c_str()) != 0) {
+    LOG_ERROR("Failed to rename tmp lsm index file (%s) to %s. system error=%d:%s",
+              tmp_file.c_str(), file_name_.c_str(), errno, strerror(errno));
+    remove(tmp_file.c_str());
+    return RC::IOERR;
+  }
+  return RC::SUCCESS;
+}
+
+LsmStats LsmTree::stats() const {
+  LsmStats stats;
+  std::lock_guard<std::mutex> guard(mutex_);
+  stats.flushes = flushes_;
+  stats.compactions = compactions_;
+  stats.bytes_inserted = bytes_inserted_;
+  stats.bytes_written = bytes_written_;
+  if (memtable_ != nullptr) {
+    stats.memtable_memory = memtable_->memory;
+  }
+  for (const std::shared_ptr<const LsmMemtable> &memtable : immutables_) {
+    stats.memtable_memory += memtable->memory;
+  }
+  if (version_ != nullptr) {
+    for (const std::vector<std::shared_ptr<LsmRun>> &runs : version_->levels) {
+      stats.level_runs.push_back(runs.size());
+    }
+  }
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC LsmScanner::open(const char *low, int low_length, bool low_inclusive,
+                    const char *high, int high_length, bool high_inclusive) {
+  const int entry_length = tree_.entry_length();
+  if (low_length > tree_.key_length() || high_length > tree_.key_length()) {
+    return RC::INVALID_ARGUMENT;
+  }
+  low_.assign(low == nullptr ? "" : low, low == nullptr ? 0 : low_length);
+  low_inclusive_ = low_inclusive;
+  high_.assign(high == nullptr ? "" : high, high == nullptr ? 0 : high_length);
+  high_inclusive_ = high_inclusive;
+
+  // 下界后面补0，定位到以下界开头的第一个索引项
+  std::string seek(entry_length, '\0');
+  memcpy(&seek[0], low_.data(), low_.size());
+
+  std::shared_ptr<LsmMemtable> memtable = std::make_shared<LsmMemtable>();
+  std::vector<std::shared_ptr<const LsmMemtable>> immutables;
+  std::shared_ptr<const LsmVersion> version;
+  {
+    std::lock_guard<std::mutex> guard(tree_.mutex_);
+    if (!tree_.opened_) {
+      return RC::RECORD_CLOSED;
+    }
+    // 当前的memtable还会被修改，拷贝出扫描范围内的部分
+    const std::map<std::string, bool> &entries = tree_.memtable_->entries;
+    for (auto iter = entries.lower_bound(seek); iter != entries.end(); ++iter) {
+      if (!high_.empty() && memcmp(iter->first.data(), high_.data(), high_.size()) > 0) {
+        break;
+      }
+      memtable->entries.emplace_hint(memtable->entries.end(), iter->first, iter->second);
+    }
+    immutables = tree_.immutables_;
+    version = tree_.version_;
+  }
+
+  const bool equal = low != nullptr && high != nullptr && low_inclusive && high_inclusive && low_ == high_;
+  iterator_.reset(new LsmMergeIterator(entry_length));
+  iterator_->add_source(std::unique_ptr<LsmMergeIterator::Source>(new MemtableSource(memtable, seek)));
+  for (auto iter = immutables.rbegin(); iter != immutables.rend(); ++iter) {
+    iterator_->add_source(std::unique_ptr<LsmMergeIterator::Source>(new MemtableSource(*iter, seek)));
+  }
+  for (const std::vector<std::shared_ptr<LsmRun>> &runs : version->levels) {
+    for (auto iter = runs.rbegin(); iter != runs.rend(); ++iter) {
+      const std::shared_ptr<LsmRun> &run = *iter;
+      // 范围不相交或者Bloom过滤器判断不存在的文件不用读
+      if (!low_.empty() && memcmp(run->last_entry(), low_.data(), low_.size()) < 0) {
+        continue;
+      }
+      if (!high_.empty() && memcmp(run->first_entry(), high_.data(), high_.size()) > 0) {
+        continue;
+      }
+      if (equal && !run->may_contain(low_.data(), low_.size())) {
+        continue;
+      }
+      RunSource *source = new RunSource(run, entry_length);
+      iterator_->add_source(std::unique_ptr<LsmMergeIterator::Source>(source));
+      RC rc = source->seek(seek);
+      if (rc != RC::SUCCESS) {
+        iterator_.reset();
+        return rc;
+      }
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC LsmScanner::next_entry(RID *rid, char *key) {
+  if (iterator_ == nullptr) {
+    return RC::RECORD_CLOSED;
+  }
+  RC rc;
+  const char *entry;
+  bool tombstone;
+  while ((rc = iterator_->next(&entry, &tombstone)) == RC::SUCCESS) {
+    if (!high_.empty()) {
+      int result = memcmp(entry, high_.data(), high_.size());
+      if (result > 0 || (result == 0 && !high_inclusive_)) {
+        return RC::RECORD_EOF;
+      }
+    }
+    if (tombstone) {
+      continue;
+    }
+    if (!low_.empty() && !low_inclusive_ && memcmp(entry, low_.data(), low_.size()) == 0) {
+      continue;
+    }
+    LsmTree::decode_rid(entry + tree_.key_length(), rid);
+    if (key != nullptr) {
+      memcpy(key, entry, tree_.key_length());
+    }
+    return RC::SUCCESS;
+  }
+  return rc;
+}
+
+RC LsmScanner::close() {
+  iterator_.reset();
+  return RC::SUCCESS;
+}
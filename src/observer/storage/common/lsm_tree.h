@@ -0,0 +1,319 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_LSM_TREE_H_
+#define __OBSERVER_STORAGE_COMMON_LSM_TREE_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rc.h"
+#include "storage/common/bloom_filter.h"
+#include "storage/common/record_manager.h"
+
+/**
+ * LSM索引的参数，由DefaultStorageStage根据配置文件设置
+ */
+struct LsmOptions {
+  size_t memtable_size = 4 * 1024 * 1024;   // memtable超过这个大小后写成一个有序文件
+  int    runs_per_level = 4;                // 一层的有序文件达到这个个数后合并到下一层
+
+  static LsmOptions &instance();
+};
+
+struct LsmStats {
+  long   flushes = 0;           // memtable写出的次数
+  long   compactions = 0;       // 合并的次数
+  long   bytes_inserted = 0;    // 插入和删除的索引项的总长度
+  long   bytes_written = 0;     // 写出和合并时写文件的总长度
+  size_t memtable_memory = 0;
+  std::vector<int> level_runs;  // 每一层的有序文件个数
+
+  /**
+   * 写放大: 写到磁盘的数据量与插入的数据量之比
+   */
+  double write_amplification() const {
+    return bytes_inserted == 0 ? 0 : (double)bytes_written / bytes_inserted;
+  }
+};
+
+/**
+ * 磁盘上的一个不可修改的有序文件(sorted run)。
+ * 索引项按固定大小的块存放，每个块的第一个索引项作为栅栏(fence pointer)常驻内存，
+ * 查找时二分栅栏，只需要读一个块。文件末尾还有一个key前缀上的Bloom过滤器
+ */
+class LsmRun {
+public:
+  static const int BLOCK_SIZE = 4096;
+
+public:
+  ~LsmRun();
+
+  static RC open(const std::string &file_name, int64_t seq, int entry_length, std::shared_ptr<LsmRun> &run);
+
+  int64_t seq() const {
+    return seq_;
+  }
+  const std::string &file_name() const {
+    return file_name_;
+  }
+  int64_t entry_count() const {
+    return entry_count_;
+  }
+  int64_t block_count() const {
+    return (int64_t)fences_.size() / entry_length_;
+  }
+  int records_per_block() const {
+    return records_per_block_;
+  }
+  int64_t file_size() const {
+    return file_size_;
+  }
+  const char *first_entry() const {
+    return fences_.data();
+  }
+  const char *last_entry() const {
+    return last_entry_.data();
+  }
+
+  /**
+   * 可能包含entry的块: 第一个索引项不大于entry的最后一个块
+   */
+  int64_t find_block(const char *entry) const;
+
+  /**
+   * 读取一个块。每条记录是索引项加一个字节的删除标记
+   */
+  RC read_block(int64_t block, std::vector<char> &buffer) const;
+
+  bool may_contain(const char *key, int length) const;
+
+  /**
+   * 合并之后不再使用，最后一个引用释放时删除文件
+   */
+  void set_obsolete() {
+    obsolete_ = true;
+  }
+
+private:
+  LsmRun() = default;
+
+private:
+  std::string       file_name_;
+  int64_t           seq_ = 0;
+  int               fd_ = -1;
+  int               entry_length_ = 0;
+  int               records_per_block_ = 0;
+  int               bloom_key_length_ = 0;
+  int64_t           entry_count_ = 0;
+  int64_t           file_size_ = 0;
+  std::vector<char> fences_;       // 每个块的第一个索引项
+  std::string       last_entry_;
+  BloomFilter       bloom_filter_;
+  std::atomic<bool> obsolete_{false};
+};
+
+/**
+ * 内存中的有序表。key是索引项(属性值 + 编码后的RID)，value表示是否是删除标记
+ */
+struct LsmMemtable {
+  std::map<std::string, bool> entries;
+  size_t memory = 0;
+};
+
+/**
+ * 某个时刻所有有序文件的集合。levels[0]是memtable直接写出的文件，
+ * 每一层中越靠后的文件越新，上一层的文件都比下一层的新
+ */
+struct LsmVersion {
+  std::vector<std::vector<std::shared_ptr<LsmRun>>> levels;
+};
+
+/**
+ * 按从新到旧的顺序合并多个有序的数据源，相同的索引项只返回最新的一个
+ */
+class LsmMergeIterator {
+public:
+  class Source {
+  public:
+    virtual ~Source() = default;
+    virtual bool valid() const = 0;
+    virtual const char *entry() const = 0;
+    virtual bool tombstone() const = 0;
+    virtual RC next() = 0;
+  };
+
+public:
+  explicit LsmMergeIterator(int entry_length) : entry_length_(entry_length) {
+  }
+
+  /**
+   * 先加入的数据源更新
+   */
+  void add_source(std::unique_ptr<Source> source) {
+    sources_.push_back(std::move(source));
+  }
+
+  /**
+   * 返回下一个索引项。没有更多数据时返回RECORD_EOF
+   */
+  RC next(const char **entry, bool *tombstone);
+
+private:
+  int entry_length_;
+  std::vector<std::unique_ptr<Source>> sources_;
+  std::string current_;
+  int current_source_ = -1;
+};
+
+/**
+ * 写优化的LSM树。写入只修改内存中的memtable，写满后由后台线程写成有序文件，
+ * 同一层的文件个数达到runs_per_level后合并成一个文件放到下一层(tiering)，
+ * 每个索引项每下降一层只被重写一次，写放大约等于层数。
+ * 删除写入删除标记，合并到最底层时才真正去掉。
+ * 索引项是定长的字节串(key + RID)，整体按memcmp排序，key需要调用者编码成可比较的形式。
+ * 文件列表保存在file_name中，有序文件是file_name.<seq>.run
+ */
+class LsmTree {
+public:
+  LsmTree() = default;
+  ~LsmTree();
+
+  /**
+   * @param bloom_key_length 有序文件中Bloom过滤器使用的key前缀长度
+   */
+  RC create(const char *file_name, int key_length, int bloom_key_length);
+  RC open(const char *file_name);
+  RC close();
+
+  /**
+   * 把memtable写成有序文件并保存文件列表
+   */
+  RC sync();
+
+  RC insert_entry(const char *key, const RID *rid);
+  RC delete_entry(const char *key, const RID *rid);
+
+  /**
+   * 写出memtable并把能合并的层都合并完
+   */
+  RC compact();
+
+  /**
+   * 关闭并删除所有有序文件，文件列表由调用者删除
+   */
+  RC destroy();
+
+  int key_length() const {
+    return key_length_;
+  }
+  int entry_length() const {
+    return key_length_ + RID_LENGTH;
+  }
+  int bloom_key_length() const {
+    return bloom_key_length_;
+  }
+
+  LsmStats stats() const;
+
+  static void encode_rid(const RID *rid, char *out);
+  static void decode_rid(const char *data, RID *rid);
+
+private:
+  friend class LsmScanner;
+
+  static const int RID_LENGTH = 8;
+  static const int MAX_IMMUTABLE_NUM = 2;   // 等待写出的memtable超过这个个数时写入需要等待
+
+  RC write_entry(const char *key, const RID *rid, bool tombstone);
+  void seal_memtable();
+  void start_background();
+  void stop_background();
+  void background_work();
+
+  /**
+   * 下面几个函数需要持有flush_mutex_
+   */
+  RC flush_immutable();
+  RC compact_level(int level);
+  bool has_immutable() const;
+  int level_to_compact() const;
+  int pick_compaction() const;
+  RC write_run(LsmMergeIterator &iterator, bool drop_tombstones, int64_t expect_count,
+               std::shared_ptr<LsmRun> &run);
+  RC save_manifest();
+
+  std::string run_file(int64_t seq) const;
+
+private:
+  std::string file_name_;
+  int         key_length_ = 0;
+  int         bloom_key_length_ = 0;
+  size_t      memtable_size_ = 0;
+  int         runs_per_level_ = 0;
+  bool        opened_ = false;
+
+  mutable std::mutex mutex_;                    // 保护memtable_、immutables_、version_和next_seq_
+  std::condition_variable work_cond_;           // 通知后台线程
+  std::condition_variable flush_cond_;          // 通知等待写出memtable的写入者
+  std::shared_ptr<LsmMemtable> memtable_;
+  std::vector<std::shared_ptr<const LsmMemtable>> immutables_;   // 越靠后越新
+  std::shared_ptr<const LsmVersion> version_;
+  int64_t     next_seq_ = 1;
+
+  std::mutex  flush_mutex_;                     // 写出memtable、合并、保存文件列表互斥
+  std::thread background_;
+  bool        stop_ = false;
+  RC          background_rc_ = RC::SUCCESS;
+
+  long flushes_ = 0;
+  long compactions_ = 0;
+  long bytes_inserted_ = 0;
+  long bytes_written_ = 0;
+};
+
+/**
+ * LSM树上的范围扫描。打开时取得memtable和有序文件的快照，之后的写入不可见。
+ * 上下界按前缀比较，low/high为空表示没有边界
+ */
+class LsmScanner {
+public:
+  explicit LsmScanner(LsmTree &tree) : tree_(tree) {
+  }
+
+  RC open(const char *low, int low_length, bool low_inclusive,
+          const char *high, int high_length, bool high_inclusive);
+
+  /**
+   * @param key 返回索引项的key，至少key_length字节，可以为空
+   */
+  RC next_entry(RID *rid, char *key);
+  RC close();
+
+private:
+  LsmTree &tree_;
+  std::unique_ptr<LsmMergeIterator> iterator_;
+  std::string low_;
+  bool        low_inclusive_ = true;
+  std::string high_;
+  bool        high_inclusive_ = true;
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_LSM_TREE_H_
@@ -104,6 +104,17 @@ RC RecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, int file_id,
     return ret;
   }
 
+  init_page_header(record_size);
+  ret = disk_buffer_pool_->append_log(file_id_, &page_handle_, CLogType::RECORD_PAGE_INIT, record_size, nullptr, 0);
+  if (ret != RC::SUCCESS) {
+    LOG_ERROR("Failed to log init of record page. ret=%s", strrc(ret));
+    return ret;
+  }
+
+  return RC::SUCCESS;
+}
+
+void RecordPageHandler::init_page_header(int record_size) {
   int page_size = sizeof(page_handle_.frame->page.data);
   int record_phy_size = align8(record_size);
   page_header_->record_num = 0;
@@ -114,12 +125,6 @@ RC RecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, int file_id,
   bitmap_ = page_handle_.frame->page.data + page_fix_size();
 
   memset(bitmap_, 0, page_bitmap_size(page_header_->record_capacity));
-  ret = disk_buffer_pool_->mark_dirty(&page_handle_);
-  if (ret != RC::SUCCESS) {
-    LOG_ERROR("Failed to mark page dirty. ret=%s", strrc(ret));
-  }
-
-  return RC::SUCCESS;
 }
 
 RC RecordPageHandler::deinit() {
@@ -135,6 +140,8 @@ RC RecordPageHandler::deinit() {
     }
     disk_buffer_pool_ = nullptr;
   }
+  // 页面可能已经释放，不能再通过get_page_num读取
+  page_header_ = nullptr;
 
   return RC::SUCCESS;
 }
@@ -158,9 +165,9 @@ RC RecordPageHandler::insert_record(const char *data, RID *rid) {
       page_header_->first_record_offset + (index * page_header_->record_size);
   memcpy(record_data, data, page_header_->record_real_size);    // Copy data to buffer pool frames' memory from a tmp constructor `data`
 
-  RC rc = disk_buffer_pool_->mark_dirty(&page_handle_);
+  RC rc = append_log(CLogType::RECORD_INSERT, index, record_data);
   if (rc != RC::SUCCESS) {
-    LOG_ERROR("Failed to mark page dirty. rc =%d:%s", rc, strrc(rc));
+    LOG_ERROR("Failed to log insert record. rc =%d:%s", rc, strrc(rc));
     // hard to rollback
   }
 
@@ -196,9 +203,9 @@ RC RecordPageHandler::update_record(const Record *rec) {
     char *record_data = page_handle_.frame->page.data +
         page_header_->first_record_offset + (rec->rid.slot_num * page_header_->record_size);    // 一个Page由Page_num、页分配信息(BPFileSubHandler)(这里字节对齐大小为first record 实际为BP_FILE_SUB_HDR_SIZE)与实际存储data组成
     memcpy(record_data, rec->data, page_header_->record_real_size);    // Copy data to buffer pool frames' memory from a tmp constructor `Record *rec->data`
-    ret = disk_buffer_pool_->mark_dirty(&page_handle_);
+    ret = append_log(CLogType::RECORD_UPDATE, rec->rid.slot_num, record_data);
     if (ret != RC::SUCCESS) {
-      LOG_ERROR("Failed to mark page dirty. ret=%s", strrc(ret));
+      LOG_ERROR("Failed to log update record. ret=%s", strrc(ret));
     }
   }
 
@@ -221,9 +228,9 @@ RC RecordPageHandler::delete_record(const RID *rid) {
   if (bitmap.get_bit(rid->slot_num)) {
     bitmap.clear_bit(rid->slot_num);
     page_header_->record_num--;
-    ret = disk_buffer_pool_->mark_dirty(&page_handle_);
+    ret = append_log(CLogType::RECORD_DELETE, rid->slot_num, nullptr);
     if (ret != RC::SUCCESS) {
-      LOG_ERROR("failed to mark page dirty in delete record. ret=%d:%s", ret, strrc(ret));
+      LOG_ERROR("failed to log delete record. ret=%d:%s", ret, strrc(ret));
       // hard to rollback
     }
 
@@ -244,6 +251,48 @@ RC RecordPageHandler::delete_record(const RID *rid) {
   return ret;
 }
 
+RC RecordPageHandler::append_log(CLogType type, SlotNum slot_num, const char *data) {
+  return disk_buffer_pool_->append_log(file_id_, &page_handle_, type, slot_num, data,
+                                       data == nullptr ? 0 : page_header_->record_real_size);
+}
+
+RC RecordPageHandler::redo(CLogType type, SlotNum slot_num, const char *data, int length, LSN lsn) {
+  Page &page = page_handle_.frame->page;
+  if (page.lsn >= lsn) {
+    return RC::SUCCESS;  // 页面写回时已经包含了这条日志的修改
+  }
+  if (type == CLogType::RECORD_PAGE_INIT) {
+    init_page_header(slot_num);
+    page.lsn = lsn;
+    return disk_buffer_pool_->mark_dirty(&page_handle_);
+  }
+
+  if (slot_num < 0 || slot_num >= page_header_->record_capacity ||
+      (type != CLogType::RECORD_DELETE && length != page_header_->record_real_size)) {
+    LOG_ERROR("Invalid record to redo, file_id:page_num %d:%d, slot_num=%d, length=%d",
+              file_id_, get_page_num(), slot_num, length);
+    return RC::RECORD_INVALIDRID;
+  }
+
+  Bitmap bitmap(bitmap_, page_header_->record_capacity);
+  if (type == CLogType::RECORD_DELETE) {
+    if (bitmap.get_bit(slot_num)) {
+      bitmap.clear_bit(slot_num);
+      page_header_->record_num--;
+    }
+  } else {
+    if (!bitmap.get_bit(slot_num)) {
+      bitmap.set_bit(slot_num);
+      page_header_->record_num++;
+    }
+    char *record_data = page_handle_.frame->page.data +
+        page_header_->first_record_offset + (slot_num * page_header_->record_size);
+    memcpy(record_data, data, length);
+  }
+  page.lsn = lsn;
+  return disk_buffer_pool_->mark_dirty(&page_handle_);
+}
+
 RC RecordPageHandler::get_record(const RID *rid, Record *rec) {
   if (rid->slot_num >= page_header_->record_capacity) {
     LOG_ERROR("Invalid slot_num:%d, exceed page's record capacity, file_id:page_num %d:%d.",
@@ -347,6 +396,7 @@ void RecordFileHandler::close() {
 }
 
 RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid) {
+  std::lock_guard<std::recursive_mutex> latch(write_latch_);
   RC ret = RC::SUCCESS;
   // 找到没有填满的页面 
   int page_count = 0;
@@ -359,11 +409,12 @@ RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
   if (current_page_num < 0) {
     if (page_count >= 2) { // 当前buffer pool 有页面时才尝试加载第一页
       // 参考diskBufferPool，pageNum从1开始
-      if ((ret = record_page_handler_.init(*disk_buffer_pool_, file_id_, 1)) != RC::SUCCESS) {
+      ret = record_page_handler_.init(*disk_buffer_pool_, file_id_, 1);
+      if (ret != RC::SUCCESS && ret != RC::BUFFERPOOL_INVALID_PAGE_NUM) {
         LOG_ERROR("Failed to init record page handler.ret=%d", ret);
         return ret;
       }
-      current_page_num = record_page_handler_.get_page_num();
+      current_page_num = ret == RC::SUCCESS ? record_page_handler_.get_page_num() : 0;
     } else {
       current_page_num = 0;
     }
@@ -382,6 +433,10 @@ RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
         LOG_ERROR("Failed to init record page handler. page number is %d. ret=%d:%s", current_page_num, ret, strrc(ret));
         return ret;
       }
+      if (ret == RC::BUFFERPOOL_INVALID_PAGE_NUM) {
+        // 记录都删除之后页面已经释放
+        continue;
+      }
     }
 
     if (!record_page_handler_.is_full()) {
@@ -419,11 +474,11 @@ RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
 }
 
 RC RecordFileHandler::update_record(const Record *rec) {
-
+  std::lock_guard<std::recursive_mutex> latch(write_latch_);
   RC ret = RC::SUCCESS;
 
   RecordPageHandler page_handler;
-  if ((ret != page_handler.init(*disk_buffer_pool_, file_id_, rec->rid.page_num)) != RC::SUCCESS) {
+  if ((ret = page_handler.init(*disk_buffer_pool_, file_id_, rec->rid.page_num)) != RC::SUCCESS) {
     LOG_ERROR("Failed to init record page handler.page number=%d, file_id=%d",
               rec->rid.page_num, file_id_);
     return ret;
@@ -433,10 +488,10 @@ RC RecordFileHandler::update_record(const Record *rec) {
 }
 
 RC RecordFileHandler::delete_record(const RID *rid) {
-
+  std::lock_guard<std::recursive_mutex> latch(write_latch_);
   RC ret = RC::SUCCESS;
   RecordPageHandler page_handler;
-  if ((ret != page_handler.init(*disk_buffer_pool_, file_id_, rid->page_num)) != RC::SUCCESS) {
+  if ((ret = page_handler.init(*disk_buffer_pool_, file_id_, rid->page_num)) != RC::SUCCESS) {
     LOG_ERROR("Failed to init record page handler.page number=%d, file_id:%d",
               rid->page_num, file_id_);
     return ret;
@@ -452,7 +507,7 @@ RC RecordFileHandler::get_record(const RID *rid, Record *rec) {
     return RC::INVALID_ARGUMENT;
   }
   RecordPageHandler page_handler;
-  if ((ret != page_handler.init(*disk_buffer_pool_, file_id_, rid->page_num)) != RC::SUCCESS) {
+  if ((ret = page_handler.init(*disk_buffer_pool_, file_id_, rid->page_num)) != RC::SUCCESS) {
     LOG_ERROR("Failed to init record page handler.page number=%d, file_id:%d",
               rid->page_num, file_id_);
     return ret;
@@ -529,6 +584,8 @@ RC RecordFileScanner::get_next_record(Record *rec) {
       }
 
       if (RC::BUFFERPOOL_INVALID_PAGE_NUM == ret) {
+        // 已经释放的页面，最后的页面都释放时返回RECORD_EOF
+        ret = RC::RECORD_EOF;
         current_record.rid.page_num++;
         current_record.rid.slot_num = -1;
         continue;
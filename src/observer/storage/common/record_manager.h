@@ -14,7 +14,12 @@ See the Mulan PSL v2 for more details. */
 #ifndef __OBSERVER_STORAGE_COMMON_RECORD_MANAGER_H_
 #define __OBSERVER_STORAGE_COMMON_RECORD_MANAGER_H_
 
+#include <mutex>
+#include <vector>
+
+#include "common/log/log.h"
 #include "storage/default/disk_buffer_pool.h"
+#include "storage/clog/clog.h"
 
 typedef int SlotNum;
 struct PageHeader;
@@ -64,12 +69,19 @@ public:
       return rc;
     }
     rc = updater(record);
-    disk_buffer_pool_->mark_dirty(&page_handle_);
-    return rc;
+    RC rc2 = append_log(CLogType::RECORD_UPDATE, rid->slot_num, record.data);
+    return rc != RC::SUCCESS ? rc : rc2;
   }
 
   RC delete_record(const RID *rid);
 
+  /**
+   * 从日志恢复时重做页面的初始化(slot_num是记录长度)和记录的插入、更新、删除。
+   * 页面的LSN不小于lsn时跳过，重做后页面的LSN设置为lsn。
+   * 删除最后一条记录时不释放页面，释放页面有单独的日志
+   */
+  RC redo(CLogType type, SlotNum slot_num, const char *data, int length, LSN lsn);
+
   RC get_record(const RID *rid, Record *rec);
   RC get_first_record(Record *rec);
   RC get_next_record(Record *rec);
@@ -78,6 +90,10 @@ public:
 
   bool is_full() const;
 
+private:
+  void init_page_header(int record_size);
+  RC append_log(CLogType type, SlotNum slot_num, const char *data);
+
 private:
   DiskBufferPool * disk_buffer_pool_;
   int              file_id_;
@@ -126,20 +142,97 @@ public:
   template<class RecordUpdater> // 改成普通模式, 不使用模板
   RC update_record_in_place(const RID *rid, RecordUpdater updater) {
 
+    std::lock_guard<std::recursive_mutex> latch(write_latch_);
     RC rc = RC::SUCCESS;
     RecordPageHandler page_handler;
-    if ((rc != page_handler.init(*disk_buffer_pool_, file_id_, rid->page_num)) != RC::SUCCESS) {
+    if ((rc = page_handler.init(*disk_buffer_pool_, file_id_, rid->page_num)) != RC::SUCCESS) {
       return rc;
     }
 
     return page_handler.update_record_in_place(rid, updater);
   }
 
+  /**
+   * 原地更新多条记录。rids需要按页面排好序，同一个页面上的记录只固定一次页面。
+   * 某条记录更新失败时继续处理后面的记录，返回第一个错误
+   */
+  template<class RecordUpdater>
+  RC update_records_in_place(const std::vector<RID> &rids, RecordUpdater updater) {
+    std::lock_guard<std::recursive_mutex> latch(write_latch_);
+    return for_each_page(rids, [&updater](RecordPageHandler &page_handler, const RID &rid) {
+      return page_handler.update_record_in_place(&rid, updater);
+    });
+  }
+
+  /**
+   * 删除多条记录，删除之前用visitor访问记录。rids需要按页面排好序，同一个页面上的记录只固定一次页面，
+   * 页面上的记录全部删除后释放页面。某条记录删除失败时继续处理后面的记录，返回第一个错误
+   */
+  template<class RecordVisitor>
+  RC delete_records(const std::vector<RID> &rids, RecordVisitor visitor) {
+    std::lock_guard<std::recursive_mutex> latch(write_latch_);
+    return for_each_page(rids, [&visitor](RecordPageHandler &page_handler, const RID &rid) {
+      Record record;
+      RC rc = page_handler.get_record(&rid, &record);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+      visitor(record);
+      return page_handler.delete_record(&rid);
+    });
+  }
+
+  /**
+   * 只读地访问多条记录，rids的要求同delete_records。某条记录读取失败时继续处理后面的记录，返回第一个错误
+   */
+  template<class RecordVisitor>
+  RC visit_records(const std::vector<RID> &rids, RecordVisitor visitor) {
+    return for_each_page(rids, [&visitor](RecordPageHandler &page_handler, const RID &rid) {
+      Record record;
+      RC rc = page_handler.get_record(&rid, &record);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+      visitor(record);
+      return RC::SUCCESS;
+    });
+  }
+
+private:
+  template<class RecordOperator>
+  RC for_each_page(const std::vector<RID> &rids, RecordOperator record_operator) {
+    RC first_rc = RC::SUCCESS;
+    size_t i = 0;
+    while (i < rids.size()) {
+      const PageNum page_num = rids[i].page_num;
+      RecordPageHandler page_handler;
+      RC rc = page_handler.init(*disk_buffer_pool_, file_id_, page_num);
+      if (rc != RC::SUCCESS) {
+        LOG_ERROR("Failed to init record page handler.page number=%d, file_id:%d", page_num, file_id_);
+      }
+      for (; i < rids.size() && rids[i].page_num == page_num; i++) {
+        // 删除最后一条记录时页面已经释放
+        if (rc == RC::SUCCESS && page_handler.get_page_num() != page_num) {
+          rc = RC::RECORD_RECORD_NOT_EXIST;
+        }
+        RC record_rc = rc == RC::SUCCESS ? record_operator(page_handler, rids[i]) : rc;
+        if (record_rc != RC::SUCCESS && first_rc == RC::SUCCESS) {
+          first_rc = record_rc;
+        }
+      }
+    }
+    return first_rc;
+  }
+
 private:
   DiskBufferPool  *   disk_buffer_pool_;
   int                 file_id_;                    // 参考DiskBufferPool中的fileId(opened-file slots number)
 
   RecordPageHandler   record_page_handler_;        // 目前只有insert record使用
+
+  // 后台清理线程和执行语句的线程会同时修改同一个页面上的位图和记录个数，修改页面时持有。
+  // 扫描只读取页面，不需要持有
+  std::recursive_mutex write_latch_;
 };
 
 class RecordFileScanner 
@@ -0,0 +1,96 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include "storage/common/rid_bitmap.h"
+
+/**
+ * 去掉末尾全0的字
+ */
+static void trim_words(std::vector<uint64_t> &words) {
+  while (!words.empty() && words.back() == 0) {
+    words.pop_back();
+  }
+}
+
+void RidBitmap::add(const RID &rid) {
+  std::vector<uint64_t> &words = pages_[rid.page_num];
+  const size_t index = rid.slot_num / 64;
+  if (words.size() <= index) {
+    words.resize(index + 1, 0);
+  }
+  words[index] |= (uint64_t)1 << (rid.slot_num % 64);
+}
+
+bool RidBitmap::contains(const RID &rid) const {
+  auto iter = pages_.find(rid.page_num);
+  if (iter == pages_.end()) {
+    return false;
+  }
+  const size_t index = rid.slot_num / 64;
+  return index < iter->second.size() && (iter->second[index] & ((uint64_t)1 << (rid.slot_num % 64))) != 0;
+}
+
+void RidBitmap::intersect(const RidBitmap &other) {
+  for (auto iter = pages_.begin(); iter != pages_.end(); ) {
+    auto other_iter = other.pages_.find(iter->first);
+    if (other_iter == other.pages_.end()) {
+      iter = pages_.erase(iter);
+      continue;
+    }
+    std::vector<uint64_t> &words = iter->second;
+    const std::vector<uint64_t> &other_words = other_iter->second;
+    if (words.size() > other_words.size()) {
+      words.resize(other_words.size());
+    }
+    for (size_t i = 0; i < words.size(); i++) {
+      words[i] &= other_words[i];
+    }
+    trim_words(words);
+    if (words.empty()) {
+      iter = pages_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void RidBitmap::unite(const RidBitmap &other) {
+  for (const auto &page : other.pages_) {
+    std::vector<uint64_t> &words = pages_[page.first];
+    if (words.size() < page.second.size()) {
+      words.resize(page.second.size(), 0);
+    }
+    for (size_t i = 0; i < page.second.size(); i++) {
+      words[i] |= page.second[i];
+    }
+  }
+}
+
+void RidBitmap::swap(RidBitmap &other) {
+  pages_.swap(other.pages_);
+}
+
+void RidBitmap::clear() {
+  pages_.clear();
+}
+
+int RidBitmap::size() const {
+  int count = 0;
+  for (const auto &page : pages_) {
+    for (uint64_t word : page.second) {
+      count += __builtin_popcountll(word);
+    }
+  }
+  return count;
+}
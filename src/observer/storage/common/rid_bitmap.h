@@ -0,0 +1,93 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_COMMON_RID_BITMAP_H_
+#define __OBSERVER_STORAGE_COMMON_RID_BITMAP_H_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "rc.h"
+#include "storage/common/record_manager.h"
+
+/**
+ * 按页面组织的RID集合，用于bitmap heap scan。
+ * 只保存出现过的页面，每个页面上是slot的位图，位图末尾全0的部分不保存。
+ * 多个索引扫描的结果可以取交集(AND)或者并集(OR)，最后按页面号的顺序访问
+ */
+class RidBitmap {
+public:
+  RidBitmap() = default;
+
+  void add(const RID &rid);
+  bool contains(const RID &rid) const;
+
+  /**
+   * 只保留两个集合中都有的RID
+   */
+  void intersect(const RidBitmap &other);
+
+  /**
+   * 加入other中的所有RID
+   */
+  void unite(const RidBitmap &other);
+
+  void swap(RidBitmap &other);
+  void clear();
+
+  bool empty() const {
+    return pages_.empty();
+  }
+
+  /**
+   * RID的个数
+   */
+  int size() const;
+
+  /**
+   * 涉及到的页面个数
+   */
+  int page_count() const {
+    return pages_.size();
+  }
+
+  /**
+   * 按页面号从小到大访问每个页面，slots是这个页面上的所有slot，从小到大排列。
+   * visitor返回的不是SUCCESS时停止访问并返回这个值
+   */
+  template <class Visitor>
+  RC visit(Visitor visitor) const {
+    std::vector<SlotNum> slots;
+    for (const auto &page : pages_) {
+      slots.clear();
+      const std::vector<uint64_t> &words = page.second;
+      for (size_t i = 0; i < words.size(); i++) {
+        for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+          slots.push_back(i * 64 + __builtin_ctzll(word));
+        }
+      }
+      RC rc = visitor(page.first, slots);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+    }
+    return RC::SUCCESS;
+  }
+
+private:
+  std::map<PageNum, std::vector<uint64_t>> pages_;
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_RID_BITMAP_H_
@@ -12,9 +12,11 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2021/5/13.
 //
 
+#include <errno.h>
 #include <limits.h>
 #include <string.h>
 #include <algorithm>
+#include <utility>
 
 #include "storage/common/table.h"
 #include "storage/common/table_meta.h"
@@ -26,7 +28,13 @@ See the Mulan PSL v2 for more details. */
 #include "storage/common/meta_util.h"
 #include "storage/common/index.h"
 #include "storage/common/bplus_tree_index.h"
+#include "storage/common/hash_index.h"
+#include "storage/common/lsm_index.h"
+#include "storage/common/key_sorter.h"
+#include "storage/common/rid_bitmap.h"
 #include "storage/trx/trx.h"
+#include "storage/trx/mvcc_manager.h"
+#include "storage/clog/clog.h"
 
 Table::Table() : 
     data_buffer_pool_(nullptr),
@@ -35,6 +43,9 @@ Table::Table() :
 }
 
 Table::~Table() {
+  // 后台清理线程不能再访问这个表
+  theGlobalMvccManager()->remove_table(this);
+
   delete record_handler_;
   record_handler_ = nullptr;
 
@@ -47,7 +58,8 @@ Table::~Table() {
   LOG_INFO("Table has been closed: %s", name());
 }
 
-RC Table::create(const char *path, const char *name, const char *base_dir, int attribute_count, const AttrInfo attributes[]) {
+RC Table::create(const char *path, const char *name, const char *base_dir, int attribute_count, const AttrInfo attributes[],
+                 Durability durability) {
 
   if (nullptr == name || common::is_blank(name)) {
     LOG_WARN("Name cannot be empty");
@@ -86,6 +98,7 @@ RC Table::create(const char *path, const char *name, const char *base_dir, int a
     LOG_ERROR("Failed to init table meta. name:%s, ret:%d", name, rc);
     return rc; // delete table file
   }
+  table_meta_.set_durability(durability);
 
   std::fstream fs;
   fs.open(path, std::ios_base::out | std::ios_base::binary);
@@ -101,6 +114,7 @@ RC Table::create(const char *path, const char *name, const char *base_dir, int a
   // 创建表中的数据的文件
   std::string data_file = std::string(base_dir) + "/" + name + TABLE_DATA_SUFFIX;
   data_buffer_pool_ = theGlobalDiskBufferPool();
+  data_buffer_pool_->set_file_logged(data_file.c_str(), table_meta_.durability() != DURABILITY_NOLOG);
   rc = data_buffer_pool_->create_file(data_file.c_str());
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to create disk buffer pool of data file. file name=%s", data_file.c_str());
@@ -129,26 +143,67 @@ RC Table::open(const char *meta_file, const char *base_dir) {
   }
   fs.close();
 
+  // 不记日志的表在崩溃之后数据文件和索引文件的内容都不完整，清空成刚创建时的样子
+  RC rc = RC::SUCCESS;
+  const bool crashed = theGlobalCLogManager()->crashed();
+  const bool reset = table_meta_.durability() == DURABILITY_NOLOG && crashed;
+  if (reset) {
+    LOG_WARN("Unlogged table %s is truncated after crash.", table_meta_.name());
+    std::string data_file = std::string(base_dir) + "/" + table_meta_.name() + TABLE_DATA_SUFFIX;
+    rc = theGlobalDiskBufferPool()->redo_create_file(data_file.c_str());
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to truncate data file of unlogged table. file=%s, rc=%d:%s", data_file.c_str(), rc, strrc(rc));
+      return rc;
+    }
+  }
+
   // 加载数据文件
-  RC rc = init_record_handler(base_dir);
+  rc = init_record_handler(base_dir);
 
   base_dir_ = base_dir;
 
   const int index_num = table_meta_.index_num();
   for (int i = 0; i < index_num; i++) {
     const IndexMeta *index_meta = table_meta_.index(i);
-    const FieldMeta *field_meta = table_meta_.field(index_meta->field());
-    if (field_meta == nullptr) {
-      LOG_PANIC("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
-                name(), index_meta->name(), index_meta->field());
-      return RC::GENERIC_ERROR;
+    std::vector<FieldMeta> field_metas;
+    for (int j = 0; j < index_meta->field_num(); j++) {
+      const FieldMeta *field_meta = table_meta_.field(index_meta->field(j));
+      if (field_meta == nullptr) {
+        LOG_PANIC("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
+                  name(), index_meta->name(), index_meta->field(j));
+        return RC::GENERIC_ERROR;
+      }
+      field_metas.push_back(*field_meta);
+    }
+    std::vector<FieldMeta> include_metas;
+    for (int j = 0; j < index_meta->include_field_num(); j++) {
+      const FieldMeta *field_meta = table_meta_.field(index_meta->include_field(j));
+      if (field_meta == nullptr) {
+        LOG_PANIC("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
+                  name(), index_meta->name(), index_meta->include_field(j));
+        return RC::GENERIC_ERROR;
+      }
+      include_metas.push_back(*field_meta);
     }
 
-    BplusTreeIndex *index = new BplusTreeIndex();
+    // 哈希索引的页面和LSM索引的memtable都不记redo日志，崩溃之后和重放出的数据对不上，删掉之后从数据重新构建
+    const bool rebuild = !reset && crashed && index_meta->type() != INDEX_BPLUS_TREE;
+    Index *index = nullptr;
     std::string index_file = index_data_file(base_dir, name(), index_meta->name());
-    rc = index->open(index_file.c_str(), *index_meta, *field_meta);
+    if (reset || rebuild) {
+      rc = remove_index_files(index_file.c_str(), *index_meta, field_metas, include_metas);
+    }
+    if (rc == RC::SUCCESS) {
+      rc = open_index(index_file.c_str(), *index_meta, field_metas, include_metas, reset || rebuild, index);
+    }
+    if (rc == RC::SUCCESS && rebuild) {
+      LOG_WARN("Rebuild index %s of table %s after crash.", index_meta->name(), name());
+      rc = build_index(nullptr, index, index_file.c_str());
+      if (rc != RC::SUCCESS) {
+        delete index;
+      }
+    }
     if (rc != RC::SUCCESS) {
-      delete index;
       LOG_ERROR("Failed to open index. table=%s, index=%s, file=%s, rc=%d:%s",
                 name(), index_meta->name(), index_file.c_str(), rc, strrc(rc));
       return rc;
@@ -165,10 +220,16 @@ RC Table::drop(const char *table_name, const char *meta_file, const char *base_d
     // 从文件系统中删除表的索引、数据( table_name-index_name.index, xxx.data)
     for (auto &it: indexes_) {
         std::string index_file = index_data_file(base_dir, table_name, it->index_meta().name());
+        if (it->index_meta().type() == INDEX_LSM) {
+            // 有序文件由索引自己删除
+            static_cast<LsmIndex *>(it)->destroy();
+        }
         if (remove(index_file.c_str()) != 0) {
             LOG_PANIC("The index file %s doesn't exist.", index_file.c_str());
             return RC::GENERIC_ERROR;
         }
+        // Bloom过滤器文件可能还没有写出来过
+        remove(BplusTreeHandler::bloom_filter_file(index_file.c_str()).c_str());
     }
 
     std::string data_file = std::string(base_dir) + "/" + table_name + TABLE_DATA_SUFFIX;
@@ -186,14 +247,90 @@ RC Table::drop(const char *table_name, const char *meta_file, const char *base_d
     return RC::SUCCESS;
 }
 
-RC Table::commit_insert(Trx *trx, const RID &rid) {
-  Record record;
-  RC rc = record_handler_->get_record(&rid, &record);
-  if (rc != RC::SUCCESS) {
-    return rc;
-  }
+RC Table::commit_records(Trx *trx, const std::vector<RID> &rids, int32_t commit_ts) {
+  // 事务号的修改在页面上原地进行，通过record handler记日志
+  const int32_t uncommitted = Trx::uncommitted_value(trx->trx_id());
+  return record_handler_->update_records_in_place(rids, [this, uncommitted, commit_ts](Record &record) {
+    int32_t begin;
+    int32_t end;
+    Trx::get_record_trx_info(this, record, begin, end);
+    // 只写自己的标记所在的字段。提交时间戳已经可见，其它事务可能正在给自己插入的版本设置删除标记
+    if (begin == uncommitted) {
+      *(int32_t *)(record.data + table_meta_.trx_field()->offset()) = commit_ts;
+    }
+    if (end == uncommitted) {
+      *(int32_t *)(record.data + table_meta_.trx_end_field()->offset()) = commit_ts;
+    }
+    return RC::SUCCESS;
+  });
+}
+
+RC Table::rollback_inserts(Trx *trx, const std::vector<RID> &rids) {
+  // 分批处理，先拷贝一批记录，删除索引项之后再删除记录，和remove_record的顺序一致，
+  // 并发的索引扫描读到的索引项不会指向已经删除的记录。一个页面上的记录在同一批中
+  static const size_t BATCH_SIZE = 4096;
+  const int record_size = table_meta_.record_size();
+  RC first_rc = RC::SUCCESS;
+  std::vector<RID> batch;
+  std::vector<RID> deleted_rids;
+  std::vector<char> records;
+  std::vector<char> keys;
+  std::vector<size_t> order;
+  for (size_t begin = 0; begin < rids.size(); ) {
+    size_t end = std::min(begin + BATCH_SIZE, rids.size());
+    while (end < rids.size() && rids[end].page_num == rids[end - 1].page_num) {
+      end++;
+    }
+    batch.assign(rids.begin() + begin, rids.begin() + end);
+    begin = end;
+
+    records.resize(batch.size() * record_size);
+    deleted_rids.clear();
+    RC rc = record_handler_->visit_records(batch, [&](const Record &record) {
+      memcpy(records.data() + deleted_rids.size() * record_size, record.data, record_size);
+      deleted_rids.push_back(record.rid);
+    });
+    const size_t record_num = deleted_rids.size();
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to read records while rollback insert. table=%s, rc=%d:%s", name(), rc, strrc(rc));
+      first_rc = first_rc == RC::SUCCESS ? rc : first_rc;
+    }
+
+    // 每个索引按(key, RID)的顺序删除，相邻的索引项在同一个索引页面上
+    for (Index *index : indexes_) {
+      const int entry_length = index->key_length() + sizeof(RID);
+      keys.resize(record_num * entry_length);
+      order.resize(record_num);
+      for (size_t i = 0; i < record_num; i++) {
+        char *entry = keys.data() + i * entry_length;
+        const char *key = index->make_key(records.data() + i * record_size, entry);
+        if (key != entry) {
+          memcpy(entry, key, index->key_length());
+        }
+        memcpy(entry + index->key_length(), &deleted_rids[i], sizeof(RID));
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [&](size_t i1, size_t i2) {
+        return CmpKey(index->key_type(), index->key_length(), keys.data() + i1 * entry_length,
+                      keys.data() + i2 * entry_length) < 0;
+      });
+      for (size_t i : order) {
+        rc = index->delete_entry(records.data() + i * record_size, &deleted_rids[i]);
+        if (rc != RC::SUCCESS) {
+          LOG_ERROR("Failed to delete index entry of record(rid=%d.%d) while rollback insert. index=%s, rc=%d:%s",
+                    deleted_rids[i].page_num, deleted_rids[i].slot_num, index->index_meta().name(), rc, strrc(rc));
+          first_rc = first_rc == RC::SUCCESS ? rc : first_rc;
+        }
+      }
+    }
 
-  return trx->commit_insert(this, record);
+    rc = record_handler_->delete_records(deleted_rids, [](const Record &record) {});
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to delete records while rollback insert. table=%s, rc=%d:%s", name(), rc, strrc(rc));
+      first_rc = first_rc == RC::SUCCESS ? rc : first_rc;
+    }
+  }
+  return first_rc;
 }
 
 RC Table::rollback_insert(Trx *trx, const RID &rid) {
@@ -210,6 +347,7 @@ RC Table::rollback_insert(Trx *trx, const RID &rid) {
     LOG_ERROR("Failed to delete indexes of record(rid=%d.%d) while rollback insert, rc=%d:%s",
               rid.page_num, rid.slot_num, rc, strrc(rc));
   } else {
+    // 插入时已经设置了pending标记，删除之后保留，参考remove_record
     rc = record_handler_->delete_record(&rid);
   }
   return rc;
@@ -220,6 +358,8 @@ RC Table::insert_record(Trx *trx, Record *record) {
 
   if (trx != nullptr) {
     trx->init_trx_info(this, *record);
+  } else {
+    Trx::set_record_trx_info(this, *record, 0, 0);
   }
   rc = record_handler_->insert_record(record->data, table_meta_.record_size(), &record->rid);
   if (rc != RC::SUCCESS) {
@@ -228,6 +368,7 @@ RC Table::insert_record(Trx *trx, Record *record) {
   }
 
   if (trx != nullptr) {
+    set_record_pending(record->rid, true);
     rc = trx->insert_record(this, record);
     if (rc != RC::SUCCESS) {
       LOG_ERROR("Failed to log operation(insertion) to trx");
@@ -329,9 +470,10 @@ RC Table::make_record(int value_num, const Value *values, char * &record_out) {
     }
   }
 
-  // 复制所有字段的值
+  // 复制所有字段的值，系统字段由insert_record设置
   int record_size = table_meta_.record_size();
   char *record = new char [record_size];
+  memset(record, 0, record_size);
 
   for (int i = 0; i < value_num; i++) {
     const FieldMeta *field = table_meta_.field(i + normal_field_start_index);
@@ -348,6 +490,7 @@ RC Table::init_record_handler(const char *base_dir) {
   if (nullptr == data_buffer_pool_) {
     data_buffer_pool_ = theGlobalDiskBufferPool();
   }
+  data_buffer_pool_->set_file_logged(data_file.c_str(), table_meta_.durability() != DURABILITY_NOLOG);
 
   int data_buffer_pool_file_id;
   RC rc = data_buffer_pool_->open_file(data_file.c_str(), &data_buffer_pool_file_id);
@@ -395,7 +538,54 @@ RC Table::scan_record(Trx *trx, ConditionFilter *filter, int limit, void *contex
   return scan_record(trx, filter, limit, (void *)&adapter, scan_record_reader_adapter);
 }
 
+RC Table::scan_record(Trx *trx, ConditionFilter *filter, const std::vector<const FieldMeta *> &fields, int limit,
+                      void *context, void (*record_reader)(const char *data, void *context)) {
+  RecordReaderScanAdapter adapter(record_reader, context);
+  return scan_record(trx, filter, &fields, limit, (void *)&adapter, scan_record_reader_adapter);
+}
+
 RC Table:: scan_record(Trx *trx, ConditionFilter *filter, int limit, void *context, RC (*record_reader)(Record *record, void *context)) {
+  return scan_record(trx, filter, nullptr, limit, context, record_reader);
+}
+
+TableScanOptions &TableScanOptions::instance() {
+  static TableScanOptions options;
+  return options;
+}
+
+/**
+ * 按顺序返回已经从索引中读出来的RID
+ */
+class RidListScanner : public IndexScanner {
+public:
+  explicit RidListScanner(std::vector<RID> &&rids) : rids_(std::move(rids)) {
+  }
+
+  RC next_entry(RID *rid) override {
+    if (next_ >= rids_.size()) {
+      return RC::RECORD_EOF;
+    }
+    *rid = rids_[next_++];
+    return RC::SUCCESS;
+  }
+
+  // 只用于回表，没有保存索引的key
+  RC next_entry(RID *rid, char *key) override {
+    return RC::GENERIC_ERROR;
+  }
+
+  RC destroy() override {
+    delete this;
+    return RC::SUCCESS;
+  }
+
+private:
+  std::vector<RID> rids_;
+  size_t next_ = 0;
+};
+
+RC Table::scan_record(Trx *trx, ConditionFilter *filter, const std::vector<const FieldMeta *> *fields, int limit,
+                      void *context, RC (*record_reader)(Record *record, void *context)) {
   if (nullptr == record_reader) {
     return RC::INVALID_ARGUMENT;
   }
@@ -407,13 +597,56 @@ RC Table:: scan_record(Trx *trx, ConditionFilter *filter, int limit, void *conte
   if (limit < 0) {
     limit = INT_MAX;
   }
+  if (trx != nullptr) {
+    trx->open_snapshot();
+  }
 
-  IndexScanner *index_scanner = find_index_for_scan(filter);
-  if (index_scanner != nullptr) {
-    return scan_record_by_index(trx, index_scanner, filter, limit, context, record_reader);
+  // 有limit时按索引的顺序逐条回表，可以提前结束；否则可以用多个索引的结果取交集后按页面顺序回表
+  const Index *covering_index = nullptr;
+  std::vector<IndexScanner *> index_scanners;
+  RC rc = find_indexes_for_scan(filter, fields, limit == INT_MAX ? MAX_BITMAP_SCAN_INDEXES : 1,
+                                index_scanners, &covering_index);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to create index scanner. table=%s, rc=%d:%s", name(), rc, strrc(rc));
+    return rc;
+  }
+  if (!index_scanners.empty()) {
+    if (covering_index != nullptr || limit != INT_MAX) {
+      // 覆盖索引不需要回表，只用第一个索引
+      for (size_t i = 1; i < index_scanners.size(); i++) {
+        index_scanners[i]->destroy();
+      }
+      return scan_record_by_index(trx, index_scanners[0], covering_index, filter, limit, context, record_reader);
+    }
+
+    // 用第一个索引命中的条数估计选择率：命中的少时按索引的顺序逐条回表，中等时用bitmap heap scan，
+    // 多到回表要读的页面接近全表时直接全表扫描。估计时最多多读bitmap_scan_selectivity比例的索引项
+    const TableScanOptions &options = TableScanOptions::instance();
+    const int record_num = estimate_record_num();
+    const int index_max = (int)(record_num * options.index_scan_selectivity);
+    const int bitmap_max = std::max(index_max, (int)(record_num * options.bitmap_scan_selectivity));
+    std::vector<RID> rids;
+    bool complete = false;
+    rc = read_index_entries(index_scanners[0], bitmap_max, rids, &complete);
+    index_scanners[0]->destroy();
+    index_scanners.erase(index_scanners.begin());
+    if (rc == RC::SUCCESS && complete && (int)rids.size() > index_max) {
+      return scan_record_by_bitmap(trx, rids, index_scanners, bitmap_max, filter, context, record_reader);
+    }
+    for (IndexScanner *scanner : index_scanners) {
+      scanner->destroy();
+    }
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    if (complete) {
+      return scan_record_by_index(trx, new RidListScanner(std::move(rids)), nullptr, filter, limit, context,
+                                  record_reader);
+    }
+    LOG_TRACE("Too many records match the index, scan the whole table. table=%s, estimated records=%d",
+              name(), record_num);
   }
 
-  RC rc = RC::SUCCESS;
   RecordFileScanner scanner;
   rc = scanner.open_scan(*data_buffer_pool_, file_id_, filter);     // 进入填充，初始化RecordFileScanner scanner
   if (rc != RC::SUCCESS) {
@@ -444,14 +677,38 @@ RC Table:: scan_record(Trx *trx, ConditionFilter *filter, int limit, void *conte
   return rc;
 }
 
-RC Table::scan_record_by_index(Trx *trx, IndexScanner *scanner, ConditionFilter *filter, int limit, void *context,
-                               RC (*record_reader)(Record *, void *)) {
+/**
+ * 索引项是扫描时读到的叶子节点的副本，对应的记录可能已经被后台清理，记录所在的页面也可能已经释放
+ */
+static bool is_record_removed(RC rc) {
+  return rc == RC::RECORD_RECORD_NOT_EXIST || rc == RC::BUFFERPOOL_INVALID_PAGE_NUM;
+}
+
+RC Table::scan_record_by_index(Trx *trx, IndexScanner *scanner, const Index *covering_index, ConditionFilter *filter,
+                               int limit, void *context, RC (*record_reader)(Record *, void *)) {
   RC rc = RC::SUCCESS;
+  if (covering_index != nullptr) {
+    rc = init_visibility_map();
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("Failed to init visibility map, fall back to fetching records. table=%s, rc=%d:%s",
+               name(), rc, strrc(rc));
+      covering_index = nullptr;
+      rc = RC::SUCCESS;
+    }
+  }
+
+  // 覆盖索引扫描时，用索引中的字段值拼出来的记录，其它字段(包括事务字段)都是0
+  std::vector<char> key(covering_index != nullptr ? covering_index->key_length() : 0);
+  std::vector<char> data(covering_index != nullptr ? table_meta_.record_size() : 0);
   RID rid;
   Record record;
   int record_count = 0;
   while (record_count < limit) {
-    rc = scanner->next_entry(&rid);
+    if (covering_index != nullptr) {
+      rc = scanner->next_entry(&rid, key.data());
+    } else {
+      rc = scanner->next_entry(&rid);
+    }
     if (rc != RC::SUCCESS) {
       if (RC::RECORD_EOF == rc) {
         rc = RC::SUCCESS;
@@ -461,10 +718,21 @@ RC Table::scan_record_by_index(Trx *trx, IndexScanner *scanner, ConditionFilter
       break;
     }
 
-    rc = record_handler_->get_record(&rid, &record);
-    if (rc != RC::SUCCESS) {
-      LOG_ERROR("Failed to fetch record of rid=%d:%d, rc=%d:%s", rid.page_num, rid.slot_num, rc, strrc(rc));
-      break;
+    if (covering_index != nullptr && is_record_all_visible(rid)) {
+      covering_index->restore_record(key.data(), data.data());
+      record.rid = rid;
+      record.data = data.data();
+    } else {
+      // 记录上可能有未提交的修改，需要回表读取事务字段判断可见性
+      rc = record_handler_->get_record(&rid, &record);
+      if (is_record_removed(rc)) {
+        rc = RC::SUCCESS;
+        continue;
+      }
+      if (rc != RC::SUCCESS) {
+        LOG_ERROR("Failed to fetch record of rid=%d:%d, rc=%d:%s", rid.page_num, rid.slot_num, rc, strrc(rc));
+        break;
+      }
     }
 
     if ((trx == nullptr || trx->is_visible(this, &record)) && (filter == nullptr || filter->filter(record))) {
@@ -482,57 +750,446 @@ RC Table::scan_record_by_index(Trx *trx, IndexScanner *scanner, ConditionFilter
   return rc;
 }
 
-class IndexInserter {
+Index *Table::find_index_for_join(const char *field_name) const {
+  Index *found = nullptr;
+  for (Index *index : indexes_) {
+    const std::vector<FieldMeta> &field_metas = index->field_metas();
+    if (0 != strcmp(field_metas[0].name(), field_name)) {
+      continue;
+    }
+    if (index->index_meta().type() == INDEX_HASH && field_metas.size() != 1) {
+      continue;
+    }
+    if (found == nullptr || field_metas.size() < found->field_metas().size()) {
+      found = index;
+    }
+  }
+  return found;
+}
+
+static RC probe_rid_collector(int probe, const RID &rid, void *context) {
+  std::vector<std::pair<RID, int>> &rids = *(std::vector<std::pair<RID, int>> *)context;
+  rids.emplace_back(rid, probe);
+  return RC::SUCCESS;
+}
+
+RC Table::probe_record(Trx *trx, Index *index, const std::vector<const char *> &values, ConditionFilter *filter,
+                       void *context, void (*record_reader)(int probe, const char *data, void *context)) {
+  if (trx != nullptr) {
+    trx->open_snapshot();
+  }
+  std::vector<std::pair<RID, int>> rids;
+  RC rc = index->probe(values, &rids, probe_rid_collector);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to probe index. table=%s, index=%s, rc=%d:%s", name(), index->index_meta().name(), rc, strrc(rc));
+    return rc;
+  }
+
+  // 按RID的顺序回表，同一个页面上的记录连续读取
+  std::sort(rids.begin(), rids.end(), [](const std::pair<RID, int> &a, const std::pair<RID, int> &b) {
+    if (a.first.page_num != b.first.page_num) {
+      return a.first.page_num < b.first.page_num;
+    }
+    return a.first.slot_num < b.first.slot_num;
+  });
+  Record record;
+  for (const std::pair<RID, int> &item : rids) {
+    rc = record_handler_->get_record(&item.first, &record);
+    if (is_record_removed(rc)) {
+      continue;
+    }
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to fetch record of rid=%d:%d, rc=%d:%s",
+                item.first.page_num, item.first.slot_num, rc, strrc(rc));
+      return rc;
+    }
+    if ((trx == nullptr || trx->is_visible(this, &record)) && (filter == nullptr || filter->filter(record))) {
+      record_reader(item.second, record.data, context);
+    }
+  }
+  return RC::SUCCESS;
+}
+
+static RC record_counter(Record *record, void *context) {
+  (*(int *)context)++;
+  return RC::SUCCESS;
+}
+
+RC Table::count_by_index(Trx *trx, ConditionFilter *filter, int *count, bool *done) {
+  *count = 0;
+  *done = false;
+  if (trx != nullptr) {
+    trx->open_snapshot();
+  }
+  const Index *covering_index = nullptr;
+  std::vector<IndexScanner *> scanners;
+  const std::vector<const FieldMeta *> fields;   // 不读取任何字段
+  if (filter != nullptr) {
+    RC rc = find_indexes_for_scan(filter, &fields, 1, scanners, &covering_index);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to create index scanner. table=%s, rc=%d:%s", name(), rc, strrc(rc));
+      return rc;
+    }
+  } else {
+    // 没有条件时数key最短的有序索引中的索引项，读取的页面最少
+    std::vector<Index *> indexes(indexes_);
+    std::stable_sort(indexes.begin(), indexes.end(), [](const Index *a, const Index *b) {
+      return a->key_length() < b->key_length();
+    });
+    for (Index *index : indexes) {
+      IndexScanner *scanner = index->create_ordered_scanner(false);
+      if (scanner != nullptr) {
+        scanners.push_back(scanner);
+        covering_index = index;
+        break;
+      }
+    }
+  }
+  if (scanners.empty()) {
+    return RC::SUCCESS;
+  }
+
+  *done = true;
+  return scan_record_by_index(trx, scanners[0], covering_index, filter, INT_MAX, count, record_counter);
+}
+
+RC Table::min_max_by_index(Trx *trx, const FieldMeta *field, bool max, char *value, bool *found, bool *done) {
+  *found = false;
+  *done = false;
+  if (trx != nullptr) {
+    trx->open_snapshot();
+  }
+  Index *chosen = nullptr;
+  IndexScanner *scanner = nullptr;
+  for (Index *index : indexes_) {
+    if (0 != strcmp(index->field_metas()[0].name(), field->name())) {
+      continue;
+    }
+    if (chosen != nullptr && index->key_length() >= chosen->key_length()) {
+      continue;
+    }
+    IndexScanner *ordered_scanner = index->create_ordered_scanner(max);
+    if (ordered_scanner != nullptr) {
+      if (scanner != nullptr) {
+        scanner->destroy();
+      }
+      scanner = ordered_scanner;
+      chosen = index;
+    }
+  }
+  if (scanner == nullptr) {
+    return RC::SUCCESS;
+  }
+  *done = true;
+
+  const bool use_visibility_map = init_visibility_map() == RC::SUCCESS;
+  std::vector<char> key(chosen->key_length());
+  std::vector<char> data(table_meta_.record_size());
+  RID rid;
+  Record record;
+  RC rc;
+  while ((rc = scanner->next_entry(&rid, key.data())) == RC::SUCCESS) {
+    if (use_visibility_map && is_record_all_visible(rid)) {
+      chosen->restore_record(key.data(), data.data());
+      memcpy(value, data.data() + field->offset(), field->len());
+      *found = true;
+      break;
+    }
+    // 索引项对应的记录可能是未提交的插入或者删除，回表判断可见性
+    rc = record_handler_->get_record(&rid, &record);
+    if (is_record_removed(rc)) {
+      continue;
+    }
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to fetch record of rid=%d:%d, rc=%d:%s", rid.page_num, rid.slot_num, rc, strrc(rc));
+      break;
+    }
+    if (trx == nullptr || trx->is_visible(this, &record)) {
+      memcpy(value, record.data + field->offset(), field->len());
+      *found = true;
+      break;
+    }
+  }
+  scanner->destroy();
+  if (rc == RC::RECORD_EOF) {
+    rc = RC::SUCCESS;
+  }
+  return rc;
+}
+
+int Table::estimate_record_num() const {
+  int page_count = 0;
+  if (data_buffer_pool_->get_page_count(file_id_, &page_count) != RC::SUCCESS) {
+    return 0;
+  }
+  // 第一个页面是文件头
+  return (page_count > 1 ? page_count - 1 : 0) * (BP_PAGE_DATA_SIZE / table_meta_.record_size());
+}
+
+RC Table::read_index_entries(IndexScanner *scanner, int max_entries, std::vector<RID> &rids, bool *complete) {
+  *complete = false;
+  RID rid;
+  RC rc;
+  while ((rc = scanner->next_entry(&rid)) == RC::SUCCESS) {
+    if ((int)rids.size() >= max_entries) {
+      return RC::SUCCESS;
+    }
+    rids.push_back(rid);
+  }
+  if (rc != RC::RECORD_EOF) {
+    LOG_ERROR("Failed to scan table by index. rc=%d:%s", rc, strrc(rc));
+    return rc;
+  }
+  *complete = true;
+  return RC::SUCCESS;
+}
+
+RC Table::scan_record_by_bitmap(Trx *trx, const std::vector<RID> &rids, std::vector<IndexScanner *> &scanners,
+                                int max_entries, ConditionFilter *filter,
+                                void *context, RC (*record_reader)(Record *, void *)) {
+  // 先把每个索引扫描到的RID放到位图里，多个索引的结果取交集
+  RC rc = RC::SUCCESS;
+  RidBitmap bitmap;
+  for (const RID &rid : rids) {
+    bitmap.add(rid);
+  }
+  std::vector<RID> current_rids;
+  for (size_t i = 0; i < scanners.size() && rc == RC::SUCCESS && !bitmap.empty(); i++) {
+    bool complete = false;
+    current_rids.clear();
+    rc = read_index_entries(scanners[i], max_entries, current_rids, &complete);
+    if (rc != RC::SUCCESS || !complete) {
+      // 这个索引上的条件不够有选择性，交给filter
+      continue;
+    }
+    RidBitmap current;
+    for (const RID &rid : current_rids) {
+      current.add(rid);
+    }
+    bitmap.intersect(current);
+  }
+  for (IndexScanner *scanner : scanners) {
+    scanner->destroy();
+  }
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  // 按页面的物理顺序回表，每个页面只读取一次
+  return bitmap.visit([&](PageNum page_num, const std::vector<SlotNum> &slots) {
+    RecordPageHandler page_handler;
+    RC rc = page_handler.init(*data_buffer_pool_, file_id_, page_num);
+    if (is_record_removed(rc)) {
+      return RC::SUCCESS;
+    }
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to init record page handler. table=%s, page num=%d, rc=%d:%s",
+                name(), page_num, rc, strrc(rc));
+      return rc;
+    }
+    Record record;
+    RID rid;
+    rid.page_num = page_num;
+    for (SlotNum slot_num : slots) {
+      rid.slot_num = slot_num;
+      rc = page_handler.get_record(&rid, &record);
+      if (is_record_removed(rc)) {
+        continue;
+      }
+      if (rc != RC::SUCCESS) {
+        LOG_ERROR("Failed to fetch record of rid=%d:%d, rc=%d:%s", rid.page_num, rid.slot_num, rc, strrc(rc));
+        return rc;
+      }
+      if ((trx == nullptr || trx->is_visible(this, &record)) && (filter == nullptr || filter->filter(record))) {
+        rc = record_reader(&record, context);
+        if (rc != RC::SUCCESS) {
+          LOG_TRACE("Record reader break the table scanning. rc=%d:%s", rc, strrc(rc));
+          return rc;
+        }
+      }
+    }
+    return RC::SUCCESS;
+  });
+}
+
+/**
+ * 创建索引时，收集每条记录的索引key和RID，交给KeySorter排序
+ */
+class IndexKeyCollector {
 public:
-  explicit IndexInserter(Index *index) : index_(index) {
+  IndexKeyCollector(const Index &index, KeySorter &sorter)
+      : index_(index), sorter_(sorter), buffer_(index.key_length()) {
   }
 
-  RC insert_index(const Record *record) {
-    return index_->insert_entry(record->data, &record->rid);
+  RC collect(const Record *record) {
+    return sorter_.add(index_.make_key(record->data, buffer_.data()), record->rid);
   }
 private:
-  Index * index_;
+  const Index &index_;
+  KeySorter &sorter_;
+  std::vector<char> buffer_;
 };
 
+static RC collect_index_key_record_reader_adapter(Record *record, void *context) {
+  IndexKeyCollector &collector = *(IndexKeyCollector *)context;
+  return collector.collect(record);
+}
+
 static RC insert_index_record_reader_adapter(Record *record, void *context) {
-  IndexInserter &inserter = *(IndexInserter *)context;
-  return inserter.insert_index(record);
+  Index *index = (Index *)context;
+  return index->insert_entry(record->data, &record->rid);
+}
+
+RC Table::open_index(const char *index_file, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+                     const std::vector<FieldMeta> &include_metas, bool create, Index *&index) {
+  // 索引文件和数据文件一样，不记日志的表上都不记日志
+  theGlobalDiskBufferPool()->set_file_logged(index_file, table_meta_.durability() != DURABILITY_NOLOG);
+
+  RC rc = RC::SUCCESS;
+  if (index_meta.type() == INDEX_HASH) {
+    HashIndex *hash_index = new HashIndex();
+    rc = create ? hash_index->create(index_file, index_meta, field_metas)
+                : hash_index->open(index_file, index_meta, field_metas);
+    index = hash_index;
+  } else if (index_meta.type() == INDEX_LSM) {
+    LsmIndex *lsm_index = new LsmIndex();
+    rc = create ? lsm_index->create(index_file, index_meta, field_metas, include_metas)
+                : lsm_index->open(index_file, index_meta, field_metas, include_metas);
+    index = lsm_index;
+  } else {
+    BplusTreeIndex *bplus_tree_index = new BplusTreeIndex();
+    rc = create ? bplus_tree_index->create(index_file, index_meta, field_metas, include_metas)
+                : bplus_tree_index->open(index_file, index_meta, field_metas, include_metas);
+    index = bplus_tree_index;
+  }
+  if (rc != RC::SUCCESS) {
+    delete index;
+    index = nullptr;
+  }
+  return rc;
+}
+
+RC Table::remove_index_files(const char *index_file, const IndexMeta &index_meta,
+                             const std::vector<FieldMeta> &field_metas, const std::vector<FieldMeta> &include_metas) {
+  if (index_meta.type() == INDEX_LSM) {
+    // 有序文件记录在索引文件中，打开之后由索引自己删除
+    LsmIndex lsm_index;
+    if (lsm_index.open(index_file, index_meta, field_metas, include_metas) == RC::SUCCESS) {
+      lsm_index.destroy();
+    }
+  }
+  if (remove(index_file) != 0 && errno != ENOENT) {
+    LOG_ERROR("Failed to remove index file %s, due to %s.", index_file, strerror(errno));
+    return RC::IOERR;
+  }
+  remove(BplusTreeHandler::bloom_filter_file(index_file).c_str());
+  return RC::SUCCESS;
 }
 
-RC Table::create_index(Trx *trx, const char *index_name, const char *attribute_name) {
-  if (index_name == nullptr || common::is_blank(index_name) ||
-      attribute_name == nullptr || common::is_blank(attribute_name)) {
+RC Table::build_index(Trx *trx, Index *index, const char *index_file) {
+  // 索引中要有所有的版本，包括其它事务未提交的和其它快照还能看到的旧版本，扫描时不判断可见性
+  if (index->index_meta().type() != INDEX_BPLUS_TREE) {
+    // 哈希索引没有顺序，LSM索引写入memtable后自己排序，都直接逐条插入
+    return scan_record(nullptr, nullptr, -1, index, insert_index_record_reader_adapter);
+  }
+
+  // 遍历当前的所有数据，排序后自底向上构建索引
+  BplusTreeIndex *bplus_tree_index = static_cast<BplusTreeIndex *>(index);
+  const IndexBuildOptions &build_options = IndexBuildOptions::instance();
+  KeySorter sorter(index->key_type(), index->key_length(), index_file, build_options);
+  IndexKeyCollector collector(*index, sorter);
+  RC rc = scan_record(nullptr, nullptr, -1, &collector, collect_index_key_record_reader_adapter);
+  if (rc == RC::SUCCESS) {
+    rc = sorter.finish();
+  }
+  if (rc == RC::SUCCESS) {
+    rc = bplus_tree_index->bulk_load(sorter, build_options.fill_factor);
+  }
+  return rc;
+}
+
+RC Table::create_index(Trx *trx, const char *index_name, int attribute_num, const char * const attribute_names[],
+                       int include_num, const char * const include_names[], IndexType index_type,
+                       int index_options) {
+  if (index_name == nullptr || common::is_blank(index_name) || attribute_num <= 0) {
     return RC::INVALID_ARGUMENT;
   }
+  for (int i = 0; i < attribute_num; i++) {
+    if (attribute_names[i] == nullptr || common::is_blank(attribute_names[i])) {
+      return RC::INVALID_ARGUMENT;
+    }
+  }
+  // 同样的字段上可以同时有一个B+树索引和一个哈希索引
+  const IndexMeta *same_fields_index = table_meta_.find_index_by_fields(attribute_names, attribute_num);
   if (table_meta_.index(index_name) != nullptr ||
-      table_meta_.find_index_by_field((attribute_name))) {
+      (same_fields_index != nullptr && same_fields_index->type() == index_type)) {
     return RC::SCHEMA_INDEX_EXIST;
   }
+  if (index_type == INDEX_HASH && include_num > 0) {
+    LOG_WARN("Hash index does not support include fields. table=%s, index=%s", name(), index_name);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (index_type != INDEX_BPLUS_TREE && index_options != 0) {
+    // LSM索引的每个有序文件上本来就有Bloom过滤器
+    LOG_WARN("Only btree index supports bloom filter or adaptive hash. table=%s, index=%s", name(), index_name);
+    return RC::INVALID_ARGUMENT;
+  }
 
-  const FieldMeta *field_meta = table_meta_.field(attribute_name);
-  if (!field_meta) {
-    return RC::SCHEMA_FIELD_MISSING;
+  std::vector<const FieldMeta *> fields;
+  std::vector<FieldMeta> field_metas;
+  for (int i = 0; i < attribute_num; i++) {
+    const FieldMeta *field_meta = table_meta_.field(attribute_names[i]);
+    if (!field_meta) {
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+    for (const FieldMeta *field : fields) {
+      if (field == field_meta) {
+        LOG_WARN("Duplicate field in index. table=%s, index=%s, field=%s", name(), index_name, attribute_names[i]);
+        return RC::INVALID_ARGUMENT;
+      }
+    }
+    if (index_type == INDEX_HASH && field_meta->type() == FLOATS) {
+      LOG_WARN("Hash index does not support float field. table=%s, index=%s, field=%s",
+               name(), index_name, attribute_names[i]);
+      return RC::INVALID_ARGUMENT;
+    }
+    fields.push_back(field_meta);
+    field_metas.push_back(*field_meta);
+  }
+
+  std::vector<const FieldMeta *> include_fields;
+  std::vector<FieldMeta> include_metas;
+  for (int i = 0; i < include_num; i++) {
+    const FieldMeta *field_meta = table_meta_.field(include_names[i]);
+    if (!field_meta) {
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+    bool duplicate = std::find(fields.begin(), fields.end(), field_meta) != fields.end() ||
+        std::find(include_fields.begin(), include_fields.end(), field_meta) != include_fields.end();
+    if (duplicate) {
+      LOG_WARN("Duplicate include field in index. table=%s, index=%s, field=%s", name(), index_name, include_names[i]);
+      return RC::INVALID_ARGUMENT;
+    }
+    include_fields.push_back(field_meta);
+    include_metas.push_back(*field_meta);
   }
 
   IndexMeta new_index_meta;
-  RC rc = new_index_meta.init(index_name, *field_meta);
+  RC rc = new_index_meta.init(index_name, fields, include_fields, index_type, index_options);
   if (rc != RC::SUCCESS) {
     return rc;
   }
 
   // 创建索引相关数据
-  BplusTreeIndex *index = new BplusTreeIndex();
+  Index *index = nullptr;
   std::string index_file = index_data_file(base_dir_.c_str(), name(), index_name);
-  rc = index->create(index_file.c_str(), new_index_meta, *field_meta);
+  rc = open_index(index_file.c_str(), new_index_meta, field_metas, include_metas, true, index);
   if (rc != RC::SUCCESS) {
-    delete index;
-    LOG_ERROR("Failed to create bplus tree index. file name=%s, rc=%d:%s", index_file.c_str(), rc, strrc(rc));
+    LOG_ERROR("Failed to create index. file name=%s, rc=%d:%s", index_file.c_str(), rc, strrc(rc));
     return rc;
   }
 
-  // 遍历当前的所有数据，插入这个索引
-  IndexInserter index_inserter(index);
-  rc = scan_record(trx, nullptr, -1, &index_inserter, insert_index_record_reader_adapter);
+  rc = build_index(trx, index, index_file.c_str());
   if (rc != RC::SUCCESS) {
     // rollback
     delete index;
@@ -577,82 +1234,103 @@ RC Table::create_index(Trx *trx, const char *index_name, const char *attribute_n
   return rc;
 }
 
+/**
+ * 先收集要更新的记录，扫描结束后再逐条更新。
+ * 更新会插入新的版本，边扫描边更新可能会再次扫描到新插入的版本
+ */
 class RecordUpdater {
 public:
-    RecordUpdater(Table &table, Trx *trx, const char* attribute_name, const Value* value) : table_(table), trx_(trx),
-     attribute_name_(attribute_name), value_(value) { }
-
-     // 对`一条`record进行update
-    RC update_record(Record *record) {
-        RC rc = RC::SUCCESS;
-        Record *rec = record;
-        int field_num = table_.table_meta().field_num();
-
-        bool flag = false;
-        const int normal_field_start_index = table_.table_meta().sys_field_num();
-        for (int i = 0; i < field_num - 1; i++) {
-            const FieldMeta *field = table_.table_meta().field(i + normal_field_start_index);
-            if (field != nullptr && ::strcmp(field->name(), attribute_name_) == 0) {
-                if (field->type() == value_->type) {
-                    memcpy(rec->data + field->offset(), value_->data, field->len());
-                    flag = true;
-                }
-                break;
-            }
-        }
+  RecordUpdater(Table &table, const FieldMeta *field, const Value *value)
+      : table_(table), field_(field), value_(value) {
+  }
 
-        if (flag == false) {
-            return RC::GENERIC_ERROR;
-        }
+  RC collect(Record *record) {
+    rids_.push_back(record->rid);
+    datas_.insert(datas_.end(), record->data, record->data + table_.table_meta().record_size());
+    return RC::SUCCESS;
+  }
 
-        rc = table_.update_record(trx_, record);
-        if (rc == RC::SUCCESS) {
-            update_count_++;
-        }
-        return rc;
+  // 对收集到的每条记录进行update
+  RC update_records(Trx *trx) {
+    RC rc = RC::SUCCESS;
+    const int record_size = table_.table_meta().record_size();
+    std::vector<char> new_data(record_size);
+    for (size_t i = 0; i < rids_.size(); i++) {
+      Record old_record;
+      old_record.rid = rids_[i];
+      old_record.data = datas_.data() + i * record_size;
+      memcpy(new_data.data(), old_record.data, record_size);
+      memcpy(new_data.data() + field_->offset(), value_->data, field_->len());
+
+      rc = table_.update_record(trx, &old_record, new_data.data());
+      if (rc != RC::SUCCESS) {
+        break;
+      }
+      update_count_++;
     }
+    return rc;
+  }
 
-    int updated_count() const {
-        return update_count_;
-    }
+  int updated_count() const {
+    return update_count_;
+  }
 
 private:
-    Table & table_;
-    Trx *trx_;
-    const char *attribute_name_;
-    const Value *value_;
-    int update_count_ = 0;
+  Table & table_;
+  const FieldMeta *field_;
+  const Value *value_;
+  std::vector<RID> rids_;
+  std::vector<char> datas_;
+  int update_count_ = 0;
 };
 
-// 填充record updater context更新record
+// 填充record updater context收集要更新的record
 static RC record_reader_update_adapter(Record *record, void *context) {
-    RecordUpdater &record_updater = *(RecordUpdater *)context;
-    return record_updater.update_record(record);
+  RecordUpdater &record_updater = *(RecordUpdater *)context;
+  return record_updater.collect(record);
 }
 
 RC Table::update_record(Trx *trx, const char *attribute_name, const Value *value, CompositeConditionFilter* filter, int *updated_count) {
-    RecordUpdater updater(*this, trx, attribute_name, value);
-    RC rc = scan_record(trx, filter, -1, &updater, record_reader_update_adapter);
-    if (updated_count != nullptr) {
-        *updated_count = updater.updated_count();
-    }
-    return rc;
+  const FieldMeta *field = table_meta_.field(attribute_name);
+  if (field == nullptr || !field->visible()) {
+    LOG_WARN("No such field. table=%s, field=%s", name(), attribute_name);
+    return RC::SCHEMA_FIELD_NOT_EXIST;
+  }
+  if (field->type() != value->type) {
+    LOG_WARN("Invalid value type. table=%s, field=%s, type=%d, but given=%d",
+             name(), attribute_name, field->type(), value->type);
+    return RC::SCHEMA_FIELD_TYPE_MISMATCH;
+  }
+
+  RecordUpdater updater(*this, field, value);
+  RC rc = scan_record(trx, filter, -1, &updater, record_reader_update_adapter);
+  if (rc == RC::SUCCESS) {
+    rc = updater.update_records(trx);
+  }
+  if (updated_count != nullptr) {
+    *updated_count = updater.updated_count();
+  }
+  return rc;
 }
 
-RC Table::update_record(Trx *trx, Record *record) {
-    RC rc = RC::SUCCESS;
-    if (trx != nullptr) {
-        rc = trx->update_record(this, record);
-    } else {
-//        rc = update_entry_of_indexes(record->data, record->rid, false);// 重复代码 refer to commit_delete
-        if (rc != RC::SUCCESS) {
-            LOG_ERROR("Failed to update indexes of record (rid=%d.%d). rc=%d:%s",
-                      record->rid.page_num, record->rid.slot_num, rc, strrc(rc));
-        } else {
-            rc = record_handler_->update_record(record);
-        }
-    }
+RC Table::update_record(Trx *trx, Record *old_record, const char *new_data) {
+  // 删除旧版本，插入新版本。旧版本留在数据文件中，其它事务的快照仍然可以读到，没有快照需要时由后台清理
+  RC rc = delete_record(trx, old_record);
+  if (rc != RC::SUCCESS) {
+    LOG_TRACE("Failed to delete old version of record (rid=%d.%d). rc=%d:%s",
+              old_record->rid.page_num, old_record->rid.slot_num, rc, strrc(rc));
     return rc;
+  }
+
+  std::vector<char> data(new_data, new_data + table_meta_.record_size());
+  Record new_record;
+  new_record.data = data.data();
+  rc = insert_record(trx, &new_record);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to insert new version of record (rid=%d.%d). rc=%d:%s",
+              old_record->rid.page_num, old_record->rid.slot_num, rc, strrc(rc));
+  }
+  return rc;
 }
 
 class RecordDeleter {
@@ -695,51 +1373,172 @@ RC Table::delete_record(Trx *trx, ConditionFilter *filter, int *deleted_count) {
 }
 
 RC Table::delete_record(Trx *trx, Record *record) {
-  RC rc = RC::SUCCESS;
-  if (trx != nullptr) {
-    rc = trx->delete_record(this, record);
-  } else {
-    rc = delete_entry_of_indexes(record->data, record->rid, false);// 重复代码 refer to commit_delete
-    if (rc != RC::SUCCESS) {
-      LOG_ERROR("Failed to delete indexes of record (rid=%d.%d). rc=%d:%s",
-                record->rid.page_num, record->rid.slot_num, rc, strrc(rc));
-    } else {
-      rc = record_handler_->delete_record(&record->rid);
-    }
+  if (trx == nullptr) {
+    return remove_record(*record);
   }
-  return rc;
-}
-
-RC Table::commit_delete(Trx *trx, const RID &rid) {
-  RC rc = RC::SUCCESS;
-  Record record;
-  rc = record_handler_->get_record(&rid, &record);
+  // 记录正在被其它事务修改时等它结束，之后再检查这个版本是否已经被删除
+  RC rc = trx->lock_record(this, record->rid);
   if (rc != RC::SUCCESS) {
+    LOG_TRACE("Failed to lock record. rid=%d.%d, rc=%d:%s", record->rid.page_num, record->rid.slot_num, rc, strrc(rc));
     return rc;
   }
-  rc = delete_entry_of_indexes(record.data, record.rid, false);
+  // 只在记录上设置删除标记，旧版本留给其它事务的快照，不再被需要时由后台清理
+  const RID &rid = record->rid;
+  std::lock_guard<std::mutex> latch(record_latches_[(rid.page_num * 31 + rid.slot_num) % RECORD_LATCH_NUM]);
+  set_record_pending(rid, true);
+  return record_handler_->update_record_in_place(&rid, [this, trx](Record &page_record) {
+    return trx->delete_record(this, &page_record);
+  });
+}
+
+RC Table::remove_record(const Record &record) {
+  // 正在进行的覆盖索引扫描可能还持有这条记录的索引项，不能按索引中的值当成所有事务都可见的记录返回。
+  // 记录删除之后一直保持这个标记，直到有新的插入重用这个位置
+  set_record_pending(record.rid, true);
+  RC rc = delete_entry_of_indexes(record.data, record.rid, false);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to delete indexes of record(rid=%d.%d). rc=%d:%s",
-              rid.page_num, rid.slot_num, rc, strrc(rc));// panic?
+              record.rid.page_num, record.rid.slot_num, rc, strrc(rc));// panic?
   }
 
-  rc = record_handler_->delete_record(&rid);
-  if (rc != RC::SUCCESS) {
-    return rc;
-  }
+  const RID rid = record.rid;
+  return record_handler_->delete_record(&rid);
+}
 
-  return rc;
+RC Table::rollback_deletes(Trx *trx, const std::vector<RID> &rids) {
+  // 可见性标记由后台清理时去掉，这期间可能有快照看不到这次回滚
+  const int32_t uncommitted = Trx::uncommitted_value(trx->trx_id());
+  return record_handler_->update_records_in_place(rids, [this, uncommitted](Record &record) {
+    int32_t begin;
+    int32_t end;
+    Trx::get_record_trx_info(this, record, begin, end);
+    if (end == uncommitted) {
+      Trx::set_record_trx_info(this, record, begin, 0);
+    }
+    return RC::SUCCESS;
+  });
 }
 
-RC Table::rollback_delete(Trx *trx, const RID &rid) {
-  RC rc = RC::SUCCESS;
+RC Table::purge_record(const RID &rid, int32_t oldest_snapshot_ts) {
+  // 和delete_record互斥，否则检查之后被删除的记录会被去掉pending标记，覆盖索引扫描会把它当成可见的记录
+  std::lock_guard<std::mutex> latch(record_latches_[(rid.page_num * 31 + rid.slot_num) % RECORD_LATCH_NUM]);
   Record record;
-  rc = record_handler_->get_record(&rid, &record);
+  RC rc = record_handler_->get_record(&rid, &record);
   if (rc != RC::SUCCESS) {
-    return rc;
+    // 回滚的插入已经删除了记录
+    LOG_TRACE("Record has been removed. table=%s, rid=%d.%d", name(), rid.page_num, rid.slot_num);
+    return RC::SUCCESS;
   }
 
-  return trx->rollback_delete(this, record); // update record in place
+  int32_t begin;
+  int32_t end;
+  Trx::get_record_trx_info(this, record, begin, end);
+  auto visible_to_all = [oldest_snapshot_ts](int32_t value) {
+    return !Trx::is_uncommitted(value) && value <= oldest_snapshot_ts;
+  };
+  if (end != 0 && visible_to_all(end)) {
+    // 所有的快照都能看到这次删除，旧版本不再被需要
+    return remove_record(record);
+  }
+  if (end == 0 && visible_to_all(begin)) {
+    set_record_pending(rid, false);
+  }
+  return RC::SUCCESS;
+}
+
+RC Table::recover_trx(int32_t max_trx_id) {
+  auto is_recovered = [max_trx_id](int32_t value) {
+    return Trx::is_uncommitted(value) && Trx::trx_id_of(value) <= max_trx_id;
+  };
+  // 重启之后没有更早的快照，重启前提交的删除可以直接清理
+  auto is_committed_delete = [max_trx_id](int32_t end) {
+    return end != 0 && !Trx::is_uncommitted(end) && end <= max_trx_id;
+  };
+
+  // 先找出带重启前事务号的记录和已经提交删除的记录，扫描时占用着页面，不能同时删除记录
+  std::vector<RID> rids;
+  {
+    RecordFileScanner scanner;
+    RC rc = scanner.open_scan(*data_buffer_pool_, file_id_, nullptr);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to open scanner. file id=%d. rc=%d:%s", file_id_, rc, strrc(rc));
+      return rc;
+    }
+    Record record;
+    for (rc = scanner.get_first_record(&record); RC::SUCCESS == rc; rc = scanner.get_next_record(&record)) {
+      int32_t begin;
+      int32_t end;
+      Trx::get_record_trx_info(this, record, begin, end);
+      if (is_recovered(begin) || is_recovered(end) || is_committed_delete(end)) {
+        rids.push_back(record.rid);
+      }
+    }
+    scanner.close_scan();
+    if (rc != RC::RECORD_EOF) {
+      LOG_ERROR("Failed to scan records. table=%s, rc=%d:%s", name(), rc, strrc(rc));
+      return rc;
+    }
+  }
+
+  CLogManager *clog_manager = theGlobalCLogManager();
+  int committed_count = 0;
+  int rollback_count = 0;
+  for (const RID &rid : rids) {
+    Record record;
+    RC rc = record_handler_->get_record(&rid, &record);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to get record(rid=%d.%d) to recover trx. rc=%d:%s", rid.page_num, rid.slot_num, rc, strrc(rc));
+      return rc;
+    }
+    int32_t begin;
+    int32_t end;
+    Trx::get_record_trx_info(this, record, begin, end);
+
+    if (is_recovered(begin) && !clog_manager->is_recovered_commit(Trx::trx_id_of(begin))) {
+      // 回滚的插入，删除记录和索引
+      rc = rollback_insert(nullptr, rid);
+      rollback_count++;
+    } else if (is_committed_delete(end) ||
+               (is_recovered(end) && clog_manager->is_recovered_commit(Trx::trx_id_of(end)))) {
+      // 提交的删除
+      rc = remove_record(record);
+      committed_count++;
+    } else {
+      // 提交的插入和回滚的删除，清除事务号。新的事务可能已经修改了这条记录，只处理重启前的事务号
+      if (is_recovered(begin)) {
+        committed_count++;
+      }
+      if (is_recovered(end)) {
+        rollback_count++;
+      }
+      bool all_visible = false;
+      rc = record_handler_->update_record_in_place(&rid, [&](Record &page_record) {
+        int32_t page_begin;
+        int32_t page_end;
+        Trx::get_record_trx_info(this, page_record, page_begin, page_end);
+        if (is_recovered(page_begin)) {
+          page_begin = 0;
+        }
+        if (is_recovered(page_end)) {
+          page_end = 0;
+        }
+        Trx::set_record_trx_info(this, page_record, page_begin, page_end);
+        all_visible = page_begin == 0 && page_end == 0;
+        return RC::SUCCESS;
+      });
+      if (rc == RC::SUCCESS && all_visible) {
+        set_record_pending(rid, false);
+      }
+    }
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to recover record(rid=%d.%d). begin=%x, end=%x, rc=%d:%s",
+                rid.page_num, rid.slot_num, begin, end, rc, strrc(rc));
+      return rc;
+    }
+  }
+  LOG_INFO("Recover trx of table %s. committed records=%d, rollback records=%d",
+           name(), committed_count, rollback_count);
+  return RC::SUCCESS;
 }
 
 RC Table::insert_entry_of_indexes(const char *record, const RID &rid) {
@@ -775,73 +1574,276 @@ Index *Table::find_index(const char *index_name) const {
   return nullptr;
 }
 
-IndexScanner *Table::find_index_for_scan(const DefaultConditionFilter &filter) {
-  const ConDesc *field_cond_desc = nullptr;
-  const ConDesc *value_cond_desc = nullptr;
+/**
+ * 从条件中找出可以用于索引的条件: 一边是字段，一边是值。
+ * 字段在右边时把比较符反过来，统一成 字段 op 值 的形式
+ */
+static bool index_condition(const DefaultConditionFilter &filter, const ConDesc **field_cond, CompOp *comp_op,
+                            const char **value) {
+  CompOp op = filter.comp_op();
   if (filter.left().is_attr && !filter.right().is_attr) {
-    field_cond_desc = &filter.left();
-    value_cond_desc = &filter.right();
+    *field_cond = &filter.left();
+    *value = (const char *)filter.right().value;
   } else if (filter.right().is_attr && !filter.left().is_attr) {
-    field_cond_desc = &filter.right();
-    value_cond_desc = &filter.left();
+    *field_cond = &filter.right();
+    *value = (const char *)filter.left().value;
+    switch (op) {
+      case LESS_THAN: op = GREAT_THAN; break;
+      case LESS_EQUAL: op = GREAT_EQUAL; break;
+      case GREAT_THAN: op = LESS_THAN; break;
+      case GREAT_EQUAL: op = LESS_EQUAL; break;
+      default: break;
+    }
+  } else {
+    return false;
+  }
+
+  if (op != EQUAL_TO && op != LESS_THAN && op != LESS_EQUAL && op != GREAT_THAN && op != GREAT_EQUAL) {
+    return false;
   }
-  if (field_cond_desc == nullptr || value_cond_desc == nullptr) {
-    return nullptr;
+  *comp_op = op;
+  return true;
+}
+
+RC Table::find_indexes_for_scan(const std::vector<const DefaultConditionFilter *> &filters,
+                                const std::vector<const FieldMeta *> *fields, int max_scanner_num,
+                                std::vector<IndexScanner *> &scanners, const Index **covering_index) {
+  struct IndexCondition {
+    const FieldMeta *field;
+    CompOp comp_op;
+    const char *value;
+  };
+  std::vector<IndexCondition> conditions;
+  for (const DefaultConditionFilter *filter : filters) {
+    IndexCondition condition;
+    const ConDesc *field_cond = nullptr;
+    if (!index_condition(*filter, &field_cond, &condition.comp_op, &condition.value)) {
+      continue;
+    }
+    condition.field = table_meta_.find_field_by_offset(field_cond->attr_offset);
+    if (nullptr == condition.field) {
+      LOG_PANIC("Cannot find field by offset %d. table=%s", field_cond->attr_offset, name());
+      return RC::GENERIC_ERROR;
+    }
+    conditions.push_back(condition);
+  }
+  if (conditions.empty()) {
+    return RC::SUCCESS;
   }
 
-  const FieldMeta *field_meta = table_meta_.find_field_by_offset(field_cond_desc->attr_offset);
-  if (nullptr == field_meta) {
-    LOG_PANIC("Cannot find field by offset %d. table=%s",
-              field_cond_desc->attr_offset, name());
-    return nullptr;
+  // 扫描需要读取的所有字段: 输出的字段和过滤条件中的字段
+  std::vector<const FieldMeta *> needed_fields;
+  if (fields != nullptr) {
+    needed_fields = *fields;
+    for (const DefaultConditionFilter *filter : filters) {
+      const ConDesc *con_descs[] = {&filter->left(), &filter->right()};
+      for (const ConDesc *con_desc : con_descs) {
+        if (con_desc->is_attr) {
+          needed_fields.push_back(table_meta_.find_field_by_offset(con_desc->attr_offset));
+        }
+      }
+    }
   }
 
-  const IndexMeta *index_meta = table_meta_.find_index_by_field(field_meta->name());
-  if (nullptr == index_meta) {
-    return nullptr;
+  // 每个索引尽量匹配最长的等值前缀，之后的一个字段上可以再用一个范围条件。
+  // 等值条件的字段越多越好，其次是有没有范围条件
+  struct IndexScanCandidate {
+    Index *index;
+    int score;
+    bool covering;
+    int eq_num;
+    const char *values[MAX_NUM];
+    const IndexCondition *range;
+    std::vector<const FieldMeta *> used_fields;   // 用到的条件字段
+  };
+  std::vector<IndexScanCandidate> candidates;
+  for (Index *index : indexes_) {
+    const std::vector<FieldMeta> &field_metas = index->field_metas();
+    IndexScanCandidate candidate;
+    candidate.index = index;
+    candidate.eq_num = 0;
+    candidate.range = nullptr;
+    for (const FieldMeta &field_meta : field_metas) {
+      const IndexCondition *eq = nullptr;
+      for (const IndexCondition &condition : conditions) {
+        if (0 != strcmp(condition.field->name(), field_meta.name())) {
+          continue;
+        }
+        if (condition.comp_op == EQUAL_TO) {
+          eq = &condition;
+          break;
+        }
+        if (candidate.range == nullptr) {
+          candidate.range = &condition;
+        }
+      }
+      if (eq == nullptr) {
+        break;
+      }
+      candidate.values[candidate.eq_num++] = eq->value;
+      candidate.used_fields.push_back(eq->field);
+      candidate.range = nullptr;
+    }
+    if (candidate.eq_num == (int)field_metas.size()) {
+      candidate.range = nullptr;
+    }
+    if (candidate.range != nullptr) {
+      candidate.used_fields.push_back(candidate.range->field);
+    }
+    const bool is_hash = index->index_meta().type() == INDEX_HASH;
+    if (is_hash && candidate.eq_num != (int)field_metas.size()) {
+      // 哈希索引只能用于所有字段上的等值查找
+      continue;
+    }
+
+    // 条件相同的情况下，优先使用不用回表的覆盖索引，其次是哈希索引
+    int score = candidate.eq_num * 2 + (candidate.range != nullptr ? 1 : 0);
+    candidate.covering = fields != nullptr;
+    for (const FieldMeta *field : needed_fields) {
+      if (nullptr == field || !index->covers(field->name())) {
+        candidate.covering = false;
+        break;
+      }
+    }
+    candidate.score = score > 0 ? (score * 2 + (candidate.covering ? 1 : 0)) * 2 + (is_hash ? 1 : 0) : 0;
+    if (candidate.score > 0) {
+      candidates.push_back(candidate);
+    }
   }
+  if (candidates.empty()) {
+    return RC::SUCCESS;
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const IndexScanCandidate &a, const IndexScanCandidate &b) {
+                     return a.score > b.score;
+                   });
 
-  Index *index = find_index(index_meta->name());
-  if (nullptr == index) {
-    return nullptr;
+  // 除了最好的索引之外，再选用到了新的条件字段的索引，结果取交集
+  std::vector<const IndexScanCandidate *> chosen;
+  std::vector<const FieldMeta *> used_fields;
+  for (const IndexScanCandidate &candidate : candidates) {
+    if ((int)chosen.size() >= max_scanner_num) {
+      break;
+    }
+    bool has_new_field = false;
+    for (const FieldMeta *field : candidate.used_fields) {
+      if (std::find(used_fields.begin(), used_fields.end(), field) == used_fields.end()) {
+        has_new_field = true;
+        used_fields.push_back(field);
+      }
+    }
+    if (has_new_field) {
+      chosen.push_back(&candidate);
+    }
   }
 
-  return index->create_scanner(filter.comp_op(), (const char *)value_cond_desc->value);
+  *covering_index = chosen[0]->covering ? chosen[0]->index : nullptr;
+  for (const IndexScanCandidate *candidate : chosen) {
+    IndexScanner *scanner = candidate->index->create_scanner(candidate->eq_num, candidate->values,
+        candidate->range != nullptr ? candidate->range->comp_op : NO_OP,
+        candidate->range != nullptr ? candidate->range->value : nullptr);
+    if (scanner == nullptr) {
+      for (IndexScanner *created : scanners) {
+        created->destroy();
+      }
+      scanners.clear();
+      *covering_index = nullptr;
+      return RC::GENERIC_ERROR;
+    }
+    scanners.push_back(scanner);
+  }
+  return RC::SUCCESS;
 }
 
-IndexScanner *Table::find_index_for_scan(const ConditionFilter *filter) {
+RC Table::find_indexes_for_scan(const ConditionFilter *filter, const std::vector<const FieldMeta *> *fields,
+                                int max_scanner_num, std::vector<IndexScanner *> &scanners,
+                                const Index **covering_index) {
+  *covering_index = nullptr;
   if (nullptr == filter) {
-    return nullptr;
+    return RC::SUCCESS;
   }
 
+  std::vector<const DefaultConditionFilter *> filters;
   // remove dynamic_cast
   const DefaultConditionFilter *default_condition_filter = dynamic_cast<const DefaultConditionFilter *>(filter);
   if (default_condition_filter != nullptr) {
-    return find_index_for_scan(*default_condition_filter);
+    filters.push_back(default_condition_filter);
   }
 
   const CompositeConditionFilter *composite_condition_filter = dynamic_cast<const CompositeConditionFilter *>(filter);
   if (composite_condition_filter != nullptr) {
     int filter_num = composite_condition_filter->filter_num();
     for (int i = 0; i < filter_num; i++) {
-      IndexScanner *scanner= find_index_for_scan(&composite_condition_filter->filter(i));
-      if (scanner != nullptr) {
-        return scanner; // 可以找到一个最优的，比如比较符号是=
+      default_condition_filter = dynamic_cast<const DefaultConditionFilter *>(&composite_condition_filter->filter(i));
+      if (default_condition_filter != nullptr) {
+        filters.push_back(default_condition_filter);
+      } else {
+        // 不知道其它过滤条件会读取哪些字段，不能使用覆盖索引
+        fields = nullptr;
       }
     }
   }
-  return nullptr;
+  return find_indexes_for_scan(filters, fields, max_scanner_num, scanners, covering_index);
+}
+
+static uint64_t record_key(const RID &rid) {
+  return (((uint64_t)rid.page_num) << 32) | (uint32_t)rid.slot_num;
+}
+
+void Table::set_record_pending(const RID &rid, bool pending) {
+  std::lock_guard<std::mutex> lock_guard(visibility_lock_);
+  if (pending) {
+    pending_records_.insert(record_key(rid));
+  } else {
+    pending_records_.erase(record_key(rid));
+  }
+}
+
+bool Table::is_record_all_visible(const RID &rid) {
+  std::lock_guard<std::mutex> lock_guard(visibility_lock_);
+  return pending_records_.find(record_key(rid)) == pending_records_.end();
+}
+
+RC Table::init_visibility_map() {
+  std::lock_guard<std::mutex> lock_guard(visibility_lock_);
+  if (visibility_map_inited_) {
+    return RC::SUCCESS;
+  }
+
+  // 重启之前留下的带事务号的记录，打开表之后还没有扫描过
+  RecordFileScanner scanner;
+  RC rc = scanner.open_scan(*data_buffer_pool_, file_id_, nullptr);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open scanner. file id=%d. rc=%d:%s", file_id_, rc, strrc(rc));
+    return rc;
+  }
+  Record record;
+  for (rc = scanner.get_first_record(&record); RC::SUCCESS == rc; rc = scanner.get_next_record(&record)) {
+    int32_t begin;
+    int32_t end;
+    Trx::get_record_trx_info(this, record, begin, end);
+    if (Trx::is_uncommitted(begin) || end != 0) {
+      pending_records_.insert(record_key(record.rid));
+    }
+  }
+  scanner.close_scan();
+  if (rc != RC::RECORD_EOF) {
+    LOG_ERROR("Failed to scan records. table=%s, rc=%d:%s", name(), rc, strrc(rc));
+    return rc;
+  }
+  visibility_map_inited_ = true;
+  return RC::SUCCESS;
 }
 
-RC Table::sync() {
-  RC rc = data_buffer_pool_->flush_all_pages(file_id_);
+RC Table::sync(bool flush_pages) {
+  RC rc = flush_pages ? data_buffer_pool_->flush_all_pages(file_id_) : RC::SUCCESS;
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to flush table's data pages. table=%s, rc=%d:%s", name(), rc, strrc(rc));
     return rc;
   }
 
   for (Index *index: indexes_) {
-    rc = index->sync();
+    rc = index->sync(flush_pages);
     if (rc != RC::SUCCESS) {
       LOG_ERROR("Failed to flush index's pages. table=%s, index=%s, rc=%d:%s",
                 name(), index->index_meta().name(), rc, strrc(rc));
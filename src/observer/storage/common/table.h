@@ -15,6 +15,10 @@ See the Mulan PSL v2 for more details. */
 #ifndef __OBSERVER_STORAGE_COMMON_TABLE_H__
 #define __OBSERVER_STORAGE_COMMON_TABLE_H__
 
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 #include "storage/common/table_meta.h"
 
 class DiskBufferPool;
@@ -29,7 +33,21 @@ class RecordDeleter;
 class Trx;
 class CompositeConditionFilter;
 
+/**
+ * 用索引扫描时按命中记录占全表的比例选择回表的方式，由DefaultStorageStage根据配置文件设置
+ */
+struct TableScanOptions {
+  double index_scan_selectivity = 0.01;    // 不超过这个比例时按索引的顺序逐条回表
+  double bitmap_scan_selectivity = 0.1;    // 不超过这个比例时用bitmap heap scan，再多就全表扫描
+
+  static TableScanOptions &instance();
+};
+
 class Table {
+public:
+  // bitmap heap scan最多对几个索引的结果取交集
+  static const int MAX_BITMAP_SCAN_INDEXES = 3;
+
 public:
   Table();
   ~Table();
@@ -41,8 +59,10 @@ public:
    * @param base_dir 表数据存放的路径
    * @param attribute_count 字段个数
    * @param attributes 字段
+   * @param durability 事务提交的默认持久性级别。DURABILITY_NOLOG的表上的修改不记日志，崩溃之后重新打开时被清空
    */
-  RC create(const char *path, const char *name, const char *base_dir, int attribute_count, const AttrInfo attributes[]);
+  RC create(const char *path, const char *name, const char *base_dir, int attribute_count, const AttrInfo attributes[],
+            Durability durability = DURABILITY_DEFAULT);
 
   /**
    * 打开一个表
@@ -61,34 +81,148 @@ public:
   
   RC insert_record(Trx *trx, int value_num, const Value *values);
   RC update_record(Trx *trx, const char *attribute_name, const Value *value, CompositeConditionFilter* condition_filter, int *updated_count);
-  RC update_record(Trx *trx, Record *record);
   RC delete_record(Trx *trx, ConditionFilter *filter, int *deleted_count);
 
   RC scan_record(Trx *trx, ConditionFilter *filter, int limit, void *context, void (*record_reader)(const char *data, void *context));
 
-  RC create_index(Trx *trx, const char *index_name, const char *attribute_name);
+  /**
+   * 同上，fields是record_reader会读取的字段。
+   * 如果有索引保存了这些字段以及过滤条件用到的所有字段，就直接用索引中的值，不再回表读取记录，
+   * 此时传给record_reader的记录中只有这些字段是有效的
+   */
+  RC scan_record(Trx *trx, ConditionFilter *filter, const std::vector<const FieldMeta *> &fields, int limit,
+                 void *context, void (*record_reader)(const char *data, void *context));
+
+  /**
+   * 在一个或多个字段上创建索引，多个字段时创建组合索引。
+   * include_names中的字段只保存在索引的叶子中，用于覆盖索引扫描。
+   * index_options是IndexOption的组合: Bloom过滤器，自适应哈希索引。只适用于B+树索引
+   */
+  RC create_index(Trx *trx, const char *index_name, int attribute_num, const char * const attribute_names[],
+                  int include_num, const char * const include_names[], IndexType index_type = INDEX_BPLUS_TREE,
+                  int index_options = 0);
+
+  /**
+   * 连接字段上可以逐行查找的索引: 第一个字段是field_name的B+树索引，或者只有这一个字段的哈希索引。
+   * 没有时返回nullptr
+   */
+  Index *find_index_for_join(const char *field_name) const;
+
+  /**
+   * 通过索引依次查找第一个字段等于values[i]的记录，用于index nested-loop join的内表。
+   * values需要从小到大排好序。每条可见并且满足filter的记录调用一次record_reader，probe是values中的下标
+   */
+  RC probe_record(Trx *trx, Index *index, const std::vector<const char *> &values, ConditionFilter *filter,
+                  void *context, void (*record_reader)(int probe, const char *data, void *context));
+
+  /**
+   * 用索引计算满足filter的记录数(filter为空表示所有记录)。过滤条件用到的字段都在索引中时只数索引项，
+   * 只有带着未提交事务信息的记录才回表判断可见性。没有能用的索引时done为false，由调用者扫描表
+   */
+  RC count_by_index(Trx *trx, ConditionFilter *filter, int *count, bool *done);
+  /**
+   * 用第一个字段是field的索引求field上的最小值(max为false)或最大值，从索引的一端开始找第一条可见的记录。
+   * 值写入value(field的长度)，没有可见的记录时found为false。没有能用的索引时done为false
+   */
+  RC min_max_by_index(Trx *trx, const FieldMeta *field, bool max, char *value, bool *found, bool *done);
+  /**
+   * 按数据文件的页面数估计的记录数，不需要扫描表
+   */
+  int estimate_record_num() const;
 
 public:
   const char *name() const;
 
   const TableMeta &table_meta() const;
 
-  RC sync();
+  /**
+   * flush_pages为false时不写回页面，只让索引写出页面以外的状态，参考Index::sync
+   */
+  RC sync(bool flush_pages);
 
 public:
-  RC commit_insert(Trx *trx, const RID &rid);
-  RC commit_delete(Trx *trx, const RID &rid);
+  /**
+   * 事务提交时把记录上这个事务的未提交事务号改成提交时间戳。
+   * 下面批量处理的rids都需要按(页面, 槽)排好序，每个页面只固定一次
+   */
+  RC commit_records(Trx *trx, const std::vector<RID> &rids, int32_t commit_ts);
+  /**
+   * 回滚插入: 删除记录，再按key的顺序删除各个索引中的索引项
+   */
+  RC rollback_inserts(Trx *trx, const std::vector<RID> &rids);
   RC rollback_insert(Trx *trx, const RID &rid);
-  RC rollback_delete(Trx *trx, const RID &rid);
+  RC rollback_deletes(Trx *trx, const std::vector<RID> &rids);
+  /**
+   * 后台清理: 删除已经对所有快照(时间戳不小于oldest_snapshot_ts)可见的旧版本，
+   * 或者在记录对所有快照可见之后去掉它的未提交标记
+   */
+  RC purge_record(const RID &rid, int32_t oldest_snapshot_ts);
+
+  /**
+   * 崩溃恢复之后处理重启前的事务留在记录上的事务号：日志中已经提交的事务完成提交，其它的回滚。
+   * 重启前已经提交删除的旧版本也一起删除。
+   * 只处理不大于max_trx_id的事务号，重启之后分配的事务号都比它大，可以和新的事务同时执行
+   */
+  RC recover_trx(int32_t max_trx_id);
 
 private:
   RC scan_record(Trx *trx, ConditionFilter *filter, int limit, void *context, RC (*record_reader)(Record *record, void *context));
-  RC scan_record_by_index(Trx *trx, IndexScanner *scanner, ConditionFilter *filter, int limit, void *context, RC (*record_reader)(Record *record, void *context));
-  IndexScanner *find_index_for_scan(const ConditionFilter *filter);
-  IndexScanner *find_index_for_scan(const DefaultConditionFilter &filter);
+  RC scan_record(Trx *trx, ConditionFilter *filter, const std::vector<const FieldMeta *> *fields, int limit,
+                 void *context, RC (*record_reader)(Record *record, void *context));
+  RC scan_record_by_index(Trx *trx, IndexScanner *scanner, const Index *covering_index, ConditionFilter *filter,
+                          int limit, void *context, RC (*record_reader)(Record *record, void *context));
+
+  /**
+   * 先把一个或多个索引扫描到的RID放到按页面组织的位图中并取交集，再按页面的物理顺序回表，
+   * 每个页面只读取一次(bitmap heap scan)。第一个索引的结果是rids，之后的索引命中超过max_entries条时
+   * 不参与交集，由filter过滤。scanners在函数中销毁
+   */
+  RC scan_record_by_bitmap(Trx *trx, const std::vector<RID> &rids, std::vector<IndexScanner *> &scanners,
+                           int max_entries, ConditionFilter *filter,
+                           void *context, RC (*record_reader)(Record *record, void *context));
+
+  /**
+   * 从第一个索引中最多读max_entries + 1条，读完时放在rids中返回true，否则命中的记录太多，返回false
+   */
+  RC read_index_entries(IndexScanner *scanner, int max_entries, std::vector<RID> &rids, bool *complete);
+
+  /**
+   * 根据过滤条件选择索引，最多返回max_scanner_num个索引上的扫描。
+   * 第一个是匹配条件最多的索引，之后的索引至少要用到一个前面没有用过的条件字段，可以与前面的结果取交集。
+   * fields不为空时，如果第一个索引保存了fields和过滤条件中的所有字段，通过covering_index返回这个索引
+   */
+  RC find_indexes_for_scan(const ConditionFilter *filter, const std::vector<const FieldMeta *> *fields,
+                           int max_scanner_num, std::vector<IndexScanner *> &scanners, const Index **covering_index);
+  RC find_indexes_for_scan(const std::vector<const DefaultConditionFilter *> &filters,
+                           const std::vector<const FieldMeta *> *fields, int max_scanner_num,
+                           std::vector<IndexScanner *> &scanners, const Index **covering_index);
+
+  /**
+   * 把已有的数据加入新建的索引: B+树排序后批量构建，哈希索引逐条插入
+   */
+  RC build_index(Trx *trx, Index *index, const char *index_file);
+
+  /**
+   * 按索引类型创建(create为true)或者打开索引文件，失败时index为nullptr
+   */
+  RC open_index(const char *index_file, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+                const std::vector<FieldMeta> &include_metas, bool create, Index *&index);
+  /**
+   * 删除索引文件，包括LSM树的有序文件和B+树的Bloom过滤器文件
+   */
+  RC remove_index_files(const char *index_file, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_metas,
+                        const std::vector<FieldMeta> &include_metas);
 
   RC insert_record(Trx *trx, Record *record);
   RC delete_record(Trx *trx, Record *record);
+  /**
+   * 删除旧版本并插入new_data作为新版本
+   */
+  RC update_record(Trx *trx, Record *old_record, const char *new_data);
+  /**
+   * 从数据文件和索引中删除记录
+   */
+  RC remove_record(const Record &record);
 
 private:
   friend class RecordUpdater;
@@ -112,6 +246,15 @@ private:
 private:
   Index *find_index(const char *index_name) const;
 
+private:
+  /**
+   * 记录上是否带有未提交事务的信息。没有的记录对所有事务都可见，覆盖索引扫描时可以不用回表。
+   * 第一次覆盖索引扫描前从数据文件中加载一次，之后随事务的操作和提交/回滚维护
+   */
+  void set_record_pending(const RID &rid, bool pending);
+  bool is_record_all_visible(const RID &rid);
+  RC init_visibility_map();
+
 private:
   std::string             base_dir_;
   TableMeta               table_meta_;
@@ -119,6 +262,14 @@ private:
   int                     file_id_;
   RecordFileHandler *     record_handler_;   /// 记录操作
   std::vector<Index *>    indexes_;
+
+  // 检查并设置记录上的删除标记时持有。乐观事务修改记录时不加行锁，靠它和其它事务互斥
+  static const int        RECORD_LATCH_NUM = 64;
+  std::mutex              record_latches_[RECORD_LATCH_NUM];
+
+  std::mutex              visibility_lock_;
+  bool                    visibility_map_inited_ = false;
+  std::unordered_set<uint64_t> pending_records_;  /// 带有未提交事务信息的记录，和删除之后还没有重用的位置
 };
 
 #endif // __OBSERVER_STORAGE_COMMON_TABLE_H__
\ No newline at end of file
@@ -22,6 +22,7 @@ See the Mulan PSL v2 for more details. */
 static const Json::StaticString FIELD_TABLE_NAME("table_name");
 static const Json::StaticString FIELD_FIELDS("fields");
 static const Json::StaticString FIELD_INDEXES("indexes");
+static const Json::StaticString FIELD_DURABILITY("durability");
 
 std::vector<FieldMeta> TableMeta::sys_fields_;
 
@@ -29,7 +30,8 @@ TableMeta::TableMeta(const TableMeta &other) :
         name_(other.name_),
         fields_(other.fields_),
         indexes_(other.indexes_),
-        record_size_(other.record_size_){
+        record_size_(other.record_size_),
+        durability_(other.durability_){
 }
 
 void TableMeta::swap(TableMeta &other) noexcept{
@@ -37,17 +39,30 @@ void TableMeta::swap(TableMeta &other) noexcept{
   fields_.swap(other.fields_);
   indexes_.swap(other.indexes_);
   std::swap(record_size_, other.record_size_);
+  std::swap(durability_, other.durability_);
+}
+
+void TableMeta::set_durability(Durability durability) {
+  durability_ = durability == DURABILITY_DEFAULT ? DURABILITY_SYNC : durability;
 }
 
 RC TableMeta::init_sys_fields() {
-  sys_fields_.reserve(1);
+  // 创建和删除这个版本的事务
+  sys_fields_.reserve(2);
   FieldMeta field_meta;
   RC rc = field_meta.init(Trx::trx_field_name(), Trx::trx_field_type(), 0, Trx::trx_field_len(), false);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to init trx field. rc = %d:%s", rc, strrc(rc));
     return rc;
   }
+  sys_fields_.push_back(field_meta);
 
+  rc = field_meta.init(Trx::trx_end_field_name(), Trx::trx_field_type(), Trx::trx_field_len(),
+                       Trx::trx_field_len(), false);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to init trx end field. rc = %d:%s", rc, strrc(rc));
+    return rc;
+  }
   sys_fields_.push_back(field_meta);
   return rc;
 }
@@ -109,6 +124,10 @@ const FieldMeta * TableMeta::trx_field() const {
   return &fields_[0];
 }
 
+const FieldMeta * TableMeta::trx_end_field() const {
+  return &fields_[1];
+}
+
 const FieldMeta * TableMeta::field(int index) const {
   return &fields_[index];
 }
@@ -151,7 +170,22 @@ const IndexMeta * TableMeta::index(const char *name) const {
 
 const IndexMeta * TableMeta::find_index_by_field(const char *field) const {
   for (const IndexMeta &index : indexes_) {
-    if (0 == strcmp(index.field(), field)) {
+    if (index.field_num() == 1 && 0 == strcmp(index.field(), field)) {
+      return &index;
+    }
+  }
+  return nullptr;
+}
+
+const IndexMeta * TableMeta::find_index_by_fields(const char * const fields[], int field_num) const {
+  for (const IndexMeta &index : indexes_) {
+    if (index.field_num() != field_num) {
+      continue;
+    }
+    int i = 0;
+    for (; i < field_num && 0 == strcmp(index.field(i), fields[i]); i++) {
+    }
+    if (i == field_num) {
       return &index;
     }
   }
@@ -191,6 +225,7 @@ int TableMeta::serialize(std::ostream &ss) const {
     indexes_value.append(std::move(index_value));
   }
   table_value[FIELD_INDEXES] = std::move(indexes_value);
+  table_value[FIELD_DURABILITY] = durability_name(durability_);
 
   Json::StreamWriterBuilder builder;
   Json::StreamWriter *writer = builder.newStreamWriter();
@@ -226,6 +261,15 @@ int TableMeta::deserialize(std::istream &is) {
 
   std::string table_name = table_name_value.asString();
 
+  // 旧版本的元数据中没有持久性级别，都是同步提交
+  Durability durability = DURABILITY_SYNC;
+  const Json::Value &durability_value = table_value[FIELD_DURABILITY];
+  if (!durability_value.isNull() &&
+      (!durability_value.isString() || parse_durability(durability_value.asCString(), &durability) != 0)) {
+    LOG_ERROR("Invalid table durability. json value=%s", durability_value.toStyledString().c_str());
+    return -1;
+  }
+
   const Json::Value &fields_value = table_value[FIELD_FIELDS];
   if (!fields_value.isArray() || fields_value.size() <= 0) {
     LOG_ERROR("Invalid table meta. fields is not array, json value=%s", fields_value.toStyledString().c_str());
@@ -246,11 +290,25 @@ int TableMeta::deserialize(std::istream &is) {
     }
   }
 
-  std::sort(fields.begin(), fields.end(), 
+  std::sort(fields.begin(), fields.end(),
       [](const FieldMeta &f1, const FieldMeta &f2){return f1.offset() < f2.offset();});
 
+  // 没有多版本事务字段的表是旧版本创建的，记录格式不同
+  if (fields.size() <= sys_fields_.size()) {
+    LOG_ERROR("Invalid table meta. too few fields. table name=%s", table_name.c_str());
+    return -1;
+  }
+  for (size_t i = 0; i < sys_fields_.size(); i++) {
+    if (0 != strcmp(fields[i].name(), sys_fields_[i].name()) || fields[i].offset() != sys_fields_[i].offset()) {
+      LOG_ERROR("Invalid table meta. system field %s is missing. table name=%s",
+                sys_fields_[i].name(), table_name.c_str());
+      return -1;
+    }
+  }
+
   name_.swap(table_name);
   fields_.swap(fields);
+  set_durability(durability);
   record_size_ = fields_.back().offset() + fields_.back().len();
 
   const Json::Value &indexes_value = table_value[FIELD_INDEXES];
@@ -297,5 +355,9 @@ void TableMeta::desc(std::ostream &os) const {
     index.desc(os);
     os << std::endl;
   }
-  os << ')' << std::endl;
+  os << ')';
+  if (durability_ != DURABILITY_SYNC) {
+    os << " durability=" << durability_name(durability_);
+  }
+  os << std::endl;
 }
@@ -36,9 +36,15 @@ public:
 
   RC add_index(const IndexMeta &index);
 
+  /**
+   * 表上事务提交的默认持久性级别，DURABILITY_DEFAULT按DURABILITY_SYNC保存
+   */
+  void set_durability(Durability durability);
+
 public:
   const char * name() const;
   const FieldMeta * trx_field() const;
+  const FieldMeta * trx_end_field() const;
   const FieldMeta * field(int index) const;
   const FieldMeta * field(const char *name) const;
   const FieldMeta * find_field_by_offset(int offset) const;
@@ -46,11 +52,15 @@ public:
   int sys_field_num() const;
 
   const IndexMeta * index(const char *name) const;
-  const IndexMeta * find_index_by_field(const char *field) const;
+  const IndexMeta * find_index_by_field(const char *field) const;          // 只查找单列索引
+  const IndexMeta * find_index_by_fields(const char * const fields[], int field_num) const;
   const IndexMeta * index(int i) const;
   int index_num() const;
 
   int record_size() const;
+  Durability durability() const {
+    return durability_;
+  }
 
 public:
   int  serialize(std::ostream &os) const override;
@@ -67,6 +77,7 @@ private:
   std::vector<IndexMeta>  indexes_;
 
   int  record_size_ = 0;
+  Durability durability_ = DURABILITY_SYNC;
 
   static std::vector<FieldMeta> sys_fields_;
 };
@@ -0,0 +1,199 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <thread>
+
+#include "storage/default/backup.h"
+#include "storage/default/disk_buffer_pool.h"
+#include "common/log/log.h"
+
+BackupOptions &BackupOptions::instance() {
+  static BackupOptions options;
+  return options;
+}
+
+OnlineBackup::OnlineBackup(DiskBufferPool &buffer_pool, CLogManager &clog_manager, const BackupOptions &options)
+    : buffer_pool_(buffer_pool), clog_manager_(clog_manager), options_(options) {
+  options_.read_size = std::max<size_t>(options_.read_size, BP_PAGE_SIZE);
+}
+
+RC OnlineBackup::run(const std::string &base_dir, const std::string &target_dir) {
+  stats_ = BackupStats();
+  if (mkdir(target_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 && errno != EEXIST) {
+    LOG_ERROR("Failed to create backup directory %s, due to %s.", target_dir.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  const std::string target_db_dir = target_dir + "/db";
+  if (access(target_db_dir.c_str(), F_OK) == 0) {
+    LOG_WARN("Backup directory %s is not empty.", target_dir.c_str());
+    return RC::SCHEMA_DB_EXIST;
+  }
+
+  CLogBackup log_backup;
+  RC rc = clog_manager_.begin_backup(log_backup);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  begin_ = std::chrono::steady_clock::now();
+  buffer_.resize(options_.read_size);
+  rc = copy_dir(base_dir + "/db", target_db_dir);
+  if (rc == RC::SUCCESS) {
+    // 复制期间的修改都在这之前的日志里
+    rc = clog_manager_.copy_backup_log(log_backup, target_dir + "/clog");
+  }
+  clog_manager_.end_backup(log_backup);
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to backup %s to %s. rc=%d:%s", base_dir.c_str(), target_dir.c_str(), rc, strrc(rc));
+    return rc;
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin_;
+  stats_.start_lsn = log_backup.start_lsn;
+  stats_.end_lsn = log_backup.end_lsn;
+  stats_.seconds = elapsed.count();
+  LOG_INFO("Backup %s to %s. files=%ld, bytes=%ld, lsn=[%lld, %lld), seconds=%.3f", base_dir.c_str(),
+           target_dir.c_str(), stats_.files, stats_.bytes, (long long)stats_.start_lsn, (long long)stats_.end_lsn,
+           stats_.seconds);
+  return RC::SUCCESS;
+}
+
+static bool has_suffix(const std::string &name, const char *suffix) {
+  const size_t length = strlen(suffix);
+  return name.size() > length && name.compare(name.size() - length, length, suffix) == 0;
+}
+
+RC OnlineBackup::copy_dir(const std::string &source_dir, const std::string &target_dir) {
+  DIR *dirp = opendir(source_dir.c_str());
+  if (dirp == nullptr) {
+    LOG_ERROR("Failed to open directory %s, due to %s.", source_dir.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  std::vector<std::string> names;
+  struct dirent *entry = nullptr;
+  while ((entry = readdir(dirp)) != nullptr) {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dirp);
+  std::sort(names.begin(), names.end());
+
+  if (mkdir(target_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 && errno != EEXIST) {
+    LOG_ERROR("Failed to create directory %s, due to %s.", target_dir.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  for (const std::string &name : names) {
+    const std::string source = source_dir + "/" + name;
+    const std::string target = target_dir + "/" + name;
+    struct stat st;
+    if (stat(source.c_str(), &st) != 0) {
+      continue;  // 复制期间被删除了
+    }
+    RC rc = RC::SUCCESS;
+    if (S_ISDIR(st.st_mode)) {
+      rc = copy_dir(source, target);
+    } else if (S_ISREG(st.st_mode)) {
+      // 写元数据时的临时文件。Bloom过滤器和LSM索引的有序文件都不在日志中，和重放之后的索引对不上，
+      // 恢复时过滤器从B+树重建，LSM索引从表中重建
+      if (has_suffix(name, ".tmp") || has_suffix(name, ".bloom") || has_suffix(name, ".run")) {
+        continue;
+      }
+      rc = copy_file(source, target);
+    }
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC OnlineBackup::copy_file(const std::string &source_file, const std::string &target_file) {
+  int source = ::open(source_file.c_str(), O_RDONLY);
+  if (source < 0) {
+    if (errno == ENOENT) {
+      return RC::SUCCESS;
+    }
+    LOG_ERROR("Failed to open %s, due to %s.", source_file.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  int target = ::open(target_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IREAD | S_IWRITE);
+  if (target < 0) {
+    LOG_ERROR("Failed to create %s, due to %s.", target_file.c_str(), strerror(errno));
+    ::close(source);
+    return RC::IOERR_ACCESS;
+  }
+
+  RC rc = RC::SUCCESS;
+  off_t offset = 0;
+  while (true) {
+    // 文件在复制期间还会变长，一直读到文件末尾。新追加的页面也在日志中
+    size_t read_size = 0;
+    rc = buffer_pool_.read_file(source, offset, buffer_.data(), buffer_.size(), &read_size);
+    if (rc != RC::SUCCESS || read_size == 0) {
+      break;
+    }
+    for (size_t written = 0; written < read_size;) {
+      ssize_t ret = pwrite(target, buffer_.data() + written, read_size - written, offset + written);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG_ERROR("Failed to write %s at %lld, due to %s.", target_file.c_str(), (long long)(offset + written),
+                  strerror(errno));
+        rc = RC::IOERR_WRITE;
+        break;
+      }
+      written += ret;
+    }
+    if (rc != RC::SUCCESS) {
+      break;
+    }
+    offset += read_size;
+    throttle(read_size);
+  }
+  if (rc == RC::SUCCESS && fsync(target) != 0) {
+    LOG_ERROR("Failed to sync %s, due to %s.", target_file.c_str(), strerror(errno));
+    rc = RC::IOERR_FSYNC;
+  }
+  ::close(source);
+  ::close(target);
+  if (rc == RC::SUCCESS) {
+    stats_.files++;
+  }
+  return rc;
+}
+
+/**
+ * 按开始以来复制的总字节数限速，读得快的时候在缓冲池的锁外睡眠
+ */
+void OnlineBackup::throttle(size_t bytes) {
+  stats_.bytes += bytes;
+  if (options_.max_rate <= 0) {
+    return;
+  }
+  const double seconds = (double)stats_.bytes / ((double)options_.max_rate * 1024 * 1024);
+  const auto deadline = begin_ + std::chrono::microseconds((long long)(seconds * 1000 * 1000));
+  if (deadline > std::chrono::steady_clock::now()) {
+    std::this_thread::sleep_until(deadline);
+  }
+}
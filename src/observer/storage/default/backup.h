@@ -0,0 +1,88 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_DEFAULT_BACKUP_H_
+#define __OBSERVER_STORAGE_DEFAULT_BACKUP_H_
+
+#include <sys/types.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "rc.h"
+#include "storage/clog/clog.h"
+
+/**
+ * 在线备份的参数，由DefaultStorageStage根据配置文件设置
+ */
+struct BackupOptions {
+  size_t read_size = 1024 * 1024;   // 每次从数据文件顺序读的大小，读的时候持有缓冲池的锁
+  int    max_rate = 64;             // 每秒最多读多少MB，0表示不限速
+
+  static BackupOptions &instance();
+};
+
+struct BackupStats {
+  long   files = 0;         // 复制的数据和元数据文件数
+  long   bytes = 0;         // 复制的数据和元数据字节数
+  LSN    start_lsn = 0;     // 备份恢复时从这里开始重放日志
+  LSN    end_lsn = 0;       // 备份恢复之后是日志到这里时的状态
+  double seconds = 0;
+};
+
+/**
+ * 在线备份。表和索引的页面在缓冲池中原地修改，复制文件期间页面还在不断写回，复制下来的文件不是同一时刻的。
+ * 借助redo日志得到一致的备份：
+ * 1. 记下最近的检查点，之前的修改都已经在数据文件中，之后的日志段在备份结束前保留；
+ * 2. 按顺序大块读取base_dir/db下所有的文件复制到target_dir/db下。读数据时持有缓冲池的锁，不会读到写了一半的页面，
+ *    每次读的大小和每秒读的字节数限制了对前台的影响；
+ * 3. 让日志落盘，把检查点开始的日志和一个从检查点恢复的控制文件复制到target_dir。
+ * 复制期间修改的页面不管复制的是新内容还是旧内容，恢复时都会用日志重放到日志结束时的状态，页面上的LSN保证重放不会重复。
+ *
+ * 不在日志中的文件不复制：Bloom过滤器打开B+树索引时重建；LSM索引的有序文件和哈希索引的页面也没有日志，
+ * 备份的控制文件没有正常关闭的标记，用备份启动时按崩溃恢复处理，这两种索引都删掉之后从恢复出的表中重建。
+ *
+ * 日志中记录的是数据文件的路径(默认配置下是相对路径./miniob/db/...)，用备份启动时要把target_dir
+ * 放到新的工作目录下和原来的BaseDir相同的位置。没有打开redo日志时不能在线备份
+ */
+class OnlineBackup {
+public:
+  OnlineBackup(DiskBufferPool &buffer_pool, CLogManager &clog_manager,
+               const BackupOptions &options = BackupOptions::instance());
+  ~OnlineBackup() = default;
+
+  /**
+   * base_dir是数据目录(BaseDir)，target_dir不存在时创建，已经有备份时返回错误
+   */
+  RC run(const std::string &base_dir, const std::string &target_dir);
+
+  const BackupStats &stats() const {
+    return stats_;
+  }
+
+private:
+  RC copy_dir(const std::string &source_dir, const std::string &target_dir);
+  RC copy_file(const std::string &source_file, const std::string &target_file);
+  void throttle(size_t bytes);
+
+private:
+  DiskBufferPool &buffer_pool_;
+  CLogManager    &clog_manager_;
+  BackupOptions   options_;
+  BackupStats     stats_;
+  std::vector<char> buffer_;
+  std::chrono::steady_clock::time_point begin_;
+};
+
+#endif // __OBSERVER_STORAGE_DEFAULT_BACKUP_H_
@@ -24,6 +24,10 @@ See the Mulan PSL v2 for more details. */
 #include "storage/common/bplus_tree.h"
 #include "storage/common/table.h"
 #include "storage/common/condition_filter.h"
+#include "storage/clog/clog.h"
+#include "storage/default/backup.h"
+#include "storage/trx/trx.h"
+#include "storage/trx/mvcc_manager.h"
 
 DefaultHandler &DefaultHandler::get_default() {
   static DefaultHandler handler;
@@ -49,17 +53,36 @@ RC DefaultHandler::init(const char *base_dir) {
   base_dir_ = base_dir;
   db_dir_ = tmp + "/";
 
+  // 打开数据文件之前重放redo日志
+  std::string clog_file = base_dir_ + "/clog";
+  CLogManager *clog_manager = theGlobalCLogManager();
+  RC rc = clog_manager->open(clog_file.c_str());
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open clog file: %s. rc=%d:%s", clog_file.c_str(), rc, strrc(rc));
+    return rc;
+  }
+  rc = clog_manager->recover(*theGlobalDiskBufferPool());
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to recover from clog file: %s. rc=%d:%s", clog_file.c_str(), rc, strrc(rc));
+    return rc;
+  }
+  // 重启前留下的事务号由Db在后台处理，新的事务号要比它们都大
+  Trx::init_trx_id(clog_manager->recovered_trx_id());
+
   LOG_INFO("Default handler init with %s success", base_dir);
   return RC::SUCCESS;
 }
 
 void DefaultHandler::destroy() {
+  // 没有清理的旧版本在重启之后由Table::recover_trx删除
+  theGlobalMvccManager()->stop();
   sync();
 
   for (const auto & iter : opened_dbs_) {
     delete iter.second;
   }
   opened_dbs_.clear();
+  theGlobalCLogManager()->close();
 }
 
 RC DefaultHandler::create_db(const char *dbname) {
@@ -119,15 +142,26 @@ RC DefaultHandler::execute(const char *sql) {
   return RC::GENERIC_ERROR;
 }
 
-RC DefaultHandler::create_table(const char *dbname, const char *relation_name, int attribute_count, const AttrInfo *attributes) {
+RC DefaultHandler::create_table(const char *dbname, const char *relation_name, int attribute_count,
+                                const AttrInfo *attributes, Durability durability) {
+  std::shared_lock<std::shared_timed_mutex> ddl_guard(ddl_lock_, std::try_to_lock);
+  if (!ddl_guard.owns_lock()) {
+    LOG_WARN("Online backup is in progress.");
+    return RC::BUSY;
+  }
   Db *db = find_db(dbname);
   if (db == nullptr) {
     return RC::SCHEMA_DB_NOT_OPENED;
   }
-  return db->create_table(relation_name, attribute_count, attributes);
+  return db->create_table(relation_name, attribute_count, attributes, durability);
 }
 
 RC DefaultHandler::drop_table(const char *dbname, const char *relation_name) {
+  std::shared_lock<std::shared_timed_mutex> ddl_guard(ddl_lock_, std::try_to_lock);
+  if (!ddl_guard.owns_lock()) {
+    LOG_WARN("Online backup is in progress.");
+    return RC::BUSY;
+  }
   Db *db = find_db(dbname);
   if (db == nullptr) {
       return RC::SCHEMA_DB_NOT_OPENED;
@@ -135,12 +169,21 @@ RC DefaultHandler::drop_table(const char *dbname, const char *relation_name) {
   return db->drop_table(relation_name);
 }
 
-RC DefaultHandler::create_index(Trx *trx, const char *dbname, const char *relation_name, const char *index_name, const char *attribute_name) {
+RC DefaultHandler::create_index(Trx *trx, const char *dbname, const char *relation_name, const char *index_name,
+                                int attribute_num, const char * const attribute_names[],
+                                int include_num, const char * const include_names[], IndexType index_type,
+                                int index_options) {
+  std::shared_lock<std::shared_timed_mutex> ddl_guard(ddl_lock_, std::try_to_lock);
+  if (!ddl_guard.owns_lock()) {
+    LOG_WARN("Online backup is in progress.");
+    return RC::BUSY;
+  }
   Table *table = find_table(dbname, relation_name);
   if (nullptr == table) {
     return RC::SCHEMA_TABLE_NOT_EXIST;
   }
-  return table->create_index(trx, index_name, attribute_name);
+  return table->create_index(trx, index_name, attribute_num, attribute_names, include_num, include_names,
+                             index_type, index_options);
 }
 
 RC DefaultHandler::drop_index(Trx *trx, const char *dbname, const char *relation_name, const char *index_name) {
@@ -210,14 +253,43 @@ Table *DefaultHandler::find_table(const char *dbname, const char *table_name) co
 }
 
 RC DefaultHandler::sync() {
+  // 日志落盘之后页面上的修改就不会丢失，脏页交给后台的检查点限速写回，不在SQL线程中等待。
+  // 页面以外的状态(LSM的memtable、Bloom过滤器)还是要由各个表写出
+  CLogManager *clog_manager = theGlobalCLogManager();
+  const bool flush_pages = !clog_manager->enabled();
   RC rc = RC::SUCCESS;
+  if (!flush_pages) {
+    rc = clog_manager->sync(clog_manager->current_lsn());
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to sync redo log. rc=%d:%s", rc, strrc(rc));
+      return rc;
+    }
+  }
+
   for (const auto & db_pair: opened_dbs_) {
     Db *db = db_pair.second;
-    rc = db->sync();
+    rc = db->sync(flush_pages);
     if (rc != RC::SUCCESS) {
       LOG_ERROR("Failed to sync db. name=%s, rc=%d:%s", db->name(), rc, strrc(rc));
       return rc;
     }
   }
+  if (!flush_pages) {
+    clog_manager->request_checkpoint();
+  }
   return rc;
-}
\ No newline at end of file
+}
+
+RC DefaultHandler::backup(const char *dir) {
+  if (nullptr == dir || common::is_blank(dir)) {
+    LOG_WARN("Invalid backup directory");
+    return RC::INVALID_ARGUMENT;
+  }
+  std::unique_lock<std::shared_timed_mutex> ddl_guard(ddl_lock_, std::try_to_lock);
+  if (!ddl_guard.owns_lock()) {
+    LOG_WARN("Another backup or ddl is in progress.");
+    return RC::BUSY;
+  }
+  OnlineBackup backup(*theGlobalDiskBufferPool(), *theGlobalCLogManager());
+  return backup.run(base_dir_, dir);
+}
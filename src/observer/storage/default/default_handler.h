@@ -16,6 +16,7 @@ See the Mulan PSL v2 for more details. */
 
 #include <string>
 #include <map>
+#include <shared_mutex>
 
 #include "storage/common/db.h"
 
@@ -79,9 +80,11 @@ public:
    * @param relName
    * @param attrCount
    * @param attributes
+   * @param durability 表上事务提交的默认持久性级别
    * @return
    */
-  RC create_table(const char *dbname, const char *relation_name, int attribute_count, const AttrInfo *attributes);
+  RC create_table(const char *dbname, const char *relation_name, int attribute_count, const AttrInfo *attributes,
+                  Durability durability = DURABILITY_DEFAULT);
 
   /**
    * 销毁名为relName的表以及在该表上建立的所有索引
@@ -99,10 +102,15 @@ public:
    * ②逐个扫描被索引的记录，并向索引文件中插入索引项；③关闭索引
    * @param indexName
    * @param relName
-   * @param attrName
+   * @param attrNames 多个字段时创建组合索引
+   * @param include_names 只保存在索引叶子中的字段(INCLUDE)
+   * @param index_type B+树索引或哈希索引(USING HASH)
+   * @param index_options IndexOption的组合(WITH BLOOM, WITH ADAPTIVE_HASH)
    * @return
    */
-  RC create_index(Trx *trx, const char *dbname, const char *relation_name, const char *index_name, const char *attribute_name);
+  RC create_index(Trx *trx, const char *dbname, const char *relation_name, const char *index_name,
+                  int attribute_num, const char * const attribute_names[],
+                  int include_num, const char * const include_names[], IndexType index_type, int index_options);
 
   /**
    * 该函数用来删除名为indexName的索引。
@@ -155,14 +163,24 @@ public:
   Db *find_db(const char *dbname) const;
   Table *find_table(const char * dbname, const char *table_name) const;
 
+  /**
+   * 打开了redo日志时只等日志落盘，然后让后台做一次检查点；否则把所有表和索引的页面写回
+   */
   RC sync();
 
+  /**
+   * 在线备份到dir，不阻塞读写，期间的建表、删表和建索引返回BUSY。
+   * 打开的数据文件和redo日志复制到dir/db、dir/clog，恢复时把dir放到和BaseDir相同的路径下启动
+   */
+  RC backup(const char *dir);
+
 public:
   static DefaultHandler &get_default();
 private:
   std::string base_dir_;
   std::string db_dir_;
   std::map<std::string, Db*>          opened_dbs_;
+  std::shared_timed_mutex             ddl_lock_;    // 在线备份期间不能增删文件，DDL加共享锁
 }; // class Handler
 
 #endif // __OBSERVER_STORAGE_DEFAULT_ENGINE_H__
\ No newline at end of file
@@ -28,7 +28,14 @@ See the Mulan PSL v2 for more details. */
 #include "storage/common/condition_filter.h"
 #include "storage/common/table.h"
 #include "storage/common/table_meta.h"
+#include "storage/common/key_sorter.h"
+#include "storage/common/adaptive_hash_index.h"
+#include "storage/common/bplus_tree.h"
+#include "storage/common/lsm_tree.h"
+#include "storage/clog/clog.h"
+#include "storage/default/backup.h"
 #include "storage/trx/trx.h"
+#include "storage/trx/lock_manager.h"
 #include "event/execution_plan_event.h"
 #include "event/session_event.h"
 #include "event/sql_event.h"
@@ -40,6 +47,28 @@ using namespace common;
 const std::string DefaultStorageStage::QUERY_METRIC_TAG = "DefaultStorageStage.query";
 const char * CONF_BASE_DIR = "BaseDir";
 const char * CONF_SYSTEM_DB = "SystemDb";
+const char * CONF_INDEX_FILL_FACTOR = "IndexFillFactor";
+const char * CONF_INDEX_SORT_THREADS = "IndexSortThreads";
+const char * CONF_INDEX_SORT_MEMORY = "IndexSortMemory";
+const char * CONF_INDEX_PREFIX_COMPRESSION = "IndexPrefixCompression";
+const char * CONF_INDEX_UPPER_LEVEL_PAGES = "IndexUpperLevelPages";
+const char * CONF_INDEX_SCAN_SELECTIVITY = "IndexScanSelectivity";
+const char * CONF_BITMAP_SCAN_SELECTIVITY = "BitmapScanSelectivity";
+const char * CONF_ADAPTIVE_HASH_MEMORY = "AdaptiveHashMemory";
+const char * CONF_ADAPTIVE_HASH_THRESHOLD = "AdaptiveHashThreshold";
+const char * CONF_LSM_MEMTABLE_SIZE = "LsmMemtableSize";
+const char * CONF_LSM_RUNS_PER_LEVEL = "LsmRunsPerLevel";
+const char * CONF_CLOG_BUFFER_SIZE = "CLogBufferSize";
+const char * CONF_CLOG_COMMIT_DELAY = "CLogCommitDelay";
+const char * CONF_CLOG_CHECKPOINT_SIZE = "CLogCheckpointSize";
+const char * CONF_CLOG_RECOVERY_THREADS = "CLogRecoveryThreads";
+const char * CONF_CLOG_ASYNC_COMMIT_DELAY = "CLogAsyncCommitDelay";
+const char * CONF_CLOG_CHECKPOINT_FLUSH_RATE = "CLogCheckpointFlushRate";
+const char * CONF_CLOG_CHECKPOINT_MAX_PAUSE = "CLogCheckpointMaxPause";
+const char * CONF_BACKUP_READ_SIZE = "BackupReadSize";
+const char * CONF_BACKUP_MAX_RATE = "BackupMaxRate";
+const char * CONF_LOCK_WAIT_TIMEOUT = "LockWaitTimeout";
+const char * CONF_OCC_MAX_RETRIES = "OccMaxRetries";
 
 const char * DEFAULT_SYSTEM_DB = "sys";
 
@@ -86,6 +115,206 @@ bool DefaultStorageStage::set_properties() {
     LOG_INFO("Use %s as system db", sys_db);
   }
 
+  IndexBuildOptions &index_build_options = IndexBuildOptions::instance();
+  iter = section.find(CONF_INDEX_FILL_FACTOR);
+  if (iter != section.end()) {
+    float fill_factor = atof(iter->second.c_str());
+    if (fill_factor <= 0 || fill_factor > 1) {
+      LOG_ERROR("Invalid %s: %s, should be in (0, 1]", CONF_INDEX_FILL_FACTOR, iter->second.c_str());
+      return false;
+    }
+    index_build_options.fill_factor = fill_factor;
+  }
+  iter = section.find(CONF_INDEX_SORT_THREADS);
+  if (iter != section.end()) {
+    index_build_options.sort_threads = atoi(iter->second.c_str());
+  }
+  iter = section.find(CONF_INDEX_SORT_MEMORY);
+  if (iter != section.end()) {
+    long long sort_memory = atoll(iter->second.c_str());
+    if (sort_memory > 0) {
+      index_build_options.sort_memory = sort_memory;
+    }
+  }
+  iter = section.find(CONF_INDEX_PREFIX_COMPRESSION);
+  if (iter != section.end()) {
+    index_build_options.prefix_compression = atoi(iter->second.c_str()) != 0;
+  }
+  iter = section.find(CONF_INDEX_UPPER_LEVEL_PAGES);
+  if (iter != section.end()) {
+    int upper_level_pages = atoi(iter->second.c_str());
+    if (upper_level_pages < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_INDEX_UPPER_LEVEL_PAGES, iter->second.c_str());
+      return false;
+    }
+    BplusTreeOptions::instance().upper_level_pages = upper_level_pages;
+  }
+
+  TableScanOptions &scan_options = TableScanOptions::instance();
+  iter = section.find(CONF_INDEX_SCAN_SELECTIVITY);
+  if (iter != section.end()) {
+    double selectivity = atof(iter->second.c_str());
+    if (selectivity < 0 || selectivity > 1) {
+      LOG_ERROR("Invalid %s: %s, should be in [0, 1]", CONF_INDEX_SCAN_SELECTIVITY, iter->second.c_str());
+      return false;
+    }
+    scan_options.index_scan_selectivity = selectivity;
+  }
+  iter = section.find(CONF_BITMAP_SCAN_SELECTIVITY);
+  if (iter != section.end()) {
+    double selectivity = atof(iter->second.c_str());
+    if (selectivity < 0 || selectivity > 1) {
+      LOG_ERROR("Invalid %s: %s, should be in [0, 1]", CONF_BITMAP_SCAN_SELECTIVITY, iter->second.c_str());
+      return false;
+    }
+    scan_options.bitmap_scan_selectivity = selectivity;
+  }
+
+  AdaptiveHashOptions &adaptive_hash_options = AdaptiveHashOptions::instance();
+  iter = section.find(CONF_ADAPTIVE_HASH_MEMORY);
+  if (iter != section.end()) {
+    long long memory_limit = atoll(iter->second.c_str());
+    if (memory_limit < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_ADAPTIVE_HASH_MEMORY, iter->second.c_str());
+      return false;
+    }
+    adaptive_hash_options.memory_limit = memory_limit;
+  }
+  iter = section.find(CONF_ADAPTIVE_HASH_THRESHOLD);
+  if (iter != section.end()) {
+    int hot_threshold = atoi(iter->second.c_str());
+    if (hot_threshold < 1 || hot_threshold > 255) {
+      LOG_ERROR("Invalid %s: %s, should be in [1, 255]", CONF_ADAPTIVE_HASH_THRESHOLD, iter->second.c_str());
+      return false;
+    }
+    adaptive_hash_options.hot_threshold = hot_threshold;
+  }
+
+  LsmOptions &lsm_options = LsmOptions::instance();
+  iter = section.find(CONF_LSM_MEMTABLE_SIZE);
+  if (iter != section.end()) {
+    long long memtable_size = atoll(iter->second.c_str());
+    if (memtable_size <= 0) {
+      LOG_ERROR("Invalid %s: %s, should be positive", CONF_LSM_MEMTABLE_SIZE, iter->second.c_str());
+      return false;
+    }
+    lsm_options.memtable_size = memtable_size;
+  }
+  iter = section.find(CONF_LSM_RUNS_PER_LEVEL);
+  if (iter != section.end()) {
+    int runs_per_level = atoi(iter->second.c_str());
+    if (runs_per_level < 2) {
+      LOG_ERROR("Invalid %s: %s, should be at least 2", CONF_LSM_RUNS_PER_LEVEL, iter->second.c_str());
+      return false;
+    }
+    lsm_options.runs_per_level = runs_per_level;
+  }
+
+  CLogOptions &clog_options = CLogOptions::instance();
+  iter = section.find(CONF_CLOG_BUFFER_SIZE);
+  if (iter != section.end()) {
+    long long buffer_size = atoll(iter->second.c_str());
+    if (buffer_size < 65536) {
+      LOG_ERROR("Invalid %s: %s, should be at least 65536", CONF_CLOG_BUFFER_SIZE, iter->second.c_str());
+      return false;
+    }
+    clog_options.buffer_size = buffer_size;
+  }
+  iter = section.find(CONF_CLOG_COMMIT_DELAY);
+  if (iter != section.end()) {
+    int commit_delay = atoi(iter->second.c_str());
+    if (commit_delay < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_CLOG_COMMIT_DELAY, iter->second.c_str());
+      return false;
+    }
+    clog_options.commit_delay = commit_delay;
+  }
+  iter = section.find(CONF_CLOG_CHECKPOINT_SIZE);
+  if (iter != section.end()) {
+    long long checkpoint_size = atoll(iter->second.c_str());
+    if (checkpoint_size < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_CLOG_CHECKPOINT_SIZE, iter->second.c_str());
+      return false;
+    }
+    clog_options.checkpoint_size = checkpoint_size;
+  }
+  iter = section.find(CONF_CLOG_RECOVERY_THREADS);
+  if (iter != section.end()) {
+    int recovery_threads = atoi(iter->second.c_str());
+    if (recovery_threads < 1) {
+      LOG_ERROR("Invalid %s: %s, should be at least 1", CONF_CLOG_RECOVERY_THREADS, iter->second.c_str());
+      return false;
+    }
+    clog_options.recovery_threads = recovery_threads;
+  }
+  iter = section.find(CONF_CLOG_ASYNC_COMMIT_DELAY);
+  if (iter != section.end()) {
+    int async_commit_delay = atoi(iter->second.c_str());
+    if (async_commit_delay < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_CLOG_ASYNC_COMMIT_DELAY, iter->second.c_str());
+      return false;
+    }
+    clog_options.async_commit_delay = async_commit_delay;
+  }
+  iter = section.find(CONF_CLOG_CHECKPOINT_FLUSH_RATE);
+  if (iter != section.end()) {
+    int checkpoint_flush_rate = atoi(iter->second.c_str());
+    if (checkpoint_flush_rate < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_CLOG_CHECKPOINT_FLUSH_RATE, iter->second.c_str());
+      return false;
+    }
+    clog_options.checkpoint_flush_rate = checkpoint_flush_rate;
+  }
+  iter = section.find(CONF_CLOG_CHECKPOINT_MAX_PAUSE);
+  if (iter != section.end()) {
+    int checkpoint_max_pause = atoi(iter->second.c_str());
+    if (checkpoint_max_pause < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_CLOG_CHECKPOINT_MAX_PAUSE, iter->second.c_str());
+      return false;
+    }
+    clog_options.checkpoint_max_pause = checkpoint_max_pause;
+  }
+
+  BackupOptions &backup_options = BackupOptions::instance();
+  iter = section.find(CONF_BACKUP_READ_SIZE);
+  if (iter != section.end()) {
+    long read_size = atol(iter->second.c_str());
+    if (read_size < BP_PAGE_SIZE) {
+      LOG_ERROR("Invalid %s: %s, should be at least %d", CONF_BACKUP_READ_SIZE, iter->second.c_str(), BP_PAGE_SIZE);
+      return false;
+    }
+    backup_options.read_size = read_size;
+  }
+  iter = section.find(CONF_BACKUP_MAX_RATE);
+  if (iter != section.end()) {
+    int max_rate = atoi(iter->second.c_str());
+    if (max_rate < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_BACKUP_MAX_RATE, iter->second.c_str());
+      return false;
+    }
+    backup_options.max_rate = max_rate;
+  }
+
+  iter = section.find(CONF_LOCK_WAIT_TIMEOUT);
+  if (iter != section.end()) {
+    int wait_timeout = atoi(iter->second.c_str());
+    if (wait_timeout < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_LOCK_WAIT_TIMEOUT, iter->second.c_str());
+      return false;
+    }
+    LockOptions::instance().wait_timeout = wait_timeout;
+  }
+
+  iter = section.find(CONF_OCC_MAX_RETRIES);
+  if (iter != section.end()) {
+    int max_retries = atoi(iter->second.c_str());
+    if (max_retries < 0) {
+      LOG_ERROR("Invalid %s: %s, should not be negative", CONF_OCC_MAX_RETRIES, iter->second.c_str());
+      return false;
+    }
+    OccOptions::instance().max_retries = max_retries;
+  }
+
   handler_ = &DefaultHandler::get_default();
   if (RC::SUCCESS != handler_->init(base_dir)) {
     LOG_ERROR("Failed to init default handler");
@@ -157,39 +386,38 @@ void DefaultStorageStage::handle_event(StageEvent *event) {
   Trx *current_trx = session->current_trx();
 
   RC rc = RC::SUCCESS;
+  bool trx_ended = false;
 
   char response[256];
   switch (sql->flag)
   {
-  case SCF_INSERT: { // insert into
-      const Inserts &inserts = sql->sstr.insertion;
-      const char *table_name = inserts.relation_name;
-      rc = handler_->insert_record(current_trx, current_db, table_name, inserts.value_num, inserts.values);
-      snprintf(response, sizeof(response), "%s\n", rc == RC::SUCCESS ? "SUCCESS" : "FAILURE");
-    }
-    break;
-  case SCF_UPDATE: {
-      const Updates &updates = sql->sstr.update;
-      const char *table_name = updates.relation_name;
-      const char *field_name = updates.attribute_name;
-      int updated_count = 0;
-      rc = handler_->update_record(current_trx, current_db, table_name, field_name, &updates.value,
-                                   updates.condition_num, updates.conditions, &updated_count);
-      snprintf(response, sizeof(response), "%s\n", rc == RC::SUCCESS ? "SUCCESS" : "FAILURE");
-    }
-    break;
+  case SCF_INSERT: // insert into
+  case SCF_UPDATE:
   case SCF_DELETE: {
-      const Deletes &deletes = sql->sstr.deletion;
-      const char *table_name = deletes.relation_name;
-      int deleted_count = 0;
-      rc = handler_->delete_record(current_trx, current_db, table_name, deletes.condition_num, deletes.conditions, &deleted_count);
+      rc = execute_dml(current_trx, current_db, sql);
+      // 乐观并发控制下自动提交的语句遇到冲突时回滚，用新的快照重新执行
+      if (!session->is_trx_multi_operation_mode() && current_trx->optimistic()) {
+        for (int retries = 0; ; retries++) {
+          if (rc == RC::SUCCESS) {
+            rc = current_trx->commit();  // 检查失败时已经回滚
+          } else {
+            current_trx->rollback();
+          }
+          if (rc != RC::BUSY_SNAPSHOT || retries >= OccOptions::instance().max_retries) {
+            break;
+          }
+          LOG_TRACE("Retry optimistic statement after conflict. retries=%d", retries + 1);
+          rc = execute_dml(current_trx, current_db, sql);
+        }
+        trx_ended = true;
+      }
       snprintf(response, sizeof(response), "%s\n", rc == RC::SUCCESS ? "SUCCESS" : "FAILURE");
     }
     break;
   case SCF_CREATE_TABLE: { // create table
       const CreateTable &create_table = sql->sstr.create_table;
       rc = handler_->create_table(current_db, create_table.relation_name, 
-              create_table.attribute_count, create_table.attributes);
+              create_table.attribute_count, create_table.attributes, create_table.durability);
       snprintf(response, sizeof(response), "%s\n", rc == RC::SUCCESS ? "SUCCESS" : "FAILURE");
     }
     break;
@@ -201,8 +429,10 @@ void DefaultStorageStage::handle_event(StageEvent *event) {
     break;
   case SCF_CREATE_INDEX: {
       const CreateIndex &create_index = sql->sstr.create_index;
-      rc = handler_->create_index(current_trx, current_db, create_index.relation_name, 
-                                  create_index.index_name, create_index.attribute_name);
+      rc = handler_->create_index(current_trx, current_db, create_index.relation_name, create_index.index_name,
+                                  create_index.attribute_num, create_index.attribute_names,
+                                  create_index.include_num, create_index.include_names,
+                                  create_index.index_type, create_index.options);
       snprintf(response, sizeof(response), "%s\n", rc == RC::SUCCESS ? "SUCCESS" : "FAILURE");
     }
     break;
@@ -255,11 +485,17 @@ void DefaultStorageStage::handle_event(StageEvent *event) {
       break;
   }
 
-  if (rc == RC::SUCCESS && !session->is_trx_multi_operation_mode()) {
+  if (rc == RC::SUCCESS && !trx_ended && !session->is_trx_multi_operation_mode()) {
     rc = current_trx->commit();
     if (rc != RC::SUCCESS) {
       LOG_ERROR("Failed to commit trx. rc=%d:%s", rc, strrc(rc));
     }
+  } else if (rc != RC::SUCCESS && !trx_ended && !session->is_trx_multi_operation_mode()) {
+    // 语句执行了一半失败(比如更新时遇到写冲突)，撤销已经做过的修改
+    RC rc2 = current_trx->rollback();
+    if (rc2 != RC::SUCCESS) {
+      LOG_ERROR("Failed to rollback trx. rc=%d:%s", rc2, strrc(rc2));
+    }
   }
 
   session_event->set_response(response);
@@ -268,6 +504,31 @@ void DefaultStorageStage::handle_event(StageEvent *event) {
   LOG_TRACE("Exit\n");
 }
 
+RC DefaultStorageStage::execute_dml(Trx *trx, const char *db_name, const Query *sql) {
+  switch (sql->flag) {
+    case SCF_INSERT: {
+      const Inserts &inserts = sql->sstr.insertion;
+      return handler_->insert_record(trx, db_name, inserts.relation_name, inserts.value_num, inserts.values);
+    }
+    case SCF_UPDATE: {
+      const Updates &updates = sql->sstr.update;
+      int updated_count = 0;
+      return handler_->update_record(trx, db_name, updates.relation_name, updates.attribute_name, &updates.value,
+                                     updates.condition_num, updates.conditions, &updated_count);
+    }
+    case SCF_DELETE: {
+      const Deletes &deletes = sql->sstr.deletion;
+      int deleted_count = 0;
+      return handler_->delete_record(trx, db_name, deletes.relation_name, deletes.condition_num, deletes.conditions,
+                                     &deleted_count);
+    }
+    default: {
+      LOG_ERROR("Not a dml. flag=%d", sql->flag);
+      return RC::INVALID_ARGUMENT;
+    }
+  }
+}
+
 void DefaultStorageStage::callback_event(StageEvent *event,
                                         CallbackContext *context) {
   LOG_TRACE("Enter\n");
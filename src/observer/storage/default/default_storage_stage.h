@@ -17,8 +17,11 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/seda/stage.h"
 #include "common/metrics/metrics.h"
+#include "rc.h"
 
 class DefaultHandler;
+class Trx;
+struct Query;
 
 class DefaultStorageStage : public common::Stage {
 public:
@@ -38,6 +41,10 @@ protected:
 
 private:
   std::string load_data(const char *db_name, const char *table_name, const char *file_name);
+  /**
+   * 执行insert、update、delete语句，不提交
+   */
+  RC execute_dml(Trx *trx, const char *db_name, const Query *sql);
 
 protected:
   common::SimpleTimer *query_metric_ = nullptr;
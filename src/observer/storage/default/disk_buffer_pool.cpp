@@ -14,8 +14,10 @@ See the Mulan PSL v2 for more details. */
 #include "disk_buffer_pool.h"
 #include <errno.h>
 #include <string.h>
+#include <algorithm>
 
 #include "common/log/log.h"
+#include "storage/clog/clog.h"
 
 using namespace common;
 
@@ -37,6 +39,7 @@ DiskBufferPool *theGlobalDiskBufferPool()
 // 在disk上allocate Page大小的空间，在Page.data开头填入page_count allocated_pages bitmap这些metadata
 RC DiskBufferPool::create_file(const char *file_name)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   int fd = open(file_name, O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE);
   if (fd < 0) {
     LOG_ERROR("Failed to create %s, due to %s.", file_name, strerror(errno));
@@ -54,11 +57,60 @@ RC DiskBufferPool::create_file(const char *file_name)
     return RC::IOERR_ACCESS;
   }
 
+  RC rc = write_file_header(fd, file_name);
+  close(fd);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  LSN lsn = 0;
+  if (unlogged_files_.count(file_name) == 0) {
+    rc = theGlobalCLogManager()->append(CLogType::FILE_CREATE, 0, nullptr, BP_INVALID_PAGE_NUM, 0,
+                                        file_name, strlen(file_name) + 1, &lsn);
+  }
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to append create log of %s. rc=%d:%s", file_name, rc, strrc(rc));
+    return rc;
+  }
+  LOG_INFO("Successfully create %s.", file_name);
+  return RC::SUCCESS;
+}
+
+void DiskBufferPool::set_file_logged(const char *file_name, bool logged)
+{
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  if (logged) {
+    unlogged_files_.erase(file_name);
+  } else {
+    unlogged_files_.insert(file_name);
+  }
+}
+
+/**
+ * 把文件清空成刚创建时的样子，只有文件头页面。文件已经不存在时不做处理
+ */
+RC DiskBufferPool::redo_create_file(const char *file_name)
+{
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  int fd = open(file_name, O_RDWR | O_TRUNC);
+  if (fd < 0) {
+    LOG_WARN("Failed to open %s to redo create, due to %s.", file_name, strerror(errno));
+    return RC::SUCCESS;
+  }
+  RC rc = write_file_header(fd, file_name);
+  close(fd);
+  return rc;
+}
+
+RC DiskBufferPool::write_file_header(int fd, const char *file_name)
+{
   Page page;
   memset(&page, 0, sizeof(Page));
 
   BPFileSubHeader *fileSubHeader;
   fileSubHeader = (BPFileSubHeader *)page.data;
+  fileSubHeader->magic = BP_FILE_MAGIC;
+  fileSubHeader->version = BP_FILE_VERSION;
   fileSubHeader->allocated_pages = 1;           // file meta-data space
   fileSubHeader->page_count = 1;
 
@@ -66,24 +118,20 @@ RC DiskBufferPool::create_file(const char *file_name)
   bitmap[0] |= 0x01;
   if (lseek(fd, 0, SEEK_SET) == -1) {
     LOG_ERROR("Failed to seek file %s to position 0, due to %s .", file_name, strerror(errno));
-    close(fd);
     return RC::IOERR_SEEK;
   }
 
   if (write(fd, (char *)&page, sizeof(Page)) != sizeof(Page)) {
     LOG_ERROR("Failed to write header to file %s, due to %s.", file_name, strerror(errno));
-    close(fd);
     return RC::IOERR_WRITE;
   }
-
-  close(fd);
-  LOG_INFO("Successfully create %s.", file_name);
   return RC::SUCCESS;
 }
 
 // 打开文件file_name并分配对应file_id，`并将page_num (即page id)为0的Page从file加载进来 [Page 0(header_page)是file的meta-data(见create_file操作)]`
 RC DiskBufferPool::open_file(const char *file_name, int *file_id)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   int fd, i;
   // This part isn't gentle, the better method is using LRU queue.
   for (i = 0; i < MAX_OPEN_FILE; i++) {
@@ -151,6 +199,7 @@ RC DiskBufferPool::open_file(const char *file_name, int *file_id)
   file_handle->file_name = cloned_file_name;
   file_handle->file_desc = fd;
   file_handle->acc_time = current_time();
+  file_handle->unlogged = unlogged_files_.count(file_name) > 0;
   if ((tmp = allocate_block(&file_handle->hdr_frame)) != RC::SUCCESS) {
     LOG_ERROR("Failed to allocate block for %s's BPFileHandle.", file_name);
     delete file_handle;
@@ -168,6 +217,17 @@ RC DiskBufferPool::open_file(const char *file_name, int *file_id)
     delete file_handle;
     return tmp;
   }
+  const BPFileSubHeader *sub_header = (const BPFileSubHeader *)file_handle->hdr_frame->page.data;
+  if (sub_header->magic != BP_FILE_MAGIC || sub_header->version != BP_FILE_VERSION) {
+    // 旧版本的页面没有LSN，数据区的位置和大小都不一样，不能按现在的格式读
+    LOG_ERROR("Failed to open %s, unsupported file format. magic=%x, version=%d, expect magic=%x, version=%d",
+              file_name, sub_header->magic, sub_header->version, BP_FILE_MAGIC, BP_FILE_VERSION);
+    file_handle->hdr_frame->pin_count = 0;
+    dispose_block(file_handle->hdr_frame);
+    close(fd);
+    delete file_handle;
+    return RC::NOTADB;
+  }
 
   file_handle->hdr_page = &(file_handle->hdr_frame->page);
   file_handle->bitmap = file_handle->hdr_page->data + BP_FILE_SUB_HDR_SIZE;
@@ -180,6 +240,7 @@ RC DiskBufferPool::open_file(const char *file_name, int *file_id)
 
 RC DiskBufferPool::close_file(int file_id)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC tmp;
   if ((tmp = check_file_id(file_id)) != RC::SUCCESS) {
     LOG_ERROR("Failed to close file, due to invalid fileId %d", file_id);
@@ -199,14 +260,15 @@ RC DiskBufferPool::close_file(int file_id)
     return RC::IOERR_CLOSE;
   }
   open_list_[file_id] = nullptr;
-  delete (file_handle);
   LOG_INFO("Successfully close file %d:%s.", file_id, file_handle->file_name);
+  delete (file_handle);
   return RC::SUCCESS;
 }
 
 // 根据文件ID和页号获取指定页面到缓冲区(内存)Frame中，已经在了page_handle meta-data更新，不存在则找一个Frame载入Page
 RC DiskBufferPool::get_this_page(int file_id, PageNum page_num, BPPageHandle *page_handle)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC tmp;
   if ((tmp = check_file_id(file_id)) != RC::SUCCESS) {
     LOG_ERROR("Failed to load page %d, due to invalid fileId %d", page_num, file_id);
@@ -264,6 +326,7 @@ RC DiskBufferPool::get_this_page(int file_id, PageNum page_num, BPPageHandle *pa
 // 最终这个新分配的页会`被打开`，分配到frame
 RC DiskBufferPool::allocate_page(int file_id, BPPageHandle *page_handle)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC tmp;
   if ((tmp = check_file_id(file_id)) != RC::SUCCESS) {
     LOG_ERROR("Failed to alloc page, due to invalid fileId %d", file_id);
@@ -282,6 +345,10 @@ RC DiskBufferPool::allocate_page(int file_id, BPPageHandle *page_handle)
       if (((file_handle->bitmap[byte]) & (1 << bit)) == 0) {
         (file_handle->file_sub_header->allocated_pages)++;
         file_handle->bitmap[byte] |= (1 << bit);
+        set_dirty(file_handle->hdr_frame);
+        if ((tmp = append_file_log(file_handle, CLogType::PAGE_ALLOCATE, i)) != RC::SUCCESS) {
+          return tmp;
+        }
         return get_this_page(file_id, i, page_handle);  // 把file_id中的page_num为i的页加载到buffer pool中
       }
     }
@@ -299,7 +366,10 @@ RC DiskBufferPool::allocate_page(int file_id, BPPageHandle *page_handle)
   byte = page_num / 8;
   bit = page_num % 8;
   file_handle->bitmap[byte] |= (1 << bit);
-  file_handle->hdr_frame->dirty = true;
+  set_dirty(file_handle->hdr_frame);
+  if ((tmp = append_file_log(file_handle, CLogType::PAGE_ALLOCATE, page_num)) != RC::SUCCESS) {
+    return tmp;
+  }
 
   page_handle->frame->dirty = false;
   page_handle->frame->file_desc = file_handle->file_desc;
@@ -336,12 +406,74 @@ RC DiskBufferPool::get_data(BPPageHandle *page_handle, char **data)
 
 RC DiskBufferPool::mark_dirty(BPPageHandle *page_handle)
 {
-  page_handle->frame->dirty = true;
+  set_dirty(page_handle->frame);
+  return RC::SUCCESS;
+}
+
+// 页面从干净变脏时记下当前日志的位置，要在追加这次修改的日志之前调用
+void DiskBufferPool::set_dirty(Frame *frame)
+{
+  if (frame->dirty) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  if (!frame->dirty) {
+    frame->rec_lsn = theGlobalCLogManager()->current_lsn();
+    frame->dirty = true;
+  }
+}
+
+RC DiskBufferPool::append_log(int file_id, BPPageHandle *page_handle, CLogType type, int offset,
+                               const char *data, int length)
+{
+  CLogManager *clog_manager = theGlobalCLogManager();
+  if (!clog_manager->enabled()) {
+    set_dirty(page_handle->frame);
+    return RC::SUCCESS;
+  }
+
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  RC rc = check_file_id(file_id);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  Frame *frame = page_handle->frame;
+  set_dirty(frame);
+  if (open_list_[file_id]->unlogged) {
+    return RC::SUCCESS;
+  }
+  LSN lsn = 0;
+  rc = clog_manager->append(type, 0, open_list_[file_id]->file_name, frame->page.page_num, offset, data, length, &lsn);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to append log of page %s:%d. rc=%d:%s",
+              open_list_[file_id]->file_name, frame->page.page_num, rc, strrc(rc));
+    return rc;
+  }
+  frame->page.lsn = lsn;
+  return RC::SUCCESS;
+}
+
+// 页面的分配信息在文件头页面上，日志也记到文件头页面上
+RC DiskBufferPool::append_file_log(BPFileHandle *file_handle, CLogType type, PageNum page_num)
+{
+  CLogManager *clog_manager = theGlobalCLogManager();
+  if (!clog_manager->enabled() || file_handle->unlogged) {
+    return RC::SUCCESS;
+  }
+  LSN lsn = 0;
+  RC rc = clog_manager->append(type, 0, file_handle->file_name, page_num, 0, nullptr, 0, &lsn);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to append %s log of page %s:%d. rc=%d:%s",
+              clog_type_name(type), file_handle->file_name, page_num, rc, strrc(rc));
+    return rc;
+  }
+  file_handle->hdr_frame->page.lsn = lsn;
   return RC::SUCCESS;
 }
 
 RC DiskBufferPool::unpin_page(BPPageHandle *page_handle)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   page_handle->open = false;
   page_handle->frame->pin_count--;
   return RC::SUCCESS;
@@ -357,6 +489,7 @@ RC DiskBufferPool::unpin_page(BPPageHandle *page_handle)
 // 在内存中释放Page占有的Frame的使用权并标记赃页，在下次allocate_block这个frame时会刷回旧Page内容
 RC DiskBufferPool::dispose_page(int file_id, PageNum page_num)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC rc;
   if ((rc = check_file_id(file_id)) != RC::SUCCESS) {
     LOG_ERROR("Failed to alloc page, due to invalid fileId %d", file_id);
@@ -383,16 +516,107 @@ RC DiskBufferPool::dispose_page(int file_id, PageNum page_num)
     }
   }
 
-  file_handle->hdr_frame->dirty = true;
+  set_dirty(file_handle->hdr_frame);
   file_handle->file_sub_header->allocated_pages--;
   // file_handle->pFileSubHeader->pageCount--;
   char tmp = 1 << (page_num % 8);
   file_handle->bitmap[page_num / 8] &= ~tmp;
+  return append_file_log(file_handle, CLogType::PAGE_DISPOSE, page_num);
+}
+
+/**
+ * 崩溃时文件头页面可能还没有写回，日志中分配的页面超出了文件的长度时先扩展文件。
+ * 已经在文件中的页面不动，上面的内容由后面的日志重做
+ */
+RC DiskBufferPool::redo_allocate_page(int file_id, PageNum page_num, LSN lsn)
+{
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  RC rc;
+  if ((rc = check_file_id(file_id)) != RC::SUCCESS) {
+    return rc;
+  }
+
+  BPFileHandle *file_handle = open_list_[file_id];
+  if (page_num <= 0 || page_num >= (int)((BP_PAGE_DATA_SIZE - BP_FILE_SUB_HDR_SIZE) * 8)) {
+    LOG_ERROR("Invalid page num %d to redo allocate of %s.", page_num, file_handle->file_name);
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+
+  struct stat st;
+  if (fstat(file_handle->file_desc, &st) < 0) {
+    LOG_ERROR("Failed to stat %s, due to %s.", file_handle->file_name, strerror(errno));
+    return RC::IOERR_FSTAT;
+  }
+  Page page;
+  memset(&page, 0, sizeof(Page));
+  for (PageNum i = st.st_size / sizeof(Page); i <= page_num; i++) {
+    page.page_num = i;
+    if (pwrite(file_handle->file_desc, &page, sizeof(Page), (s64_t)i * sizeof(Page)) != sizeof(Page)) {
+      LOG_ERROR("Failed to extend %s to page %d, due to %s.", file_handle->file_name, i, strerror(errno));
+      return RC::IOERR_WRITE;
+    }
+  }
+
+  // 文件总是扩展到这个页面，位图已经包含这次分配时不再修改
+  if (file_handle->hdr_frame->page.lsn >= lsn) {
+    return RC::SUCCESS;
+  }
+  BPFileSubHeader *sub_header = file_handle->file_sub_header;
+  if (sub_header->page_count <= page_num) {
+    sub_header->page_count = page_num + 1;
+  }
+  if ((file_handle->bitmap[page_num / 8] & (1 << (page_num % 8))) == 0) {
+    file_handle->bitmap[page_num / 8] |= (1 << (page_num % 8));
+    sub_header->allocated_pages++;
+  }
+  file_handle->hdr_frame->page.lsn = lsn;
+  set_dirty(file_handle->hdr_frame);
   return RC::SUCCESS;
 }
 
+RC DiskBufferPool::redo_dispose_page(int file_id, PageNum page_num, LSN lsn)
+{
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  RC rc;
+  if ((rc = check_file_id(file_id)) != RC::SUCCESS) {
+    return rc;
+  }
+
+  BPFileHandle *file_handle = open_list_[file_id];
+  if (file_handle->hdr_frame->page.lsn >= lsn ||
+      page_num >= file_handle->file_sub_header->page_count ||
+      (file_handle->bitmap[page_num / 8] & (1 << (page_num % 8))) == 0) {
+    return RC::SUCCESS;  // 已经释放过了
+  }
+  rc = dispose_page(file_id, page_num);
+  if (rc == RC::SUCCESS) {
+    file_handle->hdr_frame->page.lsn = lsn;
+  }
+  return rc;
+}
+
+RC DiskBufferPool::redo_write_page(int file_id, PageNum page_num, int offset, const char *data, int length, LSN lsn)
+{
+  if (offset < 0 || length < 0 || offset + length > (int)BP_PAGE_DATA_SIZE) {
+    LOG_ERROR("Invalid range to redo write page %d. offset=%d, length=%d", page_num, offset, length);
+    return RC::INVALID_ARGUMENT;
+  }
+  BPPageHandle page_handle;
+  RC rc = get_this_page(file_id, page_num, &page_handle);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+  if (page_handle.frame->page.lsn < lsn) {
+    memcpy(page_handle.frame->page.data + offset, data, length);
+    page_handle.frame->page.lsn = lsn;
+    set_dirty(page_handle.frame);
+  }
+  return unpin_page(&page_handle);
+}
+
 RC DiskBufferPool::force_page(int file_id, PageNum page_num)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC rc;
   if ((rc = check_file_id(file_id)) != RC::SUCCESS) {
     LOG_ERROR("Failed to alloc page, due to invalid fileId %d", file_id);
@@ -443,6 +667,7 @@ RC DiskBufferPool::force_page(BPFileHandle *file_handle, PageNum page_num)
 
 RC DiskBufferPool::flush_all_pages(int file_id)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC rc = check_file_id(file_id);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to flush pages due to invalid file_id %d", file_id);
@@ -453,6 +678,92 @@ RC DiskBufferPool::flush_all_pages(int file_id)
   return force_all_pages(file_handle);
 }
 
+void DiskBufferPool::dirty_page_table(LSN lsn, std::vector<DirtyPage> &pages)
+{
+  pages.clear();
+  {
+    std::lock_guard<std::recursive_mutex> guard(lock_);
+    for (int i = 0; i < BP_BUFFER_SIZE; i++) {
+      const Frame &frame = bp_manager_.frame[i];
+      if (bp_manager_.allocated[i] && frame.dirty && frame.rec_lsn < lsn) {
+        pages.push_back(DirtyPage{frame.file_desc, frame.page.page_num, frame.rec_lsn});
+      }
+    }
+  }
+  // 按文件中的位置顺序写回
+  std::sort(pages.begin(), pages.end(), [](const DirtyPage &a, const DirtyPage &b) {
+    return a.file_desc != b.file_desc ? a.file_desc < b.file_desc : a.page_num < b.page_num;
+  });
+}
+
+RC DiskBufferPool::flush_dirty_pages(const std::vector<DirtyPage> &pages, DirtyPageBatch &batch)
+{
+  batch.flushed = 0;
+  batch.sync_lsn = 0;
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  const unsigned long begin = current_time();
+  for (; batch.next < pages.size() && batch.flushed < batch.max_pages; batch.next++) {
+    if (batch.max_pause > 0 && batch.flushed > 0 && current_time() - begin >= (unsigned long)batch.max_pause * 1000) {
+      break;
+    }
+    const DirtyPage &page = pages[batch.next];
+    for (int i = 0; i < BP_BUFFER_SIZE; i++) {
+      Frame *frame = &bp_manager_.frame[i];
+      if (!bp_manager_.allocated[i] || frame->file_desc != page.file_desc || frame->page.page_num != page.page_num) {
+        continue;
+      }
+      // 被换出时已经写回过，之后重新变脏的页面上只有检查点之后的修改
+      if (!frame->dirty || frame->rec_lsn >= batch.lsn) {
+        break;
+      }
+      if (frame->page.lsn > batch.durable_lsn) {
+        batch.sync_lsn = frame->page.lsn;
+        return RC::SUCCESS;
+      }
+      RC rc = flush_block(frame);
+      if (rc != RC::SUCCESS) {
+        LOG_ERROR("Failed to flush dirty page %d of %d.", page.page_num, page.file_desc);
+        return rc;
+      }
+      batch.flushed++;
+      break;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::sync_files()
+{
+  // 复制一份文件描述符，落盘期间其它线程可以继续使用缓冲池，文件被关闭也不影响
+  std::vector<int> fds;
+  {
+    std::lock_guard<std::recursive_mutex> guard(lock_);
+    for (int i = 0; i < MAX_OPEN_FILE; i++) {
+      if (open_list_[i] == nullptr) {
+        continue;
+      }
+      int fd = dup(open_list_[i]->file_desc);
+      if (fd < 0) {
+        LOG_ERROR("Failed to dup %s, due to %s.", open_list_[i]->file_name, strerror(errno));
+        for (int opened : fds) {
+          close(opened);
+        }
+        return RC::IOERR_FSYNC;
+      }
+      fds.push_back(fd);
+    }
+  }
+  RC rc = RC::SUCCESS;
+  for (int fd : fds) {
+    if (rc == RC::SUCCESS && fsync(fd) != 0) {
+      LOG_ERROR("Failed to sync file %d, due to %s.", fd, strerror(errno));
+      rc = RC::IOERR_FSYNC;
+    }
+    close(fd);
+  }
+  return rc;
+}
+
 RC DiskBufferPool::force_all_pages(BPFileHandle *file_handle)
 {
 
@@ -470,8 +781,23 @@ RC DiskBufferPool::force_all_pages(BPFileHandle *file_handle)
         return rc;
       }
     }
-    bp_manager_.allocated[i] = false;
+    // 其它线程还在使用的页面只刷盘，不释放frame
+    if (bp_manager_.frame[i].pin_count == 0) {
+      bp_manager_.allocated[i] = false;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::read_file(int fd, off_t offset, char *buf, size_t size, size_t *read_size)
+{
+  std::lock_guard<std::recursive_mutex> guard(lock_);
+  ssize_t ret = pread(fd, buf, size, offset);
+  if (ret < 0) {
+    LOG_ERROR("Failed to read file %d at %lld, due to %s.", fd, (long long)offset, strerror(errno));
+    return RC::IOERR_READ;
   }
+  *read_size = ret;
   return RC::SUCCESS;
 }
 
@@ -481,6 +807,16 @@ RC DiskBufferPool::flush_block(Frame *frame)
   // The better way is use mmap the block into memory,
   // so it is easier to flush data to file.
 
+  // WAL: 页面上的修改对应的日志先落盘
+  if (frame->page.lsn > 0) {
+    RC rc = theGlobalCLogManager()->sync(frame->page.lsn);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to sync log before flushing page %d of %d. rc=%d:%s",
+                frame->page.page_num, frame->file_desc, rc, strrc(rc));
+      return rc;
+    }
+  }
+
   s64_t offset = ((s64_t)frame->page.page_num) * sizeof(Page);
   if (lseek(frame->file_desc, offset, SEEK_SET) == offset - 1) {
     LOG_ERROR("Failed to flush page %lld of %d due to failed to seek %s.", offset, frame->file_desc, strerror(errno));
@@ -582,6 +918,7 @@ RC DiskBufferPool::check_file_id(int file_id)
 
 RC DiskBufferPool::get_page_count(int file_id, int *page_count)
 {
+  std::lock_guard<std::recursive_mutex> guard(lock_);
   RC rc = RC::SUCCESS;
   if ((rc = check_file_id(file_id)) != RC::SUCCESS) {
     return rc;
@@ -18,33 +18,45 @@ See the Mulan PSL v2 for more details. */
 #include <stdio.h>
 #include <sys/types.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
 
+#include <mutex>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "rc.h"
 
 typedef int PageNum;
+typedef int64_t LSN;      // redo日志的位置，参考CLogManager
+
+enum class CLogType : int;
 
 //
 #define BP_INVALID_PAGE_NUM (-1)
 #define BP_PAGE_SIZE (1 << 12)
-#define BP_PAGE_DATA_SIZE (BP_PAGE_SIZE - sizeof(PageNum))
+#define BP_PAGE_DATA_SIZE (BP_PAGE_SIZE - sizeof(LSN) - sizeof(PageNum))
 #define BP_FILE_SUB_HDR_SIZE (sizeof(BPFileSubHeader))
 #define BP_BUFFER_SIZE 50
+#define BP_FILE_MAGIC 0x4D4E4442      // "MNDB"
+#define BP_FILE_VERSION 2             // 页面开头加了LSN，和版本1(没有文件头标识)的文件不兼容
 #define MAX_OPEN_FILE 1024
 
 // size of Page = 4096 bytes = 4KB
 typedef struct {
+  LSN lsn;                  // 最后一次修改这个页面的日志，写回之前这条日志要先落盘。重放日志时跳过不大于它的日志，0表示没有日志
   PageNum page_num;
   char data[BP_PAGE_DATA_SIZE];
 } Page;
 // sizeof(Page) should be equal to BP_PAGE_SIZE
 
 typedef struct {
+  uint32_t magic;           // BP_FILE_MAGIC，打开文件时检查，拒绝打开旧格式或者不是数据库的文件
+  int version;              // BP_FILE_VERSION
   PageNum page_count;       // 该数据库文件能分配已经开垦的Frame
   int allocated_pages;      // 该文件已经把开垦的Frame用给多少个Page了 (内存中正在使用的Page数)
 } BPFileSubHeader;
@@ -54,9 +66,32 @@ typedef struct {
   unsigned int pin_count;   // 多少线程占用
   unsigned long acc_time;   // 最近访问时间
   int file_desc;            // 打开文件时系统分配的文件描述符
+  LSN rec_lsn;              // 从干净变脏时日志的位置(recovery LSN)，还没有写回的修改的日志都在它之后
   Page page;
 } Frame;
 
+/**
+ * 脏页表中的一项，参考DiskBufferPool::dirty_page_table
+ */
+struct DirtyPage {
+  int file_desc;
+  PageNum page_num;
+  LSN rec_lsn;
+};
+
+/**
+ * 检查点分批写回脏页的参数和进度，参考DiskBufferPool::flush_dirty_pages
+ */
+struct DirtyPageBatch {
+  LSN lsn = 0;            // 只写回rec_lsn小于它的脏页
+  LSN durable_lsn = 0;    // 已经落盘的日志位置
+  int max_pages = 0;      // 这一批最多写回的页面数
+  int max_pause = 0;      // 这一批最多持有缓冲池的锁多少微秒，0表示不限制
+  size_t next = 0;        // 下一个要写回的页面
+  int flushed = 0;        // 这一批写回的页面数
+  LSN sync_lsn = 0;       // 不为0时要先让日志落盘到这个位置，再从next继续
+};
+
 typedef struct {
   bool open;        // 该Page是否打开可用
   Frame *frame;     // 给该Page分配的frame
@@ -77,6 +112,7 @@ public:
   Page *hdr_page;           // header_page (meta-data of the file)
   char *bitmap;     // 管理pages在file中的布局 根据page_num查找到page定位
   BPFileSubHeader *file_sub_header;
+  bool unlogged;            // 文件上的修改不记redo日志
 } ;
 
 class BPManager {
@@ -135,6 +171,12 @@ public:
    */
   RC close_file(int file_id);
 
+  /**
+   * 设置文件上的修改是否记redo日志，在创建和打开文件之前调用。
+   * 不记日志的文件在崩溃之后内容不完整，由使用者清空，参考Table::open
+   */
+  void set_file_logged(const char *file_name, bool logged);
+
   /**
    * 根据文件ID和页号获取指定页面到缓冲区，返回页面句柄指针。
    * @return
@@ -176,6 +218,21 @@ public:
    */
   RC mark_dirty(BPPageHandle *page_handle);
 
+  /**
+   * 为页面上的修改追加一条redo日志，并把页面标记为脏页。没有打开日志或者文件不记日志时只标记脏页。
+   * 页面写回之前会先等这条日志落盘
+   */
+  RC append_log(int file_id, BPPageHandle *page_handle, CLogType type, int offset, const char *data, int length);
+
+  /**
+   * 重放日志时使用。lsn是日志的位置，页面上的LSN不小于它时说明修改已经在页面上了，不再重放。
+   * 不同的页面可以由多个线程同时重放
+   */
+  RC redo_create_file(const char *file_name);
+  RC redo_allocate_page(int file_id, PageNum page_num, LSN lsn);
+  RC redo_dispose_page(int file_id, PageNum page_num, LSN lsn);
+  RC redo_write_page(int file_id, PageNum page_num, int offset, const char *data, int length, LSN lsn);
+
   /**
    * 此函数用于解除pageHandle对应页面的驻留缓冲区限制。
    * 在调用GetThisPage或AllocatePage函数将一个页面读入缓冲区后，
@@ -191,6 +248,31 @@ public:
 
   RC flush_all_pages(int file_id);
 
+  /**
+   * 取rec_lsn小于lsn的脏页，按(文件, 页号)排序。检查点只需要写回这些页面，
+   * 之后才变脏的页面上的修改都在检查点之后的日志中
+   */
+  void dirty_page_table(LSN lsn, std::vector<DirtyPage> &pages);
+
+  /**
+   * 从pages[batch.next]开始写回rec_lsn仍然小于batch.lsn的脏页，已经被写回的跳过，不释放frame。
+   * 写满max_pages个页面或者持有缓冲池的锁超过max_pause时返回。
+   * 页面上的修改的日志还没有落盘(LSN大于durable_lsn)时也返回，由调用者在锁外等日志落盘后再继续，
+   * 前台等待缓冲池的时间一般不超过max_pause加上写一个页面的时间
+   */
+  RC flush_dirty_pages(const std::vector<DirtyPage> &pages, DirtyPageBatch &batch);
+
+  /**
+   * 把所有打开的文件落盘，不持有缓冲池的锁
+   */
+  RC sync_files();
+
+  /**
+   * 在缓冲池的锁里从文件的offset处读最多size字节，返回实际读到的字节数。
+   * 页面都在这个锁里写回，读到的不会是写了一半的页面。在线备份使用，size决定了前台最多等待多久
+   */
+  RC read_file(int fd, off_t offset, char *buf, size_t size, size_t *read_size);
+
 protected:
   RC allocate_block(Frame **buf);
   RC dispose_block(Frame *buf);
@@ -206,10 +288,15 @@ protected:
   RC check_page_num(PageNum page_num, BPFileHandle *file_handle);
   RC load_page(PageNum page_num, BPFileHandle *file_handle, Frame *frame);
   RC flush_block(Frame *frame);
+  void set_dirty(Frame *frame);
+  RC append_file_log(BPFileHandle *file_handle, CLogType type, PageNum page_num);
+  RC write_file_header(int fd, const char *file_name);
 
 private:
+  std::recursive_mutex lock_;   // 保护frame分配、pin计数以及文件元数据，页面内容的并发由使用者自己控制
   BPManager bp_manager_;        // 有frames数组(实际可操作的buffer pool空间)
   BPFileHandle *open_list_[MAX_OPEN_FILE] = {nullptr};  // 已打开文件file_id对应的open_list_[file_id]不为空 指向一个BPFileHandle
+  std::unordered_set<std::string> unlogged_files_;      // 不记redo日志的文件
 };
 
 DiskBufferPool *theGlobalDiskBufferPool();
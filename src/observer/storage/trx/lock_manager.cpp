@@ -0,0 +1,329 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <chrono>
+#include <unordered_set>
+
+#include "storage/trx/lock_manager.h"
+#include "common/log/log.h"
+
+static const uint64_t OWNER_MASK = 0x7FFFFFFFULL;
+static const int      FINGERPRINT_SHIFT = 31;
+static const uint64_t FINGERPRINT_MASK = 0xFFFFULL << FINGERPRINT_SHIFT;
+static const int      QUEUE_COUNT_SHIFT = 47;
+static const uint64_t QUEUE_COUNT_ONE = 1ULL << QUEUE_COUNT_SHIFT;
+static const uint64_t QUEUE_COUNT_MASK = 0xFFFFULL << QUEUE_COUNT_SHIFT;
+static const uint64_t WAITERS_BIT = 1ULL << 63;
+
+// 兼容矩阵，按IS, IX, S, X的顺序
+static const bool LOCK_COMPATIBLE[4][4] = {
+    {true,  true,  true,  false},
+    {true,  true,  false, false},
+    {true,  false, true,  false},
+    {false, false, false, false},
+};
+
+// held是否包含request: X包含所有的模式，S和IX都包含IS
+static bool lock_covers(LockMode held, LockMode request) {
+  return held == request || held == LockMode::X || request == LockMode::IS;
+}
+
+static uint8_t mode_bit(LockMode mode) {
+  return (uint8_t)(1 << (int)mode);
+}
+
+static uint64_t fingerprint_of(uint64_t hash) {
+  return ((hash >> 32) << FINGERPRINT_SHIFT) & FINGERPRINT_MASK;
+}
+
+static uint64_t fast_word(int32_t trx_id, uint64_t hash) {
+  return fingerprint_of(hash) | ((uint64_t)trx_id & OWNER_MASK);
+}
+
+static uint64_t hash_lock_id(const LockId &id) {
+  // 64位的混合，低位用于选择槽，高32位用于指纹
+  uint64_t hash = (uint64_t)(uintptr_t)id.table;
+  hash ^= ((uint64_t)(uint32_t)id.rid.page_num << 32) | (uint32_t)id.rid.slot_num;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+LockOptions &LockOptions::instance() {
+  static LockOptions options;
+  return options;
+}
+
+LockId LockId::table_lock(Table *table) {
+  LockId id;
+  id.table = table;
+  id.rid.page_num = -1;
+  id.rid.slot_num = -1;
+  return id;
+}
+
+LockId LockId::record_lock(Table *table, const RID &rid) {
+  LockId id;
+  id.table = table;
+  id.rid = rid;
+  return id;
+}
+
+size_t LockIdHasher::operator()(const LockId &id) const {
+  return hash_lock_id(id);
+}
+
+bool LockSet::holds(const LockId &id, LockMode mode) const {
+  auto iter = locks_.find(id);
+  if (iter == locks_.end()) {
+    return false;
+  }
+  for (int i = 0; i <= (int)LockMode::X; i++) {
+    if ((iter->second.modes & (1 << i)) && lock_covers((LockMode)i, mode)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+LockManager *theGlobalLockManager() {
+  static LockManager *instance = new LockManager();
+  return instance;
+}
+
+LockManager::LockManager() : slots_(new std::atomic<uint64_t>[SLOT_NUM]) {
+  for (size_t i = 0; i < SLOT_NUM; i++) {
+    slots_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+RC LockManager::lock(int32_t trx_id, LockSet &lock_set, const LockId &id, LockMode mode) {
+  if (lock_set.holds(id, mode)) {
+    return RC::SUCCESS;
+  }
+
+  const uint64_t hash = hash_lock_id(id);
+  if (mode == LockMode::X && !id.is_table_lock() && lock_set.locks_.find(id) == lock_set.locks_.end()) {
+    // 槽是空的: 没有其它事务持有这个槽上的锁，也没有排队的锁
+    uint64_t expected = 0;
+    if (slot(hash).compare_exchange_strong(expected, fast_word(trx_id, hash), std::memory_order_acquire)) {
+      lock_set.locks_[id] = LockSet::HeldLock{mode_bit(mode), true};
+      return RC::SUCCESS;
+    }
+  }
+  return lock_slow(trx_id, lock_set, id, mode, hash);
+}
+
+RC LockManager::lock_slow(int32_t trx_id, LockSet &lock_set, const LockId &id, LockMode mode, uint64_t hash) {
+  Partition &part = partition(hash);
+  std::unique_lock<std::mutex> lock(part.lock);
+
+  // 队列中的元素在其它事务插入新队列时不会移动，可以在等待期间一直引用
+  auto queue_iter = part.queues.find(id);
+  if (queue_iter == part.queues.end()) {
+    queue_iter = part.queues.emplace(id, LockQueue()).first;
+    slot(hash).fetch_add(QUEUE_COUNT_ONE, std::memory_order_acq_rel);
+  }
+  LockQueue &queue = queue_iter->second;
+  queue.requests.push_back(LockRequest{trx_id, mode, false});
+  auto request = std::prev(queue.requests.end());
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(LockOptions::instance().wait_timeout);
+  RC rc = RC::SUCCESS;
+  bool waited = false;
+  std::vector<int32_t> blockers;
+  while (true) {
+    find_blockers(trx_id, queue, request, hash, blockers);
+    if (blockers.empty()) {
+      request->granted = true;
+      break;
+    }
+    if (!waited) {
+      waited = true;
+      waits_++;
+    }
+    if (would_deadlock(trx_id, blockers)) {
+      LOG_INFO("Deadlock detected, give up the lock request. trx id=%d, rid=%d.%d, mode=%d",
+               trx_id, id.rid.page_num, id.rid.slot_num, (int)mode);
+      deadlocks_++;
+      rc = RC::LOCKED_DEADLOCK;
+      break;
+    }
+    if (part.cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+      find_blockers(trx_id, queue, request, hash, blockers);
+      if (blockers.empty()) {
+        request->granted = true;
+        break;
+      }
+      LOG_INFO("Lock wait timeout. trx id=%d, rid=%d.%d, mode=%d", trx_id, id.rid.page_num, id.rid.slot_num, (int)mode);
+      timeouts_++;
+      rc = RC::BUSY_TIMEOUT;
+      break;
+    }
+  }
+  if (waited) {
+    clear_wait(trx_id);
+  }
+
+  if (rc != RC::SUCCESS) {
+    queue.requests.erase(request);
+    if (queue.requests.empty()) {
+      part.queues.erase(id);
+      slot(hash).fetch_sub(QUEUE_COUNT_ONE, std::memory_order_acq_rel);
+    }
+    // 排在后面的请求可能不用再等这个请求了
+    part.cond.notify_all();
+    return rc;
+  }
+
+  slow_acquires_++;
+  LockSet::HeldLock &held = lock_set.locks_[id];
+  held.modes |= mode_bit(mode);
+  return RC::SUCCESS;
+}
+
+void LockManager::find_blockers(int32_t trx_id, LockQueue &queue, std::list<LockRequest>::iterator request,
+                                uint64_t hash, std::vector<int32_t> &blockers) {
+  blockers.clear();
+
+  // 快速路径持有的锁，指纹相同时可能就是这个锁
+  std::atomic<uint64_t> &lock_slot = slot(hash);
+  uint64_t word = lock_slot.load(std::memory_order_acquire);
+  while (true) {
+    const int32_t owner = (int32_t)(word & OWNER_MASK);
+    if (owner == 0 || owner == trx_id || (word & FINGERPRINT_MASK) != fingerprint_of(hash)) {
+      break;
+    }
+    // 持有者释放时看到等待标记，会在分区锁内清除槽并唤醒等待者
+    if ((word & WAITERS_BIT) || lock_slot.compare_exchange_weak(word, word | WAITERS_BIT, std::memory_order_acq_rel)) {
+      blockers.push_back(owner);
+      break;
+    }
+  }
+
+  // 已经持有这个锁(升级)时只和已经授予的锁比较，否则按FIFO的顺序还要和排在前面的请求比较
+  bool upgrade = false;
+  for (const LockRequest &other : queue.requests) {
+    if (other.trx_id == trx_id && other.granted) {
+      upgrade = true;
+      break;
+    }
+  }
+  bool before_request = true;
+  for (auto iter = queue.requests.begin(); iter != queue.requests.end(); ++iter) {
+    if (iter == request) {
+      before_request = false;
+      continue;
+    }
+    if (iter->trx_id == trx_id) {
+      continue;
+    }
+    if (!iter->granted && (!before_request || upgrade)) {
+      continue;
+    }
+    if (!LOCK_COMPATIBLE[(int)iter->mode][(int)request->mode]) {
+      blockers.push_back(iter->trx_id);
+    }
+  }
+}
+
+bool LockManager::would_deadlock(int32_t trx_id, const std::vector<int32_t> &blockers) {
+  std::lock_guard<std::mutex> guard(graph_lock_);
+  waits_for_[trx_id] = blockers;
+
+  // 从等待的事务出发沿着等待图走，能回到自己就是死锁
+  std::vector<int32_t> stack(blockers.begin(), blockers.end());
+  std::unordered_set<int32_t> visited;
+  while (!stack.empty()) {
+    const int32_t current = stack.back();
+    stack.pop_back();
+    if (current == trx_id) {
+      waits_for_.erase(trx_id);
+      return true;
+    }
+    if (!visited.insert(current).second) {
+      continue;
+    }
+    auto iter = waits_for_.find(current);
+    if (iter != waits_for_.end()) {
+      stack.insert(stack.end(), iter->second.begin(), iter->second.end());
+    }
+  }
+  return false;
+}
+
+void LockManager::clear_wait(int32_t trx_id) {
+  std::lock_guard<std::mutex> guard(graph_lock_);
+  waits_for_.erase(trx_id);
+}
+
+void LockManager::unlock_all(int32_t trx_id, LockSet &lock_set) {
+  for (const auto &iter : lock_set.locks_) {
+    const uint64_t hash = hash_lock_id(iter.first);
+    if (iter.second.fast) {
+      unlock_fast(trx_id, hash);
+    } else {
+      unlock_slow(trx_id, iter.first, hash);
+    }
+  }
+  lock_set.locks_.clear();
+}
+
+void LockManager::unlock_fast(int32_t trx_id, uint64_t hash) {
+  uint64_t expected = fast_word(trx_id, hash);
+  if (slot(hash).compare_exchange_strong(expected, 0, std::memory_order_release)) {
+    return;
+  }
+
+  // 有等待者，或者槽上有其它锁的队列。槽上的等待标记和队列计数只在分区锁内修改
+  Partition &part = partition(hash);
+  std::lock_guard<std::mutex> guard(part.lock);
+  slot(hash).fetch_and(QUEUE_COUNT_MASK, std::memory_order_acq_rel);
+  part.cond.notify_all();
+}
+
+void LockManager::unlock_slow(int32_t trx_id, const LockId &id, uint64_t hash) {
+  Partition &part = partition(hash);
+  std::lock_guard<std::mutex> guard(part.lock);
+  auto queue_iter = part.queues.find(id);
+  if (queue_iter == part.queues.end()) {
+    LOG_WARN("Lock queue does not exist. trx id=%d, rid=%d.%d", trx_id, id.rid.page_num, id.rid.slot_num);
+    return;
+  }
+  std::list<LockRequest> &requests = queue_iter->second.requests;
+  for (auto iter = requests.begin(); iter != requests.end(); ) {
+    if (iter->trx_id == trx_id) {
+      iter = requests.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  if (requests.empty()) {
+    part.queues.erase(queue_iter);
+    slot(hash).fetch_sub(QUEUE_COUNT_ONE, std::memory_order_acq_rel);
+  }
+  part.cond.notify_all();
+}
+
+LockStats LockManager::stats() {
+  LockStats stats;
+  stats.slow_acquires = slow_acquires_.load();
+  stats.waits = waits_.load();
+  stats.deadlocks = deadlocks_.load();
+  stats.timeouts = timeouts_.load();
+  return stats;
+}
@@ -0,0 +1,176 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_TRX_LOCK_MANAGER_H_
+#define __OBSERVER_STORAGE_TRX_LOCK_MANAGER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "rc.h"
+#include "storage/common/record_manager.h"
+
+class Table;
+
+struct LockOptions {
+  int wait_timeout = 1000;   // 等待锁的最长时间(毫秒)，超时后返回RC::BUSY_TIMEOUT
+
+  static LockOptions &instance();
+};
+
+/**
+ * 表上的意向锁(IS, IX)和表锁(S, X)，记录上的共享锁(S)和排他锁(X)
+ */
+enum class LockMode : int {
+  IS,
+  IX,
+  S,
+  X,
+};
+
+struct LockId {
+  Table *table;
+  RID    rid;   // 表锁的page_num和slot_num都是-1
+
+  static LockId table_lock(Table *table);
+  static LockId record_lock(Table *table, const RID &rid);
+
+  bool is_table_lock() const {
+    return rid.page_num == -1;
+  }
+  bool operator==(const LockId &other) const {
+    return table == other.table && rid.page_num == other.rid.page_num && rid.slot_num == other.rid.slot_num;
+  }
+};
+
+class LockIdHasher {
+public:
+  size_t operator()(const LockId &id) const;
+};
+
+/**
+ * 一个事务持有的锁，只由这个事务的线程通过LockManager修改
+ */
+class LockSet {
+public:
+  /**
+   * 已经持有的锁是否包含mode
+   */
+  bool holds(const LockId &id, LockMode mode) const;
+  size_t size() const {
+    return locks_.size();
+  }
+
+private:
+  friend class LockManager;
+  struct HeldLock {
+    uint8_t modes;   // 持有的锁模式，第i位对应LockMode的第i个值
+    bool    fast;    // 通过快速路径获得，锁的状态只在槽上
+  };
+  std::unordered_map<LockId, HeldLock, LockIdHasher> locks_;
+};
+
+struct LockStats {
+  long slow_acquires = 0;   // 在锁队列中排队获得的锁
+  long waits = 0;           // 需要等待的加锁请求
+  long deadlocks = 0;       // 检测到死锁后放弃的请求
+  long timeouts = 0;        // 等待超时的请求
+};
+
+/**
+ * 行锁和表锁的锁表。
+ * 锁按(表, RID)的哈希分到一组槽上，每个槽是一个64位的原子变量:
+ *   0-30位  通过快速路径持有排他锁的事务号
+ *   31-46位 快速路径持有的锁的指纹(哈希值的另外16位)
+ *   47-62位 映射到这个槽上、有等待队列的锁的个数
+ *   63位    有事务在等待快速路径持有的锁
+ * 没有竞争时，事务对记录加排他锁只需要一次CAS把空槽改成自己的事务号，释放时再CAS改回0。
+ * 槽不空时进入慢速路径: 在槽所属的分区中为锁建立FIFO的等待队列，请求和队列中前面的请求兼容时授予，否则等待。
+ * 快速路径持有的锁只有事务号和指纹，指纹相同时认为是同一个锁，要等待持有者释放。
+ * 等待之前在等待图中查找环，会形成死锁的请求返回RC::LOCKED_DEADLOCK，等待超时返回RC::BUSY_TIMEOUT
+ */
+class LockManager {
+public:
+  LockManager();
+  ~LockManager() = default;
+
+  /**
+   * 加锁。已经持有同样或更强的锁时直接返回，持有更弱的锁时升级
+   */
+  RC lock(int32_t trx_id, LockSet &lock_set, const LockId &id, LockMode mode);
+  /**
+   * 事务结束时释放所有的锁
+   */
+  void unlock_all(int32_t trx_id, LockSet &lock_set);
+
+  LockStats stats();
+
+private:
+  struct LockRequest {
+    int32_t  trx_id;
+    LockMode mode;
+    bool     granted;
+  };
+  struct LockQueue {
+    std::list<LockRequest> requests;
+  };
+  struct Partition {
+    std::mutex                                          lock;
+    std::condition_variable                             cond;
+    std::unordered_map<LockId, LockQueue, LockIdHasher> queues;
+  };
+
+  RC lock_slow(int32_t trx_id, LockSet &lock_set, const LockId &id, LockMode mode, uint64_t hash);
+  void unlock_slow(int32_t trx_id, const LockId &id, uint64_t hash);
+  void unlock_fast(int32_t trx_id, uint64_t hash);
+  /**
+   * 请求request要等待的事务。被快速路径持有的锁挡住时在槽上设置等待标记
+   */
+  void find_blockers(int32_t trx_id, LockQueue &queue, std::list<LockRequest>::iterator request,
+                     uint64_t hash, std::vector<int32_t> &blockers);
+  bool would_deadlock(int32_t trx_id, const std::vector<int32_t> &blockers);
+  void clear_wait(int32_t trx_id);
+
+  std::atomic<uint64_t> &slot(uint64_t hash) {
+    return slots_[hash % SLOT_NUM];
+  }
+  Partition &partition(uint64_t hash) {
+    return partitions_[(hash % SLOT_NUM) % PARTITION_NUM];
+  }
+
+private:
+  static const size_t SLOT_NUM = 1 << 16;
+  static const size_t PARTITION_NUM = 64;
+
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  Partition                                partitions_[PARTITION_NUM];
+
+  std::mutex                                          graph_lock_;
+  std::unordered_map<int32_t, std::vector<int32_t>>   waits_for_;   // 等待图: 等待中的事务 -> 它等待的事务
+
+  std::atomic<long> slow_acquires_{0};
+  std::atomic<long> waits_{0};
+  std::atomic<long> deadlocks_{0};
+  std::atomic<long> timeouts_{0};
+};
+
+LockManager *theGlobalLockManager();
+
+#endif // __OBSERVER_STORAGE_TRX_LOCK_MANAGER_H_
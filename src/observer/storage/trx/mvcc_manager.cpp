@@ -0,0 +1,206 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <chrono>
+
+#include "storage/trx/mvcc_manager.h"
+#include "storage/trx/trx.h"
+#include "storage/common/table.h"
+#include "storage/clog/clog.h"
+#include "common/log/log.h"
+
+// 后台线程每次最多清理的记录数，清理时不持有lock_
+static const size_t GC_BATCH_SIZE = 1024;
+// 没有新的垃圾时后台线程检查一次的间隔，最老的快照可能在这期间结束
+static const int GC_INTERVAL_MS = 100;
+
+MvccManager *theGlobalMvccManager() {
+  static MvccManager *instance = new MvccManager();
+  return instance;
+}
+
+MvccManager::~MvccManager() {
+  stop();
+}
+
+void MvccManager::begin_trx(int32_t trx_id) {
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  trxs_[trx_id] = TrxInfo{TrxState::ACTIVE, 0};
+}
+
+int32_t MvccManager::commit_trx(int32_t trx_id) {
+  // 分配提交时间戳和建立快照都在锁内，快照时间戳不小于提交时间戳时，一定能查到这个事务已经提交
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  const int32_t commit_ts = Trx::next_trx_id();
+  trxs_[trx_id] = TrxInfo{TrxState::COMMITTED, commit_ts};
+  stats_.commits++;
+  return commit_ts;
+}
+
+void MvccManager::rollback_trx(int32_t trx_id) {
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  trxs_[trx_id] = TrxInfo{TrxState::ABORTED, Trx::current_trx_id()};
+  stats_.rollbacks++;
+}
+
+bool MvccManager::is_committed(int32_t trx_id, int32_t *commit_ts) {
+  {
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    auto iter = trxs_.find(trx_id);
+    if (iter != trxs_.end()) {
+      *commit_ts = iter->second.done_ts;
+      return iter->second.state == TrxState::COMMITTED;
+    }
+  }
+
+  *commit_ts = 0;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  if (trx_id <= clog_manager->recovered_trx_id()) {
+    // 重启前的事务，只有日志中已经提交的才可见
+    return clog_manager->is_recovered_commit(trx_id);
+  }
+  // 提交之后已经从trxs_中清理掉，或者读到记录之后事务才结束
+  return true;
+}
+
+int32_t MvccManager::open_snapshot() {
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  const int32_t snapshot_ts = Trx::current_trx_id();
+  snapshots_.insert(snapshot_ts);
+  stats_.snapshots++;
+  return snapshot_ts;
+}
+
+void MvccManager::close_snapshot(int32_t snapshot_ts) {
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  auto iter = snapshots_.find(snapshot_ts);
+  if (iter == snapshots_.end()) {
+    LOG_WARN("Snapshot does not exist. snapshot ts=%d", snapshot_ts);
+    return;
+  }
+  snapshots_.erase(iter);
+  if (!garbage_.empty()) {
+    gc_cond_.notify_one();
+  }
+}
+
+int32_t MvccManager::oldest_snapshot() {
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  return oldest_snapshot_locked();
+}
+
+int32_t MvccManager::oldest_snapshot_locked() const {
+  return snapshots_.empty() ? Trx::current_trx_id() : *snapshots_.begin();
+}
+
+void MvccManager::add_garbage(Table *table, const std::vector<RID> &rids, int32_t ts) {
+  if (rids.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  for (const RID &rid : rids) {
+    garbage_.push_back(Garbage{table, rid, ts});
+  }
+  if (!gc_started_ && !stopping_) {
+    gc_started_ = true;
+    gc_thread_ = std::thread(&MvccManager::gc_thread, this);
+  }
+  gc_cond_.notify_one();
+}
+
+int MvccManager::collect_garbage() {
+  std::lock_guard<std::mutex> gc_guard(gc_lock_);
+  int purged = 0;
+  while (true) {
+    std::vector<Garbage> batch;
+    int32_t oldest_ts;
+    {
+      std::lock_guard<std::mutex> lock_guard(lock_);
+      oldest_ts = oldest_snapshot_locked();
+      // 按提交的顺序清理，前面的记录还被快照需要时后面的一般也需要
+      while (!garbage_.empty() && garbage_.front().ts <= oldest_ts && batch.size() < GC_BATCH_SIZE) {
+        batch.push_back(garbage_.front());
+        garbage_.pop_front();
+      }
+      if (batch.empty()) {
+        // 提交时间戳不大于最老快照的事务，对所有的快照都是已提交，不用再记住它们的状态
+        for (auto iter = trxs_.begin(); iter != trxs_.end(); ) {
+          if (iter->second.state != TrxState::ACTIVE && iter->second.done_ts <= oldest_ts) {
+            iter = trxs_.erase(iter);
+          } else {
+            ++iter;
+          }
+        }
+        break;
+      }
+    }
+
+    for (const Garbage &garbage : batch) {
+      RC rc = garbage.table->purge_record(garbage.rid, oldest_ts);
+      if (rc != RC::SUCCESS) {
+        LOG_WARN("Failed to purge record. table=%s, rid=%d.%d, rc=%d:%s",
+                 garbage.table->name(), garbage.rid.page_num, garbage.rid.slot_num, rc, strrc(rc));
+      }
+    }
+    purged += batch.size();
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    stats_.purged_records += batch.size();
+  }
+  return purged;
+}
+
+void MvccManager::remove_table(Table *table) {
+  std::lock_guard<std::mutex> gc_guard(gc_lock_);
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  std::deque<Garbage> remaining;
+  for (const Garbage &garbage : garbage_) {
+    if (garbage.table != table) {
+      remaining.push_back(garbage);
+    }
+  }
+  garbage_.swap(remaining);
+}
+
+void MvccManager::stop() {
+  {
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    stopping_ = true;
+    gc_cond_.notify_all();
+  }
+  if (gc_thread_.joinable()) {
+    gc_thread_.join();
+  }
+}
+
+MvccStats MvccManager::stats() {
+  std::lock_guard<std::mutex> lock_guard(lock_);
+  MvccStats stats = stats_;
+  stats.pending_garbage = garbage_.size();
+  return stats;
+}
+
+void MvccManager::gc_thread() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!stopping_) {
+    gc_cond_.wait_for(lock, std::chrono::milliseconds(GC_INTERVAL_MS), [this]() {
+      return stopping_ || (!garbage_.empty() && garbage_.front().ts <= oldest_snapshot_locked());
+    });
+    if (stopping_) {
+      break;
+    }
+    lock.unlock();
+    collect_garbage();
+    lock.lock();
+  }
+}
@@ -0,0 +1,138 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_TRX_MVCC_MANAGER_H_
+#define __OBSERVER_STORAGE_TRX_MVCC_MANAGER_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "rc.h"
+#include "storage/common/record_manager.h"
+
+class Table;
+
+struct MvccStats {
+  long snapshots = 0;        // 建立过的快照数
+  long commits = 0;          // 有写操作的事务提交数
+  long rollbacks = 0;        // 有写操作的事务回滚数
+  long purged_records = 0;   // 后台清理掉的旧版本数
+  long pending_garbage = 0;  // 还在等待清理的记录数
+};
+
+/**
+ * 多版本并发控制的全局状态。
+ * 每条记录是一个版本，记录上的两个事务字段是创建和删除这个版本的事务:
+ * 提交之前是带未提交标记的事务号，提交时改成提交时间戳。提交时间戳和事务号从同一个计数器分配，重启后继续增长。
+ * 事务第一次读取时建立快照，快照时间戳是当时分配过的最大编号，提交时间戳不大于它的事务的修改对这个快照可见。
+ * 更新不修改原来的记录，而是删除旧版本、插入新版本，旧版本留在数据文件中。
+ *
+ * 这里记录有写操作的事务的状态(读到未提交标记时判断事务是否已经提交)、活跃的快照，
+ * 以及已提交的修改: 提交时间戳不大于最老的快照之后，被删除的版本不再被任何快照需要，由后台线程从数据文件和索引中删除
+ */
+class MvccManager {
+public:
+  MvccManager() = default;
+  ~MvccManager();
+
+  /**
+   * 事务第一次修改记录之前登记
+   */
+  void begin_trx(int32_t trx_id);
+  /**
+   * COMMIT日志落盘之后调用，分配并返回提交时间戳。之后建立的快照都能看到这个事务的修改
+   */
+  int32_t commit_trx(int32_t trx_id);
+  /**
+   * 回滚完成之后调用
+   */
+  void rollback_trx(int32_t trx_id);
+  /**
+   * 记录上带未提交标记的事务号是否已经提交，已提交时通过commit_ts返回提交时间戳。
+   * 状态已经清理掉的事务提交时间戳早于所有的快照，返回0
+   */
+  bool is_committed(int32_t trx_id, int32_t *commit_ts);
+
+  /**
+   * 建立快照，返回快照时间戳。不再使用时调用close_snapshot
+   */
+  int32_t open_snapshot();
+  void close_snapshot(int32_t snapshot_ts);
+  /**
+   * 最老的活跃快照的时间戳，没有快照时是当前分配过的最大编号。提交时间戳不大于它的修改对所有的快照都可见
+   */
+  int32_t oldest_snapshot();
+
+  /**
+   * 事务提交或回滚之后，把修改过的记录交给后台清理。ts是提交时间戳，回滚时是0
+   */
+  void add_garbage(Table *table, const std::vector<RID> &rids, int32_t ts);
+  /**
+   * 清理所有已经不被任何快照需要的记录，返回清理过的记录数。后台线程定期调用，测试中可以直接调用
+   */
+  int collect_garbage();
+  /**
+   * 表关闭或者删除之前调用，丢弃这个表上还没有清理的记录
+   */
+  void remove_table(Table *table);
+
+  /**
+   * 停止后台清理线程。没有清理的记录在重启之后由Table::recover_trx处理
+   */
+  void stop();
+
+  MvccStats stats();
+
+private:
+  enum class TrxState {
+    ACTIVE,
+    COMMITTED,
+    ABORTED,
+  };
+  struct TrxInfo {
+    TrxState state;
+    int32_t  done_ts;   // 提交时间戳，或者回滚完成时的时间戳。不大于最老的快照时可以删掉
+  };
+  struct Garbage {
+    Table  *table;
+    RID     rid;
+    int32_t ts;
+  };
+
+  int32_t oldest_snapshot_locked() const;
+  void gc_thread();
+
+private:
+  std::mutex                            lock_;
+  std::condition_variable               gc_cond_;
+  std::unordered_map<int32_t, TrxInfo>  trxs_;
+  std::multiset<int32_t>                snapshots_;
+  std::deque<Garbage>                   garbage_;
+  MvccStats                             stats_;
+
+  std::mutex                            gc_lock_;   // 清理记录时持有，删除表之前要等待正在进行的清理结束
+  std::thread                           gc_thread_;
+  bool                                  gc_started_ = false;
+  bool                                  stopping_ = false;
+};
+
+MvccManager *theGlobalMvccManager();
+
+#endif // __OBSERVER_STORAGE_TRX_MVCC_MANAGER_H_
@@ -0,0 +1,107 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <algorithm>
+
+#include "storage/trx/occ_manager.h"
+#include "common/log/log.h"
+
+OccOptions &OccOptions::instance() {
+  static OccOptions options;
+  return options;
+}
+
+OccManager *theGlobalOccManager() {
+  static OccManager *instance = new OccManager();
+  return instance;
+}
+
+bool OccStart::is_visible(uint64_t commit_seq) const {
+  return commit_seq <= seq && !std::binary_search(committing.begin(), committing.end(), commit_seq);
+}
+
+void OccManager::begin(OccStart &start) {
+  std::lock_guard<std::mutex> guard(lock_);
+  // 还没有提交完成的事务的修改在新的快照中看不到，检查时要考虑它们
+  start.seq = last_seq_;
+  start.committing.assign(committing_.begin(), committing_.end());
+  active_.insert(start.horizon());
+}
+
+RC OccManager::validate(const OccStart &start, const std::vector<LockId> &reads, const std::vector<LockId> &writes,
+                        uint64_t *commit_seq) {
+  std::lock_guard<std::mutex> guard(lock_);
+  stats_.validations++;
+  for (const std::vector<LockId> *ids : {&reads, &writes}) {
+    for (const LockId &id : *ids) {
+      auto iter = last_writes_.find(id);
+      if (iter != last_writes_.end() && !start.is_visible(iter->second)) {
+        LOG_TRACE("Optimistic trx conflicts on record. rid=%d.%d, start seq=%llu, commit seq=%llu",
+                  id.rid.page_num, id.rid.slot_num, (unsigned long long)start.seq, (unsigned long long)iter->second);
+        stats_.conflicts++;
+        return RC::BUSY_SNAPSHOT;
+      }
+    }
+  }
+
+  *commit_seq = ++last_seq_;
+  for (const LockId &id : writes) {
+    last_writes_[id] = *commit_seq;
+  }
+  if (!writes.empty()) {
+    history_.push_back(CommittedWrites{*commit_seq, writes});
+  }
+  committing_.insert(*commit_seq);
+  return RC::SUCCESS;
+}
+
+void OccManager::finish(const OccStart &start, uint64_t commit_seq) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto iter = active_.find(start.horizon());
+  if (iter != active_.end()) {
+    active_.erase(iter);
+  }
+  if (commit_seq != 0) {
+    committing_.erase(commit_seq);
+  }
+  purge_locked();
+}
+
+void OccManager::purge_locked() {
+  // 提交序号不大于这个值的修改对活跃的事务以及之后开始的事务都可见
+  uint64_t horizon = last_seq_;
+  if (!active_.empty()) {
+    horizon = std::min(horizon, *active_.begin());
+  }
+  if (!committing_.empty()) {
+    horizon = std::min(horizon, *committing_.begin() - 1);
+  }
+  while (!history_.empty() && history_.front().commit_seq <= horizon) {
+    const CommittedWrites &committed = history_.front();
+    for (const LockId &id : committed.writes) {
+      auto iter = last_writes_.find(id);
+      if (iter != last_writes_.end() && iter->second == committed.commit_seq) {
+        last_writes_.erase(iter);
+      }
+    }
+    history_.pop_front();
+  }
+}
+
+OccStats OccManager::stats() {
+  std::lock_guard<std::mutex> guard(lock_);
+  OccStats stats = stats_;
+  stats.tracked_writes = (long)last_writes_.size();
+  return stats;
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __OBSERVER_STORAGE_TRX_OCC_MANAGER_H_
+#define __OBSERVER_STORAGE_TRX_OCC_MANAGER_H_
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "rc.h"
+#include "storage/trx/lock_manager.h"
+
+struct OccOptions {
+  int max_retries = 3;   // 乐观并发控制下自动提交的语句提交冲突时，回滚后重新执行的最多次数
+
+  static OccOptions &instance();
+};
+
+struct OccStats {
+  long validations = 0;      // 提交前做过的检查
+  long conflicts = 0;        // 检查失败的事务
+  long tracked_writes = 0;   // 还保留着的已提交写集合中的记录数
+};
+
+/**
+ * 乐观事务开始时的状态: 提交序号不大于seq、并且不在committing中的事务的修改对它可见
+ */
+struct OccStart {
+  uint64_t              seq = 0;
+  std::vector<uint64_t> committing;   // 开始时通过了检查还没有提交完成的事务，按提交序号排好序
+
+  bool is_visible(uint64_t commit_seq) const;
+  /**
+   * 提交序号不大于它的修改都对这个事务可见
+   */
+  uint64_t horizon() const {
+    return committing.empty() ? seq : committing.front() - 1;
+  }
+};
+
+/**
+ * 乐观事务的提交检查(后向验证)。
+ * 乐观事务执行期间不加锁，只记下读过和修改过的记录(用LockId表示)。提交之前调用validate:
+ * 修改对它不可见的事务(它开始之后才通过检查，或者开始时还没有提交完成)修改过它读过或修改过的记录时检查失败，
+ * 事务要回滚，否则分配一个提交序号并登记它的写集合。
+ * 检查和登记在一个锁里完成，两个乐观事务不会同时通过检查。
+ *
+ * 每条记录只保留最后一次修改它的提交序号，检查的代价只和读写集合的大小有关。
+ * 对所有活跃的乐观事务都可见的修改不会再引起冲突，按提交的顺序清理掉。
+ * 通过检查的事务要等提交完成(别的事务的快照能看到它的修改)之后才调用finish，
+ * 这之前开始的事务把它当作不可见的，读到它修改之前的版本时检查会失败
+ */
+class OccManager {
+public:
+  OccManager() = default;
+  ~OccManager() = default;
+
+  /**
+   * 事务开始时调用，要在建立快照之前
+   */
+  void begin(OccStart &start);
+  /**
+   * 提交之前检查，读写集合中有记录被修改对它不可见的事务修改过时返回RC::BUSY_SNAPSHOT。
+   * 通过时返回提交序号，writes登记为这个序号的修改
+   */
+  RC validate(const OccStart &start, const std::vector<LockId> &reads, const std::vector<LockId> &writes,
+              uint64_t *commit_seq);
+  /**
+   * 事务结束时调用。commit_seq是validate返回的提交序号，没有通过检查或者没有检查时是0
+   */
+  void finish(const OccStart &start, uint64_t commit_seq);
+
+  OccStats stats();
+
+private:
+  struct CommittedWrites {
+    uint64_t            commit_seq;
+    std::vector<LockId> writes;
+  };
+
+  void purge_locked();
+
+private:
+  std::mutex                                         lock_;
+  uint64_t                                           last_seq_ = 0;
+  std::multiset<uint64_t>                            active_;       // 活跃事务的OccStart::horizon
+  std::set<uint64_t>                                 committing_;   // 通过了检查还没有提交完成的事务
+  std::unordered_map<LockId, uint64_t, LockIdHasher> last_writes_;  // 记录 -> 最后修改它的提交序号
+  std::deque<CommittedWrites>                        history_;      // 按提交序号排列的写集合，用来清理last_writes_
+  OccStats                                           stats_;
+};
+
+OccManager *theGlobalOccManager();
+
+#endif // __OBSERVER_STORAGE_TRX_OCC_MANAGER_H_
@@ -12,30 +12,56 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2021/5/24.
 //
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <sstream>
 
 #include "storage/trx/trx.h"
 #include "storage/common/table.h"
 #include "storage/common/record_manager.h"
 #include "storage/common/field_meta.h"
+#include "storage/clog/clog.h"
+#include "storage/trx/mvcc_manager.h"
 #include "common/log/log.h"
+#include "common/metrics/metrics_registry.h"
+#include "common/metrics/snapshot.h"
 
-static const uint32_t DELETED_FLAG_BIT_MASK = 0x80000000;
+static const uint32_t UNCOMMITTED_FLAG_BIT_MASK = 0x80000000;
 static const uint32_t TRX_ID_BIT_MASK = 0x7FFFFFFF;
 
+static std::atomic<int32_t> last_trx_id{0};
+
 int32_t Trx::default_trx_id() {
   return 0;
 }
 
 int32_t Trx::next_trx_id() {
-  static std::atomic<int32_t> trx_id;
-  return ++trx_id;
+  int32_t trx_id = ++last_trx_id;
+  // 控制文件中记下用过的事务号，重启之后的事务号都比它大
+  RC rc = theGlobalCLogManager()->reserve_trx_id(trx_id);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to reserve trx id %d. rc=%d:%s", trx_id, rc, strrc(rc));
+  }
+  return trx_id;
+}
+
+int32_t Trx::current_trx_id() {
+  return last_trx_id.load();
+}
+
+void Trx::init_trx_id(int32_t max_used_trx_id) {
+  last_trx_id = max_used_trx_id;
 }
 
 const char *Trx::trx_field_name() {
   return "__trx";
 }
 
+const char *Trx::trx_end_field_name() {
+  return "__trx_end";
+}
+
 AttrType Trx::trx_field_type() {
   return INTS;
 }
@@ -44,234 +70,434 @@ int Trx::trx_field_len() {
   return sizeof(int32_t);
 }
 
+void Trx::get_record_trx_info(Table *table, const Record &record, int32_t &begin, int32_t &end) {
+  const TableMeta &table_meta = table->table_meta();
+  begin = *(const int32_t *)(record.data + table_meta.trx_field()->offset());
+  end = *(const int32_t *)(record.data + table_meta.trx_end_field()->offset());
+}
+
+void Trx::set_record_trx_info(Table *table, Record &record, int32_t begin, int32_t end) {
+  const TableMeta &table_meta = table->table_meta();
+  *(int32_t *)(record.data + table_meta.trx_field()->offset()) = begin;
+  *(int32_t *)(record.data + table_meta.trx_end_field()->offset()) = end;
+}
+
+int32_t Trx::uncommitted_value(int32_t trx_id) {
+  return (int32_t)((uint32_t)trx_id | UNCOMMITTED_FLAG_BIT_MASK);
+}
+
+bool Trx::is_uncommitted(int32_t value) {
+  return ((uint32_t)value & UNCOMMITTED_FLAG_BIT_MASK) != 0;
+}
+
+int32_t Trx::trx_id_of(int32_t value) {
+  return (int32_t)((uint32_t)value & TRX_ID_BIT_MASK);
+}
+
 Trx::Trx() {
 }
 
 Trx::~Trx() {
+  if (trx_id_ != 0 || has_snapshot_) {
+    rollback();
+  }
 }
 
 RC Trx::insert_record(Table *table, Record *record) {
-  RC rc = RC::SUCCESS;
-  // 先校验是否以前是否存在过(应该不会存在) 
-  Operation *old_oper = find_operation(table, record->rid);
-  if (old_oper != nullptr) {
-    return RC::GENERIC_ERROR; // error code
-  }
-
   start_if_not_started();
 
-  // 设置record中trx_field为当前的事务号
-  // set_record_trx_id(table, record, trx_id_, false);
-  // 记录到operations中
-  insert_operation(table, Operation::Type::INSERT, record->rid);
-  return rc;
+  // 记录中的事务字段已经在init_trx_info中设置。新插入的记录在这个事务中不会再插入一次，不用查重
+  operations_.append(table, Operation::Type::INSERT, record->rid);
+  return RC::SUCCESS;
 }
 
 RC Trx::delete_record(Table *table, Record *record) {
-  RC rc = RC::SUCCESS;
   start_if_not_started();
-  Operation *old_oper = find_operation(table, record->rid);
-  if (old_oper != nullptr) {
-    if (old_oper->type() == Operation::Type::INSERT) {
-      delete_operation(table, record->rid);
-      return RC::SUCCESS;
-    } else {
-      return RC::GENERIC_ERROR;
-    }
+  int32_t begin;
+  int32_t end;
+  get_record_trx_info(table, *record, begin, end);
+  if (end != 0) {
+    // 当前快照中可见的版本，在快照之后被其它事务删除了，或者正在被删除
+    LOG_TRACE("Write conflict on record. rid=%d.%d, trx id=%d, end=%x",
+              record->rid.page_num, record->rid.slot_num, trx_id_, end);
+    return RC::BUSY_SNAPSHOT;
   }
-  set_record_trx_id(table, *record, trx_id_, true);
-  insert_operation(table, Operation::Type::DELETE, record->rid);
-  return rc;
-}
+  set_record_trx_info(table, *record, begin, uncommitted_value(trx_id_));
 
-// TODO [Need to be Reviewed]
-RC Trx::update_record(Table *table, Record *record) {
-  RC rc = RC::SUCCESS;
-  start_if_not_started();
-  Operation *old_oper = find_operation(table, record->rid);
-  if (old_oper != nullptr) {
-    if (old_oper->type() == Operation::Type::INSERT) {
-      delete_operation(table, record->rid);
-      return RC::SUCCESS;
-    } else {
-      return RC::GENERIC_ERROR;
-    }
+  // 自己插入的版本已经记过，提交时两个事务字段一起处理，回滚时直接删除
+  if (begin != uncommitted_value(trx_id_)) {
+    operations_.append(table, Operation::Type::DELETE, record->rid);
   }
-  set_record_trx_id(table, *record, trx_id_, true);
-  insert_operation(table, Operation::Type::UPDATE, record->rid);
-  return rc;
+  return RC::SUCCESS;
 }
 
-void Trx::set_record_trx_id(Table *table, Record &record, int32_t trx_id, bool deleted) const {
-  const FieldMeta *trx_field = table->table_meta().trx_field();
-  int32_t *ptrx_id = (int32_t*)(record.data + trx_field->offset());
-  if (deleted) {
-    trx_id |= DELETED_FLAG_BIT_MASK;
+RC Trx::lock_record(Table *table, const RID &rid) {
+  start_if_not_started();
+  if (occ_started_) {
+    // 写冲突由记录上的删除标记和提交前的检查发现
+    return RC::SUCCESS;
+  }
+  LockManager *lock_manager = theGlobalLockManager();
+  RC rc = lock_manager->lock(trx_id_, lock_set_, LockId::table_lock(table), LockMode::IX);
+  if (rc != RC::SUCCESS) {
+    return rc;
   }
-  *ptrx_id = trx_id;
+  return lock_manager->lock(trx_id_, lock_set_, LockId::record_lock(table, rid), LockMode::X);
 }
 
-void Trx::get_record_trx_id(Table *table, const Record &record, int32_t &trx_id, bool &deleted) {
-  const FieldMeta *trx_field = table->table_meta().trx_field();
-  int32_t trx = *(int32_t*)(record.data + trx_field->offset());
-  trx_id = trx & TRX_ID_BIT_MASK;
-  deleted = (trx & DELETED_FLAG_BIT_MASK) != 0;
+void OperationLog::append(Table *table, Operation::Type type, const RID &rid) {
+  if (blocks_.empty() || blocks_.back().size == blocks_.back().capacity) {
+    static const size_t MIN_BLOCK_CAPACITY = 64;
+    static const size_t MAX_BLOCK_CAPACITY = 64 * 1024;
+    size_t capacity = MIN_BLOCK_CAPACITY;
+    if (!blocks_.empty()) {
+      capacity = std::min(blocks_.back().capacity * 2, MAX_BLOCK_CAPACITY);
+    }
+    blocks_.push_back(Block{std::unique_ptr<Operation[]>(new Operation[capacity]), capacity, 0});
+  }
+  Block &block = blocks_.back();
+  block.operations[block.size++] = Operation(table, type, rid);
+  size_++;
 }
 
-Operation *Trx::find_operation(Table *table, const RID &rid) {
-  std::unordered_map<Table *, OperationSet>::iterator table_operations_iter = operations_.find(table);
-  if (table_operations_iter == operations_.end()) {
-    return nullptr;
+void OperationLog::sorted(std::vector<Operation> &operations) const {
+  operations.clear();
+  operations.reserve(size_);
+  for (const Block &block : blocks_) {
+    operations.insert(operations.end(), block.operations.get(), block.operations.get() + block.size);
   }
-
-  OperationSet & table_operations = table_operations_iter->second;
-  Operation tmp(Operation::Type::UNDEFINED, rid);
-  OperationSet::iterator operation_iter = table_operations.find(tmp);
-  if (operation_iter == table_operations.end()) {
-    return nullptr;
+  // 顺序插入的大事务基本上已经有序
+  if (!std::is_sorted(operations.begin(), operations.end())) {
+    std::sort(operations.begin(), operations.end());
   }
-  return const_cast<Operation *>(&(*operation_iter));
 }
 
-void Trx::insert_operation(Table *table, Operation::Type type, const RID &rid) {
-  OperationSet & table_operations = operations_[table];
-  table_operations.emplace(type, rid);
-}
-
-void Trx::delete_operation(Table *table, const RID &rid) {
-
-  std::unordered_map<Table *, OperationSet>::iterator table_operations_iter = operations_.find(table);
-  if (table_operations_iter == operations_.end()) {
-    return ;
+void OperationLog::clear() {
+  if (blocks_.size() > 1) {
+    blocks_.erase(blocks_.begin() + 1, blocks_.end());
   }
-
-  Operation tmp(Operation::Type::UNDEFINED, rid);
-  table_operations_iter->second.erase(tmp);
+  if (!blocks_.empty()) {
+    blocks_.front().size = 0;
+  }
+  size_ = 0;
 }
 
 RC Trx::commit() {
   RC rc = RC::SUCCESS;
-  for (const auto &table_operations: operations_) {
-    Table *table = table_operations.first;
-    const OperationSet &operation_set = table_operations.second;
-    for (const Operation &operation: operation_set) {
-
-      RID rid;
-      rid.page_num = operation.page_num();
-      rid.slot_num = operation.slot_num();
-
-      switch (operation.type()) {
-        case Operation::Type::INSERT: {
-          rc = table->commit_insert(this, rid);
-          if (rc != RC::SUCCESS) {
-            // handle rc
-            LOG_ERROR("Failed to commit insert operation. rid=%d.%d, rc=%d:%s",
-                      rid.page_num, rid.slot_num, rc, strrc(rc));
-          }
-        }
-        break;
-        case Operation::Type::DELETE: {
-          rc = table->commit_delete(this, rid);
-          if (rc != RC::SUCCESS) {
-            // handle rc
-            LOG_ERROR("Failed to commit delete operation. rid=%d.%d, rc=%d:%s",
-                      rid.page_num, rid.slot_num, rc, strrc(rc));
-          }
-        }
-        break;
-        case Operation::Type::UPDATE: {
+  MvccManager *mvcc_manager = theGlobalMvccManager();
+  if (operations_.empty()) {
+    if (trx_id_ != 0) {
+      mvcc_manager->rollback_trx(trx_id_);
+    }
+    end_trx();
+    return rc;
+  }
 
-        }
-        break;
-        default: {
-          LOG_PANIC("Unknown operation. type=%d", (int)operation.type());
-        }
-        break;
+  const auto begin = std::chrono::steady_clock::now();
+  std::vector<Operation> operations;
+  operations_.sorted(operations);
+  const Durability durability = commit_durability(operations);
+
+  if (occ_started_) {
+    rc = validate_optimistic(operations);
+    if (rc != RC::SUCCESS) {
+      LOG_TRACE("Optimistic trx failed to validate, rollback. trx id=%d", trx_id_);
+      rollback();
+      return rc;
+    }
+  }
+
+  // COMMIT日志落盘之后事务才算提交，同时提交的事务共用一次落盘。异步提交时日志追加到缓冲区就返回。
+  // 之后才把记录上的事务号换成提交时间戳，崩溃时没有换完的事务在恢复后继续完成提交
+  CLogManager *clog_manager = theGlobalCLogManager();
+  LSN lsn = 0;
+  if (durability != DURABILITY_NOLOG) {
+    rc = clog_manager->append(CLogType::COMMIT, trx_id_, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn);
+    if (rc == RC::SUCCESS) {
+      rc = durability == DURABILITY_ASYNC ? clog_manager->commit_async(lsn) : clog_manager->sync(lsn);
+    }
+  }
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to write commit log, rollback. trx id=%d, rc=%d:%s", trx_id_, rc, strrc(rc));
+    rollback();
+    return rc;
+  }
+
+  // 从这里开始，新建立的快照都能看到这个事务的修改
+  const int32_t commit_ts = mvcc_manager->commit_trx(trx_id_);
+  std::vector<RID> rids;
+  for (size_t i = 0; i < operations.size(); i++) {
+    RID rid;
+    rid.page_num = operations[i].page_num();
+    rid.slot_num = operations[i].slot_num();
+    rids.push_back(rid);
+
+    // 一个表上的记录一起处理，同一个页面上的记录只固定一次页面
+    Table *table = operations[i].table();
+    if (i + 1 == operations.size() || operations[i + 1].table() != table) {
+      rc = table->commit_records(this, rids, commit_ts);
+      if (rc != RC::SUCCESS) {
+        // handle rc
+        LOG_ERROR("Failed to commit operations. table=%s, trx id=%d, rc=%d:%s",
+                  table->name(), trx_id_, rc, strrc(rc));
       }
+      // 被删除的版本等到没有快照需要时再从数据文件中删除
+      mvcc_manager->add_garbage(table, rids, commit_ts);
+      rids.clear();
+    }
+  }
+
+  // 不需要等待落盘，恢复时没有TRX_END的已提交事务会重新处理一遍
+  if (durability != DURABILITY_NOLOG) {
+    RC rc2 = clog_manager->append(CLogType::TRX_END, trx_id_, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn);
+    if (rc2 != RC::SUCCESS) {
+      LOG_ERROR("Failed to write trx end log. trx id=%d, rc=%d:%s", trx_id_, rc2, strrc(rc2));
+      rc = rc2;
     }
   }
 
   operations_.clear();
-  trx_id_ = 0;
+  end_trx();
+  const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+  commit_metric().record(durability, (long)latency.count());
   return rc;
 }
 
+Durability Trx::commit_durability(const std::vector<Operation> &operations) const {
+  Durability durability = DURABILITY_NOLOG;
+  const Table *last_table = nullptr;
+  for (const Operation &operation : operations) {
+    // 操作按表排好了序
+    if (operation.table() == last_table) {
+      continue;
+    }
+    last_table = operation.table();
+    const Durability table_durability = last_table->table_meta().durability();
+    if (table_durability == DURABILITY_NOLOG) {
+      continue;
+    }
+    if (durability_ != DURABILITY_DEFAULT) {
+      return durability_;
+    }
+    if (table_durability == DURABILITY_SYNC) {
+      return DURABILITY_SYNC;
+    }
+    durability = DURABILITY_ASYNC;
+  }
+  return durability;
+}
+
 RC Trx::rollback() {
   RC rc = RC::SUCCESS;
-  for (const auto &table_operations: operations_) {
-    Table *table = table_operations.first;
-    const OperationSet &operation_set = table_operations.second;
-    for (const Operation &operation: operation_set) {
-
-      RID rid;
-      rid.page_num = operation.page_num();
-      rid.slot_num = operation.slot_num();
-
-      switch (operation.type()) {
-        case Operation::Type::INSERT: {
-          rc = table->rollback_insert(this, rid);
-          if (rc != RC::SUCCESS) {
-            // handle rc
-            LOG_ERROR("Failed to rollback insert operation. rid=%d.%d, rc=%d:%s",
-                      rid.page_num, rid.slot_num, rc, strrc(rc));
-          }
-        }
-          break;
-        case Operation::Type::DELETE: {
-          rc = table->rollback_delete(this, rid);
-          if (rc != RC::SUCCESS) {
-            // handle rc
-            LOG_ERROR("Failed to rollback delete operation. rid=%d.%d, rc=%d:%s",
-                      rid.page_num, rid.slot_num, rc, strrc(rc));
-          }
-        }
-          break;
-        case Operation::Type::UPDATE: {
-
-        }
-          break;
-        default: {
-          LOG_PANIC("Unknown operation. type=%d", (int)operation.type());
-        }
-          break;
+  MvccManager *mvcc_manager = theGlobalMvccManager();
+  std::vector<Operation> operations;
+  operations_.sorted(operations);
+  std::vector<RID> inserted_rids;
+  std::vector<RID> deleted_rids;
+  for (size_t i = 0; i < operations.size(); i++) {
+    const Operation &operation = operations[i];
+    RID rid;
+    rid.page_num = operation.page_num();
+    rid.slot_num = operation.slot_num();
+
+    switch (operation.type()) {
+      case Operation::Type::INSERT: {
+        inserted_rids.push_back(rid);
+      }
+        break;
+      case Operation::Type::DELETE: {
+        deleted_rids.push_back(rid);
       }
+        break;
+      default: {
+        LOG_PANIC("Unknown operation. type=%d", (int)operation.type());
+      }
+        break;
+    }
+
+    Table *table = operation.table();
+    if (i + 1 < operations.size() && operations[i + 1].table() == table) {
+      continue;
+    }
+    RC rc2 = table->rollback_inserts(this, inserted_rids);
+    if (rc2 != RC::SUCCESS) {
+      // handle rc
+      LOG_ERROR("Failed to rollback insert operations. table=%s, trx id=%d, rc=%d:%s",
+                table->name(), trx_id_, rc2, strrc(rc2));
+      rc = rc2;
+    }
+    rc2 = table->rollback_deletes(this, deleted_rids);
+    if (rc2 != RC::SUCCESS) {
+      // handle rc
+      LOG_ERROR("Failed to rollback delete operations. table=%s, trx id=%d, rc=%d:%s",
+                table->name(), trx_id_, rc2, strrc(rc2));
+      rc = rc2;
     }
+    // 恢复的版本可能还带着其它事务的提交时间戳，由后台判断什么时候对所有快照可见
+    mvcc_manager->add_garbage(table, deleted_rids, 0);
+    inserted_rids.clear();
+    deleted_rids.clear();
   }
 
+  if (trx_id_ != 0) {
+    mvcc_manager->rollback_trx(trx_id_);
+  }
   operations_.clear();
-  trx_id_ = 0;
+  end_trx();
   return rc;
 }
 
-RC Trx::commit_insert(Table *table, Record &record) {
-  set_record_trx_id(table, record, 0, false);
-  return RC::SUCCESS;
+bool Trx::is_visible(Table *table, const Record *record) {
+  int32_t begin;
+  int32_t end;
+  get_record_trx_info(table, *record, begin, end);
+
+  // 创建这个版本的事务在快照中已经提交，并且删除它的事务在快照中还没有提交
+  const bool visible = is_committed_in_snapshot(begin) && (end == 0 || !is_committed_in_snapshot(end));
+  // 自己插入的版本其它事务看不到，不会冲突
+  if (visible && occ_started_ && begin != uncommitted_value(trx_id_)) {
+    read_set_.push_back(LockId::record_lock(table, record->rid));
+  }
+  return visible;
 }
 
-RC Trx::rollback_delete(Table *table, Record &record) {
-  set_record_trx_id(table, record, 0, false);
-  return RC::SUCCESS;
+void Trx::open_snapshot() {
+  snapshot_ts();
 }
 
-bool Trx::is_visible(Table *table, const Record *record) {
-  int32_t record_trx_id;
-  bool record_deleted;
-  get_record_trx_id(table, *record, record_trx_id, record_deleted);
-
-  // 0 表示这条数据已经提交
-  if (0 == record_trx_id || record_trx_id == trx_id_) {
-    return !record_deleted;
+bool Trx::is_committed_in_snapshot(int32_t value) {
+  if (value == 0) {
+    return true;
+  }
+  if (!is_uncommitted(value)) {
+    return value <= snapshot_ts();
   }
 
-  return record_deleted; // 当前记录上面有事务号，说明是未提交数据，那么如果有删除标记的话，就表示是未提交的删除
+  const int32_t trx_id = trx_id_of(value);
+  if (trx_id == trx_id_) {
+    return true;
+  }
+  // 读取记录时事务还没有把事务号换成提交时间戳
+  int32_t commit_ts;
+  return theGlobalMvccManager()->is_committed(trx_id, &commit_ts) && commit_ts <= snapshot_ts();
 }
 
 void Trx::init_trx_info(Table *table, Record &record) {
-  set_record_trx_id(table, record, trx_id_, false);
+  // 插入的记录要带上事务号，否则在提交之前就对其它事务可见，崩溃之后也无法回滚
+  start_if_not_started();
+  set_record_trx_info(table, record, uncommitted_value(trx_id_), 0);
 }
 
 void Trx::start_if_not_started() {
   if (trx_id_ == 0) {
+    begin_optimistic();
     trx_id_ = next_trx_id();
+    theGlobalMvccManager()->begin_trx(trx_id_);
+  }
+}
+
+void Trx::begin_optimistic() {
+  if (optimistic_ && !occ_started_ && trx_id_ == 0 && !has_snapshot_) {
+    theGlobalOccManager()->begin(occ_start_);
+    occ_started_ = true;
+  }
+}
+
+RC Trx::validate_optimistic(const std::vector<Operation> &operations) {
+  std::vector<LockId> writes;
+  writes.reserve(operations.size());
+  for (const Operation &operation : operations) {
+    RID rid;
+    rid.page_num = operation.page_num();
+    rid.slot_num = operation.slot_num();
+    writes.push_back(LockId::record_lock(operation.table(), rid));
+  }
+  return theGlobalOccManager()->validate(occ_start_, read_set_, writes, &occ_commit_seq_);
+}
+
+int32_t Trx::snapshot_ts() {
+  if (!has_snapshot_) {
+    begin_optimistic();
+    snapshot_ts_ = theGlobalMvccManager()->open_snapshot();
+    has_snapshot_ = true;
+  }
+  return snapshot_ts_;
+}
+
+void Trx::end_trx() {
+  // 修改已经提交或者回滚，等待这些记录的事务可以继续
+  if (lock_set_.size() > 0) {
+    theGlobalLockManager()->unlock_all(trx_id_, lock_set_);
+  }
+  if (has_snapshot_) {
+    theGlobalMvccManager()->close_snapshot(snapshot_ts_);
+    has_snapshot_ = false;
+  }
+  // 修改已经对新的快照可见，之后开始的乐观事务不用再和它比较
+  if (occ_started_) {
+    theGlobalOccManager()->finish(occ_start_, occ_commit_seq_);
+    occ_started_ = false;
+    occ_commit_seq_ = 0;
+    read_set_.clear();
+  }
+  trx_id_ = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static const std::string COMMIT_METRIC_TAG = "Trx.commit";
+
+CommitMetric::CommitMetric() {
+  snapshot_value_ = nullptr;
+}
+
+CommitMetric::~CommitMetric() {
+  delete snapshot_value_;
+  snapshot_value_ = nullptr;
+}
+
+void CommitMetric::record(Durability durability, long latency_us) {
+  Counter &counter = counters_[durability];
+  counter.commits.fetch_add(1, std::memory_order_relaxed);
+  counter.total_latency_us.fetch_add(latency_us, std::memory_order_relaxed);
+  long max_latency_us = counter.max_latency_us.load(std::memory_order_relaxed);
+  while (latency_us > max_latency_us &&
+         !counter.max_latency_us.compare_exchange_weak(max_latency_us, latency_us, std::memory_order_relaxed)) {
   }
-}
\ No newline at end of file
+}
+
+CommitStats CommitMetric::stats(Durability durability) const {
+  const Counter &counter = counters_[durability];
+  CommitStats stats;
+  stats.commits = counter.commits.load(std::memory_order_relaxed);
+  stats.total_latency_us = counter.total_latency_us.load(std::memory_order_relaxed);
+  stats.max_latency_us = counter.max_latency_us.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CommitMetric::snapshot() {
+  std::stringstream ss;
+  for (Durability durability : {DURABILITY_SYNC, DURABILITY_ASYNC, DURABILITY_NOLOG}) {
+    const CommitStats commit_stats = stats(durability);
+    if (durability != DURABILITY_SYNC) {
+      ss << ", ";
+    }
+    ss << durability_name(durability) << "={commits=" << commit_stats.commits
+       << ", mean_latency_us=" << commit_stats.mean_latency_us()
+       << ", max_latency_us=" << commit_stats.max_latency_us << "}";
+  }
+  std::string value = ss.str();
+
+  if (snapshot_value_ == nullptr) {
+    snapshot_value_ = new common::SnapshotBasic<std::string>();
+  }
+  ((common::SnapshotBasic<std::string> *)snapshot_value_)->setValue(value);
+}
+
+CommitMetric &commit_metric() {
+  static CommitMetric *metric = []() {
+    CommitMetric *metric = new CommitMetric();
+    common::get_metrics_registry().register_metric(COMMIT_METRIC_TAG, metric);
+    return metric;
+  }();
+  return *metric;
+}
@@ -16,12 +16,15 @@ See the Mulan PSL v2 for more details. */
 #define __OBSERVER_STORAGE_TRX_TRX_H_
 
 #include <stddef.h>
-#include <unordered_map>
-#include <unordered_set>
-#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
 
+#include "common/metrics/metric.h"
 #include "sql/parser/parse.h"
 #include "storage/common/record_manager.h"
+#include "storage/trx/lock_manager.h"
+#include "storage/trx/occ_manager.h"
 #include "rc.h"
 
 class Table;
@@ -30,15 +33,19 @@ class Operation {
 public:
   enum class Type: int {
     INSERT,
-    UPDATE,
     DELETE,
     UNDEFINED,
   };
 
 public:
-  Operation(Type type, const RID &rid) : type_(type), page_num_(rid.page_num), slot_num_(rid.slot_num){
+  Operation() = default;
+  Operation(Table *table, Type type, const RID &rid)
+      : table_(table), type_(type), page_num_(rid.page_num), slot_num_(rid.slot_num) {
   }
 
+  Table *table() const {
+    return table_;
+  }
   Type type() const {
     return type_;
   }
@@ -49,73 +56,216 @@ public:
     return slot_num_;
   }
 
+  /**
+   * 按(表, 页面, 槽)排序
+   */
+  bool operator<(const Operation &other) const {
+    if (table_ != other.table_) {
+      return table_ < other.table_;
+    }
+    if (page_num_ != other.page_num_) {
+      return page_num_ < other.page_num_;
+    }
+    return slot_num_ < other.slot_num_;
+  }
+
 private:
-  Type type_;
-  PageNum  page_num_;
-  SlotNum  slot_num_;
+  Table *  table_ = nullptr;
+  Type     type_ = Type::UNDEFINED;
+  PageNum  page_num_ = 0;
+  SlotNum  slot_num_ = 0;
 };
-class OperationHasher {
+
+/**
+ * 事务修改过的记录，只追加不查找。
+ * 操作保存在按倍数增长的内存块中，追加一条操作不需要单独分配内存，大事务也不用搬移已有的操作
+ */
+class OperationLog {
 public:
-  size_t operator() (const Operation &op) const {
-    return (((size_t)op.page_num()) << 32) | (op.slot_num());
+  void append(Table *table, Operation::Type type, const RID &rid);
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size() const {
+    return size_;
   }
+  /**
+   * 按(表, 页面, 槽)排好序的所有操作，提交和回滚时同一个表、同一个页面上的记录挨在一起处理
+   */
+  void sorted(std::vector<Operation> &operations) const;
+  /**
+   * 清空操作，保留第一个内存块给这个事务对象之后的事务使用
+   */
+  void clear();
+
+private:
+  struct Block {
+    std::unique_ptr<Operation[]> operations;
+    size_t capacity;
+    size_t size;
+  };
+  std::vector<Block> blocks_;
+  size_t size_ = 0;
 };
 
-class OperationEqualer {
-public:
-  bool operator()(const Operation &op1, const Operation &op2) const {
-    return op1.page_num() == op2.page_num() &&
-           op1.slot_num() == op2.slot_num();
+struct CommitStats {
+  long commits = 0;
+  long total_latency_us = 0;
+  long max_latency_us = 0;
+
+  double mean_latency_us() const {
+    return commits == 0 ? 0 : (double)total_latency_us / commits;
   }
 };
 
 /**
- * 这里是一个简单的事务实现，可以支持提交/回滚。但是没有对并发访问做控制
- * 可以在这个基础上做备份恢复，当然也可以重写
+ * 事务提交的延迟，按实际使用的持久性级别(sync/async/nolog)分别统计，注册在metrics中，名字是Trx.commit
+ */
+class CommitMetric : public common::Metric {
+public:
+  CommitMetric();
+  ~CommitMetric();
+
+  void snapshot() override;
+
+  void record(Durability durability, long latency_us);
+  CommitStats stats(Durability durability) const;
+
+private:
+  struct Counter {
+    std::atomic<long> commits{0};
+    std::atomic<long> total_latency_us{0};
+    std::atomic<long> max_latency_us{0};
+  };
+  Counter counters_[DURABILITY_NOLOG + 1];
+};
+
+CommitMetric &commit_metric();
+
+/**
+ * 多版本的事务，参考MvccManager。
+ * 第一次读取时建立快照，多语句事务之后的读取都使用这个快照，读不到其它事务未提交的修改，也不会被写操作阻塞。
+ * 修改记录之前先加行排他锁(表上加意向排他锁)，记录正在被其它事务修改时等待它结束，锁一直持有到事务结束。
+ * 修改的记录在其它事务的快照之后被删除时返回RC::BUSY_SNAPSHOT(先修改的事务获胜)。
+ * 乐观模式下修改记录不加锁，记下快照中读到的记录，提交前由OccManager检查它们和修改过的记录有没有被
+ * 并发提交的乐观事务修改过，有的话回滚并返回RC::BUSY_SNAPSHOT。乐观事务之间读过的记录是可串行化的(不检查幻读)。
+ * 提交时按持久性级别决定是否等待COMMIT日志落盘，参考commit_durability
  */
 class Trx {
 public:
   static int32_t default_trx_id();
   static int32_t next_trx_id();
+  /**
+   * 当前分配过的最大事务号，提交时间戳也从这里分配
+   */
+  static int32_t current_trx_id();
+  /**
+   * 启动时设置，之后分配的事务号都比max_used_trx_id大
+   */
+  static void init_trx_id(int32_t max_used_trx_id);
   static const char *trx_field_name();
+  static const char *trx_end_field_name();
   static AttrType trx_field_type();
   static int      trx_field_len();
 
+  /**
+   * 记录上的两个事务字段: begin是创建这个版本的事务，end是删除它的事务。
+   * 提交之前是uncommitted_value(事务号)，提交之后是提交时间戳，0表示在所有快照之前创建或者没有被删除
+   */
+  static void get_record_trx_info(Table *table, const Record &record, int32_t &begin, int32_t &end);
+  static void set_record_trx_info(Table *table, Record &record, int32_t begin, int32_t end);
+  static int32_t uncommitted_value(int32_t trx_id);
+  static bool    is_uncommitted(int32_t value);
+  static int32_t trx_id_of(int32_t value);
+
 public:
   Trx();
   ~Trx();
 
 public:
   RC insert_record(Table *table, Record *record);
+  /**
+   * 在页面上的记录上设置删除标记。这个版本已经被其它事务删除或者正在被删除时返回RC::BUSY_SNAPSHOT
+   */
   RC delete_record(Table *table, Record *record);
-  RC update_record(Table *table, Record *record);
+  /**
+   * 修改记录之前加锁，等待超时返回RC::BUSY_TIMEOUT，会形成死锁时返回RC::LOCKED_DEADLOCK
+   */
+  RC lock_record(Table *table, const RID &rid);
 
   RC commit();
   RC rollback();
 
-  RC commit_insert(Table *table, Record &record);
-  RC rollback_delete(Table *table, Record &record);
-
   bool is_visible(Table *table, const Record *record);
+  /**
+   * 读取之前建立快照。先读到的索引项和之后判断可见性要基于同一个快照，
+   * 否则期间提交的删除和插入会让结果多出或者少掉记录
+   */
+  void open_snapshot();
 
   void init_trx_info(Table *table, Record &record);
 
-private:
-  void set_record_trx_id(Table *table, Record &record, int32_t trx_id, bool deleted) const;
-  static void get_record_trx_id(Table *table, const Record &record, int32_t &trx_id, bool &deleted);
+  int32_t trx_id() const {
+    return trx_id_;
+  }
 
-private:
-  using OperationSet = std::unordered_set<Operation, OperationHasher, OperationEqualer>;
+  /**
+   * 会话设置的持久性级别，DURABILITY_DEFAULT表示按修改过的表的设置提交
+   */
+  void set_durability(Durability durability) {
+    durability_ = durability;
+  }
+  Durability durability() const {
+    return durability_;
+  }
 
-  Operation *find_operation(Table *table, const RID &rid);
-  void insert_operation(Table *table, Operation::Type type, const RID &rid);
-  void delete_operation(Table *table, const RID &rid);
+  /**
+   * 是否使用乐观并发控制。在事务开始(第一次读取或修改)之前设置，已经开始的事务保持原来的方式
+   */
+  void set_optimistic(bool optimistic) {
+    optimistic_ = optimistic;
+  }
+  bool optimistic() const {
+    return optimistic_;
+  }
 
 private:
   void start_if_not_started();
+  /**
+   * 乐观模式的事务开始时在OccManager中登记，要在建立快照之前
+   */
+  void begin_optimistic();
+  /**
+   * 提交前检查读写集合，通过时得到提交序号
+   */
+  RC validate_optimistic(const std::vector<Operation> &operations);
+  /**
+   * 第一次读取时建立快照
+   */
+  int32_t snapshot_ts();
+  /**
+   * 记录上的一个事务字段在快照中是否已经提交(自己的修改也算)
+   */
+  bool is_committed_in_snapshot(int32_t value);
+  void end_trx();
+  /**
+   * 这次提交使用的持久性级别: 会话设置了级别时按会话的，否则按修改过的表中最强的(SYNC > ASYNC)。
+   * 不记日志的表不参与，只修改了不记日志的表时返回DURABILITY_NOLOG，不写COMMIT日志
+   */
+  Durability commit_durability(const std::vector<Operation> &operations) const;
 private:
   int32_t  trx_id_ = 0;
-  std::unordered_map<Table *, OperationSet> operations_;
+  bool     has_snapshot_ = false;
+  int32_t  snapshot_ts_ = 0;
+  OperationLog operations_;
+  LockSet  lock_set_;
+  Durability durability_ = DURABILITY_DEFAULT;
+
+  bool     optimistic_ = false;
+  bool     occ_started_ = false;     // 这个事务按乐观模式执行
+  OccStart occ_start_;
+  uint64_t occ_commit_seq_ = 0;      // 通过检查后的提交序号
+  std::vector<LockId> read_set_;     // 乐观事务在快照中读到的记录
 };
 
 #endif // __OBSERVER_STORAGE_TRX_TRX_H_
@@ -0,0 +1,321 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "storage/common/bplus_tree.h"
+
+/**
+ * B+树并发吞吐测试: 不同线程数下插入、点查、范围扫描、删除的吞吐
+ * 用法: bplus_tree_performance_test [每个线程的key个数]
+ */
+
+static RID make_rid(int value) {
+  RID rid;
+  rid.page_num = value / 100 + 1;
+  rid.slot_num = value % 100;
+  return rid;
+}
+
+static double run_threads(int thread_num, const std::function<void(int)> &func) {
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back(func, i);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  return elapsed.count();
+}
+
+static void run_test(int thread_num, int count_per_thread) {
+  const char *index_file = "bplus_tree_performance_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  if (handler.create(index_file, INTS, sizeof(int)) != RC::SUCCESS) {
+    printf("Failed to create index file %s\n", index_file);
+    exit(1);
+  }
+
+  std::vector<std::vector<int>> values(thread_num);
+  for (int t = 0; t < thread_num; t++) {
+    for (int i = 0; i < count_per_thread; i++) {
+      values[t].push_back(i * thread_num + t);
+    }
+    std::shuffle(values[t].begin(), values[t].end(), std::mt19937(t));
+  }
+  const double total = (double)thread_num * count_per_thread;
+
+  double insert_time = run_threads(thread_num, [&](int t) {
+    for (int value : values[t]) {
+      RID rid = make_rid(value);
+      handler.insert_entry((const char *)&value, &rid);
+    }
+  });
+
+  double get_time = run_threads(thread_num, [&](int t) {
+    for (int value : values[t]) {
+      RID rid = make_rid(value);
+      handler.get_entry((const char *)&value, &rid);
+    }
+  });
+
+  // 每个线程做若干次短范围扫描，每次读取100条
+  const int scan_num = std::max(1, count_per_thread / 100);
+  double scan_time = run_threads(thread_num, [&](int t) {
+    for (int i = 0; i < scan_num; i++) {
+      int start = values[t][i];
+      BplusTreeScanner scanner(handler);
+      scanner.open(GREAT_EQUAL, (const char *)&start);
+      RID rid;
+      for (int j = 0; j < 100 && scanner.next_entry(&rid) == RC::SUCCESS; j++) {
+      }
+      scanner.close();
+    }
+  });
+
+  double delete_time = run_threads(thread_num, [&](int t) {
+    for (int value : values[t]) {
+      RID rid = make_rid(value);
+      handler.delete_entry((const char *)&value, &rid);
+    }
+  });
+
+  printf("threads=%2d insert=%10.0f/s get=%10.0f/s scan(100 keys)=%8.0f/s delete=%10.0f/s\n",
+         thread_num, total / insert_time, total / get_time,
+         thread_num * scan_num / scan_time, total / delete_time);
+
+  handler.close();
+  unlink(index_file);
+}
+
+/**
+ * 单线程点查延迟。key越长，节点的扇出越小，树越深
+ */
+static void run_lookup_test(int attr_length, int count) {
+  const char *index_file = "bplus_tree_performance_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  if (handler.create(index_file, CHARS, attr_length) != RC::SUCCESS) {
+    printf("Failed to create index file %s\n", index_file);
+    exit(1);
+  }
+
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  std::vector<char> key(attr_length);
+  for (int value : values) {
+    snprintf(key.data(), attr_length, "%010d", value);
+    RID rid = make_rid(value);
+    handler.insert_entry(key.data(), &rid);
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int value : values) {
+    snprintf(key.data(), attr_length, "%010d", value);
+    RID rid = make_rid(value);
+    handler.get_entry(key.data(), &rid);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+  printf("key length=%4d point lookup=%8.0f ns\n", attr_length, elapsed.count() / count);
+
+  handler.close();
+  unlink(index_file);
+}
+
+/**
+ * 前缀压缩对比: 公共前缀很长的URL和文件路径，分别用定长格式和前缀压缩格式建索引，
+ * 输出每个叶子平均的key个数(扇出)、树高和索引文件大小
+ */
+static void run_prefix_compression_test(const char *name, const char *format, int attr_length, int count) {
+  const char *index_file = "bplus_tree_performance_test.index";
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  std::vector<char> key(attr_length);
+
+  for (bool prefix_compression : {false, true}) {
+    unlink(index_file);
+    BplusTreeHandler handler;
+    if (handler.create(index_file, CHARS, attr_length, prefix_compression) != RC::SUCCESS) {
+      printf("Failed to create index file %s\n", index_file);
+      exit(1);
+    }
+    for (int value : values) {
+      snprintf(key.data(), attr_length, format, value % 97, value);
+      RID rid = make_rid(value);
+      handler.insert_entry(key.data(), &rid);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int value : values) {
+      snprintf(key.data(), attr_length, format, value % 97, value);
+      RID rid = make_rid(value);
+      handler.get_entry(key.data(), &rid);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+
+    int key_count = 0;
+    int leaf_count = 0;
+    handler.validate_tree(&key_count, &leaf_count);
+    const int height = handler.height();
+    handler.close();
+    struct stat st;
+    stat(index_file, &st);
+    printf("%-5s %-6s keys/leaf=%6.1f height=%d file size=%8ld KB point lookup=%8.0f ns\n",
+           name, prefix_compression ? "prefix" : "fixed", (double)key_count / leaf_count, height,
+           (long)st.st_size / 1024, elapsed.count() / count);
+  }
+  unlink(index_file);
+}
+
+/**
+ * 上层内部节点缓存对比: 缓存预算为0时每次查找都从根节点经过缓冲池，否则只有叶子节点经过缓冲池
+ */
+static void run_upper_level_test(int thread_num, int count_per_thread) {
+  const char *index_file = "bplus_tree_performance_test.index";
+  unlink(index_file);
+
+  const int attr_length = 64;
+  BplusTreeHandler handler;
+  if (handler.create(index_file, CHARS, attr_length, false) != RC::SUCCESS) {
+    printf("Failed to create index file %s\n", index_file);
+    exit(1);
+  }
+  const int count = thread_num * count_per_thread;
+  std::vector<char> key(attr_length);
+  for (int value = 0; value < count; value++) {
+    snprintf(key.data(), attr_length, "%010d", value);
+    RID rid = make_rid(value);
+    handler.insert_entry(key.data(), &rid);
+  }
+
+  const int budgets[] = {0, BplusTreeOptions::instance().upper_level_pages};
+  for (int budget : budgets) {
+    handler.set_upper_level_pages(budget);
+    double get_time = run_threads(thread_num, [&](int t) {
+      std::vector<char> thread_key(attr_length);
+      std::mt19937 random(t);
+      for (int i = 0; i < count_per_thread; i++) {
+        int value = random() % count;
+        snprintf(thread_key.data(), attr_length, "%010d", value);
+        RID rid = make_rid(value);
+        handler.get_entry(thread_key.data(), &rid);
+      }
+    });
+    printf("threads=%2d height=%d cached pages=%4d cached levels=%d get=%10.0f/s\n",
+           thread_num, handler.height(), handler.upper_level_pages(), handler.upper_level_depth(),
+           count / get_time);
+  }
+
+  handler.close();
+  unlink(index_file);
+}
+
+/**
+ * MIN/MAX: 从树的两端读取第一个索引项，和正向扫描到最后一个索引项对比
+ */
+static void run_min_max_test(int count) {
+  const char *index_file = "bplus_tree_performance_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  if (handler.create(index_file, INTS, sizeof(int)) != RC::SUCCESS) {
+    printf("Failed to create index file %s\n", index_file);
+    exit(1);
+  }
+  for (int value = 0; value < count; value++) {
+    RID rid = make_rid(value);
+    handler.insert_entry((const char *)&value, &rid);
+  }
+
+  const int rounds = 1000;
+  RID rid;
+  int key;
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    BplusTreeScanner scanner(handler);
+    scanner.open(NO_OP, (const char *)&key);
+    scanner.next_entry(&rid, (char *)&key);
+    scanner.close();
+  }
+  std::chrono::duration<double, std::nano> min_elapsed = std::chrono::steady_clock::now() - begin;
+
+  begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    BplusTreeReverseScanner scanner(handler);
+    scanner.next_entry(&rid, (char *)&key);
+  }
+  std::chrono::duration<double, std::nano> max_elapsed = std::chrono::steady_clock::now() - begin;
+
+  begin = std::chrono::steady_clock::now();
+  BplusTreeScanner scanner(handler);
+  scanner.open(NO_OP, (const char *)&key);
+  while (scanner.next_entry(&rid, (char *)&key) == RC::SUCCESS) {
+  }
+  scanner.close();
+  std::chrono::duration<double, std::nano> scan_elapsed = std::chrono::steady_clock::now() - begin;
+  printf("keys=%d min=%8.0f ns max=%8.0f ns full scan=%10.0f ns\n",
+         count, min_elapsed.count() / rounds, max_elapsed.count() / rounds, scan_elapsed.count());
+
+  handler.close();
+  unlink(index_file);
+}
+
+int main(int argc, char **argv) {
+  int count_per_thread = 20000;
+  if (argc > 1) {
+    count_per_thread = atoi(argv[1]);
+  }
+
+  const int thread_nums[] = {1, 2, 4, 8, 16};
+  for (int thread_num : thread_nums) {
+    run_test(thread_num, count_per_thread);
+  }
+
+  const int attr_lengths[] = {16, 64, 256};
+  for (int attr_length : attr_lengths) {
+    run_lookup_test(attr_length, count_per_thread);
+  }
+
+  for (int thread_num : {1, 4, 16}) {
+    run_upper_level_test(thread_num, count_per_thread);
+  }
+
+  run_min_max_test(count_per_thread * 16);
+
+  run_prefix_compression_test("url", "https://www.example.com/static/images/category_%03d/item_%08d.png",
+                              128, count_per_thread);
+  run_prefix_compression_test("path", "/data/minidb/warehouse/tables/partition_%03d/segment_%08d.dat",
+                              128, count_per_thread);
+  return 0;
+}
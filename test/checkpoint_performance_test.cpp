@@ -0,0 +1,150 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/clog.h"
+#include "storage/common/record_manager.h"
+#include "test_util.h"
+
+/**
+ * 检查点测试: 前台线程不停地原地更新随机的记录(页面比缓冲池大，会有页面换出)，
+ * 后台线程连续做检查点，分别测试一次写回所有脏页和按限速、分批写回时前台更新的延迟分布和检查点的耗时。
+ * 前台不提交，日志一直在追加，写回的页面大多要先等日志落盘
+ * 用法: checkpoint_performance_test [每种配置的运行时间(秒)] [记录数]
+ */
+
+static const int RECORD_SIZE = 64;
+
+struct Config {
+  const char *name;
+  int flush_rate;
+  int max_pause;
+};
+
+static void check(RC rc, const char *action) {
+  if (rc != RC::SUCCESS) {
+    printf("Failed to %s. rc=%d:%s\n", action, rc, strrc(rc));
+    exit(1);
+  }
+}
+
+static void run_test(const std::string &dir, const Config &config, int seconds, int record_num) {
+  CLogOptions options = CLogOptions::instance();
+  options.checkpoint_size = 0;  // 检查点由测试线程发起
+  options.checkpoint_flush_rate = config.flush_rate;
+  options.checkpoint_max_pause = config.max_pause;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  const std::string clog_file = dir + "/" + config.name + ".clog";
+  const std::string data_file = dir + "/" + config.name + ".data";
+  check(clog_manager->open(clog_file.c_str(), options), "open clog");
+  check(clog_manager->recover(*buffer_pool), "recover clog");
+
+  int file_id;
+  RecordFileHandler record_handler;
+  check(buffer_pool->create_file(data_file.c_str()), "create data file");
+  check(buffer_pool->open_file(data_file.c_str(), &file_id), "open data file");
+  check(record_handler.init(*buffer_pool, file_id), "init record file");
+  std::vector<RID> rids(record_num);
+  char data[RECORD_SIZE];
+  memset(data, 0, sizeof(data));
+  for (int i = 0; i < record_num; i++) {
+    check(record_handler.insert_record(data, RECORD_SIZE, &rids[i]), "insert record");
+  }
+  const CLogStats begin_stats = clog_manager->stats();
+
+  std::atomic<bool> stop{false};
+  std::vector<double> checkpoint_times;
+  std::thread checkpointer([&]() {
+    while (!stop.load()) {
+      auto begin = std::chrono::steady_clock::now();
+      check(clog_manager->checkpoint(true), "checkpoint");
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+      checkpoint_times.push_back(elapsed.count());
+    }
+  });
+
+  std::mt19937 random(1);
+  std::uniform_int_distribution<int> dist(0, record_num - 1);
+  std::vector<double> latencies;
+  auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+  while (std::chrono::steady_clock::now() < end) {
+    const RID &rid = rids[dist(random)];
+    auto begin = std::chrono::steady_clock::now();
+    RC rc = record_handler.update_record_in_place(&rid, [](Record &record) {
+      record.data[0]++;
+      return RC::SUCCESS;
+    });
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+    check(rc, "update record");
+    latencies.push_back(elapsed.count());
+  }
+  stop.store(true);
+  checkpointer.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  double checkpoint_total = 0;
+  for (double time : checkpoint_times) {
+    checkpoint_total += time;
+  }
+  const CLogStats stats = clog_manager->stats();
+  printf("%-10s rate=%5d pause=%5dus updates=%8zu p50=%7.1fus p99=%8.1fus max=%9.1fus "
+         "checkpoints=%4zu mean checkpoint=%8.2fms pages=%7ld\n",
+         config.name, config.flush_rate, config.max_pause, latencies.size(), latencies[latencies.size() / 2],
+         latencies[latencies.size() * 99 / 100], latencies.back(), checkpoint_times.size(),
+         checkpoint_total / std::max<size_t>(1, checkpoint_times.size()),
+         stats.checkpoint_pages - begin_stats.checkpoint_pages);
+
+  record_handler.close();
+  check(buffer_pool->close_file(file_id), "close data file");
+  check(clog_manager->close(), "close clog");
+}
+
+int main(int argc, char **argv) {
+  int seconds = 3;
+  int record_num = 100000;
+  if (argc > 1) {
+    seconds = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    record_num = atoi(argv[2]);
+  }
+
+  const std::string dir = make_temp_dir("checkpoint_performance_test");
+  if (dir.empty()) {
+    return 1;
+  }
+  // 不限速、持有缓冲池的锁一次写回所有脏页；之后是分批、限速的后台检查点
+  const Config configs[] = {
+      {"unbounded", 0, 0},
+      {"bounded", 0, 100},
+      {"throttled", 2000, 100},
+  };
+  for (const Config &config : configs) {
+    run_test(dir, config, seconds, record_num);
+  }
+
+  remove_temp_dir(dir);
+  return 0;
+}
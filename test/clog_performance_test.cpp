@@ -0,0 +1,142 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/clog.h"
+#include "storage/common/bplus_tree.h"
+#include "storage/common/record_manager.h"
+
+/**
+ * redo日志组提交测试: 不同线程数下的持久化自动提交插入吞吐。
+ * 每次插入写一条记录和一个索引项，然后追加COMMIT日志并等待落盘
+ * 用法: clog_performance_test [每个线程的插入次数] [组提交等待时间(微秒)]
+ */
+
+static const int RECORD_SIZE = 64;
+
+static double run_threads(int thread_num, const std::function<void(int)> &func) {
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back(func, i);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  return elapsed.count();
+}
+
+static void remove_clog(const char *clog_file) {
+  std::string command = std::string("rm -f ") + clog_file + ".*";
+  if (system(command.c_str()) != 0) {
+    printf("Failed to remove redo log %s\n", clog_file);
+  }
+}
+
+static void run_test(int thread_num, int count_per_thread, int commit_delay) {
+  const char *clog_file = "clog_performance_test.clog";
+  const char *data_file = "clog_performance_test.data";
+  const char *index_file = "clog_performance_test.index";
+  remove_clog(clog_file);
+  unlink(data_file);
+  unlink(index_file);
+
+  CLogOptions options = CLogOptions::instance();
+  options.commit_delay = commit_delay;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  if (clog_manager->open(clog_file, options) != RC::SUCCESS ||
+      clog_manager->recover(*buffer_pool) != RC::SUCCESS) {
+    printf("Failed to open redo log %s\n", clog_file);
+    exit(1);
+  }
+
+  int file_id;
+  RecordFileHandler record_handler;
+  BplusTreeHandler index_handler;
+  if (buffer_pool->create_file(data_file) != RC::SUCCESS ||
+      buffer_pool->open_file(data_file, &file_id) != RC::SUCCESS ||
+      record_handler.init(*buffer_pool, file_id) != RC::SUCCESS ||
+      index_handler.create(index_file, INTS, sizeof(int)) != RC::SUCCESS) {
+    printf("Failed to create data file %s or index file %s\n", data_file, index_file);
+    exit(1);
+  }
+
+  // 记录文件的修改和表一样串行执行，索引支持并发插入
+  std::mutex record_lock;
+  const CLogStats begin_stats = clog_manager->stats();
+  double elapsed = run_threads(thread_num, [&](int t) {
+    char data[RECORD_SIZE];
+    memset(data, 0, sizeof(data));
+    for (int i = 0; i < count_per_thread; i++) {
+      int value = i * thread_num + t;
+      memcpy(data, &value, sizeof(value));
+      RID rid;
+      {
+        std::lock_guard<std::mutex> guard(record_lock);
+        record_handler.insert_record(data, RECORD_SIZE, &rid);
+      }
+      index_handler.insert_entry((const char *)&value, &rid);
+
+      LSN lsn;
+      clog_manager->append(CLogType::COMMIT, value + 1, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn);
+      clog_manager->sync(lsn);
+      clog_manager->append(CLogType::TRX_END, value + 1, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn);
+    }
+  });
+  const CLogStats stats = clog_manager->stats();
+  const long commits = stats.commits - begin_stats.commits;
+  const long syncs = stats.syncs - begin_stats.syncs;
+
+  printf("threads=%2d commit delay=%4dus durable insert=%9.0f/s fdatasync=%7.0f/s commits/fdatasync=%6.1f "
+         "log bytes/insert=%5.0f\n",
+         thread_num, commit_delay, commits / elapsed, syncs / elapsed, (double)commits / std::max(1L, syncs),
+         (double)(stats.bytes - begin_stats.bytes) / std::max(1L, commits));
+
+  index_handler.close();
+  record_handler.close();
+  buffer_pool->close_file(file_id);
+  clog_manager->close();
+  remove_clog(clog_file);
+  unlink(data_file);
+  unlink(index_file);
+  unlink(BplusTreeHandler::bloom_filter_file(index_file).c_str());
+}
+
+int main(int argc, char **argv) {
+  int count_per_thread = 2000;
+  int commit_delay = 0;
+  if (argc > 1) {
+    count_per_thread = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    commit_delay = atoi(argv[2]);
+  }
+
+  for (int thread_num : {1, 2, 4, 8, 16, 32}) {
+    run_test(thread_num, count_per_thread, commit_delay);
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "storage/clog/clog.h"
+#include "storage/common/meta_util.h"
+#include "storage/common/table.h"
+#include "storage/trx/mvcc_manager.h"
+#include "storage/trx/trx.h"
+#include "test_util.h"
+
+/**
+ * 持久性级别测试: 打开redo日志，每个事务插入一条记录后提交(写入密集的会话)，
+ * 分别测试同步提交、异步提交和不记日志的表的提交吞吐和延迟
+ * 用法: durability_performance_test [事务数]
+ */
+
+static void check(RC rc, const char *action) {
+  if (rc != RC::SUCCESS) {
+    printf("Failed to %s. rc=%d:%s\n", action, rc, strrc(rc));
+    exit(1);
+  }
+}
+
+static void run_test(const std::string &dir, const char *table_name, Durability table_durability,
+                     Durability session_durability, int trx_num) {
+  AttrInfo attributes[] = {
+      {(char *)"id", INTS, sizeof(int)},
+      {(char *)"value", INTS, sizeof(int)},
+  };
+  Table table;
+  check(table.create(table_meta_file(dir.c_str(), table_name).c_str(), table_name, dir.c_str(), 2, attributes,
+                     table_durability),
+        "create table");
+
+  CLogManager *clog_manager = theGlobalCLogManager();
+  const CLogStats clog_stats = clog_manager->stats();
+  Trx trx;
+  trx.set_durability(session_durability);
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < trx_num; i++) {
+    Value values[] = {{INTS, &i}, {INTS, &i}};
+    check(table.insert_record(&trx, 2, values), "insert record");
+    check(trx.commit(), "commit");
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+  const Durability durability = table_durability == DURABILITY_NOLOG ? DURABILITY_NOLOG :
+      session_durability != DURABILITY_DEFAULT ? session_durability : table_durability;
+  const CommitStats stats = commit_metric().stats(durability);
+  printf("table=%-6s session=%-8s commits=%7d trx=%9.0f/s mean commit=%8.1fus max commit=%7ldus syncs=%6ld\n",
+         durability_name(table_durability), durability_name(session_durability), trx_num, trx_num / elapsed.count(),
+         stats.mean_latency_us(), stats.max_latency_us, clog_manager->stats().syncs - clog_stats.syncs);
+  theGlobalMvccManager()->remove_table(&table);
+}
+
+int main(int argc, char **argv) {
+  int trx_num = 5000;
+  if (argc > 1) {
+    trx_num = atoi(argv[1]);
+  }
+
+  theGlobalMvccManager()->stop();
+
+  const std::string dir = make_temp_dir("durability_performance_test");
+  if (dir.empty()) {
+    return 1;
+  }
+  CLogManager *clog_manager = theGlobalCLogManager();
+  check(clog_manager->open((dir + "/clog").c_str()), "open clog");
+  check(clog_manager->recover(*theGlobalDiskBufferPool()), "recover clog");
+
+  // 每种级别只跑一次，commit_metric的统计就是这一次的
+  run_test(dir, "t_sync", DURABILITY_SYNC, DURABILITY_DEFAULT, trx_num);
+  run_test(dir, "t_async", DURABILITY_SYNC, DURABILITY_ASYNC, trx_num);
+  run_test(dir, "t_nolog", DURABILITY_NOLOG, DURABILITY_DEFAULT, trx_num);
+
+  check(clog_manager->close(), "close clog");
+  remove_temp_dir(dir);
+  return 0;
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "storage/trx/lock_manager.h"
+
+/**
+ * 锁管理器测试: 每个事务对若干条记录加排他锁，然后全部释放。
+ * 分别测试每个线程修改不同记录(没有冲突，全部走快速路径)和所有线程修改少量热点记录的吞吐
+ * 用法: lock_manager_performance_test [每个线程的事务数] [每个事务加锁的记录数]
+ */
+
+static Table *const TABLE = (Table *)0x1000;
+
+static void run_test(int thread_num, int trx_per_thread, int rows_per_trx, int hot_rows) {
+  LockManager lock_manager;
+  std::atomic<int32_t> next_trx_id{1};
+  std::atomic<long> failures{0};
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < trx_per_thread; i++) {
+        const int32_t trx_id = next_trx_id++;
+        LockSet lock_set;
+        RC rc = lock_manager.lock(trx_id, lock_set, LockId::table_lock(TABLE), LockMode::IX);
+        for (int r = 0; rc == RC::SUCCESS && r < rows_per_trx; r++) {
+          RID rid;
+          if (hot_rows > 0) {
+            // 所有事务按同样的顺序加锁，不会死锁
+            rid.page_num = 1;
+            rid.slot_num = r % hot_rows;
+          } else {
+            rid.page_num = t + 1;
+            rid.slot_num = i * rows_per_trx + r;
+          }
+          rc = lock_manager.lock(trx_id, lock_set, LockId::record_lock(TABLE, rid), LockMode::X);
+        }
+        if (rc != RC::SUCCESS) {
+          failures++;
+        }
+        lock_manager.unlock_all(trx_id, lock_set);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+  const LockStats stats = lock_manager.stats();
+  const long locks = (long)thread_num * trx_per_thread * (rows_per_trx + 1);
+  printf("threads=%2d hot rows=%d locks=%8ld lock/unlock=%10.0f/s slow acquires=%8ld waits=%7ld deadlocks=%ld "
+         "timeouts=%ld failures=%ld\n",
+         thread_num, hot_rows, locks, locks / elapsed.count(), stats.slow_acquires, stats.waits, stats.deadlocks,
+         stats.timeouts, failures.load());
+}
+
+int main(int argc, char **argv) {
+  int trx_per_thread = 20000;
+  int rows_per_trx = 10;
+  if (argc > 1) {
+    trx_per_thread = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    rows_per_trx = atoi(argv[2]);
+  }
+
+  for (int hot_rows : {0, 4}) {
+    for (int thread_num : {1, 2, 4, 8}) {
+      run_test(thread_num, trx_per_thread, rows_per_trx, hot_rows);
+    }
+  }
+  return 0;
+}
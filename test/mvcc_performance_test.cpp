@@ -0,0 +1,266 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/common/condition_filter.h"
+#include "storage/common/meta_util.h"
+#include "storage/common/table.h"
+#include "storage/trx/lock_manager.h"
+#include "storage/trx/mvcc_manager.h"
+#include "storage/trx/trx.h"
+#include "test_util.h"
+
+/**
+ * 多版本并发控制测试: 多个线程在账户之间转账(读两个账户的余额，再分别更新)，冲突时回滚重试。
+ * 分别测试没有读事务和有一个长时间运行的快照读事务时的转账吞吐，快照读每次扫描的总余额都应该不变。
+ * 表上的每条语句和表一样串行执行，事务之间交错进行。清理旧版本也在语句之间进行
+ * 用法: mvcc_performance_test [每个线程的转账次数] [转账线程数] [账户数]
+ */
+
+static const int INIT_BALANCE = 1000;
+// 账户号用定长字符串保存，整数字段上的等值条件还不能正确比较
+static const int ID_LEN = 12;
+
+struct Bench {
+  Table *table = nullptr;
+  int id_offset = 0;
+  int balance_offset = 0;
+  std::mutex statement_lock;
+};
+
+struct ScanContext {
+  int offset;
+  int count;
+  long balance;
+};
+
+static void sum_reader(const char *data, void *context) {
+  ScanContext *scan_context = (ScanContext *)context;
+  scan_context->count++;
+  scan_context->balance += *(const int *)(data + scan_context->offset);
+}
+
+static ScanContext scan(Bench &bench, Trx *trx, ConditionFilter *filter) {
+  ScanContext context = {bench.balance_offset, 0, 0};
+  std::lock_guard<std::mutex> guard(bench.statement_lock);
+  RC rc = bench.table->scan_record(trx, filter, -1, &context, sum_reader);
+  if (rc != RC::SUCCESS) {
+    printf("Failed to scan table. rc=%d:%s\n", rc, strrc(rc));
+    exit(1);
+  }
+  return context;
+}
+
+static void make_id(int id, char *buffer) {
+  memset(buffer, 0, ID_LEN);
+  snprintf(buffer, ID_LEN, "%d", id);
+}
+
+class AccountFilter {
+public:
+  AccountFilter(Bench &bench, int id) {
+    make_id(id, id_);
+    ConDesc left = {true, ID_LEN, bench.id_offset, nullptr};
+    ConDesc right = {false, 0, 0, id_};
+    filter_.init(left, right, INTS, EQUAL_TO);
+    filters_[0] = &filter_;
+    composite_.init(filters_, 1);
+  }
+
+  CompositeConditionFilter *filter() {
+    return &composite_;
+  }
+
+private:
+  char id_[ID_LEN];
+  DefaultConditionFilter filter_;
+  const ConditionFilter *filters_[1];
+  CompositeConditionFilter composite_;
+};
+
+static RC transfer(Bench &bench, Trx *trx, int from, int to, int amount) {
+  AccountFilter from_filter(bench, from);
+  AccountFilter to_filter(bench, to);
+  const long from_balance = scan(bench, trx, from_filter.filter()).balance;
+  const long to_balance = scan(bench, trx, to_filter.filter()).balance;
+
+  int new_balances[] = {(int)(from_balance - amount), (int)(to_balance + amount)};
+  CompositeConditionFilter *filters[] = {from_filter.filter(), to_filter.filter()};
+  for (int i = 0; i < 2; i++) {
+    Value value = {INTS, &new_balances[i]};
+    std::lock_guard<std::mutex> guard(bench.statement_lock);
+    RC rc = bench.table->update_record(trx, "balance", &value, filters[i], nullptr);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+static void create_table(Bench &bench, const std::string &dir, int account_num) {
+  AttrInfo attributes[] = {
+      {(char *)"id", CHARS, ID_LEN},
+      {(char *)"balance", INTS, sizeof(int)},
+  };
+  bench.table = new Table();
+  if (bench.table->create(table_meta_file(dir.c_str(), "account").c_str(), "account", dir.c_str(), 2, attributes) !=
+      RC::SUCCESS) {
+    printf("Failed to create table in %s\n", dir.c_str());
+    exit(1);
+  }
+  bench.id_offset = bench.table->table_meta().field("id")->offset();
+  bench.balance_offset = bench.table->table_meta().field("balance")->offset();
+
+  Trx trx;
+  for (int i = 0; i < account_num; i++) {
+    char id[ID_LEN];
+    make_id(i, id);
+    int balance = INIT_BALANCE;
+    Value values[] = {{CHARS, id}, {INTS, &balance}};
+    if (bench.table->insert_record(&trx, 2, values) != RC::SUCCESS) {
+      printf("Failed to insert account %d\n", i);
+      exit(1);
+    }
+  }
+  trx.commit();
+}
+
+static void run_test(const std::string &dir, int count_per_thread, int thread_num, int account_num,
+                     bool long_reader) {
+  Bench bench;
+  create_table(bench, dir, account_num);
+  MvccManager *mvcc_manager = theGlobalMvccManager();
+  const MvccStats begin_stats = mvcc_manager->stats();
+  const long total = (long)account_num * INIT_BALANCE;
+
+  std::atomic<bool> writers_done{false};
+  std::atomic<long> conflicts{0};
+  long reader_scans = 0;
+  long wrong_sums = 0;
+  int max_versions = 0;
+  std::thread reader;
+  if (long_reader) {
+    // 一个事务的快照一直打开到转账结束，期间修改的旧版本都不能清理
+    reader = std::thread([&]() {
+      Trx trx;
+      while (!writers_done.load()) {
+        if (scan(bench, &trx, nullptr).balance != total) {
+          wrong_sums++;
+        }
+        reader_scans++;
+      }
+      max_versions = scan(bench, nullptr, nullptr).count;
+      trx.commit();
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> writers;
+  for (int t = 0; t < thread_num; t++) {
+    writers.emplace_back([&, t]() {
+      std::mt19937 random(t);
+      for (int i = 0; i < count_per_thread; i++) {
+        const int from = random() % account_num;
+        const int to = (from + 1 + random() % (account_num - 1)) % account_num;
+        while (true) {
+          Trx trx;
+          RC rc = transfer(bench, &trx, from, to, random() % 100);
+          if (rc == RC::SUCCESS) {
+            rc = trx.commit();
+          } else {
+            trx.rollback();
+          }
+          if (rc == RC::SUCCESS) {
+            break;
+          }
+          if (rc != RC::BUSY_SNAPSHOT && rc != RC::BUSY_TIMEOUT && rc != RC::LOCKED_DEADLOCK) {
+            printf("Failed to transfer. rc=%d:%s\n", rc, strrc(rc));
+            exit(1);
+          }
+          conflicts++;
+        }
+        if (i % 64 == 0) {
+          std::lock_guard<std::mutex> guard(bench.statement_lock);
+          mvcc_manager->collect_garbage();
+        }
+      }
+    });
+  }
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  writers_done = true;
+  if (reader.joinable()) {
+    reader.join();
+  }
+
+  Trx checker;
+  const long final_sum = scan(bench, &checker, nullptr).balance;
+  checker.commit();
+  mvcc_manager->collect_garbage();
+  const int versions_after_gc = scan(bench, nullptr, nullptr).count;
+  const MvccStats stats = mvcc_manager->stats();
+
+  const long transfers = (long)count_per_thread * thread_num;
+  printf("threads=%2d long snapshot=%d transfer=%8.0f/s conflicts=%6ld reader scans=%5ld wrong sums=%ld "
+         "final sum %s max versions=%7d versions after gc=%6d purged=%ld\n",
+         thread_num, long_reader ? 1 : 0, transfers / elapsed.count(), conflicts.load(), reader_scans, wrong_sums,
+         final_sum == total ? "ok" : "WRONG", max_versions, versions_after_gc,
+         stats.purged_records - begin_stats.purged_records);
+
+  mvcc_manager->remove_table(bench.table);
+  delete bench.table;
+}
+
+int main(int argc, char **argv) {
+  int count_per_thread = 2000;
+  int thread_num = 4;
+  int account_num = 1000;
+  if (argc > 1) {
+    count_per_thread = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    thread_num = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    account_num = atoi(argv[3]);
+  }
+
+  // 后台清理线程和转账语句之间没有页面锁，改成在语句之间清理
+  theGlobalMvccManager()->stop();
+  // 语句之间用一个锁串行执行，在语句中等待行锁会挡住持有行锁的事务，冲突时不等待直接重试
+  LockOptions::instance().wait_timeout = 0;
+
+  for (bool long_reader : {false, true}) {
+    const std::string dir = make_temp_dir("mvcc_performance_test");
+    if (dir.empty()) {
+      return 1;
+    }
+    run_test(dir, count_per_thread, thread_num, account_num, long_reader);
+    remove_temp_dir(dir);
+  }
+  return 0;
+}
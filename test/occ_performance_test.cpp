@@ -0,0 +1,163 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "storage/trx/lock_manager.h"
+#include "storage/trx/occ_manager.h"
+
+/**
+ * 并发控制测试: 每个事务读几条记录、修改几条记录，分别用悲观的行锁(读加共享锁、写加排他锁，持有到事务结束)
+ * 和乐观的提交前检查执行，冲突(死锁、超时、检查失败)后重试同一个事务。
+ * 记录从很多条中随机选(低冲突)或者从少量热点记录中选(高冲突)，测试不同线程数下提交的吞吐和重试次数
+ * 用法: occ_performance_test [每个线程的事务数] [每个事务读的记录数] [每个事务写的记录数]
+ */
+
+static Table *const TABLE = (Table *)0x1000;
+static const int COLD_ROWS = 1000000;
+static const int ROW_ACCESS_SPINS = 200;   // 模拟读写一条记录的工作，两种方式下都在事务执行期间进行
+
+struct Workload {
+  int trx_per_thread;
+  int reads;
+  int writes;
+  int rows;   // 从多少条记录中选
+};
+
+static LockId row(int key) {
+  RID rid;
+  rid.page_num = key / 1000 + 1;
+  rid.slot_num = key % 1000;
+  return LockId::record_lock(TABLE, rid);
+}
+
+static void access_row(const LockId &id) {
+  volatile int value = id.rid.slot_num;
+  for (int i = 0; i < ROW_ACCESS_SPINS; i++) {
+    value = value * 31 + i;
+  }
+}
+
+static void pick_rows(std::mt19937 &random, const Workload &workload, std::vector<LockId> &reads,
+                      std::vector<LockId> &writes) {
+  reads.clear();
+  writes.clear();
+  std::uniform_int_distribution<int> dist(0, workload.rows - 1);
+  for (int i = 0; i < workload.reads; i++) {
+    reads.push_back(row(dist(random)));
+  }
+  for (int i = 0; i < workload.writes; i++) {
+    writes.push_back(row(dist(random)));
+  }
+}
+
+static bool run_pessimistic(LockManager &lock_manager, int32_t trx_id, const std::vector<LockId> &reads,
+                            const std::vector<LockId> &writes) {
+  LockSet lock_set;
+  RC rc = lock_manager.lock(trx_id, lock_set, LockId::table_lock(TABLE), LockMode::IX);
+  for (size_t i = 0; rc == RC::SUCCESS && i < reads.size(); i++) {
+    rc = lock_manager.lock(trx_id, lock_set, reads[i], LockMode::S);
+    access_row(reads[i]);
+  }
+  for (size_t i = 0; rc == RC::SUCCESS && i < writes.size(); i++) {
+    rc = lock_manager.lock(trx_id, lock_set, writes[i], LockMode::X);
+    access_row(writes[i]);
+  }
+  lock_manager.unlock_all(trx_id, lock_set);
+  return rc == RC::SUCCESS;
+}
+
+static bool run_optimistic(OccManager &occ_manager, const std::vector<LockId> &reads,
+                           const std::vector<LockId> &writes) {
+  OccStart start;
+  occ_manager.begin(start);
+  // 执行期间只记下读写集合
+  std::vector<LockId> read_set;
+  std::vector<LockId> write_set;
+  for (const LockId &id : reads) {
+    read_set.push_back(id);
+    access_row(id);
+  }
+  for (const LockId &id : writes) {
+    write_set.push_back(id);
+    access_row(id);
+  }
+  uint64_t commit_seq = 0;
+  RC rc = occ_manager.validate(start, read_set, write_set, &commit_seq);
+  occ_manager.finish(start, rc == RC::SUCCESS ? commit_seq : 0);
+  return rc == RC::SUCCESS;
+}
+
+static void run_test(bool optimistic, int thread_num, const Workload &workload) {
+  LockManager lock_manager;
+  OccManager occ_manager;
+  std::atomic<int32_t> next_trx_id{1};
+  std::atomic<long> retries{0};
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937 random(t + 1);
+      std::vector<LockId> reads;
+      std::vector<LockId> writes;
+      for (int i = 0; i < workload.trx_per_thread; i++) {
+        pick_rows(random, workload, reads, writes);
+        while (!(optimistic ? run_optimistic(occ_manager, reads, writes)
+                            : run_pessimistic(lock_manager, next_trx_id++, reads, writes))) {
+          retries++;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+  const long commits = (long)thread_num * workload.trx_per_thread;
+  printf("%-11s threads=%2d rows=%7d commits=%8ld trx=%10.0f/s retries=%8ld\n",
+         optimistic ? "optimistic" : "pessimistic", thread_num, workload.rows, commits, commits / elapsed.count(),
+         retries.load());
+}
+
+int main(int argc, char **argv) {
+  Workload workload = {100000, 4, 2, COLD_ROWS};
+  if (argc > 1) {
+    workload.trx_per_thread = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    workload.reads = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    workload.writes = atoi(argv[3]);
+  }
+
+  // 热点记录上死锁后要尽快重试
+  LockOptions::instance().wait_timeout = 100;
+  for (int rows : {COLD_ROWS, 16}) {
+    workload.rows = rows;
+    for (int thread_num : {1, 2, 4, 8}) {
+      run_test(false, thread_num, workload);
+      run_test(true, thread_num, workload);
+    }
+  }
+  return 0;
+}
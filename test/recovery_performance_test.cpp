@@ -0,0 +1,161 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/clog.h"
+#include "storage/common/bplus_tree.h"
+#include "storage/common/record_manager.h"
+
+/**
+ * 崩溃恢复测试: 子进程多线程插入(每次插入后提交并等待日志落盘)，运行一段时间后kill -9，
+ * 然后在数据目录的多个副本上分别用不同的线程数恢复，输出重放的日志条数和耗时。
+ * 日志和数据文件使用相对路径，每个副本在自己的目录中恢复
+ * 用法: recovery_performance_test [加载时间(秒)] [加载线程数]
+ */
+
+static const int RECORD_SIZE = 64;
+static const char *CLOG_FILE = "clog";
+static const char *DATA_FILE = "recovery.data";
+static const char *INDEX_FILE = "recovery.index";
+
+static void run_command(const std::string &command) {
+  if (system(command.c_str()) != 0) {
+    printf("Failed to run %s\n", command.c_str());
+    exit(1);
+  }
+}
+
+static void run_load(int thread_num) {
+  CLogOptions options = CLogOptions::instance();
+  options.checkpoint_size = 0;  // 崩溃前不做检查点，恢复时重放所有的日志
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  int file_id;
+  RecordFileHandler record_handler;
+  BplusTreeHandler index_handler;
+  if (clog_manager->open(CLOG_FILE, options) != RC::SUCCESS || clog_manager->recover(*buffer_pool) != RC::SUCCESS ||
+      buffer_pool->create_file(DATA_FILE) != RC::SUCCESS || buffer_pool->open_file(DATA_FILE, &file_id) != RC::SUCCESS ||
+      record_handler.init(*buffer_pool, file_id) != RC::SUCCESS ||
+      index_handler.create(INDEX_FILE, INTS, sizeof(int)) != RC::SUCCESS) {
+    _exit(1);
+  }
+
+  // 一直插入，直到被父进程杀掉
+  std::mutex record_lock;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      char data[RECORD_SIZE];
+      memset(data, 0, sizeof(data));
+      for (int i = 0; ; i++) {
+        int value = i * thread_num + t;
+        memcpy(data, &value, sizeof(value));
+        RID rid;
+        {
+          std::lock_guard<std::mutex> guard(record_lock);
+          record_handler.insert_record(data, RECORD_SIZE, &rid);
+        }
+        index_handler.insert_entry((const char *)&value, &rid);
+
+        LSN lsn;
+        clog_manager->append(CLogType::COMMIT, value + 1, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn);
+        clog_manager->sync(lsn);
+        clog_manager->append(CLogType::TRX_END, value + 1, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+static void recover(const std::string &dir, int recovery_threads) {
+  if (chdir(dir.c_str()) != 0) {
+    printf("Failed to enter %s\n", dir.c_str());
+    exit(1);
+  }
+
+  CLogOptions options = CLogOptions::instance();
+  options.recovery_threads = recovery_threads;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  auto begin = std::chrono::steady_clock::now();
+  if (clog_manager->open(CLOG_FILE, options) != RC::SUCCESS ||
+      clog_manager->recover(*theGlobalDiskBufferPool()) != RC::SUCCESS) {
+    printf("Failed to recover %s\n", dir.c_str());
+    exit(1);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  const long records = clog_manager->stats().redo_records;
+  clog_manager->close();
+
+  printf("recovery threads=%d redo records=%8ld time=%7.3fs redo=%9.0f/s\n",
+         recovery_threads, records, elapsed.count(), records / elapsed.count());
+}
+
+int main(int argc, char **argv) {
+  int load_seconds = 3;
+  int load_threads = 8;
+  if (argc > 1) {
+    load_seconds = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    load_threads = atoi(argv[2]);
+  }
+
+  char cwd[1024];
+  if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+    return 1;
+  }
+  const std::string base_dir = std::string(cwd) + "/recovery_performance_test";
+  const std::string load_dir = base_dir + "/load";
+  run_command("rm -rf " + base_dir + " && mkdir -p " + load_dir);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    return 1;
+  }
+  if (pid == 0) {
+    if (chdir(load_dir.c_str()) != 0) {
+      _exit(1);
+    }
+    run_load(load_threads);
+    _exit(0);
+  }
+  sleep(load_seconds);
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  run_command("du -sh " + load_dir);
+
+  for (int recovery_threads : {1, 2, 4, 8}) {
+    const std::string dir = base_dir + "/recover_" + std::to_string(recovery_threads);
+    run_command("cp -a " + load_dir + " " + dir);
+    recover(dir, recovery_threads);
+  }
+
+  if (chdir(cwd) == 0) {
+    run_command("rm -rf " + base_dir);
+  }
+  return 0;
+}
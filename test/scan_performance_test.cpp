@@ -0,0 +1,162 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/common/condition_filter.h"
+#include "storage/common/meta_util.h"
+#include "storage/common/table.h"
+#include "storage/trx/trx.h"
+#include "test_util.h"
+
+/**
+ * 索引范围扫描测试: id字段上有B+树索引，id的值和记录的物理位置无关。
+ * 对不同选择率的范围条件(id < N * 选择率)，分别强制按索引的顺序回表、bitmap heap scan和全表扫描，
+ * 再用默认参数按估计的选择率自动选择，比较扫描的耗时。缓冲池比表小很多，按索引的顺序回表时页面会反复换入换出
+ * 用法: scan_performance_test [记录数] [每种扫描的重复次数]
+ */
+
+// id用定长、补零的字符串保存，字典序就是数值的顺序。整数字段上的条件还不能正确比较
+static const int ID_LEN = 12;
+static const int PAD_LEN = 84;
+
+struct Method {
+  const char *name;
+  double index_scan_selectivity;
+  double bitmap_scan_selectivity;
+};
+
+static void check(RC rc, const char *action) {
+  if (rc != RC::SUCCESS) {
+    printf("Failed to %s. rc=%d:%s\n", action, rc, strrc(rc));
+    exit(1);
+  }
+}
+
+static void make_id(int id, char *buffer) {
+  memset(buffer, 0, ID_LEN);
+  snprintf(buffer, ID_LEN, "%010d", id);
+}
+
+static void count_reader(const char *data, void *context) {
+  (*(int *)context)++;
+}
+
+static Table *create_table(const std::string &dir, int record_num) {
+  AttrInfo attributes[] = {
+      {(char *)"id", CHARS, ID_LEN},
+      {(char *)"pad", CHARS, PAD_LEN},
+  };
+  Table *table = new Table();
+  check(table->create(table_meta_file(dir.c_str(), "t").c_str(), "t", dir.c_str(), 2, attributes), "create table");
+
+  std::vector<int> ids(record_num);
+  for (int i = 0; i < record_num; i++) {
+    ids[i] = i;
+  }
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(1));
+  char pad[PAD_LEN];
+  memset(pad, 'x', sizeof(pad) - 1);
+  pad[PAD_LEN - 1] = 0;
+  Trx trx;
+  char id_value[ID_LEN];
+  for (int id : ids) {
+    make_id(id, id_value);
+    Value values[] = {{CHARS, id_value}, {CHARS, pad}};
+    check(table->insert_record(&trx, 2, values), "insert record");
+  }
+  check(trx.commit(), "commit");
+
+  const char *fields[] = {"id"};
+  check(table->create_index(nullptr, "t_id", 1, fields, 0, nullptr), "create index");
+  return table;
+}
+
+static int scan(Table *table, int bound, const Method &method, double *ms) {
+  TableScanOptions &options = TableScanOptions::instance();
+  options.index_scan_selectivity = method.index_scan_selectivity;
+  options.bitmap_scan_selectivity = method.bitmap_scan_selectivity;
+
+  char bound_value[ID_LEN];
+  make_id(bound, bound_value);
+  ConDesc left = {true, ID_LEN, table->table_meta().field("id")->offset(), nullptr};
+  ConDesc right = {false, 0, 0, bound_value};
+  DefaultConditionFilter filter;
+  check(filter.init(left, right, CHARS, LESS_THAN), "init filter");
+  const ConditionFilter *filters[] = {&filter};
+  CompositeConditionFilter composite;
+  check(composite.init(filters, 1), "init composite filter");
+
+  int count = 0;
+  auto begin = std::chrono::steady_clock::now();
+  check(table->scan_record(nullptr, &composite, -1, &count, count_reader), "scan table");
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+  *ms = elapsed.count();
+  return count;
+}
+
+int main(int argc, char **argv) {
+  int record_num = 200000;
+  int repeat = 3;
+  if (argc > 1) {
+    record_num = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    repeat = atoi(argv[2]);
+  }
+
+  const std::string dir = make_temp_dir("scan_performance_test");
+  if (dir.empty()) {
+    return 1;
+  }
+  Table *table = create_table(dir, record_num);
+  printf("records=%d estimated=%d\n", record_num, table->estimate_record_num());
+
+  const TableScanOptions defaults = TableScanOptions::instance();
+  const Method methods[] = {
+      {"index", 1, 1},
+      {"bitmap", 0, 1},
+      {"full", 0, 0},
+      {"auto", defaults.index_scan_selectivity, defaults.bitmap_scan_selectivity},
+  };
+  for (double selectivity : {0.0005, 0.005, 0.02, 0.1, 0.3, 0.6, 1.0}) {
+    const int bound = (int)(record_num * selectivity);
+    printf("selectivity=%6.4f", selectivity);
+    for (const Method &method : methods) {
+      double best = 0;
+      for (int i = 0; i < repeat; i++) {
+        double ms = 0;
+        const int count = scan(table, bound, method, &ms);
+        if (count != bound) {
+          printf("\n%s scan returns %d records, expect %d\n", method.name, count, bound);
+          exit(1);
+        }
+        best = i == 0 ? ms : std::min(best, ms);
+      }
+      printf(" %s=%9.2fms", method.name, best);
+    }
+    printf("\n");
+  }
+
+  delete table;
+  remove_temp_dir(dir);
+  return 0;
+}
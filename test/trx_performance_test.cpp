@@ -0,0 +1,102 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "storage/common/meta_util.h"
+#include "storage/common/table.h"
+#include "storage/trx/mvcc_manager.h"
+#include "storage/trx/trx.h"
+#include "test_util.h"
+
+/**
+ * 大事务测试: 一个事务插入很多条记录后提交，再用一个事务修改所有的记录后回滚，
+ * 分别统计执行语句和提交(回滚)的时间。修改的字段上有索引
+ * 用法: trx_performance_test [记录数]
+ */
+
+typedef std::chrono::duration<double> Seconds;
+
+static Seconds since(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::steady_clock::now() - begin;
+}
+
+static void check(RC rc, const char *action) {
+  if (rc != RC::SUCCESS) {
+    printf("Failed to %s. rc=%d:%s\n", action, rc, strrc(rc));
+    exit(1);
+  }
+}
+
+static void run_test(const std::string &dir, int record_num) {
+  AttrInfo attributes[] = {
+      {(char *)"id", INTS, sizeof(int)},
+      {(char *)"value", INTS, sizeof(int)},
+  };
+  Table table;
+  check(table.create(table_meta_file(dir.c_str(), "bulk").c_str(), "bulk", dir.c_str(), 2, attributes),
+        "create table");
+  // 回滚插入时要按key的顺序删除索引项
+  const char *index_fields[] = {"value"};
+  check(table.create_index(nullptr, "bulk_value", 1, index_fields, 0, nullptr), "create index");
+
+  Trx trx;
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < record_num; i++) {
+    int value = i;
+    Value values[] = {{INTS, &value}, {INTS, &value}};
+    check(table.insert_record(&trx, 2, values), "insert record");
+  }
+  const Seconds insert_time = since(begin);
+  begin = std::chrono::steady_clock::now();
+  check(trx.commit(), "commit");
+  const Seconds commit_time = since(begin);
+
+  begin = std::chrono::steady_clock::now();
+  int new_value = -1;
+  Value value = {INTS, &new_value};
+  int updated_count = 0;
+  check(table.update_record(&trx, "value", &value, nullptr, &updated_count), "update records");
+  const Seconds update_time = since(begin);
+  begin = std::chrono::steady_clock::now();
+  check(trx.rollback(), "rollback");
+  const Seconds rollback_time = since(begin);
+
+  printf("records=%8d insert=%8.0f/s commit=%8.3fs update=%8.0f/s (%d updated) rollback=%8.3fs\n",
+         record_num, record_num / insert_time.count(), commit_time.count(), updated_count / update_time.count(),
+         updated_count, rollback_time.count());
+  theGlobalMvccManager()->remove_table(&table);
+}
+
+int main(int argc, char **argv) {
+  int record_num = 200000;
+  if (argc > 1) {
+    record_num = atoi(argv[1]);
+  }
+
+  // 回滚和提交之后不需要在后台清理旧版本
+  theGlobalMvccManager()->stop();
+
+  const std::string dir = make_temp_dir("trx_performance_test");
+  if (dir.empty()) {
+    return 1;
+  }
+  run_test(dir, record_num);
+  remove_temp_dir(dir);
+  return 0;
+}
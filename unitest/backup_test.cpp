@@ -0,0 +1,180 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/clog.h"
+#include "storage/common/record_manager.h"
+#include "storage/default/backup.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+static const int RECORD_COUNT = 20000;
+
+// 日志中记录的是数据文件的相对路径，备份放到另一个工作目录下相同的位置恢复
+static const char *DATA_FILE = "./miniob/db/sys/test.data";
+
+/**
+ * 从备份恢复，检查所有记录的version：前面一部分是pass，后面的是pass-1。返回恢复出的更新次数
+ */
+static long check_backup(const std::string &dir) {
+  EXPECT_EQ(0, chdir(dir.c_str()));
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  EXPECT_EQ(RC::SUCCESS, clog_manager->open("./miniob/clog"));
+  EXPECT_EQ(RC::SUCCESS, clog_manager->recover(*buffer_pool));
+
+  int file_id;
+  EXPECT_EQ(RC::SUCCESS, buffer_pool->open_file(DATA_FILE, &file_id));
+  std::vector<int> versions(RECORD_COUNT, -1);
+  {
+    RecordFileScanner scanner;
+    EXPECT_EQ(RC::SUCCESS, scanner.open_scan(*buffer_pool, file_id, nullptr));
+    Record record;
+    while (scanner.get_next_record(&record) == RC::SUCCESS) {
+      const TestRecord *data = (const TestRecord *)record.data;
+      EXPECT_GE(data->value, 0);
+      EXPECT_LT(data->value, RECORD_COUNT);
+      versions[data->value] = data->version;
+    }
+    EXPECT_EQ(RC::SUCCESS, scanner.close_scan());
+  }
+  EXPECT_EQ(RC::SUCCESS, buffer_pool->close_file(file_id));
+  EXPECT_EQ(RC::SUCCESS, clog_manager->close());
+
+  int k = 0;
+  while (k < RECORD_COUNT && versions[k] == versions[0]) {
+    k++;
+  }
+  for (int i = k; i < RECORD_COUNT; i++) {
+    EXPECT_EQ(versions[0] - 1, versions[i]) << "record " << i;
+  }
+  return k == RECORD_COUNT ? (long)versions[0] * RECORD_COUNT : (long)(versions[0] - 1) * RECORD_COUNT + k;
+}
+
+TEST(test_backup, test_online_backup) {
+  const std::string dir = make_temp_dir("backup_test");
+  ASSERT_FALSE(dir.empty());
+  char cwd[1024];
+  ASSERT_NE(nullptr, getcwd(cwd, sizeof(cwd)));
+  ASSERT_EQ(0, chdir(dir.c_str()));
+  ASSERT_EQ(0, mkdir("miniob", S_IRWXU));
+  ASSERT_EQ(0, mkdir("miniob/db", S_IRWXU));
+  ASSERT_EQ(0, mkdir("miniob/db/sys", S_IRWXU));
+  ASSERT_EQ(0, mkdir("backup", S_IRWXU));
+
+  CLogOptions options;
+  options.checkpoint_size = 0;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  ASSERT_EQ(RC::SUCCESS, clog_manager->open("./miniob/clog", options));
+  ASSERT_EQ(RC::SUCCESS, clog_manager->recover(*buffer_pool));
+
+  int file_id;
+  RecordFileHandler record_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->create_file(DATA_FILE));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->open_file(DATA_FILE, &file_id));
+  ASSERT_EQ(RC::SUCCESS, record_handler.init(*buffer_pool, file_id));
+  std::vector<RID> rids(RECORD_COUNT);
+  for (int i = 0; i < RECORD_COUNT; i++) {
+    TestRecord record;
+    memset(&record, 0, sizeof(record));
+    record.value = i;
+    ASSERT_EQ(RC::SUCCESS, record_handler.insert_record((const char *)&record, TEST_RECORD_SIZE, &rids[i]));
+  }
+  ASSERT_EQ(RC::SUCCESS, clog_manager->checkpoint());
+  // 不在日志中的Bloom过滤器和LSM有序文件不复制
+  for (const char *file_name : {"./miniob/db/sys/test-i.index.bloom", "./miniob/db/sys/test-l.index.1.run"}) {
+    FILE *file = fopen(file_name, "w");
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(0, fclose(file));
+  }
+
+  // 备份期间一遍一遍地按顺序更新所有记录，每一遍之后做一次检查点，备份开始时的日志段不能被删除
+  std::atomic<bool> stop{false};
+  std::atomic<long> updates{0};
+  std::thread updater([&]() {
+    for (int pass = 1; !stop.load(); pass++) {
+      for (int i = 0; i < RECORD_COUNT && !stop.load(); i++) {
+        RC rc = record_handler.update_record_in_place(&rids[i], [pass](Record &record) {
+          ((TestRecord *)record.data)->version = pass;
+          return RC::SUCCESS;
+        });
+        ASSERT_EQ(RC::SUCCESS, rc);
+        updates++;
+      }
+      ASSERT_EQ(RC::SUCCESS, clog_manager->checkpoint(true));
+    }
+  });
+
+  // 一次只读一个页面，限速让复制持续一段时间
+  BackupOptions backup_options;
+  backup_options.read_size = BP_PAGE_SIZE;
+  backup_options.max_rate = 1;
+  OnlineBackup backup(*buffer_pool, *clog_manager, backup_options);
+  while (updates.load() < RECORD_COUNT / 2) {
+    std::this_thread::yield();
+  }
+  const long updates_before = updates.load();
+  ASSERT_EQ(RC::SUCCESS, backup.run("./miniob", "./backup/miniob"));
+  const long updates_after = updates.load();
+  stop.store(true);
+  updater.join();
+
+  const BackupStats &stats = backup.stats();
+  ASSERT_EQ(1, stats.files);
+  ASSERT_NE(0, access("./backup/miniob/db/sys/test-i.index.bloom", F_OK));
+  ASSERT_NE(0, access("./backup/miniob/db/sys/test-l.index.1.run", F_OK));
+  ASSERT_GT(stats.bytes, 0);
+  ASSERT_LT(stats.start_lsn, stats.end_lsn);
+  ASSERT_GE(stats.seconds, stats.bytes / (1024.0 * 1024) * 0.99);
+  ASSERT_GT(updates_after, updates_before);
+  // 已经有备份的目录不能再备份
+  ASSERT_EQ(RC::SCHEMA_DB_EXIST, backup.run("./miniob", "./backup/miniob"));
+
+  record_handler.close();
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->close_file(file_id));
+  ASSERT_EQ(RC::SUCCESS, clog_manager->close());
+
+  // 恢复出的是复制过程中的某个时刻的状态
+  const long recovered = check_backup(dir + "/backup");
+  ASSERT_GE(recovered, updates_before);
+  // 最后一次更新可能已经写了日志还没有计数
+  ASSERT_LE(recovered, updates_after + 1);
+
+  ASSERT_EQ(0, chdir(cwd));
+  remove_temp_dir(dir);
+}
+
+TEST(test_backup, test_backup_without_clog) {
+  const std::string dir = make_temp_dir("backup_test");
+  ASSERT_FALSE(dir.empty());
+  CLogManager clog_manager;
+  OnlineBackup backup(*theGlobalDiskBufferPool(), clog_manager);
+  ASSERT_NE(RC::SUCCESS, backup.run(dir, dir + "/backup"));
+  remove_temp_dir(dir);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
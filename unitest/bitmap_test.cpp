@@ -64,6 +64,14 @@ TEST(test_bitmap, test_bitmap) {
   buf3[1] = 0;
   ASSERT_EQ(8, bitmap3.next_unsetted_bit(0));
   ASSERT_EQ(16, bitmap3.next_setted_bit(8));
+
+  // 起始位置所在的字节全部为0或者全部为1时，下一个字节要从第一位开始找
+  buf3[0] = 0;
+  buf3[1] = 0x01;
+  ASSERT_EQ(8, bitmap3.next_setted_bit(5));
+  buf3[0] = -1;
+  buf3[1] = -2;
+  ASSERT_EQ(8, bitmap3.next_unsetted_bit(5));
 }
 
 int main(int argc, char **argv) {
@@ -0,0 +1,1002 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/common/bplus_tree.h"
+#include "storage/common/key_comparator.h"
+#include "storage/common/key_sorter.h"
+#include "gtest/gtest.h"
+
+static RID make_rid(int value) {
+  RID rid;
+  rid.page_num = value / 100 + 1;
+  rid.slot_num = value % 100;
+  return rid;
+}
+
+TEST(test_bplus_tree, test_key_binary_search) {
+  const int key_length = sizeof(int) + sizeof(RID);
+  KeyComparator<INTS> cmp(sizeof(int));
+  for (int key_num = 0; key_num < 40; key_num++) {
+    // 0, 2, 4 ... 每个值对应相同的RID
+    std::vector<char> keys(key_num * key_length);
+    for (int i = 0; i < key_num; i++) {
+      int value = i * 2;
+      RID rid = make_rid(value);
+      memcpy(keys.data() + i * key_length, &value, sizeof(value));
+      memcpy(keys.data() + i * key_length + sizeof(int), &rid, sizeof(rid));
+    }
+    for (int value = -1; value <= key_num * 2; value++) {
+      char key[key_length];
+      RID rid = make_rid(value < 0 ? 0 : value);
+      memcpy(key, &value, sizeof(value));
+      memcpy(key + sizeof(int), &rid, sizeof(rid));
+
+      int expect_lower = 0;
+      while (expect_lower < key_num && cmp(keys.data() + expect_lower * key_length, key) < 0) {
+        expect_lower++;
+      }
+      int expect_upper = expect_lower;
+      while (expect_upper < key_num && cmp(keys.data() + expect_upper * key_length, key) <= 0) {
+        expect_upper++;
+      }
+      ASSERT_EQ(expect_lower, binary_search_keys<false>(keys.data(), key_num, key_length, key, cmp));
+      ASSERT_EQ(expect_upper, binary_search_keys<true>(keys.data(), key_num, key_length, key, cmp));
+    }
+  }
+}
+
+TEST(test_bplus_tree, test_normalize_attr_restore) {
+  // 覆盖索引要能从编码后的key中还原出原来的值
+  const int ints[] = {INT_MIN, -100, -1, 0, 1, 100, INT_MAX};
+  for (int value : ints) {
+    char key[sizeof(int)];
+    int restored = 0;
+    normalize_attr(INTS, sizeof(value), (const char *)&value, key);
+    denormalize_attr(INTS, sizeof(value), key, (char *)&restored);
+    ASSERT_EQ(value, restored);
+  }
+  const float floats[] = {-1e10f, -3.5f, -0.5f, 0.0f, 0.5f, 3.5f, 1e10f};
+  for (float value : floats) {
+    char key[sizeof(float)];
+    float restored = 0;
+    normalize_attr(FLOATS, sizeof(value), (const char *)&value, key);
+    denormalize_attr(FLOATS, sizeof(value), key, (char *)&restored);
+    ASSERT_EQ(value, restored);
+  }
+  char chars[8] = "abc";
+  char key[sizeof(chars)];
+  char restored[sizeof(chars)];
+  normalize_attr(CHARS, sizeof(chars), chars, key);
+  denormalize_attr(CHARS, sizeof(chars), key, restored);
+  ASSERT_STREQ(chars, restored);
+}
+
+TEST(test_bplus_tree, test_composite_key_prefix_scan) {
+  const char *index_file = "bplus_tree_composite_test.index";
+  unlink(index_file);
+
+  // (a int, b float) 两列编码成一个可以memcmp比较的key
+  const int attr_length = sizeof(int) + sizeof(float);
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, BYTES, attr_length));
+
+  auto make_key = [](int a, float b, char *key) {
+    normalize_attr(INTS, sizeof(a), (const char *)&a, key);
+    normalize_attr(FLOATS, sizeof(b), (const char *)&b, key + sizeof(a));
+  };
+
+  std::vector<int> values;
+  for (int a = -5; a < 5; a++) {
+    for (int b = -50; b < 50; b++) {
+      values.push_back((a + 5) * 100 + (b + 50));
+    }
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  for (int value : values) {
+    char key[attr_length];
+    make_key(value / 100 - 5, (float)(value % 100 - 50) / 2, key);
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(key, &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  // a = -2 and b > -3.0 and b <= 10.0
+  char low[attr_length];
+  char high[attr_length];
+  make_key(-2, -3.0f, low);
+  make_key(-2, 10.0f, high);
+  BplusTreeScanner scanner(handler);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(low, attr_length, false, high, attr_length, true));
+  RID rid;
+  int expect = 3 * 100 + (-6 + 50) + 1;
+  while (scanner.next_entry(&rid) == RC::SUCCESS) {
+    ASSERT_EQ(make_rid(expect), rid);
+    expect++;
+  }
+  ASSERT_EQ(3 * 100 + 20 + 50 + 1, expect);
+  scanner.close();
+
+  // a < 0 只用第一列做前缀
+  int a = 0;
+  char prefix[sizeof(int)];
+  normalize_attr(INTS, sizeof(a), (const char *)&a, prefix);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, true, prefix, sizeof(prefix), false));
+  int count = 0;
+  while (scanner.next_entry(&rid) == RC::SUCCESS) {
+    ASSERT_EQ(make_rid(count), rid);
+    count++;
+  }
+  ASSERT_EQ(500, count);
+  scanner.close();
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_scanner_seek) {
+  const char *index_file = "bplus_tree_seek_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  // 偶数值，每个值3个RID，跨越多个叶子节点
+  for (int value = 0; value < 3000; value += 2) {
+    for (int i = 0; i < 3; i++) {
+      RID rid = make_rid(value * 3 + i);
+      ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+    }
+  }
+
+  // 按从小到大的顺序依次查找，包括不存在的值
+  BplusTreeScanner scanner(handler);
+  int value = -1;
+  ASSERT_EQ(RC::SUCCESS, scanner.open(EQUAL_TO, (const char *)&value));
+  for (; value < 3010; value += 7) {
+    if (value > -1) {
+      ASSERT_EQ(RC::SUCCESS, scanner.seek((const char *)&value));
+    }
+    RID rid;
+    int count = 0;
+    while (scanner.next_entry(&rid) == RC::SUCCESS) {
+      ASSERT_EQ(make_rid(value * 3 + count), rid);
+      count++;
+    }
+    ASSERT_EQ(value >= 0 && value < 3000 && value % 2 == 0 ? 3 : 0, count) << value;
+  }
+  scanner.close();
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_bulk_load) {
+  const char *index_file = "bplus_tree_bulk_load_test.index";
+  unlink(index_file);
+
+  const int count = 20000;
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+
+  // 内存上限很小，强制走多个run的外部归并
+  IndexBuildOptions options;
+  options.sort_memory = 1;
+  options.sort_threads = 4;
+  KeySorter sorter(INTS, sizeof(int), index_file, options);
+  for (int value : values) {
+    ASSERT_EQ(RC::SUCCESS, sorter.add((const char *)&value, make_rid(value)));
+  }
+  ASSERT_EQ(RC::SUCCESS, sorter.finish());
+  ASSERT_EQ((size_t)count, sorter.size());
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  ASSERT_EQ(RC::SUCCESS, handler.bulk_load(sorter, 0.7));
+  int key_count = 0;
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(count, key_count);
+
+  // 插入一些新值，触发分裂
+  for (int value = count; value < count + 1000; value++) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+  ASSERT_EQ(RC::SUCCESS, handler.close());
+
+  // 重新打开，根节点需要被持久化
+  ASSERT_EQ(RC::SUCCESS, handler.open(index_file));
+  for (int value = 0; value < count + 1000; value += 7) {
+    RID rid = make_rid(value);
+    RID found;
+    found = rid;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&value, &found));
+    ASSERT_EQ(rid, found);
+  }
+
+  int start = 100;
+  BplusTreeScanner scanner(handler);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(GREAT_EQUAL, (const char *)&start));
+  RID rid;
+  int expect = start;
+  while (scanner.next_entry(&rid) == RC::SUCCESS) {
+    ASSERT_EQ(make_rid(expect), rid);
+    expect++;
+  }
+  ASSERT_EQ(count + 1000, expect);
+  scanner.close();
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_bloom_filter) {
+  const char *index_file = "bplus_tree_bloom_test.index";
+  const std::string bloom_file = BplusTreeHandler::bloom_filter_file(index_file);
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  ASSERT_EQ(RC::SUCCESS, handler.enable_bloom_filter(sizeof(int)));
+  ASSERT_TRUE(handler.bloom_filter_enabled());
+
+  // 超过过滤器的初始容量，插入过程中要重建
+  const int count = 5000;
+  for (int value = 0; value < count * 2; value += 2) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+
+  // 不存在的值大多数被过滤器直接挡住，存在的值一定能找到
+  for (int value = 0; value < count * 2; value++) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(value % 2 == 0 ? RC::SUCCESS : RC::RECORD_INVALID_KEY,
+              handler.get_entry((const char *)&value, &rid)) << value;
+  }
+  BloomFilterStats stats = handler.bloom_filter_stats();
+  ASSERT_EQ(count * 2, stats.probes);
+  ASSERT_EQ(count, stats.negatives + stats.false_positives);
+  ASSERT_LT(stats.false_positive_rate(), 0.05);
+
+  // 扫描器上的等值查找也使用过滤器
+  for (int value = 1; value < 200; value += 2) {
+    BplusTreeScanner scanner(handler);
+    ASSERT_EQ(RC::SUCCESS, scanner.open(EQUAL_TO, (const char *)&value));
+    RID rid;
+    ASSERT_EQ(RC::RECORD_EOF, scanner.next_entry(&rid));
+    scanner.close();
+  }
+  BloomFilterStats scan_stats = handler.bloom_filter_stats();
+  ASSERT_EQ(stats.probes + 100, scan_stats.probes);
+  ASSERT_EQ(stats.negatives + stats.false_positives + 100, scan_stats.negatives + scan_stats.false_positives);
+
+  // 关闭时写出过滤器，重新打开时直接加载
+  ASSERT_EQ(RC::SUCCESS, handler.close());
+  ASSERT_EQ(0, access(bloom_file.c_str(), F_OK));
+  ASSERT_EQ(RC::SUCCESS, handler.open(index_file));
+  ASSERT_EQ(RC::SUCCESS, handler.enable_bloom_filter(sizeof(int)));
+  for (int value = 0; value < count * 2; value += 2) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&value, &rid)) << value;
+  }
+
+  // 之后再插入，文件中的过滤器就过期了，没有sync就关闭(崩溃)时要从B+树重建
+  int value = count * 2 + 1;
+  RID rid = make_rid(value);
+  ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  ASSERT_NE(0, access(bloom_file.c_str(), F_OK));
+  ASSERT_EQ(RC::SUCCESS, handler.sync());
+  ASSERT_EQ(0, access(bloom_file.c_str(), F_OK));
+  handler.close();
+
+  unlink(index_file);
+  unlink(bloom_file.c_str());
+}
+
+TEST(test_bplus_tree, test_bloom_filter_false_positive_rate) {
+  BloomFilter filter;
+  const int count = 100000;
+  filter.init(count);
+  for (int i = 0; i < count; i++) {
+    filter.add(BloomFilter::hash((const char *)&i, sizeof(i)));
+  }
+  int false_positives = 0;
+  for (int i = 0; i < count; i++) {
+    ASSERT_TRUE(filter.may_contain(BloomFilter::hash((const char *)&i, sizeof(i))));
+    int other = count + i;
+    if (filter.may_contain(BloomFilter::hash((const char *)&other, sizeof(other)))) {
+      false_positives++;
+    }
+  }
+  // 每个key 10位，分块之后理论上在1%左右
+  ASSERT_LT(false_positives, count * 2 / 100);
+}
+
+TEST(test_bplus_tree, test_concurrent_insert_lookup_delete) {
+  const char *index_file = "bplus_tree_concurrency_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+
+  const int writer_num = 4;
+  const int count_per_writer = 5000;
+  std::atomic<bool> writing(true);
+  std::atomic<int> errors(0);
+
+  // 每个写线程负责一段互不相交的key: 插入、查找、删除掉奇数
+  auto writer = [&](int thread_index) {
+    std::vector<int> values;
+    for (int i = 0; i < count_per_writer; i++) {
+      values.push_back(i * writer_num + thread_index);
+    }
+    std::shuffle(values.begin(), values.end(), std::mt19937(thread_index));
+    for (int value : values) {
+      RID rid = make_rid(value);
+      if (handler.insert_entry((const char *)&value, &rid) != RC::SUCCESS) {
+        errors++;
+      }
+    }
+    for (int value : values) {
+      RID rid = make_rid(value);
+      if (handler.get_entry((const char *)&value, &rid) != RC::SUCCESS) {
+        errors++;
+      }
+    }
+    for (int value : values) {
+      if (value % 2 == 1) {
+        RID rid = make_rid(value);
+        if (handler.delete_entry((const char *)&value, &rid) != RC::SUCCESS) {
+          errors++;
+        }
+      }
+    }
+  };
+
+  // 读线程不断做范围扫描，结果必须有序
+  auto reader = [&]() {
+    while (writing) {
+      int start = 0;
+      BplusTreeScanner scanner(handler);
+      if (scanner.open(GREAT_EQUAL, (const char *)&start) != RC::SUCCESS) {
+        errors++;
+        return;
+      }
+      RID rid;
+      RID last_rid{};
+      bool first = true;
+      RC rc;
+      while ((rc = scanner.next_entry(&rid)) == RC::SUCCESS) {
+        int value = (rid.page_num - 1) * 100 + rid.slot_num;
+        int last_value = (last_rid.page_num - 1) * 100 + last_rid.slot_num;
+        if (!first && value <= last_value) {
+          errors++;
+        }
+        first = false;
+        last_rid = rid;
+      }
+      if (rc != RC::RECORD_EOF) {
+        errors++;
+      }
+      scanner.close();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < writer_num; i++) {
+    threads.emplace_back(writer, i);
+  }
+  std::thread reader1(reader);
+  std::thread reader2(reader);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  writing = false;
+  reader1.join();
+  reader2.join();
+
+  ASSERT_EQ(0, errors.load());
+  int key_count = 0;
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(writer_num * count_per_writer / 2, key_count);
+  for (int value = 0; value < writer_num * count_per_writer; value++) {
+    RID rid = make_rid(value);
+    RC expect = value % 2 == 0 ? RC::SUCCESS : RC::RECORD_INVALID_KEY;
+    ASSERT_EQ(expect, handler.get_entry((const char *)&value, &rid)) << value;
+    if (expect == RC::SUCCESS) {
+      ASSERT_EQ(make_rid(value), rid);
+    }
+  }
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_lazy_delete_rebalance) {
+  const char *index_file = "bplus_tree_lazy_delete_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  const int count = 20000;
+  for (int value = 0; value < count; value++) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+  int leaf_count = 0;
+  ASSERT_TRUE(handler.validate_tree(nullptr, &leaf_count));
+  const int full_leaf_count = leaf_count;
+
+  // 删除只修改叶子节点，低于半满甚至空的叶子也是合法的树
+  for (int value = 0; value < count; value++) {
+    if (value % 10 != 0) {
+      RID rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&value, &rid));
+    }
+  }
+  int value = 1;
+  RID rid = make_rid(value);
+  ASSERT_EQ(RC::RECORD_INVALID_KEY, handler.delete_entry((const char *)&value, &rid));
+  int key_count = 0;
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(count / 10, key_count);
+
+  // 合并之后叶子节点回到半满以上，多出来的页面被回收
+  ASSERT_EQ(RC::SUCCESS, handler.rebalance());
+  ASSERT_EQ(0u, handler.rebalance_pending());
+  ASSERT_TRUE(handler.validate_tree(&key_count, &leaf_count));
+  ASSERT_EQ(count / 10, key_count);
+  ASSERT_LT(leaf_count, full_leaf_count / 4);
+
+  BplusTreeScanner scanner(handler);
+  int start = 0;
+  ASSERT_EQ(RC::SUCCESS, scanner.open(GREAT_EQUAL, (const char *)&start));
+  int expect = 0;
+  while (scanner.next_entry(&rid) == RC::SUCCESS) {
+    ASSERT_EQ(make_rid(expect), rid);
+    expect += 10;
+  }
+  ASSERT_EQ(count, expect);
+  scanner.close();
+
+  // 全部删除后由后台线程合并，只剩一个叶子节点作为根
+  for (int value = 0; value < count; value += 10) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&value, &rid));
+  }
+  for (int i = 0; i < 1000 && handler.rebalance_pending() > 0; i++) {
+    usleep(10 * 1000);
+  }
+  ASSERT_EQ(RC::SUCCESS, handler.rebalance());
+  ASSERT_TRUE(handler.validate_tree(&key_count, &leaf_count));
+  ASSERT_EQ(0, key_count);
+  ASSERT_EQ(1, leaf_count);
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_adaptive_hash) {
+  const char *index_file = "bplus_tree_adaptive_hash_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  ASSERT_EQ(RC::SUCCESS, handler.enable_adaptive_hash(1024 * 1024, 2));
+  ASSERT_TRUE(handler.adaptive_hash_enabled());
+
+  const int count = 10000;
+  for (int value = 0; value < count * 4; value += 4) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+
+  // 热点值查找两次之后记录下来，后面的查找直接定位到叶子
+  const int rounds = 10;
+  for (int round = 0; round < rounds; round++) {
+    for (int value = 0; value < 400; value += 4) {
+      RID rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&value, &rid)) << value;
+      BplusTreeScanner scanner(handler);
+      ASSERT_EQ(RC::SUCCESS, scanner.open(EQUAL_TO, (const char *)&value));
+      ASSERT_EQ(RC::SUCCESS, scanner.next_entry(&rid));
+      ASSERT_EQ(make_rid(value), rid);
+      ASSERT_EQ(RC::RECORD_EOF, scanner.next_entry(&rid));
+      scanner.close();
+    }
+  }
+  AdaptiveHashStats stats = handler.adaptive_hash_stats();
+  ASSERT_GE(stats.hits, 100 * 2 * (rounds - 3));
+  ASSERT_GT(stats.entries, 0);
+
+  // 在热点值之间插入数据，叶子分裂后旧的位置失效，结果仍然正确
+  for (int value = 1; value < 400; value += 4) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+  // 删除一半热点值
+  for (int value = 0; value < 400; value += 8) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&value, &rid));
+  }
+  for (int round = 0; round < 3; round++) {
+    for (int value = 0; value < 400; value++) {
+      RID rid = make_rid(value);
+      RC expect = (value % 4 == 0 && value % 8 != 0) || value % 4 == 1 ? RC::SUCCESS : RC::RECORD_INVALID_KEY;
+      ASSERT_EQ(expect, handler.get_entry((const char *)&value, &rid)) << value;
+    }
+  }
+  ASSERT_GT(handler.adaptive_hash_stats().invalidations, 0);
+  int key_count = 0;
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(count + 100 - 50, key_count);
+
+  handler.close();
+  ASSERT_FALSE(handler.adaptive_hash_enabled());
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_adaptive_hash_memory_limit) {
+  const char *index_file = "bplus_tree_adaptive_hash_limit_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  const size_t memory_limit = 16 * 1024;
+  ASSERT_EQ(RC::SUCCESS, handler.enable_adaptive_hash(memory_limit, 1));
+
+  const int count = 20000;
+  for (int value = 0; value < count; value++) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+  for (int round = 0; round < 2; round++) {
+    for (int value = 0; value < count; value++) {
+      RID rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&value, &rid)) << value;
+    }
+  }
+  AdaptiveHashStats stats = handler.adaptive_hash_stats();
+  ASSERT_LE(stats.memory, memory_limit);
+  ASSERT_GT(stats.entries, 0);
+  ASSERT_LT(stats.entries, count);
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_adaptive_hash_concurrent) {
+  const char *index_file = "bplus_tree_adaptive_hash_concurrency_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  ASSERT_EQ(RC::SUCCESS, handler.enable_adaptive_hash(1024 * 1024, 1));
+
+  // 偶数一直存在，写线程反复插入删除奇数，叶子不断分裂合并
+  const int count = 4000;
+  for (int value = 0; value < count; value += 2) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+  std::atomic<bool> writing(true);
+  std::atomic<int> errors(0);
+  auto writer = [&]() {
+    for (int round = 0; round < 4; round++) {
+      for (int value = 1; value < count; value += 2) {
+        RID rid = make_rid(value);
+        if (handler.insert_entry((const char *)&value, &rid) != RC::SUCCESS) {
+          errors++;
+        }
+      }
+      for (int value = 1; value < count; value += 2) {
+        RID rid = make_rid(value);
+        if (handler.delete_entry((const char *)&value, &rid) != RC::SUCCESS) {
+          errors++;
+        }
+      }
+    }
+  };
+  auto reader = [&](int seed) {
+    std::mt19937 random(seed);
+    while (writing) {
+      int value = random() % (count / 2) * 2;
+      RID rid = make_rid(value);
+      if (handler.get_entry((const char *)&value, &rid) != RC::SUCCESS || !(make_rid(value) == rid)) {
+        errors++;
+      }
+    }
+  };
+
+  std::thread writer_thread(writer);
+  std::thread reader1(reader, 1);
+  std::thread reader2(reader, 2);
+  writer_thread.join();
+  writing = false;
+  reader1.join();
+  reader2.join();
+
+  ASSERT_EQ(0, errors.load());
+  // 写完之后叶子不再变化，记录的位置重新生效
+  for (int round = 0; round < 2; round++) {
+    for (int value = 0; value < count; value += 2) {
+      RID rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&value, &rid)) << value;
+    }
+  }
+  ASSERT_GT(handler.adaptive_hash_stats().hits, 0);
+  handler.close();
+  unlink(index_file);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+// 公共前缀很长的URL，用来测试前缀压缩
+static void make_url(int value, char *url, int length) {
+  memset(url, 0, length);
+  snprintf(url, length, "https://www.example.com/static/images/2026/10/category_%03d/item_%06d.png",
+      value % 37, value);
+}
+
+TEST(test_bplus_tree, test_prefix_compression) {
+  const char *fixed_file = "bplus_tree_fixed_test.index";
+  const char *prefix_file = "bplus_tree_prefix_test.index";
+  unlink(fixed_file);
+  unlink(prefix_file);
+
+  const int attr_length = 100;
+  const int count = 20000;
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+
+  BplusTreeHandler fixed;
+  BplusTreeHandler prefix;
+  ASSERT_EQ(RC::SUCCESS, fixed.create(fixed_file, CHARS, attr_length, false));
+  ASSERT_EQ(RC::SUCCESS, prefix.create(prefix_file, CHARS, attr_length, true));
+  ASSERT_FALSE(fixed.prefix_compressed());
+  ASSERT_TRUE(prefix.prefix_compressed());
+
+  char url[attr_length];
+  for (int value : values) {
+    RID rid = make_rid(value);
+    make_url(value, url, attr_length);
+    ASSERT_EQ(RC::SUCCESS, fixed.insert_entry(url, &rid));
+    ASSERT_EQ(RC::SUCCESS, prefix.insert_entry(url, &rid));
+  }
+
+  int fixed_keys = 0, fixed_leaves = 0;
+  int prefix_keys = 0, prefix_leaves = 0;
+  ASSERT_TRUE(fixed.validate_tree(&fixed_keys, &fixed_leaves));
+  ASSERT_TRUE(prefix.validate_tree(&prefix_keys, &prefix_leaves));
+  ASSERT_EQ(count, fixed_keys);
+  ASSERT_EQ(count, prefix_keys);
+  // 压缩之后每个叶子能放更多的key，树也更矮
+  ASSERT_LT(prefix_leaves * 2, fixed_leaves);
+  ASSERT_LE(prefix.height(), fixed.height());
+
+  // 删除一半，触发合并和重分配
+  for (int value : values) {
+    if (value % 2 == 1) {
+      RID rid = make_rid(value);
+      make_url(value, url, attr_length);
+      ASSERT_EQ(RC::SUCCESS, prefix.delete_entry(url, &rid));
+    }
+  }
+  ASSERT_TRUE(prefix.validate_tree(&prefix_keys));
+  ASSERT_EQ(count / 2, prefix_keys);
+  ASSERT_EQ(RC::SUCCESS, prefix.close());
+
+  // 重新打开，节点格式需要被持久化
+  ASSERT_EQ(RC::SUCCESS, prefix.open(prefix_file));
+  ASSERT_TRUE(prefix.prefix_compressed());
+  for (int value = 0; value < count; value++) {
+    RID rid = make_rid(value);
+    make_url(value, url, attr_length);
+    RC expect = value % 2 == 0 ? RC::SUCCESS : RC::RECORD_INVALID_KEY;
+    ASSERT_EQ(expect, prefix.get_entry(url, &rid)) << value;
+  }
+
+  // 扫描结果按字符串有序
+  make_url(0, url, attr_length);
+  BplusTreeScanner scanner(prefix);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(GREAT_EQUAL, url));
+  RID rid;
+  char key[attr_length];
+  std::string last;
+  int scanned = 0;
+  while (scanner.next_entry(&rid, key) == RC::SUCCESS) {
+    std::string current(key, strnlen(key, attr_length));
+    ASSERT_LT(last, current);
+    int value = (rid.page_num - 1) * 100 + rid.slot_num;
+    make_url(value, url, attr_length);
+    ASSERT_EQ(std::string(url), current);
+    last = current;
+    scanned++;
+  }
+  ASSERT_EQ(count / 2, scanned);
+  scanner.close();
+
+  fixed.close();
+  prefix.close();
+  unlink(fixed_file);
+  unlink(prefix_file);
+}
+
+TEST(test_bplus_tree, test_prefix_compression_bulk_load) {
+  const char *index_file = "bplus_tree_prefix_bulk_load_test.index";
+  unlink(index_file);
+
+  const int attr_length = 100;
+  const int count = 20000;
+  IndexBuildOptions options;
+  KeySorter sorter(CHARS, attr_length, index_file, options);
+  char url[attr_length];
+  for (int value = 0; value < count; value++) {
+    make_url(value, url, attr_length);
+    ASSERT_EQ(RC::SUCCESS, sorter.add(url, make_rid(value)));
+  }
+  ASSERT_EQ(RC::SUCCESS, sorter.finish());
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, CHARS, attr_length, true));
+  ASSERT_EQ(RC::SUCCESS, handler.bulk_load(sorter, 0.7));
+  int key_count = 0;
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(count, key_count);
+
+  // 批量构建之后继续插入和删除
+  for (int value = count; value < count + 2000; value++) {
+    RID rid = make_rid(value);
+    make_url(value, url, attr_length);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(url, &rid));
+  }
+  for (int value = 0; value < count; value += 3) {
+    RID rid = make_rid(value);
+    make_url(value, url, attr_length);
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry(url, &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(count + 2000 - (count + 2) / 3, key_count);
+  for (int value = 0; value < count + 2000; value += 7) {
+    RID rid = make_rid(value);
+    make_url(value, url, attr_length);
+    RC expect = value < count && value % 3 == 0 ? RC::RECORD_INVALID_KEY : RC::SUCCESS;
+    ASSERT_EQ(expect, handler.get_entry(url, &rid)) << value;
+    if (expect == RC::SUCCESS) {
+      ASSERT_EQ(make_rid(value), rid);
+    }
+  }
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_upper_level_cache) {
+  const char *index_file = "bplus_tree_upper_level_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, CHARS, 100));
+  // 只有一个叶子节点时没有内部节点可以缓存
+  ASSERT_EQ(0, handler.upper_level_depth());
+
+  const int count = 20000;
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  char url[100];
+  for (int value : values) {
+    RID rid = make_rid(value);
+    make_url(value, url, sizeof(url));
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(url, &rid));
+  }
+  // 预算足够时缓存所有内部节点
+  const int height = handler.height();
+  ASSERT_GE(height, 3);
+  ASSERT_EQ(height - 1, handler.upper_level_depth());
+
+  // 只放得下根节点
+  ASSERT_EQ(RC::SUCCESS, handler.set_upper_level_pages(1));
+  ASSERT_EQ(1, handler.upper_level_depth());
+  ASSERT_EQ(1, handler.upper_level_pages());
+  ASSERT_EQ(RC::SUCCESS, handler.set_upper_level_pages(0));
+  ASSERT_EQ(0, handler.upper_level_pages());
+  ASSERT_EQ(RC::SUCCESS, handler.set_upper_level_pages(8));
+  ASSERT_LE(handler.upper_level_pages(), 8);
+
+  // 写线程分裂、合并节点，读线程通过缓存查找，结果都要正确
+  const int writer_num = 2;
+  std::atomic<bool> writing(true);
+  std::atomic<int> errors(0);
+  auto writer = [&](int thread_index) {
+    char key[100];
+    for (int value = count + thread_index; value < count * 2; value += writer_num) {
+      RID rid = make_rid(value);
+      make_url(value, key, sizeof(key));
+      if (handler.insert_entry(key, &rid) != RC::SUCCESS) {
+        errors++;
+      }
+    }
+    for (int value = thread_index; value < count; value += writer_num) {
+      if (value % 3 == 0) {
+        RID rid = make_rid(value);
+        make_url(value, key, sizeof(key));
+        if (handler.delete_entry(key, &rid) != RC::SUCCESS) {
+          errors++;
+        }
+      }
+    }
+  };
+  auto reader = [&]() {
+    char key[100];
+    while (writing) {
+      for (int value = 1; value < count; value += 3) {
+        RID rid = make_rid(value);
+        make_url(value, key, sizeof(key));
+        if (handler.get_entry(key, &rid) != RC::SUCCESS || !(rid == make_rid(value))) {
+          errors++;
+        }
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < writer_num; i++) {
+    threads.emplace_back(writer, i);
+  }
+  std::thread reader1(reader);
+  std::thread reader2(reader);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(RC::SUCCESS, handler.rebalance());
+  writing = false;
+  reader1.join();
+  reader2.join();
+  ASSERT_EQ(0, errors.load());
+
+  int key_count = 0;
+  ASSERT_TRUE(handler.validate_tree(&key_count));
+  ASSERT_EQ(count * 2 - (count + 2) / 3, key_count);
+  for (int value = 0; value < count * 2; value++) {
+    RID rid = make_rid(value);
+    make_url(value, url, sizeof(url));
+    RC expect = value < count && value % 3 == 0 ? RC::RECORD_INVALID_KEY : RC::SUCCESS;
+    ASSERT_EQ(expect, handler.get_entry(url, &rid)) << value;
+  }
+  ASSERT_EQ(RC::SUCCESS, handler.close());
+
+  // 重新打开时按配置重新缓存
+  ASSERT_EQ(RC::SUCCESS, handler.open(index_file));
+  ASSERT_EQ(handler.height() - 1, handler.upper_level_depth());
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_reverse_scanner) {
+  const char *index_file = "bplus_tree_reverse_scan_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+  RID rid;
+  int key;
+  {
+    BplusTreeReverseScanner scanner(handler);
+    ASSERT_EQ(RC::RECORD_EOF, scanner.next_entry(&rid, (char *)&key));
+  }
+
+  const int count = 20000;
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  for (int value : values) {
+    rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+
+  // 经过缓存的上层节点和不经过缓存，结果都一样
+  for (int pages : {256, 0}) {
+    ASSERT_EQ(RC::SUCCESS, handler.set_upper_level_pages(pages));
+    BplusTreeReverseScanner scanner(handler);
+    int expect = count - 1;
+    while (scanner.next_entry(&rid, (char *)&key) == RC::SUCCESS) {
+      ASSERT_EQ(expect, key);
+      ASSERT_EQ(make_rid(expect), rid);
+      expect--;
+    }
+    ASSERT_EQ(-1, expect);
+  }
+  ASSERT_EQ(RC::SUCCESS, handler.set_upper_level_pages(256));
+
+  // 删除之后留下很多空的叶子节点，倒序扫描要跳过它们
+  for (int value = 0; value < count; value++) {
+    if (value % 10 != 0 || value >= count / 2) {
+      rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&value, &rid));
+    }
+  }
+  BplusTreeReverseScanner scanner(handler);
+  int expect = count / 2 - 10;
+  while (scanner.next_entry(&rid, (char *)&key) == RC::SUCCESS) {
+    ASSERT_EQ(expect, key);
+    expect -= 10;
+  }
+  ASSERT_EQ(-10, expect);
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_bplus_tree, test_reverse_scanner_prefix_compression) {
+  const char *index_file = "bplus_tree_reverse_scan_prefix_test.index";
+  unlink(index_file);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, CHARS, 100));
+  const int count = 20000;
+  char url[100];
+  for (int value = 0; value < count; value++) {
+    RID rid = make_rid(value);
+    make_url(value, url, sizeof(url));
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(url, &rid));
+  }
+
+  std::vector<std::string> expect;
+  {
+    BplusTreeScanner scanner(handler);
+    memset(url, 0, sizeof(url));
+    ASSERT_EQ(RC::SUCCESS, scanner.open(GREAT_EQUAL, url));
+    RID rid;
+    while (scanner.next_entry(&rid, url) == RC::SUCCESS) {
+      expect.emplace_back(url, strnlen(url, sizeof(url)));
+    }
+    scanner.close();
+  }
+  ASSERT_EQ((size_t)count, expect.size());
+
+  BplusTreeReverseScanner scanner(handler);
+  RID rid;
+  int i = count - 1;
+  while (scanner.next_entry(&rid, url) == RC::SUCCESS) {
+    ASSERT_GE(i, 0);
+    ASSERT_EQ(expect[i], std::string(url, strnlen(url, sizeof(url))));
+    i--;
+  }
+  ASSERT_EQ(-1, i);
+
+  handler.close();
+  unlink(index_file);
+}
@@ -0,0 +1,546 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/os/path.h"
+#include "storage/clog/clog.h"
+#include "storage/common/bplus_tree.h"
+#include "storage/common/record_manager.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+static const int RECORD_COUNT = 3000;
+static void run_command(const std::string &command) {
+  if (system(command.c_str()) != 0) {
+    printf("Failed to run %s\n", command.c_str());
+  }
+}
+
+static long file_size(const std::string &file_name) {
+  struct stat st;
+  if (stat(file_name.c_str(), &st) != 0) {
+    return -1;
+  }
+  return st.st_size;
+}
+
+static std::string segment_file(const std::string &dir, LSN start_lsn) {
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%020lld", (long long)start_lsn);
+  return dir + "/clog" + suffix;
+}
+
+static int segment_count(const std::string &dir) {
+  std::vector<std::string> files;
+  common::list_file(dir.c_str(), "^clog\\.[0-9]\\{20\\}$", files);
+  return (int)files.size();
+}
+
+/**
+ * 在子进程中执行：打开日志，建一个记录文件和一个B+树索引，插入、更新、删除之后提交，
+ * 不写回任何页面直接退出，模拟进程崩溃。checkpoint为true时在插入之后做一次检查点
+ */
+static int run_workload_and_crash(const std::string &dir, bool checkpoint) {
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  const std::string data_file = dir + "/test.data";
+  const std::string index_file = dir + "/test.index";
+  if (clog_manager->open((dir + "/clog").c_str()) != RC::SUCCESS ||
+      clog_manager->recover(*buffer_pool) != RC::SUCCESS) {
+    return 1;
+  }
+
+  int file_id;
+  RecordFileHandler record_handler;
+  if (buffer_pool->create_file(data_file.c_str()) != RC::SUCCESS ||
+      buffer_pool->open_file(data_file.c_str(), &file_id) != RC::SUCCESS ||
+      record_handler.init(*buffer_pool, file_id) != RC::SUCCESS) {
+    return 2;
+  }
+  BplusTreeHandler index_handler;
+  if (index_handler.create(index_file.c_str(), INTS, sizeof(int)) != RC::SUCCESS) {
+    return 3;
+  }
+
+  std::vector<RID> rids(RECORD_COUNT);
+  for (int i = 0; i < RECORD_COUNT; i++) {
+    TestRecord record;
+    memset(&record, 0, sizeof(record));
+    record.value = i;
+    if (record_handler.insert_record((const char *)&record, TEST_RECORD_SIZE, &rids[i]) != RC::SUCCESS ||
+        index_handler.insert_entry((const char *)&i, &rids[i]) != RC::SUCCESS) {
+      return 4;
+    }
+  }
+  if (checkpoint && clog_manager->checkpoint() != RC::SUCCESS) {
+    return 8;
+  }
+  for (int i = 0; i < RECORD_COUNT; i += 2) {
+    RC rc = record_handler.update_record_in_place(&rids[i], [](Record &record) {
+      ((TestRecord *)record.data)->version = 1;
+      return RC::SUCCESS;
+    });
+    if (rc != RC::SUCCESS) {
+      return 5;
+    }
+  }
+  for (int i = 0; i < RECORD_COUNT; i += 3) {
+    if (record_handler.delete_record(&rids[i]) != RC::SUCCESS ||
+        index_handler.delete_entry((const char *)&i, &rids[i]) != RC::SUCCESS) {
+      return 6;
+    }
+  }
+
+  LSN lsn;
+  if (clog_manager->append(CLogType::COMMIT, 1, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn) != RC::SUCCESS ||
+      clog_manager->sync(lsn) != RC::SUCCESS) {
+    return 7;
+  }
+  return 0;
+}
+
+static void crash_in_child(const std::string &dir, bool checkpoint = false) {
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    _exit(run_workload_and_crash(dir, checkpoint));
+  }
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+}
+
+/**
+ * 恢复之后在日志结束的位置做了检查点，只剩下一个空的日志段
+ */
+static void recover(const std::string &dir, int recovery_threads, long *redo_records = nullptr) {
+  CLogOptions options;
+  options.recovery_threads = recovery_threads;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  ASSERT_EQ(RC::SUCCESS, clog_manager->open((dir + "/clog").c_str(), options));
+  ASSERT_EQ(RC::SUCCESS, clog_manager->recover(*theGlobalDiskBufferPool()));
+  ASSERT_GT(clog_manager->stats().redo_records, 0);
+  ASSERT_EQ(clog_manager->current_lsn(), clog_manager->checkpoint_lsn());
+  ASSERT_EQ(1, segment_count(dir));
+  ASSERT_EQ(0, file_size(segment_file(dir, clog_manager->current_lsn())));
+  if (redo_records != nullptr) {
+    *redo_records = clog_manager->stats().redo_records;
+  }
+  ASSERT_EQ(RC::SUCCESS, clog_manager->close());
+}
+
+/**
+ * 检查恢复后的数据：3的倍数被删除，偶数的version是1
+ */
+static void check_recovered(const std::string &dir) {
+  const std::string data_file = dir + "/test.data";
+  const std::string index_file = dir + "/test.index";
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+
+  int file_id;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->open_file(data_file.c_str(), &file_id));
+  std::vector<RID> rids(RECORD_COUNT, RID{0, 0});
+  std::vector<bool> found(RECORD_COUNT, false);
+  int count = 0;
+  {
+    // scanner析构时才释放最后一个页面，要在关闭文件之前析构
+    RecordFileScanner scanner;
+    ASSERT_EQ(RC::SUCCESS, scanner.open_scan(*buffer_pool, file_id, nullptr));
+    Record record;
+    while (scanner.get_next_record(&record) == RC::SUCCESS) {
+      const TestRecord *data = (const TestRecord *)record.data;
+      ASSERT_GE(data->value, 0);
+      ASSERT_LT(data->value, RECORD_COUNT);
+      ASSERT_NE(0, data->value % 3);
+      ASSERT_FALSE(found[data->value]);
+      ASSERT_EQ(data->value % 2 == 0 ? 1 : 0, data->version);
+      found[data->value] = true;
+      rids[data->value] = record.rid;
+      count++;
+    }
+    ASSERT_EQ(RC::SUCCESS, scanner.close_scan());
+  }
+  ASSERT_EQ(RECORD_COUNT - (RECORD_COUNT + 2) / 3, count);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->close_file(file_id));
+
+  BplusTreeHandler index_handler;
+  ASSERT_EQ(RC::SUCCESS, index_handler.open(index_file.c_str()));
+  int key_count = 0;
+  ASSERT_TRUE(index_handler.validate_tree(&key_count));
+  ASSERT_EQ(count, key_count);
+  for (int i = 0; i < RECORD_COUNT; i++) {
+    RID rid = rids[i];
+    RC rc = index_handler.get_entry((const char *)&i, &rid);
+    if (i % 3 == 0) {
+      ASSERT_NE(RC::SUCCESS, rc);
+    } else {
+      ASSERT_EQ(RC::SUCCESS, rc);
+      ASSERT_EQ(rids[i], rid);
+    }
+  }
+  ASSERT_EQ(RC::SUCCESS, index_handler.close());
+}
+
+TEST(test_clog, test_group_commit) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  CLogOptions options;
+  options.commit_delay = 200;
+  CLogManager clog_manager;
+  ASSERT_EQ(RC::SUCCESS, clog_manager.open((dir + "/clog").c_str(), options));
+  ASSERT_EQ(RC::SUCCESS, clog_manager.recover(*theGlobalDiskBufferPool()));
+
+  const int thread_num = 8;
+  const int commit_per_thread = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&clog_manager, t]() {
+      char data[64];
+      memset(data, t, sizeof(data));
+      for (int i = 0; i < commit_per_thread; i++) {
+        LSN lsn;
+        ASSERT_EQ(RC::SUCCESS, clog_manager.append(CLogType::PAGE_WRITE, t + 1, "group_commit.data", 1, 0,
+                                                   data, sizeof(data), &lsn));
+        ASSERT_EQ(RC::SUCCESS, clog_manager.append(CLogType::COMMIT, t + 1, nullptr, BP_INVALID_PAGE_NUM, 0,
+                                                   nullptr, 0, &lsn));
+        ASSERT_EQ(RC::SUCCESS, clog_manager.sync(lsn));
+        ASSERT_LE(lsn, clog_manager.durable_lsn());
+        ASSERT_EQ(RC::SUCCESS, clog_manager.append(CLogType::TRX_END, t + 1, nullptr, BP_INVALID_PAGE_NUM, 0,
+                                                   nullptr, 0, &lsn));
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  CLogStats stats = clog_manager.stats();
+  ASSERT_EQ(thread_num * commit_per_thread, stats.commits);
+  ASSERT_LT(stats.syncs, stats.commits);
+  ASSERT_EQ(RC::SUCCESS, clog_manager.sync(clog_manager.current_lsn()));
+  ASSERT_EQ(clog_manager.durable_lsn(), file_size(segment_file(dir, 0)));
+  ASSERT_EQ(RC::SUCCESS, clog_manager.close());
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_recover_after_crash) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  crash_in_child(dir);
+  recover(dir, 1);
+  check_recovered(dir);
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_parallel_recover) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  crash_in_child(dir);
+  recover(dir, 8);
+  check_recovered(dir);
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_recover_twice) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  // 恢复过程中再次崩溃时日志还在，页面上的LSN不小于日志的LSN时跳过，结果不变
+  crash_in_child(dir);
+  run_command("mkdir " + dir + "/bak && cp " + dir + "/clog.* " + dir + "/bak/");
+  recover(dir, 4);
+  run_command("rm -f " + dir + "/clog.* && cp " + dir + "/bak/clog.* " + dir + "/");
+  recover(dir, 4);
+  check_recovered(dir);
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_recover_from_checkpoint) {
+  const std::string full_dir = make_temp_dir("clog_test");
+  const std::string checkpoint_dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(full_dir.empty());
+  ASSERT_FALSE(checkpoint_dir.empty());
+
+  long full_records = 0;
+  crash_in_child(full_dir);
+  recover(full_dir, 4, &full_records);
+  check_recovered(full_dir);
+
+  // 检查点之前的日志段已经删除，恢复时只重放检查点之后的更新和删除
+  long checkpoint_records = 0;
+  crash_in_child(checkpoint_dir, true);
+  ASSERT_EQ(1, segment_count(checkpoint_dir));
+  recover(checkpoint_dir, 4, &checkpoint_records);
+  check_recovered(checkpoint_dir);
+  ASSERT_LT(checkpoint_records, full_records / 2);
+
+  remove_temp_dir(full_dir);
+  remove_temp_dir(checkpoint_dir);
+}
+
+/**
+ * 子进程中分配事务号并提交，7只写了COMMIT，8写了COMMIT和TRX_END
+ */
+static int commit_and_crash(const std::string &dir) {
+  CLogManager clog_manager;
+  if (clog_manager.open((dir + "/clog").c_str()) != RC::SUCCESS ||
+      clog_manager.recover(*theGlobalDiskBufferPool()) != RC::SUCCESS ||
+      clog_manager.reserve_trx_id(8) != RC::SUCCESS) {
+    return 1;
+  }
+  LSN lsn;
+  if (clog_manager.append(CLogType::COMMIT, 7, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn) != RC::SUCCESS ||
+      clog_manager.append(CLogType::COMMIT, 8, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn) != RC::SUCCESS ||
+      clog_manager.append(CLogType::TRX_END, 8, nullptr, BP_INVALID_PAGE_NUM, 0, nullptr, 0, &lsn) != RC::SUCCESS ||
+      clog_manager.sync(lsn) != RC::SUCCESS) {
+    return 2;
+  }
+  _exit(0);
+}
+
+TEST(test_clog, test_recover_trx_state) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    _exit(commit_and_crash(dir));
+  }
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // 重启之后的事务号大于之前预留的事务号，只有7需要继续完成提交
+  for (int i = 0; i < 2; i++) {
+    CLogManager clog_manager;
+    ASSERT_EQ(RC::SUCCESS, clog_manager.open((dir + "/clog").c_str()));
+    ASSERT_EQ(RC::SUCCESS, clog_manager.recover(*theGlobalDiskBufferPool()));
+    ASSERT_GE(clog_manager.recovered_trx_id(), 8);
+    ASSERT_TRUE(clog_manager.is_recovered_commit(7));
+    ASSERT_FALSE(clog_manager.is_recovered_commit(8));
+    ASSERT_EQ(RC::SUCCESS, clog_manager.close());
+  }
+
+  CLogManager clog_manager;
+  ASSERT_EQ(RC::SUCCESS, clog_manager.open((dir + "/clog").c_str()));
+  ASSERT_EQ(RC::SUCCESS, clog_manager.recover(*theGlobalDiskBufferPool()));
+  clog_manager.finish_trx_recovery();
+  ASSERT_FALSE(clog_manager.is_recovered_commit(7));
+  ASSERT_EQ(RC::SUCCESS, clog_manager.checkpoint());
+  ASSERT_EQ(RC::SUCCESS, clog_manager.close());
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_async_commit) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  CLogOptions options;
+  options.async_commit_delay = 50;
+  CLogManager clog_manager;
+  ASSERT_EQ(RC::SUCCESS, clog_manager.open((dir + "/clog").c_str(), options));
+  ASSERT_EQ(RC::SUCCESS, clog_manager.recover(*theGlobalDiskBufferPool()));
+
+  // 异步提交直接返回，后台线程在async_commit_delay之后把这段时间的提交一起落盘
+  const int commit_num = 100;
+  LSN lsn = 0;
+  for (int i = 0; i < commit_num; i++) {
+    ASSERT_EQ(RC::SUCCESS, clog_manager.append(CLogType::COMMIT, i + 1, nullptr, BP_INVALID_PAGE_NUM, 0,
+                                               nullptr, 0, &lsn));
+    ASSERT_EQ(RC::SUCCESS, clog_manager.commit_async(lsn));
+  }
+  ASSERT_LT(clog_manager.durable_lsn(), lsn);
+  for (int i = 0; i < 100 && clog_manager.durable_lsn() < lsn; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(lsn, clog_manager.durable_lsn());
+  ASSERT_EQ(lsn, file_size(segment_file(dir, 0)));
+  CLogStats stats = clog_manager.stats();
+  ASSERT_GE(stats.async_flushes, 1);
+  ASSERT_LT(stats.syncs, commit_num / 10);
+  ASSERT_EQ(RC::SUCCESS, clog_manager.close());
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_incremental_checkpoint) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  CLogOptions options;
+  options.checkpoint_size = 0;
+  options.checkpoint_flush_rate = 200;
+  options.checkpoint_max_pause = 100;
+  CLogManager *clog_manager = theGlobalCLogManager();
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  ASSERT_EQ(RC::SUCCESS, clog_manager->open((dir + "/clog").c_str(), options));
+  ASSERT_EQ(RC::SUCCESS, clog_manager->recover(*buffer_pool));
+
+  const std::string data_file = dir + "/test.data";
+  int file_id;
+  RecordFileHandler record_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->create_file(data_file.c_str()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->open_file(data_file.c_str(), &file_id));
+  ASSERT_EQ(RC::SUCCESS, record_handler.init(*buffer_pool, file_id));
+  std::vector<RID> rids(RECORD_COUNT);
+  for (int i = 0; i < RECORD_COUNT; i++) {
+    TestRecord record;
+    memset(&record, 0, sizeof(record));
+    record.value = i;
+    ASSERT_EQ(RC::SUCCESS, record_handler.insert_record((const char *)&record, TEST_RECORD_SIZE, &rids[i]));
+  }
+
+  // 脏页表按(文件, 页面)排序，页面变脏时的日志位置都在检查点之前
+  const LSN lsn = clog_manager->current_lsn();
+  std::vector<DirtyPage> pages;
+  buffer_pool->dirty_page_table(lsn, pages);
+  ASSERT_GT(pages.size(), 2u);
+  for (size_t i = 0; i < pages.size(); i++) {
+    ASSERT_LT(pages[i].rec_lsn, lsn);
+    if (i > 0 && pages[i].file_desc == pages[i - 1].file_desc) {
+      ASSERT_LT(pages[i - 1].page_num, pages[i].page_num);
+    }
+  }
+
+  // 后台的检查点按限速写回
+  auto begin = std::chrono::steady_clock::now();
+  ASSERT_EQ(RC::SUCCESS, clog_manager->checkpoint(true));
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  ASSERT_GE(elapsed.count(), (pages.size() - 1) / (double)options.checkpoint_flush_rate * 0.99);
+  ASSERT_EQ(lsn, clog_manager->checkpoint_lsn());
+  ASSERT_EQ((long)pages.size(), clog_manager->stats().checkpoint_pages);
+  buffer_pool->dirty_page_table(clog_manager->current_lsn() + 1, pages);
+  ASSERT_TRUE(pages.empty());
+
+  // 检查点之后只修改了一个页面，下一个检查点只写回这个页面
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(rids[0].page_num, rids[i].page_num);
+    RC rc = record_handler.update_record_in_place(&rids[i], [](Record &record) {
+      ((TestRecord *)record.data)->version = 1;
+      return RC::SUCCESS;
+    });
+    ASSERT_EQ(RC::SUCCESS, rc);
+  }
+  buffer_pool->dirty_page_table(clog_manager->current_lsn(), pages);
+  ASSERT_EQ(1u, pages.size());
+  ASSERT_EQ(rids[0].page_num, pages[0].page_num);
+  ASSERT_GE(pages[0].rec_lsn, lsn);
+  const long checkpoint_pages = clog_manager->stats().checkpoint_pages;
+  ASSERT_EQ(RC::SUCCESS, clog_manager->checkpoint());
+  ASSERT_EQ(checkpoint_pages + 1, clog_manager->stats().checkpoint_pages);
+
+  record_handler.close();
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->close_file(file_id));
+  ASSERT_EQ(RC::SUCCESS, clog_manager->close());
+  remove_temp_dir(dir);
+}
+
+static bool crashed_after_open(const std::string &dir) {
+  CLogManager clog_manager;
+  EXPECT_EQ(RC::SUCCESS, clog_manager.open((dir + "/clog").c_str()));
+  EXPECT_EQ(RC::SUCCESS, clog_manager.recover(*theGlobalDiskBufferPool()));
+  const bool crashed = clog_manager.crashed();
+  EXPECT_EQ(RC::SUCCESS, clog_manager.close());
+  return crashed;
+}
+
+TEST(test_clog, test_unlogged_file_after_crash) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  // 新建的日志和正常关闭之后都不算崩溃
+  ASSERT_FALSE(crashed_after_open(dir));
+  ASSERT_FALSE(crashed_after_open(dir));
+
+  // 不记日志的文件上的修改不写日志
+  const std::string data_file = dir + "/unlogged.data";
+  DiskBufferPool *buffer_pool = theGlobalDiskBufferPool();
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    CLogManager *clog_manager = theGlobalCLogManager();
+    int file_id;
+    RecordFileHandler record_handler;
+    buffer_pool->set_file_logged(data_file.c_str(), false);
+    if (clog_manager->open((dir + "/clog").c_str()) != RC::SUCCESS ||
+        clog_manager->recover(*buffer_pool) != RC::SUCCESS ||
+        buffer_pool->create_file(data_file.c_str()) != RC::SUCCESS ||
+        buffer_pool->open_file(data_file.c_str(), &file_id) != RC::SUCCESS ||
+        record_handler.init(*buffer_pool, file_id) != RC::SUCCESS) {
+      _exit(1);
+    }
+    const LSN lsn = clog_manager->current_lsn();
+    for (int i = 0; i < RECORD_COUNT; i++) {
+      TestRecord record;
+      memset(&record, 0, sizeof(record));
+      record.value = i;
+      RID rid;
+      if (record_handler.insert_record((const char *)&record, TEST_RECORD_SIZE, &rid) != RC::SUCCESS) {
+        _exit(2);
+      }
+    }
+    _exit(clog_manager->current_lsn() == lsn ? 0 : 3);
+  }
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // 没有正常关闭，下次启动时要清空不记日志的文件
+  ASSERT_TRUE(crashed_after_open(dir));
+  ASSERT_FALSE(crashed_after_open(dir));
+  remove_temp_dir(dir);
+}
+
+TEST(test_clog, test_reject_old_file_format) {
+  const std::string dir = make_temp_dir("clog_test");
+  ASSERT_FALSE(dir.empty());
+
+  // 旧格式的页面开头没有LSN，文件头是page_num、page_count、allocated_pages和bitmap
+  const std::string data_file = dir + "/old.data";
+  std::vector<char> page(BP_PAGE_SIZE, 0);
+  int *header = (int *)page.data();
+  header[0] = 0;
+  header[1] = 1;
+  header[2] = 1;
+  page[3 * sizeof(int)] = 0x01;
+  FILE *file = fopen(data_file.c_str(), "wb");
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(page.size(), fwrite(page.data(), 1, page.size(), file));
+  ASSERT_EQ(0, fclose(file));
+
+  int file_id;
+  ASSERT_EQ(RC::NOTADB, theGlobalDiskBufferPool()->open_file(data_file.c_str(), &file_id));
+  remove_temp_dir(dir);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "storage/common/extendible_hash.h"
+#include "gtest/gtest.h"
+
+static RID make_rid(int value) {
+  RID rid;
+  rid.page_num = value / 100 + 1;
+  rid.slot_num = value % 100;
+  return rid;
+}
+
+TEST(test_extendible_hash, test_insert_lookup_delete) {
+  const char *index_file = "extendible_hash_test.index";
+  unlink(index_file);
+
+  ExtendibleHashHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, INTS, sizeof(int)));
+
+  const int count = 20000;
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  for (int value : values) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&value, &rid));
+  }
+  // 桶需要分裂很多次
+  ASSERT_GT(handler.global_depth(), 4);
+
+  int value = 7;
+  RID rid = make_rid(value);
+  ASSERT_EQ(RC::RECORD_DUPLICATE_KEY, handler.insert_entry((const char *)&value, &rid));
+
+  for (int value = 0; value < count; value++) {
+    std::vector<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entries((const char *)&value, rids));
+    ASSERT_EQ(1u, rids.size()) << value;
+    ASSERT_EQ(make_rid(value), rids[0]);
+  }
+
+  for (int value = 1; value < count; value += 2) {
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&value, &rid));
+  }
+  ASSERT_EQ(RC::RECORD_INVALID_KEY, handler.delete_entry((const char *)&value, &rid));
+  ASSERT_EQ(RC::SUCCESS, handler.close());
+
+  // 重新打开，目录需要被持久化
+  ASSERT_EQ(RC::SUCCESS, handler.open(index_file));
+  for (int value = 0; value < count; value++) {
+    std::vector<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entries((const char *)&value, rids));
+    ASSERT_EQ(value % 2 == 0 ? 1u : 0u, rids.size()) << value;
+  }
+
+  handler.close();
+  unlink(index_file);
+}
+
+TEST(test_extendible_hash, test_float_key) {
+  const char *index_file = "extendible_hash_float_test.index";
+  unlink(index_file);
+  ExtendibleHashHandler handler;
+  ASSERT_EQ(RC::INVALID_ARGUMENT, handler.create(index_file, FLOATS, sizeof(float)));
+  ASSERT_NE(0, access(index_file, F_OK));
+}
+
+TEST(test_extendible_hash, test_duplicate_values) {
+  const char *index_file = "extendible_hash_duplicate_test.index";
+  unlink(index_file);
+
+  // 同一个值对应大量RID，无法通过分裂解决，只能挂溢出页
+  char key[8] = "same";
+  ExtendibleHashHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_file, CHARS, sizeof(key)));
+  const int count = 3000;
+  for (int i = 0; i < count; i++) {
+    RID rid = make_rid(i);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(key, &rid));
+  }
+  char other[8] = "other";
+  RID other_rid = make_rid(count);
+  ASSERT_EQ(RC::SUCCESS, handler.insert_entry(other, &other_rid));
+
+  std::vector<RID> rids;
+  ASSERT_EQ(RC::SUCCESS, handler.get_entries(key, rids));
+  ASSERT_EQ((size_t)count, rids.size());
+  std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) {
+    return a.page_num != b.page_num ? a.page_num < b.page_num : a.slot_num < b.slot_num;
+  });
+  for (int i = 0; i < count; i++) {
+    ASSERT_EQ(make_rid(i), rids[i]);
+  }
+
+  // 删除全部重复值后，溢出页被回收
+  for (int i = 0; i < count; i++) {
+    RID rid = make_rid(i);
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry(key, &rid));
+  }
+  rids.clear();
+  ASSERT_EQ(RC::SUCCESS, handler.get_entries(key, rids));
+  ASSERT_TRUE(rids.empty());
+  rids.clear();
+  ASSERT_EQ(RC::SUCCESS, handler.get_entries(other, rids));
+  ASSERT_EQ(1u, rids.size());
+  ASSERT_EQ(other_rid, rids[0]);
+
+  handler.close();
+  unlink(index_file);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,201 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "storage/trx/lock_manager.h"
+#include "gtest/gtest.h"
+
+// 只用作锁的键，不会被访问
+static Table *const TABLE = (Table *)0x1000;
+
+static LockId row(int page_num, int slot_num) {
+  RID rid;
+  rid.page_num = page_num;
+  rid.slot_num = slot_num;
+  return LockId::record_lock(TABLE, rid);
+}
+
+static void sleep_ms(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+class LockManagerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    LockOptions::instance().wait_timeout = 1000;
+  }
+  LockManager lock_manager_;
+};
+
+TEST_F(LockManagerTest, test_compatible) {
+  LockSet set1;
+  LockSet set2;
+  const LockId table = LockId::table_lock(TABLE);
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, table, LockMode::IX));
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, table, LockMode::IS));
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, table, LockMode::IX));
+  ASSERT_TRUE(set2.holds(table, LockMode::IS));
+  ASSERT_FALSE(set2.holds(table, LockMode::S));
+
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(1, 1), LockMode::S));
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, row(1, 1), LockMode::S));
+
+  // 表上有意向排他锁，共享表锁要等待
+  LockOptions::instance().wait_timeout = 50;
+  LockSet set3;
+  ASSERT_EQ(RC::BUSY_TIMEOUT, lock_manager_.lock(3, set3, table, LockMode::S));
+  ASSERT_EQ(0, (int)set3.size());
+  ASSERT_EQ(1, lock_manager_.stats().timeouts);
+
+  lock_manager_.unlock_all(1, set1);
+  lock_manager_.unlock_all(2, set2);
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(3, set3, table, LockMode::S));
+  lock_manager_.unlock_all(3, set3);
+}
+
+TEST_F(LockManagerTest, test_fast_path) {
+  LockSet set1;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(1, i), LockMode::X));
+  }
+  // 重复加锁直接返回
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(1, 0), LockMode::S));
+  ASSERT_EQ(100, (int)set1.size());
+  ASSERT_EQ(0, lock_manager_.stats().slow_acquires);
+
+  // 其它事务的锁要等待持有者释放
+  LockSet set2;
+  std::atomic<bool> acquired{false};
+  std::thread waiter([&]() {
+    ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, row(1, 7), LockMode::S));
+    acquired = true;
+  });
+  sleep_ms(50);
+  ASSERT_FALSE(acquired.load());
+  lock_manager_.unlock_all(1, set1);
+  waiter.join();
+  ASSERT_TRUE(acquired.load());
+  ASSERT_EQ(1, lock_manager_.stats().waits);
+  lock_manager_.unlock_all(2, set2);
+
+  // 全部释放之后又可以走快速路径
+  const long slow_acquires = lock_manager_.stats().slow_acquires;
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(3, set1, row(1, 7), LockMode::X));
+  ASSERT_EQ(slow_acquires, lock_manager_.stats().slow_acquires);
+  lock_manager_.unlock_all(3, set1);
+}
+
+TEST_F(LockManagerTest, test_fifo) {
+  LockSet set1;
+  LockSet set2;
+  LockSet set3;
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(2, 1), LockMode::S));
+
+  // 排他锁在等待，后来的共享锁不能插队
+  std::vector<int> order;
+  std::mutex order_lock;
+  std::thread writer([&]() {
+    ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, row(2, 1), LockMode::X));
+    std::lock_guard<std::mutex> guard(order_lock);
+    order.push_back(2);
+  });
+  sleep_ms(50);
+  std::thread reader([&]() {
+    ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(3, set3, row(2, 1), LockMode::S));
+    std::lock_guard<std::mutex> guard(order_lock);
+    order.push_back(3);
+  });
+  sleep_ms(50);
+  ASSERT_TRUE(order.empty());
+
+  lock_manager_.unlock_all(1, set1);
+  writer.join();
+  sleep_ms(50);
+  {
+    std::lock_guard<std::mutex> guard(order_lock);
+    ASSERT_EQ(1, (int)order.size());
+  }
+  lock_manager_.unlock_all(2, set2);
+  reader.join();
+  ASSERT_EQ(2, order[0]);
+  ASSERT_EQ(3, order[1]);
+  lock_manager_.unlock_all(3, set3);
+}
+
+TEST_F(LockManagerTest, test_upgrade) {
+  LockSet set1;
+  LockSet set2;
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(3, 1), LockMode::S));
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(3, 1), LockMode::X));
+  ASSERT_TRUE(set1.holds(row(3, 1), LockMode::X));
+
+  LockOptions::instance().wait_timeout = 50;
+  ASSERT_EQ(RC::BUSY_TIMEOUT, lock_manager_.lock(2, set2, row(3, 1), LockMode::S));
+  lock_manager_.unlock_all(1, set1);
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, row(3, 1), LockMode::S));
+  lock_manager_.unlock_all(2, set2);
+}
+
+TEST_F(LockManagerTest, test_deadlock) {
+  LockSet set1;
+  LockSet set2;
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(1, set1, row(4, 1), LockMode::X));
+  ASSERT_EQ(RC::SUCCESS, lock_manager_.lock(2, set2, row(4, 2), LockMode::X));
+
+  RC rc1 = RC::GENERIC_ERROR;
+  std::thread trx1([&]() {
+    rc1 = lock_manager_.lock(1, set1, row(4, 2), LockMode::X);
+  });
+  sleep_ms(50);
+  // 事务2再等待事务1就形成了环，后等待的事务放弃
+  ASSERT_EQ(RC::LOCKED_DEADLOCK, lock_manager_.lock(2, set2, row(4, 1), LockMode::X));
+  ASSERT_EQ(1, lock_manager_.stats().deadlocks);
+  lock_manager_.unlock_all(2, set2);
+  trx1.join();
+  ASSERT_EQ(RC::SUCCESS, rc1);
+  lock_manager_.unlock_all(1, set1);
+}
+
+TEST_F(LockManagerTest, test_concurrent) {
+  const int thread_num = 8;
+  const int count = 2000;
+  int counters[4] = {0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < count; i++) {
+        const int32_t trx_id = t * count + i + 1;
+        LockSet lock_set;
+        const int key = (t + i) % 4;
+        RC rc = lock_manager_.lock(trx_id, lock_set, row(5, key), LockMode::X);
+        ASSERT_EQ(RC::SUCCESS, rc);
+        counters[key]++;
+        lock_manager_.unlock_all(trx_id, lock_set);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(thread_num * count, counters[0] + counters[1] + counters[2] + counters[3]);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,336 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "storage/common/lsm_tree.h"
+#include "gtest/gtest.h"
+
+static const int KEY_LENGTH = 4;
+
+// 大端序，按字节比较和按整数比较的结果一致
+static void make_key(int value, char *key) {
+  key[0] = (char)((value >> 24) & 0xFF);
+  key[1] = (char)((value >> 16) & 0xFF);
+  key[2] = (char)((value >> 8) & 0xFF);
+  key[3] = (char)(value & 0xFF);
+}
+
+static int parse_key(const char *key) {
+  return ((uint8_t)key[0] << 24) | ((uint8_t)key[1] << 16) | ((uint8_t)key[2] << 8) | (uint8_t)key[3];
+}
+
+static RID make_rid(int value) {
+  RID rid;
+  rid.page_num = value / 100 + 1;
+  rid.slot_num = value % 100;
+  return rid;
+}
+
+static void set_options(size_t memtable_size, int runs_per_level) {
+  LsmOptions::instance().memtable_size = memtable_size;
+  LsmOptions::instance().runs_per_level = runs_per_level;
+}
+
+static void remove_lsm(LsmTree &tree, const char *file_name) {
+  tree.destroy();
+  unlink(file_name);
+}
+
+/**
+ * 扫描[low, high]中的所有值
+ */
+static std::vector<int> scan(LsmTree &tree, int low, int high) {
+  char low_key[KEY_LENGTH];
+  char high_key[KEY_LENGTH];
+  make_key(low, low_key);
+  make_key(high, high_key);
+
+  std::vector<int> values;
+  LsmScanner scanner(tree);
+  EXPECT_EQ(RC::SUCCESS, scanner.open(low_key, KEY_LENGTH, true, high_key, KEY_LENGTH, true));
+  RID rid;
+  char key[KEY_LENGTH];
+  while (scanner.next_entry(&rid, key) == RC::SUCCESS) {
+    const int value = parse_key(key);
+    EXPECT_EQ(make_rid(value), rid);
+    values.push_back(value);
+  }
+  scanner.close();
+  return values;
+}
+
+static int total_runs(const LsmStats &stats) {
+  int runs = 0;
+  for (int level_runs : stats.level_runs) {
+    runs += level_runs;
+  }
+  return runs;
+}
+
+TEST(test_lsm_tree, test_rid_encoding) {
+  RID rids[] = {{-1, 0}, {0, -1}, {0, 0}, {0, 1}, {1, 0}, {1, 5}, {100, 0}};
+  for (size_t i = 0; i + 1 < sizeof(rids) / sizeof(rids[0]); i++) {
+    char a[8], b[8];
+    LsmTree::encode_rid(&rids[i], a);
+    LsmTree::encode_rid(&rids[i + 1], b);
+    ASSERT_LT(memcmp(a, b, sizeof(a)), 0) << i;
+
+    RID decoded;
+    LsmTree::decode_rid(a, &decoded);
+    ASSERT_EQ(rids[i], decoded);
+  }
+}
+
+TEST(test_lsm_tree, test_insert_delete_scan) {
+  const char *file_name = "lsm_tree_test.lsm";
+  set_options(64 * 1024, 4);
+  LsmTree tree;
+  remove_lsm(tree, file_name);
+  ASSERT_EQ(RC::SUCCESS, tree.create(file_name, KEY_LENGTH, KEY_LENGTH));
+
+  const int count = 50000;
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(i);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+
+  std::set<int> expect;
+  char key[KEY_LENGTH];
+  for (int value : values) {
+    make_key(value, key);
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, tree.insert_entry(key, &rid));
+    expect.insert(value);
+  }
+  for (int i = 0; i < count; i += 3) {
+    make_key(values[i], key);
+    RID rid = make_rid(values[i]);
+    ASSERT_EQ(RC::SUCCESS, tree.delete_entry(key, &rid));
+    expect.erase(values[i]);
+  }
+  // memtable写出了很多次，数据分散在多层的文件中
+  ASSERT_EQ(RC::SUCCESS, tree.sync());
+  LsmStats stats = tree.stats();
+  ASSERT_GT(stats.flushes, 10);
+  ASSERT_GT(stats.level_runs.size(), 1u);
+
+  std::vector<int> result = scan(tree, 0, count);
+  ASSERT_EQ(std::vector<int>(expect.begin(), expect.end()), result);
+
+  result = scan(tree, 1000, 1999);
+  ASSERT_EQ(std::vector<int>(expect.lower_bound(1000), expect.upper_bound(1999)), result);
+
+  for (int value = 0; value < count; value += 97) {
+    result = scan(tree, value, value);
+    ASSERT_EQ(expect.count(value), result.size()) << value;
+  }
+
+  // 删除后重新插入
+  for (int i = 0; i < count; i += 3) {
+    make_key(values[i], key);
+    RID rid = make_rid(values[i]);
+    ASSERT_EQ(RC::SUCCESS, tree.insert_entry(key, &rid));
+  }
+  ASSERT_EQ((size_t)count, scan(tree, 0, count).size());
+
+  remove_lsm(tree, file_name);
+}
+
+TEST(test_lsm_tree, test_compaction) {
+  const char *file_name = "lsm_tree_compaction_test.lsm";
+  // 每个文件有一个块的文件头和Bloom过滤器，memtable太小时这些额外的开销会超过数据本身
+  set_options(128 * 1024, 3);
+  LsmTree tree;
+  remove_lsm(tree, file_name);
+  ASSERT_EQ(RC::SUCCESS, tree.create(file_name, KEY_LENGTH, KEY_LENGTH));
+
+  const int count = 100000;
+  char key[KEY_LENGTH];
+  for (int value = 0; value < count; value++) {
+    make_key(value, key);
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, tree.insert_entry(key, &rid));
+  }
+  for (int value = 0; value < count; value++) {
+    make_key(value, key);
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, tree.delete_entry(key, &rid));
+  }
+  ASSERT_EQ(RC::SUCCESS, tree.compact());
+
+  // 每一层的文件个数都少于runs_per_level
+  LsmStats stats = tree.stats();
+  ASSERT_GT(stats.compactions, 0);
+  for (int level_runs : stats.level_runs) {
+    ASSERT_LT(level_runs, 3);
+  }
+  ASSERT_TRUE(scan(tree, 0, count).empty());
+
+  // 每个索引项每下降一层只重写一次
+  ASSERT_LE(stats.write_amplification(), (double)stats.level_runs.size() + 1)
+      << "levels=" << stats.level_runs.size() << ", flushes=" << stats.flushes;
+
+  // 最底层合并时去掉删除标记，全部删除的数据合并后不再占用文件
+  for (int i = 0; i < 6; i++) {
+    make_key(i, key);
+    RID rid = make_rid(i);
+    ASSERT_EQ(RC::SUCCESS, tree.insert_entry(key, &rid));
+    ASSERT_EQ(RC::SUCCESS, tree.delete_entry(key, &rid));
+    ASSERT_EQ(RC::SUCCESS, tree.compact());
+  }
+  ASSERT_LE(total_runs(tree.stats()), 2);
+
+  remove_lsm(tree, file_name);
+}
+
+TEST(test_lsm_tree, test_reopen) {
+  const char *file_name = "lsm_tree_reopen_test.lsm";
+  set_options(32 * 1024, 4);
+  const int count = 20000;
+  {
+    LsmTree tree;
+    remove_lsm(tree, file_name);
+    ASSERT_EQ(RC::SUCCESS, tree.create(file_name, KEY_LENGTH, KEY_LENGTH));
+    ASSERT_EQ(RC::SCHEMA_INDEX_EXIST, LsmTree().create(file_name, KEY_LENGTH, KEY_LENGTH));
+    char key[KEY_LENGTH];
+    for (int value = 0; value < count; value++) {
+      make_key(value, key);
+      RID rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, tree.insert_entry(key, &rid));
+    }
+    for (int value = 0; value < count; value += 2) {
+      make_key(value, key);
+      RID rid = make_rid(value);
+      ASSERT_EQ(RC::SUCCESS, tree.delete_entry(key, &rid));
+    }
+    // 还在memtable中的数据关闭时写出
+    ASSERT_EQ(RC::SUCCESS, tree.close());
+  }
+
+  LsmTree tree;
+  ASSERT_EQ(RC::SUCCESS, tree.open(file_name));
+  ASSERT_EQ(KEY_LENGTH, tree.key_length());
+  std::vector<int> result = scan(tree, 0, count);
+  ASSERT_EQ((size_t)count / 2, result.size());
+  for (size_t i = 0; i < result.size(); i++) {
+    ASSERT_EQ((int)i * 2 + 1, result[i]);
+  }
+  remove_lsm(tree, file_name);
+}
+
+TEST(test_lsm_tree, test_unbounded_scan) {
+  const char *file_name = "lsm_tree_unbounded_test.lsm";
+  set_options(16 * 1024, 4);
+  LsmTree tree;
+  remove_lsm(tree, file_name);
+  ASSERT_EQ(RC::SUCCESS, tree.create(file_name, KEY_LENGTH, KEY_LENGTH));
+
+  const int count = 5000;
+  char key[KEY_LENGTH];
+  for (int value = 0; value < count; value++) {
+    make_key(value, key);
+    RID rid = make_rid(value);
+    ASSERT_EQ(RC::SUCCESS, tree.insert_entry(key, &rid));
+  }
+
+  // 只有上界，或者只有下界且不包含
+  LsmScanner scanner(tree);
+  char high[KEY_LENGTH];
+  make_key(100, high);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, true, high, KEY_LENGTH, false));
+  RID rid;
+  int num = 0;
+  while (scanner.next_entry(&rid, nullptr) == RC::SUCCESS) {
+    ASSERT_EQ(make_rid(num), rid);
+    num++;
+  }
+  ASSERT_EQ(100, num);
+  scanner.close();
+
+  char low[KEY_LENGTH];
+  make_key(count - 100, low);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(low, KEY_LENGTH, false, nullptr, 0, true));
+  num = 0;
+  while (scanner.next_entry(&rid, nullptr) == RC::SUCCESS) {
+    num++;
+  }
+  ASSERT_EQ(99, num);
+  scanner.close();
+
+  remove_lsm(tree, file_name);
+}
+
+TEST(test_lsm_tree, test_concurrent) {
+  const char *file_name = "lsm_tree_concurrent_test.lsm";
+  set_options(16 * 1024, 3);
+  LsmTree tree;
+  remove_lsm(tree, file_name);
+  ASSERT_EQ(RC::SUCCESS, tree.create(file_name, KEY_LENGTH, KEY_LENGTH));
+
+  // 每个写线程写自己的一段，扫描线程检查看到的数据都在已经写过的范围内并且有序
+  const int thread_num = 4;
+  const int per_thread = 20000;
+  std::atomic<bool> done(false);
+  std::atomic<int> errors(0);
+  std::vector<std::thread> writers;
+  for (int t = 0; t < thread_num; t++) {
+    writers.emplace_back([&tree, &errors, t]() {
+      char key[KEY_LENGTH];
+      for (int i = 0; i < per_thread; i++) {
+        const int value = t * per_thread + i;
+        make_key(value, key);
+        RID rid = make_rid(value);
+        if (tree.insert_entry(key, &rid) != RC::SUCCESS) {
+          errors++;
+        }
+      }
+    });
+  }
+  std::thread reader([&tree, &done, &errors]() {
+    while (!done.load()) {
+      std::vector<int> values = scan(tree, 0, thread_num * per_thread);
+      if (!std::is_sorted(values.begin(), values.end()) ||
+          std::adjacent_find(values.begin(), values.end()) != values.end()) {
+        errors++;
+      }
+    }
+  });
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+  done.store(true);
+  reader.join();
+  ASSERT_EQ(0, errors.load());
+
+  std::vector<int> values = scan(tree, 0, thread_num * per_thread);
+  ASSERT_EQ((size_t)thread_num * per_thread, values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    ASSERT_EQ((int)i, values[i]);
+  }
+  remove_lsm(tree, file_name);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,440 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/common/meta_util.h"
+#include "storage/common/index.h"
+#include "storage/common/table.h"
+#include "storage/trx/mvcc_manager.h"
+#include "storage/trx/occ_manager.h"
+#include "storage/trx/trx.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+static const int ROW_COUNT = 100;
+static const int INIT_BALANCE = 10;
+
+class MvccTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = make_temp_dir("mvcc_test");
+    ASSERT_FALSE(dir_.empty());
+
+    AttrInfo attributes[] = {
+        {(char *)"id", INTS, sizeof(int)},
+        {(char *)"balance", INTS, sizeof(int)},
+    };
+    table_ = new Table();
+    ASSERT_EQ(RC::SUCCESS, table_->create(table_meta_file(dir_.c_str(), "account").c_str(), "account",
+                                          dir_.c_str(), 2, attributes));
+    balance_offset_ = table_->table_meta().field("balance")->offset();
+
+    Trx trx;
+    for (int i = 0; i < ROW_COUNT; i++) {
+      ASSERT_EQ(RC::SUCCESS, insert(&trx, i, INIT_BALANCE));
+    }
+    ASSERT_EQ(RC::SUCCESS, trx.commit());
+  }
+
+  void TearDown() override {
+    delete table_;
+    remove_temp_dir(dir_);
+  }
+
+  RC insert(Trx *trx, int id, int balance) {
+    int id_value = id;
+    int balance_value = balance;
+    Value values[] = {
+        {INTS, &id_value},
+        {INTS, &balance_value},
+    };
+    return table_->insert_record(trx, 2, values);
+  }
+
+  RC set_balance(Trx *trx, int balance, int *updated_count) {
+    int balance_value = balance;
+    Value value = {INTS, &balance_value};
+    return table_->update_record(trx, "balance", &value, nullptr, updated_count);
+  }
+
+  struct Sum {
+    int offset;
+    int count;
+    long balance;
+  };
+
+  // trx为空时统计数据文件中所有的版本
+  Sum sum(Trx *trx) {
+    Sum sum = {balance_offset_, 0, 0};
+    RC rc = table_->scan_record(trx, nullptr, -1, &sum, [](const char *data, void *context) {
+      Sum *sum = (Sum *)context;
+      sum->count++;
+      sum->balance += *(const int *)(data + sum->offset);
+    });
+    EXPECT_EQ(RC::SUCCESS, rc);
+    return sum;
+  }
+
+protected:
+  std::string dir_;
+  Table *table_ = nullptr;
+  int balance_offset_ = 0;
+};
+
+TEST_F(MvccTest, test_snapshot_read) {
+  Trx reader;
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, sum(&reader).balance);
+
+  // 未提交的修改只有自己能看到
+  Trx writer;
+  int updated_count = 0;
+  ASSERT_EQ(RC::SUCCESS, set_balance(&writer, 0, &updated_count));
+  ASSERT_EQ(ROW_COUNT, updated_count);
+  ASSERT_EQ(RC::SUCCESS, insert(&writer, ROW_COUNT, 1));
+  Sum writer_sum = sum(&writer);
+  ASSERT_EQ(ROW_COUNT + 1, writer_sum.count);
+  ASSERT_EQ(1, writer_sum.balance);
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, sum(&reader).balance);
+
+  // 快照建立之后提交的修改也看不到
+  ASSERT_EQ(RC::SUCCESS, writer.commit());
+  Sum reader_sum = sum(&reader);
+  ASSERT_EQ(ROW_COUNT, reader_sum.count);
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, reader_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, reader.commit());
+
+  Trx new_reader;
+  Sum new_sum = sum(&new_reader);
+  ASSERT_EQ(ROW_COUNT + 1, new_sum.count);
+  ASSERT_EQ(1, new_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, new_reader.commit());
+}
+
+TEST_F(MvccTest, test_write_conflict) {
+  // 另一个事务正在删除，等它回滚之后可以修改
+  Trx trx1;
+  int deleted_count = 0;
+  ASSERT_EQ(RC::SUCCESS, table_->delete_record(&trx1, nullptr, &deleted_count));
+  ASSERT_EQ(ROW_COUNT, deleted_count);
+  RC trx2_rc = RC::GENERIC_ERROR;
+  std::thread trx2_thread([&]() {
+    Trx trx2;
+    trx2_rc = set_balance(&trx2, INIT_BALANCE, nullptr);
+    trx2.commit();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(RC::SUCCESS, trx1.rollback());
+  trx2_thread.join();
+  ASSERT_EQ(RC::SUCCESS, trx2_rc);
+
+  // 等待的事务提交了删除
+  Trx trx5;
+  ASSERT_EQ(RC::SUCCESS, set_balance(&trx5, INIT_BALANCE, nullptr));
+  Trx trx6;
+  ASSERT_EQ(ROW_COUNT, sum(&trx6).count);
+  std::thread trx5_thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    trx5.commit();
+  });
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, set_balance(&trx6, 1, nullptr));
+  trx5_thread.join();
+  ASSERT_EQ(RC::SUCCESS, trx6.rollback());
+
+  // 快照之后被其它事务修改并提交
+  Trx trx3;
+  ASSERT_EQ(ROW_COUNT, sum(&trx3).count);
+  Trx trx4;
+  ASSERT_EQ(RC::SUCCESS, set_balance(&trx4, 1, nullptr));
+  ASSERT_EQ(RC::SUCCESS, trx4.commit());
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, table_->delete_record(&trx3, nullptr, nullptr));
+  ASSERT_EQ(RC::SUCCESS, trx3.rollback());
+
+  Trx reader;
+  Sum reader_sum = sum(&reader);
+  ASSERT_EQ(ROW_COUNT, reader_sum.count);
+  ASSERT_EQ(ROW_COUNT, reader_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, reader.commit());
+}
+
+TEST_F(MvccTest, test_rollback) {
+  Trx writer;
+  ASSERT_EQ(RC::SUCCESS, set_balance(&writer, 0, nullptr));
+  ASSERT_EQ(RC::SUCCESS, insert(&writer, ROW_COUNT, 1));
+  ASSERT_EQ(RC::SUCCESS, writer.rollback());
+
+  Trx reader;
+  Sum reader_sum = sum(&reader);
+  ASSERT_EQ(ROW_COUNT, reader_sum.count);
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, reader_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, reader.commit());
+
+  // 回滚的插入已经删除，只剩下删除标记被清除的旧版本
+  ASSERT_EQ(ROW_COUNT, sum(nullptr).count);
+
+  // 回滚之后其它事务可以修改这些记录
+  Trx trx;
+  ASSERT_EQ(RC::SUCCESS, set_balance(&trx, 1, nullptr));
+  ASSERT_EQ(RC::SUCCESS, trx.commit());
+}
+
+TEST_F(MvccTest, test_modify_twice) {
+  // 同一个事务插入之后又修改两次，只有插入的操作需要处理
+  Trx writer;
+  ASSERT_EQ(RC::SUCCESS, insert(&writer, ROW_COUNT, 1));
+  ASSERT_EQ(RC::SUCCESS, set_balance(&writer, 2, nullptr));
+  ASSERT_EQ(RC::SUCCESS, set_balance(&writer, 3, nullptr));
+  Sum writer_sum = sum(&writer);
+  ASSERT_EQ(ROW_COUNT + 1, writer_sum.count);
+  ASSERT_EQ((ROW_COUNT + 1) * 3, writer_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, writer.commit());
+
+  Trx reader;
+  Sum reader_sum = sum(&reader);
+  ASSERT_EQ(ROW_COUNT + 1, reader_sum.count);
+  ASSERT_EQ((ROW_COUNT + 1) * 3, reader_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, reader.commit());
+
+  Trx rollback_writer;
+  ASSERT_EQ(RC::SUCCESS, set_balance(&rollback_writer, 4, nullptr));
+  ASSERT_EQ(RC::SUCCESS, set_balance(&rollback_writer, 5, nullptr));
+  ASSERT_EQ(RC::SUCCESS, rollback_writer.rollback());
+  Trx checker;
+  ASSERT_EQ((ROW_COUNT + 1) * 3, sum(&checker).balance);
+  ASSERT_EQ(RC::SUCCESS, checker.commit());
+}
+
+TEST_F(MvccTest, test_rollback_index_entries) {
+  const char *index_fields[] = {"balance"};
+  ASSERT_EQ(RC::SUCCESS, table_->create_index(nullptr, "account_balance", 1, index_fields, 0, nullptr));
+  Index *index = table_->find_index_for_join("balance");
+  ASSERT_NE(nullptr, index);
+  auto count_entries = [index](int balance) {
+    IndexScanner *scanner = index->create_scanner(EQUAL_TO, (const char *)&balance);
+    int count = 0;
+    RID rid;
+    while (scanner->next_entry(&rid) == RC::SUCCESS) {
+      count++;
+    }
+    scanner->destroy();
+    return count;
+  };
+
+  // 插入和修改的记录跨多个页面，回滚时按页面删除记录，按key的顺序删除索引项
+  const int insert_num = 2000;
+  Trx writer;
+  for (int i = 0; i < insert_num; i++) {
+    ASSERT_EQ(RC::SUCCESS, insert(&writer, ROW_COUNT + i, insert_num - i));
+  }
+  ASSERT_EQ(RC::SUCCESS, set_balance(&writer, -1, nullptr));
+  ASSERT_EQ(ROW_COUNT + insert_num, count_entries(-1));
+  ASSERT_EQ(RC::SUCCESS, writer.rollback());
+
+  ASSERT_EQ(0, count_entries(-1));
+  ASSERT_EQ(0, count_entries(insert_num));
+  ASSERT_EQ(ROW_COUNT, count_entries(INIT_BALANCE));
+  ASSERT_EQ(ROW_COUNT, sum(nullptr).count);
+}
+
+TEST_F(MvccTest, test_garbage_collection) {
+  MvccManager *mvcc_manager = theGlobalMvccManager();
+  mvcc_manager->collect_garbage();
+
+  Trx reader;
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, sum(&reader).balance);
+
+  for (int i = 0; i < 3; i++) {
+    Trx writer;
+    ASSERT_EQ(RC::SUCCESS, set_balance(&writer, i, nullptr));
+    ASSERT_EQ(RC::SUCCESS, writer.commit());
+  }
+
+  // 旧版本还被reader的快照需要
+  mvcc_manager->collect_garbage();
+  ASSERT_EQ(ROW_COUNT * 4, sum(nullptr).count);
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, sum(&reader).balance);
+  ASSERT_EQ(RC::SUCCESS, reader.commit());
+
+  mvcc_manager->collect_garbage();
+  Sum all_versions = sum(nullptr);
+  ASSERT_EQ(ROW_COUNT, all_versions.count);
+  ASSERT_EQ(ROW_COUNT * 2, all_versions.balance);
+  ASSERT_EQ(0, mvcc_manager->stats().pending_garbage);
+}
+
+TEST_F(MvccTest, test_index_scan_with_purge) {
+  const char *index_fields[] = {"balance"};
+  ASSERT_EQ(RC::SUCCESS, table_->create_index(nullptr, "account_balance", 1, index_fields, 0, nullptr));
+  Index *index = table_->find_index_for_join("balance");
+  ASSERT_NE(nullptr, index);
+  const FieldMeta *balance_field = table_->table_meta().field("balance");
+
+  // 不断删除所有记录再插入同样多的新记录，提交之后马上清理旧版本，和通过索引读取的事务并发。
+  // 线程中失败时不能直接返回，否则读取的循环不会结束
+  auto write_round = [this](int round) {
+    Trx writer;
+    int deleted_count = 0;
+    EXPECT_EQ(RC::SUCCESS, table_->delete_record(&writer, nullptr, &deleted_count));
+    EXPECT_EQ(ROW_COUNT, deleted_count);
+    for (int i = 0; i < ROW_COUNT; i++) {
+      EXPECT_EQ(RC::SUCCESS, insert(&writer, round * ROW_COUNT + i, INIT_BALANCE));
+    }
+    EXPECT_EQ(RC::SUCCESS, writer.commit());
+    theGlobalMvccManager()->collect_garbage();
+    return !HasFailure();
+  };
+  std::atomic<bool> stop{false};
+  std::thread writer_thread([&]() {
+    for (int round = 1; round <= 200 && write_round(round); round++) {
+    }
+    stop.store(true);
+  });
+
+  // 被清理的记录不能让扫描失败，也不能被当成可见的记录返回
+  const int balance = INIT_BALANCE;
+  const std::vector<const char *> values = {(const char *)&balance};
+  int rounds = 0;
+  while (!stop.load() && !HasFailure()) {
+    Trx reader;
+    int count = 0;
+    bool done = false;
+    EXPECT_EQ(RC::SUCCESS, table_->count_by_index(&reader, nullptr, &count, &done));
+    EXPECT_TRUE(done);
+    EXPECT_EQ(ROW_COUNT, count);
+
+    count = 0;
+    EXPECT_EQ(RC::SUCCESS, table_->probe_record(&reader, index, values, nullptr, &count,
+                                                [](int probe, const char *data, void *context) {
+      (*(int *)context)++;
+    }));
+    EXPECT_EQ(ROW_COUNT, count);
+
+    int max_balance = 0;
+    bool found = false;
+    EXPECT_EQ(RC::SUCCESS, table_->min_max_by_index(&reader, balance_field, true, (char *)&max_balance,
+                                                    &found, &done));
+    EXPECT_TRUE(found);
+    EXPECT_EQ(INIT_BALANCE, max_balance);
+    EXPECT_EQ(RC::SUCCESS, reader.commit());
+    rounds++;
+  }
+  stop.store(true);
+  writer_thread.join();
+  ASSERT_GT(rounds, 0);
+}
+
+TEST_F(MvccTest, test_commit_durability) {
+  AttrInfo attributes[] = {
+      {(char *)"id", INTS, sizeof(int)},
+  };
+  Table scratch;
+  ASSERT_EQ(RC::SUCCESS, scratch.create(table_meta_file(dir_.c_str(), "scratch").c_str(), "scratch", dir_.c_str(), 1,
+                                        attributes, DURABILITY_NOLOG));
+  ASSERT_EQ(DURABILITY_NOLOG, scratch.table_meta().durability());
+  ASSERT_EQ(DURABILITY_SYNC, table_->table_meta().durability());
+
+  CommitMetric &metric = commit_metric();
+  const long sync_commits = metric.stats(DURABILITY_SYNC).commits;
+  const long async_commits = metric.stats(DURABILITY_ASYNC).commits;
+  const long nolog_commits = metric.stats(DURABILITY_NOLOG).commits;
+  int id = ROW_COUNT;
+  Value value = {INTS, &id};
+
+  // 只修改了不记日志的表，不写COMMIT日志
+  Trx trx;
+  ASSERT_EQ(RC::SUCCESS, scratch.insert_record(&trx, 1, &value));
+  ASSERT_EQ(RC::SUCCESS, trx.commit());
+  ASSERT_EQ(nolog_commits + 1, metric.stats(DURABILITY_NOLOG).commits);
+
+  // 同时修改了记日志的表时按它的级别提交
+  ASSERT_EQ(RC::SUCCESS, scratch.insert_record(&trx, 1, &value));
+  ASSERT_EQ(RC::SUCCESS, insert(&trx, id, INIT_BALANCE));
+  ASSERT_EQ(RC::SUCCESS, trx.commit());
+  ASSERT_EQ(sync_commits + 1, metric.stats(DURABILITY_SYNC).commits);
+
+  // 会话的设置覆盖表的设置，但是不会让不记日志的表记日志
+  trx.set_durability(DURABILITY_ASYNC);
+  ASSERT_EQ(RC::SUCCESS, insert(&trx, id + 1, INIT_BALANCE));
+  ASSERT_EQ(RC::SUCCESS, trx.commit());
+  ASSERT_EQ(async_commits + 1, metric.stats(DURABILITY_ASYNC).commits);
+  ASSERT_EQ(RC::SUCCESS, scratch.insert_record(&trx, 1, &value));
+  ASSERT_EQ(RC::SUCCESS, trx.commit());
+  ASSERT_EQ(nolog_commits + 2, metric.stats(DURABILITY_NOLOG).commits);
+  ASSERT_LE(metric.stats(DURABILITY_SYNC).mean_latency_us(), metric.stats(DURABILITY_SYNC).max_latency_us);
+
+  ASSERT_EQ(ROW_COUNT + 2, sum(nullptr).count);
+}
+
+TEST_F(MvccTest, test_optimistic) {
+  const long conflicts = theGlobalOccManager()->stats().conflicts;
+
+  // 读过的记录在提交前被其它乐观事务修改并提交，检查失败，自己的修改也回滚
+  Trx trx1;
+  trx1.set_optimistic(true);
+  ASSERT_EQ(ROW_COUNT * INIT_BALANCE, sum(&trx1).balance);
+  Trx trx2;
+  trx2.set_optimistic(true);
+  ASSERT_EQ(RC::SUCCESS, set_balance(&trx2, 1, nullptr));
+  ASSERT_EQ(RC::SUCCESS, trx2.commit());
+  ASSERT_EQ(RC::SUCCESS, insert(&trx1, ROW_COUNT, 1));
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, trx1.commit());
+  ASSERT_EQ(conflicts + 1, theGlobalOccManager()->stats().conflicts);
+
+  Trx reader;
+  reader.set_optimistic(true);
+  Sum reader_sum = sum(&reader);
+  ASSERT_EQ(ROW_COUNT, reader_sum.count);
+  ASSERT_EQ(ROW_COUNT, reader_sum.balance);
+
+  // 不加锁，修改正在被修改的记录时直接失败，不等待
+  Trx trx3;
+  trx3.set_optimistic(true);
+  ASSERT_EQ(RC::SUCCESS, set_balance(&trx3, 2, nullptr));
+  Trx trx4;
+  trx4.set_optimistic(true);
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, set_balance(&trx4, 3, nullptr));
+  ASSERT_EQ(RC::SUCCESS, trx4.rollback());
+  ASSERT_EQ(RC::SUCCESS, trx3.commit());
+
+  // 只读的事务在快照中读，不用检查
+  ASSERT_EQ(ROW_COUNT, sum(&reader).balance);
+  ASSERT_EQ(RC::SUCCESS, reader.commit());
+
+  // 没有读写交集的事务都可以提交
+  Trx trx5;
+  trx5.set_optimistic(true);
+  ASSERT_EQ(RC::SUCCESS, insert(&trx5, ROW_COUNT, 1));
+  Trx trx6;
+  trx6.set_optimistic(true);
+  ASSERT_EQ(RC::SUCCESS, set_balance(&trx6, 4, nullptr));
+  ASSERT_EQ(RC::SUCCESS, trx6.commit());
+  ASSERT_EQ(RC::SUCCESS, trx5.commit());
+  ASSERT_EQ(conflicts + 1, theGlobalOccManager()->stats().conflicts);
+
+  Trx trx7;
+  reader_sum = sum(&trx7);
+  ASSERT_EQ(ROW_COUNT + 1, reader_sum.count);
+  ASSERT_EQ(ROW_COUNT * 4 + 1, reader_sum.balance);
+  ASSERT_EQ(RC::SUCCESS, trx7.commit());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
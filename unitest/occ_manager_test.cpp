@@ -0,0 +1,112 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <vector>
+
+#include "storage/trx/occ_manager.h"
+#include "gtest/gtest.h"
+
+// 只用作记录的键，不会被访问
+static Table *const TABLE = (Table *)0x1000;
+
+static LockId row(int slot_num) {
+  RID rid;
+  rid.page_num = 1;
+  rid.slot_num = slot_num;
+  return LockId::record_lock(TABLE, rid);
+}
+
+TEST(test_occ_manager, test_validate) {
+  OccManager occ_manager;
+  OccStart start1;
+  occ_manager.begin(start1);
+  OccStart start2;
+  occ_manager.begin(start2);
+
+  // 事务2修改了事务1读过的记录并先通过检查
+  uint64_t commit2 = 0;
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start2, {row(1)}, {row(1), row(2)}, &commit2));
+  occ_manager.finish(start2, commit2);
+  uint64_t commit1 = 0;
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, occ_manager.validate(start1, {row(2), row(3)}, {row(4)}, &commit1));
+  occ_manager.finish(start1, 0);
+
+  // 之后开始的事务不受影响
+  OccStart start3;
+  occ_manager.begin(start3);
+  uint64_t commit3 = 0;
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start3, {row(2)}, {row(2)}, &commit3));
+  occ_manager.finish(start3, commit3);
+
+  const OccStats stats = occ_manager.stats();
+  ASSERT_EQ(3, stats.validations);
+  ASSERT_EQ(1, stats.conflicts);
+  // 没有活跃的事务，登记的修改都已经清理
+  ASSERT_EQ(0, stats.tracked_writes);
+}
+
+TEST(test_occ_manager, test_write_write) {
+  OccManager occ_manager;
+  OccStart start1;
+  occ_manager.begin(start1);
+  OccStart start2;
+  occ_manager.begin(start2);
+  uint64_t commit1 = 0;
+  uint64_t commit2 = 0;
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start1, {}, {row(1)}, &commit1));
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, occ_manager.validate(start2, {}, {row(1)}, &commit2));
+  occ_manager.finish(start1, commit1);
+  occ_manager.finish(start2, 0);
+}
+
+TEST(test_occ_manager, test_committing) {
+  OccManager occ_manager;
+  OccStart start1;
+  occ_manager.begin(start1);
+  uint64_t commit1 = 0;
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start1, {}, {row(1)}, &commit1));
+
+  // 事务1通过了检查还没有提交完成，事务2在它之后通过检查并提交完成
+  OccStart start2;
+  occ_manager.begin(start2);
+  uint64_t commit2 = 0;
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start2, {}, {row(2)}, &commit2));
+  occ_manager.finish(start2, commit2);
+
+  // 这时开始的事务看不到事务1的修改，要和它比较；事务2的修改可见
+  OccStart start3;
+  occ_manager.begin(start3);
+  ASSERT_FALSE(start3.is_visible(commit1));
+  ASSERT_TRUE(start3.is_visible(commit2));
+  occ_manager.finish(start1, commit1);
+  ASSERT_EQ(2, occ_manager.stats().tracked_writes);
+  uint64_t commit3 = 0;
+  ASSERT_EQ(RC::BUSY_SNAPSHOT, occ_manager.validate(start3, {row(1)}, {row(3)}, &commit3));
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start3, {row(2)}, {row(3)}, &commit3));
+  occ_manager.finish(start3, commit3);
+
+  // 提交完成之后开始的事务能看到它的修改
+  OccStart start4;
+  occ_manager.begin(start4);
+  ASSERT_TRUE(start4.is_visible(commit1));
+  uint64_t commit4 = 0;
+  ASSERT_EQ(RC::SUCCESS, occ_manager.validate(start4, {row(1)}, {row(1)}, &commit4));
+  occ_manager.finish(start4, commit4);
+  ASSERT_EQ(0, occ_manager.stats().tracked_writes);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
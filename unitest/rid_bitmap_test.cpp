@@ -0,0 +1,108 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "storage/common/rid_bitmap.h"
+#include "gtest/gtest.h"
+
+static RID make_rid(int page_num, int slot_num) {
+  RID rid;
+  rid.page_num = page_num;
+  rid.slot_num = slot_num;
+  return rid;
+}
+
+static std::vector<std::pair<int, int>> to_vector(const RidBitmap &bitmap) {
+  std::vector<std::pair<int, int>> rids;
+  bitmap.visit([&rids](PageNum page_num, const std::vector<SlotNum> &slots) {
+    for (SlotNum slot_num : slots) {
+      rids.emplace_back(page_num, slot_num);
+    }
+    return RC::SUCCESS;
+  });
+  return rids;
+}
+
+TEST(test_rid_bitmap, test_visit_in_page_order) {
+  std::vector<std::pair<int, int>> expect;
+  for (int page = 1; page < 50; page += 3) {
+    for (int slot = 0; slot < 300; slot += page) {
+      expect.emplace_back(page, slot);
+    }
+  }
+  std::vector<std::pair<int, int>> shuffled = expect;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(0));
+
+  RidBitmap bitmap;
+  for (const auto &rid : shuffled) {
+    bitmap.add(make_rid(rid.first, rid.second));
+    bitmap.add(make_rid(rid.first, rid.second));
+  }
+  ASSERT_EQ((int)expect.size(), bitmap.size());
+  ASSERT_EQ(17, bitmap.page_count());
+  ASSERT_EQ(expect, to_vector(bitmap));
+  ASSERT_TRUE(bitmap.contains(make_rid(4, 8)));
+  ASSERT_FALSE(bitmap.contains(make_rid(4, 9)));
+  ASSERT_FALSE(bitmap.contains(make_rid(2, 0)));
+}
+
+TEST(test_rid_bitmap, test_intersect_unite) {
+  std::set<std::pair<int, int>> set1;
+  std::set<std::pair<int, int>> set2;
+  RidBitmap bitmap1;
+  RidBitmap bitmap2;
+  std::mt19937 random(1);
+  for (int i = 0; i < 5000; i++) {
+    int page = random() % 40 + 1;
+    int slot = random() % 500;
+    set1.emplace(page, slot);
+    bitmap1.add(make_rid(page, slot));
+    page = random() % 60 + 1;
+    slot = random() % 200;
+    set2.emplace(page, slot);
+    bitmap2.add(make_rid(page, slot));
+  }
+
+  std::vector<std::pair<int, int>> expect_and;
+  std::set_intersection(set1.begin(), set1.end(), set2.begin(), set2.end(), std::back_inserter(expect_and));
+  std::vector<std::pair<int, int>> expect_or;
+  std::set_union(set1.begin(), set1.end(), set2.begin(), set2.end(), std::back_inserter(expect_or));
+
+  RidBitmap result_and;
+  result_and.unite(bitmap1);
+  result_and.intersect(bitmap2);
+  ASSERT_EQ(expect_and, to_vector(result_and));
+  ASSERT_EQ((int)expect_and.size(), result_and.size());
+
+  RidBitmap result_or;
+  result_or.unite(bitmap1);
+  result_or.unite(bitmap2);
+  ASSERT_EQ(expect_or, to_vector(result_or));
+
+  // 没有交集的页面要被去掉
+  RidBitmap disjoint;
+  disjoint.add(make_rid(1000, 1));
+  result_and.intersect(disjoint);
+  ASSERT_TRUE(result_and.empty());
+  ASSERT_EQ(0, result_and.page_count());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,55 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+//
+// Created by hizhisong on 2026/10/19.
+//
+
+#ifndef __UNITEST_TEST_UTIL_H_
+#define __UNITEST_TEST_UTIL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+/**
+ * 单元测试和性能测试共用的辅助函数，性能测试的CMakeLists.txt也包含了这个目录
+ */
+
+/**
+ * 在/tmp下创建名字以name开头的临时目录，失败时返回空串
+ */
+inline std::string make_temp_dir(const char *name) {
+  std::string dir = std::string("/tmp/") + name + ".XXXXXX";
+  if (mkdtemp(&dir[0]) == nullptr) {
+    return std::string();
+  }
+  return dir;
+}
+
+inline void remove_temp_dir(const std::string &dir) {
+  std::string command = "rm -rf " + dir;
+  if (system(command.c_str()) != 0) {
+    printf("Failed to remove %s\n", dir.c_str());
+  }
+}
+
+/**
+ * 直接通过RecordFileHandler读写的定长记录，记录文件和日志的测试使用
+ */
+static const int TEST_RECORD_SIZE = 16;
+
+struct TestRecord {
+  int value;
+  int version;
+  char padding[TEST_RECORD_SIZE - 2 * sizeof(int)];
+};
+
+#endif // __UNITEST_TEST_UTIL_H_